@@ -53,11 +53,13 @@
 #include <k3dsdk/nodes.h>
 #include <k3dsdk/options_policy.h>
 #include <k3dsdk/parallel/threads.h>
+#include <k3dsdk/pipeline_trace.h>
 #include <k3dsdk/plugin.h>
 #include <k3dsdk/property.h>
 #include <k3dsdk/register_application.h>
 #include <k3dsdk/register_plugin_factories.h>
 #include <k3dsdk/scripting.h>
+#include <k3dsdk/string_cast.h>
 #include <k3dsdk/shader_cache_detail.h>
 #include <k3dsdk/share_detail.h>
 #include <k3dsdk/string_modifiers.h>
@@ -69,8 +71,12 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include <atomic>
+#include <cstdlib>
 #include <iomanip>
 #include <iterator>
+#include <new>
+#include <sstream>
 
 #ifdef K3D_API_WIN32
 	#include <k3dsdk/win32.h>
@@ -94,6 +100,7 @@ k3d::log_level_t g_minimum_log_level = k3d::K3D_LOG_LEVEL_WARNING;
 k3d::filesystem::path g_default_ngui_path;
 k3d::filesystem::path g_default_nui_path;
 k3d::filesystem::path g_default_options_path;
+k3d::filesystem::path g_default_plugin_index_path;
 k3d::filesystem::path g_default_pyui_path;
 k3d::filesystem::path g_default_qtui_path;
 k3d::filesystem::path g_default_shader_cache_path;
@@ -104,13 +111,25 @@ k3d::string_t g_default_plugin_paths;
 
 k3d::filesystem::path g_override_locale_path;
 k3d::filesystem::path g_options_path;
+k3d::filesystem::path g_plugin_index_path;
+k3d::filesystem::path g_profile_pipeline_path;
 k3d::filesystem::path g_shader_cache_path;
 k3d::filesystem::path g_share_path;
 k3d::filesystem::path g_user_interface_path;
 k3d::string_t g_plugin_paths;
 
+/// Set to true if the undo / redo budgets were overridden on the command-line
+k3d::bool_t g_undo_budget_set = false;
+/// Stores the undo / redo memory budget for new documents, in megabytes
+k3d::uint64_t g_undo_memory_budget = 256;
+/// Stores the undo / redo spill-file budget for new documents, in megabytes
+k3d::uint64_t g_undo_spill_budget = 1024;
+
 k3d::ievent_loop* g_user_interface = 0;
 
+/// Set to true while allocations are counted for the pipeline trace
+std::atomic<k3d::bool_t> g_count_allocations(false);
+
 /////////////////////////////////////////////////////////////////////////////
 // handle_error
 
@@ -159,6 +178,7 @@ void set_default_options(k3d::bool_t& Quit, k3d::bool_t& Error)
 	g_default_ngui_path = executable_dir / k3d::filesystem::generic_path("../" K3D_LIBDIR "/k3d/plugins/k3d-ngui.module");
 	g_default_nui_path = executable_dir / k3d::filesystem::generic_path("../" K3D_LIBDIR "/k3d/plugins/k3d-nui.module");
 	g_default_options_path = user_dir / k3d::filesystem::generic_path("options.k3d");
+	g_default_plugin_index_path = user_dir / k3d::filesystem::generic_path("plugins.index");
 	g_default_plugin_paths = (executable_dir / k3d::filesystem::generic_path("../" K3D_LIBDIR "/k3d/plugins")).native_filesystem_string();
 	g_default_pyui_path = executable_dir / k3d::filesystem::generic_path("../" K3D_LIBDIR "/k3d/plugins/k3d-pyui.module");
 	g_default_qtui_path = executable_dir / k3d::filesystem::generic_path("../" K3D_LIBDIR "/k3d/plugins/k3d-qtui.module");
@@ -173,6 +193,7 @@ void set_default_options(k3d::bool_t& Quit, k3d::bool_t& Error)
 
 	// Setup path options based on the defaults ...
 	g_options_path = g_default_options_path;
+	g_plugin_index_path = g_default_plugin_index_path;
 	g_plugin_paths = g_default_plugin_paths;
 	g_shader_cache_path = g_default_shader_cache_path;
 	g_share_path = g_default_share_path;
@@ -185,6 +206,9 @@ void set_default_options(k3d::bool_t& Quit, k3d::bool_t& Error)
 	if(!k3d::system::getenv("K3D_OPTIONS_PATH").empty())
 		g_options_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(k3d::system::getenv("K3D_OPTIONS_PATH")));
 
+	if(!k3d::system::getenv("K3D_PLUGIN_INDEX_PATH").empty())
+		g_plugin_index_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(k3d::system::getenv("K3D_PLUGIN_INDEX_PATH")));
+
 	if(!k3d::system::getenv("K3D_PLUGIN_PATHS").empty())
 		g_plugin_paths = k3d::system::getenv("K3D_PLUGIN_PATHS");
 
@@ -293,6 +317,14 @@ const arguments_t parse_startup_arguments(const arguments_t& Arguments, k3d::boo
 			else
 				g_user_interface_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(argument->value[0]));
 		}
+		else if(argument->string_key == "plugin-index")
+		{
+			g_plugin_index_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(argument->value[0]));
+		}
+		else if(argument->string_key == "profile-pipeline")
+		{
+			g_profile_pipeline_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(argument->value[0]));
+		}
 		else if(argument->string_key == "plugins")
 		{
 			g_plugin_paths = argument->value[0];
@@ -334,6 +366,16 @@ const arguments_t parse_startup_arguments(const arguments_t& Arguments, k3d::boo
 		{
 			g_override_locale_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(argument->value[0]));
 		}
+		else if(argument->string_key == "undo-memory-budget")
+		{
+			g_undo_budget_set = true;
+			g_undo_memory_budget = k3d::from_string(argument->value[0], g_undo_memory_budget);
+		}
+		else if(argument->string_key == "undo-spill-budget")
+		{
+			g_undo_budget_set = true;
+			g_undo_spill_budget = k3d::from_string(argument->value[0], g_undo_spill_budget);
+		}
 		else
 		{
 			unused.push_back(*argument);
@@ -365,6 +407,7 @@ void check_dependencies(k3d::bool_t& Quit, k3d::bool_t& Error)
 
 	k3d::log() << info << "executable: " << k3d::system::executable_path().native_console_string() << std::endl;
 	k3d::log() << info << "options file: " << g_options_path.native_console_string() << std::endl;
+	k3d::log() << info << "plugin index: " << g_plugin_index_path.native_console_string() << std::endl;
 	k3d::log() << info << "plugin path(s): " << g_plugin_paths << std::endl;
 	k3d::log() << info << "shader cache path: " << g_shader_cache_path.native_console_string() << std::endl;
 	k3d::log() << info << "share path: " << g_share_path.native_console_string() << std::endl;
@@ -466,7 +509,17 @@ void create_user_interface(k3d::plugin_factory_collection& Plugins, k3d::bool_t&
 /// Loads (statically- or dynamically-linked) plugin modules
 void load_modules(k3d::plugin_factory_collection& Plugins, k3d::bool_t& Quit, k3d::bool_t& Error)
 {
+	if(!g_plugin_index_path.empty())
+		Plugins.load_index(g_plugin_index_path);
+
 	Plugins.load_modules(g_plugin_paths, true, k3d::plugin_factory_collection::LOAD_PROXIES);
+
+	if(!g_plugin_index_path.empty())
+		Plugins.save_index(g_plugin_index_path);
+
+	std::ostringstream load_times;
+	Plugins.print_load_times(load_times);
+	k3d::log() << info << "plugin module load times:\n" << load_times.str();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -577,6 +630,36 @@ void check_unused_arguments(const arguments_t& Arguments, k3d::bool_t& Quit, k3d
 	    k3d::log() << warning << "name: " << argument->string_key << " value: " << argument->value[0] << std::endl;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// pipeline_trace_recorder
+
+/// Records a trace of pipeline execution while it exists, if one was requested with --profile-pipeline, writing the trace to a file when it's destroyed
+class pipeline_trace_recorder
+{
+public:
+	pipeline_trace_recorder()
+	{
+		if(g_profile_pipeline_path.empty())
+			return;
+
+		k3d::log() << info << "Recording pipeline trace to [" << g_profile_pipeline_path.native_console_string() << "]" << std::endl;
+		g_count_allocations.store(true);
+		k3d::pipeline_trace::start();
+	}
+
+	~pipeline_trace_recorder()
+	{
+		if(g_profile_pipeline_path.empty())
+			return;
+
+		k3d::pipeline_trace::stop();
+		g_count_allocations.store(false);
+
+		if(!k3d::pipeline_trace::write_chrome_trace(g_profile_pipeline_path))
+			k3d::log() << error << "Error writing pipeline trace to [" << g_profile_pipeline_path.native_console_string() << "]" << std::endl;
+	}
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // create_auto_start_plugins
 
@@ -634,6 +717,73 @@ void delete_auto_start_plugins(auto_start_plugins_t& Plugins)
 
 } // namespace
 
+/////////////////////////////////////////////////////////////////////////////
+// Global allocation functions
+
+// These replace the standard allocation functions, so the pipeline trace can report the memory allocated by each task.
+// Allocations are only counted while a trace is being recorded.
+
+void* operator new(std::size_t Size)
+{
+	if(g_count_allocations.load(std::memory_order_relaxed))
+		k3d::pipeline_trace::count_allocation(Size);
+
+	while(true)
+	{
+		if(void* const result = std::malloc(Size ? Size : 1))
+			return result;
+
+		const std::new_handler handler = std::set_new_handler(0);
+		std::set_new_handler(handler);
+		if(!handler)
+			throw std::bad_alloc();
+
+		handler();
+	}
+}
+
+void* operator new[](std::size_t Size)
+{
+	return operator new(Size);
+}
+
+void* operator new(std::size_t Size, const std::nothrow_t&) throw()
+{
+	try
+	{
+		return operator new(Size);
+	}
+	catch(...)
+	{
+		return 0;
+	}
+}
+
+void* operator new[](std::size_t Size, const std::nothrow_t&) throw()
+{
+	return operator new(Size, std::nothrow);
+}
+
+void operator delete(void* Pointer) throw()
+{
+	std::free(Pointer);
+}
+
+void operator delete[](void* Pointer) throw()
+{
+	std::free(Pointer);
+}
+
+void operator delete(void* Pointer, const std::nothrow_t&) throw()
+{
+	std::free(Pointer);
+}
+
+void operator delete[](void* Pointer, const std::nothrow_t&) throw()
+{
+	std::free(Pointer);
+}
+
 int k3d_main(std::vector<k3d::string_t> raw_arguments)
 {
 	// Append extra options from the environment ...
@@ -667,7 +817,9 @@ int k3d_main(std::vector<k3d::string_t> raw_arguments)
 			("log-level", boost::program_options::value<k3d::string_t>(), "Specifies the minimum message priority to log - valid values are \"warning\", \"information\", \"debug\" [default: warning].")
 			("no-color", "Disable color-coding of log messages based on their level.")
 			("options", boost::program_options::value<k3d::string_t>(), "Overrides the filepath for storing user options [default: /home/tshead/.k3d/options.k3d].")
+			("plugin-index", boost::program_options::value<k3d::string_t>(), "Overrides the filepath for caching plugin module contents, or disables the cache if empty [default: /home/tshead/.k3d/plugins.index].")
 			("plugins", boost::program_options::value<k3d::string_t>(), "Overrides the path(s) for loading plugin libraries [default: /usr/local/k3d/lib/k3d].")
+			("profile-pipeline", boost::program_options::value<k3d::string_t>(), "Records the execution of pipeline tasks on every thread, and writes them to the given file in Chrome trace-event JSON format, for viewing with chrome://tracing or Perfetto.")
 			("script,e", boost::program_options::value<k3d::string_t>(), "Executes the given script text after startup.")
 			("script-file,f", boost::program_options::value<k3d::string_t>(), "Executes the given script file after startup (use - for stdin).")
 			("setenv", boost::program_options::value<k3d::string_t>(), "Set an environment variable using name=value syntax.")
@@ -677,6 +829,8 @@ int k3d_main(std::vector<k3d::string_t> raw_arguments)
 			("show-timestamps", "Prints timestamps next to log messages.")
 			("syslog", "Logs messages to syslog.")
 			("ui,u", boost::program_options::value<k3d::string_t>(), "Specifies the user interface plugin to use - valid values are a plugin path, \"nui\", \"ngui\", \"qtui\", or \"pyui\" [default: qtui].")
+			("undo-memory-budget", boost::program_options::value<k3d::string_t>(), "Specifies how many megabytes of memory undo / redo history may use before the oldest changes are spilled to disk [default: 256].")
+			("undo-spill-budget", boost::program_options::value<k3d::string_t>(), "Specifies how many megabytes of disk undo / redo history may spill to before the oldest changes are discarded, or 0 to disable spilling [default: 1024].")
 			("user-interface-help,H", "Prints user interface help message and exits.")
 			("version", "Prints program version information and exits.")
 			;
@@ -813,6 +967,13 @@ int k3d_main(std::vector<k3d::string_t> raw_arguments)
 		// Register it with the library as the global application object ...
 		k3d::register_application(application.interface());
 
+		// Apply undo / redo budgets, if requested ...
+		if(g_undo_budget_set)
+			application.set_memory_budget(g_undo_memory_budget * 1024 * 1024, g_undo_spill_budget * 1024 * 1024);
+
+		// Record a pipeline trace, if requested ...
+		pipeline_trace_recorder trace_recorder;
+
 		// Switch the UI to its "normal" (post-startup) layout ...
 		startup_message_handler(_("Starting user interface"));
 		g_user_interface->display_user_interface();
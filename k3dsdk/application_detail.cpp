@@ -30,6 +30,7 @@
 #include <k3dsdk/idocument.h>
 #include <k3dsdk/iscript_engine.h>
 #include <k3dsdk/iscripted_action.h>
+#include <k3dsdk/istate_recorder.h>
 #include <k3dsdk/plugin.h>
 #include <k3dsdk/result.h>
 #include <k3dsdk/signal_accumulators.h>
@@ -54,7 +55,10 @@ class application_implementation::implementation :
 	public k3d::iapplication
 {
 public:
-	implementation()
+	implementation() :
+		m_memory_budget_set(false),
+		m_memory_budget(0),
+		m_spill_budget(0)
 	{
 	}
 
@@ -80,6 +84,10 @@ public:
 		return_val_if_fail(document, 0);
 		m_documents.push_back(document);
 
+		// Apply the undo / redo budgets, if any were set ...
+		if(m_memory_budget_set)
+			document->state_recorder().set_memory_budget(m_memory_budget, m_spill_budget);
+
 		// Create any auto-start plugins ...
 		const plugin::factory::collection_t factories = plugin::factory::lookup();
 		for(plugin::factory::collection_t::const_iterator factory = factories.begin(); factory != factories.end(); ++factory)
@@ -176,6 +184,12 @@ public:
 	sigc::signal<void, idocument&> m_close_document_signal;
 	/// Signal emitted to request application close
 	sigc::signal0<bool, signal::cancelable> m_exit_signal;
+	/// Set to true if the undo / redo budgets should override the document defaults
+	bool_t m_memory_budget_set;
+	/// Stores the undo / redo memory budget for new documents, in bytes
+	uint64_t m_memory_budget;
+	/// Stores the undo / redo spill-file budget for new documents, in bytes
+	uint64_t m_spill_budget;
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -201,5 +215,12 @@ sigc::connection application_implementation::connect_exit_signal(const sigc::slo
 	return m_implementation->m_exit_signal.connect(Slot);
 }
 
+void application_implementation::set_memory_budget(const uint64_t MemoryBudget, const uint64_t SpillBudget)
+{
+	m_implementation->m_memory_budget_set = true;
+	m_implementation->m_memory_budget = MemoryBudget;
+	m_implementation->m_spill_budget = SpillBudget;
+}
+
 } // namespace k3d
 
@@ -26,6 +26,7 @@
 
 #include <k3dsdk/signal_accumulators.h>
 #include <k3dsdk/signal_system.h>
+#include <k3dsdk/types.h>
 
 namespace k3d
 {
@@ -44,6 +45,8 @@ public:
 
 	/// Connects a slot that will be called to request application exit - observers may return false to indicate that this isn't possible (e.g. because we're embedded in a scripting engine)
 	sigc::connection connect_exit_signal(const sigc::slot<bool>& Slot);
+	/// Sets the undo / redo memory and spill-file budgets (in bytes) for documents created from now on - see k3d::istate_recorder::set_memory_budget()
+	void set_memory_budget(const uint64_t MemoryBudget, const uint64_t SpillBudget);
 
 private:
 	class implementation;
@@ -0,0 +1,132 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/archive_cache_ri.h>
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/gzstream.h>
+#include <k3dsdk/inetwork_render_job.h>
+#include <k3dsdk/result.h>
+
+#include <boost/scoped_ptr.hpp>
+
+namespace k3d
+{
+
+namespace ri
+{
+
+namespace detail
+{
+
+/// Returns the 64-bit FNV-1a hash of a string
+const uint64_t content_hash(const string_t& Content)
+{
+	uint64_t result = 14695981039346656037ULL;
+	for(string_t::const_iterator c = Content.begin(); c != Content.end(); ++c)
+	{
+		result ^= static_cast<unsigned char>(*c);
+		result *= 1099511628211ULL;
+	}
+	return result;
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// archive_cache
+
+archive_cache::archive_cache(inetwork_render_job& Job, const bool_t BinaryEncoding, const bool_t Compress) :
+	m_job(Job),
+	m_binary_encoding(BinaryEncoding),
+	m_compress(Compress)
+{
+}
+
+const filesystem::path archive_cache::lookup(const iunknown* const Owner, const uint_t Version) const
+{
+	const std::map<const iunknown*, entry>::const_iterator existing = m_entries.find(Owner);
+	if(existing == m_entries.end() || existing->second.version != Version)
+		return filesystem::path();
+
+	return existing->second.archive;
+}
+
+const filesystem::path archive_cache::store(const iunknown* const Owner, const uint_t Version, const string_t& RIB)
+{
+	const filesystem::path path = store(RIB);
+	if(path.empty())
+		return path;
+
+	entry& owner_entry = m_entries[Owner];
+	owner_entry.version = Version;
+	owner_entry.archive = path;
+
+	return path;
+}
+
+const filesystem::path archive_cache::store(const string_t& RIB)
+{
+	// Reuse an existing archive if its contents are identical ...
+	const uint64_t hash = detail::content_hash(RIB);
+	for(std::multimap<uint64_t, archive>::const_iterator existing = m_archives.lower_bound(hash); existing != m_archives.upper_bound(hash); ++existing)
+	{
+		if(existing->second.contents == RIB)
+			return existing->second.path;
+	}
+
+	// Otherwise, write a new archive ...
+	const filesystem::path path = m_job.add_file(m_compress ? "archive.rib.gz" : "archive.rib");
+
+	boost::scoped_ptr<std::ostream> stream;
+	if(m_compress)
+		stream.reset(new filesystem::ogzstream(path));
+	else
+		stream.reset(new filesystem::ofstream(path));
+	return_val_if_fail(stream->good(), filesystem::path());
+
+	stream->write(RIB.data(), RIB.size());
+	stream->flush();
+	return_val_if_fail(stream->good(), filesystem::path());
+
+	archive new_archive;
+	new_archive.path = path;
+	new_archive.contents = RIB;
+	m_archives.insert(std::make_pair(hash, new_archive));
+
+	return path;
+}
+
+const bool_t archive_cache::binary_encoding() const
+{
+	return m_binary_encoding;
+}
+
+const uint_t archive_cache::archive_count() const
+{
+	return m_archives.size();
+}
+
+} // namespace ri
+
+} // namespace k3d
+
@@ -0,0 +1,90 @@
+#ifndef K3DSDK_ARCHIVE_CACHE_RI_H
+#define K3DSDK_ARCHIVE_CACHE_RI_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/path.h>
+#include <k3dsdk/types.h>
+
+#include <map>
+
+namespace k3d
+{
+
+class inetwork_render_job;
+class iunknown;
+
+namespace ri
+{
+
+/// Shares RIB archives among the frames of an animation, so geometry that doesn't change from frame-to-frame is written once to the
+/// job directory and referenced with ReadArchive.  Owners look up their archive by version (a counter the owner increments whenever
+/// anything that affects its RIB - geometry, painter or shader settings - may have changed), and only generate RIB when it has changed.
+/// Archives are also matched by content, so an owner whose version changed without changing its RIB still reuses its archive.
+class archive_cache
+{
+public:
+	archive_cache(inetwork_render_job& Job, const bool_t BinaryEncoding, const bool_t Compress);
+
+	/// Returns the archive stored for Owner, iff it was stored with the same Version, or an empty path
+	const filesystem::path lookup(const iunknown* const Owner, const uint_t Version) const;
+	/// Stores RIB for Owner and Version, returning the path of an existing archive with identical contents, or of a new archive
+	const filesystem::path store(const iunknown* const Owner, const uint_t Version, const string_t& RIB);
+	/// Returns the path of an existing archive with contents identical to RIB, or of a new archive written to the job directory
+	const filesystem::path store(const string_t& RIB);
+
+	/// Returns true iff archives should be written using the binary RIB encoding
+	const bool_t binary_encoding() const;
+	/// Returns the number of archive files written so far
+	const uint_t archive_count() const;
+
+private:
+	/// Stores the most recent archive for an owner
+	struct entry
+	{
+		uint_t version;
+		filesystem::path archive;
+	};
+
+	/// Stores an archive file, along with its contents so matches can be confirmed without reading the file back
+	struct archive
+	{
+		filesystem::path path;
+		string_t contents;
+	};
+
+	inetwork_render_job& m_job;
+	const bool_t m_binary_encoding;
+	const bool_t m_compress;
+	std::map<const iunknown*, entry> m_entries;
+	/// Maps content hashes to archives
+	std::multimap<uint64_t, archive> m_archives;
+};
+
+} // namespace ri
+
+} // namespace k3d
+
+#endif // !K3DSDK_ARCHIVE_CACHE_RI_H
+
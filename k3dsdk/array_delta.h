@@ -0,0 +1,393 @@
+#ifndef K3DSDK_ARRAY_DELTA_H
+#define K3DSDK_ARRAY_DELTA_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/ispillable_state_container.h>
+#include <k3dsdk/istate_container.h>
+#include <k3dsdk/result.h>
+#include <k3dsdk/state_change_set.h>
+#include <k3dsdk/state_spill_file.h>
+#include <k3dsdk/types.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace k3d
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// array_delta
+
+/// Stores the differences between two versions of an array as runs of changed values, so that either version can be recreated from the other
+template<typename array_t>
+class array_delta
+{
+public:
+	typedef typename array_t::value_type value_type;
+	typedef std::vector<value_type> values_t;
+
+	array_delta() :
+		old_size(0),
+		new_size(0)
+	{
+	}
+
+	/// Records the differences between Old and New
+	array_delta(const array_t& Old, const array_t& New) :
+		old_size(Old.size()),
+		new_size(New.size())
+	{
+		const uint_t common_size = std::min(old_size, new_size);
+		for(uint_t i = 0; i != common_size; )
+		{
+			if(Old[i] == New[i])
+			{
+				++i;
+				continue;
+			}
+
+			const uint_t begin = i;
+			for(++i; i != common_size && !(Old[i] == New[i]); ++i)
+				;
+
+			runs.push_back(begin);
+			runs.push_back(i - begin);
+			old_values.insert(old_values.end(), Old.begin() + begin, Old.begin() + i);
+			new_values.insert(new_values.end(), New.begin() + begin, New.begin() + i);
+		}
+
+		// Values past the end of the shorter version are stored after the runs ...
+		old_values.insert(old_values.end(), Old.begin() + common_size, Old.end());
+		new_values.insert(new_values.end(), New.begin() + common_size, New.end());
+	}
+
+	/// Converts an array that matches the new version into the old version
+	void undo(array_t& Array) const
+	{
+		apply(Array, old_size, old_values);
+	}
+
+	/// Converts an array that matches the old version into the new version
+	void redo(array_t& Array) const
+	{
+		apply(Array, new_size, new_values);
+	}
+
+	/// Returns true iff the two versions are identical
+	const bool_t empty() const
+	{
+		return old_size == new_size && runs.empty();
+	}
+
+	/// Returns the approximate number of bytes of memory used to store the differences
+	const uint_t memory_usage() const
+	{
+		return sizeof(*this) + runs.capacity() * sizeof(uint_t) + (old_values.capacity() + new_values.capacity()) * sizeof(value_type);
+	}
+
+	/// Stores the size of the old version
+	uint_t old_size;
+	/// Stores the size of the new version
+	uint_t new_size;
+	/// Stores the first index and the length of each run of changed values
+	std::vector<uint_t> runs;
+	/// Stores the old value of each run, followed by any old values past the end of the new version
+	values_t old_values;
+	/// Stores the new value of each run, followed by any new values past the end of the old version
+	values_t new_values;
+
+private:
+	void apply(array_t& Array, const uint_t Size, const values_t& Values) const
+	{
+		Array.resize(Size);
+
+		typename values_t::const_iterator value = Values.begin();
+		for(uint_t i = 0; i < runs.size(); i += 2)
+		{
+			std::copy(value, value + runs[i + 1], Array.begin() + runs[i]);
+			value += runs[i + 1];
+		}
+
+		std::copy(value, Values.end(), Array.begin() + std::min(old_size, new_size));
+	}
+};
+
+namespace detail
+{
+
+/// Returns true iff array_delta<array_t> can be written to a spill file as raw bytes
+template<typename array_t>
+struct spillable_array_delta
+{
+	typedef typename array_t::value_type value_type;
+	static const bool value = std::is_trivially_copyable<value_type>::value && !std::is_same<value_type, bool>::value;
+};
+
+/// Stores the undo/redo state shared by the old and new state containers of an array: a complete copy of the old version while
+/// recording is in progress, then only the differences once recording is finished, optionally moved to a spill file
+template<typename array_t>
+class array_delta_state
+{
+public:
+	array_delta_state(const array_t& Old) :
+		m_old(new array_t(Old))
+	{
+	}
+
+	~array_delta_state()
+	{
+		if(m_file)
+			m_file->release(m_block);
+	}
+
+	/// Replaces the copy of the old version with the differences between it and the new version
+	void finish(const array_t& New)
+	{
+		return_if_fail(m_old.get());
+
+		m_delta = array_delta<array_t>(*m_old, New);
+		m_old.reset();
+	}
+
+	void undo(array_t& Array)
+	{
+		if(m_old.get())
+		{
+			Array = *m_old;
+			return;
+		}
+
+		if(m_file)
+		{
+			array_delta<array_t> delta;
+			return_if_fail(load(delta));
+			delta.undo(Array);
+			return;
+		}
+
+		m_delta.undo(Array);
+	}
+
+	void redo(array_t& Array)
+	{
+		if(m_file)
+		{
+			array_delta<array_t> delta;
+			return_if_fail(load(delta));
+			delta.redo(Array);
+			return;
+		}
+
+		m_delta.redo(Array);
+	}
+
+	const uint_t memory_usage() const
+	{
+		if(m_old.get())
+			return sizeof(*this) + m_old->size() * sizeof(typename array_t::value_type);
+		if(m_file)
+			return sizeof(*this);
+		return sizeof(*this) + m_delta.memory_usage();
+	}
+
+	void spill(const boost::shared_ptr<state_spill_file>& File)
+	{
+		spill(File, std::integral_constant<bool, spillable_array_delta<array_t>::value>());
+	}
+
+private:
+	typedef typename array_t::value_type value_type;
+
+	void spill(const boost::shared_ptr<state_spill_file>& File, std::true_type)
+	{
+		// Recordings that were never finished, and states that have already been spilled, stay as they are ...
+		if(m_old.get() || m_file || !File)
+			return;
+
+		const uint_t header[3] = { m_delta.old_size, m_delta.new_size, m_delta.runs.size() };
+		const uint64_t values_size = (m_delta.old_values.size() + m_delta.new_values.size()) * sizeof(value_type);
+		std::vector<char> buffer(sizeof(header) + m_delta.runs.size() * sizeof(uint_t) + values_size);
+
+		char* output = &buffer[0];
+		output = write(output, header, sizeof(header));
+		output = write(output, m_delta.runs.data(), m_delta.runs.size() * sizeof(uint_t));
+		output = write(output, m_delta.old_values.data(), m_delta.old_values.size() * sizeof(value_type));
+		output = write(output, m_delta.new_values.data(), m_delta.new_values.size() * sizeof(value_type));
+
+		const state_spill_file::block block = File->write(&buffer[0], buffer.size());
+		if(!block.size)
+			return;
+
+		m_file = File;
+		m_block = block;
+		m_delta = array_delta<array_t>();
+	}
+
+	void spill(const boost::shared_ptr<state_spill_file>&, std::false_type)
+	{
+	}
+
+	const bool_t load(array_delta<array_t>& Delta)
+	{
+		return load(Delta, std::integral_constant<bool, spillable_array_delta<array_t>::value>());
+	}
+
+	const bool_t load(array_delta<array_t>& Delta, std::true_type)
+	{
+		std::vector<char> buffer(m_block.size);
+		if(!m_file->read(m_block, &buffer[0]))
+			return false;
+
+		const char* input = &buffer[0];
+		uint_t header[3];
+		input = read(input, header, sizeof(header));
+
+		const uint_t common_size = std::min(header[0], header[1]);
+		Delta.old_size = header[0];
+		Delta.new_size = header[1];
+		Delta.runs.resize(header[2]);
+		input = read(input, Delta.runs.data(), Delta.runs.size() * sizeof(uint_t));
+
+		uint_t run_values = 0;
+		for(uint_t i = 1; i < Delta.runs.size(); i += 2)
+			run_values += Delta.runs[i];
+
+		Delta.old_values.resize(run_values + header[0] - common_size);
+		Delta.new_values.resize(run_values + header[1] - common_size);
+		input = read(input, Delta.old_values.data(), Delta.old_values.size() * sizeof(value_type));
+		input = read(input, Delta.new_values.data(), Delta.new_values.size() * sizeof(value_type));
+
+		return_val_if_fail(input == &buffer[0] + buffer.size(), false);
+		return true;
+	}
+
+	const bool_t load(array_delta<array_t>&, std::false_type)
+	{
+		return false;
+	}
+
+	static char* write(char* Output, const void* Data, const uint_t Size)
+	{
+		if(Size)
+			std::memcpy(Output, Data, Size);
+		return Output + Size;
+	}
+
+	static const char* read(const char* Input, void* Data, const uint_t Size)
+	{
+		if(Size)
+			std::memcpy(Data, Input, Size);
+		return Input + Size;
+	}
+
+	/// Stores a complete copy of the old version until recording is finished
+	std::unique_ptr<array_t> m_old;
+	/// Stores the differences between the old and new versions
+	array_delta<array_t> m_delta;
+	/// Stores the file that the differences have been spilled to, if any
+	boost::shared_ptr<state_spill_file> m_file;
+	/// Identifies the spilled differences within m_file
+	state_spill_file::block m_block;
+};
+
+/// Restores one side (old or new) of an array_delta_state
+template<typename array_t>
+class array_delta_container :
+	public istate_container,
+	public ispillable_state_container
+{
+public:
+	array_delta_container(array_t& Instance, const boost::shared_ptr<array_delta_state<array_t> >& State, const bool_t Undo) :
+		m_instance(Instance),
+		m_state(State),
+		m_undo(Undo)
+	{
+	}
+
+	void restore_state()
+	{
+		if(m_undo)
+			m_state->undo(m_instance);
+		else
+			m_state->redo(m_instance);
+	}
+
+	const uint_t memory_usage()
+	{
+		// The state is shared with the container for the other side, so only the old side reports it ...
+		return m_undo ? m_state->memory_usage() : 0;
+	}
+
+	void spill(const boost::shared_ptr<state_spill_file>& File)
+	{
+		m_state->spill(File);
+	}
+
+private:
+	array_t& m_instance;
+	const boost::shared_ptr<array_delta_state<array_t> > m_state;
+	const bool_t m_undo;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// array_undo_storage
+
+/// Records undo/redo state for an array by storing only the values that changed between the start and finish of recording
+template<typename array_t>
+class array_undo_storage
+{
+public:
+	/// Called to store the original state of the array prior to modification
+	void start_recording(state_change_set& ChangeSet, array_t& Array)
+	{
+		m_state.reset(new detail::array_delta_state<array_t>(Array));
+		ChangeSet.record_old_state(new detail::array_delta_container<array_t>(Array, m_state, true));
+	}
+
+	/// Called to store the new state of the array after one-or-more modifications
+	void finish_recording(state_change_set& ChangeSet, array_t& Array)
+	{
+		return_if_fail(m_state);
+
+		m_state->finish(Array);
+		ChangeSet.record_new_state(new detail::array_delta_container<array_t>(Array, m_state, false));
+		m_state.reset();
+	}
+
+private:
+	boost::shared_ptr<detail::array_delta_state<array_t> > m_state;
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_ARRAY_DELTA_H
+
@@ -86,7 +86,7 @@ private:
 
 	void execute(const std::vector<ihint*>& Hints, bitmap& Bitmap)
 	{
-		if(const bitmap* const input = m_input_bitmap.pipeline_value())
+		if(const bitmap* const input = input_bitmap())
 		{
 			bool resize_bitmap = false;
 			bool assign_pixels = false;
@@ -124,6 +124,12 @@ private:
 		}
 	}
 
+	/// Returns the bitmap passed to on_resize_bitmap() and on_assign_pixels(), derived classes may override this to bypass upstream nodes
+	virtual const bitmap* input_bitmap()
+	{
+		return m_input_bitmap.pipeline_value();
+	}
+
 	virtual void on_resize_bitmap(const bitmap& Input, bitmap& Output) = 0;
 	virtual void on_assign_pixels(const bitmap& Input, bitmap& Output) = 0;
 };
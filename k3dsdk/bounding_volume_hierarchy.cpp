@@ -0,0 +1,326 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <k3dsdk/bounding_volume_hierarchy.h>
+#include <k3dsdk/result.h>
+
+#include <algorithm>
+
+namespace k3d
+{
+
+namespace detail
+{
+
+/// Maximum number of elements stored in a leaf node
+const uint_t bvh_leaf_size = 4;
+
+/// Returns the signed distance from a clip-space point to a clip-space plane
+inline double_t plane_distance(const point4& Plane, const point4& Point)
+{
+	return Plane[0] * Point[0] + Plane[1] * Point[1] + Plane[2] * Point[2] + Plane[3] * Point[3];
+}
+
+/// Orders elements by the coordinate of their centroids along one axis
+class compare_centroids
+{
+public:
+	compare_centroids(const std::vector<point3>& Centroids, const uint_t Axis) :
+		centroids(Centroids),
+		axis(Axis)
+	{
+	}
+
+	bool_t operator()(const uint_t A, const uint_t B) const
+	{
+		return centroids[A][axis] < centroids[B][axis];
+	}
+
+private:
+	const std::vector<point3>& centroids;
+	const uint_t axis;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// selection_frustum
+
+selection_frustum::selection_frustum(const matrix4& ObjectToClip, const double_t Left, const double_t Right, const double_t Bottom, const double_t Top) :
+	m_object_to_clip(ObjectToClip)
+{
+	m_clip_planes[0] = point4(1, 0, 0, -Left);
+	m_clip_planes[1] = point4(-1, 0, 0, Right);
+	m_clip_planes[2] = point4(0, 1, 0, -Bottom);
+	m_clip_planes[3] = point4(0, -1, 0, Top);
+	m_clip_planes[4] = point4(0, 0, 1, 1);
+	m_clip_planes[5] = point4(0, 0, -1, 1);
+
+	for(uint_t i = 0; i != 6; ++i)
+	{
+		for(uint_t j = 0; j != 4; ++j)
+		{
+			m_object_planes[i][j] =
+				m_clip_planes[i][0] * m_object_to_clip[0][j] +
+				m_clip_planes[i][1] * m_object_to_clip[1][j] +
+				m_clip_planes[i][2] * m_object_to_clip[2][j] +
+				m_clip_planes[i][3] * m_object_to_clip[3][j];
+		}
+	}
+}
+
+bool_t selection_frustum::intersects(const bounding_box3& Box) const
+{
+	for(uint_t i = 0; i != 6; ++i)
+	{
+		const point4& plane = m_object_planes[i];
+		const double_t distance =
+			plane[0] * (plane[0] >= 0 ? Box.px : Box.nx) +
+			plane[1] * (plane[1] >= 0 ? Box.py : Box.ny) +
+			plane[2] * (plane[2] >= 0 ? Box.pz : Box.nz) +
+			plane[3];
+
+		if(distance < 0)
+			return false;
+	}
+
+	return true;
+}
+
+bool_t selection_frustum::clip(const point3* const Vertices, const uint_t VertexCount, double_t& ZMin, double_t& ZMax) const
+{
+	return_val_if_fail(VertexCount >= 1 && VertexCount <= 3, false);
+
+	// Sutherland-Hodgman clipping in homogeneous coordinates; each plane can add at-most one vertex ...
+	point4 buffers[2][9];
+	uint_t counts[2] = { VertexCount, 0 };
+	for(uint_t i = 0; i != VertexCount; ++i)
+		buffers[0][i] = m_object_to_clip * point4(Vertices[i][0], Vertices[i][1], Vertices[i][2], 1);
+
+	uint_t current = 0;
+	for(uint_t plane = 0; plane != 6 && counts[current]; ++plane)
+	{
+		const point4* const input = buffers[current];
+		const uint_t input_count = counts[current];
+		point4* const output = buffers[1 - current];
+		uint_t& output_count = counts[1 - current];
+		output_count = 0;
+
+		if(input_count == 1)
+		{
+			if(detail::plane_distance(m_clip_planes[plane], input[0]) >= 0)
+				output[output_count++] = input[0];
+		}
+		else
+		{
+			for(uint_t i = 0; i != input_count; ++i)
+			{
+				const point4& a = input[i];
+				const point4& b = input[(i + 1) % input_count];
+				const double_t da = detail::plane_distance(m_clip_planes[plane], a);
+				const double_t db = detail::plane_distance(m_clip_planes[plane], b);
+
+				if(da >= 0)
+					output[output_count++] = a;
+				if((da >= 0) != (db >= 0))
+				{
+					const double_t t = da / (da - db);
+					output[output_count++] = point4(a[0] + t * (b[0] - a[0]), a[1] + t * (b[1] - a[1]), a[2] + t * (b[2] - a[2]), a[3] + t * (b[3] - a[3]));
+				}
+			}
+		}
+
+		current = 1 - current;
+	}
+
+	bool_t result = false;
+	ZMin = 1.0;
+	ZMax = 0.0;
+	for(uint_t i = 0; i != counts[current]; ++i)
+	{
+		const point4& vertex = buffers[current][i];
+		if(vertex[3] <= 0)
+			continue;
+
+		const double_t z = std::max(0.0, std::min(1.0, 0.5 * (vertex[2] / vertex[3]) + 0.5));
+		ZMin = std::min(ZMin, z);
+		ZMax = std::max(ZMax, z);
+		result = true;
+	}
+
+	return result;
+}
+
+bool_t selection_frustum::counter_clockwise(const point3& A, const point3& B, const point3& C) const
+{
+	const point4 a = m_object_to_clip * point4(A[0], A[1], A[2], 1);
+	const point4 b = m_object_to_clip * point4(B[0], B[1], B[2], 1);
+	const point4 c = m_object_to_clip * point4(C[0], C[1], C[2], 1);
+
+	// The sign of this determinant matches the winding of the projected triangle, without dividing by w ...
+	const double_t determinant =
+		a[0] * (b[1] * c[3] - c[1] * b[3]) -
+		b[0] * (a[1] * c[3] - c[1] * a[3]) +
+		c[0] * (a[1] * b[3] - b[1] * a[3]);
+
+	return determinant > 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// bounding_volume_hierarchy
+
+bounding_volume_hierarchy::bounding_volume_hierarchy(const uint_t VertexCount, const mesh::indices_t& ElementVertices, const mesh::points_t& Points) :
+	m_vertex_count(VertexCount),
+	m_element_vertices(ElementVertices)
+{
+	return_if_fail(m_vertex_count >= 1 && m_vertex_count <= 3);
+
+	const uint_t element_count = m_element_vertices.size() / m_vertex_count;
+	if(!element_count)
+		return;
+
+	std::vector<point3> centroids(element_count, point3(0, 0, 0));
+	for(uint_t element = 0; element != element_count; ++element)
+	{
+		for(uint_t i = 0; i != m_vertex_count; ++i)
+			centroids[element] += to_vector(Points[m_element_vertices[element * m_vertex_count + i]]);
+		centroids[element] /= m_vertex_count;
+	}
+
+	m_elements.resize(element_count);
+	for(uint_t element = 0; element != element_count; ++element)
+		m_elements[element] = element;
+
+	m_nodes.reserve(2 * (element_count / detail::bvh_leaf_size + 1));
+	build(0, element_count, centroids);
+	refit(Points);
+}
+
+void bounding_volume_hierarchy::refit(const mesh::points_t& Points)
+{
+	// Children always follow their parents, so a reverse pass updates children before parents ...
+	for(std::vector<node>::reverse_iterator node = m_nodes.rbegin(); node != m_nodes.rend(); ++node)
+		update_bounds(*node, Points);
+}
+
+void bounding_volume_hierarchy::intersect(const selection_frustum& Frustum, const mesh::points_t& Points, const culling Culling, hits_t& Hits) const
+{
+	if(m_nodes.empty())
+		return;
+
+	point3 vertices[3];
+	hit element_hit;
+
+	std::vector<uint_t> stack(1, 0);
+	while(stack.size())
+	{
+		const node& current = m_nodes[stack.back()];
+		const uint_t current_index = stack.back();
+		stack.pop_back();
+
+		if(!Frustum.intersects(current.bounds))
+			continue;
+
+		if(current.second_child)
+		{
+			stack.push_back(current.second_child);
+			stack.push_back(current_index + 1);
+			continue;
+		}
+
+		for(uint_t i = current.begin; i != current.end; ++i)
+		{
+			const uint_t element = m_elements[i];
+			for(uint_t j = 0; j != m_vertex_count; ++j)
+				vertices[j] = Points[m_element_vertices[element * m_vertex_count + j]];
+
+			if(m_vertex_count == 3 && Culling != CULL_NONE)
+			{
+				if(Frustum.counter_clockwise(vertices[0], vertices[1], vertices[2]) == (Culling == CULL_COUNTER_CLOCKWISE))
+					continue;
+			}
+
+			if(!Frustum.clip(vertices, m_vertex_count, element_hit.zmin, element_hit.zmax))
+				continue;
+
+			element_hit.element = element;
+			Hits.push_back(element_hit);
+		}
+	}
+}
+
+uint_t bounding_volume_hierarchy::element_count() const
+{
+	return m_elements.size();
+}
+
+uint_t bounding_volume_hierarchy::build(const uint_t Begin, const uint_t End, const std::vector<point3>& Centroids)
+{
+	const uint_t index = m_nodes.size();
+	m_nodes.push_back(node());
+	m_nodes[index].begin = Begin;
+	m_nodes[index].end = End;
+	m_nodes[index].second_child = 0;
+
+	if(End - Begin <= detail::bvh_leaf_size)
+		return index;
+
+	// Split at the median centroid along the longest axis of the centroid bounds ...
+	bounding_box3 centroid_bounds;
+	for(uint_t i = Begin; i != End; ++i)
+		centroid_bounds.insert(Centroids[m_elements[i]]);
+
+	const double_t extents[3] = { centroid_bounds.width(), centroid_bounds.height(), centroid_bounds.depth() };
+	const uint_t axis = std::max_element(extents, extents + 3) - extents;
+
+	const uint_t middle = Begin + (End - Begin) / 2;
+	std::nth_element(m_elements.begin() + Begin, m_elements.begin() + middle, m_elements.begin() + End, detail::compare_centroids(Centroids, axis));
+
+	build(Begin, middle, Centroids);
+	const uint_t second_child = build(middle, End, Centroids);
+	m_nodes[index].second_child = second_child;
+
+	return index;
+}
+
+void bounding_volume_hierarchy::update_bounds(node& Node, const mesh::points_t& Points) const
+{
+	Node.bounds = bounding_box3();
+
+	if(Node.second_child)
+	{
+		const bounding_box3& first = (&Node + 1)->bounds;
+		const bounding_box3& second = m_nodes[Node.second_child].bounds;
+		Node.bounds.insert(point3(first.nx, first.ny, first.nz));
+		Node.bounds.insert(point3(first.px, first.py, first.pz));
+		Node.bounds.insert(point3(second.nx, second.ny, second.nz));
+		Node.bounds.insert(point3(second.px, second.py, second.pz));
+		return;
+	}
+
+	for(uint_t i = Node.begin; i != Node.end; ++i)
+	{
+		const uint_t element = m_elements[i];
+		for(uint_t j = 0; j != m_vertex_count; ++j)
+			Node.bounds.insert(Points[m_element_vertices[element * m_vertex_count + j]]);
+	}
+}
+
+} // namespace k3d
+
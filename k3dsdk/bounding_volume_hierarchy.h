@@ -0,0 +1,126 @@
+#ifndef K3DSDK_BOUNDING_VOLUME_HIERARCHY_H
+#define K3DSDK_BOUNDING_VOLUME_HIERARCHY_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <k3dsdk/algebra.h>
+#include <k3dsdk/bounding_box3.h>
+#include <k3dsdk/mesh.h>
+
+#include <vector>
+
+namespace k3d
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// selection_frustum
+
+/// Defines a selection volume in object coordinates, equivalent to combining gluPickMatrix() with
+/// the OpenGL projection, so that geometry can be picked on the CPU with the same results as GL_SELECT.
+class selection_frustum
+{
+public:
+	/// Creates a frustum from a matrix that maps object coordinates to clip coordinates, and a region in normalized device coordinates
+	selection_frustum(const matrix4& ObjectToClip, const double_t Left, const double_t Right, const double_t Bottom, const double_t Top);
+
+	/// Returns false if the given box is entirely outside the frustum (may return true for boxes that are outside but near a corner)
+	bool_t intersects(const bounding_box3& Box) const;
+	/// Clips a point, line segment, or triangle against the frustum, returning true iff any part of it is inside.
+	/// On return, ZMin and ZMax contain the range of normalized window depths for the clipped element.
+	bool_t clip(const point3* const Vertices, const uint_t VertexCount, double_t& ZMin, double_t& ZMax) const;
+	/// Returns true iff the given triangle has counter-clockwise winding in window coordinates
+	bool_t counter_clockwise(const point3& A, const point3& B, const point3& C) const;
+
+private:
+	/// Stores the matrix that maps object coordinates to clip coordinates
+	const matrix4 m_object_to_clip;
+	/// Stores the six frustum planes in clip coordinates
+	point4 m_clip_planes[6];
+	/// Stores the six frustum planes in object coordinates
+	point4 m_object_planes[6];
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// bounding_volume_hierarchy
+
+/// Stores a bounding volume hierarchy over simple elements (points, line segments, or triangles) whose vertices
+/// index into a shared array of points.  When the points move without changing connectivity, call refit(),
+/// which updates the bounding volumes in linear time without rebuilding the hierarchy.
+class bounding_volume_hierarchy
+{
+public:
+	/// Builds a hierarchy over elements with VertexCount (1, 2, or 3) vertices each, stored consecutively in ElementVertices
+	bounding_volume_hierarchy(const uint_t VertexCount, const mesh::indices_t& ElementVertices, const mesh::points_t& Points);
+
+	/// Recomputes the bounding volumes after the points have moved
+	void refit(const mesh::points_t& Points);
+
+	/// Stores one element found by a query, along with its range of normalized window depths
+	struct hit
+	{
+		uint_t element;
+		double_t zmin;
+		double_t zmax;
+	};
+	typedef std::vector<hit> hits_t;
+
+	/// Defines how triangles are culled during queries
+	enum culling
+	{
+		/// Returns all triangles
+		CULL_NONE,
+		/// Skips triangles with clockwise winding in window coordinates
+		CULL_CLOCKWISE,
+		/// Skips triangles with counter-clockwise winding in window coordinates
+		CULL_COUNTER_CLOCKWISE
+	};
+
+	/// Appends every element that is at-least partially inside the given frustum to Hits
+	void intersect(const selection_frustum& Frustum, const mesh::points_t& Points, const culling Culling, hits_t& Hits) const;
+
+	/// Returns the number of elements in the hierarchy
+	uint_t element_count() const;
+
+private:
+	struct node
+	{
+		bounding_box3 bounds;
+		/// Range of element indices (into m_elements) for leaf nodes
+		uint_t begin;
+		uint_t end;
+		/// Index of the second child for internal nodes (the first child always immediately follows its parent), or zero for leaves
+		uint_t second_child;
+	};
+
+	uint_t build(const uint_t Begin, const uint_t End, const std::vector<point3>& Centroids);
+	void update_bounds(node& Node, const mesh::points_t& Points) const;
+
+	const uint_t m_vertex_count;
+	const mesh::indices_t m_element_vertices;
+	/// Stores element indices, ordered so that each leaf references a contiguous range
+	std::vector<uint_t> m_elements;
+	/// Stores hierarchy nodes in depth-first order, so that children always follow their parents
+	std::vector<node> m_nodes;
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_BOUNDING_VOLUME_HIERARCHY_H
+
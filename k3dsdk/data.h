@@ -20,6 +20,7 @@
 // License along with this program; if not, write to the Free Software
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
+#include <k3dsdk/array_delta.h>
 #include <k3dsdk/idocument.h>
 #include <k3dsdk/ienumeration_property.h>
 #include <k3dsdk/ihint.h>
@@ -44,6 +45,8 @@
 #include <k3dsdk/nodes.h>
 #include <k3dsdk/result.h>
 #include <k3dsdk/state_change_set.h>
+#include <k3dsdk/typed_array.h>
+#include <k3dsdk/uint_t_array.h>
 #include <k3dsdk/xml.h>
 
 #include <boost/lexical_cast.hpp>
@@ -54,6 +57,7 @@
 #include <cassert>
 #include <string>
 #include <typeinfo>
+#include <vector>
 
 namespace k3d
 {
@@ -1745,6 +1749,71 @@ private:
 	bool m_changes;
 };
 
+/////////////////////////////////////////////////////////////////////////////
+// value_container
+
+/// Provides an implementation of istate_container for storing data by value (value_t must have a copy constructor and assignment operator)
+template<typename value_t>
+class value_container :
+	public istate_container
+{
+public:
+	value_container(value_t& Instance) :
+		m_instance(Instance),
+		m_value(Instance)
+	{
+	}
+
+	void restore_state()
+	{
+		m_instance = m_value;
+	}
+
+private:
+	value_t& m_instance;
+	const value_t m_value;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// undo_storage
+
+/// Defines how local_storage records undo/redo state - by default, complete copies of the old and new values are stored
+template<typename value_t>
+class undo_storage
+{
+public:
+	void start_recording(state_change_set& ChangeSet, value_t& Value)
+	{
+		ChangeSet.record_old_state(new value_container<value_t>(Value));
+	}
+
+	void finish_recording(state_change_set& ChangeSet, value_t& Value)
+	{
+		ChangeSet.record_new_state(new value_container<value_t>(Value));
+	}
+};
+
+/// Array values only store the ranges that changed
+template<typename T, typename allocator_t>
+class undo_storage<std::vector<T, allocator_t> > :
+	public array_undo_storage<std::vector<T, allocator_t> >
+{
+};
+
+/// Array values only store the ranges that changed
+template<typename T>
+class undo_storage<typed_array<T> > :
+	public array_undo_storage<typed_array<T> >
+{
+};
+
+/// Array values only store the ranges that changed
+template<>
+class undo_storage<uint_t_array> :
+	public array_undo_storage<uint_t_array>
+{
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // local_storage
 
@@ -1778,7 +1847,7 @@ protected:
 	void start_recording(istate_recorder& StateRecorder)
 	{
 		signal_policy_t::start_recording(StateRecorder);
-		StateRecorder.current_change_set()->record_old_state(new value_container(m_value));
+		m_undo_storage.start_recording(*StateRecorder.current_change_set(), m_value);
 	}
 
 	/// Sets a new value for the data
@@ -1791,34 +1860,15 @@ protected:
 	/// Optionally called to store the new state of the data after one-or-more modifications
 	void finish_recording(istate_recorder& StateRecorder)
 	{
-		StateRecorder.current_change_set()->record_new_state(new value_container(m_value));
+		m_undo_storage.finish_recording(*StateRecorder.current_change_set(), m_value);
 		signal_policy_t::finish_recording(StateRecorder);
 	}
 
 private:
 	/// Local storage for the data stored by this policy
 	value_t m_value;
-
-	/// Provides an implementation of istate_container for storing nodes by value (ValueType must have a copy constructor and assignment operator)
-	class value_container :
-		public istate_container
-	{
-	public:
-		value_container(value_t& Instance) :
-			m_instance(Instance),
-			m_value(Instance)
-		{
-		}
-
-		void restore_state()
-		{
-			m_instance = m_value;
-		}
-
-	private:
-		value_t& m_instance;
-		const value_t m_value;
-	};
+	/// Records undo/redo state for the data
+	undo_storage<value_t> m_undo_storage;
 };
 
 /////////////////////////////////////////////////////////////////////////////
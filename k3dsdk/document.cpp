@@ -43,6 +43,7 @@
 #include <k3dsdk/pipeline_profiler.h>
 #include <k3dsdk/property_collection.h>
 #include <k3dsdk/signal_slots.h>
+#include <k3dsdk/state_spill_file.h>
 #include <k3dsdk/string_cast.h>
 #include <k3dsdk/string_modifiers.h>
 #include <k3dsdk/utility.h>
@@ -53,9 +54,12 @@ using namespace k3d::xml;
 
 #include <k3dsdk/fstream.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iterator>
+#include <map>
 #include <memory>
+#include <unordered_map>
 
 namespace k3d
 {
@@ -74,7 +78,10 @@ public:
 	state_recorder_implementation() :
 		m_current_node(0),
 		m_newest_node(0),
-		m_last_saved_node(0)
+		m_last_saved_node(0),
+		m_memory_budget(256 * 1024 * 1024),
+		m_spill_budget(1024 * 1024 * 1024),
+		m_memory_usage(0)
 	{
 	}
 
@@ -98,6 +105,117 @@ public:
 		delete Node;
 	}
 
+	/// Discards a node and its descendants from the hierarchy, updating the memory accounting and any references to the discarded nodes
+	void discard_node(node* const Node)
+	{
+		for(nodes_t::iterator node = Node->children.begin(); node != Node->children.end(); ++node)
+			discard_node(*node);
+		Node->children.clear();
+		discard_single_node(Node);
+	}
+
+	/// Discards a node whose children have already been detached
+	void discard_single_node(node* const Node)
+	{
+		if(!Node->change_set->spilled())
+			m_memory_usage -= std::min(m_memory_usage, Node->change_set->memory_usage());
+
+		m_history.erase(std::remove(m_history.begin(), m_history.end(), Node), m_history.end());
+
+		if(m_newest_node == Node)
+			m_newest_node = m_current_node;
+		if(m_last_saved_node == Node)
+			m_last_saved_node = 0;
+
+		delete Node->change_set;
+		delete Node;
+	}
+
+	/// Returns true iff Ancestor is Node or one of its parents
+	static const bool_t is_ancestor(const node* const Ancestor, const node* Node)
+	{
+		for(; Node; Node = Node->parent)
+		{
+			if(Node == Ancestor)
+				return true;
+		}
+
+		return false;
+	}
+
+	/// Discards the oldest root node.  If it leads to the current node, the document can no longer return to the states before it,
+	/// so the other root nodes are discarded too and its children become the new roots.  Returns false if nothing can be discarded.
+	const bool_t discard_oldest_root()
+	{
+		if(m_root_nodes.empty())
+			return false;
+
+		node* const root = m_root_nodes.front();
+		if(root == m_current_node)
+			return false;
+
+		if(is_ancestor(root, m_current_node))
+		{
+			for(nodes_t::iterator node = m_root_nodes.begin() + 1; node != m_root_nodes.end(); ++node)
+				discard_node(*node);
+
+			m_root_nodes = root->children;
+			for(nodes_t::iterator node = m_root_nodes.begin(); node != m_root_nodes.end(); ++node)
+				(*node)->parent = 0;
+
+			root->children.clear();
+			discard_single_node(root);
+		}
+		else
+		{
+			m_root_nodes.erase(m_root_nodes.begin());
+			discard_node(root);
+		}
+
+		return true;
+	}
+
+	/// Spills or discards the oldest change sets until memory usage is within budget, returns true if any nodes were discarded
+	const bool_t enforce_memory_budget()
+	{
+		bool_t discarded = false;
+
+		while(m_memory_usage > m_memory_budget || (m_spill_file && m_spill_file->size() > m_spill_budget))
+		{
+			if(m_memory_usage > m_memory_budget && m_spill_budget && spill_oldest())
+				continue;
+
+			if(!discard_oldest_root())
+				break;
+
+			discarded = true;
+		}
+
+		return discarded;
+	}
+
+	/// Moves the oldest change set that's still in memory to the spill file, returns false if there was nothing to spill
+	const bool_t spill_oldest()
+	{
+		for(nodes_t::iterator node = m_history.begin(); node != m_history.end(); ++node)
+		{
+			// Keep the change set that would be undone next in memory ...
+			if(*node == m_current_node || (*node)->change_set->spilled())
+				continue;
+
+			if(!m_spill_file)
+				m_spill_file.reset(new state_spill_file());
+
+			m_memory_usage -= std::min(m_memory_usage, (*node)->change_set->memory_usage());
+			(*node)->change_set->spill(m_spill_file);
+			m_memory_usage += (*node)->change_set->memory_usage();
+
+			return true;
+		}
+
+		return false;
+	}
+
 	void start_recording(std::unique_ptr<state_change_set> ChangeSet, const char* const Context)
 	{
 		if(!ChangeSet.get())
@@ -161,8 +279,14 @@ public:
 			label = "Unnamed changeset";
 		}
 
+		// Make room for the new change set, oldest first ...
+		m_memory_usage += ChangeSet->memory_usage();
+		if(enforce_memory_budget())
+			m_nodes_removed_signal.emit();
+
 		// Create a new node in the hierarchy, branching it from the current node if necessary ...
 		m_newest_node = new node(label, ChangeSet.release(), m_current_node);
+		m_history.push_back(m_newest_node);
 
 		if(m_current_node)
 			m_current_node->children.push_back(m_newest_node);
@@ -207,6 +331,20 @@ public:
 		m_current_node_changed_signal.emit();
 	}
 
+	void set_memory_budget(const uint64_t MemoryBudget, const uint64_t SpillBudget)
+	{
+		m_memory_budget = MemoryBudget;
+		m_spill_budget = SpillBudget;
+
+		if(enforce_memory_budget())
+			m_nodes_removed_signal.emit();
+	}
+
+	const uint64_t memory_usage()
+	{
+		return m_memory_usage;
+	}
+
 	sigc::connection connect_recording_done_signal(const sigc::slot<void>& Slot)
 	{
 		return m_recording_done_signal.connect(Slot);
@@ -217,6 +355,11 @@ public:
 		return m_node_added_signal.connect(Slot);
 	}
 	
+	sigc::connection connect_nodes_removed_signal(const sigc::slot<void>& Slot)
+	{
+		return m_nodes_removed_signal.connect(Slot);
+	}
+	
 	sigc::connection connect_current_node_changed_signal(const sigc::slot<void>& Slot)
 	{
 		return m_current_node_changed_signal.connect(Slot);
@@ -240,9 +383,20 @@ private:
 	node* m_newest_node;
 	/// Stores a reference to the most-recently-saved node (if any)
 	node* m_last_saved_node;
+	/// Stores every node, oldest first
+	nodes_t m_history;
+	/// Stores the number of bytes of memory that change sets may use before the oldest are spilled or discarded
+	uint64_t m_memory_budget;
+	/// Stores the number of compressed bytes that may be spilled to disk before the oldest change sets are discarded
+	uint64_t m_spill_budget;
+	/// Stores the number of bytes of memory used by change sets
+	uint64_t m_memory_usage;
+	/// Stores change sets that have been moved out of memory (created on demand)
+	boost::shared_ptr<state_spill_file> m_spill_file;
 
 	sigc::signal<void> m_recording_done_signal;
 	sigc::signal<void, const node*> m_node_added_signal;
+	sigc::signal<void> m_nodes_removed_signal;
 	sigc::signal<void> m_current_node_changed_signal;
 	sigc::signal<void> m_last_saved_node_changed_signal;
 };
@@ -251,7 +405,8 @@ private:
 // node_collection_implementation
 
 class node_collection_implementation :
-	public inode_collection
+	public inode_collection,
+	public sigc::trackable
 {
 public:
 	node_collection_implementation(istate_recorder& StateRecorder) :
@@ -265,15 +420,37 @@ public:
 
 	void add_nodes(const nodes_t& Nodes)
 	{
-		// Ensure no NULLs creep in ...
-		nodes_t nodes(Nodes);
-		nodes.erase(std::remove(nodes.begin(), nodes.end(), static_cast<inode*>(0)), nodes.end());
-		if(nodes.size() != Nodes.size())
+		// Ensure no NULLs or duplicates creep in ...
+		nodes_t nodes;
+		nodes.reserve(Nodes.size());
+		uint_t null_nodes = 0;
+		uint_t duplicate_nodes = 0;
+		for(nodes_t::const_iterator node = Nodes.begin(); node != Nodes.end(); ++node)
+		{
+			if(!*node)
+				++null_nodes;
+			else if(!m_records.insert(std::make_pair(*node, node_record())).second)
+				++duplicate_nodes;
+			else
+				nodes.push_back(*node);
+		}
+		if(null_nodes)
 			log() << warning << "NULL node cannot be inserted into node collection and will be ignored" << std::endl;
+		if(duplicate_nodes)
+			log() << warning << "node is already in the node collection and will be ignored" << std::endl;
 
-		// We want to emit a signal whenever an node's name changes ...
+		// Index the new nodes, and keep the indices up-to-date when their names or properties change ...
 		for(nodes_t::const_iterator node = nodes.begin(); node != nodes.end(); ++node)
-			(*node)->name_changed_signal().connect(sigc::bind(m_rename_node_signal.make_slot(), *node));
+		{
+			node_record& record = m_records[*node];
+			record.position = m_nodes.size() + (node - nodes.begin());
+			record.name = m_names.insert(std::make_pair((*node)->name(), *node));
+			record.properties_indexed = false;
+			record.name_changed_connection = (*node)->name_changed_signal().connect(sigc::bind(sigc::mem_fun(*this, &node_collection_implementation::on_rename_node), *node));
+			if(iproperty_collection* const property_collection = dynamic_cast<iproperty_collection*>(*node))
+				record.properties_changed_connection = property_collection->connect_properties_changed_signal(sigc::bind(sigc::mem_fun(*this, &node_collection_implementation::on_properties_changed), *node));
+			m_unindexed_nodes.push_back(*node);
+		}
 
 		// If we're recording undo/redo data, record the new state ...
 		if(m_state_recorder.current_change_set())
@@ -309,12 +486,62 @@ public:
 
 		// Make the change and notify observers ...
 		for(nodes_t::const_iterator node = nodes.begin(); node != nodes.end(); ++node)
-		{
 			(*node)->deleted_signal().emit();
-			m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), *node), m_nodes.end());
+
+		uint_t first_removed = m_nodes.size();
+		for(nodes_t::const_iterator node = nodes.begin(); node != nodes.end(); ++node)
+		{
+			const records_t::iterator record = m_records.find(*node);
+			if(record == m_records.end())
+				continue;
+
+			first_removed = std::min(first_removed, record->second.position);
+			record->second.name_changed_connection.disconnect();
+			record->second.properties_changed_connection.disconnect();
+			m_names.erase(record->second.name);
+			unindex_properties(*node, record->second);
+			m_records.erase(record);
 		}
+
+		// Compact the remaining nodes in a single pass, so removing many nodes at once stays linear ...
+		uint_t position = first_removed;
+		for(uint_t i = first_removed; i < m_nodes.size(); ++i)
+		{
+			const records_t::iterator record = m_records.find(m_nodes[i]);
+			if(record == m_records.end())
+				continue;
+
+			record->second.position = position;
+			m_nodes[position++] = m_nodes[i];
+		}
+		if(position < m_nodes.size())
+			m_nodes.resize(position);
+
 		m_remove_nodes_signal.emit(nodes);
+	}
+
+	const nodes_t find_nodes(const std::string& Name)
+	{
+		const std::pair<names_t::const_iterator, names_t::const_iterator> range = m_names.equal_range(Name);
+
+		std::vector<std::pair<uint_t, inode*> > nodes;
+		for(names_t::const_iterator name = range.first; name != range.second; ++name)
+			nodes.push_back(std::make_pair(m_records[name->second].position, name->second));
+		std::sort(nodes.begin(), nodes.end());
+
+		nodes_t results;
+		results.reserve(nodes.size());
+		for(uint_t i = 0; i != nodes.size(); ++i)
+			results.push_back(nodes[i].second);
+		return results;
+	}
+
+	inode* find_node(iproperty& Property)
+	{
+		index_properties();
 
+		const property_owners_t::const_iterator owner = m_property_owners.find(&Property);
+		return owner == m_property_owners.end() ? 0 : owner->second;
 	}
 
 	add_nodes_signal_t& add_nodes_signal()
@@ -340,6 +567,17 @@ public:
 			(*node)->deleted_signal().emit();
 		}
 
+		// Stop tracking nodes ...
+		for(records_t::iterator record = m_records.begin(); record != m_records.end(); ++record)
+		{
+			record->second.name_changed_connection.disconnect();
+			record->second.properties_changed_connection.disconnect();
+		}
+		m_records.clear();
+		m_names.clear();
+		m_property_owners.clear();
+		m_unindexed_nodes.clear();
+
 		// Zap nodes ...
 		for(inode_collection::nodes_t::iterator node = m_nodes.begin(); node != m_nodes.end(); ++node)
 			delete *node;
@@ -394,10 +632,96 @@ private:
 		const inode_collection::nodes_t m_nodes;
 	};
 
+	/// Defines storage for an index from node names to nodes
+	typedef std::multimap<std::string, inode*> names_t;
+
+	/// Stores the state used to index one node in the collection
+	struct node_record
+	{
+		/// Stores the position of the node within the collection
+		uint_t position;
+		/// Stores the node's entry in the name index
+		names_t::iterator name;
+		/// Stores the properties that were indexed for the node
+		iproperty_collection::properties_t properties;
+		/// Set to true iff the node's current properties are indexed
+		bool_t properties_indexed;
+		sigc::connection name_changed_connection;
+		sigc::connection properties_changed_connection;
+	};
+
+	/// Defines storage for per-node index state
+	typedef std::unordered_map<inode*, node_record> records_t;
+	/// Defines storage for an index from properties to the nodes that own them
+	typedef std::unordered_map<iproperty*, inode*> property_owners_t;
+
+	/// Called when a node is renamed, to update the name index
+	void on_rename_node(inode* Node)
+	{
+		const records_t::iterator record = m_records.find(Node);
+		if(record != m_records.end())
+		{
+			m_names.erase(record->second.name);
+			record->second.name = m_names.insert(std::make_pair(Node->name(), Node));
+		}
+
+		m_rename_node_signal.emit(Node);
+	}
+
+	/// Called when properties are added-to or removed-from a node.  Nodes are re-indexed lazily, so adding many properties stays cheap.
+	void on_properties_changed(ihint*, inode* Node)
+	{
+		const records_t::iterator record = m_records.find(Node);
+		if(record == m_records.end() || !record->second.properties_indexed)
+			return;
+
+		record->second.properties_indexed = false;
+		m_unindexed_nodes.push_back(Node);
+	}
+
+	/// Removes a node's properties from the property index
+	void unindex_properties(inode* Node, node_record& Record)
+	{
+		for(iproperty_collection::properties_t::const_iterator property = Record.properties.begin(); property != Record.properties.end(); ++property)
+		{
+			const property_owners_t::iterator owner = m_property_owners.find(*property);
+			if(owner != m_property_owners.end() && owner->second == Node)
+				m_property_owners.erase(owner);
+		}
+		Record.properties.clear();
+	}
+
+	/// Brings the property index up-to-date
+	void index_properties()
+	{
+		for(nodes_t::const_iterator node = m_unindexed_nodes.begin(); node != m_unindexed_nodes.end(); ++node)
+		{
+			const records_t::iterator record = m_records.find(*node);
+			if(record == m_records.end() || record->second.properties_indexed)
+				continue;
+
+			unindex_properties(*node, record->second);
+			if(iproperty_collection* const property_collection = dynamic_cast<iproperty_collection*>(*node))
+				record->second.properties = property_collection->properties();
+			for(iproperty_collection::properties_t::const_iterator property = record->second.properties.begin(); property != record->second.properties.end(); ++property)
+				m_property_owners[*property] = *node;
+			record->second.properties_indexed = true;
+		}
+		m_unindexed_nodes.clear();
+	}
+
 	/// Provides storage for undo/redo information
 	istate_recorder& m_state_recorder;
 	/// Provides undo-able storage for a collection of nodes
 	inode_collection::nodes_t m_nodes;
+	/// Stores index state for every node in the collection
+	records_t m_records;
+	/// Indexes nodes by name
+	names_t m_names;
+	/// Indexes nodes by the properties they own
+	property_owners_t m_property_owners;
+	/// Stores nodes whose properties haven't been indexed yet
+	nodes_t m_unindexed_nodes;
 	/// Signal for notifying observers when nodes are added to the collection
 	add_nodes_signal_t m_add_nodes_signal;
 	/// Signal for notifying observers when nodes are removed from the collection
@@ -21,6 +21,8 @@
 #include <k3dsdk/expression/fparser.h>
 #include <k3dsdk/result.h>
 
+#include <vector>
+
 namespace k3d
 {
 
@@ -73,6 +75,17 @@ double_t basic_parser::evaluate(const double_t* Variables)
 	return m_implementation->basic_parser.Eval(Variables);
 }
 
+bool_t basic_parser::block_evaluation() const
+{
+	return m_implementation->basic_parser.CanEvalBlock();
+}
+
+bool_t basic_parser::evaluate_block(const double_t* const* Variables, const uint_t* Strides, const uint_t Count, double_t* Results) const
+{
+	std::vector<unsigned> strides(Strides, Strides + m_implementation->basic_parser.VarAmount());
+	return m_implementation->basic_parser.EvalBlock(Variables, strides.empty() ? 0 : &strides[0], Count, Results);
+}
+
 } // namespace expression
 
 } // namespace k3d
@@ -55,6 +55,14 @@ public:
 	/// Evaluate the expression with the given variable values, returning the result
 	double_t evaluate(const double_t* Variables);
 
+	/// Returns true iff the currently parsed expression can be evaluated using evaluate_block()
+	/// (expressions containing conditionals, eval(), or user-defined functions can't)
+	bool_t block_evaluation() const;
+	/// Evaluate the expression for Count sets of variable values, storing the results in Results.  The value of variable i
+	/// for set j is read from Variables[i][j * Strides[i]], so a stride of zero supplies one value to every set.  Unlike evaluate(),
+	/// this method may be called from multiple threads at once.  Returns false if block_evaluation() returns false.
+	bool_t evaluate_block(const double_t* const* Variables, const uint_t* Strides, const uint_t Count, double_t* Results) const;
+
 
 private:
 	basic_parser(const basic_parser&);
@@ -23,6 +23,7 @@ using namespace FUNCTIONPARSERTYPES;
 #include <cstring>
 #include <cctype>
 #include <cmath>
+#include <algorithm>
 
 using namespace std;
 
@@ -1239,6 +1240,254 @@ double FunctionParser::Eval(const double* Vars)
 }
 
 
+//===========================================================================
+// Block evaluation
+//===========================================================================
+bool FunctionParser::CanEvalBlock() const
+{
+    const unsigned* const ByteCode = data->ByteCode;
+
+    for(unsigned IP=0; IP<data->ByteCodeSize; ++IP)
+    {
+        switch(ByteCode[IP])
+        {
+#ifndef DISABLE_EVAL
+          case cEval:
+#endif
+          case cIf: case cJump: case cFCall: case cPCall:
+              return false;
+        }
+    }
+
+    return data->ByteCodeSize > 0;
+}
+
+namespace
+{
+    // Number of variable sets evaluated together; each stack entry holds one
+    // value per set, so the loops below operate on contiguous arrays that
+    // compilers can vectorize.
+    const unsigned BlockLanes = 64;
+}
+
+bool FunctionParser::EvalBlock(const double* const* Vars,
+                               const unsigned* Strides,
+                               unsigned Count, double* Results) const
+{
+    if(!CanEvalBlock()) return false;
+
+    const unsigned* const ByteCode = data->ByteCode;
+    const double* const Immed = data->Immed;
+    const unsigned ByteCodeSize = data->ByteCodeSize;
+
+    std::vector<double> StackStorage(data->StackSize * BlockLanes);
+    double* const Stack = &StackStorage[0];
+    bool Errors[BlockLanes];
+
+    for(unsigned Begin=0; Begin<Count; Begin+=BlockLanes)
+    {
+        const unsigned N = std::min(BlockLanes, Count-Begin);
+        std::fill(Errors, Errors+N, false);
+
+        unsigned DP=0;
+        int SP=-1;
+
+        for(unsigned IP=0; IP<ByteCodeSize; ++IP)
+        {
+            const unsigned Op = ByteCode[IP];
+            double* const Top = Stack + (SP < 0 ? 0 : SP) * BlockLanes;
+            double* const Prev = Stack + (SP < 1 ? 0 : SP-1) * BlockLanes;
+            double* const Next = Stack + (SP+1) * BlockLanes;
+            unsigned i;
+
+            switch(Op)
+            {
+// Functions:
+              case   cAbs: for(i=0; i<N; ++i) Top[i] = fabs(Top[i]); break;
+              case  cAcos: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] < -1 || Top[i] > 1)
+                               { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = acos(Top[i]);
+                           }
+                           break;
+              case  cAsin: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] < -1 || Top[i] > 1)
+                               { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = asin(Top[i]);
+                           }
+                           break;
+#ifndef NO_ASINH
+              case cAcosh: for(i=0; i<N; ++i) Top[i] = acosh(Top[i]); break;
+              case cAsinh: for(i=0; i<N; ++i) Top[i] = asinh(Top[i]); break;
+              case cAtanh: for(i=0; i<N; ++i) Top[i] = atanh(Top[i]); break;
+#endif
+              case  cAtan: for(i=0; i<N; ++i) Top[i] = atan(Top[i]); break;
+              case cAtan2: for(i=0; i<N; ++i) Prev[i] = atan2(Prev[i], Top[i]);
+                           --SP; break;
+              case  cCeil: for(i=0; i<N; ++i) Top[i] = ceil(Top[i]); break;
+              case   cCos: for(i=0; i<N; ++i) Top[i] = cos(Top[i]); break;
+              case  cCosh: for(i=0; i<N; ++i) Top[i] = cosh(Top[i]); break;
+              case   cCot: for(i=0; i<N; ++i)
+                           {
+                               const double t = tan(Top[i]);
+                               if(t == 0) { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = 1/t;
+                           }
+                           break;
+              case   cCsc: for(i=0; i<N; ++i)
+                           {
+                               const double s = sin(Top[i]);
+                               if(s == 0) { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = 1/s;
+                           }
+                           break;
+              case   cExp: for(i=0; i<N; ++i) Top[i] = exp(Top[i]); break;
+              case cFloor: for(i=0; i<N; ++i) Top[i] = floor(Top[i]); break;
+              case   cInt: for(i=0; i<N; ++i) Top[i] = floor(Top[i]+.5); break;
+              case   cLog: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] <= 0) { Errors[i] = true; Top[i] = 1; }
+                               else Top[i] = log(Top[i]);
+                           }
+                           break;
+              case cLog10: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] <= 0) { Errors[i] = true; Top[i] = 1; }
+                               else Top[i] = log10(Top[i]);
+                           }
+                           break;
+              case   cMax: for(i=0; i<N; ++i) Prev[i] = Max(Prev[i], Top[i]);
+                           --SP; break;
+              case   cMin: for(i=0; i<N; ++i) Prev[i] = Min(Prev[i], Top[i]);
+                           --SP; break;
+              case   cSec: for(i=0; i<N; ++i)
+                           {
+                               const double c = cos(Top[i]);
+                               if(c == 0) { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = 1/c;
+                           }
+                           break;
+              case   cSin: for(i=0; i<N; ++i) Top[i] = sin(Top[i]); break;
+              case  cSinh: for(i=0; i<N; ++i) Top[i] = sinh(Top[i]); break;
+              case  cSqrt: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] < 0) { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = sqrt(Top[i]);
+                           }
+                           break;
+              case   cTan: for(i=0; i<N; ++i) Top[i] = tan(Top[i]); break;
+              case  cTanh: for(i=0; i<N; ++i) Top[i] = tanh(Top[i]); break;
+
+// Misc:
+              case cImmed: std::fill(Next, Next+N, Immed[DP++]); ++SP; break;
+
+// Operators:
+              case   cNeg: for(i=0; i<N; ++i) Top[i] = -Top[i]; break;
+              case   cAdd: for(i=0; i<N; ++i) Prev[i] += Top[i]; --SP; break;
+              case   cSub: for(i=0; i<N; ++i) Prev[i] -= Top[i]; --SP; break;
+              case   cMul: for(i=0; i<N; ++i) Prev[i] *= Top[i]; --SP; break;
+              case   cDiv: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] == 0) { Errors[i] = true; Prev[i] = 0; }
+                               else Prev[i] /= Top[i];
+                           }
+                           --SP; break;
+              case   cMod: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] == 0) { Errors[i] = true; Prev[i] = 0; }
+                               else Prev[i] = fmod(Prev[i], Top[i]);
+                           }
+                           --SP; break;
+              case   cPow: for(i=0; i<N; ++i) Prev[i] = pow(Prev[i], Top[i]);
+                           --SP; break;
+
+#ifdef FP_EPSILON
+              case cEqual: for(i=0; i<N; ++i)
+                               Prev[i] = (fabs(Prev[i]-Top[i]) <= FP_EPSILON);
+                           --SP; break;
+              case cNEqual: for(i=0; i<N; ++i)
+                                Prev[i] = (fabs(Prev[i]-Top[i]) >= FP_EPSILON);
+                           --SP; break;
+              case  cLess: for(i=0; i<N; ++i)
+                               Prev[i] = (Prev[i] < Top[i]-FP_EPSILON);
+                           --SP; break;
+              case  cLessOrEq: for(i=0; i<N; ++i)
+                                   Prev[i] = (Prev[i] <= Top[i]+FP_EPSILON);
+                           --SP; break;
+              case cGreater: for(i=0; i<N; ++i)
+                                 Prev[i] = (Prev[i]-FP_EPSILON > Top[i]);
+                             --SP; break;
+              case cGreaterOrEq: for(i=0; i<N; ++i)
+                                     Prev[i] = (Prev[i]+FP_EPSILON >= Top[i]);
+                             --SP; break;
+#else
+              case cEqual: for(i=0; i<N; ++i) Prev[i] = (Prev[i] == Top[i]);
+                           --SP; break;
+              case cNEqual: for(i=0; i<N; ++i) Prev[i] = (Prev[i] != Top[i]);
+                           --SP; break;
+              case  cLess: for(i=0; i<N; ++i) Prev[i] = (Prev[i] < Top[i]);
+                           --SP; break;
+              case  cLessOrEq: for(i=0; i<N; ++i) Prev[i] = (Prev[i] <= Top[i]);
+                           --SP; break;
+              case cGreater: for(i=0; i<N; ++i) Prev[i] = (Prev[i] > Top[i]);
+                             --SP; break;
+              case cGreaterOrEq: for(i=0; i<N; ++i) Prev[i] = (Prev[i] >= Top[i]);
+                             --SP; break;
+#endif
+
+              case   cAnd: for(i=0; i<N; ++i)
+                               Prev[i] = (doubleToInt(Prev[i]) &&
+                                          doubleToInt(Top[i]));
+                           --SP; break;
+              case    cOr: for(i=0; i<N; ++i)
+                               Prev[i] = (doubleToInt(Prev[i]) ||
+                                          doubleToInt(Top[i]));
+                           --SP; break;
+              case   cNot: for(i=0; i<N; ++i) Top[i] = !doubleToInt(Top[i]);
+                           break;
+
+// Degrees-radians conversion:
+              case   cDeg: for(i=0; i<N; ++i) Top[i] = RadiansToDegrees(Top[i]);
+                           break;
+              case   cRad: for(i=0; i<N; ++i) Top[i] = DegreesToRadians(Top[i]);
+                           break;
+
+#ifdef SUPPORT_OPTIMIZER
+              case   cVar: break; // Paranoia. These should never exist
+              case   cDup: std::copy(Top, Top+N, Next); ++SP; break;
+              case   cInv: for(i=0; i<N; ++i)
+                           {
+                               if(Top[i] == 0) { Errors[i] = true; Top[i] = 0; }
+                               else Top[i] = 1/Top[i];
+                           }
+                           break;
+#endif
+
+// Variables:
+              default:
+                  {
+                      const unsigned Var = Op-VarBegin;
+                      const unsigned Stride = Strides[Var];
+                      const double* const Values = Vars[Var] + Begin*Stride;
+                      if(Stride == 0)
+                          std::fill(Next, Next+N, Values[0]);
+                      else
+                          for(i=0; i<N; ++i) Next[i] = Values[i*Stride];
+                      ++SP;
+                  }
+            }
+        }
+
+        for(unsigned i=0; i<N; ++i)
+            Results[Begin+i] = Errors[i] ? 0 : Stack[i];
+    }
+
+    return true;
+}
+
+
 #ifdef FUNCTIONPARSER_SUPPORT_DEBUG_OUTPUT
 namespace
 {
@@ -49,6 +49,18 @@ public:
     double Eval(const double* Vars);
     inline int EvalError() const { return evalErrorType; }
 
+    // Block evaluation: evaluates the function for Count sets of variable
+    // values, reading variable i of set j from Vars[i][j*Strides[i]] (so a
+    // stride of zero supplies the same value to every set).  Sets that cause
+    // an evaluation error produce 0, as with Eval().  Unlike Eval(), this
+    // doesn't modify the parser, so multiple threads can call it at once.
+    // Returns false without evaluating anything if the function uses
+    // conditionals, eval() or user-defined functions (see CanEvalBlock()).
+    bool CanEvalBlock() const;
+    inline unsigned VarAmount() const { return data->varAmount; }
+    bool EvalBlock(const double* const* Vars, const unsigned* Strides,
+                   unsigned Count, double* Results) const;
+
     bool AddConstant(const std::string& name, double value);
 
     typedef double (*FunctionPtr)(const double*);
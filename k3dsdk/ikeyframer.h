@@ -26,6 +26,11 @@
 */
 
 #include <k3dsdk/iproperty.h>
+#include <k3dsdk/iunknown.h>
+#include <k3dsdk/types.h>
+
+#include <list>
+#include <vector>
 
 namespace k3d
 {
@@ -58,6 +63,22 @@ public:
 	virtual ~ikeyframer() {}
 };
 
+/// Abstract interface for keyframed channels that can be evaluated at many times at once, e.g. to cache playback or export animation
+template<typename time_t, typename value_t>
+class ikeyframe_sampler :
+	public virtual iunknown
+{
+public:
+	/// Stores the channel value at Count evenly-spaced times beginning at Start, in Values
+	virtual void sample(const time_t Start, const time_t Step, const uint_t Count, std::vector<value_t>& Values) = 0;
+
+protected:
+	ikeyframe_sampler() {}
+	ikeyframe_sampler(const ikeyframe_sampler&) {}
+	ikeyframe_sampler& operator=(const ikeyframe_sampler&) { return *this; }
+	virtual ~ikeyframe_sampler() {}
+};
+
 }
 
 #endif // !K3DSDK_IKEYFRAMER_H
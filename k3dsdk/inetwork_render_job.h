@@ -31,6 +31,8 @@ namespace k3d
 {
 
 class inetwork_render_frame;
+
+namespace filesystem { class path; }
 	
 /// Abstract interface encapsulating a render job containing zero-to-many frames to be rendered
 class inetwork_render_job :
@@ -39,6 +41,8 @@ class inetwork_render_job :
 public:
 	/// Adds a new "frame" to the job, to be rendered when the job is run
 	virtual inetwork_render_frame& create_frame(const string_t& FrameName) = 0;
+	/// Returns a unique path to a file in the job directory, which can be shared by every frame in the job
+	virtual const filesystem::path add_file(const string_t& Name) = 0;
 
 protected:
 	inetwork_render_job() {}
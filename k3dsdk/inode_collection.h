@@ -28,12 +28,14 @@
 #include <k3dsdk/iunknown.h>
 #include <k3dsdk/signal_system.h>
 
+#include <string>
 #include <vector>
 
 namespace k3d
 {
 
 class inode;
+class iproperty;
 
 /// Abstract interface for a collection of document nodes
 class inode_collection :
@@ -49,6 +51,10 @@ public:
 	virtual const nodes_t& collection() = 0;
 	/// Removes nodes from the collection
 	virtual void remove_nodes(const nodes_t& Objects) = 0;
+	/// Returns the nodes in the collection with the given name, in collection order
+	virtual const nodes_t find_nodes(const std::string& Name) = 0;
+	/// Returns the node in the collection that owns the given property (could return NULL)
+	virtual inode* find_node(iproperty& Property) = 0;
 
 	/// Defines a signal that will be emitted whenever nodes are added to the collection
 	typedef sigc::signal<void, const nodes_t&> add_nodes_signal_t;
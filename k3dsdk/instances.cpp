@@ -0,0 +1,280 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <k3dsdk/instances.h>
+#include <k3dsdk/metadata_keys.h>
+#include <k3dsdk/primitive_validation.h>
+#include <k3dsdk/selection.h>
+
+#include <boost/scoped_ptr.hpp>
+
+namespace k3d
+{
+
+namespace instances
+{
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// const_primitive
+
+const_primitive::const_primitive(
+	const mesh::matrices_t& Matrices,
+	const mesh::selection_t& Selections,
+	const mesh::table_t& ConstantAttributes,
+	const mesh::table_t& InstanceAttributes
+		) :
+	matrices(Matrices),
+	selections(Selections),
+	constant_attributes(ConstantAttributes),
+	instance_attributes(InstanceAttributes)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// primitive
+
+primitive::primitive(
+	mesh::matrices_t& Matrices,
+	mesh::selection_t& Selections,
+	mesh::table_t& ConstantAttributes,
+	mesh::table_t& InstanceAttributes
+		) :
+	matrices(Matrices),
+	selections(Selections),
+	constant_attributes(ConstantAttributes),
+	instance_attributes(InstanceAttributes)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// create
+
+primitive* create(mesh& Mesh)
+{
+	mesh::primitive& generic_primitive = Mesh.primitives.create("instances");
+
+	primitive* const result = new primitive(
+		generic_primitive.structure["instance"].create<mesh::matrices_t >("matrices"),
+		generic_primitive.structure["instance"].create<mesh::selection_t>("selections"),
+		generic_primitive.attributes["constant"],
+		generic_primitive.attributes["instance"]
+		);
+
+	result->selections.set_metadata_value(metadata::key::role(), metadata::value::selection_role());
+
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// validate
+
+const_primitive* validate(const mesh& Mesh, const mesh::primitive& Primitive)
+{
+	if(Primitive.type != "instances")
+		return 0;
+
+	try
+	{
+		require_valid_primitive(Mesh, Primitive);
+
+		const mesh::table_t& instance_structure = require_structure(Primitive, "instance");
+
+		const mesh::table_t& constant_attributes = require_attributes(Primitive, "constant");
+		const mesh::table_t& instance_attributes = require_attributes(Primitive, "instance");
+
+		const mesh::matrices_t& matrices = require_array<mesh::matrices_t >(Primitive, instance_structure, "matrices");
+		const mesh::selection_t& selections = require_array<mesh::selection_t>(Primitive, instance_structure, "selections");
+
+		require_metadata(Primitive, selections, "selections", metadata::key::role(), metadata::value::selection_role());
+
+		return new const_primitive(matrices, selections, constant_attributes, instance_attributes);
+	}
+	catch(std::exception& e)
+	{
+		log() << error << e.what() << std::endl;
+	}
+
+	return 0;
+}
+
+primitive* validate(const mesh& Mesh, mesh::primitive& Primitive)
+{
+	if(Primitive.type != "instances")
+		return 0;
+
+	try
+	{
+		require_valid_primitive(Mesh, Primitive);
+
+		mesh::table_t& instance_structure = require_structure(Primitive, "instance");
+
+		mesh::table_t& constant_attributes = require_attributes(Primitive, "constant");
+		mesh::table_t& instance_attributes = require_attributes(Primitive, "instance");
+
+		mesh::matrices_t& matrices = require_array<mesh::matrices_t >(Primitive, instance_structure, "matrices");
+		mesh::selection_t& selections = require_array<mesh::selection_t>(Primitive, instance_structure, "selections");
+
+		require_metadata(Primitive, selections, "selections", metadata::key::role(), metadata::value::selection_role());
+
+		return new primitive(matrices, selections, constant_attributes, instance_attributes);
+	}
+	catch(std::exception& e)
+	{
+		log() << error << e.what() << std::endl;
+	}
+
+	return 0;
+}
+
+primitive* validate(const mesh& Mesh, pipeline_data<mesh::primitive>& Primitive)
+{
+	if(!Primitive.get())
+		return 0;
+
+	if(Primitive->type != "instances")
+		return 0;
+
+	return validate(Mesh, Primitive.writable());
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// exists
+
+bool_t exists(const mesh& Mesh)
+{
+	for(mesh::primitives_t::const_iterator p = Mesh.primitives.begin(); p != Mesh.primitives.end(); ++p)
+	{
+		if((*p)->type == "instances")
+			return true;
+	}
+
+	return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// get_matrices
+
+bool_t get_matrices(const mesh& Mesh, mesh::matrices_t& Matrices)
+{
+	bool_t result = false;
+	Matrices.clear();
+
+	for(mesh::primitives_t::const_iterator p = Mesh.primitives.begin(); p != Mesh.primitives.end(); ++p)
+	{
+		boost::scoped_ptr<const_primitive> instances(validate(Mesh, **p));
+		if(!instances)
+			continue;
+
+		Matrices.insert(Matrices.end(), instances->matrices.begin(), instances->matrices.end());
+		result = true;
+	}
+
+	return result;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// get_prototype
+
+void get_prototype(const mesh& Mesh, mesh& Prototype)
+{
+	Prototype = mesh();
+	Prototype.points = Mesh.points;
+	Prototype.point_selection = Mesh.point_selection;
+	Prototype.point_attributes = Mesh.point_attributes;
+
+	for(mesh::primitives_t::const_iterator p = Mesh.primitives.begin(); p != Mesh.primitives.end(); ++p)
+	{
+		if((*p)->type != "instances")
+			Prototype.primitives.push_back(*p);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// replicate
+
+void replicate(const mesh& Input, const mesh::matrices_t& Matrices, mesh& Output)
+{
+	mesh::matrices_t existing_matrices;
+	const bool_t nested = get_matrices(Input, existing_matrices);
+
+	get_prototype(Input, Output);
+
+	boost::scoped_ptr<primitive> instances(create(Output));
+	if(nested)
+	{
+		instances->matrices.reserve(Matrices.size() * existing_matrices.size());
+		for(mesh::matrices_t::const_iterator matrix = Matrices.begin(); matrix != Matrices.end(); ++matrix)
+		{
+			for(mesh::matrices_t::const_iterator existing_matrix = existing_matrices.begin(); existing_matrix != existing_matrices.end(); ++existing_matrix)
+				instances->matrices.push_back(*matrix * *existing_matrix);
+		}
+	}
+	else
+	{
+		instances->matrices.assign(Matrices.begin(), Matrices.end());
+	}
+	instances->selections.assign(instances->matrices.size(), 0.0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// flatten
+
+void flatten(const mesh& Input, mesh& Output)
+{
+	mesh::matrices_t matrices;
+	if(!get_matrices(Input, matrices))
+	{
+		Output = Input;
+		return;
+	}
+
+	mesh prototype;
+	get_prototype(Input, prototype);
+
+	Output = mesh();
+	for(mesh::matrices_t::const_iterator matrix = matrices.begin(); matrix != matrices.end(); ++matrix)
+	{
+		// Merge prototype geometry into our output ...
+		uint_t point_begin = 0;
+		uint_t point_end = 0;
+		mesh::append(prototype, Output, &point_begin, &point_end);
+
+		// Transform the corresponding output points ...
+		if(Output.points)
+		{
+			mesh::points_t& output_points = Output.points.writable();
+			for(uint_t point = point_begin; point != point_end; ++point)
+				output_points[point] = *matrix * output_points[point];
+		}
+	}
+}
+
+const mesh& explicit_geometry(const mesh& Input, mesh& Storage)
+{
+	if(!exists(Input))
+		return Input;
+
+	flatten(Input, Storage);
+	return Storage;
+}
+
+} // namespace instances
+
+} // namespace k3d
+
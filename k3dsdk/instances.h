@@ -0,0 +1,100 @@
+#ifndef K3DSDK_INSTANCES_H
+#define K3DSDK_INSTANCES_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <k3dsdk/mesh.h>
+
+namespace k3d
+{
+
+/// An "instances" primitive places transformed copies of a prototype, where the prototype is every point and every
+/// other primitive in the same mesh.  Instances let large arrays of geometry share a single copy of the prototype
+/// arrays, and can be flattened into explicit geometry when required.
+namespace instances
+{
+
+/// Gathers the member arrays of an instances primitive into a convenient package
+class const_primitive
+{
+public:
+	const_primitive(
+		const mesh::matrices_t& Matrices,
+		const mesh::selection_t& Selections,
+		const mesh::table_t& ConstantAttributes,
+		const mesh::table_t& InstanceAttributes);
+
+	const mesh::matrices_t& matrices;
+	const mesh::selection_t& selections;
+	const mesh::table_t& constant_attributes;
+	const mesh::table_t& instance_attributes;
+};
+
+/// Gathers the member arrays of an instances primitive into a convenient package
+class primitive
+{
+public:
+	primitive(
+		mesh::matrices_t& Matrices,
+		mesh::selection_t& Selections,
+		mesh::table_t& ConstantAttributes,
+		mesh::table_t& InstanceAttributes);
+
+	mesh::matrices_t& matrices;
+	mesh::selection_t& selections;
+	mesh::table_t& constant_attributes;
+	mesh::table_t& instance_attributes;
+};
+
+/// Creates a new instances mesh primitive, returning references to its member arrays.
+/// The caller is responsible for the lifetime of the returned object.
+primitive* create(mesh& Mesh);
+
+/// Tests the given mesh primitive to see if it is a valid instances primitive, returning references to its member arrays, or NULL.
+/// The caller is responsible for the lifetime of the returned object.
+const_primitive* validate(const mesh& Mesh, const mesh::primitive& GenericPrimitive);
+/// Tests the given mesh primitive to see if it is a valid instances primitive, returning references to its member arrays, or NULL.
+/// The caller is responsible for the lifetime of the returned object.
+primitive* validate(const mesh& Mesh, mesh::primitive& GenericPrimitive);
+/// Tests the given mesh primitive to see if it is a valid instances primitive, returning references to its member arrays, or NULL.
+/// The caller is responsible for the lifetime of the returned object.
+primitive* validate(const mesh& Mesh, pipeline_data<mesh::primitive>& GenericPrimitive);
+
+/// Returns true iff the given mesh contains one-or-more instances primitives.
+bool_t exists(const mesh& Mesh);
+/// Returns true iff the given mesh contains one-or-more instances primitives, storing the matrices of every instance in the mesh.
+bool_t get_matrices(const mesh& Mesh, mesh::matrices_t& Matrices);
+/// Stores the prototype of the given mesh (its points and every primitive other than instances) in Prototype.
+void get_prototype(const mesh& Mesh, mesh& Prototype);
+/// Stores the prototype of Input in Output, along with an instances primitive that places it once for every matrix in Matrices.
+/// If Input already contains instances, each new matrix is combined with every existing instance, so arrays of arrays remain shallow.
+void replicate(const mesh& Input, const mesh::matrices_t& Matrices, mesh& Output);
+/// Replaces instances with explicit, transformed copies of their prototype.  Meshes without instances are copied unchanged.
+void flatten(const mesh& Input, mesh& Output);
+/// Returns Input if it doesn't contain instances, otherwise flattens it into Storage and returns Storage.  Use this in consumers that
+/// can't process instances, so meshes without instances aren't copied.
+const mesh& explicit_geometry(const mesh& Input, mesh& Storage);
+
+} // namespace instances
+
+} // namespace k3d
+
+#endif // !K3DSDK_INSTANCES_H
+
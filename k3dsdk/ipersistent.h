@@ -65,16 +65,29 @@ public:
 	class save_context
 	{
 	public:
-		save_context(const filesystem::path& RootPath, idependencies& Dependencies, ipersistent_lookup& Lookup) :
+		/// Controls how large numeric arrays (e.g. mesh points) are stored
+		typedef enum
+		{
+			/// Whitespace-delimited text
+			TEXT_ARRAYS,
+			/// Little-endian binary data, stored as base64
+			BINARY_ARRAYS,
+			/// Little-endian binary data, compressed with zlib and stored as base64
+			COMPRESSED_BINARY_ARRAYS
+		} array_encoding_t;
+
+		save_context(const filesystem::path& RootPath, idependencies& Dependencies, ipersistent_lookup& Lookup, const array_encoding_t ArrayEncoding = TEXT_ARRAYS) :
 			root_path(RootPath),
 			dependencies(Dependencies),
-			lookup(Lookup)
+			lookup(Lookup),
+			array_encoding(ArrayEncoding)
 		{
 		}
 
 		const filesystem::path& root_path;
 		idependencies& dependencies;
 		ipersistent_lookup& lookup;
+		const array_encoding_t array_encoding;
 	};
 	/// Called once during document save
 	virtual void save(xml::element& Element, const save_context& Context) = 0;
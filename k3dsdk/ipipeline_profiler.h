@@ -25,6 +25,7 @@
 */
 
 #include <k3dsdk/iunknown.h>
+#include <k3dsdk/parallel/statistics.h>
 #include <k3dsdk/signal_system.h>
 #include <k3dsdk/types.h>
 
@@ -48,6 +49,9 @@ public:
 	
 	/// Connects a slot that will be called to report the time in seconds that a node spent processing a given task
 	virtual sigc::connection connect_node_execution_signal(const sigc::slot<void, inode&, const string_t&, double>& Slot) = 0;
+	/// Connects a slot that will be called to report the parallel work (calls, tasks, steals, and busy time) performed while a node processed a given task.
+	/// The slot is only called for tasks that used parallel algorithms.
+	virtual sigc::connection connect_node_parallel_signal(const sigc::slot<void, inode&, const string_t&, const parallel::statistics&>& Slot) = 0;
 
 	/// RAII helper class that records profile information for the current scope with return- and exception-safety
 	class profile
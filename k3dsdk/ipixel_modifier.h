@@ -0,0 +1,56 @@
+#ifndef K3DSDK_IPIXEL_MODIFIER_H
+#define K3DSDK_IPIXEL_MODIFIER_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+		\brief Declares ipixel_modifier, an interface for bitmap modifiers that transform each pixel independently
+		\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/iunknown.h>
+
+namespace k3d
+{
+
+class pixel_operation;
+
+/// Abstract interface for bitmap modifiers that transform each pixel independently, so that chains of them can be evaluated in a single pass
+class ipixel_modifier :
+	public virtual iunknown
+{
+public:
+	/// Returns a new operation that implements the modifier using its current property values (the caller takes ownership)
+	virtual pixel_operation* create_pixel_operation() = 0;
+	/// Called when a downstream modifier evaluates this one as part of a fused chain, bypassing its output.  Since the output
+	/// isn't being read, implementations should coalesce any updates queued for it instead of letting them accumulate.
+	virtual void coalesce_pending_updates() = 0;
+
+protected:
+	ipixel_modifier() {}
+	ipixel_modifier(const ipixel_modifier&) {}
+	ipixel_modifier& operator=(const ipixel_modifier&) { return *this; }
+	virtual ~ipixel_modifier() {}
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_IPIXEL_MODIFIER_H
+
@@ -0,0 +1,56 @@
+#ifndef K3DSDK_ISPILLABLE_STATE_CONTAINER_H
+#define K3DSDK_ISPILLABLE_STATE_CONTAINER_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+#include <boost/shared_ptr.hpp>
+
+namespace k3d
+{
+
+class state_spill_file;
+
+/// Abstract interface for state containers that can report their memory usage, and move their stored state to a spill file until it is restored
+class ispillable_state_container
+{
+public:
+	virtual ~ispillable_state_container() { }
+
+	/// Returns the approximate number of bytes of memory used by the stored state
+	virtual const uint_t memory_usage() = 0;
+	/// Moves the stored state into the given file, releasing its memory.  The state is read back when it is next restored.
+	virtual void spill(const boost::shared_ptr<state_spill_file>& File) = 0;
+
+protected:
+	ispillable_state_container() {}
+	ispillable_state_container(const ispillable_state_container&) {}
+	ispillable_state_container& operator = (const ispillable_state_container&) { return *this; }
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_ISPILLABLE_STATE_CONTAINER_H
+
@@ -26,6 +26,7 @@
 
 #include <k3dsdk/iunknown.h>
 #include <k3dsdk/signal_system.h>
+#include <k3dsdk/types.h>
 
 #include <memory>
 #include <string>
@@ -63,8 +64,8 @@ public:
 		const std::string label;
 		/// Points to the change set owned by this node
 		state_change_set* const change_set;
-		/// Points to this node's parent (NULL for the root node)
-		node* const parent;
+		/// Points to this node's parent (NULL for root nodes - a node becomes a root if its parent is discarded to stay within the memory budget)
+		node* parent;
 		/// Points to this node's children
 		nodes_t children;
 	};
@@ -83,11 +84,19 @@ public:
 	/// Called to mark the current node as saved
 	virtual void mark_saved() = 0;
 
+	/// Sets the approximate number of bytes of memory that recorded change sets may use.  When MemoryBudget is exceeded, the oldest change sets
+	/// are moved to a compressed temporary file, as long as the file stays within SpillBudget bytes.  Beyond that, the oldest nodes are discarded.
+	virtual void set_memory_budget(const uint64_t MemoryBudget, const uint64_t SpillBudget) = 0;
+	/// Returns the approximate number of bytes of memory used by recorded change sets
+	virtual const uint64_t memory_usage() = 0;
+
 	/// Connects a slot that will be called when recording finishes
 	virtual sigc::connection connect_recording_done_signal(const sigc::slot<void>& Slot) = 0;
 	
 	/// Connects a slot that will be called after a node is added to the hierarchy
 	virtual sigc::connection connect_node_added_signal(const sigc::slot<void, const node*>& Slot) = 0;
+	/// Connects a slot that will be called after nodes are discarded from the hierarchy to stay within the memory budget
+	virtual sigc::connection connect_nodes_removed_signal(const sigc::slot<void>& Slot) = 0;
 	/// Connects a slot that will be called when the current node has changed
 	virtual sigc::connection connect_current_node_changed_signal(const sigc::slot<void>& Slot) = 0;
 	/// Connects a slot that will be called when the last saved node has changed
@@ -0,0 +1,214 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3d-platform-config.h>
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/mapped_file.h>
+#include <k3dsdk/path.h>
+
+#if defined K3D_API_WIN32
+
+	#include <k3dsdk/win32.h>
+
+#else // K3D_API_WIN32
+
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+
+#endif // !K3D_API_WIN32
+
+namespace k3d
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// mapped_file::implementation
+
+#if defined K3D_API_WIN32
+
+class mapped_file::implementation
+{
+public:
+	implementation(const filesystem::path& Path, const char*& Begin, uint64_t& Size) :
+		file(INVALID_HANDLE_VALUE),
+		mapping(0),
+		view(0)
+	{
+		file = ::CreateFile(Path.native_filesystem_string().c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+		if(file == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER size;
+		if(!::GetFileSizeEx(file, &size) || !size.QuadPart)
+			return;
+
+		mapping = ::CreateFileMapping(file, 0, PAGE_READONLY, 0, 0, 0);
+		if(!mapping)
+			return;
+
+		view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(!view)
+			return;
+
+		Begin = static_cast<const char*>(view);
+		Size = size.QuadPart;
+	}
+
+	~implementation()
+	{
+		if(view)
+			::UnmapViewOfFile(view);
+		if(mapping)
+			::CloseHandle(mapping);
+		if(file != INVALID_HANDLE_VALUE)
+			::CloseHandle(file);
+	}
+
+	const bool_t mapped() const
+	{
+		return view != 0;
+	}
+
+private:
+	HANDLE file;
+	HANDLE mapping;
+	void* view;
+};
+
+#else // K3D_API_WIN32
+
+class mapped_file::implementation
+{
+public:
+	implementation(const filesystem::path& Path, const char*& Begin, uint64_t& Size) :
+		file(-1),
+		view(MAP_FAILED),
+		size(0)
+	{
+		file = ::open(Path.native_filesystem_string().c_str(), O_RDONLY);
+		if(file == -1)
+			return;
+
+		struct stat status;
+		if(::fstat(file, &status) != 0 || !status.st_size)
+			return;
+
+		view = ::mmap(0, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if(view == MAP_FAILED)
+			return;
+
+		size = status.st_size;
+#if defined POSIX_MADV_SEQUENTIAL
+		::posix_madvise(view, size, POSIX_MADV_SEQUENTIAL);
+#endif // POSIX_MADV_SEQUENTIAL
+
+		Begin = static_cast<const char*>(view);
+		Size = size;
+	}
+
+	~implementation()
+	{
+		if(view != MAP_FAILED)
+			::munmap(view, size);
+		if(file != -1)
+			::close(file);
+	}
+
+	const bool_t mapped() const
+	{
+		return view != MAP_FAILED;
+	}
+
+private:
+	int file;
+	void* view;
+	size_t size;
+};
+
+#endif // !K3D_API_WIN32
+
+/////////////////////////////////////////////////////////////////////////////
+// mapped_file
+
+mapped_file::mapped_file(const filesystem::path& Path) :
+	m_open(false),
+	m_begin(0),
+	m_size(0),
+	m_implementation(new implementation(Path, m_begin, m_size))
+{
+	if(m_implementation->mapped())
+	{
+		m_open = true;
+		return;
+	}
+
+	// The file is empty, or couldn't be mapped, so read it instead ...
+	filesystem::ifstream stream(Path);
+	if(!stream)
+		return;
+
+	stream.seekg(0, std::ios::end);
+	const std::streamoff size = stream.tellg();
+	stream.seekg(0, std::ios::beg);
+	if(size > 0)
+	{
+		m_buffer.resize(size);
+		stream.read(&m_buffer[0], size);
+		if(stream.gcount() != size)
+			return;
+
+		m_begin = &m_buffer[0];
+		m_size = size;
+	}
+
+	m_open = true;
+}
+
+mapped_file::~mapped_file()
+{
+	delete m_implementation;
+}
+
+const bool_t mapped_file::is_open() const
+{
+	return m_open;
+}
+
+const char* mapped_file::begin() const
+{
+	return m_begin;
+}
+
+const char* mapped_file::end() const
+{
+	return m_begin + m_size;
+}
+
+const uint64_t mapped_file::size() const
+{
+	return m_size;
+}
+
+} // namespace k3d
+
@@ -0,0 +1,70 @@
+#ifndef K3DSDK_MAPPED_FILE_H
+#define K3DSDK_MAPPED_FILE_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+#include <vector>
+
+namespace k3d
+{
+
+namespace filesystem { class path; }
+
+/// Provides read-only access to the contents of a file by mapping it into memory, so large files can be parsed in-place
+/// (and in parallel) without copying them through a stream.  Falls back to reading the file into memory if it can't be mapped.
+class mapped_file
+{
+public:
+	explicit mapped_file(const filesystem::path& Path);
+	~mapped_file();
+
+	/// Returns true iff the file was opened successfully (an empty file is still open)
+	const bool_t is_open() const;
+	/// Returns the start of the file contents
+	const char* begin() const;
+	/// Returns one-past-the-end of the file contents
+	const char* end() const;
+	/// Returns the size of the file contents in bytes
+	const uint64_t size() const;
+
+private:
+	mapped_file(const mapped_file&);
+	mapped_file& operator=(const mapped_file&);
+
+	bool_t m_open;
+	const char* m_begin;
+	uint64_t m_size;
+	/// Stores the file contents if the file couldn't be mapped
+	std::vector<char> m_buffer;
+
+	class implementation;
+	implementation* const m_implementation;
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_MAPPED_FILE_H
+
@@ -99,6 +99,16 @@ public:
 		/// Stores array data that defines the primitive's attributes.
 		named_tables_t attributes;
 
+		/// Base class for data that is derived from a primitive's topology and cached with the primitive.
+		class topology_cache
+		{
+		public:
+			virtual ~topology_cache() {}
+		};
+		/// Stores data derived from the primitive's topology (such as adjacency lookups), which is shared by copies of the primitive
+		/// and ignored by difference() and serialization.  Users of the cache must verify that it still matches the primitive's arrays.
+		mutable pipeline_data<topology_cache> cached_topology;
+
 		/// Returns the difference between two primitives using the fuzzy semantics of difference::test().
 		void difference(const primitive& Other, difference::accumulator& Result) const;
 	};
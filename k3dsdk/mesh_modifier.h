@@ -30,6 +30,7 @@
 #include <k3dsdk/idocument.h>
 #include <k3dsdk/imesh_sink.h>
 #include <k3dsdk/imesh_source.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/ipipeline_profiler.h>
 #include <k3dsdk/mesh.h>
 
@@ -78,11 +79,24 @@ protected:
 	k3d_data(mesh*, data::immutable_name, data::change_signal, data::no_undo, data::local_storage, data::no_constraint, data::read_only_property, data::no_serialization) m_input_mesh;
 	k3d_data(mesh*, data::immutable_name, data::change_signal, data::no_undo, data::pointer_storage, data::no_constraint, data::read_only_property, data::no_serialization) m_output_mesh;
 
+	/// Returns the given input mesh, or flattens any "instances" primitives into explicit geometry stored in Flattened, unless derived classes handle them
+	const mesh& explicit_input(const mesh& Input, mesh& Flattened)
+	{
+		if(preserve_instances() || !instances::exists(Input))
+			return Input;
+
+		ipipeline_profiler::profile profile(base_t::document().pipeline_profiler(), *this, "Flatten Instances");
+		return instances::explicit_geometry(Input, Flattened);
+	}
+
 private:
 	void initialize_mesh(mesh& Output)
 	{
-		if(const mesh* const input = m_input_mesh.pipeline_value())
+		if(const mesh* const pipeline_input = m_input_mesh.pipeline_value())
 		{
+			mesh flattened;
+			const mesh* const input = &explicit_input(*pipeline_input, flattened);
+
 			base_t::document().pipeline_profiler().start_execution(*this, "Create Mesh");
 			on_create_mesh(*input, Output);
 			base_t::document().pipeline_profiler().finish_execution(*this, "Create Mesh");
@@ -95,14 +109,23 @@ private:
 
 	void update_mesh(mesh& Output)
 	{
-		if(const mesh* const input = m_input_mesh.pipeline_value())
+		if(const mesh* const pipeline_input = m_input_mesh.pipeline_value())
 		{
+			mesh flattened;
+			const mesh* const input = &explicit_input(*pipeline_input, flattened);
+
 			base_t::document().pipeline_profiler().start_execution(*this, "Update Mesh");
 			on_update_mesh(*input, Output);
 			base_t::document().pipeline_profiler().finish_execution(*this, "Update Mesh");
 		}
 	}
 
+	/// Override this in derived classes that can process "instances" primitives directly, to receive input meshes without flattening.
+	virtual bool_t preserve_instances()
+	{
+		return false;
+	}
+
 	virtual void on_create_mesh(const mesh& Input, mesh& Output) = 0;
 	virtual void on_update_mesh(const mesh& Input, mesh& Output) = 0;
 };
@@ -28,6 +28,7 @@
 #include <k3dsdk/hints.h>
 #include <k3dsdk/imesh_sink.h>
 #include <k3dsdk/imesh_source.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/ipipeline_profiler.h>
 #include <k3dsdk/mesh.h>
 #include <k3dsdk/pointer_demand_storage.h>
@@ -75,12 +76,16 @@ protected:
 	void execute(const std::vector<ihint*>& Hints, mesh& Mesh)
 	{
 		// In our case, we don't have to worry about any hints, we just execute.
-		if(const mesh* const input = m_input_mesh.pipeline_value())
+		if(const mesh* const pipeline_input = m_input_mesh.pipeline_value())
 		{
-			Mesh = *input;
+			// Selections refer to explicit components, so flatten any instances ...
+			mesh flattened;
+			const mesh& input = instances::explicit_geometry(*pipeline_input, flattened);
+
+			Mesh = input;
 			
 			base_t::document().pipeline_profiler().start_execution(*this, "Update Selection");
-			on_update_selection(*input, Mesh);
+			on_update_selection(input, Mesh);
 			base_t::document().pipeline_profiler().finish_execution(*this, "Update Selection");
 		}
 	}
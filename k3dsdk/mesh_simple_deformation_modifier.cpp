@@ -21,16 +21,242 @@
 	\author Timothy M. Shead (tshead@k-3d.com)
  */
 
+#include <k3d-i18n-config.h>
 #include <k3dsdk/geometry.h>
+#include <k3dsdk/ipipeline.h>
 #include <k3dsdk/mesh_simple_deformation_modifier.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
+
+#include <algorithm>
+#include <memory>
 
 namespace k3d
 {
 
 mesh_simple_deformation_modifier::mesh_simple_deformation_modifier(iplugin_factory& Factory, idocument& Document) :
-	base(Factory, Document)
+	base(Factory, Document),
+	m_fuse_deformations(init_owner(*this) + init_name("fuse_deformations") + init_label(_("Fuse Deformations")) + init_description(_("Evaluate upstream simple deformations together with this one, avoiding a copy of the mesh points for each modifier.")) + init_value(false))
 {
 	m_mesh_selection.changed_signal().connect(make_reset_mesh_slot());
+	m_fuse_deformations.changed_signal().connect(make_reset_mesh_slot());
+
+	m_output_mesh.set_initialize_slot(sigc::mem_fun(*this, &mesh_simple_deformation_modifier::initialize_mesh));
+	m_output_mesh.set_update_slot(sigc::mem_fun(*this, &mesh_simple_deformation_modifier::update_mesh));
+}
+
+void mesh_simple_deformation_modifier::initialize_mesh(mesh& Output)
+{
+	const chain_t chain = fused_chain();
+	if(chain.size() > 1)
+	{
+		if(const mesh* const input = chain.front()->m_input_mesh.pipeline_value())
+		{
+			mesh flattened;
+			fused_deform_mesh(chain, explicit_input(*input, flattened), Output);
+		}
+		return;
+	}
+
+	if(const mesh* const pipeline_input = m_input_mesh.pipeline_value())
+	{
+		mesh flattened;
+		const mesh* const input = &explicit_input(*pipeline_input, flattened);
+
+		document().pipeline_profiler().start_execution(*this, "Create Mesh");
+		on_create_mesh(*input, Output);
+		document().pipeline_profiler().finish_execution(*this, "Create Mesh");
+
+		document().pipeline_profiler().start_execution(*this, "Update Mesh");
+		on_update_mesh(*input, Output);
+		document().pipeline_profiler().finish_execution(*this, "Update Mesh");
+	}
+}
+
+void mesh_simple_deformation_modifier::update_mesh(mesh& Output)
+{
+	const chain_t chain = fused_chain();
+	if(chain.size() > 1)
+	{
+		if(const mesh* const input = chain.front()->m_input_mesh.pipeline_value())
+		{
+			mesh flattened;
+			fused_deform_mesh(chain, explicit_input(*input, flattened), Output);
+		}
+		return;
+	}
+
+	if(const mesh* const pipeline_input = m_input_mesh.pipeline_value())
+	{
+		mesh flattened;
+		const mesh* const input = &explicit_input(*pipeline_input, flattened);
+
+		document().pipeline_profiler().start_execution(*this, "Update Mesh");
+		on_update_mesh(*input, Output);
+		document().pipeline_profiler().finish_execution(*this, "Update Mesh");
+	}
+}
+
+const mesh_simple_deformation_modifier::chain_t mesh_simple_deformation_modifier::fused_chain()
+{
+	chain_t chain(1, this);
+	if(!m_fuse_deformations.pipeline_value())
+		return chain;
+
+	ipipeline& pipeline = document().pipeline();
+	const ipipeline::dependencies_t& dependencies = pipeline.dependencies();
+
+	while(true)
+	{
+		iproperty* const source = pipeline.dependency(chain.back()->m_input_mesh);
+		if(!source)
+			break;
+
+		mesh_simple_deformation_modifier* const upstream = dynamic_cast<mesh_simple_deformation_modifier*>(source->property_node());
+		if(!upstream || source != &upstream->mesh_source_output())
+			break;
+
+		// If anything else consumes the upstream output, it will be computed anyway, so the chain stops here ...
+		uint_t consumers = 0;
+		for(ipipeline::dependencies_t::const_iterator dependency = dependencies.begin(); dependency != dependencies.end(); ++dependency)
+		{
+			if(dependency->second == source)
+				++consumers;
+		}
+		if(consumers != 1)
+			break;
+
+		chain.push_back(upstream);
+	}
+
+	std::reverse(chain.begin(), chain.end());
+	return chain;
+}
+
+namespace detail
+{
+
+/// Applies a run of point deformations to blocks of points, initializing each block from the input points first if necessary
+class fused_deformation_worker
+{
+public:
+	typedef std::vector<std::shared_ptr<mesh_simple_deformation_modifier::point_deformation> > deformations_t;
+	typedef std::vector<pipeline_data<mesh::selection_t> > selections_t;
+
+	fused_deformation_worker(const mesh::points_t* const InputPoints, const deformations_t& Deformations, const selections_t& Selections, mesh::points_t& OutputPoints) :
+		input_points(InputPoints),
+		deformations(Deformations),
+		selections(Selections),
+		output_points(OutputPoints)
+	{
+	}
+
+	void operator()(const parallel::blocked_range<uint_t>& Range) const
+	{
+		if(input_points)
+			std::copy(input_points->begin() + Range.begin(), input_points->begin() + Range.end(), output_points.begin() + Range.begin());
+
+		for(uint_t i = 0; i != deformations.size(); ++i)
+			deformations[i]->deform(Range.begin(), Range.end(), *selections[i], output_points);
+	}
+
+private:
+	const mesh::points_t* const input_points;
+	const deformations_t& deformations;
+	const selections_t& selections;
+	mesh::points_t& output_points;
+};
+
+} // namespace detail
+
+void mesh_simple_deformation_modifier::fused_deform_mesh(const chain_t& Chain, const mesh& Input, mesh& Output)
+{
+	Output = Input;
+
+	if(!Input.points)
+		return;
+
+	const uint_t point_count = Input.points->size();
+
+	// Each stage deforms using the selection merged by itself and every upstream stage ...
+	detail::fused_deformation_worker::selections_t selections;
+	for(uint_t stage = 0; stage != Chain.size(); ++stage)
+	{
+		mesh_simple_deformation_modifier& node = *Chain[stage];
+
+		node.document().pipeline_profiler().start_execution(node, "Create Mesh");
+		geometry::selection::merge(node.m_mesh_selection.pipeline_value(), Output);
+		node.document().pipeline_profiler().finish_execution(node, "Create Mesh");
+
+		return_if_fail(Output.point_selection);
+		return_if_fail(Output.point_selection->size() == point_count);
+
+		// Share the merged selection, so the next stage merges into a copy instead of overwriting it ...
+		selections.push_back(Output.point_selection);
+		Output.point_selection = selections.back();
+	}
+
+	std::unique_ptr<mesh::points_t> output_points(new mesh::points_t(point_count));
+	// Set once the output points have been initialized from the input points ...
+	bool_t initialized = false;
+
+	for(uint_t stage = 0; stage != Chain.size(); )
+	{
+		// Collect the run of stages that deform each point independently ...
+		detail::fused_deformation_worker::deformations_t deformations;
+		uint_t run_end = stage;
+		for(; run_end != Chain.size(); ++run_end)
+		{
+			point_deformation* const deformation = Chain[run_end]->create_point_deformation();
+			if(!deformation)
+				break;
+			deformations.push_back(std::shared_ptr<point_deformation>(deformation));
+		}
+
+		if(deformations.size())
+		{
+			mesh_simple_deformation_modifier& node = *Chain[run_end - 1];
+			const detail::fused_deformation_worker::selections_t run_selections(selections.begin() + stage, selections.begin() + run_end);
+
+			node.document().pipeline_profiler().start_execution(node, "Update Mesh");
+			parallel::parallel_for(
+				parallel::blocked_range<uint_t>(0, point_count, parallel::grain_size()),
+				detail::fused_deformation_worker(initialized ? 0 : Input.points.get(), deformations, run_selections, *output_points));
+			node.document().pipeline_profiler().finish_execution(node, "Update Mesh");
+
+			initialized = true;
+			stage = run_end;
+			continue;
+		}
+
+		// This stage needs all of its input points at once, so it can't work in-place.  Deformers may leave points untouched,
+		// so the output starts with the input ...
+		mesh_simple_deformation_modifier& node = *Chain[stage];
+
+		node.document().pipeline_profiler().start_execution(node, "Copy points");
+		mesh::points_t previous_points;
+		if(initialized)
+			previous_points = *output_points;
+		else
+			std::copy(Input.points->begin(), Input.points->end(), output_points->begin());
+		const mesh::points_t& stage_input = initialized ? previous_points : *Input.points;
+		node.document().pipeline_profiler().finish_execution(node, "Copy points");
+
+		node.document().pipeline_profiler().start_execution(node, "Update Mesh");
+		node.on_deform_mesh(stage_input, *selections[stage], *output_points);
+		node.document().pipeline_profiler().finish_execution(node, "Update Mesh");
+
+		initialized = true;
+		++stage;
+	}
+
+	Output.points.create(output_points.release());
+}
+
+mesh_simple_deformation_modifier::point_deformation* mesh_simple_deformation_modifier::create_point_deformation()
+{
+	return 0;
 }
 
 void mesh_simple_deformation_modifier::on_create_mesh(const mesh& Input, mesh& Output)
@@ -61,4 +287,3 @@ void mesh_simple_deformation_modifier::on_update_mesh(const mesh& Input, mesh& O
 }
 
 } // namespace k3d
-
@@ -28,6 +28,8 @@
 #include <k3dsdk/mesh_modifier.h>
 #include <k3dsdk/node.h>
 
+#include <vector>
+
 namespace k3d
 {
 
@@ -40,12 +42,40 @@ class mesh_simple_deformation_modifier :
 public:
 	mesh_simple_deformation_modifier(iplugin_factory& Factory, idocument& Document);
 
+	/// Deforms each point independently of the others, so that the deformations of a chain of modifiers can be applied to blocks of points in a single pass
+	class point_deformation
+	{
+	public:
+		virtual ~point_deformation() {}
+
+		/// Deforms the points in the half-open range [Begin, End) in-place, weighted by their selection.  Called concurrently for disjoint ranges.
+		virtual void deform(const uint_t Begin, const uint_t End, const mesh::selection_t& PointSelection, mesh::points_t& Points) const = 0;
+	};
+
 private:
+	/// Defines a linear chain of simple deformation modifiers, ordered from upstream to downstream
+	typedef std::vector<mesh_simple_deformation_modifier*> chain_t;
+
+	void initialize_mesh(mesh& Output);
+	void update_mesh(mesh& Output);
+	/// Returns the chain of simple deformation modifiers ending with this one that can be evaluated together
+	const chain_t fused_chain();
+	/// Evaluates a chain of simple deformation modifiers as a single operation.  Runs of modifiers that provide a point_deformation are applied
+	/// together in one parallel pass over blocks of points, without copying the points between them.
+	static void fused_deform_mesh(const chain_t& Chain, const mesh& Input, mesh& Output);
+
 	void on_create_mesh(const mesh& Input, mesh& Output);
 	void on_update_mesh(const mesh& Input, mesh& Output);
 
 	/// Implement this method in derived classes and deform the output mesh using its input points and selection.
 	virtual void on_deform_mesh(const mesh::points_t& InputPoints, const mesh::selection_t& PointSelection, mesh::points_t& OutputPoints) = 0;
+	/// Optionally implement this method in derived classes whose deformation of each point depends only on that point's input position and
+	/// selection, returning the deformation for the current property values (the caller takes ownership).  Return NULL (the default) if the
+	/// deformation needs all of the input points at once, e.g. to compute their bounds.  Used when fusing deformations.
+	virtual point_deformation* create_point_deformation();
+
+	/// When true, upstream simple deformation modifiers are evaluated together with this one
+	k3d_data(bool_t, data::immutable_name, data::change_signal, data::with_undo, data::local_storage, data::no_constraint, data::writable_property, data::with_serialization) m_fuse_deformations;
 };
 
 } // namespace k3d
@@ -29,6 +29,7 @@
 #include <k3dsdk/fstream.h>
 #include <k3dsdk/hints.h>
 #include <k3dsdk/imesh_sink.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/ipipeline_profiler.h>
 
 namespace k3d
@@ -91,8 +92,14 @@ private:
 			return;
 		}
 
+		// File formats have no notion of instances, so write them as explicit geometry ...
+		const bool_t has_instances = instances::exists(*mesh);
+		k3d::mesh flattened_mesh;
+		if(has_instances)
+			instances::flatten(*mesh, flattened_mesh);
+
 		base_t::document().pipeline_profiler().start_execution(*this, "Write Mesh");
-		on_write_mesh(*mesh, path, stream);
+		on_write_mesh(has_instances ? flattened_mesh : *mesh, path, stream);
 		base_t::document().pipeline_profiler().finish_execution(*this, "Write Mesh");
 	}
 
@@ -265,6 +265,22 @@ public:
 		return m_frames.back();
 	}
 
+	const filesystem::path add_file(const string_t& Name)
+	{
+		// Sanity checks ...
+		assert_warning(Name.size());
+
+		// Make sure the filepath is unique ...
+		unsigned long index = 0;
+		string_t name = Name;
+		while(std::count(m_files.begin(), m_files.end(), name))
+			name = Name + '-' + string_cast(++index);
+
+		m_files.push_back(name);
+
+		return m_Path / filesystem::generic_path(name);
+	}
+
 	bool write_control_files()
 	{
 		// Create a control file for each frame ...
@@ -306,6 +322,9 @@ private:
 
 	typedef std::list<network_render_frame> frames_t;
 	frames_t m_frames;
+
+	typedef std::vector<string_t> files_t;
+	files_t m_files;
 };
 
 /////////////////////////////////////////////////////////////////////////////
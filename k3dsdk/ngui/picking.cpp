@@ -0,0 +1,574 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/bounding_volume_hierarchy.h>
+#include <k3dsdk/classes.h>
+#include <k3dsdk/hints.h>
+#include <k3dsdk/idocument.h>
+#include <k3dsdk/imesh_painter_gl.h>
+#include <k3dsdk/imesh_source.h>
+#include <k3dsdk/inode.h>
+#include <k3dsdk/inode_collection.h>
+#include <k3dsdk/instances.h>
+#include <k3dsdk/iplugin_factory.h>
+#include <k3dsdk/iproperty_collection.h>
+#include <k3dsdk/ngui/picking.h>
+#include <k3dsdk/ngui/selection.h>
+#include <k3dsdk/nodes.h>
+#include <k3dsdk/polyhedron.h>
+#include <k3dsdk/property.h>
+#include <k3dsdk/rectangle.h>
+#include <k3dsdk/selection_state_gl.h>
+#include <k3dsdk/transform.h>
+#include <k3dsdk/triangulator.h>
+#include <k3dsdk/utility_gl.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <limits>
+#include <map>
+
+namespace k3d
+{
+
+namespace ngui
+{
+
+namespace picking
+{
+
+namespace detail
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// triangulate_faces
+
+/// Triangulates a polyhedron for picking, recording how to recompute any vertices that the triangulator adds
+class triangulate_faces :
+	public k3d::triangulator
+{
+public:
+	triangulate_faces(const uint_t PointCount, mesh::indices_t& TriangleVertices, mesh::indices_t& TriangleFaces, mesh::indices_t& NewVertexPoints, mesh::weights_t& NewVertexWeights) :
+		m_point_count(PointCount),
+		m_current_face(0),
+		m_triangle_vertices(TriangleVertices),
+		m_triangle_faces(TriangleFaces),
+		m_new_vertex_points(NewVertexPoints),
+		m_new_vertex_weights(NewVertexWeights)
+	{
+	}
+
+private:
+	void start_face(const uint_t Face)
+	{
+		m_current_face = Face;
+	}
+
+	void add_vertex(const point3& Coordinates, uint_t Vertices[4], uint_t Edges[4], double_t Weights[4], uint_t& NewVertex)
+	{
+		NewVertex = m_point_count + m_new_vertex_points.size() / 4;
+
+		for(uint_t i = 0; i != 4; ++i)
+		{
+			m_new_vertex_points.push_back(Weights[i] ? Vertices[i] : 0);
+			m_new_vertex_weights.push_back(Weights[i]);
+		}
+	}
+
+	void add_triangle(uint_t Vertices[3], uint_t Edges[3])
+	{
+		m_triangle_vertices.push_back(Vertices[0]);
+		m_triangle_vertices.push_back(Vertices[1]);
+		m_triangle_vertices.push_back(Vertices[2]);
+		m_triangle_faces.push_back(m_current_face);
+	}
+
+	const uint_t m_point_count;
+	uint_t m_current_face;
+	mesh::indices_t& m_triangle_vertices;
+	mesh::indices_t& m_triangle_faces;
+	mesh::indices_t& m_new_vertex_points;
+	mesh::weights_t& m_new_vertex_weights;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// polyhedron_cache
+
+/// Caches picking data for a single polyhedron
+class polyhedron_cache
+{
+public:
+	polyhedron_cache(const mesh& Mesh, const polyhedron::const_primitive& Polyhedron) :
+		sds(polyhedron::is_sds(Polyhedron)),
+		face_count(Polyhedron.face_first_loops.size()),
+		edge_count(Polyhedron.clockwise_edges.size())
+	{
+		const mesh::points_t& points = *Mesh.points;
+
+		mesh::indices_t edge_vertices(2 * edge_count);
+		for(uint_t edge = 0; edge != edge_count; ++edge)
+		{
+			edge_vertices[2 * edge + 0] = Polyhedron.vertex_points[edge];
+			edge_vertices[2 * edge + 1] = Polyhedron.vertex_points[Polyhedron.clockwise_edges[edge]];
+		}
+		edges.reset(new bounding_volume_hierarchy(2, edge_vertices, points));
+
+		// Subdivision surfaces are drawn as limit surfaces, so we can't pick their faces ...
+		if(sds)
+			return;
+
+		mesh::indices_t triangle_vertices;
+		triangulate_faces(points.size(), triangle_vertices, triangle_faces, new_vertex_points, new_vertex_weights).process(Mesh, Polyhedron);
+
+		update_triangle_points(points);
+		triangles.reset(new bounding_volume_hierarchy(3, triangle_vertices, triangle_points));
+	}
+
+	/// Returns true iff this cache was created from a polyhedron with the same topology
+	bool_t matches(const polyhedron::const_primitive& Polyhedron) const
+	{
+		return face_count == Polyhedron.face_first_loops.size() && edge_count == Polyhedron.clockwise_edges.size() && sds == polyhedron::is_sds(Polyhedron);
+	}
+
+	/// Updates cached bounding volumes after the mesh points have moved
+	void refit(const mesh::points_t& Points)
+	{
+		edges->refit(Points);
+
+		if(triangles)
+		{
+			update_triangle_points(Points);
+			triangles->refit(triangle_points);
+		}
+	}
+
+	const bool_t sds;
+	const uint_t face_count;
+	const uint_t edge_count;
+
+	/// Stores a hierarchy over every edge, in edge order
+	boost::scoped_ptr<bounding_volume_hierarchy> edges;
+	/// Stores a hierarchy over every triangle, or NULL for subdivision surfaces
+	boost::scoped_ptr<bounding_volume_hierarchy> triangles;
+	/// Stores the source face for each triangle
+	mesh::indices_t triangle_faces;
+	/// Stores the mesh points, followed by any vertices added by the triangulator
+	mesh::points_t triangle_points;
+
+private:
+	void update_triangle_points(const mesh::points_t& Points)
+	{
+		const uint_t new_vertex_count = new_vertex_points.size() / 4;
+		triangle_points.assign(Points.begin(), Points.end());
+		triangle_points.resize(Points.size() + new_vertex_count);
+
+		for(uint_t i = 0; i != new_vertex_count; ++i)
+		{
+			point3 new_vertex(0, 0, 0);
+			for(uint_t j = 0; j != 4; ++j)
+				new_vertex += new_vertex_weights[4 * i + j] * to_vector(triangle_points[new_vertex_points[4 * i + j]]);
+			triangle_points[Points.size() + i] = new_vertex;
+		}
+	}
+
+	mesh::indices_t new_vertex_points;
+	mesh::weights_t new_vertex_weights;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// mesh_cache
+
+/// Caches picking data for the output mesh of a single mesh instance, discarding it when the mesh topology changes
+class mesh_cache :
+	public sigc::trackable
+{
+public:
+	mesh_cache(imesh_source& MeshSource) :
+		other_primitives(false),
+		sds_primitives(false),
+		m_point_count(0),
+		m_valid(false),
+		m_geometry_changed(false)
+	{
+		MeshSource.mesh_source_output().property_changed_signal().connect(sigc::mem_fun(*this, &mesh_cache::on_mesh_changed));
+	}
+
+	~mesh_cache()
+	{
+		clear();
+	}
+
+	/// Brings the cache up-to-date with the given mesh
+	void update(const mesh& Mesh)
+	{
+		const uint_t point_count = Mesh.points ? Mesh.points->size() : 0;
+		if(!m_valid || point_count != m_point_count || Mesh.primitives.size() != polyhedra.size())
+		{
+			rebuild(Mesh);
+			return;
+		}
+
+		for(uint_t primitive = 0; primitive != Mesh.primitives.size(); ++primitive)
+		{
+			boost::scoped_ptr<polyhedron::const_primitive> source_polyhedron(polyhedron::validate(Mesh, *Mesh.primitives[primitive]));
+			if(bool_t(source_polyhedron) != bool_t(polyhedra[primitive]) || (source_polyhedron && !polyhedra[primitive]->matches(*source_polyhedron)))
+			{
+				rebuild(Mesh);
+				return;
+			}
+		}
+
+		if(m_geometry_changed)
+		{
+			if(points)
+				points->refit(*Mesh.points);
+
+			for(uint_t primitive = 0; primitive != polyhedra.size(); ++primitive)
+			{
+				if(polyhedra[primitive])
+					polyhedra[primitive]->refit(*Mesh.points);
+			}
+
+			m_geometry_changed = false;
+		}
+	}
+
+	/// Stores a hierarchy over every mesh point, or NULL for a mesh without points
+	boost::scoped_ptr<bounding_volume_hierarchy> points;
+	/// Stores picking data for each primitive, or NULL for primitives that aren't polyhedra
+	std::vector<polyhedron_cache*> polyhedra;
+	/// Set to true if the mesh contains primitives other than polyhedra
+	bool_t other_primitives;
+	/// Set to true if the mesh contains subdivision surfaces
+	bool_t sds_primitives;
+
+private:
+	void rebuild(const mesh& Mesh)
+	{
+		clear();
+
+		m_point_count = Mesh.points ? Mesh.points->size() : 0;
+		if(Mesh.points)
+		{
+			mesh::indices_t point_vertices(m_point_count);
+			for(uint_t point = 0; point != m_point_count; ++point)
+				point_vertices[point] = point;
+			points.reset(new bounding_volume_hierarchy(1, point_vertices, *Mesh.points));
+		}
+
+		for(uint_t primitive = 0; primitive != Mesh.primitives.size(); ++primitive)
+		{
+			boost::scoped_ptr<polyhedron::const_primitive> source_polyhedron(polyhedron::validate(Mesh, *Mesh.primitives[primitive]));
+			if(source_polyhedron)
+			{
+				polyhedra.push_back(new polyhedron_cache(Mesh, *source_polyhedron));
+				sds_primitives = sds_primitives || polyhedra.back()->sds;
+			}
+			else
+			{
+				polyhedra.push_back(0);
+				other_primitives = true;
+			}
+		}
+
+		m_valid = true;
+		m_geometry_changed = false;
+	}
+
+	void clear()
+	{
+		points.reset();
+		for(uint_t i = 0; i != polyhedra.size(); ++i)
+			delete polyhedra[i];
+		polyhedra.clear();
+		other_primitives = false;
+		sds_primitives = false;
+		m_valid = false;
+	}
+
+	void on_mesh_changed(ihint* Hint)
+	{
+		if(dynamic_cast<hint::selection_changed*>(Hint))
+			return;
+
+		if(dynamic_cast<hint::mesh_geometry_changed*>(Hint))
+		{
+			m_geometry_changed = true;
+			return;
+		}
+
+		m_valid = false;
+	}
+
+	uint_t m_point_count;
+	bool_t m_valid;
+	bool_t m_geometry_changed;
+};
+
+/// Stores picking data for each mesh instance
+typedef std::map<inode*, mesh_cache*> mesh_caches_t;
+
+mesh_caches_t& mesh_caches()
+{
+	static mesh_caches_t caches;
+	return caches;
+}
+
+void on_node_deleted(inode* Node)
+{
+	mesh_caches_t::iterator cache = mesh_caches().find(Node);
+	if(cache == mesh_caches().end())
+		return;
+
+	delete cache->second;
+	mesh_caches().erase(cache);
+}
+
+/// Returns the (possibly out-of-date) picking data for a mesh instance, creating it if it doesn't already exist
+mesh_cache& get_mesh_cache(inode& Node, imesh_source& MeshSource)
+{
+	mesh_caches_t::iterator cache = mesh_caches().find(&Node);
+	if(cache == mesh_caches().end())
+	{
+		cache = mesh_caches().insert(std::make_pair(&Node, new mesh_cache(MeshSource))).first;
+		Node.deleted_signal().connect(sigc::bind(sigc::ptr_fun(on_node_deleted), &Node));
+	}
+
+	return *cache->second;
+}
+
+/// Records which mesh components a painter (including any painters it contains) draws, and therefore which can be picked
+struct painted_components
+{
+	painted_components() :
+		points(false),
+		edges(false),
+		sds_points(false),
+		sds_edges(false)
+	{
+	}
+
+	bool_t points;
+	bool_t edges;
+	/// Set to true if subdivision surface points are drawn, which only OpenGL selection handles
+	bool_t sds_points;
+	/// Set to true if subdivision surface edges are drawn, which only OpenGL selection handles
+	bool_t sds_edges;
+};
+
+/// Determines which mesh components are drawn by a painter, looking inside multi-painters
+void get_painted_components(inode* const Painter, painted_components& Components)
+{
+	if(!Painter)
+		return;
+
+	const string_t name = Painter->factory().name();
+	if(name == "OpenGLPointPainter" || name == "VirtualOpenGLPointPainter")
+		Components.points = true;
+	else if(name == "OpenGLEdgePainter" || name == "VirtualOpenGLEdgePainter")
+		Components.edges = true;
+	else if(name == "OpenGLSDSPointPainter" || name == "VirtualOpenGLSDSPointPainter")
+		Components.sds_points = true;
+	else if(name == "OpenGLSDSEdgePainter" || name == "VirtualOpenGLSDSEdgePainter")
+		Components.sds_edges = true;
+
+	// Multi-painters draw using the painters referenced by their node properties ...
+	iproperty_collection* const property_collection = dynamic_cast<iproperty_collection*>(Painter);
+	if(!property_collection)
+		return;
+
+	const iproperty_collection::properties_t& properties = property_collection->properties();
+	for(iproperty_collection::properties_t::const_iterator prop = properties.begin(); prop != properties.end(); ++prop)
+	{
+		iproperty& property = **prop;
+		if(property.property_type() != typeid(inode*))
+			continue;
+
+		inode* const child = boost::any_cast<inode*>(property::pipeline_value(property));
+		if(dynamic_cast<k3d::gl::imesh_painter*>(child))
+			get_painted_components(child, Components);
+	}
+}
+
+/// Converts a normalized window depth into the integer representation used by OpenGL selection
+const GLuint selection_depth(const double_t Depth)
+{
+	return static_cast<GLuint>(Depth * static_cast<double_t>(std::numeric_limits<GLuint>::max()));
+}
+
+/// Appends a selection record for an element found by a query
+void add_record(const k3d::selection::record& Base, const bounding_volume_hierarchy::hit& Hit, const k3d::selection::type Type, const k3d::selection::id ID, k3d::selection::records& Records)
+{
+	Records.push_back(Base);
+	Records.back().zmin = selection_depth(Hit.zmin);
+	Records.back().zmax = selection_depth(Hit.zmax);
+	Records.back().tokens.push_back(k3d::selection::token(Type, ID));
+}
+
+} // namespace detail
+
+bool_t get_selection(idocument& Document, const k3d::gl::selection_state& SelectionState, const rectangle& SelectionRegion, const GLdouble ViewMatrix[16], const GLdouble ProjectionMatrix[16], const GLint Viewport[4], k3d::selection::records& Records)
+{
+	const bool_t select_points = SelectionState.select_component.count(k3d::selection::POINT);
+	const bool_t select_edges = SelectionState.select_component.count(k3d::selection::EDGE);
+	const bool_t select_faces = SelectionState.select_component.count(k3d::selection::FACE);
+	const bool_t select_other = SelectionState.select_component.count(k3d::selection::CURVE) || SelectionState.select_component.count(k3d::selection::PATCH) || SelectionState.select_component.count(k3d::selection::SURFACE);
+
+	if(!select_points && !select_edges && !select_faces)
+		return false;
+
+	if(Viewport[2] <= 0 || Viewport[3] <= 0)
+		return false;
+
+	// Convert the selection region (in widget coordinates) into normalized device coordinates ...
+	const rectangle region = rectangle::normalize(SelectionRegion);
+	const double_t left = 2.0 * (region.x1 - Viewport[0]) / Viewport[2] - 1.0;
+	const double_t right = 2.0 * (region.x2 - Viewport[0]) / Viewport[2] - 1.0;
+	const double_t bottom = 2.0 * ((Viewport[3] - region.y2) - Viewport[1]) / Viewport[3] - 1.0;
+	const double_t top = 2.0 * ((Viewport[3] - region.y1) - Viewport[1]) / Viewport[3] - 1.0;
+
+	GLdouble view_matrix[16];
+	GLdouble projection_matrix[16];
+	std::copy(ViewMatrix, ViewMatrix + 16, view_matrix);
+	std::copy(ProjectionMatrix, ProjectionMatrix + 16, projection_matrix);
+	const matrix4 world_to_clip = k3d::gl::matrix(projection_matrix) * k3d::gl::matrix(view_matrix);
+
+	const k3d::nodes_t nodes = SelectionState.exclude_unselected_nodes ? selection::state(Document).selected_nodes() : Document.nodes().collection();
+
+	k3d::selection::records records;
+	bounding_volume_hierarchy::hits_t hits;
+	for(k3d::nodes_t::const_iterator node = nodes.begin(); node != nodes.end(); ++node)
+	{
+		if((*node)->factory().factory_id() != classes::MeshInstance())
+			continue;
+
+		imesh_source* const mesh_source = dynamic_cast<imesh_source*>(*node);
+		if(!mesh_source)
+			continue;
+
+		// Hidden mesh instances aren't drawn, so they can't be picked ...
+		iproperty* const visible = property::get(**node, "viewport_visible");
+		if(visible && !property::pipeline_value<bool_t>(*visible))
+			continue;
+
+		// Mesh instances without a painter can't be picked ...
+		iproperty* const painter = property::get(**node, "gl_painter");
+		k3d::gl::imesh_painter* const painter_value = painter ? property::pipeline_value<k3d::gl::imesh_painter*>(*painter) : 0;
+		if(!painter_value)
+			continue;
+
+		// Only components that the painter draws can be picked ...
+		detail::painted_components painted;
+		detail::get_painted_components(dynamic_cast<inode*>(painter_value), painted);
+
+		const mesh* const instance_mesh = property::pipeline_value<k3d::mesh*>(mesh_source->mesh_source_output());
+		if(!instance_mesh)
+			continue;
+
+		// Instances are drawn as transformed copies of their prototype, which only OpenGL selection handles ...
+		if(instances::exists(*instance_mesh))
+			return false;
+
+		detail::mesh_cache& cache = detail::get_mesh_cache(**node, *mesh_source);
+		cache.update(*instance_mesh);
+
+		if(select_other && cache.other_primitives)
+			return false;
+		if(select_faces && cache.sds_primitives)
+			return false;
+		if(cache.sds_primitives && ((select_points && painted.sds_points) || (select_edges && painted.sds_edges)))
+			return false;
+
+		const matrix4 node_matrix = node_to_world_matrix(**node);
+		const selection_frustum frustum(world_to_clip * node_matrix, left, right, bottom, top);
+
+		k3d::selection::record base = k3d::selection::make_record(*node);
+		base.tokens.push_back(k3d::selection::token(k3d::selection::MESH, 0));
+
+		if(select_points && painted.points && cache.points)
+		{
+			hits.clear();
+			cache.points->intersect(frustum, *instance_mesh->points, bounding_volume_hierarchy::CULL_NONE, hits);
+			for(bounding_volume_hierarchy::hits_t::const_iterator hit = hits.begin(); hit != hits.end(); ++hit)
+				detail::add_record(base, *hit, k3d::selection::POINT, hit->element, records);
+		}
+
+		// Painters draw front faces with clockwise winding, unless the instance matrix turns the mesh inside-out ...
+		const bounding_volume_hierarchy::culling culling = SelectionState.select_backfacing ? bounding_volume_hierarchy::CULL_NONE : inside_out(node_matrix) ? bounding_volume_hierarchy::CULL_CLOCKWISE : bounding_volume_hierarchy::CULL_COUNTER_CLOCKWISE;
+
+		for(uint_t primitive = 0; primitive != cache.polyhedra.size(); ++primitive)
+		{
+			const detail::polyhedron_cache* const primitive_cache = cache.polyhedra[primitive];
+			if(!primitive_cache)
+				continue;
+
+			k3d::selection::record primitive_base = base;
+			primitive_base.tokens.push_back(k3d::selection::token(k3d::selection::PRIMITIVE, primitive));
+
+			if(select_edges && painted.edges)
+			{
+				hits.clear();
+				primitive_cache->edges->intersect(frustum, *instance_mesh->points, bounding_volume_hierarchy::CULL_NONE, hits);
+				for(bounding_volume_hierarchy::hits_t::const_iterator hit = hits.begin(); hit != hits.end(); ++hit)
+					detail::add_record(primitive_base, *hit, k3d::selection::EDGE, hit->element, records);
+			}
+
+			if(select_faces && primitive_cache->triangles)
+			{
+				hits.clear();
+				primitive_cache->triangles->intersect(frustum, primitive_cache->triangle_points, culling, hits);
+
+				// OpenGL reports one hit per face, covering the depth range of all its triangles ...
+				typedef std::map<uint_t, bounding_volume_hierarchy::hit> face_hits_t;
+				face_hits_t face_hits;
+				for(bounding_volume_hierarchy::hits_t::const_iterator hit = hits.begin(); hit != hits.end(); ++hit)
+				{
+					const uint_t face = primitive_cache->triangle_faces[hit->element];
+					face_hits_t::iterator face_hit = face_hits.find(face);
+					if(face_hit == face_hits.end())
+					{
+						face_hits.insert(std::make_pair(face, *hit));
+					}
+					else
+					{
+						face_hit->second.zmin = std::min(face_hit->second.zmin, hit->zmin);
+						face_hit->second.zmax = std::max(face_hit->second.zmax, hit->zmax);
+					}
+				}
+
+				for(face_hits_t::const_iterator face_hit = face_hits.begin(); face_hit != face_hits.end(); ++face_hit)
+					detail::add_record(primitive_base, face_hit->second, k3d::selection::FACE, face_hit->first, records);
+			}
+		}
+	}
+
+	Records.swap(records);
+	return true;
+}
+
+} // namespace picking
+
+} // namespace ngui
+
+} // namespace k3d
+
@@ -0,0 +1,56 @@
+#ifndef K3DSDK_NGUI_PICKING_H
+#define K3DSDK_NGUI_PICKING_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/gl.h>
+#include <k3dsdk/selection.h>
+
+namespace k3d
+{
+
+class idocument;
+class rectangle;
+namespace gl { class selection_state; }
+
+namespace ngui
+{
+
+namespace picking
+{
+
+/// Picks mesh points, polyhedron edges, and polyhedron faces within a region of a viewport on the CPU, using a bounding volume hierarchy
+/// that is cached for each mesh instance and refit when only its geometry changes.  The results contain the same tokens and depths that
+/// OpenGL selection would produce.  Returns false without modifying Records if the request or the scene contains anything that can
+/// only be picked with OpenGL (such as curves, patches, subdivision surface faces, or instances), so callers can fall back to GL_SELECT.
+bool_t get_selection(idocument& Document, const k3d::gl::selection_state& SelectionState, const rectangle& SelectionRegion, const GLdouble ViewMatrix[16], const GLdouble ProjectionMatrix[16], const GLint Viewport[4], k3d::selection::records& Records);
+
+} // namespace picking
+
+} // namespace ngui
+
+} // namespace k3d
+
+#endif // !K3DSDK_NGUI_PICKING_H
+
@@ -44,6 +44,7 @@
 #include <k3dsdk/mesh.h>
 #include <k3dsdk/ngui/document_state.h>
 #include <k3dsdk/ngui/modifiers.h>
+#include <k3dsdk/ngui/picking.h>
 #include <k3dsdk/ngui/selection.h>
 #include <k3dsdk/ngui/selection.h>
 #include <k3dsdk/ngui/tool.h>
@@ -370,6 +371,8 @@ public:
 		m_font_begin(0),
 		m_font_end(0)
 	{
+		// An empty viewport marks the cached matrices as invalid until the first redraw ...
+		std::fill(m_gl_viewport, m_gl_viewport + 4, 0);
 	}
 
 	/// Stores a reference to the owning document
@@ -1322,6 +1325,18 @@ const k3d::selection::records control::get_selection(const k3d::gl::selection_st
 {
 	k3d::selection::records selection;
 
+	// Component selection within selected nodes can usually be handled on the CPU, without re-rendering the scene ...
+	if(SelectionState.exclude_unselected_nodes && is_realized() && m_implementation->m_camera.internal_value())
+	{
+		if(picking::get_selection(m_implementation->m_document_state.document(), SelectionState, SelectionRegion, m_implementation->m_gl_view_matrix, m_implementation->m_gl_projection_matrix, m_implementation->m_gl_viewport, selection))
+		{
+			std::copy(m_implementation->m_gl_view_matrix, m_implementation->m_gl_view_matrix + 16, ViewMatrix);
+			std::copy(m_implementation->m_gl_projection_matrix, m_implementation->m_gl_projection_matrix + 16, ProjectionMatrix);
+			std::copy(m_implementation->m_gl_viewport, m_implementation->m_gl_viewport + 4, Viewport);
+			return selection;
+		}
+	}
+
 	const unsigned int hit_count = select(SelectionState, SelectionRegion, ViewMatrix, ProjectionMatrix, Viewport);
 
 	for(detail::hit_iterator hit(m_implementation->m_selection_buffer, hit_count); hit != detail::hit_iterator(); ++hit)
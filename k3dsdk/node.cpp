@@ -123,16 +123,7 @@ const std::vector<inode*> node::lookup(idocument& Document, const uuid FactoryID
 
 const std::vector<inode*> node::lookup(idocument& Document, const string_t& NodeName)
 {
-	std::vector<inode*> result;
-
-	const std::vector<inode*>::const_iterator end = Document.nodes().collection().end();
-	for(std::vector<inode*>::const_iterator node = Document.nodes().collection().begin(); node != end; ++node)
-	{
-		if((**node).name() == NodeName)
-			result.push_back(*node);
-	}
-
-	return result;
+	return Document.nodes().find_nodes(NodeName);
 }
 
 const std::vector<inode*> node::lookup(idocument& Document, const string_t& MetaName, const string_t& MetaValue)
@@ -37,6 +37,8 @@
 // The following includes are needed to compare typeinfo of properties in skip_nodes
 #include <k3dsdk/mesh.h>
 
+#include <set>
+
 namespace k3d
 {
 
@@ -101,38 +103,20 @@ void skip_nodes(nodes_t Nodes, ipipeline::dependencies_t& NewDependencies)
 
 inode* find_node(inode_collection& Nodes, iproperty& Property)
 {
-	const nodes_t::const_iterator end = Nodes.collection().end();
-	for(nodes_t::const_iterator node = Nodes.collection().begin(); node != end; ++node)
-	{
-		iproperty_collection* const property_collection = dynamic_cast<iproperty_collection*>(*node);
-		if(!property_collection)
-			continue;
-
-		const iproperty_collection::properties_t& properties = property_collection->properties();
-		if(std::find(properties.begin(), properties.end(), &Property) != properties.end())
-			return *node;
-	}
-
-	return 0;
+	return Nodes.find_node(Property);
 }
 
 const std::string unique_name(inode_collection& Nodes, const std::string& Name)
 {
-	// For each node in the collection ...
-	for(k3d::inode_collection::nodes_t::const_iterator handle = Nodes.collection().begin(); handle != Nodes.collection().end(); ++handle)
-	{
-		inode* const node = *handle;
-
-		// Name doesn't match, so keep going ...
-		if(Name != node->name())
-			continue;
+	std::string name = Name;
 
-		// Got a duplicate name, so recursively try something else ...
-		std::string base(k3d::trim(Name));
+	// While the name matches a node in the collection ...
+	while(!Nodes.find_nodes(name).empty())
+	{
+		// Got a duplicate name, so try something else ...
+		std::string base(k3d::trim(name));
 		unsigned int copy = 1;
 
-		//parse(Name.c_str(), lexeme_d[*(anychar_p - space_p)][assign(base)] >> !(int_p[assign(copy)]), space_p);
-
 		// Find trailing space followed by a number and increment ('k3d 5' -> 'k3d 6', 'k3d3' -> 'k3d3 2')
 		std::string::iterator c = base.end();
 		while(--c != base.begin() && *c >= '0' && *c <= '9')
@@ -149,10 +133,10 @@ const std::string unique_name(inode_collection& Nodes, const std::string& Name)
 			base = std::string(base.begin(), c);
 		}
 
-		return unique_name(Nodes, base + ' ' + k3d::string_cast(copy+1));
+		name = base + ' ' + k3d::string_cast(copy+1);
 	}
 
-	return Name;
+	return name;
 }
 
 void delete_nodes(idocument& Document, const nodes_t& Nodes)
@@ -168,6 +152,7 @@ void delete_nodes(idocument& Document, const nodes_t& Nodes)
 	Document.nodes().remove_nodes(Nodes);
 	
 	// Remove them from node collection sinks
+	const std::set<inode*> deleted_nodes(Nodes.begin(), Nodes.end());
 	const k3d::inode_collection::nodes_t::const_iterator doc_node_end = Document.nodes().collection().end();
 	for(k3d::inode_collection::nodes_t::const_iterator doc_node = Document.nodes().collection().begin(); doc_node != doc_node_end; ++doc_node)
 	{
@@ -179,17 +164,14 @@ void delete_nodes(idocument& Document, const nodes_t& Nodes)
 				if(k3d::inode_collection_property* const node_collection_property = dynamic_cast<k3d::inode_collection_property*>(*property))
 				{
 					k3d::inode_collection_property::nodes_t nodes = k3d::property::internal_value<k3d::inode_collection_property::nodes_t>(**property);
-					for(nodes_t::const_iterator node = Nodes.begin(); node != Nodes.end(); ++node)
+					k3d::inode_collection_property::nodes_t visible_nodes;
+					visible_nodes.reserve(nodes.size());
+					for(k3d::inode_collection_property::nodes_t::const_iterator visible_node = nodes.begin(); visible_node != nodes.end(); ++visible_node)
 					{
-						for (k3d::inode_collection_property::nodes_t::iterator visible_node = nodes.begin(); visible_node != nodes.end(); )
-						{
-							if (*visible_node == *node)
-								visible_node = nodes.erase(visible_node);
-							else
-								++visible_node;
-						}
+						if(!deleted_nodes.count(*visible_node))
+							visible_nodes.push_back(*visible_node);
 					}
-					k3d::property::set_internal_value(**property, nodes);
+					k3d::property::set_internal_value(**property, visible_nodes);
 				}
 			}
 		}
@@ -27,12 +27,26 @@
 #include <k3d-parallel-config.h>
 #include <k3dsdk/types.h>
 
+#ifdef K3D_ENABLE_PARALLEL
+#include <tbb/tbb_stddef.h>
+#endif // K3D_ENABLE_PARALLEL
+
 namespace k3d
 {
 
 namespace parallel
 {
 
+#ifdef K3D_ENABLE_PARALLEL
+/// Tag type used to select the splitting constructors of ranges and bodies
+typedef ::tbb::split split;
+#else // K3D_ENABLE_PARALLEL
+/// Tag type used to select the splitting constructors of ranges and bodies
+class split
+{
+};
+#endif // !K3D_ENABLE_PARALLEL
+
 template<typename ValueT>
 class blocked_range
 {
@@ -54,12 +68,12 @@ public:
 	}
 
 	//! Construct range over half-open interval [begin,end), with the given grainsize.
+	/** A grainsize of zero is treated as one, since ranges could otherwise be split forever. */
 	blocked_range(ValueT Begin, ValueT End, size_type Grainsize = 1) : 
 		m_end(End),
 		m_begin(Begin),
-		m_grainsize(Grainsize) 
+		m_grainsize(Grainsize ? Grainsize : 1) 
 	{
-//		__TBB_ASSERT( m_grainsize>0, "grainsize must be positive" );
 	}
 
 	//! Beginning of range.
@@ -25,6 +25,11 @@
 */
 
 #include <k3d-parallel-config.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/statistics.h>
+#include <k3dsdk/parallel/task_group.h>
+
+#include <thread>
 
 #ifdef K3D_ENABLE_PARALLEL
 #include <tbb/parallel_for.h>
@@ -36,25 +41,109 @@ namespace k3d
 namespace parallel
 {
 
+/// Applies Body to every subrange of Range, concurrently.  Range must model the range concept
+/// (see blocked_range), and Body must provide "void operator()(const RangeT&) const".
 template<typename RangeT, typename BodyT>
 void parallel_for(const RangeT& Range, const BodyT& Body);
 
 #ifdef K3D_ENABLE_PARALLEL
 
+namespace detail
+{
+
+/// Wraps a parallel_for body so its execution is recorded in the parallel statistics
+template<typename BodyT>
+class for_body
+{
+public:
+	for_body(const BodyT& Body) :
+		m_body(Body),
+		m_caller(std::this_thread::get_id())
+	{
+	}
+
+	template<typename RangeT>
+	void operator()(const RangeT& Range) const
+	{
+		task_timer timer(std::this_thread::get_id() != m_caller);
+		m_body(Range);
+	}
+
+private:
+	const BodyT& m_body;
+	const std::thread::id m_caller;
+};
+
+} // namespace detail
+
 template<typename RangeT, typename BodyT>
 void parallel_for(const RangeT& Range, const BodyT& Body)
 {
-	::tbb::parallel_for(Range, Body);
+	detail::record_call();
+	::tbb::parallel_for(Range, detail::for_body<BodyT>(Body));
 }
 
 #else // K3D_ENABLE_PARALLEL
 
+namespace detail
+{
+
+/// Recursively splits a range, scheduling one half while the current thread continues with the other
 template<typename RangeT, typename BodyT>
-void parallel_for(const RangeT& Range, const BodyT& Body)
+void spawn_for(task_group& Group, RangeT Range, const BodyT& Body);
+
+template<typename RangeT, typename BodyT>
+class for_task
+{
+public:
+	for_task(task_group& Group, const RangeT& Range, const BodyT& Body) :
+		m_group(Group),
+		m_range(Range),
+		m_body(Body)
+	{
+	}
+
+	void operator()() const
+	{
+		spawn_for(m_group, m_range, m_body);
+	}
+
+private:
+	task_group& m_group;
+	const RangeT m_range;
+	const BodyT& m_body;
+};
+
+template<typename RangeT, typename BodyT>
+void spawn_for(task_group& Group, RangeT Range, const BodyT& Body)
 {
+	while(Range.is_divisible())
+	{
+		RangeT second(Range, split());
+		Group.run(for_task<RangeT, BodyT>(Group, second, Body));
+	}
+
 	Body(Range);
 }
 
+} // namespace detail
+
+template<typename RangeT, typename BodyT>
+void parallel_for(const RangeT& Range, const BodyT& Body)
+{
+	detail::record_call();
+
+	if(Range.empty())
+		return;
+
+	task_group group;
+	{
+		detail::task_timer timer(false);
+		detail::spawn_for(group, Range, Body);
+	}
+	group.wait();
+}
+
 #endif // !K3D_ENABLE_PARALLEL
 
 } // namespace parallel
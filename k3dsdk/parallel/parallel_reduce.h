@@ -0,0 +1,173 @@
+#ifndef K3DSDK_PARALLEL_PARALLEL_REDUCE_H
+#define K3DSDK_PARALLEL_PARALLEL_REDUCE_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3d-parallel-config.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/statistics.h>
+#include <k3dsdk/parallel/task_group.h>
+
+#include <memory>
+#include <thread>
+
+#ifdef K3D_ENABLE_PARALLEL
+#include <tbb/parallel_reduce.h>
+#endif // K3D_ENABLE_PARALLEL
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+/// Accumulates a result over Range, concurrently.  Body must provide a splitting constructor "BodyT(BodyT&, split)" that creates
+/// a body with an empty result, "void operator()(const RangeT&)" to accumulate a subrange, and "void join(BodyT&)" to merge the
+/// result of a body that was split from it and accumulated the subsequent subrange.  On return, Body contains the final result.
+template<typename RangeT, typename BodyT>
+void parallel_reduce(const RangeT& Range, BodyT& Body);
+
+#ifdef K3D_ENABLE_PARALLEL
+
+namespace detail
+{
+
+/// Wraps a parallel_reduce body so its execution is recorded in the parallel statistics
+template<typename BodyT>
+class reduce_body
+{
+public:
+	reduce_body(BodyT& Body) :
+		m_body(&Body),
+		m_caller(std::this_thread::get_id())
+	{
+	}
+
+	reduce_body(reduce_body& Other, split Split) :
+		m_owned_body(new BodyT(*Other.m_body, Split)),
+		m_body(m_owned_body.get()),
+		m_caller(Other.m_caller)
+	{
+	}
+
+	template<typename RangeT>
+	void operator()(const RangeT& Range)
+	{
+		task_timer timer(std::this_thread::get_id() != m_caller);
+		(*m_body)(Range);
+	}
+
+	void join(reduce_body& Other)
+	{
+		m_body->join(*Other.m_body);
+	}
+
+private:
+	std::unique_ptr<BodyT> m_owned_body;
+	BodyT* const m_body;
+	const std::thread::id m_caller;
+};
+
+} // namespace detail
+
+template<typename RangeT, typename BodyT>
+void parallel_reduce(const RangeT& Range, BodyT& Body)
+{
+	detail::record_call();
+
+	detail::reduce_body<BodyT> body(Body);
+	::tbb::parallel_reduce(Range, body);
+}
+
+#else // K3D_ENABLE_PARALLEL
+
+namespace detail
+{
+
+/// Recursively splits a range and its body, reducing both halves concurrently and joining the results in order
+template<typename RangeT, typename BodyT>
+void spawn_reduce(RangeT Range, BodyT& Body);
+
+template<typename RangeT, typename BodyT>
+class reduce_task
+{
+public:
+	reduce_task(const RangeT& Range, BodyT& Body) :
+		m_range(Range),
+		m_body(Body)
+	{
+	}
+
+	void operator()() const
+	{
+		spawn_reduce(m_range, m_body);
+	}
+
+private:
+	const RangeT m_range;
+	BodyT& m_body;
+};
+
+template<typename RangeT, typename BodyT>
+void spawn_reduce(RangeT Range, BodyT& Body)
+{
+	if(!Range.is_divisible())
+	{
+		Body(Range);
+		return;
+	}
+
+	RangeT second(Range, split());
+	BodyT second_body(Body, split());
+
+	task_group group;
+	group.run(reduce_task<RangeT, BodyT>(second, second_body));
+	spawn_reduce(Range, Body);
+	group.wait();
+
+	Body.join(second_body);
+}
+
+} // namespace detail
+
+template<typename RangeT, typename BodyT>
+void parallel_reduce(const RangeT& Range, BodyT& Body)
+{
+	detail::record_call();
+
+	if(Range.empty())
+		return;
+
+	detail::task_timer timer(false);
+	detail::spawn_reduce(Range, Body);
+}
+
+#endif // !K3D_ENABLE_PARALLEL
+
+} // namespace parallel
+
+} // namespace k3d
+
+#endif // !K3DSDK_PARALLEL_PARALLEL_REDUCE_H
+
@@ -0,0 +1,244 @@
+#ifndef K3DSDK_PARALLEL_PARALLEL_SCAN_H
+#define K3DSDK_PARALLEL_PARALLEL_SCAN_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3d-parallel-config.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/statistics.h>
+#include <k3dsdk/parallel/task_group.h>
+#include <k3dsdk/parallel/threads.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef K3D_ENABLE_PARALLEL
+#include <tbb/parallel_scan.h>
+#endif // K3D_ENABLE_PARALLEL
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+#ifdef K3D_ENABLE_PARALLEL
+/// Tag passed to scan bodies when they only need to accumulate a summary of a subrange
+typedef ::tbb::pre_scan_tag pre_scan_tag;
+/// Tag passed to scan bodies when they must accumulate a subrange and store its prefix results
+typedef ::tbb::final_scan_tag final_scan_tag;
+#else // K3D_ENABLE_PARALLEL
+/// Tag passed to scan bodies when they only need to accumulate a summary of a subrange
+class pre_scan_tag
+{
+public:
+	static bool_t is_final_scan() { return false; }
+};
+
+/// Tag passed to scan bodies when they must accumulate a subrange and store its prefix results
+class final_scan_tag
+{
+public:
+	static bool_t is_final_scan() { return true; }
+};
+#endif // !K3D_ENABLE_PARALLEL
+
+/// Computes a parallel prefix (for example, a running sum) over Range.  Body must provide a splitting constructor "BodyT(BodyT&, split)"
+/// that creates a body with an empty summary, "template<typename TagT> void operator()(const RangeT&, TagT)" that accumulates a subrange
+/// and stores results only if TagT::is_final_scan(), "void reverse_join(BodyT&)" that merges the summary of the preceding subrange into
+/// this one, and "void assign(BodyT&)" that copies a summary.  On return, Body contains the summary of the entire range.
+template<typename RangeT, typename BodyT>
+void parallel_scan(const RangeT& Range, BodyT& Body);
+
+#ifdef K3D_ENABLE_PARALLEL
+
+namespace detail
+{
+
+/// Wraps a parallel_scan body so its execution is recorded in the parallel statistics
+template<typename BodyT>
+class scan_body
+{
+public:
+	scan_body(BodyT& Body) :
+		m_body(&Body),
+		m_caller(std::this_thread::get_id())
+	{
+	}
+
+	scan_body(scan_body& Other, split Split) :
+		m_owned_body(new BodyT(*Other.m_body, Split)),
+		m_body(m_owned_body.get()),
+		m_caller(Other.m_caller)
+	{
+	}
+
+	template<typename RangeT, typename TagT>
+	void operator()(const RangeT& Range, TagT Tag)
+	{
+		task_timer timer(std::this_thread::get_id() != m_caller);
+		(*m_body)(Range, Tag);
+	}
+
+	void reverse_join(scan_body& Other)
+	{
+		m_body->reverse_join(*Other.m_body);
+	}
+
+	void assign(scan_body& Other)
+	{
+		m_body->assign(*Other.m_body);
+	}
+
+private:
+	std::unique_ptr<BodyT> m_owned_body;
+	BodyT* const m_body;
+	const std::thread::id m_caller;
+};
+
+} // namespace detail
+
+template<typename RangeT, typename BodyT>
+void parallel_scan(const RangeT& Range, BodyT& Body)
+{
+	detail::record_call();
+
+	detail::scan_body<BodyT> body(Body);
+	::tbb::parallel_scan(Range, body);
+}
+
+#else // K3D_ENABLE_PARALLEL
+
+namespace detail
+{
+
+/// Scans a single chunk of a range
+template<typename RangeT, typename BodyT, typename TagT>
+class scan_task
+{
+public:
+	scan_task(const RangeT& Range, BodyT& Body) :
+		m_range(Range),
+		m_body(Body)
+	{
+	}
+
+	void operator()() const
+	{
+		m_body(m_range, TagT());
+	}
+
+private:
+	const RangeT m_range;
+	BodyT& m_body;
+};
+
+} // namespace detail
+
+template<typename RangeT, typename BodyT>
+void parallel_scan(const RangeT& Range, BodyT& Body)
+{
+	detail::record_call();
+
+	if(Range.empty())
+		return;
+
+	// Split the range into a few ordered chunks per thread ...
+	const uint_t target_chunks = 4 * thread_count();
+	std::vector<RangeT> chunks(1, Range);
+	for(bool_t divisible = true; divisible && chunks.size() < target_chunks; )
+	{
+		divisible = false;
+		std::vector<RangeT> next_chunks;
+		for(uint_t i = 0; i != chunks.size(); ++i)
+		{
+			RangeT first(chunks[i]);
+			if(!first.is_divisible())
+			{
+				next_chunks.push_back(first);
+				continue;
+			}
+
+			RangeT second(first, split());
+			next_chunks.push_back(first);
+			next_chunks.push_back(second);
+			divisible = true;
+		}
+		chunks.swap(next_chunks);
+	}
+
+	const uint_t chunk_count = chunks.size();
+	if(chunk_count == 1)
+	{
+		detail::task_timer timer(false);
+		Body(Range, final_scan_tag());
+		return;
+	}
+
+	// Bodies for each chunk are split from the original before any work begins ...
+	std::vector<std::unique_ptr<BodyT> > pre_scan_bodies(chunk_count);
+	std::vector<std::unique_ptr<BodyT> > final_scan_bodies(chunk_count);
+	for(uint_t i = 1; i != chunk_count; ++i)
+	{
+		if(i + 1 != chunk_count)
+			pre_scan_bodies[i].reset(new BodyT(Body, split()));
+		final_scan_bodies[i].reset(new BodyT(Body, split()));
+	}
+
+	// The first chunk is scanned in final form, while the others (except the last) compute their summaries ...
+	task_group group;
+	group.run(detail::scan_task<RangeT, BodyT, final_scan_tag>(chunks[0], Body));
+	for(uint_t i = 1; i + 1 < chunk_count; ++i)
+		group.run(detail::scan_task<RangeT, BodyT, pre_scan_tag>(chunks[i], *pre_scan_bodies[i]));
+	group.wait();
+
+	// Propagate the prefix summaries serially ...
+	BodyT* prefix = &Body;
+	for(uint_t i = 1; i != chunk_count; ++i)
+	{
+		final_scan_bodies[i]->reverse_join(*prefix);
+		if(pre_scan_bodies[i])
+		{
+			pre_scan_bodies[i]->reverse_join(*prefix);
+			prefix = pre_scan_bodies[i].get();
+		}
+	}
+
+	// Complete the remaining chunks in final form ...
+	for(uint_t i = 1; i != chunk_count; ++i)
+		group.run(detail::scan_task<RangeT, BodyT, final_scan_tag>(chunks[i], *final_scan_bodies[i]));
+	group.wait();
+
+	Body.assign(*final_scan_bodies[chunk_count - 1]);
+}
+
+#endif // !K3D_ENABLE_PARALLEL
+
+} // namespace parallel
+
+} // namespace k3d
+
+#endif // !K3DSDK_PARALLEL_PARALLEL_SCAN_H
+
@@ -0,0 +1,170 @@
+#ifndef K3DSDK_PARALLEL_PARALLEL_SORT_H
+#define K3DSDK_PARALLEL_PARALLEL_SORT_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3d-parallel-config.h>
+#include <k3dsdk/parallel/statistics.h>
+#include <k3dsdk/parallel/task_group.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+#ifdef K3D_ENABLE_PARALLEL
+#include <tbb/parallel_sort.h>
+#endif // K3D_ENABLE_PARALLEL
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+#ifdef K3D_ENABLE_PARALLEL
+
+/// Sorts the sequence [Begin, End) using the given comparison, concurrently.  Like std::sort(), the sort is not stable.
+template<typename IteratorT, typename CompareT>
+void parallel_sort(IteratorT Begin, IteratorT End, const CompareT& Compare)
+{
+	detail::record_call();
+	::tbb::parallel_sort(Begin, End, Compare);
+}
+
+#else // K3D_ENABLE_PARALLEL
+
+namespace detail
+{
+
+/// Sequences shorter than this are sorted serially
+const long parallel_sort_cutoff = 500;
+
+template<typename IteratorT, typename CompareT>
+void spawn_sort(task_group& Group, IteratorT Begin, IteratorT End, const CompareT& Compare);
+
+template<typename IteratorT, typename CompareT>
+class sort_task
+{
+public:
+	sort_task(task_group& Group, IteratorT Begin, IteratorT End, const CompareT& Compare) :
+		m_group(Group),
+		m_begin(Begin),
+		m_end(End),
+		m_compare(Compare)
+	{
+	}
+
+	void operator()() const
+	{
+		spawn_sort(m_group, m_begin, m_end, m_compare);
+	}
+
+private:
+	task_group& m_group;
+	const IteratorT m_begin;
+	const IteratorT m_end;
+	const CompareT& m_compare;
+};
+
+/// Compares values to a pivot
+template<typename ValueT, typename CompareT>
+class pivot_compare
+{
+public:
+	pivot_compare(const ValueT& Pivot, const CompareT& Compare, const bool_t Less) :
+		m_pivot(Pivot),
+		m_compare(Compare),
+		m_less(Less)
+	{
+	}
+
+	bool_t operator()(const ValueT& Value) const
+	{
+		return m_less ? m_compare(Value, m_pivot) : !m_compare(m_pivot, Value);
+	}
+
+private:
+	const ValueT& m_pivot;
+	const CompareT& m_compare;
+	const bool_t m_less;
+};
+
+/// Partitions a sequence into values less than, equal to, and greater than a median-of-three pivot, scheduling
+/// the greater values as a separate task while the current thread continues with the lesser values
+template<typename IteratorT, typename CompareT>
+void spawn_sort(task_group& Group, IteratorT Begin, IteratorT End, const CompareT& Compare)
+{
+	typedef typename std::iterator_traits<IteratorT>::value_type value_t;
+
+	while(End - Begin > parallel_sort_cutoff)
+	{
+		const value_t& a = *Begin;
+		const value_t& b = *(Begin + (End - Begin) / 2);
+		const value_t& c = *(End - 1);
+
+		const value_t pivot = Compare(a, b) ?
+			(Compare(b, c) ? b : Compare(a, c) ? c : a) :
+			(Compare(a, c) ? a : Compare(b, c) ? c : b);
+
+		const IteratorT equal_begin = std::partition(Begin, End, pivot_compare<value_t, CompareT>(pivot, Compare, true));
+		const IteratorT equal_end = std::partition(equal_begin, End, pivot_compare<value_t, CompareT>(pivot, Compare, false));
+
+		Group.run(sort_task<IteratorT, CompareT>(Group, equal_end, End, Compare));
+		End = equal_begin;
+	}
+
+	std::sort(Begin, End, Compare);
+}
+
+} // namespace detail
+
+/// Sorts the sequence [Begin, End) using the given comparison, concurrently.  Like std::sort(), the sort is not stable.
+template<typename IteratorT, typename CompareT>
+void parallel_sort(IteratorT Begin, IteratorT End, const CompareT& Compare)
+{
+	detail::record_call();
+
+	task_group group;
+	{
+		detail::task_timer timer(false);
+		detail::spawn_sort(group, Begin, End, Compare);
+	}
+	group.wait();
+}
+
+#endif // !K3D_ENABLE_PARALLEL
+
+/// Sorts the sequence [Begin, End) in ascending order, concurrently.  Like std::sort(), the sort is not stable.
+template<typename IteratorT>
+void parallel_sort(IteratorT Begin, IteratorT End)
+{
+	parallel_sort(Begin, End, std::less<typename std::iterator_traits<IteratorT>::value_type>());
+}
+
+} // namespace parallel
+
+} // namespace k3d
+
+#endif // !K3DSDK_PARALLEL_PARALLEL_SORT_H
+
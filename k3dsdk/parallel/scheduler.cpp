@@ -0,0 +1,243 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <k3dsdk/parallel/scheduler.h>
+#include <k3dsdk/parallel/threads.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+namespace detail
+{
+
+/// Stores the index of the queue owned by the current thread, or zero for threads that aren't workers
+static thread_local uint_t t_queue = 0;
+
+/////////////////////////////////////////////////////////////////////////////
+// scheduler::implementation
+
+class scheduler::implementation
+{
+public:
+	implementation() :
+		pending(0),
+		stopping(false)
+	{
+		queues.push_back(new queue());
+	}
+
+	~implementation()
+	{
+		stop_workers();
+
+		for(std::deque<task*>::iterator t = queues[0]->tasks.begin(); t != queues[0]->tasks.end(); ++t)
+			delete *t;
+		delete queues[0];
+	}
+
+	/// A queue of tasks that is shared between its owner and thieves
+	struct queue
+	{
+		std::mutex mutex;
+		std::deque<task*> tasks;
+	};
+
+	void start_workers(const uint_t ThreadCount)
+	{
+		for(uint_t i = 1; i < ThreadCount; ++i)
+			queues.push_back(new queue());
+
+		for(uint_t i = 1; i < ThreadCount; ++i)
+			workers.push_back(std::thread(&implementation::worker, this, i));
+	}
+
+	void stop_workers()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for(uint_t i = 0; i != workers.size(); ++i)
+			workers[i].join();
+		workers.clear();
+
+		// Workers drain the queues before they stop, but hand-off anything that arrived late ...
+		for(uint_t i = 1; i < queues.size(); ++i)
+		{
+			queues[0]->tasks.insert(queues[0]->tasks.end(), queues[i]->tasks.begin(), queues[i]->tasks.end());
+			delete queues[i];
+		}
+		queues.resize(1);
+
+		stopping = false;
+	}
+
+	void worker(const uint_t Queue)
+	{
+		t_queue = Queue;
+
+		while(true)
+		{
+			if(execute_one())
+				continue;
+
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+			if(stopping && pending.load() == 0)
+				break;
+			wake.wait(lock, [this]() { return stopping || pending.load() != 0; });
+		}
+	}
+
+	void spawn(task* const Task)
+	{
+		queue& owner = *queues[t_queue < queues.size() ? t_queue : 0];
+		{
+			std::lock_guard<std::mutex> lock(owner.mutex);
+			owner.tasks.push_back(Task);
+		}
+		++pending;
+
+		// Synchronize with sleeping workers so the notification can't be lost between their test and their wait ...
+		{
+			std::lock_guard<std::mutex> lock(sleep_mutex);
+		}
+		wake.notify_one();
+	}
+
+	bool_t execute_one()
+	{
+		const uint_t queue_count = queues.size();
+		const uint_t self = t_queue < queue_count ? t_queue : 0;
+
+		task* current = 0;
+		bool_t stolen = false;
+
+		// Take the newest task from our own queue, while its data is likely to be in-cache ...
+		{
+			queue& owner = *queues[self];
+			std::lock_guard<std::mutex> lock(owner.mutex);
+			if(!owner.tasks.empty())
+			{
+				current = owner.tasks.back();
+				owner.tasks.pop_back();
+			}
+		}
+
+		// Otherwise, steal the oldest (and typically largest) task from another queue ...
+		for(uint_t i = 1; !current && i < queue_count; ++i)
+		{
+			queue& victim = *queues[(self + i) % queue_count];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if(!victim.tasks.empty())
+			{
+				current = victim.tasks.front();
+				victim.tasks.pop_front();
+				stolen = true;
+			}
+		}
+
+		if(!current)
+			return false;
+
+		--pending;
+
+		std::unique_ptr<task> owned_task(current);
+		owned_task->execute(stolen);
+
+		return true;
+	}
+
+	/// Stores one queue for threads that aren't workers, followed by one queue for each worker
+	std::vector<queue*> queues;
+	std::vector<std::thread> workers;
+	/// Stores the number of queued tasks
+	std::atomic<uint_t> pending;
+	/// Set to true while worker threads are being shut down
+	std::atomic<bool> stopping;
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	/// Serializes changes to the thread count
+	std::mutex configuration_mutex;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// scheduler
+
+scheduler& scheduler::instance()
+{
+	static scheduler result;
+	return result;
+}
+
+scheduler::scheduler() :
+	m_implementation(new implementation())
+{
+	set_thread_count(automatic);
+}
+
+scheduler::~scheduler()
+{
+	delete m_implementation;
+}
+
+void scheduler::set_thread_count(const int32_t Count)
+{
+	uint_t thread_count = Count == automatic ? std::thread::hardware_concurrency() : Count;
+	if(thread_count < 1)
+		thread_count = 1;
+
+	std::lock_guard<std::mutex> lock(m_implementation->configuration_mutex);
+	m_implementation->stop_workers();
+	m_implementation->start_workers(thread_count);
+}
+
+uint_t scheduler::thread_count()
+{
+	return m_implementation->workers.size() + 1;
+}
+
+void scheduler::spawn(task* const Task)
+{
+	m_implementation->spawn(Task);
+}
+
+bool_t scheduler::execute_one()
+{
+	return m_implementation->execute_one();
+}
+
+} // namespace detail
+
+} // namespace parallel
+
+} // namespace k3d
+
@@ -0,0 +1,83 @@
+#ifndef K3DSDK_PARALLEL_SCHEDULER_H
+#define K3DSDK_PARALLEL_SCHEDULER_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+namespace detail
+{
+
+/// Abstract interface for a unit of work executed by the portable scheduler
+class task
+{
+public:
+	virtual ~task() {}
+
+	/// Called exactly once to perform the work.  Stolen is true if the task is executed by a thread other than the one that spawned it.
+	virtual void execute(const bool_t Stolen) = 0;
+};
+
+/// Portable work-stealing scheduler used when K-3D is built without Threading Building Blocks.  Every worker thread
+/// owns a queue of tasks; workers execute their own tasks in last-in, first-out order and steal the oldest tasks from
+/// other queues when they run out of work.  Threads that are not workers (such as the user interface thread) share a
+/// single queue, and participate in execution while they wait for their tasks to complete.
+class scheduler
+{
+public:
+	/// Returns the process-wide scheduler, creating worker threads as-needed
+	static scheduler& instance();
+
+	/// Sets the total number of threads used for parallel operations, including the calling thread.  Must not be called while parallel operations are running.
+	void set_thread_count(const int32_t Count);
+	/// Returns the total number of threads used for parallel operations, including the calling thread
+	uint_t thread_count();
+
+	/// Queues a task for execution, taking ownership of it
+	void spawn(task* const Task);
+	/// Executes a single queued task if one is available, returning false if no work was found
+	bool_t execute_one();
+
+private:
+	scheduler();
+	~scheduler();
+
+	class implementation;
+	implementation* const m_implementation;
+};
+
+} // namespace detail
+
+} // namespace parallel
+
+} // namespace k3d
+
+#endif // !K3DSDK_PARALLEL_SCHEDULER_H
+
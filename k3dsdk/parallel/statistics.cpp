@@ -0,0 +1,129 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include <k3dsdk/parallel/statistics.h>
+
+#include <algorithm>
+#include <atomic>
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+namespace detail
+{
+
+static std::atomic<uint64_t> g_calls(0);
+static std::atomic<uint64_t> g_tasks(0);
+static std::atomic<uint64_t> g_steals(0);
+/// Busy time is accumulated in nanoseconds, since there are no portable atomic floating-point operations
+static std::atomic<uint64_t> g_busy_time(0);
+
+void record_call()
+{
+	g_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Accumulates the time spent in nested tasks by the task that is currently executing on this thread
+static thread_local double_t t_nested_time = 0;
+
+/////////////////////////////////////////////////////////////////////////////
+// task_timer
+
+task_timer::task_timer(const bool_t Stolen) :
+	m_stolen(Stolen),
+	m_outer_nested_time(t_nested_time),
+	m_start(std::chrono::steady_clock::now())
+{
+	t_nested_time = 0;
+}
+
+task_timer::~task_timer()
+{
+	const double_t elapsed = std::chrono::duration<double_t>(std::chrono::steady_clock::now() - m_start).count();
+	const double_t busy_time = std::max(0.0, elapsed - t_nested_time);
+	t_nested_time = m_outer_nested_time + elapsed;
+
+	g_tasks.fetch_add(1, std::memory_order_relaxed);
+	if(m_stolen)
+		g_steals.fetch_add(1, std::memory_order_relaxed);
+	g_busy_time.fetch_add(static_cast<uint64_t>(busy_time * 1e9), std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// statistics
+
+statistics::statistics() :
+	calls(0),
+	tasks(0),
+	steals(0),
+	busy_time(0)
+{
+}
+
+statistics& statistics::operator+=(const statistics& RHS)
+{
+	calls += RHS.calls;
+	tasks += RHS.tasks;
+	steals += RHS.steals;
+	busy_time += RHS.busy_time;
+	return *this;
+}
+
+statistics& statistics::operator-=(const statistics& RHS)
+{
+	calls -= RHS.calls;
+	tasks -= RHS.tasks;
+	steals -= RHS.steals;
+	busy_time -= RHS.busy_time;
+	return *this;
+}
+
+const statistics operator+(const statistics& LHS, const statistics& RHS)
+{
+	statistics result(LHS);
+	result += RHS;
+	return result;
+}
+
+const statistics operator-(const statistics& LHS, const statistics& RHS)
+{
+	statistics result(LHS);
+	result -= RHS;
+	return result;
+}
+
+const statistics get_statistics()
+{
+	statistics result;
+	result.calls = detail::g_calls.load(std::memory_order_relaxed);
+	result.tasks = detail::g_tasks.load(std::memory_order_relaxed);
+	result.steals = detail::g_steals.load(std::memory_order_relaxed);
+	result.busy_time = static_cast<double_t>(detail::g_busy_time.load(std::memory_order_relaxed)) * 1e-9;
+	return result;
+}
+
+} // namespace parallel
+
+} // namespace k3d
+
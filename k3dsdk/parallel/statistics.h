@@ -0,0 +1,93 @@
+#ifndef K3DSDK_PARALLEL_STATISTICS_H
+#define K3DSDK_PARALLEL_STATISTICS_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+#include <chrono>
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+/// Summarizes the work performed by parallel algorithms and task groups
+class statistics
+{
+public:
+	statistics();
+
+	/// Stores the number of calls to parallel algorithms
+	uint64_t calls;
+	/// Stores the number of tasks (body invocations) executed
+	uint64_t tasks;
+	/// Stores the number of tasks executed by a thread other than the one that created them
+	uint64_t steals;
+	/// Stores the total time in seconds that threads spent executing tasks, summed across threads
+	double_t busy_time;
+
+	statistics& operator+=(const statistics& RHS);
+	statistics& operator-=(const statistics& RHS);
+};
+
+const statistics operator+(const statistics& LHS, const statistics& RHS);
+const statistics operator-(const statistics& LHS, const statistics& RHS);
+
+/// Returns the totals for every parallel operation performed by this process.  Totals only increase,
+/// so callers measure an operation by taking the difference between totals before and after it.
+const statistics get_statistics();
+
+namespace detail
+{
+
+/// Records a call to a parallel algorithm
+void record_call();
+
+/// RAII helper that records the execution of a single task.  Time spent in nested tasks that are executed
+/// by the same thread (for example, while waiting for a task group) is excluded, so busy time is never counted twice.
+class task_timer
+{
+public:
+	task_timer(const bool_t Stolen);
+	~task_timer();
+
+private:
+	task_timer(const task_timer&);
+	task_timer& operator=(const task_timer&);
+
+	const bool_t m_stolen;
+	const double_t m_outer_nested_time;
+	const std::chrono::steady_clock::time_point m_start;
+};
+
+} // namespace detail
+
+} // namespace parallel
+
+} // namespace k3d
+
+#endif // !K3DSDK_PARALLEL_STATISTICS_H
+
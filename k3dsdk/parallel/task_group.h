@@ -0,0 +1,202 @@
+#ifndef K3DSDK_PARALLEL_TASK_GROUP_H
+#define K3DSDK_PARALLEL_TASK_GROUP_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3d-parallel-config.h>
+#include <k3dsdk/parallel/statistics.h>
+
+#include <thread>
+
+#ifdef K3D_ENABLE_PARALLEL
+#include <tbb/task_group.h>
+#else // K3D_ENABLE_PARALLEL
+#include <k3dsdk/parallel/scheduler.h>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#endif // !K3D_ENABLE_PARALLEL
+
+namespace k3d
+{
+
+namespace parallel
+{
+
+#ifdef K3D_ENABLE_PARALLEL
+
+namespace detail
+{
+
+/// Wraps a functor so its execution is recorded in the parallel statistics
+template<typename FunctorT>
+class timed_functor
+{
+public:
+	timed_functor(const FunctorT& Functor) :
+		m_functor(Functor),
+		m_spawner(std::this_thread::get_id())
+	{
+	}
+
+	void operator()() const
+	{
+		task_timer timer(std::this_thread::get_id() != m_spawner);
+		m_functor();
+	}
+
+private:
+	FunctorT m_functor;
+	const std::thread::id m_spawner;
+};
+
+} // namespace detail
+
+/// Runs a collection of functors concurrently, and waits for them to complete
+class task_group
+{
+public:
+	~task_group()
+	{
+		m_group.wait();
+	}
+
+	/// Schedules a copy of the given functor for execution
+	template<typename FunctorT>
+	void run(const FunctorT& Functor)
+	{
+		m_group.run(detail::timed_functor<FunctorT>(Functor));
+	}
+
+	/// Waits for every scheduled functor to complete.  If a functor throws an exception, it is rethrown here.
+	void wait()
+	{
+		m_group.wait();
+	}
+
+private:
+	::tbb::task_group m_group;
+};
+
+#else // K3D_ENABLE_PARALLEL
+
+/// Runs a collection of functors concurrently, and waits for them to complete
+class task_group
+{
+public:
+	task_group() :
+		m_pending(0)
+	{
+	}
+
+	~task_group()
+	{
+		try
+		{
+			wait();
+		}
+		catch(...)
+		{
+		}
+	}
+
+	/// Schedules a copy of the given functor for execution
+	template<typename FunctorT>
+	void run(const FunctorT& Functor)
+	{
+		++m_pending;
+		detail::scheduler::instance().spawn(new functor_task<FunctorT>(*this, Functor));
+	}
+
+	/// Waits for every scheduled functor to complete, executing queued tasks while it waits.  If a functor throws an exception, it is rethrown here.
+	void wait()
+	{
+		while(m_pending.load() != 0)
+		{
+			if(!detail::scheduler::instance().execute_one())
+				std::this_thread::yield();
+		}
+
+		if(m_exception)
+		{
+			std::exception_ptr exception = m_exception;
+			m_exception = std::exception_ptr();
+			std::rethrow_exception(exception);
+		}
+	}
+
+private:
+	task_group(const task_group&);
+	task_group& operator=(const task_group&);
+
+	template<typename FunctorT>
+	class functor_task :
+		public detail::task
+	{
+	public:
+		functor_task(task_group& Group, const FunctorT& Functor) :
+			m_group(Group),
+			m_functor(Functor)
+		{
+		}
+
+		void execute(const bool_t Stolen)
+		{
+			try
+			{
+				detail::task_timer timer(Stolen);
+				m_functor();
+			}
+			catch(...)
+			{
+				std::lock_guard<std::mutex> lock(m_group.m_exception_mutex);
+				if(!m_group.m_exception)
+					m_group.m_exception = std::current_exception();
+			}
+
+			// Note: the group may be destroyed as soon as this completes, so it must be the last thing we do ...
+			--m_group.m_pending;
+		}
+
+	private:
+		task_group& m_group;
+		FunctorT m_functor;
+	};
+
+	/// Stores the number of functors that haven't completed
+	std::atomic<uint_t> m_pending;
+	/// Stores the first exception thrown by a functor
+	std::exception_ptr m_exception;
+	std::mutex m_exception_mutex;
+};
+
+#endif // !K3D_ENABLE_PARALLEL
+
+} // namespace parallel
+
+} // namespace k3d
+
+#endif // !K3DSDK_PARALLEL_TASK_GROUP_H
+
@@ -22,7 +22,9 @@
 
 #ifdef K3D_ENABLE_PARALLEL
 #include <tbb/task_scheduler_init.h>
-#endif // K3D_ENABLE_PARALLEL
+#else // K3D_ENABLE_PARALLEL
+#include <k3dsdk/parallel/scheduler.h>
+#endif // !K3D_ENABLE_PARALLEL
 
 namespace k3d
 {
@@ -34,6 +36,8 @@ static uint_t g_grain_size = 10000;
 
 #ifdef K3D_ENABLE_PARALLEL
 
+static int32_t g_thread_count = automatic;
+
 void set_thread_count(const int32_t Count)
 {
 	static ::tbb::task_scheduler_init scheduler(::tbb::task_scheduler_init::automatic);
@@ -43,12 +47,25 @@ void set_thread_count(const int32_t Count)
 		scheduler.initialize(::tbb::task_scheduler_init::automatic);
 	else
 		scheduler.initialize(Count);
+
+	g_thread_count = Count;
+}
+
+uint_t thread_count()
+{
+	return g_thread_count == automatic ? ::tbb::task_scheduler_init::default_num_threads() : g_thread_count;
 }
 
 #else // K3D_ENABLE_PARALLEL
 
-void set_thread_count(const int32_t)
+void set_thread_count(const int32_t Count)
+{
+	detail::scheduler::instance().set_thread_count(Count);
+}
+
+uint_t thread_count()
 {
+	return detail::scheduler::instance().thread_count();
 }
 
 #endif // !K3D_ENABLE_PARALLEL
@@ -40,6 +40,8 @@ enum
 
 /// Set the number of threads to be used for parallel operations
 void set_thread_count(const int32_t Count);
+/// Get the number of threads used for parallel operations
+uint_t thread_count();
 /// Set the preferred grainsize to be used for parallel operations
 void set_grain_size(const uint_t GrainSize);
 /// Get the preferred grainsize to be used for parallel operations
@@ -22,24 +22,130 @@
 */
 
 #include <k3dsdk/high_res_timer.h>
+#include <k3dsdk/inode.h>
 #include <k3dsdk/log.h>
 #include <k3dsdk/pipeline_profiler.h>
+#include <k3dsdk/pipeline_trace.h>
 
+#include <atomic>
 #include <iomanip>
-#include <stack>
+#include <mutex>
+#include <vector>
 
 namespace k3d
 {
 
+namespace detail
+{
+
+/// Stores the state of a task that is executing
+struct profiler_task
+{
+	profiler_task(const double Adjustment) :
+		adjustment(Adjustment),
+		parallel_start(parallel::get_statistics()),
+		traced(pipeline_trace::recording()),
+		trace_start(0),
+		trace_allocated_bytes(0)
+	{
+		if(traced)
+		{
+			trace_hints = pipeline_trace::current_hints();
+			trace_allocated_bytes = pipeline_trace::allocated_bytes();
+			trace_start = pipeline_trace::now();
+		}
+	}
+
+	timer execution_timer;
+	double adjustment;
+	/// Stores the parallel statistics totals when the task started
+	parallel::statistics parallel_start;
+	/// Stores the parallel work performed by nested tasks, which is excluded from their parents
+	parallel::statistics parallel_adjustment;
+	/// Set to true iff the task is being recorded by the pipeline trace
+	bool_t traced;
+	double_t trace_start;
+	uint64_t trace_allocated_bytes;
+	string_t trace_hints;
+};
+
+/// Stores the tasks executing on a thread, innermost last.  Tasks only nest within a thread, so no locking is needed
+static thread_local std::vector<profiler_task> t_tasks;
+
+} // namespace detail
+
 /////////////////////////////////////////////////////////////////////
 // pipeline_profiler::implementation
 
 class pipeline_profiler::implementation
 {
 public:
+	implementation() :
+		observed(false)
+	{
+	}
+
+	void start_execution(const double Adjustment)
+	{
+		detail::t_tasks.push_back(detail::profiler_task(Adjustment));
+	}
+
+	void finish_execution(inode& Node, const string_t& Task)
+	{
+		std::vector<detail::profiler_task>& tasks = detail::t_tasks;
+		return_if_fail(tasks.size());
+
+		const detail::profiler_task& current = tasks.back();
+		const double elapsed = current.execution_timer.elapsed();
+		const double adjustment = current.adjustment;
+
+		const bool_t traced = current.traced;
+		pipeline_trace::span span;
+		if(traced)
+		{
+			span.hints = current.trace_hints;
+			span.start = current.trace_start;
+			span.finish = pipeline_trace::now();
+			span.allocated_bytes = pipeline_trace::allocated_bytes() - current.trace_allocated_bytes;
+		}
+
+		// Measure parallel work performed by this task (but not its nested tasks) ...
+		const parallel::statistics parallel_elapsed = parallel::get_statistics() - current.parallel_start;
+		const parallel::statistics parallel_work = parallel_elapsed - current.parallel_adjustment;
+
+		// Observers may start tasks of their own, so finish with the stack before calling them ...
+		tasks.pop_back();
+		if(tasks.size())
+		{
+			tasks.back().adjustment += elapsed;
+			tasks.back().parallel_adjustment += parallel_elapsed;
+		}
+
+		if(traced)
+		{
+			span.node = Node.name();
+			span.task = Task;
+			span.thread = pipeline_trace::thread();
+			pipeline_trace::record(span);
+		}
+
+		// Most documents are never observed, so they skip the signal lock altogether ...
+		if(!observed.load(std::memory_order_acquire))
+			return;
+
+		std::lock_guard<std::recursive_mutex> lock(signal_mutex);
+		node_execution_signal.emit(Node, Task, elapsed - adjustment);
+		if(parallel_work.calls)
+			node_parallel_signal.emit(Node, Task, parallel_work);
+	}
+
 	sigc::signal<void, inode&, const string_t&, double> node_execution_signal;
-	std::stack<timer> timers;
-	std::stack<double> adjustments;
+	sigc::signal<void, inode&, const string_t&, const parallel::statistics&> node_parallel_signal;
+
+	/// Serializes signal connections and emissions, so observers needn't be thread-safe.  Recursive, so observers can profile too.
+	std::recursive_mutex signal_mutex;
+	/// Set to true once an observer has connected, after which emissions take the signal lock
+	std::atomic<bool_t> observed;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -57,8 +163,7 @@ pipeline_profiler::~pipeline_profiler()
 
 void pipeline_profiler::start_execution(inode& Node, const string_t& Task)
 {
-	m_implementation->timers.push(timer());
-	m_implementation->adjustments.push(0.0);
+	m_implementation->start_execution(0.0);
 }
 
 /**
@@ -67,23 +172,12 @@ void pipeline_profiler::start_execution(inode& Node, const string_t& Task)
  */
 void pipeline_profiler::start_execution(inode& Node, const string_t& Task, const double Adjustment)
 {
-	m_implementation->timers.push(timer());
-	m_implementation->adjustments.push(Adjustment);
+	m_implementation->start_execution(Adjustment);
 }
 
 void pipeline_profiler::finish_execution(inode& Node, const string_t& Task)
 {
-	return_if_fail(m_implementation->timers.size());
-
-	const double elapsed = m_implementation->timers.top().elapsed();
-	const double adjustment = m_implementation->adjustments.top();
-	m_implementation->node_execution_signal.emit(Node, Task, elapsed - adjustment);
-
-	m_implementation->timers.pop();
-	m_implementation->adjustments.pop();
-
-	if(m_implementation->adjustments.size())
-		m_implementation->adjustments.top() += elapsed;
+	m_implementation->finish_execution(Node, Task);
 }
 
 /**
@@ -91,13 +185,23 @@ void pipeline_profiler::finish_execution(inode& Node, const string_t& Task)
  */
 void pipeline_profiler::add_timing_entry(inode& Node, const string_t& Task, const double TimingValue)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_implementation->signal_mutex);
 	m_implementation->node_execution_signal.emit(Node, Task, TimingValue);
 }
 
 sigc::connection pipeline_profiler::connect_node_execution_signal(const sigc::slot<void, inode&, const string_t&, double>& Slot)
 {
+	std::lock_guard<std::recursive_mutex> lock(m_implementation->signal_mutex);
+	m_implementation->observed.store(true, std::memory_order_release);
 	return m_implementation->node_execution_signal.connect(Slot);
 }
 
+sigc::connection pipeline_profiler::connect_node_parallel_signal(const sigc::slot<void, inode&, const string_t&, const parallel::statistics&>& Slot)
+{
+	std::lock_guard<std::recursive_mutex> lock(m_implementation->signal_mutex);
+	m_implementation->observed.store(true, std::memory_order_release);
+	return m_implementation->node_parallel_signal.connect(Slot);
+}
+
 } // namespace k3d
 
@@ -43,6 +43,7 @@ public:
 	void add_timing_entry(inode& Node, const string_t& Task, const double TimingValue);
 	
 	sigc::connection connect_node_execution_signal(const sigc::slot<void, inode&, const string_t&, double>& Slot);
+	sigc::connection connect_node_parallel_signal(const sigc::slot<void, inode&, const string_t&, const parallel::statistics&>& Slot);
 
 private:
 	class implementation;
@@ -0,0 +1,319 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/hints.h>
+#include <k3dsdk/pipeline_trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <locale>
+#include <mutex>
+#include <sstream>
+
+namespace k3d
+{
+
+namespace pipeline_trace
+{
+
+namespace detail
+{
+
+/// Stores the spans recorded by a single thread
+class thread_buffer
+{
+public:
+	thread_buffer(const uint_t Thread) :
+		thread(Thread)
+	{
+	}
+
+	const uint_t thread;
+	/// Serializes access to the spans, which is only contended while they're being cleared or exported
+	std::mutex mutex;
+	std::vector<span> spans;
+};
+
+static std::atomic<bool_t> g_recording(false);
+/// Stores the time at which recording started, in nanoseconds
+static std::atomic<int64_t> g_start_time(0);
+
+static std::mutex g_buffers_mutex;
+/// Stores a buffer for every thread that has recorded spans.  Buffers are never freed, since threads can record spans until the process exits.
+static std::vector<thread_buffer*> g_buffers;
+
+static thread_local thread_buffer* t_buffer = 0;
+static thread_local uint64_t t_allocated_bytes = 0;
+/// Stores the hints that are current for this thread, innermost last
+static thread_local std::vector<const std::vector<ihint*>*> t_hints;
+
+const int64_t clock_time()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+thread_buffer& buffer()
+{
+	if(!t_buffer)
+	{
+		std::lock_guard<std::mutex> lock(g_buffers_mutex);
+		t_buffer = new thread_buffer(g_buffers.size() + 1);
+		g_buffers.push_back(t_buffer);
+	}
+
+	return *t_buffer;
+}
+
+/// Orders spans by thread, then start time, with enclosing spans ahead of the spans they enclose
+const bool_t span_order(const span& LHS, const span& RHS)
+{
+	if(LHS.thread != RHS.thread)
+		return LHS.thread < RHS.thread;
+	if(LHS.start != RHS.start)
+		return LHS.start < RHS.start;
+	return LHS.finish > RHS.finish;
+}
+
+/// Writes a string as a quoted JSON string
+void write_json(std::ostream& Stream, const string_t& Text)
+{
+	Stream << '"';
+	for(string_t::const_iterator c = Text.begin(); c != Text.end(); ++c)
+	{
+		switch(*c)
+		{
+			case '"':
+				Stream << "\\\"";
+				break;
+			case '\\':
+				Stream << "\\\\";
+				break;
+			case '\n':
+				Stream << "\\n";
+				break;
+			case '\r':
+				Stream << "\\r";
+				break;
+			case '\t':
+				Stream << "\\t";
+				break;
+			default:
+				if(static_cast<unsigned char>(*c) < 0x20)
+				{
+					char buffer[8];
+					std::sprintf(buffer, "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(*c)));
+					Stream << buffer;
+				}
+				else
+				{
+					Stream << *c;
+				}
+				break;
+		}
+	}
+	Stream << '"';
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// span
+
+span::span() :
+	thread(0),
+	start(0),
+	finish(0),
+	allocated_bytes(0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// recording
+
+void start()
+{
+	std::lock_guard<std::mutex> lock(detail::g_buffers_mutex);
+	for(uint_t i = 0; i != detail::g_buffers.size(); ++i)
+	{
+		std::lock_guard<std::mutex> buffer_lock(detail::g_buffers[i]->mutex);
+		detail::g_buffers[i]->spans.clear();
+	}
+
+	detail::g_start_time.store(detail::clock_time());
+	detail::g_recording.store(true);
+}
+
+void stop()
+{
+	detail::g_recording.store(false);
+}
+
+const bool_t recording()
+{
+	return detail::g_recording.load(std::memory_order_relaxed);
+}
+
+const double_t now()
+{
+	return (detail::clock_time() - detail::g_start_time.load(std::memory_order_relaxed)) * 1e-9;
+}
+
+const uint_t thread()
+{
+	return detail::buffer().thread;
+}
+
+void record(const span& Span)
+{
+	detail::thread_buffer& buffer = detail::buffer();
+
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.spans.push_back(Span);
+}
+
+const std::vector<span> spans()
+{
+	std::vector<span> results;
+
+	std::lock_guard<std::mutex> lock(detail::g_buffers_mutex);
+	for(uint_t i = 0; i != detail::g_buffers.size(); ++i)
+	{
+		std::lock_guard<std::mutex> buffer_lock(detail::g_buffers[i]->mutex);
+		results.insert(results.end(), detail::g_buffers[i]->spans.begin(), detail::g_buffers[i]->spans.end());
+	}
+
+	std::sort(results.begin(), results.end(), detail::span_order);
+	return results;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// allocations
+
+void count_allocation(const uint64_t Bytes)
+{
+	detail::t_allocated_bytes += Bytes;
+}
+
+const uint64_t allocated_bytes()
+{
+	return detail::t_allocated_bytes;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// hint_scope
+
+hint_scope::hint_scope(const std::vector<ihint*>& Hints) :
+	m_active(recording())
+{
+	if(m_active)
+		detail::t_hints.push_back(&Hints);
+}
+
+hint_scope::~hint_scope()
+{
+	if(m_active)
+		detail::t_hints.pop_back();
+}
+
+const string_t current_hints()
+{
+	if(detail::t_hints.empty())
+		return string_t();
+
+	std::ostringstream buffer;
+	const std::vector<ihint*>& hints = *detail::t_hints.back();
+	for(uint_t i = 0; i != hints.size(); ++i)
+	{
+		if(i)
+			buffer << ", ";
+		buffer << hint::print(hints[i]);
+	}
+
+	return buffer.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// write_chrome_trace
+
+void write_chrome_trace(std::ostream& Stream)
+{
+	const std::vector<span> results = spans();
+
+	std::ostringstream buffer;
+	buffer.imbue(std::locale::classic());
+	buffer << std::fixed << std::setprecision(3);
+
+	buffer << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	uint_t named_thread = 0;
+	for(uint_t i = 0; i != results.size(); ++i)
+	{
+		const span& current = results[i];
+
+		if(i)
+			buffer << ",";
+		buffer << "\n";
+
+		// Name each thread once, before its first span ...
+		if(current.thread != named_thread)
+		{
+			named_thread = current.thread;
+			buffer << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << named_thread << ",\"args\":{\"name\":\"Thread " << named_thread << "\"}},\n";
+		}
+
+		buffer << "{\"name\":";
+		detail::write_json(buffer, current.node + ": " + current.task);
+		buffer << ",\"cat\":\"pipeline\",\"ph\":\"X\",\"pid\":1,\"tid\":" << current.thread;
+		buffer << ",\"ts\":" << current.start * 1e6 << ",\"dur\":" << (current.finish - current.start) * 1e6;
+		buffer << ",\"args\":{\"node\":";
+		detail::write_json(buffer, current.node);
+		buffer << ",\"task\":";
+		detail::write_json(buffer, current.task);
+		buffer << ",\"hints\":";
+		detail::write_json(buffer, current.hints);
+		buffer << ",\"allocated_bytes\":" << current.allocated_bytes << "}}";
+	}
+
+	buffer << "\n]}\n";
+
+	Stream << buffer.str();
+}
+
+const bool_t write_chrome_trace(const filesystem::path& Path)
+{
+	filesystem::ofstream stream(Path);
+	if(!stream)
+		return false;
+
+	write_chrome_trace(stream);
+	return stream.good();
+}
+
+} // namespace pipeline_trace
+
+} // namespace k3d
+
@@ -0,0 +1,115 @@
+#ifndef K3DSDK_PIPELINE_TRACE_H
+#define K3DSDK_PIPELINE_TRACE_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\brief Declares functions for recording a process-wide trace of pipeline execution, for offline analysis
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+#include <iosfwd>
+#include <vector>
+
+namespace k3d
+{
+
+class ihint;
+
+namespace filesystem { class path; }
+
+namespace pipeline_trace
+{
+
+/// Describes a span of time during which one thread executed a pipeline task.  Spans on the same thread nest.
+class span
+{
+public:
+	span();
+
+	/// Stores the name of the node that executed the task
+	string_t node;
+	/// Stores the name of the task
+	string_t task;
+	/// Stores a description of the hints that caused the task to execute, if any
+	string_t hints;
+	/// Stores a small integer that identifies the thread that executed the task
+	uint_t thread;
+	/// Stores the start of the span, in seconds since recording started
+	double_t start;
+	/// Stores the end of the span, in seconds since recording started
+	double_t finish;
+	/// Stores the number of bytes allocated by the thread during the span (only available when the application counts allocations)
+	uint64_t allocated_bytes;
+};
+
+/// Starts recording spans, discarding any that were previously recorded
+void start();
+/// Stops recording spans
+void stop();
+/// Returns true iff spans are being recorded.  Cheap enough to call on every pipeline execution.
+const bool_t recording();
+
+/// Returns the current time, in seconds since recording started
+const double_t now();
+/// Returns a small integer that identifies the calling thread
+const uint_t thread();
+/// Records a span.  Spans are buffered per-thread, so any thread can record spans without contention.
+void record(const span& Span);
+/// Returns every recorded span, ordered by thread and start time
+const std::vector<span> spans();
+
+/// Adds to the count of bytes allocated by the calling thread.  Applications that want allocations included in
+/// traces call this from their global operator new while recording.
+void count_allocation(const uint64_t Bytes);
+/// Returns the total number of bytes counted for the calling thread
+const uint64_t allocated_bytes();
+
+/// RAII helper that makes a set of hints "current" for the calling thread while a pipeline value is brought up-to-date,
+/// so spans started within the update can describe what triggered them.  Does nothing unless recording.
+class hint_scope
+{
+public:
+	hint_scope(const std::vector<ihint*>& Hints);
+	~hint_scope();
+
+private:
+	hint_scope(const hint_scope&);
+	hint_scope& operator=(const hint_scope&);
+
+	const bool_t m_active;
+};
+
+/// Returns a description of the calling thread's current hints, or an empty string
+const string_t current_hints();
+
+/// Writes recorded spans to a stream using the Chrome trace-event JSON format, which can be loaded into chrome://tracing or Perfetto
+void write_chrome_trace(std::ostream& Stream);
+/// Writes recorded spans to a file using the Chrome trace-event JSON format.  Returns false if the file couldn't be written.
+const bool_t write_chrome_trace(const filesystem::path& Path);
+
+} // namespace pipeline_trace
+
+} // namespace k3d
+
+#endif // !K3DSDK_PIPELINE_TRACE_H
+
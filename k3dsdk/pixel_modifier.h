@@ -0,0 +1,106 @@
+#ifndef K3DSDK_PIXEL_MODIFIER_H
+#define K3DSDK_PIXEL_MODIFIER_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/bitmap_modifier.h>
+#include <k3dsdk/idocument.h>
+#include <k3dsdk/inode.h>
+#include <k3dsdk/ipipeline.h>
+#include <k3dsdk/ipixel_modifier.h>
+#include <k3dsdk/pixel_operation.h>
+#include <k3dsdk/property.h>
+
+namespace k3d
+{
+
+/// Implements a bitmap modifier using a pixel_operation.  A chain of consecutive pixel modifiers is evaluated in a single pass by the
+/// last modifier in the chain, reading the input of the first, so the intermediate bitmaps are only computed if something else uses them.
+template<typename derived_t>
+class pixel_modifier :
+	public bitmap_modifier<derived_t>,
+	public ipixel_modifier
+{
+protected:
+	pixel_modifier()
+	{
+	}
+
+	void on_assign_pixels(const bitmap& Input, bitmap& Output)
+	{
+		m_operations.apply(Input, Output);
+	}
+
+private:
+	inline derived_t& owner()
+	{
+		return *static_cast<derived_t*>(this);
+	}
+
+	const bitmap* input_bitmap()
+	{
+		m_operations.clear();
+		m_operations.push_back(create_pixel_operation());
+
+		// Walk upstream, collecting operations for as long as our input is the output of another pixel modifier ...
+		iproperty* input = &static_cast<iproperty&>(this->m_input_bitmap);
+		ipipeline& pipeline = owner().document().pipeline();
+		for(iproperty* source = pipeline.dependency(*input); source; source = pipeline.dependency(*input))
+		{
+			inode* const node = source->property_node();
+			ipixel_modifier* const upstream_modifier = dynamic_cast<ipixel_modifier*>(node);
+			ibitmap_source* const upstream_source = dynamic_cast<ibitmap_source*>(node);
+			ibitmap_sink* const upstream_sink = dynamic_cast<ibitmap_sink*>(node);
+			if(!upstream_modifier || !upstream_source || !upstream_sink || source != &upstream_source->bitmap_source_output())
+				break;
+
+			m_operations.push_front(upstream_modifier->create_pixel_operation());
+			upstream_modifier->coalesce_pending_updates();
+			input = &upstream_sink->bitmap_sink_input();
+		}
+
+		if(input == &static_cast<iproperty&>(this->m_input_bitmap))
+			return this->m_input_bitmap.pipeline_value();
+
+		return property::pipeline_value<bitmap*>(*input);
+	}
+
+	void coalesce_pending_updates()
+	{
+		this->m_output_bitmap.coalesce_pending_hints();
+	}
+
+	void on_resize_bitmap(const bitmap& Input, bitmap& Output)
+	{
+		Output.recreate(Input.width(), Input.height());
+	}
+
+	/// Stores the operations to be applied, from the first upstream modifier in the chain to this one
+	pixel_operations m_operations;
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_PIXEL_MODIFIER_H
+
@@ -0,0 +1,278 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/pixel_operation.h>
+#include <k3dsdk/result.h>
+
+namespace k3d
+{
+
+namespace detail
+{
+
+/// Number of pixels converted to floating-point and transformed at a time
+const uint_t pixel_block_size = 512;
+/// Number of distinct half-float values
+const uint_t half_table_size = 65536;
+/// Smallest bitmap (in pixels) for which building lookup tables is cheaper than evaluating operations for every pixel
+const uint_t minimum_table_pixels = 65536;
+/// Approximate number of pixels processed by each parallel task
+const uint_t pixels_per_task = 16384;
+
+typedef std::vector<boost::shared_ptr<pixel_operation> > operations_t;
+
+/// Applies a range of operations to a block
+void apply_operations(const operations_t& Operations, const uint_t Begin, const uint_t End, pixel_block& Block)
+{
+	for(uint_t i = Begin; i != End; ++i)
+		Operations[i]->apply(Block);
+}
+
+/// Evaluates separable operations for every half-float value, storing the results in one table per channel
+class table_worker
+{
+public:
+	table_worker(const operations_t& Operations, const uint_t OperationCount, std::vector<float_t>& Tables) :
+		m_operations(Operations),
+		m_operation_count(OperationCount),
+		m_tables(Tables)
+	{
+	}
+
+	void operator()(const parallel::blocked_range<uint_t>& Range) const
+	{
+		float_t* const red = &m_tables[0 * half_table_size + Range.begin()];
+		float_t* const green = &m_tables[1 * half_table_size + Range.begin()];
+		float_t* const blue = &m_tables[2 * half_table_size + Range.begin()];
+		float_t* const alpha = &m_tables[3 * half_table_size + Range.begin()];
+
+		half value;
+		for(uint_t i = 0; i != Range.size(); ++i)
+		{
+			value.setBits(static_cast<unsigned short>(Range.begin() + i));
+			red[i] = green[i] = blue[i] = alpha[i] = value;
+		}
+
+		pixel_block block(red, green, blue, alpha, Range.size());
+		apply_operations(m_operations, 0, m_operation_count, block);
+	}
+
+private:
+	const operations_t& m_operations;
+	const uint_t m_operation_count;
+	std::vector<float_t>& m_tables;
+};
+
+/// Transforms bands of rows using lookup tables alone, for chains that are entirely separable
+class table_row_worker
+{
+public:
+	table_row_worker(const bitmap::const_view_t& Input, const bitmap::view_t& Output, const std::vector<half>& Tables) :
+		m_input(Input),
+		m_output(Output),
+		m_tables(Tables)
+	{
+	}
+
+	void operator()(const parallel::blocked_range<uint_t>& Rows) const
+	{
+		const half* const red = &m_tables[0 * half_table_size];
+		const half* const green = &m_tables[1 * half_table_size];
+		const half* const blue = &m_tables[2 * half_table_size];
+		const half* const alpha = &m_tables[3 * half_table_size];
+
+		const uint_t width = m_input.width();
+		for(uint_t row = Rows.begin(); row != Rows.end(); ++row)
+		{
+			bitmap::const_view_t::x_iterator input = m_input.row_begin(row);
+			bitmap::view_t::x_iterator output = m_output.row_begin(row);
+			for(uint_t x = 0; x != width; ++x, ++input, ++output)
+			{
+				*output = pixel(
+					red[boost::gil::get_color(*input, boost::gil::red_t()).bits()],
+					green[boost::gil::get_color(*input, boost::gil::green_t()).bits()],
+					blue[boost::gil::get_color(*input, boost::gil::blue_t()).bits()],
+					alpha[boost::gil::get_color(*input, boost::gil::alpha_t()).bits()]);
+			}
+		}
+	}
+
+private:
+	const bitmap::const_view_t m_input;
+	const bitmap::view_t m_output;
+	const std::vector<half>& m_tables;
+};
+
+/// Transforms bands of rows a block at a time, converting pixels to floating-point (optionally using lookup tables for the first operations)
+class block_row_worker
+{
+public:
+	block_row_worker(const bitmap::const_view_t& Input, const bitmap::view_t& Output, const operations_t& Operations, const uint_t FirstOperation, const std::vector<float_t>& Tables) :
+		m_input(Input),
+		m_output(Output),
+		m_operations(Operations),
+		m_first_operation(FirstOperation),
+		m_tables(Tables)
+	{
+	}
+
+	void operator()(const parallel::blocked_range<uint_t>& Rows) const
+	{
+		float_t red[pixel_block_size];
+		float_t green[pixel_block_size];
+		float_t blue[pixel_block_size];
+		float_t alpha[pixel_block_size];
+
+		const uint_t width = m_input.width();
+		for(uint_t row = Rows.begin(); row != Rows.end(); ++row)
+		{
+			bitmap::const_view_t::x_iterator input = m_input.row_begin(row);
+			bitmap::view_t::x_iterator output = m_output.row_begin(row);
+
+			for(uint_t x = 0; x < width; x += pixel_block_size)
+			{
+				const uint_t count = std::min(pixel_block_size, width - x);
+
+				if(m_tables.empty())
+				{
+					for(uint_t i = 0; i != count; ++i)
+					{
+						red[i] = boost::gil::get_color(input[i], boost::gil::red_t());
+						green[i] = boost::gil::get_color(input[i], boost::gil::green_t());
+						blue[i] = boost::gil::get_color(input[i], boost::gil::blue_t());
+						alpha[i] = boost::gil::get_color(input[i], boost::gil::alpha_t());
+					}
+				}
+				else
+				{
+					const float_t* const red_table = &m_tables[0 * half_table_size];
+					const float_t* const green_table = &m_tables[1 * half_table_size];
+					const float_t* const blue_table = &m_tables[2 * half_table_size];
+					const float_t* const alpha_table = &m_tables[3 * half_table_size];
+
+					for(uint_t i = 0; i != count; ++i)
+					{
+						red[i] = red_table[boost::gil::get_color(input[i], boost::gil::red_t()).bits()];
+						green[i] = green_table[boost::gil::get_color(input[i], boost::gil::green_t()).bits()];
+						blue[i] = blue_table[boost::gil::get_color(input[i], boost::gil::blue_t()).bits()];
+						alpha[i] = alpha_table[boost::gil::get_color(input[i], boost::gil::alpha_t()).bits()];
+					}
+				}
+
+				pixel_block block(red, green, blue, alpha, count);
+				apply_operations(m_operations, m_first_operation, m_operations.size(), block);
+
+				for(uint_t i = 0; i != count; ++i)
+					output[i] = pixel(half(red[i]), half(green[i]), half(blue[i]), half(alpha[i]));
+
+				input += count;
+				output += count;
+			}
+		}
+	}
+
+private:
+	const bitmap::const_view_t m_input;
+	const bitmap::view_t m_output;
+	const operations_t& m_operations;
+	const uint_t m_first_operation;
+	const std::vector<float_t>& m_tables;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// pixel_operations
+
+void pixel_operations::push_front(pixel_operation* const Operation)
+{
+	return_if_fail(Operation);
+	m_operations.insert(m_operations.begin(), boost::shared_ptr<pixel_operation>(Operation));
+}
+
+void pixel_operations::push_back(pixel_operation* const Operation)
+{
+	return_if_fail(Operation);
+	m_operations.push_back(boost::shared_ptr<pixel_operation>(Operation));
+}
+
+void pixel_operations::clear()
+{
+	m_operations.clear();
+}
+
+const uint_t pixel_operations::size() const
+{
+	return m_operations.size();
+}
+
+void pixel_operations::apply(const bitmap& Input, bitmap& Output) const
+{
+	return_if_fail(Input.width() == Output.width() && Input.height() == Output.height());
+
+	if(m_operations.empty())
+	{
+		boost::gil::copy_pixels(const_view(Input), view(Output));
+		return;
+	}
+
+	const uint_t width = Input.width();
+	const uint_t height = Input.height();
+	if(!width || !height)
+		return;
+
+	const parallel::blocked_range<uint_t> rows(0, height, std::max(uint_t(1), detail::pixels_per_task / width));
+
+	// Tabulate separable operations at the start of the chain, if the bitmap is large enough to make it worthwhile ...
+	uint_t separable_count = 0;
+	while(separable_count != m_operations.size() && m_operations[separable_count]->separable())
+		++separable_count;
+
+	std::vector<float_t> tables;
+	if(separable_count && width * height >= detail::minimum_table_pixels)
+	{
+		tables.resize(4 * detail::half_table_size);
+		parallel::parallel_for(
+			parallel::blocked_range<uint_t>(0, detail::half_table_size, 4096),
+			detail::table_worker(m_operations, separable_count, tables));
+	}
+	else
+	{
+		separable_count = 0;
+	}
+
+	// If the entire chain is separable, the tables can map input values directly to output values ...
+	if(separable_count == m_operations.size())
+	{
+		const std::vector<half> half_tables(tables.begin(), tables.end());
+		parallel::parallel_for(rows, detail::table_row_worker(const_view(Input), view(Output), half_tables));
+		return;
+	}
+
+	parallel::parallel_for(rows, detail::block_row_worker(const_view(Input), view(Output), m_operations, separable_count, tables));
+}
+
+} // namespace k3d
+
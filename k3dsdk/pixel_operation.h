@@ -0,0 +1,98 @@
+#ifndef K3DSDK_PIXEL_OPERATION_H
+#define K3DSDK_PIXEL_OPERATION_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/bitmap.h>
+#include <k3dsdk/types.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+namespace k3d
+{
+
+/// Stores a run of pixels as separate arrays of red, green, blue, and alpha values, so that per-channel operations vectorize
+class pixel_block
+{
+public:
+	pixel_block(float_t* const Red, float_t* const Green, float_t* const Blue, float_t* const Alpha, const uint_t Size) :
+		red(Red),
+		green(Green),
+		blue(Blue),
+		alpha(Alpha),
+		size(Size)
+	{
+	}
+
+	float_t* const red;
+	float_t* const green;
+	float_t* const blue;
+	float_t* const alpha;
+	const uint_t size;
+};
+
+/// Abstract interface for an operation that transforms each pixel of a bitmap independently of its neighbors
+class pixel_operation
+{
+public:
+	virtual ~pixel_operation() {}
+
+	/// Transforms every pixel in a block, in-place.  Called concurrently for different blocks.
+	virtual void apply(pixel_block& Block) const = 0;
+	/// Returns true iff each output channel depends only on the same input channel, so the operation can be tabulated for half-float input
+	virtual const bool_t separable() const
+	{
+		return false;
+	}
+};
+
+/// Applies a chain of pixel operations to a bitmap in a single pass, processing bands of rows in parallel.  Runs of separable
+/// operations at the start of the chain are replaced by lookup tables indexed by the half-float input values, which gives
+/// identical results, since the operations are evaluated exactly once for every possible input value.
+class pixel_operations
+{
+public:
+	/// Adds an operation to the start of the chain, taking ownership of it
+	void push_front(pixel_operation* const Operation);
+	/// Adds an operation to the end of the chain, taking ownership of it
+	void push_back(pixel_operation* const Operation);
+	/// Removes every operation from the chain
+	void clear();
+	/// Returns the number of operations in the chain
+	const uint_t size() const;
+
+	/// Applies the chain to Input, storing the results in Output, which must have the same dimensions
+	void apply(const bitmap& Input, bitmap& Output) const;
+
+private:
+	typedef std::vector<boost::shared_ptr<pixel_operation> > operations_t;
+	operations_t m_operations;
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_PIXEL_OPERATION_H
+
@@ -22,12 +22,14 @@
 */
 
 #include <k3dsdk/fstream.h>
+#include <k3dsdk/high_res_timer.h>
 #include <k3dsdk/iapplication_plugin_factory.h>
 #include <k3dsdk/idocument_plugin_factory.h>
 #include <k3dsdk/iplugin_factory.h>
 #include <k3dsdk/iplugin_registry.h>
 #include <k3dsdk/iscript_engine.h>
 #include <k3d-i18n-config.h>
+#include <k3d-version-config.h>
 #include <k3dsdk/log.h>
 #include <k3dsdk/os_load_module.h>
 #include <k3dsdk/plugin_factory_collection.h>
@@ -38,7 +40,9 @@
 #include <k3dsdk/type_registry.h>
 #include <k3dsdk/xml.h>
 
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 namespace k3d
 {
@@ -96,9 +100,10 @@ class plugin_registry :
 	public iplugin_registry
 {
 public:
-	plugin_registry(message_signal_t& MessageSignal, iplugin_factory_collection::factories_t& Factories) :
+	plugin_registry(message_signal_t& MessageSignal, iplugin_factory_collection::factories_t& Factories, iplugin_factory_collection::factories_t* const ModuleFactories = 0) :
 		m_message_signal(MessageSignal),
-		m_factories(Factories)
+		m_factories(Factories),
+		m_module_factories(ModuleFactories)
 	{
 	}
 
@@ -122,13 +127,91 @@ public:
 
 		// Stash that baby!
 		m_factories.insert(&Factory);
+		if(m_module_factories)
+			m_module_factories->insert(&Factory);
 	}
 
 private:
 	message_signal_t& m_message_signal;
 	iplugin_factory_collection::factories_t& m_factories;
+	iplugin_factory_collection::factories_t* const m_module_factories;
 };
 
+/// Records how long it took to make the plugins in a module available, and whether they were indexed, proxied, or loaded
+struct module_load_time
+{
+	module_load_time(const filesystem::path& Module, const std::string& Method, const double Seconds, const uint_t Factories) :
+		module(Module),
+		method(Method),
+		seconds(Seconds),
+		factories(Factories)
+	{
+	}
+
+	bool operator<(const module_load_time& RHS) const
+	{
+		return seconds > RHS.seconds;
+	}
+
+	filesystem::path module;
+	std::string method;
+	double seconds;
+	uint_t factories;
+};
+
+/// Stores load times for every module, including modules that are loaded on-demand
+std::vector<module_load_time> module_load_times;
+
+/// Prints a single module load time, using the same format as plugin_factory_collection::print_load_times()
+void print_load_time(std::ostream& Stream, const module_load_time& LoadTime)
+{
+	Stream << std::fixed << std::setprecision(4) << std::setw(10) << LoadTime.seconds << "s " << std::setw(9) << std::left << LoadTime.method << std::right << " " << std::setw(4) << LoadTime.factories << " plugins " << LoadTime.module.native_console_string() << "\n";
+}
+
+/// Describes a set of plugin factories using the same XML as a module proxy, returning false if any factory can't be proxied
+bool save_proxy(const iplugin_factory_collection::factories_t& Factories, xml::element& XMLPlugins)
+{
+	for(iplugin_factory_collection::factories_t::const_iterator factory = Factories.begin(); factory != Factories.end(); ++factory)
+	{
+		xml::element& xml_plugin = XMLPlugins.append(
+			xml::element("plugin",
+				xml::attribute("name", (*factory)->name()),
+				xml::attribute("factory_id", (*factory)->factory_id()),
+				xml::attribute("quality", (*factory)->quality())));
+
+		if(dynamic_cast<iapplication_plugin_factory*>(*factory))
+			xml_plugin.append(xml::attribute("type", "application"));
+		else if(dynamic_cast<idocument_plugin_factory*>(*factory))
+			xml_plugin.append(xml::attribute("type", "document"));
+		else
+			return false;
+
+		xml_plugin.append(xml::element("short_description", (*factory)->short_description()));
+
+		xml::element& xml_categories = xml_plugin.append(xml::element("categories"));
+		for(iplugin_factory::categories_t::const_iterator category = (*factory)->categories().begin(); category != (*factory)->categories().end(); ++category)
+			xml_categories.append(xml::element("category", *category));
+
+		xml::element& xml_interfaces = xml_plugin.append(xml::element("interfaces"));
+		const iplugin_factory::interfaces_t interfaces = (*factory)->interfaces();
+		for(iplugin_factory::interfaces_t::const_iterator interface = interfaces.begin(); interface != interfaces.end(); ++interface)
+		{
+			const std::string xml_interface = type_string(**interface);
+			if(xml_interface.empty())
+				return false;
+
+			xml_interfaces.append(xml::element("interface", xml_interface));
+		}
+
+		xml::element& xml_metadata = xml_plugin.append(xml::element("metadata"));
+		const iplugin_factory::metadata_t metadata = (*factory)->metadata();
+		for(iplugin_factory::metadata_t::const_iterator pair = metadata.begin(); pair != metadata.end(); ++pair)
+			xml_metadata.append(xml::element("pair", xml::attribute("name", pair->first), xml::attribute("value", pair->second)));
+	}
+
+	return true;
+}
+
 /// Stores a mapping of plugin class id to plugin factory, so we can lookup recently-loaded factories quickly
 std::map<uuid, iplugin_factory*> proxied_factories;
 /// Stores a mapping of plugin class id to plugin module path, so we can load modules that were proxied
@@ -141,6 +224,7 @@ iplugin_factory* load_proxied_factory(const uuid& FactoryID)
 		return proxied_factories[FactoryID];
 
 	// OK, just load the module already!
+	k3d::timer timer;
 	register_plugins_entry_point register_plugins = 0;
 	os_load_module(proxied_modules[FactoryID], register_plugins);
 
@@ -157,6 +241,12 @@ iplugin_factory* load_proxied_factory(const uuid& FactoryID)
 	for(iplugin_factory_collection::factories_t::iterator factory = factories.begin(); factory != factories.end(); ++factory)
 		proxied_factories[(*factory)->factory_id()] = (*factory);
 
+	// Modules loaded on-demand miss the load times printed at startup, so log each one as it happens ...
+	module_load_times.push_back(module_load_time(proxied_modules[FactoryID], "on demand", timer.elapsed(), factories.size()));
+	std::ostringstream load_time;
+	print_load_time(load_time, module_load_times.back());
+	log() << info << "plugin module load time:\n" << load_time.str();
+
 	return proxied_factories[FactoryID];
 }
 
@@ -379,7 +469,21 @@ private:
 
 struct plugin_factory_collection::implementation
 {
-	bool proxy_module(const filesystem::path& Path, const filesystem::path& ProxyPath)
+	implementation() :
+		m_index_modified(false)
+	{
+	}
+
+	/// Stores the contents of a proxied module, along with the module modification time, so the contents can be reused until the module changes
+	struct index_entry
+	{
+		int64_t modified;
+		xml::element plugins;
+	};
+	/// Stores index entries, keyed by module path
+	typedef std::map<std::string, index_entry> index_t;
+
+	bool proxy_module(const filesystem::path& Path, const filesystem::path& ProxyPath, const time_t Modified)
 	{
 		m_message_signal.emit(string_cast(boost::format(_("Proxying plugin module %1%")) % Path.native_utf8_string().raw()));
 
@@ -400,109 +504,145 @@ struct plugin_factory_collection::implementation
 			if(!xml_plugins)
 				throw std::runtime_error("Missing <plugins> tag");
 
-			for(xml::element::elements_t::iterator xml_plugin = xml_plugins->children.begin(); xml_plugin != xml_plugins->children.end(); ++xml_plugin)
-			{
-				if(xml_plugin->name != "plugin")
-					continue;
+			proxy_plugins(Path, *xml_plugins);
+			index_module(Path, Modified, *xml_plugins);
 
-				const std::string factory_name = xml::attribute_text(*xml_plugin, "name");
-				m_message_signal.emit(string_cast(boost::format(_("Proxying plugin %1%")) % factory_name));
+			return true;
+		}
+		catch(std::exception& e)
+		{
+			log() << error << "Error proxying plugin module " << ProxyPath.native_console_string() << std::endl;
+			return false;
+		}
 
-				const uuid plugin_factory_id = xml::attribute_value<uuid>(*xml_plugin, "factory_id", uuid::null());
-				if(plugin_factory_id == uuid::null())
-				{
-					log() << error << "Plugin " << factory_name << " with missing factory ID will not be loaded" << std::endl;
-					continue;
-				}
+		return false;
+	}
 
-				// Ensure we don't have any duplicate factory IDs ...
-				if(std::count_if(m_factories.begin(), m_factories.end(), detail::same_factory_id(plugin_factory_id)))
-				{
-					log() << error << "Plugin " << factory_name << " with duplicate factory ID " << plugin_factory_id << " will not be loaded" << std::endl;
-					continue;
-				}
+	/// Proxies a module using its index entry, if the module hasn't been modified since it was indexed
+	bool proxy_indexed_module(const filesystem::path& Path, const time_t Modified)
+	{
+		index_t::const_iterator entry = m_index.find(Path.native_filesystem_string());
+		if(entry == m_index.end() || entry->second.modified != Modified)
+			return false;
 
-				// Warn if we have duplicate names ...
-				if(std::count_if(m_factories.begin(), m_factories.end(), detail::same_name(factory_name)))
-				{
-					log() << error << "Plugin factory [" << plugin_factory_id << "] with duplicate name [" << factory_name << "] will not be loaded." << std::endl;
-					continue;
-				}
+		m_message_signal.emit(string_cast(boost::format(_("Proxying plugin module %1%")) % Path.native_utf8_string().raw()));
+		proxy_plugins(Path, entry->second.plugins);
 
-				const std::string plugin_short_description = xml::element_text(*xml_plugin, "short_description");
-				const iplugin_factory::quality_t plugin_quality = xml::attribute_value<iplugin_factory::quality_t>(*xml_plugin, "quality", iplugin_factory::EXPERIMENTAL);
-				const std::string plugin_type = xml::attribute_text(*xml_plugin, "type");
+		return true;
+	}
 
-				iplugin_factory::categories_t plugin_categories;
-				if(xml::element* const xml_categories = xml::find_element(*xml_plugin, "categories"))
-				{
-					for(xml::element::elements_t::iterator xml_category = xml_categories->children.begin(); xml_category != xml_categories->children.end(); ++xml_category)
-					{
-						if(xml_category->name != "category")
-							continue;
+	/// Stores the contents of a module in the index
+	void index_module(const filesystem::path& Path, const time_t Modified, const xml::element& XMLPlugins)
+	{
+		if(!Modified)
+			return;
 
-						plugin_categories.push_back(xml_category->text);
-					}
-				}
+		index_entry& entry = m_index[Path.native_filesystem_string()];
+		entry.modified = Modified;
+		entry.plugins = XMLPlugins;
+		m_index_modified = true;
+	}
 
-				iplugin_factory::interfaces_t plugin_interfaces;
-				if(xml::element* const xml_interfaces = xml::find_element(*xml_plugin, "interfaces"))
-				{
-					for(xml::element::elements_t::iterator xml_interface = xml_interfaces->children.begin(); xml_interface != xml_interfaces->children.end(); ++xml_interface)
-					{
-						if(xml_interface->name != "interface")
-							continue;
+	/// Registers proxies for the plugins described by a module proxy or index entry
+	void proxy_plugins(const filesystem::path& Path, const xml::element& XMLPlugins)
+	{
+		for(xml::element::elements_t::const_iterator xml_plugin = XMLPlugins.children.begin(); xml_plugin != XMLPlugins.children.end(); ++xml_plugin)
+		{
+			if(xml_plugin->name != "plugin")
+				continue;
 
-						plugin_interfaces.push_back(type_id(xml_interface->text));
-					}
-				}
-				plugin_interfaces.erase(std::find(plugin_interfaces.begin(), plugin_interfaces.end(), static_cast<std::type_info*>(0)), plugin_interfaces.end());
+			const std::string factory_name = xml::attribute_text(*xml_plugin, "name");
+			m_message_signal.emit(string_cast(boost::format(_("Proxying plugin %1%")) % factory_name));
 
-				iplugin_factory::metadata_t metadata;
-				if(xml::element* const xml_metadata = xml::find_element(*xml_plugin, "metadata"))
-				{
-					for(xml::element::elements_t::iterator xml_pair = xml_metadata->children.begin(); xml_pair != xml_metadata->children.end(); ++xml_pair)
-					{
-						if(xml_pair->name != "pair")
-							continue;
+			const uuid plugin_factory_id = xml::attribute_value<uuid>(*xml_plugin, "factory_id", uuid::null());
+			if(plugin_factory_id == uuid::null())
+			{
+				log() << error << "Plugin " << factory_name << " with missing factory ID will not be loaded" << std::endl;
+				continue;
+			}
 
-						metadata.insert(std::make_pair(xml::attribute_text(*xml_pair, "name"), xml::attribute_text(*xml_pair, "value")));
-					}
-				}
+			// Ensure we don't have any duplicate factory IDs ...
+			if(std::count_if(m_factories.begin(), m_factories.end(), detail::same_factory_id(plugin_factory_id)))
+			{
+				log() << error << "Plugin " << factory_name << " with duplicate factory ID " << plugin_factory_id << " will not be loaded" << std::endl;
+				continue;
+			}
 
-				if(plugin_type == "application")
+			// Warn if we have duplicate names ...
+			if(std::count_if(m_factories.begin(), m_factories.end(), detail::same_name(factory_name)))
+			{
+				log() << error << "Plugin factory [" << plugin_factory_id << "] with duplicate name [" << factory_name << "] will not be loaded." << std::endl;
+				continue;
+			}
+
+			const std::string plugin_short_description = xml::element_text(*xml_plugin, "short_description");
+			const iplugin_factory::quality_t plugin_quality = xml::attribute_value<iplugin_factory::quality_t>(*xml_plugin, "quality", iplugin_factory::EXPERIMENTAL);
+			const std::string plugin_type = xml::attribute_text(*xml_plugin, "type");
+
+			iplugin_factory::categories_t plugin_categories;
+			if(const xml::element* const xml_categories = xml::find_element(*xml_plugin, "categories"))
+			{
+				for(xml::element::elements_t::const_iterator xml_category = xml_categories->children.begin(); xml_category != xml_categories->children.end(); ++xml_category)
 				{
-					m_factories.insert(new detail::application_plugin_factory_proxy(plugin_factory_id, factory_name, plugin_short_description, plugin_categories, plugin_quality, plugin_interfaces, metadata));
+					if(xml_category->name != "category")
+						continue;
+
+					plugin_categories.push_back(xml_category->text);
 				}
-				else if(plugin_type == "document")
+			}
+
+			iplugin_factory::interfaces_t plugin_interfaces;
+			if(const xml::element* const xml_interfaces = xml::find_element(*xml_plugin, "interfaces"))
+			{
+				for(xml::element::elements_t::const_iterator xml_interface = xml_interfaces->children.begin(); xml_interface != xml_interfaces->children.end(); ++xml_interface)
 				{
-					m_factories.insert(new detail::document_plugin_factory_proxy(plugin_factory_id, factory_name, plugin_short_description, plugin_categories, plugin_quality, plugin_interfaces, metadata));
+					if(xml_interface->name != "interface")
+						continue;
+
+					plugin_interfaces.push_back(type_id(xml_interface->text));
 				}
-				else
+			}
+			plugin_interfaces.erase(std::find(plugin_interfaces.begin(), plugin_interfaces.end(), static_cast<std::type_info*>(0)), plugin_interfaces.end());
+
+			iplugin_factory::metadata_t metadata;
+			if(const xml::element* const xml_metadata = xml::find_element(*xml_plugin, "metadata"))
+			{
+				for(xml::element::elements_t::const_iterator xml_pair = xml_metadata->children.begin(); xml_pair != xml_metadata->children.end(); ++xml_pair)
 				{
-					log() << error << "Unknown plugin factory type " << plugin_type << " will be ignored" << std::endl;
-					continue;
+					if(xml_pair->name != "pair")
+						continue;
+
+					metadata.insert(std::make_pair(xml::attribute_text(*xml_pair, "name"), xml::attribute_text(*xml_pair, "value")));
 				}
+			}
 
-				detail::proxied_modules[plugin_factory_id] = Path;
-				detail::proxied_factories[plugin_factory_id] = 0;
+			if(plugin_type == "application")
+			{
+				m_factories.insert(new detail::application_plugin_factory_proxy(plugin_factory_id, factory_name, plugin_short_description, plugin_categories, plugin_quality, plugin_interfaces, metadata));
+			}
+			else if(plugin_type == "document")
+			{
+				m_factories.insert(new detail::document_plugin_factory_proxy(plugin_factory_id, factory_name, plugin_short_description, plugin_categories, plugin_quality, plugin_interfaces, metadata));
+			}
+			else
+			{
+				log() << error << "Unknown plugin factory type " << plugin_type << " will be ignored" << std::endl;
+				continue;
 			}
 
-			return true;
-		}
-		catch(std::exception& e)
-		{
-			log() << error << "Error proxying plugin module " << ProxyPath.native_console_string() << std::endl;
-			return false;
+			detail::proxied_modules[plugin_factory_id] = Path;
+			detail::proxied_factories[plugin_factory_id] = 0;
 		}
-
-		return false;
 	}
 
 	/// Stores a signal that will be emitted to display loading progress
 	detail::message_signal_t m_message_signal;
 	/// Stores the set of available plugin factories
 	factories_t m_factories;
+	/// Stores the plugin index
+	index_t m_index;
+	/// Set to true iff the index has changed since it was loaded
+	bool_t m_index_modified;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -539,12 +679,40 @@ void plugin_factory_collection::load_module(const filesystem::path& Path, const
 	if(filesystem::extension(Path).lowercase().raw() != ".module")
 		return;
 
+	k3d::timer timer;
+	const uint_t factory_count = m_implementation->m_factories.size();
+
+	time_t modified = 0;
+	system::file_modification_time(Path, modified);
+
 	// If the module can be proxied for fast startup, do that and return ...
+	bool_t index_module = false;
 	if(LoadProxies == LOAD_PROXIES)
 	{
-		filesystem::path proxy_path = Path + ".proxy";
-		if(filesystem::exists(proxy_path) && m_implementation->proxy_module(Path, proxy_path))
+		if(m_implementation->proxy_indexed_module(Path, modified))
+		{
+			detail::module_load_times.push_back(detail::module_load_time(Path, "index", timer.elapsed(), m_implementation->m_factories.size() - factory_count));
 			return;
+		}
+
+		const filesystem::path proxy_path = Path + ".proxy";
+		if(filesystem::exists(proxy_path))
+		{
+			if(filesystem::up_to_date(Path, proxy_path))
+			{
+				if(m_implementation->proxy_module(Path, proxy_path, modified))
+				{
+					detail::module_load_times.push_back(detail::module_load_time(Path, "proxy", timer.elapsed(), m_implementation->m_factories.size() - factory_count));
+					return;
+				}
+			}
+			else
+			{
+				// The module has been rebuilt since its proxy was created, so load the module and index its actual contents ...
+				log() << warning << "Ignoring out-of-date plugin module proxy " << proxy_path.native_console_string() << std::endl;
+				index_module = true;
+			}
+		}
 	}
 
 	// OK, just load the module ...
@@ -556,8 +724,18 @@ void plugin_factory_collection::load_module(const filesystem::path& Path, const
 		return;
 
 	// It's a K-3D module, all-right - give it a chance to register its plugins
-	detail::plugin_registry registry(m_implementation->m_message_signal, m_implementation->m_factories);
+	factories_t module_factories;
+	detail::plugin_registry registry(m_implementation->m_message_signal, m_implementation->m_factories, &module_factories);
 	register_plugins(registry);
+
+	if(index_module)
+	{
+		xml::element xml_plugins("plugins");
+		if(detail::save_proxy(module_factories, xml_plugins))
+			m_implementation->index_module(Path, modified, xml_plugins);
+	}
+
+	detail::module_load_times.push_back(detail::module_load_time(Path, "loaded", timer.elapsed(), module_factories.size()));
 }
 
 void plugin_factory_collection::load_modules(const filesystem::path& Path, const bool Recursive, const load_proxy_t LoadProxies)
@@ -595,6 +773,120 @@ void plugin_factory_collection::load_modules(const std::string& Paths, const boo
 		load_modules(*path, Recursive, LoadProxies);
 }
 
+void plugin_factory_collection::load_index(const filesystem::path& Path)
+{
+	m_implementation->m_index.clear();
+	m_implementation->m_index_modified = false;
+
+	if(!filesystem::exists(Path))
+		return;
+
+	try
+	{
+		filesystem::ifstream index_stream(Path);
+		xml::element xml_document;
+		index_stream >> xml_document;
+
+		if(xml_document.name != "k3dml")
+			throw std::runtime_error("Not a k3dml document");
+
+		// Module contents may be described differently by other versions, so start over ...
+		if(xml::attribute_text(xml_document, "version") != K3D_VERSION || xml::attribute_text(xml_document, "host") != K3D_HOST)
+		{
+			log() << info << "Ignoring plugin index " << Path.native_console_string() << " from another version" << std::endl;
+			return;
+		}
+
+		xml::element* const xml_index = xml::find_element(xml_document, "index");
+		if(!xml_index)
+			throw std::runtime_error("Missing <index> tag");
+
+		for(xml::element::elements_t::iterator xml_module = xml_index->children.begin(); xml_module != xml_index->children.end(); ++xml_module)
+		{
+			if(xml_module->name != "module")
+				continue;
+
+			xml::element* const xml_plugins = xml::find_element(*xml_module, "plugins");
+			if(!xml_plugins)
+				continue;
+
+			implementation::index_entry& entry = m_implementation->m_index[xml::attribute_text(*xml_module, "path")];
+			entry.modified = xml::attribute_value<int64_t>(*xml_module, "modified", 0);
+			entry.plugins = *xml_plugins;
+		}
+	}
+	catch(std::exception& e)
+	{
+		log() << error << "Error loading plugin index " << Path.native_console_string() << ": " << e.what() << std::endl;
+		m_implementation->m_index.clear();
+	}
+}
+
+void plugin_factory_collection::save_index(const filesystem::path& Path)
+{
+	if(!m_implementation->m_index_modified)
+		return;
+
+	xml::element xml_document("k3dml",
+		xml::attribute("package", K3D_PACKAGE),
+		xml::attribute("version", K3D_VERSION),
+		xml::attribute("host", K3D_HOST));
+
+	xml::element& xml_index = xml_document.append(xml::element("index"));
+	for(implementation::index_t::const_iterator entry = m_implementation->m_index.begin(); entry != m_implementation->m_index.end(); ++entry)
+	{
+		xml::element& xml_module = xml_index.append(
+			xml::element("module",
+				xml::attribute("path", entry->first),
+				xml::attribute("modified", entry->second.modified)));
+		xml_module.append(entry->second.plugins);
+	}
+
+	// Write to a temporary file first, so concurrent processes never read a partial index.  The temporary file is unique to this
+	// process so concurrent writers can't interleave, and lives alongside the index so the rename never crosses filesystems ...
+	filesystem::create_directories(Path.branch_path());
+	const filesystem::path temp_path = Path + ("." + string_cast(system::process_id()) + ".tmp");
+	{
+		filesystem::ofstream index_stream(temp_path);
+		index_stream << xml::declaration() << xml_document;
+		if(!index_stream)
+		{
+			log() << error << "Error saving plugin index " << temp_path.native_console_string() << std::endl;
+			index_stream.close();
+			filesystem::remove(temp_path);
+			return;
+		}
+	}
+
+	if(!filesystem::rename(temp_path, Path))
+	{
+		filesystem::remove(Path);
+		if(!filesystem::rename(temp_path, Path))
+		{
+			log() << error << "Error saving plugin index " << Path.native_console_string() << std::endl;
+			filesystem::remove(temp_path);
+			return;
+		}
+	}
+
+	m_implementation->m_index_modified = false;
+}
+
+void plugin_factory_collection::print_load_times(std::ostream& Stream)
+{
+	std::vector<detail::module_load_time> load_times(detail::module_load_times);
+	std::stable_sort(load_times.begin(), load_times.end());
+
+	double total = 0;
+	for(std::vector<detail::module_load_time>::const_iterator load_time = load_times.begin(); load_time != load_times.end(); ++load_time)
+	{
+		detail::print_load_time(Stream, *load_time);
+		total += load_time->seconds;
+	}
+
+	Stream << std::fixed << std::setprecision(4) << std::setw(10) << total << "s total for " << load_times.size() << " modules" << std::endl;
+}
+
 const iplugin_factory_collection::factories_t& plugin_factory_collection::factories()
 {
 	return m_implementation->m_factories;
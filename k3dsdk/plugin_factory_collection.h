@@ -29,6 +29,7 @@
 #include <k3dsdk/module.h>
 #include <k3dsdk/signal_system.h>
 
+#include <iosfwd>
 #include <string>
 
 namespace k3d
@@ -65,6 +66,14 @@ public:
 	/// Loads plugin modules from zero-to-many directories, optionally descending recursively into each directory
 	void load_modules(const std::string& Paths, const bool Recursive, const load_proxy_t LoadProxies);
 
+	/// Loads a plugin index, which stores the contents of every proxied module in a single file.  When loading proxies,
+	/// modules that haven't been modified since they were indexed are proxied from the index, without reading their proxy files.
+	void load_index(const filesystem::path& Path);
+	/// Saves the plugin index, if it has changed since it was loaded
+	void save_index(const filesystem::path& Path);
+	/// Prints the time spent loading or proxying each module (including modules loaded on-demand so far), slowest first
+	void print_load_times(std::ostream& Stream);
+
 	// iplugin_factory_collection implementation
 	const factories_t& factories();
 
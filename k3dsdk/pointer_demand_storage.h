@@ -21,6 +21,7 @@
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include <k3dsdk/ihint.h>
+#include <k3dsdk/pipeline_trace.h>
 #include <k3dsdk/signal_system.h>
 #include <k3dsdk/utility.h>
 
@@ -100,6 +101,17 @@ public:
 		signal_policy_t::set_value(Hint);
 	}
 
+	/// Replaces two-or-more pending hints with a single NULL hint, so the next update recreates the value from scratch.
+	/// This bounds the pending hints for values that are updated repeatedly but rarely read.
+	void coalesce_pending_hints()
+	{
+		if(m_pending_hints.size() < 2)
+			return;
+
+		std::for_each(m_pending_hints.begin(), m_pending_hints.end(), delete_object());
+		m_pending_hints.assign(1, static_cast<ihint*>(0));
+	}
+
 	/// Accesses the underlying value, creating it if it doesn't already exist
 	pointer_t internal_value()
 	{
@@ -112,6 +124,7 @@ public:
 
 			// Create a temporary copy of pending hints in-case we are updated while executing ...
 			const pending_hints_t pending_hints(m_pending_hints);
+			const pipeline_trace::hint_scope hints(pending_hints);
 			m_update_slot(pending_hints, *m_value);
 			
 			std::for_each(m_pending_hints.begin(), m_pending_hints.end(), delete_object());
@@ -221,29 +221,36 @@ primitive* create(mesh& Mesh, const mesh::points_t& Vertices, const mesh::counts
 		primitive* const polyhedron = create(Mesh);
 		polyhedron->shell_types.push_back(POLYGONS);
 
+		// Size every array up-front, since this is used to load large meshes ...
+		const uint_t face_count = VertexCounts.size();
+		polyhedron->face_shells.assign(face_count, 0);
+		polyhedron->face_first_loops.resize(face_count);
+		polyhedron->face_loop_counts.assign(face_count, 1);
+		polyhedron->face_selections.assign(face_count, 0.0);
+		polyhedron->face_materials.assign(face_count, Material);
+		polyhedron->loop_first_edges.resize(face_count);
+		polyhedron->vertex_points.resize(expected_indices);
+		polyhedron->vertex_selections.assign(expected_indices, 0.0);
+		polyhedron->clockwise_edges.resize(expected_indices);
+		polyhedron->edge_selections.assign(expected_indices, 0.0);
+
 		uint_t face_vertex = 0;
 		const uint_t face_begin = 0;
-		const uint_t face_end = face_begin + VertexCounts.size();
+		const uint_t face_end = face_begin + face_count;
 		for(uint_t face = face_begin; face != face_end; ++face)
 		{
-			polyhedron->face_shells.push_back(0);
-			polyhedron->face_first_loops.push_back(polyhedron->loop_first_edges.size());
-			polyhedron->face_loop_counts.push_back(1);
-			polyhedron->face_selections.push_back(0.0);
-			polyhedron->face_materials.push_back(Material);
-			polyhedron->loop_first_edges.push_back(polyhedron->clockwise_edges.size());
+			polyhedron->face_first_loops[face] = face;
+			polyhedron->loop_first_edges[face] = face_vertex;
 
 			const uint_t vertex_begin = 0;
 			const uint_t vertex_end = vertex_begin + VertexCounts[face];
-			const uint_t loop_begin = polyhedron->clockwise_edges.size();
+			const uint_t loop_begin = face_vertex;
 			for(uint_t vertex = vertex_begin; vertex != vertex_end; ++vertex, ++face_vertex)
 			{
-				polyhedron->vertex_points.push_back(point_offset + VertexIndices[face_vertex]);
-				polyhedron->vertex_selections.push_back(0.0);
-				polyhedron->clockwise_edges.push_back(polyhedron->clockwise_edges.size() + 1);
-				polyhedron->edge_selections.push_back(0.0);
+				polyhedron->vertex_points[face_vertex] = point_offset + VertexIndices[face_vertex];
+				polyhedron->clockwise_edges[face_vertex] = face_vertex + 1;
 			}
-			polyhedron->clockwise_edges.back() = loop_begin;
+			polyhedron->clockwise_edges[face_vertex - 1] = loop_begin;
 		}
 
 		return polyhedron;
@@ -1504,6 +1511,214 @@ void create_boundary_face_lookup(const mesh::indices_t& FaceFirstLoops, const me
 	}
 }
 
+namespace detail
+{
+
+/// Defines the number of arrays that define the topology of a polyhedron
+const uint_t topology_array_count = 5;
+
+/// Caches a topology index with a generic polyhedron primitive, along with the arrays it was created from
+class topology_index_cache :
+	public mesh::primitive::topology_cache
+{
+public:
+	boost::shared_ptr<const topology_index> index;
+	pipeline_data<array> arrays[topology_array_count];
+};
+
+/// Looks-up an array in a structure table, returning false if it doesn't exist
+bool_t get_topology_array(const mesh::primitive& Primitive, const string_t& TableName, const string_t& ArrayName, pipeline_data<array>& Array)
+{
+	mesh::named_tables_t::const_iterator table = Primitive.structure.find(TableName);
+	if(table == Primitive.structure.end())
+		return false;
+
+	mesh::table_t::const_iterator column = table->second.find(ArrayName);
+	if(column == table->second.end() || !dynamic_cast<const uint_t_array*>(column->second.get()))
+		return false;
+
+	Array = column->second;
+	return true;
+}
+
+/// Looks-up the arrays that define the topology of a polyhedron, returning false if any are missing
+bool_t get_topology_arrays(const mesh::primitive& Primitive, pipeline_data<array> (&Arrays)[topology_array_count])
+{
+	return get_topology_array(Primitive, "face", "face_first_loops", Arrays[0])
+		&& get_topology_array(Primitive, "face", "face_loop_counts", Arrays[1])
+		&& get_topology_array(Primitive, "loop", "loop_first_edges", Arrays[2])
+		&& get_topology_array(Primitive, "edge", "clockwise_edges", Arrays[3])
+		&& get_topology_array(Primitive, "vertex", "vertex_points", Arrays[4]);
+}
+
+/// Returns true iff two topology arrays store the same values
+bool_t equal_topology_arrays(const array& A, const array& B)
+{
+	const uint_t_array& a = dynamic_cast<const uint_t_array&>(A);
+	const uint_t_array& b = dynamic_cast<const uint_t_array&>(B);
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+/// Converts per-point counts into compressed-sparse-row offsets, with a final entry that stores the total count
+void create_row_offsets(const mesh::counts_t& Counts, mesh::indices_t& Offsets)
+{
+	Offsets.resize(Counts.size() + 1);
+	Offsets[0] = 0;
+	for(uint_t i = 0; i != Counts.size(); ++i)
+		Offsets[i + 1] = Offsets[i] + Counts[i];
+}
+
+/// Finds the companion for each edge in a range, using compressed-sparse-row out-edges
+class find_indexed_companion_worker
+{
+public:
+	find_indexed_companion_worker(const mesh::indices_t& VertexPoints, const mesh::indices_t& ClockwiseEdges, topology_index& Index) :
+		m_vertex_points(VertexPoints),
+		m_clockwise_edges(ClockwiseEdges),
+		m_index(Index)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<uint_t>& range) const
+	{
+		const uint_t edge_begin = range.begin();
+		const uint_t edge_end = range.end();
+		for(uint_t edge = edge_begin; edge != edge_end; ++edge)
+		{
+			const uint_t vertex1 = m_vertex_points[edge];
+			const uint_t vertex2 = m_vertex_points[m_clockwise_edges[edge]];
+
+			m_index.companions[edge] = edge;
+			m_index.boundary_edges[edge] = true;
+
+			const uint_t out_edge_end = m_index.point_first_out_edges[vertex2 + 1];
+			for(uint_t i = m_index.point_first_out_edges[vertex2]; i != out_edge_end; ++i)
+			{
+				const uint_t companion = m_index.point_out_edges[i];
+				if(m_vertex_points[m_clockwise_edges[companion]] == vertex1)
+				{
+					m_index.boundary_edges[edge] = false;
+					m_index.companions[edge] = companion;
+					break;
+				}
+			}
+		}
+	}
+
+private:
+	const mesh::indices_t& m_vertex_points;
+	const mesh::indices_t& m_clockwise_edges;
+	topology_index& m_index;
+};
+
+/// Initializes a topology index for a polyhedron
+void create_topology_index(const uint_t PointCount, const const_primitive& Polyhedron, topology_index& Index)
+{
+	const mesh::indices_t& vertex_points = Polyhedron.vertex_points;
+	const mesh::indices_t& clockwise_edges = Polyhedron.clockwise_edges;
+
+	const uint_t edge_begin = 0;
+	const uint_t edge_end = edge_begin + clockwise_edges.size();
+
+	Index.point_count = PointCount;
+
+	// Count in- and out-edges, then scatter edges into rows (preserving edge order within each row) ...
+	mesh::counts_t in_edge_counts(PointCount, 0);
+	Index.point_valences.assign(PointCount, 0);
+	for(uint_t edge = edge_begin; edge != edge_end; ++edge)
+	{
+		++Index.point_valences[vertex_points[edge]];
+		++in_edge_counts[vertex_points[clockwise_edges[edge]]];
+	}
+
+	create_row_offsets(Index.point_valences, Index.point_first_out_edges);
+	create_row_offsets(in_edge_counts, Index.point_first_in_edges);
+
+	Index.point_out_edges.resize(edge_end);
+	Index.point_in_edges.resize(edge_end);
+	mesh::indices_t out_edge_cursors(Index.point_first_out_edges.begin(), Index.point_first_out_edges.end() - 1);
+	mesh::indices_t in_edge_cursors(Index.point_first_in_edges.begin(), Index.point_first_in_edges.end() - 1);
+	for(uint_t edge = edge_begin; edge != edge_end; ++edge)
+	{
+		Index.point_out_edges[out_edge_cursors[vertex_points[edge]]++] = edge;
+		Index.point_in_edges[in_edge_cursors[vertex_points[clockwise_edges[edge]]]++] = edge;
+	}
+
+	Index.counterclockwise_edges.resize(edge_end);
+	for(uint_t edge = edge_begin; edge != edge_end; ++edge)
+		Index.counterclockwise_edges[clockwise_edges[edge]] = edge;
+
+	create_edge_face_lookup(Polyhedron, Index.edge_faces);
+
+	Index.companions.resize(edge_end);
+	Index.boundary_edges.resize(edge_end);
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<uint_t>(edge_begin, edge_end, k3d::parallel::grain_size()),
+		find_indexed_companion_worker(vertex_points, clockwise_edges, Index));
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+// get_topology_index
+
+boost::shared_ptr<const topology_index> get_topology_index(const mesh& Mesh, const mesh::primitive& GenericPrimitive)
+{
+	if(GenericPrimitive.type != "polyhedron")
+		return boost::shared_ptr<const topology_index>();
+
+	pipeline_data<array> arrays[detail::topology_array_count];
+	if(!detail::get_topology_arrays(GenericPrimitive, arrays))
+		return boost::shared_ptr<const topology_index>();
+
+	const uint_t point_count = Mesh.points ? Mesh.points->size() : 0;
+
+	// Reuse a cached index if it was created from the same arrays, or from arrays that store the same topology ...
+	const detail::topology_index_cache* const cache = dynamic_cast<const detail::topology_index_cache*>(GenericPrimitive.cached_topology.get());
+	if(cache && cache->index->point_count == point_count)
+	{
+		bool_t shared = true;
+		bool_t equal = true;
+		for(uint_t i = 0; i != detail::topology_array_count && equal; ++i)
+		{
+			if(arrays[i] == cache->arrays[i])
+				continue;
+
+			shared = false;
+			equal = detail::equal_topology_arrays(*arrays[i], *cache->arrays[i]);
+		}
+
+		if(shared)
+			return cache->index;
+
+		if(equal)
+		{
+			const boost::shared_ptr<const topology_index> index = cache->index;
+
+			detail::topology_index_cache* const new_cache = new detail::topology_index_cache();
+			new_cache->index = index;
+			std::copy(arrays, arrays + detail::topology_array_count, new_cache->arrays);
+			GenericPrimitive.cached_topology.create(new_cache);
+
+			return index;
+		}
+	}
+
+	boost::scoped_ptr<const const_primitive> polyhedron(validate(Mesh, GenericPrimitive));
+	if(!polyhedron)
+		return boost::shared_ptr<const topology_index>();
+
+	boost::shared_ptr<topology_index> index(new topology_index());
+	detail::create_topology_index(point_count, *polyhedron, *index);
+
+	detail::topology_index_cache* const new_cache = new detail::topology_index_cache();
+	new_cache->index = index;
+	std::copy(arrays, arrays + detail::topology_array_count, new_cache->arrays);
+	GenericPrimitive.cached_topology.create(new_cache);
+
+	return index;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 // mark_collinear_edges
 
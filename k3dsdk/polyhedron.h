@@ -234,6 +234,41 @@ void create_point_valence_lookup(const uint_t PointCount, const mesh::indices_t&
 /// Initialise boundary_faces array for constant time lookup of faces that are on the mesh boundary. BoundaryEdges and AdjacentEdges can be created using create_edge_adjacency_lookup
 void create_boundary_face_lookup(const mesh::indices_t& FaceFirstLoops, const mesh::indices_t& FaceLoopCounts, const mesh::indices_t& LoopFirstEdges, const mesh::indices_t& ClockwiseEdges, const mesh::bools_t& BoundaryEdges, const mesh::indices_t& AdjacentEdges, mesh::bools_t& BoundaryFaces);
 
+/// Stores the adjacency of a polyhedron in compressed-sparse-row form.  The edges adjacent to a point are stored
+/// contiguously in ascending order, so the out-edges of point P are point_out_edges[point_first_out_edges[P]] through
+/// point_out_edges[point_first_out_edges[P + 1] - 1].
+class topology_index
+{
+public:
+	/// Stores the number of points in the mesh when the index was created
+	uint_t point_count;
+	/// Stores the first out-edge of each point, plus a final entry that stores the total number of edges
+	mesh::indices_t point_first_out_edges;
+	/// Stores the edges that start at each point
+	mesh::indices_t point_out_edges;
+	/// Stores the first in-edge of each point, plus a final entry that stores the total number of edges
+	mesh::indices_t point_first_in_edges;
+	/// Stores the edges that end at each point
+	mesh::indices_t point_in_edges;
+	/// Stores the number of edges that start at each point
+	mesh::counts_t point_valences;
+	/// Stores the companion (adjacent) edge for each edge, or the edge itself for boundary edges
+	mesh::indices_t companions;
+	/// Stores true for each edge that doesn't have a companion
+	mesh::bools_t boundary_edges;
+	/// Stores the counterclockwise edge for each edge
+	mesh::indices_t counterclockwise_edges;
+	/// Stores the face that owns each edge
+	mesh::indices_t edge_faces;
+};
+
+/// Returns a topology index for the given polyhedron primitive, or NULL if the primitive isn't a valid polyhedron.  The index is
+/// cached with the primitive, so it is shared by every node whose input contains the same primitive, and reused until the primitive
+/// topology changes (typically because a node received hint::mesh_topology_changed and recreated its output).  Copies of a primitive
+/// whose topology arrays were duplicated (e.g. by the writable version of validate()) reuse the index after a linear comparison.
+/// Call this before the writable version of validate() to avoid the comparison.  Not thread-safe for a single primitive.
+boost::shared_ptr<const topology_index> get_topology_index(const mesh& Mesh, const mesh::primitive& GenericPrimitive);
+
 /// Adds edges that are collinear and with points of valence 1 for boundary edges or valence 2 otherwise to EdgeList
 void mark_collinear_edges(mesh::indices_t& RedundantEdges, const mesh::selection_t& EdgeSelection, const mesh::points_t& Points, const mesh::indices_t& VertexPoints, const mesh::indices_t& ClockwiseEdges, const mesh::counts_t& VertexValences, const mesh::bools_t& BoundaryEdges, const mesh::indices_t& AdjacentEdges, const double_t Threshold = 1e-8);
 
@@ -0,0 +1,407 @@
+#ifndef K3DSDK_PYTHON_ARRAY_BUFFER_PYTHON_H
+#define K3DSDK_PYTHON_ARRAY_BUFFER_PYTHON_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\brief Exposes numeric arrays to Python using the buffer protocol, so they can be shared with NumPy without copying.
+	\author Timothy M. Shead (tshead@k-3d.com)
+*/
+
+#include <boost/mpl/bool.hpp>
+#include <boost/python.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+#include <k3dsdk/python/instance_wrapper_python.h>
+
+#include <k3dsdk/algebra.h>
+#include <k3dsdk/color.h>
+#include <k3dsdk/normal3.h>
+#include <k3dsdk/point2.h>
+#include <k3dsdk/point3.h>
+#include <k3dsdk/point4.h>
+#include <k3dsdk/texture3.h>
+#include <k3dsdk/vector2.h>
+#include <k3dsdk/vector3.h>
+
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace k3d
+{
+
+namespace python
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// buffer_traits
+
+/// Describes how the values stored in an array map to a buffer of scalars.  Types without a specialization can't be exposed as buffers.
+template<typename value_t>
+class buffer_traits
+{
+public:
+	static const bool_t supported = false;
+};
+
+#define K3D_PYTHON_BUFFER_TRAITS(value_t, scalar_t, Components, Format) \
+template<> \
+class buffer_traits<value_t> \
+{ \
+public: \
+	static const bool_t supported = true; \
+	typedef scalar_t scalar_type; \
+	static const uint_t components = Components; \
+	static const char* format() { return Format; } \
+	BOOST_STATIC_ASSERT(sizeof(value_t) == Components * sizeof(scalar_t)); \
+};
+
+K3D_PYTHON_BUFFER_TRAITS(double_t, double_t, 1, "d")
+K3D_PYTHON_BUFFER_TRAITS(int8_t, int8_t, 1, "b")
+K3D_PYTHON_BUFFER_TRAITS(int16_t, int16_t, 1, "h")
+K3D_PYTHON_BUFFER_TRAITS(int32_t, int32_t, 1, "i")
+K3D_PYTHON_BUFFER_TRAITS(int64_t, int64_t, 1, "q")
+K3D_PYTHON_BUFFER_TRAITS(uint8_t, uint8_t, 1, "B")
+K3D_PYTHON_BUFFER_TRAITS(uint16_t, uint16_t, 1, "H")
+K3D_PYTHON_BUFFER_TRAITS(uint32_t, uint32_t, 1, "I")
+K3D_PYTHON_BUFFER_TRAITS(uint64_t, uint64_t, 1, "Q")
+K3D_PYTHON_BUFFER_TRAITS(color, double_t, 3, "d")
+K3D_PYTHON_BUFFER_TRAITS(matrix4, double_t, 16, "d")
+K3D_PYTHON_BUFFER_TRAITS(normal3, double_t, 3, "d")
+K3D_PYTHON_BUFFER_TRAITS(point2, double_t, 2, "d")
+K3D_PYTHON_BUFFER_TRAITS(point3, double_t, 3, "d")
+K3D_PYTHON_BUFFER_TRAITS(point4, double_t, 4, "d")
+K3D_PYTHON_BUFFER_TRAITS(texture3, double_t, 3, "d")
+K3D_PYTHON_BUFFER_TRAITS(vector2, double_t, 2, "d")
+K3D_PYTHON_BUFFER_TRAITS(vector3, double_t, 3, "d")
+
+#undef K3D_PYTHON_BUFFER_TRAITS
+
+namespace detail
+{
+
+/// Copies scalars of one type into an array of another, converting each one
+template<typename source_t, typename target_t>
+void convert_scalars(const char* Source, const uint_t Count, target_t* Target)
+{
+	for(uint_t i = 0; i != Count; ++i)
+	{
+		source_t value;
+		std::memcpy(&value, Source + i * sizeof(source_t), sizeof(source_t));
+		Target[i] = static_cast<target_t>(value);
+	}
+}
+
+/// Copies a contiguous buffer of scalars described by a buffer-protocol format string into an array of scalars, converting as-necessary
+template<typename target_t>
+void convert_scalars(const char* Format, const uint_t ItemSize, const char* Source, const uint_t Count, target_t* Target)
+{
+	const char* format = Format ? Format : "B";
+
+	// We only handle native byte-order ...
+	const uint16_t byte_order_test = 1;
+	const char native_order = *reinterpret_cast<const char*>(&byte_order_test) ? '<' : '>';
+	if(*format == '@' || *format == '=' || *format == native_order)
+		++format;
+
+	if(std::strlen(format) != 1)
+		throw std::invalid_argument("unsupported buffer format: " + string_t(Format));
+
+	switch(*format)
+	{
+		case 'f':
+			if(ItemSize == sizeof(float))
+				return convert_scalars<float>(Source, Count, Target);
+			break;
+		case 'd':
+			if(ItemSize == sizeof(double))
+				return convert_scalars<double>(Source, Count, Target);
+			break;
+		case '?':
+			if(ItemSize == sizeof(uint8_t))
+				return convert_scalars<uint8_t>(Source, Count, Target);
+			break;
+		case 'b':
+		case 'h':
+		case 'i':
+		case 'l':
+		case 'q':
+			switch(ItemSize)
+			{
+				case 1: return convert_scalars<int8_t>(Source, Count, Target);
+				case 2: return convert_scalars<int16_t>(Source, Count, Target);
+				case 4: return convert_scalars<int32_t>(Source, Count, Target);
+				case 8: return convert_scalars<int64_t>(Source, Count, Target);
+			}
+			break;
+		case 'B':
+		case 'H':
+		case 'I':
+		case 'L':
+		case 'Q':
+			switch(ItemSize)
+			{
+				case 1: return convert_scalars<uint8_t>(Source, Count, Target);
+				case 2: return convert_scalars<uint16_t>(Source, Count, Target);
+				case 4: return convert_scalars<uint32_t>(Source, Count, Target);
+				case 8: return convert_scalars<uint64_t>(Source, Count, Target);
+			}
+			break;
+	}
+
+	throw std::invalid_argument("unsupported buffer format: " + string_t(Format));
+}
+
+/// Returns the number of buffers currently exported for each array, so arrays can't be resized while views refer to their storage
+inline std::map<const void*, uint_t>& buffer_exports()
+{
+	static std::map<const void*, uint_t> exports;
+	return exports;
+}
+
+/// Releases a Py_buffer when it goes out of scope
+class scoped_buffer
+{
+public:
+	scoped_buffer(PyObject* const Object)
+	{
+		if(-1 == PyObject_GetBuffer(Object, &view, PyBUF_STRIDES | PyBUF_FORMAT))
+			boost::python::throw_error_already_set();
+	}
+
+	~scoped_buffer()
+	{
+		PyBuffer_Release(&view);
+	}
+
+	Py_buffer view;
+};
+
+} // namespace detail
+
+/// Raises BufferError if buffers exported from an array are still in use, since resizing the array could invalidate them.
+/// Like Python's bytearray, arrays can't be resized while they're viewed.
+inline void require_resizable(const void* const Array)
+{
+	if(detail::buffer_exports().count(Array))
+	{
+		PyErr_SetString(PyExc_BufferError, "Existing exports of data: array cannot be re-sized");
+		boost::python::throw_error_already_set();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// array_buffer
+
+/// Implements the Python buffer protocol for a wrapped array type, so that arrays can be viewed (e.g. with numpy.asarray() or memoryview())
+/// without copying.  Arrays of values with more than one component (such as points) are exposed as two-dimensional buffers.
+/// Const arrays are exposed as read-only buffers.  Views refer directly to array storage, so arrays can't be resized from Python
+/// while they're viewed (see require_resizable()), and views become invalid if the array is destroyed.
+template<typename array_type>
+class array_buffer
+{
+	typedef typename boost::remove_const<array_type>::type mutable_array_type;
+	typedef typename mutable_array_type::value_type value_type;
+	typedef buffer_traits<value_type> traits;
+	typedef typename traits::scalar_type scalar_type;
+	typedef instance_wrapper<array_type> wrapper_type;
+
+public:
+	/// Adds buffer-protocol support to a Python class that wraps array_type
+	static void define(const boost::python::object& Class)
+	{
+		static PyBufferProcs buffer_procs;
+		std::memset(&buffer_procs, 0, sizeof(buffer_procs));
+		buffer_procs.bf_getbuffer = &get_buffer;
+		buffer_procs.bf_releasebuffer = &release_buffer;
+
+		PyTypeObject* const type = reinterpret_cast<PyTypeObject*>(Class.ptr());
+		type->tp_as_buffer = &buffer_procs;
+#ifdef Py_TPFLAGS_HAVE_NEWBUFFER
+		type->tp_flags |= Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+		PyType_Modified(type);
+	}
+
+	/// Replaces the contents of an array with the contents of any object that supports the buffer protocol, converting scalar types as-needed
+	static void assign(mutable_array_type& Array, const boost::python::object& Buffer)
+	{
+		detail::scoped_buffer buffer(Buffer.ptr());
+		const Py_buffer& view = buffer.view;
+
+		const uint_t item_size = view.itemsize;
+		const uint_t scalar_count = item_size ? view.len / item_size : 0;
+		if(scalar_count % traits::components)
+			throw std::invalid_argument("buffer size must be a multiple of the value size");
+		if(view.ndim > 1 && view.shape && uint_t(view.shape[view.ndim - 1]) != traits::components)
+			throw std::invalid_argument("buffer shape doesn't match the value size");
+
+		// Gather non-contiguous buffers (e.g. NumPy slices) before converting ...
+		std::vector<char> contiguous;
+		const char* source = static_cast<const char*>(view.buf);
+		if(!PyBuffer_IsContiguous(const_cast<Py_buffer*>(&view), 'C'))
+		{
+			contiguous.resize(view.len);
+			if(-1 == PyBuffer_ToContiguous(&contiguous[0], const_cast<Py_buffer*>(&view), view.len, 'C'))
+				boost::python::throw_error_already_set();
+			source = &contiguous[0];
+		}
+
+		Array.resize(scalar_count / traits::components);
+		if(!scalar_count)
+			return;
+
+		scalar_type* const target = reinterpret_cast<scalar_type*>(&Array[0]);
+		if(view.format && string_t(view.format) == traits::format() && item_size == sizeof(scalar_type))
+			std::memcpy(target, source, view.len);
+		else
+			detail::convert_scalars(view.format, item_size, source, scalar_count, target);
+	}
+
+private:
+	static int get_buffer(PyObject* Self, Py_buffer* View, int Flags)
+	{
+		View->obj = 0;
+
+		try
+		{
+			boost::python::extract<wrapper_type&> self(Self);
+			if(!self.check())
+			{
+				PyErr_SetString(PyExc_TypeError, "object doesn't wrap an array");
+				return -1;
+			}
+
+			const bool_t read_only = boost::is_const<array_type>::value;
+			if(read_only && (Flags & PyBUF_WRITABLE) == PyBUF_WRITABLE)
+			{
+				PyErr_SetString(PyExc_BufferError, "array is read-only");
+				return -1;
+			}
+
+			array_type& array = self().wrapped();
+
+			// Shape and strides must remain valid until the buffer is released ...
+			Py_ssize_t* const shape = new Py_ssize_t[4];
+			Py_ssize_t* const strides = shape + 2;
+			shape[0] = array.size();
+			shape[1] = traits::components;
+			strides[0] = sizeof(value_type);
+			strides[1] = sizeof(scalar_type);
+
+			View->buf = array.size() ? const_cast<value_type*>(&array[0]) : static_cast<void*>(shape);
+			View->obj = Self;
+			Py_INCREF(Self);
+			View->len = array.size() * sizeof(value_type);
+			View->readonly = read_only;
+			View->itemsize = sizeof(scalar_type);
+			View->format = (Flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char*>(traits::format()) : 0;
+			View->ndim = traits::components == 1 ? 1 : 2;
+			View->shape = (Flags & PyBUF_ND) == PyBUF_ND ? shape : 0;
+			View->strides = (Flags & PyBUF_STRIDES) == PyBUF_STRIDES ? strides : 0;
+			View->suboffsets = 0;
+			View->internal = shape;
+
+			++detail::buffer_exports()[&array];
+
+			return 0;
+		}
+		catch(std::exception& e)
+		{
+			PyErr_SetString(PyExc_BufferError, e.what());
+			return -1;
+		}
+	}
+
+	static void release_buffer(PyObject* Self, Py_buffer* View)
+	{
+		delete[] static_cast<Py_ssize_t*>(View->internal);
+		View->internal = 0;
+
+		boost::python::extract<wrapper_type&> self(Self);
+		if(!self.check())
+			return;
+
+		std::map<const void*, uint_t>& exports = detail::buffer_exports();
+		const std::map<const void*, uint_t>::iterator exported = exports.find(&self().wrapped());
+		if(exported != exports.end() && !--exported->second)
+			exports.erase(exported);
+	}
+};
+
+namespace detail
+{
+
+template<typename array_type>
+void define_array_buffer(const boost::python::object& Class, boost::mpl::true_)
+{
+	array_buffer<array_type>::define(Class);
+}
+
+template<typename array_type>
+void define_array_buffer(const boost::python::object& Class, boost::mpl::false_)
+{
+}
+
+template<typename array_type>
+bool_t assign_array_buffer(array_type& Array, const boost::python::object& Buffer, boost::mpl::true_)
+{
+	if(!PyObject_CheckBuffer(Buffer.ptr()))
+		return false;
+
+	array_buffer<array_type>::assign(Array, Buffer);
+	return true;
+}
+
+template<typename array_type>
+bool_t assign_array_buffer(array_type& Array, const boost::python::object& Buffer, boost::mpl::false_)
+{
+	return false;
+}
+
+} // namespace detail
+
+/// Adds buffer-protocol support to a Python class that wraps array_type, if the array values are numeric
+template<typename array_type>
+void define_array_buffer(const boost::python::object& Class)
+{
+	typedef typename boost::remove_const<array_type>::type::value_type value_type;
+	detail::define_array_buffer<array_type>(Class, boost::mpl::bool_<buffer_traits<value_type>::supported>());
+}
+
+/// Replaces the contents of an array with the contents of a buffer-protocol object, returning false if the object isn't
+/// a buffer or the array values aren't numeric
+template<typename array_type>
+bool_t assign_array_buffer(array_type& Array, const boost::python::object& Buffer)
+{
+	typedef typename array_type::value_type value_type;
+	return detail::assign_array_buffer(Array, Buffer, boost::mpl::bool_<buffer_traits<value_type>::supported>());
+}
+
+} // namespace python
+
+} // namespace k3d
+
+#endif // !K3DSDK_PYTHON_ARRAY_BUFFER_PYTHON_H
+
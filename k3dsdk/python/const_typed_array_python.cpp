@@ -23,6 +23,7 @@
 
 #include <boost/python.hpp>
 
+#include <k3dsdk/python/array_buffer_python.h>
 #include <k3dsdk/python/const_typed_array_python.h>
 #include <k3dsdk/python/utility_python.h>
 
@@ -87,13 +88,15 @@ static void define_class_const_typed_array(const char* const ClassName, const ch
 {
 	typedef instance_wrapper<array_type> wrapper_type;
 
-	boost::python::class_<wrapper_type>(ClassName, DocString, boost::python::no_init)
+	const boost::python::object array_class = boost::python::class_<wrapper_type>(ClassName, DocString, boost::python::no_init)
 		.def("__len__", &utility::wrapped_len<wrapper_type>)
 		.def("__getitem__", &utility::wrapped_get_item<wrapper_type, typename array_type::value_type>)
 		.def("__str__", &array_str<wrapper_type>)
 		.def("get_metadata_value", &get_metadata_value<wrapper_type>)
 		.def("get_metadata", &get_metadata<wrapper_type>)
 		;
+
+	define_array_buffer<array_type>(array_class);
 }
 
 template<>
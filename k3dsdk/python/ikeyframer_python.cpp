@@ -28,6 +28,7 @@
 #include <k3dsdk/python/iunknown_python.h>
 #include <k3dsdk/python/utility_python.h>
 
+#include <k3dsdk/algebra.h>
 #include <k3dsdk/ikeyframer.h>
 
 using namespace boost::python;
@@ -63,6 +64,32 @@ static list get_keys(iunknown_wrapper& Self)
 	return results;
 }
 
+template<typename value_t>
+static bool_t sample_values(iunknown_wrapper& Self, const double_t Start, const double_t Step, const uint_t Count, list& Results)
+{
+	k3d::ikeyframe_sampler<double_t, value_t>* const sampler = Self.wrapped_ptr<k3d::ikeyframe_sampler<double_t, value_t> >();
+	if(!sampler)
+		return false;
+
+	std::vector<value_t> values;
+	sampler->sample(Start, Step, Count, values);
+	for(uint_t i = 0; i != values.size(); ++i)
+		Results.append(values[i]);
+
+	return true;
+}
+
+static list sample(iunknown_wrapper& Self, const double_t Start, const double_t Step, const uint_t Count)
+{
+	list results;
+	if(sample_values<double_t>(Self, Start, Step, Count, results))
+		return results;
+	if(sample_values<matrix4>(Self, Start, Step, Count, results))
+		return results;
+
+	throw std::invalid_argument("unsupported keyframe sampler type");
+}
+
 void define_methods_ikeyframer(iunknown& Interface, boost::python::object& Instance)
 {
 	if(!dynamic_cast<k3d::ikeyframer*>(&Interface))
@@ -78,6 +105,17 @@ void define_methods_ikeyframer(iunknown& Interface, boost::python::object& Insta
 		"@return: The input property.\n\n"), "input_property", Instance);
 	utility::add_method(utility::make_function(&get_keys,
 		"Returns a list with all the time properties for the keyframes."), "get_keys", Instance);
+
+	if(!dynamic_cast<k3d::ikeyframe_sampler<double_t, double_t>*>(&Interface) && !dynamic_cast<k3d::ikeyframe_sampler<double_t, matrix4>*>(&Interface))
+		return;
+
+	utility::add_method(utility::make_function(&sample,
+		"Samples the channel at evenly-spaced times.\n\n"
+		"@param start: The first time to sample.\n"
+		"@param step: The interval between samples.\n"
+		"@param count: The number of samples.\n"
+		"@rtype: list\n"
+		"@return: The channel value at each time.\n\n"), "sample", Instance);
 }
 
 } // namespace python
@@ -37,6 +37,7 @@ class matrix4;
 namespace ri
 {
 
+class archive_cache;
 class istream;
 class ishader_collection;
 	
@@ -52,7 +53,8 @@ public:
 		render_context(RenderContext),
 		sample_times(SampleTimes),
 		sample_index(SampleIndex),
-		camera_matrix(CameraMatrix)
+		camera_matrix(CameraMatrix),
+		archives(0)
 	{
 	}
 
@@ -64,6 +66,8 @@ public:
 	sample_times_t sample_times;
 	unsigned_integer sample_index;
 	matrix4 camera_matrix;
+	/// Optional storage for geometry archives shared among the frames of an animation, may be NULL
+	archive_cache* archives;
 };
 
 } // namespace ri
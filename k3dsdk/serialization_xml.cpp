@@ -22,7 +22,9 @@
 */
 
 #include <k3dsdk/array.h>
+#include <k3dsdk/base64.h>
 #include <k3dsdk/classes.h>
+#include <k3dsdk/file_helpers.h>
 #include <k3dsdk/idocument.h>
 #include <k3dsdk/imaterial.h>
 #include <k3dsdk/imesh_painter_gl.h>
@@ -55,9 +57,15 @@
 #include <k3dsdk/xpath.h>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/mpl/bool.hpp>
 #include <boost/mpl/for_each.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <zlib.h>
+
 namespace k3d
 {
 
@@ -1421,23 +1429,152 @@ void save_array_metadata(element& Storage, const array& Array, const ipersistent
 		xml_metadata.append(element("pair", attribute("name", pair->first), pair->second));
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// save_array_count
+
+/// Stores the number of items in an array, so they can be preallocated at load time
+void save_array_count(element& Storage, const uint_t Count)
+{
+	Storage.append(attribute("count", Count));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// binary_array_traits
+
+/// Describes how the values in an array are stored using binary encoding, as a sequence of little-endian scalars.
+/// Arrays of values that can't be stored this way (strings, pointers, and bools) are always stored as text.
+template<typename value_t>
+class binary_array_traits
+{
+public:
+	typedef boost::mpl::bool_<false> supported;
+	typedef value_t scalar_type;
+};
+
+#define K3D_BINARY_ARRAY_TRAITS(value_t, scalar_t) \
+template<> \
+class binary_array_traits<value_t> \
+{ \
+public: \
+	typedef boost::mpl::bool_<true> supported; \
+	typedef scalar_t scalar_type; \
+};
+
+K3D_BINARY_ARRAY_TRAITS(color, double_t)
+K3D_BINARY_ARRAY_TRAITS(double_t, double_t)
+K3D_BINARY_ARRAY_TRAITS(int16_t, int16_t)
+K3D_BINARY_ARRAY_TRAITS(int32_t, int32_t)
+K3D_BINARY_ARRAY_TRAITS(int64_t, int64_t)
+K3D_BINARY_ARRAY_TRAITS(int8_t, int8_t)
+K3D_BINARY_ARRAY_TRAITS(matrix4, double_t)
+K3D_BINARY_ARRAY_TRAITS(normal3, double_t)
+K3D_BINARY_ARRAY_TRAITS(point2, double_t)
+K3D_BINARY_ARRAY_TRAITS(point3, double_t)
+K3D_BINARY_ARRAY_TRAITS(point4, double_t)
+K3D_BINARY_ARRAY_TRAITS(texture3, double_t)
+K3D_BINARY_ARRAY_TRAITS(uint16_t, uint16_t)
+K3D_BINARY_ARRAY_TRAITS(uint32_t, uint32_t)
+K3D_BINARY_ARRAY_TRAITS(uint64_t, uint64_t)
+K3D_BINARY_ARRAY_TRAITS(uint8_t, uint8_t)
+K3D_BINARY_ARRAY_TRAITS(vector2, double_t)
+K3D_BINARY_ARRAY_TRAITS(vector3, double_t)
+
+#undef K3D_BINARY_ARRAY_TRAITS
+
+/// Arrays smaller than this are always stored as text, for legibility
+static const uint_t binary_array_threshold = 16;
+
+/// Reverses the byte order of a buffer of scalars in-place
+void swap_bytes(char* const Data, const uint_t ScalarSize, const uint_t ScalarCount)
+{
+	for(char* scalar = Data; scalar != Data + (ScalarSize * ScalarCount); scalar += ScalarSize)
+		std::reverse(scalar, scalar + ScalarSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// save_binary_data
+
+/// Stores a buffer of native-endian scalars as little-endian base64 text, compressing it if requested
+void save_binary_data(element& Storage, const char* const Data, const uint_t ScalarSize, const uint_t ScalarCount, const ipersistent::save_context& Context)
+{
+	std::string buffer(Data, Data + (ScalarSize * ScalarCount));
+	if(big_endian())
+		swap_bytes(&buffer[0], ScalarSize, ScalarCount);
+
+	if(Context.array_encoding == ipersistent::save_context::COMPRESSED_BINARY_ARRAYS)
+	{
+		uLongf compressed_size = compressBound(buffer.size());
+		std::string compressed(compressed_size, '\0');
+		if(Z_OK == compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size, reinterpret_cast<const Bytef*>(buffer.data()), buffer.size(), Z_DEFAULT_COMPRESSION))
+		{
+			compressed.resize(compressed_size);
+			buffer.swap(compressed);
+			Storage.append(attribute("compression", "zlib"));
+		}
+		else
+		{
+			log() << warning << k3d_file_reference << ": error compressing array, it will be stored uncompressed" << std::endl;
+		}
+	}
+
+	std::istringstream input(buffer);
+	std::ostringstream output;
+	base64::encode(input, output);
+
+	Storage.append(attribute("encoding", "base64"));
+	Storage.text = "\n" + output.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// save_binary_array
+
+/// Stores an array using binary encoding, if the save context and array type allow it.  Returns false for arrays that must be stored as text.
+template<typename array_type>
+bool_t save_binary_array(element& Storage, const array_type& Array, const ipersistent::save_context& Context, boost::mpl::bool_<true>)
+{
+	if(Context.array_encoding == ipersistent::save_context::TEXT_ARRAYS || Array.size() < binary_array_threshold)
+		return false;
+
+	typedef typename binary_array_traits<typename array_type::value_type>::scalar_type scalar_type;
+	save_binary_data(Storage, reinterpret_cast<const char*>(&Array[0]), sizeof(scalar_type), Array.size() * sizeof(typename array_type::value_type) / sizeof(scalar_type), Context);
+	return true;
+}
+
+template<typename array_type>
+bool_t save_binary_array(element& Storage, const array_type& Array, const ipersistent::save_context& Context, boost::mpl::bool_<false>)
+{
+	return false;
+}
+
+template<typename array_type>
+bool_t save_binary_array(element& Storage, const array_type& Array, const ipersistent::save_context& Context)
+{
+	return save_binary_array(Storage, Array, Context, typename binary_array_traits<typename array_type::value_type>::supported());
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // save_array
 
 template<typename array_type>
 void save_array(element& Container, element Storage, const array_type& Array, const ipersistent::save_context& Context)
 {
-	typename array_type::const_iterator item = Array.begin();
-	const typename array_type::const_iterator end = Array.end();
+	save_array_count(Storage, Array.size());
 
-	std::ostringstream buffer;
+	if(!save_binary_array(Storage, Array, Context))
+	{
+		typename array_type::const_iterator item = Array.begin();
+		const typename array_type::const_iterator end = Array.end();
 
-	if(item != end)
-		buffer << *item++;
-	for(; item != end; ++item)
-		buffer << " " << *item;
+		std::ostringstream buffer;
+
+		if(item != end)
+			buffer << *item++;
+		for(; item != end; ++item)
+			buffer << " " << *item;
+
+		Storage.text = buffer.str();
+	}
 
-	Storage.text = buffer.str();
 	save_array_metadata(Storage, Array, Context);
 
 	Container.append(Storage);
@@ -1451,17 +1588,23 @@ void save_array(element& Container, element Storage, const typed_array<int8_t>&
 {
 	typedef typed_array<int8_t> array_type;
 
-	array_type::const_iterator item = Array.begin();
-	const array_type::const_iterator end = Array.end();
+	save_array_count(Storage, Array.size());
 
-	std::ostringstream buffer;
+	if(!save_binary_array(Storage, Array, Context))
+	{
+		array_type::const_iterator item = Array.begin();
+		const array_type::const_iterator end = Array.end();
 
-	if(item != end)
-		buffer << static_cast<int16_t>(*item++);
-	for(; item != end; ++item)
-		buffer << " " << static_cast<int16_t>(*item);
+		std::ostringstream buffer;
+
+		if(item != end)
+			buffer << static_cast<int16_t>(*item++);
+		for(; item != end; ++item)
+			buffer << " " << static_cast<int16_t>(*item);
+
+		Storage.text = buffer.str();
+	}
 
-	Storage.text = buffer.str();
 	save_array_metadata(Storage, Array, Context);
 
 	Container.append(Storage);
@@ -1475,17 +1618,56 @@ void save_array(element& Container, element Storage, const typed_array<uint8_t>&
 {
 	typedef typed_array<uint8_t> array_type;
 
-	array_type::const_iterator item = Array.begin();
-	const array_type::const_iterator end = Array.end();
+	save_array_count(Storage, Array.size());
 
-	std::ostringstream buffer;
+	if(!save_binary_array(Storage, Array, Context))
+	{
+		array_type::const_iterator item = Array.begin();
+		const array_type::const_iterator end = Array.end();
 
-	if(item != end)
-		buffer << static_cast<uint16_t>(*item++);
-	for(; item != end; ++item)
-		buffer << " " << static_cast<uint16_t>(*item);
+		std::ostringstream buffer;
+
+		if(item != end)
+			buffer << static_cast<uint16_t>(*item++);
+		for(; item != end; ++item)
+			buffer << " " << static_cast<uint16_t>(*item);
+
+		Storage.text = buffer.str();
+	}
+
+	save_array_metadata(Storage, Array, Context);
+
+	Container.append(Storage);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// save_array
+
+/// Specialization of save_array to ensure that binary indices are always stored as 64-bit values
+void save_array(element& Container, element Storage, const uint_t_array& Array, const ipersistent::save_context& Context)
+{
+	save_array_count(Storage, Array.size());
+
+	if(Context.array_encoding != ipersistent::save_context::TEXT_ARRAYS && Array.size() >= binary_array_threshold)
+	{
+		const std::vector<uint64_t> buffer(Array.begin(), Array.end());
+		save_binary_data(Storage, reinterpret_cast<const char*>(&buffer[0]), sizeof(uint64_t), buffer.size(), Context);
+	}
+	else
+	{
+		uint_t_array::const_iterator item = Array.begin();
+		const uint_t_array::const_iterator end = Array.end();
+
+		std::ostringstream buffer;
+
+		if(item != end)
+			buffer << *item++;
+		for(; item != end; ++item)
+			buffer << " " << *item;
+
+		Storage.text = buffer.str();
+	}
 
-	Storage.text = buffer.str();
 	save_array_metadata(Storage, Array, Context);
 
 	Container.append(Storage);
@@ -1499,6 +1681,8 @@ void save_array(element& Container, element Storage, const typed_array<string_t>
 {
 	typedef typed_array<string_t> array_type;
 
+	save_array_count(Storage, Array.size());
+
 	const array_type::const_iterator end = Array.end();
 	for(array_type::const_iterator item = Array.begin(); item != end; ++item)
 		Storage.append(element("value", *item));
@@ -1516,18 +1700,24 @@ void save_array(element& Container, element Storage, const typed_array<double_t>
 {
 	typedef typed_array<double_t> array_type;
 
-	array_type::const_iterator item = Array.begin();
-	const array_type::const_iterator end = Array.end();
+	save_array_count(Storage, Array.size());
 
-	std::ostringstream buffer;
-	buffer << std::setprecision(17);
+	if(!save_binary_array(Storage, Array, Context))
+	{
+		array_type::const_iterator item = Array.begin();
+		const array_type::const_iterator end = Array.end();
 
-	if(item != end)
-		buffer << *item++;
-	for(; item != end; ++item)
-		buffer << " " << *item;
+		std::ostringstream buffer;
+		buffer << std::setprecision(17);
+
+		if(item != end)
+			buffer << *item++;
+		for(; item != end; ++item)
+			buffer << " " << *item;
+
+		Storage.text = buffer.str();
+	}
 
-	Storage.text = buffer.str();
 	save_array_metadata(Storage, Array, Context);
 
 	Container.append(Storage);
@@ -1540,6 +1730,8 @@ void save_array(element& Container, element Storage, const typed_array<imaterial
 {
 	typedef typed_array<imaterial*> array_type;
 
+	save_array_count(Storage, Array.size());
+
 	array_type::const_iterator item = Array.begin();
 	const array_type::const_iterator end = Array.end();
 
@@ -1683,23 +1875,163 @@ void load_array_metadata(const element& Storage, array& Array, const ipersistent
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// load_array_count
+
+/// Returns the number of items stored in an array, or zero for documents that predate storing the count
+const uint_t load_array_count(const element& Storage)
+{
+	return attribute_value<uint_t>(Storage, "count", 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// load_array_reserve
+
+/// Returns the number of items to reserve for an array stored as text.  The stored count is untrusted, so it's limited to the
+/// number of values the text could possibly contain.
+const uint_t load_array_reserve(const element& Storage)
+{
+	return std::min(load_array_count(Storage), uint_t(Storage.text.size() / 2 + 1));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// load_binary_data
+
+/// Retrieves a buffer of native-endian scalars stored by save_binary_data(), which must contain exactly ScalarCount scalars.
+/// The count comes from the document, so it's validated before anything is allocated.  Returns false if the stored data is corrupt.
+const bool_t load_binary_data(const element& Storage, const uint_t ScalarSize, const uint_t ScalarCount, std::string& Data)
+{
+	if(!ScalarSize || ScalarCount > std::numeric_limits<uint_t>::max() / ScalarSize)
+	{
+		log() << error << k3d_file_reference << ": invalid array count [" << ScalarCount << "]" << std::endl;
+		return false;
+	}
+
+	const uint_t expected_size = ScalarSize * ScalarCount;
+
+	std::istringstream input(Storage.text);
+	std::ostringstream output;
+	base64::decode(input, output);
+	std::string buffer = output.str();
+
+	const string_t compression = attribute_text(Storage, "compression");
+	if(compression == "zlib")
+	{
+		// zlib can't compress by more than 1032:1, so a larger count can't be genuine, and mustn't be allocated ...
+		if(expected_size / 1032 > buffer.size())
+		{
+			log() << error << k3d_file_reference << ": expected " << expected_size << " bytes of array data, found " << buffer.size() << " compressed bytes" << std::endl;
+			return false;
+		}
+
+		uLongf uncompressed_size = expected_size;
+		std::string uncompressed(expected_size, '\0');
+		if(Z_OK != uncompress(reinterpret_cast<Bytef*>(&uncompressed[0]), &uncompressed_size, reinterpret_cast<const Bytef*>(buffer.data()), buffer.size()) || uncompressed_size != expected_size)
+		{
+			log() << error << k3d_file_reference << ": error decompressing array data" << std::endl;
+			return false;
+		}
+		buffer.swap(uncompressed);
+	}
+	else if(!compression.empty())
+	{
+		log() << error << k3d_file_reference << ": unknown array compression [" << compression << "]" << std::endl;
+		return false;
+	}
+
+	if(buffer.size() != expected_size)
+	{
+		log() << error << k3d_file_reference << ": expected " << expected_size << " bytes of array data, found " << buffer.size() << std::endl;
+		return false;
+	}
+
+	if(big_endian() && buffer.size())
+		swap_bytes(&buffer[0], ScalarSize, ScalarCount);
+
+	Data.swap(buffer);
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// load_binary_array
+
+/// Loads an array stored using binary encoding.  Returns false for arrays stored as text.
+template<typename array_type>
+bool_t load_binary_array(const element& Storage, array_type& Array, const ipersistent::load_context& Context, boost::mpl::bool_<true>)
+{
+	const string_t encoding = attribute_text(Storage, "encoding");
+	if(encoding.empty())
+		return false;
+
+	if(encoding != "base64")
+	{
+		log() << error << k3d_file_reference << ": unknown array encoding [" << encoding << "]" << std::endl;
+		return true;
+	}
+
+	const uint_t count = load_array_count(Storage);
+	if(!count)
+		return true;
+
+	typedef typename array_type::value_type value_type;
+	typedef typename binary_array_traits<value_type>::scalar_type scalar_type;
+	const uint_t components = sizeof(value_type) / sizeof(scalar_type);
+	if(count > std::numeric_limits<uint_t>::max() / components)
+	{
+		log() << error << k3d_file_reference << ": invalid array count [" << count << "]" << std::endl;
+		return true;
+	}
+
+	// Decode first, so a corrupt count can't allocate more than the document actually contains ...
+	std::string data;
+	if(!load_binary_data(Storage, sizeof(scalar_type), count * components, data))
+		return true;
+
+	Array.resize(count);
+	std::memcpy(&Array[0], data.data(), data.size());
+
+	return true;
+}
+
+template<typename array_type>
+bool_t load_binary_array(const element& Storage, array_type& Array, const ipersistent::load_context& Context, boost::mpl::bool_<false>)
+{
+	const string_t encoding = attribute_text(Storage, "encoding");
+	if(encoding.empty())
+		return false;
+
+	log() << error << k3d_file_reference << ": array type [" << demangle(typeid(Array)) << "] cannot use encoding [" << encoding << "]" << std::endl;
+	return true;
+}
+
+template<typename array_type>
+bool_t load_binary_array(const element& Storage, array_type& Array, const ipersistent::load_context& Context)
+{
+	return load_binary_array(Storage, Array, Context, typename binary_array_traits<typename array_type::value_type>::supported());
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // load_array
 
 template<typename array_type>
 void load_array(const element& Storage, array_type& Array, const ipersistent::load_context& Context)
 {
-	typename array_type::value_type value;
-
-	std::istringstream buffer(Storage.text);
-	while(true)
+	if(!load_binary_array(Storage, Array, Context))
 	{
-		buffer >> value;
+		Array.reserve(load_array_reserve(Storage));
 
-		if(!buffer)
-			break;
+		typename array_type::value_type value;
+
+		std::istringstream buffer(Storage.text);
+		while(true)
+		{
+			buffer >> value;
+
+			if(!buffer)
+				break;
 
-		Array.push_back(value);
+			Array.push_back(value);
+		}
 	}
 
 	load_array_metadata(Storage, Array, Context);
@@ -1710,17 +2042,22 @@ void load_array(const element& Storage, array_type& Array, const ipersistent::lo
 
 void load_array(const element& Storage, typed_array<int8_t>& Array, const ipersistent::load_context& Context)
 {
-	int16_t value;
-
-	std::istringstream buffer(Storage.text);
-	while(true)
+	if(!load_binary_array(Storage, Array, Context))
 	{
-		buffer >> value;
+		Array.reserve(load_array_reserve(Storage));
 
-		if(!buffer)
-			break;
+		int16_t value;
+
+		std::istringstream buffer(Storage.text);
+		while(true)
+		{
+			buffer >> value;
+
+			if(!buffer)
+				break;
 
-		Array.push_back(static_cast<int8_t>(value));
+			Array.push_back(static_cast<int8_t>(value));
+		}
 	}
 
 	load_array_metadata(Storage, Array, Context);
@@ -1731,17 +2068,22 @@ void load_array(const element& Storage, typed_array<int8_t>& Array, const ipersi
 
 void load_array(const element& Storage, typed_array<uint8_t>& Array, const ipersistent::load_context& Context)
 {
-	uint16_t value;
-
-	std::istringstream buffer(Storage.text);
-	while(true)
+	if(!load_binary_array(Storage, Array, Context))
 	{
-		buffer >> value;
+		Array.reserve(load_array_reserve(Storage));
 
-		if(!buffer)
-			break;
+		uint16_t value;
+
+		std::istringstream buffer(Storage.text);
+		while(true)
+		{
+			buffer >> value;
 
-		Array.push_back(static_cast<uint8_t>(value));
+			if(!buffer)
+				break;
+
+			Array.push_back(static_cast<uint8_t>(value));
+		}
 	}
 
 	load_array_metadata(Storage, Array, Context);
@@ -1752,22 +2094,54 @@ void load_array(const element& Storage, typed_array<uint8_t>& Array, const ipers
 
 void load_array(const element& Storage, uint_t_array& Array, const ipersistent::load_context& Context)
 {
-	uint64_t value;
+	const uint_t count = load_array_count(Storage);
+	const string_t encoding = attribute_text(Storage, "encoding");
 
-	std::istringstream buffer(Storage.text);
-	while(true)
+	if(encoding == "base64")
 	{
-		buffer >> value;
+		std::string data;
+		if(count && load_binary_data(Storage, sizeof(uint64_t), count, data))
+		{
+			Array.resize(count);
+			for(uint_t i = 0; i != count; ++i)
+			{
+				uint64_t value;
+				std::memcpy(&value, data.data() + i * sizeof(uint64_t), sizeof(uint64_t));
+
+				/** \note We clamp 64-bit values on 32-bit platforms.  This makes selections work. */
+				#if defined K3D_UINT_T_32_BITS
+					Array[i] = std::min(uint64_t(uint_t(-1)), value);
+				#else
+					Array[i] = value;
+				#endif
+			}
+		}
+	}
+	else if(!encoding.empty())
+	{
+		log() << error << k3d_file_reference << ": unknown array encoding [" << encoding << "]" << std::endl;
+	}
+	else
+	{
+		Array.reserve(load_array_reserve(Storage));
 
-		if(!buffer)
-			break;
+		uint64_t value;
 
-		/** \note We clamp 64-bit values on 32-bit platforms.  This makes selections work. */
-		#if defined K3D_UINT_T_32_BITS
-			value = std::min(uint64_t(uint_t(-1)), value);
-		#endif 
+		std::istringstream buffer(Storage.text);
+		while(true)
+		{
+			buffer >> value;
 
-		Array.push_back(value);
+			if(!buffer)
+				break;
+
+			/** \note We clamp 64-bit values on 32-bit platforms.  This makes selections work. */
+			#if defined K3D_UINT_T_32_BITS
+				value = std::min(uint64_t(uint_t(-1)), value);
+			#endif 
+
+			Array.push_back(value);
+		}
 	}
 
 	load_array_metadata(Storage, Array, Context);
@@ -1778,6 +2152,8 @@ void load_array(const element& Storage, uint_t_array& Array, const ipersistent::
 
 void load_array(const element& Storage, typed_array<string_t>& Array, const ipersistent::load_context& Context)
 {
+	Array.reserve(std::min(load_array_count(Storage), uint_t(Storage.children.size())));
+
 	for(element::elements_t::const_iterator xml_value = Storage.children.begin(); xml_value != Storage.children.end(); ++xml_value)
 	{
 		if(xml_value->name != "value")
@@ -1794,6 +2170,8 @@ void load_array(const element& Storage, typed_array<string_t>& Array, const iper
 
 void load_array(const element& Storage, typed_array<imaterial*>& Array, const ipersistent::load_context& Context)
 {
+	Array.reserve(load_array_reserve(Storage));
+
 	std::istringstream buffer(Storage.text);
 	while(true)
 	{
@@ -1814,6 +2192,8 @@ void load_array(const element& Storage, typed_array<imaterial*>& Array, const ip
 
 void load_array(const element& Storage, typed_array<inode*>& Array, const ipersistent::load_context& Context)
 {
+	Array.reserve(load_array_reserve(Storage));
+
 	std::istringstream buffer(Storage.text);
 	while(true)
 	{
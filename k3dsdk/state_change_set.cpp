@@ -23,6 +23,7 @@
 */
 
 #include <k3dsdk/idocument.h>
+#include <k3dsdk/ispillable_state_container.h>
 #include <k3dsdk/istate_container.h>
 #include <k3dsdk/istate_recorder.h>
 #include <k3dsdk/result.h>
@@ -42,7 +43,8 @@ namespace k3d
 class state_change_set::implementation
 {
 public:
-	implementation()
+	implementation() :
+		m_spilled(false)
 	{
 	}
 
@@ -55,6 +57,7 @@ public:
 	typedef std::vector<istate_container*> state_collection_t;
 	state_collection_t m_old_states;
 	state_collection_t m_new_states;
+	bool_t m_spilled;
 
 	sigc::signal<void> m_undo_signal;
 	sigc::signal<void> m_redo_signal;
@@ -117,6 +120,47 @@ size_t state_change_set::redo_count() const
 	return m_implementation->m_new_states.size();
 }
 
+const uint_t state_change_set::memory_usage() const
+{
+	uint_t result = 0;
+
+	for(implementation::state_collection_t::const_iterator state = m_implementation->m_old_states.begin(); state != m_implementation->m_old_states.end(); ++state)
+	{
+		if(ispillable_state_container* const spillable = dynamic_cast<ispillable_state_container*>(*state))
+			result += spillable->memory_usage();
+	}
+
+	for(implementation::state_collection_t::const_iterator state = m_implementation->m_new_states.begin(); state != m_implementation->m_new_states.end(); ++state)
+	{
+		if(ispillable_state_container* const spillable = dynamic_cast<ispillable_state_container*>(*state))
+			result += spillable->memory_usage();
+	}
+
+	return result;
+}
+
+void state_change_set::spill(const boost::shared_ptr<state_spill_file>& File)
+{
+	for(implementation::state_collection_t::iterator state = m_implementation->m_old_states.begin(); state != m_implementation->m_old_states.end(); ++state)
+	{
+		if(ispillable_state_container* const spillable = dynamic_cast<ispillable_state_container*>(*state))
+			spillable->spill(File);
+	}
+
+	for(implementation::state_collection_t::iterator state = m_implementation->m_new_states.begin(); state != m_implementation->m_new_states.end(); ++state)
+	{
+		if(ispillable_state_container* const spillable = dynamic_cast<ispillable_state_container*>(*state))
+			spillable->spill(File);
+	}
+
+	m_implementation->m_spilled = true;
+}
+
+const bool_t state_change_set::spilled() const
+{
+	return m_implementation->m_spilled;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // create_state_change_set
 
@@ -25,6 +25,9 @@
 */
 
 #include <k3dsdk/signal_system.h>
+#include <k3dsdk/types.h>
+
+#include <boost/shared_ptr.hpp>
 
 #include <memory>
 #include <string>
@@ -34,6 +37,7 @@ namespace k3d
 
 class idocument;
 class istate_container;
+class state_spill_file;
 
 /// Stores an atomic set of state changes that can be undone / redone
 class state_change_set
@@ -61,6 +65,13 @@ public:
 	size_t undo_count() const;
 	/// Returns the number of stored redo state containers (mainly for debugging)
 	size_t redo_count() const;
+
+	/// Returns the approximate number of bytes of memory used by stored state containers that implement ispillable_state_container (other containers aren't counted)
+	const uint_t memory_usage() const;
+	/// Moves stored state to the given file, for every state container that implements ispillable_state_container
+	void spill(const boost::shared_ptr<state_spill_file>& File);
+	/// Returns true iff spill() has been called
+	const bool_t spilled() const;
 	
 private:
 	state_change_set(const state_change_set&);
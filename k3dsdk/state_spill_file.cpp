@@ -0,0 +1,176 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/log.h>
+#include <k3dsdk/result.h>
+#include <k3dsdk/state_spill_file.h>
+#include <k3dsdk/system.h>
+
+#include <zlib.h>
+
+#include <string>
+
+namespace k3d
+{
+
+/////////////////////////////////////////////////////////////////////////////
+// state_spill_file::implementation
+
+class state_spill_file::implementation
+{
+public:
+	implementation() :
+		live_blocks(0),
+		live_size(0)
+	{
+	}
+
+	~implementation()
+	{
+		if(stream.is_open())
+			stream.close();
+		if(!path.empty())
+			filesystem::remove(path);
+	}
+
+	/// Opens the file, discarding any previous contents
+	const bool_t open()
+	{
+		if(path.empty())
+			path = system::generate_temp_file();
+
+		if(stream.is_open())
+			stream.close();
+		stream.clear();
+		stream.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+
+		if(!stream.good())
+		{
+			log() << error << "Error opening undo/redo spill file [" << path.native_console_string() << "]" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	filesystem::path path;
+	filesystem::fstream stream;
+	uint64_t live_blocks;
+	uint64_t live_size;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// state_spill_file
+
+state_spill_file::state_spill_file() :
+	m_implementation(new implementation())
+{
+}
+
+state_spill_file::~state_spill_file()
+{
+	delete m_implementation;
+}
+
+const state_spill_file::block state_spill_file::write(const void* const Data, const uint64_t Size)
+{
+	block result;
+	return_val_if_fail(Data && Size, result);
+
+	if(!m_implementation->stream.is_open())
+		return_val_if_fail(m_implementation->open(), result);
+
+	uLongf compressed_size = compressBound(Size);
+	std::string compressed(compressed_size, '\0');
+	if(Z_OK != compress2(reinterpret_cast<Bytef*>(&compressed[0]), &compressed_size, reinterpret_cast<const Bytef*>(Data), Size, Z_BEST_SPEED))
+	{
+		log() << error << "Error compressing undo/redo state" << std::endl;
+		return result;
+	}
+
+	m_implementation->stream.seekp(0, std::ios::end);
+	const uint64_t offset = m_implementation->stream.tellp();
+	m_implementation->stream.write(compressed.data(), compressed_size);
+	if(!m_implementation->stream.good())
+	{
+		log() << error << "Error writing undo/redo spill file" << std::endl;
+		m_implementation->stream.clear();
+		return result;
+	}
+
+	result.offset = offset;
+	result.compressed_size = compressed_size;
+	result.size = Size;
+
+	++m_implementation->live_blocks;
+	m_implementation->live_size += compressed_size;
+
+	return result;
+}
+
+const bool_t state_spill_file::read(const block& Block, void* const Data)
+{
+	return_val_if_fail(Data && Block.size, false);
+	return_val_if_fail(m_implementation->stream.is_open(), false);
+
+	std::string compressed(Block.compressed_size, '\0');
+	m_implementation->stream.seekg(Block.offset);
+	m_implementation->stream.read(&compressed[0], Block.compressed_size);
+	if(!m_implementation->stream.good())
+	{
+		log() << error << "Error reading undo/redo spill file" << std::endl;
+		m_implementation->stream.clear();
+		return false;
+	}
+
+	uLongf size = Block.size;
+	if(Z_OK != uncompress(reinterpret_cast<Bytef*>(Data), &size, reinterpret_cast<const Bytef*>(compressed.data()), compressed.size()) || size != Block.size)
+	{
+		log() << error << "Error decompressing undo/redo state" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void state_spill_file::release(const block& Block)
+{
+	return_if_fail(Block.size);
+	return_if_fail(m_implementation->live_blocks);
+
+	--m_implementation->live_blocks;
+	m_implementation->live_size -= Block.compressed_size;
+
+	// Once nothing refers to the file contents, start over to reclaim disk space ...
+	if(!m_implementation->live_blocks)
+		m_implementation->open();
+}
+
+const uint64_t state_spill_file::size() const
+{
+	return m_implementation->live_size;
+}
+
+} // namespace k3d
+
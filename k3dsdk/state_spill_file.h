@@ -0,0 +1,71 @@
+#ifndef K3DSDK_STATE_SPILL_FILE_H
+#define K3DSDK_STATE_SPILL_FILE_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+namespace k3d
+{
+
+/// Stores zlib-compressed blocks of undo/redo state in a temporary file, so old change sets can be released from memory.
+/// The file is created when the first block is written, truncated whenever every block has been released, and deleted with the object.
+class state_spill_file
+{
+public:
+	state_spill_file();
+	~state_spill_file();
+
+	/// Identifies a block of data stored in the file
+	struct block
+	{
+		block() : offset(0), compressed_size(0), size(0) { }
+
+		uint64_t offset;
+		uint64_t compressed_size;
+		uint64_t size;
+	};
+
+	/// Compresses and stores Size bytes of data, returning the block that identifies them (a block with zero size indicates an error)
+	const block write(const void* const Data, const uint64_t Size);
+	/// Reads a block back into Data, which must have room for Block.size bytes.  Returns true on success.
+	const bool_t read(const block& Block, void* const Data);
+	/// Called when a block will never be read again
+	void release(const block& Block);
+
+	/// Returns the number of compressed bytes stored in blocks that haven't been released
+	const uint64_t size() const;
+
+private:
+	state_spill_file(const state_spill_file&);
+	state_spill_file& operator=(const state_spill_file&);
+
+	class implementation;
+	implementation* const m_implementation;
+};
+
+} // namespace k3d
+
+#endif // !K3DSDK_STATE_SPILL_FILE_H
+
@@ -24,7 +24,11 @@
 
 #include <k3dsdk/stream_io_ri.h>
 #include <k3dsdk/texture3.h>
+
+#include <cstring>
+#include <map>
 #include <set>
+#include <sstream>
 
 namespace k3d
 {
@@ -77,20 +81,21 @@ bool print_parameter(const std::string& Type, std::ostream& Stream, const parame
 	if(array_t* const array = dynamic_cast<array_t*>(RHS.storage.get()))
 	{
 		// First, print the parameter name, with optional inline type info (only if inlining is enabled and the type isn't predefined) ...
-		Stream << "\"";
+		if(inline_types(Stream) && !detail::predefined_types().count(RHS.name))
+		{
+			std::ostringstream token;
+			token << RHS.storage_class << " " << Type << " ";
+			if(RHS.tuple_size > 1)
+				token << "[" << RHS.tuple_size << "] ";
+			token << RHS.name;
 
-		if(inline_types(Stream))
+			Stream << format_string(token.str()) << " ";
+		}
+		else
 		{
-			if(!detail::predefined_types().count(RHS.name))
-			{
-				Stream << RHS.storage_class << " " << Type << " ";
-				if(RHS.tuple_size > 1)
-					Stream << "[" << RHS.tuple_size << "] ";
-			}
+			Stream << format_string(RHS.name) << " ";
 		}
 
-		Stream << RHS.name << "\" ";
-
 		// Next, print the parameter values
 		Stream << format_array(array->begin(), array->end());
 
@@ -100,6 +105,206 @@ bool print_parameter(const std::string& Type, std::ostream& Stream, const parame
 	return false;
 }
 
+/// Stores the string table and encoded requests for an output stream that uses the binary RIB encoding
+struct binary_encoding_state
+{
+	binary_encoding_state() :
+		enabled(false)
+	{
+	}
+
+	bool enabled;
+	/// Maps strings to their string table entries
+	std::map<string, uint32_t> strings;
+	/// Maps request names to their request codes
+	std::map<string, uint32_t> requests;
+};
+
+int binary_encoding_index()
+{
+	static const int index = std::ios_base::xalloc();
+	return index;
+}
+
+void binary_encoding_callback(std::ios_base::event Event, std::ios_base& Stream, int Index)
+{
+	switch(Event)
+	{
+		case std::ios_base::erase_event:
+			delete static_cast<binary_encoding_state*>(Stream.pword(Index));
+			Stream.pword(Index) = 0;
+			break;
+		case std::ios_base::copyfmt_event:
+			// The copied state belongs to the original stream ...
+			Stream.pword(Index) = 0;
+			break;
+		default:
+			break;
+	}
+}
+
+/// Returns the binary encoding state for a stream, or NULL if binary encoding has never been enabled
+binary_encoding_state* get_binary_encoding_state(std::ios_base& Stream)
+{
+	return static_cast<binary_encoding_state*>(Stream.pword(binary_encoding_index()));
+}
+
+/// Writes an unsigned value using the given number of big-endian bytes
+void write_bytes(std::ostream& Stream, const uint32_t Value, const uint32_t Bytes)
+{
+	for(uint32_t i = Bytes; i; --i)
+		Stream.put(static_cast<char>((Value >> (8 * (i - 1))) & 0xff));
+}
+
+/// Returns the number of bytes required to store a value
+const uint32_t byte_count(const uint32_t Value)
+{
+	return Value < 0x100 ? 1 : Value < 0x10000 ? 2 : Value < 0x1000000 ? 3 : 4;
+}
+
+/// Writes a binary RIB string token, without using the string table
+void write_string_token(std::ostream& Stream, const string& Value)
+{
+	if(Value.size() < 16)
+	{
+		Stream.put(static_cast<char>(0220 + Value.size()));
+	}
+	else
+	{
+		const uint32_t bytes = byte_count(Value.size());
+		Stream.put(static_cast<char>(0240 + bytes - 1));
+		write_bytes(Stream, Value.size(), bytes);
+	}
+
+	Stream.write(Value.data(), Value.size());
+}
+
+/// Writes a binary RIB string, using the string table whenever possible
+void write_binary_string(std::ostream& Stream, binary_encoding_state& State, const string& Value)
+{
+	std::map<string, uint32_t>::const_iterator entry = State.strings.find(Value);
+	if(entry != State.strings.end())
+	{
+		const uint32_t bytes = byte_count(entry->second);
+		Stream.put(static_cast<char>(0317 + bytes - 1));
+		write_bytes(Stream, entry->second, bytes);
+		return;
+	}
+
+	// String table entries have at most two-byte indices ...
+	const uint32_t index = State.strings.size();
+	if(index >= 0x10000)
+	{
+		write_string_token(Stream, Value);
+		return;
+	}
+
+	State.strings.insert(std::make_pair(Value, index));
+
+	const uint32_t bytes = byte_count(index);
+	Stream.put(static_cast<char>(0315 + bytes - 1));
+	write_bytes(Stream, index, bytes);
+	write_string_token(Stream, Value);
+}
+
+void append_binary(std::vector<int32_t>& Values, const integer Value)
+{
+	Values.push_back(Value);
+}
+
+void append_binary(std::vector<int32_t>& Values, const unsigned_integer Value)
+{
+	Values.push_back(static_cast<int32_t>(Value));
+}
+
+void append_binary(std::vector<float>& Values, const real Value)
+{
+	Values.push_back(Value);
+}
+
+void append_binary(std::vector<float>& Values, const point& Value)
+{
+	Values.insert(Values.end(), Value.n, Value.n + 3);
+}
+
+void append_binary(std::vector<float>& Values, const vector& Value)
+{
+	Values.insert(Values.end(), Value.n, Value.n + 3);
+}
+
+void append_binary(std::vector<float>& Values, const normal& Value)
+{
+	Values.insert(Values.end(), Value.n, Value.n + 3);
+}
+
+void append_binary(std::vector<float>& Values, const color& Value)
+{
+	Values.push_back(Value.red);
+	Values.push_back(Value.green);
+	Values.push_back(Value.blue);
+}
+
+void append_binary(std::vector<float>& Values, const hpoint& Value)
+{
+	Values.insert(Values.end(), Value.n, Value.n + 4);
+}
+
+void append_binary(std::vector<float>& Values, const matrix& Value)
+{
+	// Matches the (row-major) ASCII output of matrices within parameter lists ...
+	for(int i = 0; i != 4; ++i)
+		Values.insert(Values.end(), Value[i].n, Value[i].n + 4);
+}
+
+void append_binary(std::vector<float>& Values, const texture3& Value)
+{
+	Values.insert(Values.end(), Value.n, Value.n + 3);
+}
+
+void write_binary(std::ostream& Stream, const std::vector<int32_t>& Values)
+{
+	std::vector<char> buffer(2 + 5 * Values.size());
+	std::vector<char>::iterator output = buffer.begin();
+
+	*output++ = '[';
+	for(std::vector<int32_t>::const_iterator value = Values.begin(); value != Values.end(); ++value)
+	{
+		const uint32_t bits = static_cast<uint32_t>(*value);
+		*output++ = static_cast<char>(0203);
+		*output++ = static_cast<char>(bits >> 24);
+		*output++ = static_cast<char>(bits >> 16);
+		*output++ = static_cast<char>(bits >> 8);
+		*output++ = static_cast<char>(bits);
+	}
+	*output++ = ']';
+
+	Stream.write(&buffer[0], buffer.size());
+}
+
+void write_binary(std::ostream& Stream, const std::vector<float>& Values)
+{
+	const uint32_t bytes = byte_count(Values.size());
+	Stream.put(static_cast<char>(0310 + bytes - 1));
+	write_bytes(Stream, Values.size(), bytes);
+
+	if(Values.empty())
+		return;
+
+	std::vector<char> buffer(4 * Values.size());
+	std::vector<char>::iterator output = buffer.begin();
+	for(std::vector<float>::const_iterator value = Values.begin(); value != Values.end(); ++value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &*value, 4);
+		*output++ = static_cast<char>(bits >> 24);
+		*output++ = static_cast<char>(bits >> 16);
+		*output++ = static_cast<char>(bits >> 8);
+		*output++ = static_cast<char>(bits);
+	}
+
+	Stream.write(&buffer[0], buffer.size());
+}
+
 } // namespace detail
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -152,6 +357,82 @@ bool set_inline_types(std::ostream& Stream, const bool Enabled)
 	return old_state;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////
+// binary_encoding
+
+bool binary_encoding(std::ostream& Stream)
+{
+	const detail::binary_encoding_state* const state = detail::get_binary_encoding_state(Stream);
+	return state && state->enabled;
+}
+
+bool set_binary_encoding(std::ostream& Stream, const bool Enabled)
+{
+	detail::binary_encoding_state* state = detail::get_binary_encoding_state(Stream);
+	if(!state)
+	{
+		if(!Enabled)
+			return false;
+
+		state = new detail::binary_encoding_state();
+		Stream.pword(detail::binary_encoding_index()) = state;
+		Stream.register_callback(detail::binary_encoding_callback, detail::binary_encoding_index());
+	}
+
+	const bool old_state = state->enabled;
+	state->enabled = Enabled;
+	return old_state;
+}
+
+void reset_binary_encoding(std::ostream& Stream)
+{
+	if(detail::binary_encoding_state* const state = detail::get_binary_encoding_state(Stream))
+	{
+		state->strings.clear();
+		state->requests.clear();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// format_request
+
+format_request::format_request(const char* const Name) :
+	name(Name)
+{
+}
+
+std::ostream& operator<<(std::ostream& Stream, const format_request& RHS)
+{
+	detail::binary_encoding_state* const state = detail::get_binary_encoding_state(Stream);
+	if(!state || !state->enabled)
+	{
+		Stream << RHS.name;
+		return Stream;
+	}
+
+	// Define the request the first time it's used (request codes are a single byte) ...
+	std::map<string, uint32_t>::iterator request = state->requests.find(RHS.name);
+	if(request == state->requests.end())
+	{
+		if(state->requests.size() >= 0x100)
+		{
+			Stream << RHS.name;
+			return Stream;
+		}
+
+		request = state->requests.insert(std::make_pair(string(RHS.name), static_cast<uint32_t>(state->requests.size()))).first;
+
+		Stream.put(static_cast<char>(0314));
+		Stream.put(static_cast<char>(request->second));
+		detail::write_string_token(Stream, request->first);
+	}
+
+	Stream.put(static_cast<char>(0246));
+	Stream.put(static_cast<char>(request->second));
+
+	return Stream;
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 // format_string
 
@@ -162,6 +443,13 @@ format_string::format_string(const string& Token) :
 
 std::ostream& operator<<(std::ostream& Stream, const format_string& RHS)
 {
+	detail::binary_encoding_state* const state = detail::get_binary_encoding_state(Stream);
+	if(state && state->enabled)
+	{
+		detail::write_binary_string(Stream, *state, RHS.token);
+		return Stream;
+	}
+
 	Stream << "\"" << RHS.token << "\"";
 	return Stream;
 }
@@ -176,6 +464,19 @@ format_matrix::format_matrix(const matrix& Matrix) :
 
 std::ostream& operator<<(std::ostream& Stream, const format_matrix& RHS)
 {
+	if(binary_encoding(Stream))
+	{
+		std::vector<float> values;
+		for(int i = 0; i != 4; ++i)
+		{
+			for(int j = 0; j != 4; ++j)
+				values.push_back(RHS.m[j][i]);
+		}
+		detail::write_binary(Stream, values);
+
+		return Stream;
+	}
+
 	Stream << "[";
 	for(int i = 0; i != 4; ++i)
 	{
@@ -26,9 +26,14 @@
 
 #include <k3dsdk/types_ri.h>
 
+#include <iterator>
+#include <vector>
+
 namespace k3d
 {
 
+class texture3;
+
 namespace ri
 {
 
@@ -40,6 +45,26 @@ bool inline_types(std::ostream& Stream);
 /// iostream-compatible manipulator that controls whether inline types are enabled for an output stream
 bool set_inline_types(std::ostream& Stream, const bool Enabled);
 
+/// iostream-compatible manipulator that returns true iff the binary RIB encoding is enabled for an output stream
+bool binary_encoding(std::ostream& Stream);
+/// iostream-compatible manipulator that controls whether strings, arrays and requests are written using the binary RIB encoding (encoded
+/// requests, a string table, and single-precision float arrays) instead of ASCII.  Both encodings can be mixed freely within a RIB file.
+bool set_binary_encoding(std::ostream& Stream, const bool Enabled);
+/// Forgets the encoded requests and string table entries defined so far, so they will be redefined before they are used again.  Call this
+/// after including another RIB file, which may redefine the same codes.
+void reset_binary_encoding(std::ostream& Stream);
+
+/// Formats the name of a RIB request, as an encoded request if binary encoding is enabled; designed to be used as an inline formatting object
+class format_request
+{
+public:
+	explicit format_request(const char* const Name);
+	friend std::ostream& operator<<(std::ostream& Stream, const format_request& RHS);
+
+private:
+	const char* const name;
+};
+
 /// Formats a string with real-quotes for inclusion in a RIB file; designed to be used as an inline formatting object
 class format_string
 {
@@ -62,6 +87,46 @@ private:
 	const matrix& m;
 };
 
+namespace detail
+{
+
+/// Stores values for the binary RIB encoding - integers are written as individual integer tokens, everything else as one float array token
+template<typename value_t>
+struct binary_array
+{
+	typedef std::vector<float> type;
+};
+
+template<>
+struct binary_array<integer>
+{
+	typedef std::vector<int32_t> type;
+};
+
+template<>
+struct binary_array<unsigned_integer>
+{
+	typedef std::vector<int32_t> type;
+};
+
+void append_binary(std::vector<int32_t>& Values, const integer Value);
+void append_binary(std::vector<int32_t>& Values, const unsigned_integer Value);
+void append_binary(std::vector<float>& Values, const real Value);
+void append_binary(std::vector<float>& Values, const point& Value);
+void append_binary(std::vector<float>& Values, const vector& Value);
+void append_binary(std::vector<float>& Values, const normal& Value);
+void append_binary(std::vector<float>& Values, const color& Value);
+void append_binary(std::vector<float>& Values, const hpoint& Value);
+void append_binary(std::vector<float>& Values, const matrix& Value);
+void append_binary(std::vector<float>& Values, const texture3& Value);
+
+/// Writes integers as binary RIB integer tokens within square brackets
+void write_binary(std::ostream& Stream, const std::vector<int32_t>& Values);
+/// Writes floats as a binary RIB float array token
+void write_binary(std::ostream& Stream, const std::vector<float>& Values);
+
+} // namespace detail
+
 /// Formats an array of values within square brackets for inclusion in a RIB file; designed to be used as an inline formatting object
 template<typename iterator_t, typename value_t>
 class format_array_t
@@ -75,6 +140,16 @@ public:
 
 	friend std::ostream& operator << (std::ostream& Stream, const format_array_t& RHS)
 	{
+		if(binary_encoding(Stream))
+		{
+			typename detail::binary_array<value_t>::type values;
+			for(iterator_t value = RHS.begin; value != RHS.end; ++value)
+				detail::append_binary(values, *value);
+			detail::write_binary(Stream, values);
+
+			return Stream;
+		}
+
 		Stream << "[ ";
 		std::copy(RHS.begin, RHS.end, std::ostream_iterator<value_t>(Stream, " "));
 		Stream << "]";
@@ -45,6 +45,8 @@ public:
 	~stream();
 
 	bool set_inline_types(const bool Inline);
+	/// Enables the binary RIB encoding for subsequent requests, returns the previous state
+	bool set_binary_encoding(const bool Binary);
 	void use_shader(const path& Path);
 
 	const light_handle RiAreaLightSourceV(const path& Path, const string& Name, const parameter_list& Parameters = parameter_list());
@@ -1169,8 +1169,10 @@ public:
 		std::copy(new_points.begin(), new_points.end(), Points.begin() + point_offset);
 		copy_output_polyhedron(m_intermediate_polyhedra[m_levels - 1], Polyhedron, point_offset);
 		k3d::table_copier point_copier(m_intermediate_point_data[m_levels - 1], PointData);
+		k3d::mesh::indices_t point_indices(new_point_count);
 		for(k3d::uint_t i = 0; i != new_point_count; ++i)
-			point_copier.push_back(i);
+			point_indices[i] = i;
+		point_copier.push_back(new_point_count, point_indices.empty() ? 0 : &point_indices[0]);
 	}
 	
 	void visit_surface(const k3d::uint_t Level, ipatch_surface_visitor& Visitor) const
@@ -287,11 +287,36 @@ bool spawn_async(const string_t& CommandLine)
 }
 
 bool spawn_sync(const string_t& CommandLine)
+{
+	int exit_status = 0;
+	return spawn_sync(CommandLine, exit_status);
+}
+
+bool spawn_sync(const string_t& CommandLine, int& ExitStatus)
 {
 	return_val_if_fail(!CommandLine.empty(), false);
 
 	log() << info << "spawn_sync: " << CommandLine << std::endl;
 	log() << info << "PATH=" << getenv("PATH") << std::endl;
+
+	string_t error_message;
+	if(spawn_sync(CommandLine, ExitStatus, error_message))
+		return true;
+
+	log() << error << error_message << std::endl;
+	return false;
+}
+
+bool spawn_sync(const string_t& CommandLine, int& ExitStatus, string_t& ErrorMessage)
+{
+	ExitStatus = 0;
+
+	if(CommandLine.empty())
+	{
+		ErrorMessage = "empty command line";
+		return false;
+	}
+
 #ifdef K3D_API_WIN32
 	k3d::bool_t status = true;
 	STARTUPINFO si;
@@ -316,7 +341,7 @@ bool spawn_sync(const string_t& CommandLine)
 		&pi )           // Pointer to PROCESS_INFORMATION structure
 	) 
 	{
-		log() << error << "Failed to CreateProcess with error: " << GetLastError() << std::endl;
+		ErrorMessage = "Failed to CreateProcess with error: " + string_cast(GetLastError());
 		status = false;
 	}
 	else
@@ -324,6 +349,10 @@ bool spawn_sync(const string_t& CommandLine)
 		// Wait until child process exits.
 		WaitForSingleObject( pi.hProcess, INFINITE );
 
+		DWORD exit_code = 0;
+		if(GetExitCodeProcess(pi.hProcess, &exit_code))
+			ExitStatus = exit_code;
+
 		// Close process and thread handles. 
 		CloseHandle( pi.hProcess );
 		CloseHandle( pi.hThread );
@@ -334,12 +363,12 @@ bool spawn_sync(const string_t& CommandLine)
 #else // non-win32:
 	try
 	{
-		Glib::spawn_command_line_sync(CommandLine);
+		Glib::spawn_command_line_sync(CommandLine, 0, 0, &ExitStatus);
 		return true;
 	}
 	catch(Glib::Exception& e)
 	{
-		log() << error << e.what() << std::endl;
+		ErrorMessage = e.what();
 		return false;
 	}
 #endif
@@ -405,6 +434,15 @@ void sleep(const double Seconds)
 
 #endif // !K3D_API_WIN32
 
+const uint_t process_id()
+{
+#ifdef K3D_API_WIN32
+	return GetCurrentProcessId();
+#else // K3D_API_WIN32
+	return getpid();
+#endif // !K3D_API_WIN32
+}
+
 } // namespace system
 
 } // namespace k3d
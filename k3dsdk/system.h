@@ -65,6 +65,11 @@ bool file_modification_time(const filesystem::path& File, time_t& ModificationTi
 bool spawn_async(const string_t& CommandLine);
 /// Runs an external process synchronously, blocking until it returns.  Note: execs the process directly, do not use shell features!  The child process will have the same environment as its parent, and the PATH environment variable will be used to lookup the binary to be executed.
 bool spawn_sync(const string_t& CommandLine);
+/// Runs an external process synchronously, blocking until it returns, and storing its exit status.  Returns false if the process couldn't be run.
+bool spawn_sync(const string_t& CommandLine, int& ExitStatus);
+/// Runs an external process synchronously, blocking until it returns, and storing its exit status.  Returns false if the process couldn't be run,
+/// storing the reason in ErrorMessage.  Doesn't log anything, so callers on worker threads can serialize their own logging.
+bool spawn_sync(const string_t& CommandLine, int& ExitStatus, string_t& ErrorMessage);
 
 /// Defines a collection of paths
 typedef std::vector<filesystem::path> paths_t;
@@ -76,6 +81,8 @@ const string_t executable_name(const string_t& Executable);
 
 /// Blocks the calling thread for the given number of seconds
 void sleep(const double Seconds);
+/// Returns the identifier of the current process
+const uint_t process_id();
 
 } // namespace system
 
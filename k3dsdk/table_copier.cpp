@@ -24,6 +24,9 @@
 #include <k3dsdk/array.h>
 #include <k3dsdk/table_copier.h>
 #include <k3dsdk/named_array_types.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
 #include <k3dsdk/result.h>
 #include <k3dsdk/typed_array.h>
 #include <k3dsdk/type_registry.h>
@@ -33,6 +36,7 @@
 #include <boost/mpl/for_each.hpp>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/static_assert.hpp>
+#include <boost/type_traits/is_same.hpp>
 
 #include <functional>
 
@@ -391,6 +395,33 @@ public:
 		std::for_each(copiers.begin(), copiers.end(), boost::bind(&array_copier::copy, _1, Count, Indices, Weights, TargetIndex));
 	}
 
+	void reserve(const uint_t Count)
+	{
+		std::for_each(copiers.begin(), copiers.end(), boost::bind(&array_copier::reserve, _1, Count));
+	}
+
+	void push_back(const uint_t Count, const uint_t* Indices)
+	{
+		const std::vector<uint_t> target_offsets = grow_targets(Count);
+		bulk_copy(Count, gather(Indices, target_offsets));
+	}
+
+	void push_back(const uint_t Count, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights)
+	{
+		const std::vector<uint_t> target_offsets = grow_targets(Count);
+		bulk_copy(Count, weighted_gather(FirstIndices, Indices, Weights, target_offsets));
+	}
+
+	void copy(const uint_t Count, const uint_t* SourceIndices, const uint_t* TargetIndices)
+	{
+		bulk_copy(Count, scatter(SourceIndices, TargetIndices));
+	}
+
+	void copy(const uint_t Count, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t* TargetIndices)
+	{
+		bulk_copy(Count, weighted_scatter(FirstIndices, Indices, Weights, TargetIndices));
+	}
+
 private:
 	/// Abstract interface for concrete objects that provide array-copying operations
 	class array_copier
@@ -406,11 +437,172 @@ private:
 		virtual void copy(const uint_t SourceIndex, const uint_t TargetIndex) = 0;
 		/// Called to compute a weighted sum from the source array and store the result at TargetIndex in the target array
 		virtual void copy(const uint_t Count, const uint_t* Indices, const double_t* Weights, const uint_t TagetIndex) = 0;
+
+		/// Called to reserve storage in the target array
+		virtual void reserve(const uint_t Count) = 0;
+		/// Called to append Count default values to the target array, returning the index of the first new value
+		virtual uint_t grow(const uint_t Count) = 0;
+		/// Returns true iff distinct values in the target array can be written concurrently
+		virtual bool_t concurrent_rows() const = 0;
+		/// Called to copy source values Indices[i] to target values TargetOffset + i, for i in [Begin, End)
+		virtual void gather(const uint_t Begin, const uint_t End, const uint_t* Indices, const uint_t TargetOffset) = 0;
+		/// Called to store compressed-sparse-row weighted sums i at target values TargetOffset + i, for i in [Begin, End)
+		virtual void gather(const uint_t Begin, const uint_t End, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t TargetOffset) = 0;
+		/// Called to copy source values SourceIndices[i] to target values TargetIndices[i], for i in [Begin, End)
+		virtual void scatter(const uint_t Begin, const uint_t End, const uint_t* SourceIndices, const uint_t* TargetIndices) = 0;
+		/// Called to store compressed-sparse-row weighted sums i at target values TargetIndices[i], for i in [Begin, End)
+		virtual void scatter(const uint_t Begin, const uint_t End, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t* TargetIndices) = 0;
 	};
 
 	/// Defines storage for a collection of array copiers
 	typedef boost::ptr_vector<array_copier> copiers_t;
 
+	/// Appends Count values to every target array, returning the index of the first new value in each
+	const std::vector<uint_t> grow_targets(const uint_t Count)
+	{
+		std::vector<uint_t> result(copiers.size());
+		for(uint_t i = 0; i != copiers.size(); ++i)
+			result[i] = copiers[i].grow(Count);
+		return result;
+	}
+
+	/// Bulk operation that copies source values to new target values
+	struct gather
+	{
+		gather(const uint_t* Indices, const std::vector<uint_t>& TargetOffsets) :
+			indices(Indices),
+			target_offsets(TargetOffsets)
+		{
+		}
+
+		void operator()(array_copier& Copier, const uint_t CopierIndex, const uint_t Begin, const uint_t End) const
+		{
+			Copier.gather(Begin, End, indices, target_offsets[CopierIndex]);
+		}
+
+		const uint_t* const indices;
+		const std::vector<uint_t>& target_offsets;
+	};
+
+	/// Bulk operation that stores weighted sums of source values in new target values
+	struct weighted_gather
+	{
+		weighted_gather(const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const std::vector<uint_t>& TargetOffsets) :
+			first_indices(FirstIndices),
+			indices(Indices),
+			weights(Weights),
+			target_offsets(TargetOffsets)
+		{
+		}
+
+		void operator()(array_copier& Copier, const uint_t CopierIndex, const uint_t Begin, const uint_t End) const
+		{
+			Copier.gather(Begin, End, first_indices, indices, weights, target_offsets[CopierIndex]);
+		}
+
+		const uint_t* const first_indices;
+		const uint_t* const indices;
+		const double_t* const weights;
+		const std::vector<uint_t>& target_offsets;
+	};
+
+	/// Bulk operation that copies source values to existing target values
+	struct scatter
+	{
+		scatter(const uint_t* SourceIndices, const uint_t* TargetIndices) :
+			source_indices(SourceIndices),
+			target_indices(TargetIndices)
+		{
+		}
+
+		void operator()(array_copier& Copier, const uint_t, const uint_t Begin, const uint_t End) const
+		{
+			Copier.scatter(Begin, End, source_indices, target_indices);
+		}
+
+		const uint_t* const source_indices;
+		const uint_t* const target_indices;
+	};
+
+	/// Bulk operation that stores weighted sums of source values in existing target values
+	struct weighted_scatter
+	{
+		weighted_scatter(const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t* TargetIndices) :
+			first_indices(FirstIndices),
+			indices(Indices),
+			weights(Weights),
+			target_indices(TargetIndices)
+		{
+		}
+
+		void operator()(array_copier& Copier, const uint_t, const uint_t Begin, const uint_t End) const
+		{
+			Copier.scatter(Begin, End, first_indices, indices, weights, target_indices);
+		}
+
+		const uint_t* const first_indices;
+		const uint_t* const indices;
+		const double_t* const weights;
+		const uint_t* const target_indices;
+	};
+
+	/// Splits a bulk operation into blocks of rows for each array, so the work is spread across both arrays and rows
+	template<typename OperationT>
+	class bulk_copy_blocks
+	{
+	public:
+		bulk_copy_blocks(copiers_t& Copiers, const uint_t Count, const uint_t BlockSize, const uint_t BlockCount, const OperationT& Operation) :
+			m_copiers(Copiers),
+			m_count(Count),
+			m_block_size(BlockSize),
+			m_block_count(BlockCount),
+			m_operation(Operation)
+		{
+		}
+
+		void operator()(const parallel::blocked_range<uint_t>& Range) const
+		{
+			for(uint_t item = Range.begin(); item != Range.end(); ++item)
+			{
+				const uint_t copier_index = item / m_block_count;
+				const uint_t block = item % m_block_count;
+				array_copier& copier = m_copiers[copier_index];
+
+				// Arrays that can't be written concurrently are handled in their entirety by their first block ...
+				if(!copier.concurrent_rows())
+				{
+					if(block == 0)
+						m_operation(copier, copier_index, 0, m_count);
+					continue;
+				}
+
+				const uint_t begin = block * m_block_size;
+				const uint_t end = std::min(m_count, begin + m_block_size);
+				m_operation(copier, copier_index, begin, end);
+			}
+		}
+
+	private:
+		copiers_t& m_copiers;
+		const uint_t m_count;
+		const uint_t m_block_size;
+		const uint_t m_block_count;
+		const OperationT& m_operation;
+	};
+
+	template<typename OperationT>
+	void bulk_copy(const uint_t Count, const OperationT& Operation)
+	{
+		if(!Count || copiers.empty())
+			return;
+
+		const uint_t block_size = std::max(uint_t(1), parallel::grain_size());
+		const uint_t block_count = (Count + block_size - 1) / block_size;
+		parallel::parallel_for(
+			parallel::blocked_range<uint_t>(0, copiers.size() * block_count, 1),
+			bulk_copy_blocks<OperationT>(copiers, Count, block_size, block_count, Operation));
+	}
+
 	/// Helper class that instantiates array_copier objects based on the runtime type of source and target arrays
 	class copier_factory
 	{
@@ -488,7 +680,59 @@ private:
 				target[TargetIndex] = weighted_sum(source, Count, Indices, Weights);
 			}
 
+			void reserve(const uint_t Count)
+			{
+				target.reserve(Count);
+			}
+
+			uint_t grow(const uint_t Count)
+			{
+				const uint_t result = target.size();
+				target.resize(result + Count);
+				return result;
+			}
+
+			bool_t concurrent_rows() const
+			{
+				// std::vector<bool> packs values into shared words ...
+				return !boost::is_same<typename array_t::value_type, bool_t>::value;
+			}
+
+			void gather(const uint_t Begin, const uint_t End, const uint_t* Indices, const uint_t TargetOffset)
+			{
+				for(uint_t i = Begin; i != End; ++i)
+					target[TargetOffset + i] = source[Indices[i]];
+			}
+
+			void gather(const uint_t Begin, const uint_t End, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t TargetOffset)
+			{
+				for(uint_t i = Begin; i != End; ++i)
+					target[TargetOffset + i] = row_value(FirstIndices, Indices, Weights, i);
+			}
+
+			void scatter(const uint_t Begin, const uint_t End, const uint_t* SourceIndices, const uint_t* TargetIndices)
+			{
+				for(uint_t i = Begin; i != End; ++i)
+					target[TargetIndices[i]] = source[SourceIndices[i]];
+			}
+
+			void scatter(const uint_t Begin, const uint_t End, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t* TargetIndices)
+			{
+				for(uint_t i = Begin; i != End; ++i)
+					target[TargetIndices[i]] = row_value(FirstIndices, Indices, Weights, i);
+			}
+
 		private:
+			/// Returns the weighted sum for one compressed-sparse-row entry, copying single rows with unit weight exactly
+			const typename array_t::value_type row_value(const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t Row) const
+			{
+				const uint_t first = FirstIndices[Row];
+				const uint_t count = FirstIndices[Row + 1] - first;
+				if(count == 1 && Weights[first] == 1.0)
+					return source[Indices[first]];
+				return weighted_sum(source, count, Indices + first, Weights + first);
+			}
+
 			const array_t& source;
 			array_t& target;
 		};
@@ -562,6 +806,7 @@ table_copier::table_copier(table& Table) :
 
 table_copier::~table_copier()
 {
+	delete m_implementation;
 }
 
 void table_copier::push_back(const uint_t Index)
@@ -584,5 +829,30 @@ void table_copier::copy(const uint_t Count, const uint_t* Indices, const double_
 	m_implementation->copy(Count, Indices, Weights, TargetIndex);
 }
 
+void table_copier::reserve(const uint_t Count)
+{
+	m_implementation->reserve(Count);
+}
+
+void table_copier::push_back(const uint_t Count, const uint_t* Indices)
+{
+	m_implementation->push_back(Count, Indices);
+}
+
+void table_copier::push_back(const uint_t Count, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights)
+{
+	m_implementation->push_back(Count, FirstIndices, Indices, Weights);
+}
+
+void table_copier::copy(const uint_t Count, const uint_t* SourceIndices, const uint_t* TargetIndices)
+{
+	m_implementation->copy(Count, SourceIndices, TargetIndices);
+}
+
+void table_copier::copy(const uint_t Count, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t* TargetIndices)
+{
+	m_implementation->copy(Count, FirstIndices, Indices, Weights, TargetIndices);
+}
+
 } // namespace k3d
 
@@ -91,6 +91,21 @@ public:
 	/// Computes a weighted sum of N values from each source array and copies the result to the corresponding target array at the given TargetIndex.
 	void copy(const uint_t Count, const uint_t* Indices, const double_t* Weights, const uint_t TargetIndex);
 
+	/// Reserves storage for the given total number of values in each target array, so callers that know their output size avoid reallocation.
+	void reserve(const uint_t Count);
+	/// Appends Count values to each target array, copying the value at Indices[i] from each corresponding source array.
+	void push_back(const uint_t Count, const uint_t* Indices);
+	/// Appends Count values to each target array, where value i is the weighted sum of the source values Indices[FirstIndices[i]]
+	/// through Indices[FirstIndices[i + 1] - 1] (compressed-sparse-row storage, so FirstIndices must contain Count + 1 values).
+	/// Values with a single source index and unit weight are copied exactly.
+	void push_back(const uint_t Count, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights);
+	/// Copies Count values from SourceIndices[i] in each source array to TargetIndices[i] in each corresponding target array.
+	/// Target indices must be unique, and must not overlap the source indices when copying within a single table.
+	void copy(const uint_t Count, const uint_t* SourceIndices, const uint_t* TargetIndices);
+	/// Computes Count weighted sums using compressed-sparse-row storage (see push_back()), storing sum i at TargetIndices[i] in each
+	/// corresponding target array.  Target indices must be unique, and must not overlap the source indices when copying within a single table.
+	void copy(const uint_t Count, const uint_t* FirstIndices, const uint_t* Indices, const double_t* Weights, const uint_t* TargetIndices);
+
 private:
 	class implementation;
 	implementation* const m_implementation;
@@ -0,0 +1,254 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/parallel/threads.h>
+#include <k3dsdk/text_parsing.h>
+
+#include <algorithm>
+#include <locale>
+#include <sstream>
+
+namespace k3d
+{
+
+namespace text
+{
+
+namespace detail
+{
+
+/// Powers of ten that can be represented exactly as doubles
+const double_t exact_powers_of_ten[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/// Largest integer mantissa that can be represented exactly as a double
+const uint64_t maximum_exact_mantissa = uint64_t(1) << 53;
+
+/// Minimum number of bytes in each chunk of a buffer that is parsed in parallel
+const uint64_t minimum_chunk_size = 1 << 20;
+
+inline const bool_t is_digit(const char C)
+{
+	return C >= '0' && C <= '9';
+}
+
+} // namespace detail
+
+const bool_t parse(const char*& Current, const char* const End, int64_t& Value)
+{
+	const char* c = skip_blanks(Current, End);
+
+	bool_t negative = false;
+	if(c != End && (*c == '-' || *c == '+'))
+	{
+		negative = *c == '-';
+		++c;
+	}
+
+	if(c == End || !detail::is_digit(*c))
+		return false;
+
+	uint64_t result = 0;
+	for(; c != End && detail::is_digit(*c); ++c)
+	{
+		const uint64_t digit = *c - '0';
+		if(result > (uint64_t(9223372036854775807LL) + (negative ? 1 : 0) - digit) / 10)
+			return false;
+		result = result * 10 + digit;
+	}
+
+	Value = negative ? -static_cast<int64_t>(result - 1) - 1 : static_cast<int64_t>(result);
+	Current = c;
+	return true;
+}
+
+const bool_t parse(const char*& Current, const char* const End, uint64_t& Value)
+{
+	const char* c = skip_blanks(Current, End);
+	if(c != End && *c == '+')
+		++c;
+
+	if(c == End || !detail::is_digit(*c))
+		return false;
+
+	uint64_t result = 0;
+	for(; c != End && detail::is_digit(*c); ++c)
+	{
+		const uint64_t digit = *c - '0';
+		if(result > (uint64_t(18446744073709551615ULL) - digit) / 10)
+			return false;
+		result = result * 10 + digit;
+	}
+
+	Value = result;
+	Current = c;
+	return true;
+}
+
+const bool_t parse(const char*& Current, const char* const End, double_t& Value)
+{
+	const char* const begin = skip_blanks(Current, End);
+	const char* c = begin;
+
+	bool_t negative = false;
+	if(c != End && (*c == '-' || *c == '+'))
+	{
+		negative = *c == '-';
+		++c;
+	}
+
+	// Accumulate up to 19 significant digits of the mantissa, tracking the decimal exponent ...
+	uint64_t mantissa = 0;
+	uint_t significant_digits = 0;
+	uint_t digits = 0;
+	int64_t exponent = 0;
+
+	for(; c != End && detail::is_digit(*c); ++c, ++digits)
+	{
+		if(significant_digits || *c != '0')
+		{
+			if(significant_digits < 19)
+				mantissa = mantissa * 10 + (*c - '0');
+			else
+				++exponent;
+			++significant_digits;
+		}
+	}
+
+	if(c != End && *c == '.')
+	{
+		for(++c; c != End && detail::is_digit(*c); ++c, ++digits)
+		{
+			if(significant_digits || *c != '0')
+			{
+				if(significant_digits < 19)
+				{
+					mantissa = mantissa * 10 + (*c - '0');
+					--exponent;
+				}
+				++significant_digits;
+			}
+			else
+			{
+				--exponent;
+			}
+		}
+	}
+
+	if(!digits)
+		return false;
+
+	if(c != End && (*c == 'e' || *c == 'E'))
+	{
+		const char* e = c + 1;
+		bool_t negative_exponent = false;
+		if(e != End && (*e == '-' || *e == '+'))
+		{
+			negative_exponent = *e == '-';
+			++e;
+		}
+
+		if(e != End && detail::is_digit(*e))
+		{
+			int64_t explicit_exponent = 0;
+			for(; e != End && detail::is_digit(*e); ++e)
+			{
+				if(explicit_exponent < 100000)
+					explicit_exponent = explicit_exponent * 10 + (*e - '0');
+			}
+			exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+			c = e;
+		}
+	}
+
+	// If the mantissa and the power of ten are both exact, a single multiplication or division is correctly rounded ...
+	if(!mantissa)
+	{
+		Value = negative ? -0.0 : 0.0;
+		Current = c;
+		return true;
+	}
+
+	if(significant_digits <= 19 && mantissa <= detail::maximum_exact_mantissa && exponent >= -22 && exponent <= 22)
+	{
+		double_t result = static_cast<double_t>(mantissa);
+		if(exponent < 0)
+			result /= detail::exact_powers_of_ten[-exponent];
+		else
+			result *= detail::exact_powers_of_ten[exponent];
+
+		Value = negative ? -result : result;
+		Current = c;
+		return true;
+	}
+
+	// Otherwise, let the standard library do the hard work ...
+	std::istringstream stream(std::string(begin, c));
+	stream.imbue(std::locale::classic());
+	double_t result = 0;
+	stream >> result;
+	if(stream.fail())
+		return false;
+
+	Value = result;
+	Current = c;
+	return true;
+}
+
+const uint64_t count_lines(const char* Begin, const char* const End)
+{
+	if(Begin == End)
+		return 0;
+
+	return std::count(Begin, End, '\n') + (*(End - 1) == '\n' ? 0 : 1);
+}
+
+void split_lines(const char* const Begin, const char* const End, const uint_t ChunkCount, std::vector<const char*>& Boundaries)
+{
+	Boundaries.clear();
+	Boundaries.push_back(Begin);
+
+	const uint64_t size = End - Begin;
+	for(uint_t i = 1; i < ChunkCount; ++i)
+	{
+		const char* const nominal = Begin + size * i / ChunkCount;
+		const char* const boundary = next_line(std::max(Boundaries.back(), nominal - 1), End);
+		if(boundary != Boundaries.back() && boundary != End)
+			Boundaries.push_back(boundary);
+	}
+
+	Boundaries.push_back(End);
+}
+
+const uint_t chunk_count(const uint64_t Size)
+{
+	return std::max(uint64_t(1), std::min(Size / detail::minimum_chunk_size, uint64_t(4 * parallel::thread_count())));
+}
+
+} // namespace text
+
+} // namespace k3d
+
@@ -0,0 +1,134 @@
+#ifndef K3DSDK_TEXT_PARSING_H
+#define K3DSDK_TEXT_PARSING_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\brief Declares functions for scanning numbers and lines in memory buffers, for fast file readers
+	\author Tim Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/types.h>
+
+#include <vector>
+
+namespace k3d
+{
+
+namespace text
+{
+
+/// Returns true iff the given character is a space or a tab
+inline const bool_t is_blank(const char C)
+{
+	return C == ' ' || C == '\t';
+}
+
+/// Returns true iff the given character ends a line
+inline const bool_t is_line_end(const char C)
+{
+	return C == '\n' || C == '\r';
+}
+
+/// Returns true iff the given character is whitespace
+inline const bool_t is_space(const char C)
+{
+	return is_blank(C) || is_line_end(C) || C == '\v' || C == '\f';
+}
+
+/// Advances past any spaces and tabs, stopping at the end of the line
+inline const char* skip_blanks(const char* Current, const char* const End)
+{
+	while(Current != End && is_blank(*Current))
+		++Current;
+	return Current;
+}
+
+/// Advances past any whitespace, including line endings
+inline const char* skip_space(const char* Current, const char* const End)
+{
+	while(Current != End && is_space(*Current))
+		++Current;
+	return Current;
+}
+
+/// Returns one-past-the-end of the token that begins at Current
+inline const char* token_end(const char* Current, const char* const End)
+{
+	while(Current != End && !is_space(*Current))
+		++Current;
+	return Current;
+}
+
+/// Returns the end of the current line (the line ending itself is excluded)
+inline const char* line_end(const char* Current, const char* const End)
+{
+	while(Current != End && !is_line_end(*Current))
+		++Current;
+	return Current;
+}
+
+/// Returns the start of the next line, or End
+inline const char* next_line(const char* Current, const char* const End)
+{
+	while(Current != End && *Current != '\n')
+		++Current;
+	return Current == End ? End : Current + 1;
+}
+
+/// Returns true iff the characters in [Begin, End) match the given null-terminated string exactly
+inline const bool_t equal(const char* Begin, const char* const End, const char* String)
+{
+	for(; Begin != End; ++Begin, ++String)
+	{
+		if(*Begin != *String)
+			return false;
+	}
+	return *String == '\0';
+}
+
+/// Parses an optionally-signed decimal integer at Current, skipping leading blanks.  On success, advances Current
+/// past the number and returns true.  Otherwise, leaves Current and Value unchanged and returns false.
+const bool_t parse(const char*& Current, const char* const End, int64_t& Value);
+/// Parses an optionally-signed decimal integer at Current, skipping leading blanks.  On success, advances Current
+/// past the number and returns true.  Otherwise, leaves Current and Value unchanged and returns false.
+const bool_t parse(const char*& Current, const char* const End, uint64_t& Value);
+/// Parses a floating-point number at Current, skipping leading blanks.  On success, advances Current past the number and
+/// returns true.  Otherwise, leaves Current and Value unchanged and returns false.  Gives exactly the same results as
+/// extracting a double from a std::istream in the "C" locale; common cases are handled without the stream, and
+/// uncommon cases (very long mantissas, or large exponents) fall back to the stream.
+const bool_t parse(const char*& Current, const char* const End, double_t& Value);
+
+/// Counts the lines in [Begin, End), including a final line that isn't terminated
+const uint64_t count_lines(const char* Begin, const char* const End);
+
+/// Divides [Begin, End) into at-most ChunkCount ranges of roughly equal size that start at the beginning of a line, for parsing
+/// in parallel.  On return, chunk i is [Boundaries[i], Boundaries[i + 1]).
+void split_lines(const char* const Begin, const char* const End, const uint_t ChunkCount, std::vector<const char*>& Boundaries);
+
+/// Returns a suitable number of chunks for parsing a buffer of the given size in parallel
+const uint_t chunk_count(const uint64_t Size);
+
+} // namespace text
+
+} // namespace k3d
+
+#endif // !K3DSDK_TEXT_PARSING_H
+
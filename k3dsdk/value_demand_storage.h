@@ -20,6 +20,8 @@
 // License along with this program; if not, write to the Free Software
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
+#include <k3dsdk/pipeline_trace.h>
+
 #include <boost/scoped_ptr.hpp>
 #include <boost/static_assert.hpp>
 #include <boost/type_traits.hpp>
@@ -72,6 +74,7 @@ public:
 		{
 			// Create a temporary copy of pending hints in-case we are updated while executing ...
 			const pending_hints_t pending_hints(m_pending_hints);
+			const pipeline_trace::hint_scope hints(pending_hints);
 			m_update_slot(pending_hints, m_value);
 			
 			std::for_each(m_pending_hints.begin(), m_pending_hints.end(), delete_object());
@@ -44,6 +44,9 @@ void plugin_message_handler(const std::string& Message)
 void usage(std::ostream& Stream)
 {
 	Stream << "usage: k3d-make-module-proxy [Module] [OutputFile]" << std::endl;
+	Stream << "       k3d-make-module-proxy --index [IndexFile] [PluginPaths]" << std::endl;
+	Stream << std::endl;
+	Stream << "The second form updates a plugin index, re-indexing any modules that have been modified since the index was written." << std::endl;
 	Stream << std::endl;
 }
 
@@ -52,6 +55,20 @@ void usage(std::ostream& Stream)
 
 int main(int argc, char* argv[])
 {
+	if(argc == 4 && std::string(argv[1]) == "--index")
+	{
+		const k3d::filesystem::path index_path = k3d::filesystem::native_path(k3d::ustring::from_utf8(argv[2]));
+
+		k3d::plugin_factory_collection plugins;
+		plugins.connect_message_signal(sigc::ptr_fun(plugin_message_handler));
+		plugins.load_index(index_path);
+		plugins.load_modules(argv[3], true, k3d::plugin_factory_collection::LOAD_PROXIES);
+		plugins.save_index(index_path);
+		plugins.print_load_times(std::cout);
+
+		return 0;
+	}
+
 	if(argc != 3)
 	{
 		usage(std::cerr);
@@ -122,13 +122,15 @@ template <typename time_t, typename value_t>
 class animation_track :
 	public k3d::node,
 	public k3d::property_group_collection,
-	public k3d::ikeyframer
+	public k3d::ikeyframer,
+	public k3d::ikeyframe_sampler<time_t, value_t>
 {
 	typedef k3d::node base;
 	typedef k3d_data(time_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) time_property_t;
 	typedef k3d_data(value_t, immutable_name, change_signal, no_undo, local_storage, no_constraint, writable_property, with_serialization) value_property_t;
 	typedef std::map<time_property_t*, value_property_t*> keyframes_t;
 	typedef interpolator<time_t, value_t> interpolator_t;
+	typedef typename interpolator_t::curve_t curve_t;
 	typedef std::map<time_property_t*, std::string> keygroups_t;
 public:
 	animation_track(k3d::iplugin_factory& Factory, k3d::idocument& Document, time_t Time, value_t Value) :
@@ -139,7 +141,8 @@ public:
 		m_interpolator(init_owner(*this) + init_name("interpolator") + init_label("Interpolator") + init_description("Method used to interpolate keyframes") + init_value(static_cast<interpolator_t*>(0))),
 		m_manual_keyframe(init_owner(*this) + init_name("manual_keyframe") + init_label(("Manual keyframe only")) + init_description(("If checked, keyframes are created only usint the timeline. Otherwise keyframes are created/updated whenever the Value Input changes")) + init_value(false)),
 		m_record(true),
-		m_no_interpolation(false)
+		m_no_interpolation(false),
+		m_curve_valid(false)
 	{
 		m_output_value.set_update_slot(sigc::mem_fun(*this, &animation_track::on_output_request));
 		m_time_input.changed_signal().connect(m_output_value.make_slot());
@@ -162,13 +165,10 @@ public:
 			Output =  m_value_input.pipeline_value();
 			return;
 		}
-		typename interpolator_t::keyframes_t keyframes;
-		for (typename keyframes_t::iterator keyframe = m_keyframes.begin(); keyframe != m_keyframes.end(); ++keyframe)
-			keyframes.insert(std::make_pair(keyframe->first->pipeline_value(), keyframe->second->pipeline_value()));
 		time_t time = m_time_input.pipeline_value();
 		try
 		{
-			Output = interpolator->interpolate(time, keyframes);
+			Output = interpolator->interpolate(time, compiled_curve());
 		}
 		catch (insufficient_data_exception& e)
 		{
@@ -177,6 +177,22 @@ public:
 		}
 	}
 	
+	/// Samples the track at evenly-spaced times, without updating the output property.  Times outside the keyframes
+	/// (or every time, if there's no interpolator) use the current input value, just like the output property.
+	void sample(const time_t Start, const time_t Step, const k3d::uint_t Count, std::vector<value_t>& Values)
+	{
+		Values.resize(Count);
+
+		const value_t input_value = m_value_input.pipeline_value();
+		interpolator_t* interpolator = m_interpolator.pipeline_value();
+		const curve_t& curve = compiled_curve();
+		for (k3d::uint_t i = 0; i != Count; ++i)
+		{
+			const time_t time = Start + Step * i;
+			Values[i] = interpolator && curve.covers(time) ? interpolator->interpolate(time, curve) : input_value;
+		}
+	}
+	
 	/// Create a keyframe from the current time and value inputs
 	void keyframe()
 	{
@@ -252,6 +268,7 @@ public:
 		m_keygroups.erase(time_property);
 		delete value_property;
 		delete time_property;
+		m_curve_valid = false;
 		m_keys_changed_signal.emit();
 		reset_output();
 	}
@@ -351,6 +368,12 @@ public:
 		key_group.properties.push_back(static_cast<k3d::iproperty*>(time_property));
 		key_group.properties.push_back(static_cast<k3d::iproperty*>(value_it->second));
 		register_property_group(key_group);
+
+		// Recompile the keyframes whenever they change
+		time_property->changed_signal().connect(sigc::mem_fun(*this, &animation_track::on_key_change));
+		value_it->second->changed_signal().connect(sigc::mem_fun(*this, &animation_track::on_key_change));
+		m_curve_valid = false;
+
 		m_keys_changed_signal.emit();
 	}
 	
@@ -382,6 +405,27 @@ public:
 
 private:
 	
+	/// Returns the keyframes sorted by time, recompiling them if they've changed
+	const curve_t& compiled_curve()
+	{
+		if (!m_curve_valid)
+		{
+			m_curve.clear();
+			for (typename keyframes_t::const_iterator keyframe = m_keyframes.begin(); keyframe != m_keyframes.end(); ++keyframe)
+				m_curve.push_back(keyframe->first->pipeline_value(), keyframe->second->pipeline_value());
+			m_curve.sort();
+			m_curve_valid = true;
+		}
+		return m_curve;
+	}
+	
+	/// Executed when a key time or value changes
+	void on_key_change(k3d::ihint* Hint)
+	{
+		m_curve_valid = false;
+		m_output_value.update();
+	}
+	
 	/// Executed when the input value changes
 	void on_value_change(k3d::ihint* Hint)
 	{
@@ -439,6 +483,10 @@ private:
 	k3d::state_change_set* m_last_set; 
 	store_state_container<time_t, value_t>* m_last_store;
 	k3d::ikeyframer::keys_changed_signal_t m_keys_changed_signal;
+	/// Keyframes sorted by time, for fast interpolation
+	curve_t m_curve;
+	/// False if the keyframes have changed since m_curve was compiled
+	bool m_curve_valid;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -25,7 +25,9 @@
 		\author Bart Janssens (bart.janssens@lid.kviv.be)
 */
 
+#include <algorithm>
 #include <stdexcept>
+#include <vector>
 
 #include <k3dsdk/algebra.h>
 
@@ -42,6 +44,102 @@ public:
 	insufficient_data_exception() : std::runtime_error("Animation keyframe: insufficuent data to interpolate") {}
 };
 
+/// Stores keyframes sorted by time in contiguous arrays, so they can be evaluated without rebuilding a map.  Remembers the most
+/// recently used segment, so evaluating at steadily increasing (or decreasing) times, as during playback, finds the surrounding
+/// keys in constant time.
+template<typename time_t, typename value_t>
+class keyframe_curve
+{
+public:
+	keyframe_curve() : m_segment(0) {}
+
+	/// Removes all keyframes
+	void clear()
+	{
+		m_times.clear();
+		m_values.clear();
+		m_segment = 0;
+	}
+
+	/// Adds a keyframe.  Call sort() once all of the keyframes have been added.
+	void push_back(const time_t& Time, const value_t& Value)
+	{
+		m_times.push_back(Time);
+		m_values.push_back(Value);
+	}
+
+	/// Sorts keyframes by time.  If several keyframes share a time, the first one added is kept.
+	void sort()
+	{
+		std::vector<std::pair<time_t, k3d::uint_t> > order;
+		order.reserve(m_times.size());
+		for(k3d::uint_t i = 0; i != m_times.size(); ++i)
+			order.push_back(std::make_pair(m_times[i], i));
+		std::sort(order.begin(), order.end());
+
+		std::vector<time_t> times;
+		std::vector<value_t> values;
+		times.reserve(order.size());
+		values.reserve(order.size());
+		for(k3d::uint_t i = 0; i != order.size(); ++i)
+		{
+			if(!times.empty() && times.back() == order[i].first)
+				continue;
+			times.push_back(order[i].first);
+			values.push_back(m_values[order[i].second]);
+		}
+
+		m_times.swap(times);
+		m_values.swap(values);
+		m_segment = 0;
+	}
+
+	const k3d::uint_t size() const
+	{
+		return m_times.size();
+	}
+
+	const time_t& time(const k3d::uint_t Index) const
+	{
+		return m_times[Index];
+	}
+
+	const value_t& value(const k3d::uint_t Index) const
+	{
+		return m_values[Index];
+	}
+
+	/// Returns true iff Time lies between the first and last keyframes (inclusive), so it can be interpolated
+	const bool covers(const time_t& Time) const
+	{
+		return !m_times.empty() && !(Time < m_times.front()) && !(m_times.back() < Time);
+	}
+
+	/// Returns the index of the first keyframe whose time isn't less than Time, like std::lower_bound().  Checks the most
+	/// recently used segment and its successor before falling back to a binary search.
+	const k3d::uint_t lower_bound(const time_t& Time) const
+	{
+		const k3d::uint_t count = m_times.size();
+		for(k3d::uint_t segment = m_segment; segment <= count && segment <= m_segment + 1; ++segment)
+		{
+			if((segment == 0 || m_times[segment - 1] < Time) && (segment == count || !(m_times[segment] < Time)))
+			{
+				m_segment = segment;
+				return segment;
+			}
+		}
+
+		m_segment = std::lower_bound(m_times.begin(), m_times.end(), Time) - m_times.begin();
+		return m_segment;
+	}
+
+private:
+	std::vector<time_t> m_times;
+	std::vector<value_t> m_values;
+	/// Caches the result of the most recent lookup
+	mutable k3d::uint_t m_segment;
+};
+
 /// Base class for interpolation methods for keyframed animations
 template<typename time_t, typename value_t>
 class interpolator : public k3d::node
@@ -50,10 +148,21 @@ class interpolator : public k3d::node
 public:
 	/// Stores the keyframe data
 	typedef std::map<time_t, value_t> keyframes_t;
+	/// Stores compiled keyframe data
+	typedef keyframe_curve<time_t, value_t> curve_t;
 	
 	interpolator(k3d::iplugin_factory& Factory, k3d::idocument& Document) : base (Factory, Document) {}
 	/// Calculate the interpolation value at Time based on Keyframes. Throws insufficient_data_exception if there aren't enough keyframes around Time
 	virtual value_t interpolate(time_t Time, const keyframes_t& Keyframes) = 0;
+	/// Calculate the interpolation value at Time based on a compiled Curve. Throws insufficient_data_exception if there aren't enough keyframes around Time.
+	/// The default implementation converts the curve to keyframes_t, so derived classes should override it.
+	virtual value_t interpolate(time_t Time, const curve_t& Curve)
+	{
+		keyframes_t keyframes;
+		for(k3d::uint_t i = 0; i != Curve.size(); ++i)
+			keyframes.insert(std::make_pair(Curve.time(i), Curve.value(i)));
+		return interpolate(Time, keyframes);
+	}
 	
 	virtual ~interpolator() {}
 protected:
@@ -77,6 +186,26 @@ protected:
 		t_lower = found_key->first;
 		v_lower = found_key->second;
 	}  
+
+	/// Stores the keys and values of the key before and after Time in the non-const arguments
+	void get_surrounding_keys(const time_t& Time, const curve_t& Curve, time_t& t_lower, time_t& t_upper, value_t& v_lower, value_t& v_upper)
+	{
+		const k3d::uint_t found_key = Curve.lower_bound(Time);
+		if (found_key == 0 && Curve.size() && Curve.time(0) == Time)
+		{
+			t_upper = Curve.time(0);
+			v_upper = Curve.value(0);
+			t_lower = t_upper;
+			v_lower = v_upper;
+			return;
+		}
+		if (found_key == 0 || found_key == Curve.size())
+			throw insufficient_data_exception(); // no key before or after Time
+		t_upper = Curve.time(found_key);
+		v_upper = Curve.value(found_key);
+		t_lower = Curve.time(found_key - 1);
+		v_lower = Curve.value(found_key - 1);
+	}
 };
 
 
@@ -95,6 +224,13 @@ public:
 		base::get_surrounding_keys(Time, Keyframes, t_lower, t_upper, v_lower, v_upper); 
 		return lerp(t_lower, t_upper, v_lower, v_upper, Time);
 	}
+	virtual value_t interpolate(time_t Time, const typename base::curve_t& Curve)
+	{
+		time_t t_lower, t_upper;
+		value_t v_lower, v_upper;
+		base::get_surrounding_keys(Time, Curve, t_lower, t_upper, v_lower, v_upper); 
+		return lerp(t_lower, t_upper, v_lower, v_upper, Time);
+	}
 protected:
 	value_t lerp(const time_t& t_lower, const time_t& t_upper, const value_t& v_lower, const value_t& v_upper, const time_t& Time)
 	{
@@ -119,6 +255,13 @@ public:
 		base::get_surrounding_keys(Time, Keyframes, t_lower, t_upper, v_lower, v_upper); 
 		return lerp(t_lower, t_upper, v_lower, v_upper, Time);
 	} 
+	virtual value_t interpolate(time_t Time, const typename base::curve_t& Curve)
+	{
+		time_t t_lower, t_upper;
+		value_t v_lower, v_upper;
+		base::get_surrounding_keys(Time, Curve, t_lower, t_upper, v_lower, v_upper); 
+		return lerp(t_lower, t_upper, v_lower, v_upper, Time);
+	} 
 protected:
 	k3d::matrix4 lerp(const double& t_lower, const double& t_upper, const k3d::matrix4& v_lower, const k3d::matrix4& v_upper, const double& Time)
 	{
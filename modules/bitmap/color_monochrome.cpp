@@ -55,27 +55,30 @@ public:
 			k3d::hint::convert<k3d::hint::any, k3d::hint::bitmap_pixels_changed> >(make_update_bitmap_slot()));
 	}
 
-	struct functor
+	class operation :
+		public k3d::pixel_operation
 	{
-		functor(const double RedWeight, const double GreenWeight, const double BlueWeight) :
+	public:
+		operation(const double RedWeight, const double GreenWeight, const double BlueWeight) :
 			red_weight(RedWeight),
 			green_weight(GreenWeight),
 			blue_weight(BlueWeight)
 		{
 		}
 
-		k3d::pixel operator()(const k3d::pixel& Input) const
+		void apply(k3d::pixel_block& Block) const
 		{
-			const double value = 
-				red_weight * boost::gil::get_color(Input, boost::gil::red_t()) +
-				green_weight * boost::gil::get_color(Input, boost::gil::green_t()) + 
-				blue_weight * boost::gil::get_color(Input, boost::gil::blue_t());
-
-			return k3d::pixel(
-				value,
-				value,
-				value,
-				boost::gil::get_color(Input, boost::gil::alpha_t()));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+			{
+				const double value =
+					red_weight * Block.red[i] +
+					green_weight * Block.green[i] +
+					blue_weight * Block.blue[i];
+
+				Block.red[i] = value;
+				Block.green[i] = value;
+				Block.blue[i] = value;
+			}
 		}
 
 		const double red_weight;
@@ -83,10 +86,15 @@ public:
 		const double blue_weight;
 	};
 
+	k3d::pixel_operation* create_pixel_operation()
+	{
+		return new operation(m_red_weight.pipeline_value(), m_green_weight.pipeline_value(), m_blue_weight.pipeline_value());
+	}
+
 	void on_assign_pixels(const k3d::bitmap& Input, k3d::bitmap& Output)
 	{
 		k3d::ipipeline_profiler::profile profile(document().pipeline_profiler(), *this, "Update Bitmap");
-		boost::gil::transform_pixels(const_view(Input), view(Output), functor(m_red_weight.pipeline_value(), m_green_weight.pipeline_value(), m_blue_weight.pipeline_value()));
+		base::on_assign_pixels(Input, Output);
 	}
 
 	static k3d::iplugin_factory& get_factory()
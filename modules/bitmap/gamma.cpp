@@ -49,28 +49,36 @@ public:
 			k3d::hint::convert<k3d::hint::any, k3d::hint::bitmap_pixels_changed> >(make_update_bitmap_slot()));
 	}
 
-	struct functor
+	class operation :
+		public k3d::pixel_operation
 	{
-		functor(const double Gamma) :
+	public:
+		operation(const double Gamma) :
 			gamma(Gamma ? 1.0 / Gamma : 1.0)
 		{
 		}
 
-		k3d::pixel operator()(const k3d::pixel& Input)
+		void apply(k3d::pixel_block& Block) const
 		{
-			return k3d::pixel(
-				std::pow(static_cast<double>(boost::gil::get_color(Input, boost::gil::red_t())), gamma),
-				std::pow(static_cast<double>(boost::gil::get_color(Input, boost::gil::green_t())), gamma),
-				std::pow(static_cast<double>(boost::gil::get_color(Input, boost::gil::blue_t())), gamma),
-				boost::gil::get_color(Input, boost::gil::alpha_t()));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.red[i] = std::pow(static_cast<double>(Block.red[i]), gamma);
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.green[i] = std::pow(static_cast<double>(Block.green[i]), gamma);
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.blue[i] = std::pow(static_cast<double>(Block.blue[i]), gamma);
+		}
+
+		const k3d::bool_t separable() const
+		{
+			return true;
 		}
 
 		const double gamma;
 	};
 
-	void on_assign_pixels(const k3d::bitmap& Input, k3d::bitmap& Output)
+	k3d::pixel_operation* create_pixel_operation()
 	{
-		boost::gil::transform_pixels(const_view(Input), view(Output), functor(m_gamma.pipeline_value()));
+		return new operation(m_gamma.pipeline_value());
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -47,21 +47,29 @@ public:
 	{
 	}
 
-	struct functor
+	class operation :
+		public k3d::pixel_operation
 	{
-		k3d::pixel operator()(const k3d::pixel& Input)
+	public:
+		void apply(k3d::pixel_block& Block) const
 		{
-			return k3d::pixel(
-				boost::gil::channel_invert(boost::gil::get_color(Input, boost::gil::red_t())),
-				boost::gil::channel_invert(boost::gil::get_color(Input, boost::gil::green_t())),
-				boost::gil::channel_invert(boost::gil::get_color(Input, boost::gil::blue_t())),
-				boost::gil::get_color(Input, boost::gil::alpha_t()));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.red[i] = 1.0f - Block.red[i];
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.green[i] = 1.0f - Block.green[i];
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.blue[i] = 1.0f - Block.blue[i];
+		}
+
+		const k3d::bool_t separable() const
+		{
+			return true;
 		}
 	};
 
-	void on_assign_pixels(const k3d::bitmap& Input, k3d::bitmap& Output)
+	k3d::pixel_operation* create_pixel_operation()
 	{
-		boost::gil::transform_pixels(const_view(Input), view(Output), functor());
+		return new operation();
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -49,33 +49,34 @@ public:
 			k3d::hint::convert<k3d::hint::any, k3d::hint::bitmap_pixels_changed> >(make_update_bitmap_slot()));
 	}
 
-	struct functor
+	class operation :
+		public k3d::pixel_operation
 	{
-		functor(const double Threshold) :
+	public:
+		operation(const double Threshold) :
 			threshold(Threshold)
 		{
 		}
 
-		k3d::pixel operator()(const k3d::pixel& Input)
+		void apply(k3d::pixel_block& Block) const
 		{
-			const half red = boost::gil::get_color(Input, boost::gil::red_t());
-			const half green = boost::gil::get_color(Input, boost::gil::green_t());
-			const half blue = boost::gil::get_color(Input, boost::gil::blue_t());
-			const half alpha = boost::gil::get_color(Input, boost::gil::alpha_t());
-
-			return k3d::pixel(
-				red,
-				green,
-				std::min(green, blue),
-				blue > threshold ? 1 - (blue - std::max(red, green)) : 1);
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+			{
+				const k3d::float_t red = Block.red[i];
+				const k3d::float_t green = Block.green[i];
+				const k3d::float_t blue = Block.blue[i];
+
+				Block.blue[i] = std::min(green, blue);
+				Block.alpha[i] = blue > threshold ? 1 - (blue - std::max(red, green)) : 1;
+			}
 		}
 
 		const double threshold;
 	};
 
-	void on_assign_pixels(const k3d::bitmap& Input, k3d::bitmap& Output)
+	k3d::pixel_operation* create_pixel_operation()
 	{
-		boost::gil::transform_pixels(const_view(Input), view(Output), functor(m_threshold.pipeline_value()));
+		return new operation(m_threshold.pipeline_value());
 	}
 
 	static k3d::iplugin_factory& get_factory()
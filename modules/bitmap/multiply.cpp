@@ -49,31 +49,38 @@ public:
 			k3d::hint::convert<k3d::hint::any, k3d::hint::bitmap_pixels_changed> >(make_update_bitmap_slot()));
 	}
 
-	struct functor
+	class operation :
+		public k3d::pixel_operation
 	{
-		functor(const double Value) :
+	public:
+		operation(const double Value) :
 			value(Value)
 		{
 		}
 
-		k3d::pixel operator()(const k3d::pixel& Input) const
+		void apply(k3d::pixel_block& Block) const
 		{
-			return k3d::pixel(
-				boost::gil::get_color(Input, boost::gil::red_t()) * value,
-				boost::gil::get_color(Input, boost::gil::green_t()) * value,
-				boost::gil::get_color(Input, boost::gil::blue_t()) * value,
-				boost::gil::get_color(Input, boost::gil::alpha_t()));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.red[i] = Block.red[i] * value;
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.green[i] = Block.green[i] * value;
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.blue[i] = Block.blue[i] * value;
+		}
+
+		const k3d::bool_t separable() const
+		{
+			return true;
 		}
 
 		const double value;
 	};
 
-	void on_assign_pixels(const k3d::bitmap& Input, k3d::bitmap& Output)
+	k3d::pixel_operation* create_pixel_operation()
 	{
-		boost::gil::transform_pixels(const_view(Input), view(Output), functor(m_value.pipeline_value()));
+		return new operation(m_value.pipeline_value());
 	}
 
-	
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<multiply,
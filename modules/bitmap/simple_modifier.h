@@ -20,8 +20,8 @@
 // License along with this program; if not, write to the Free Software
 // Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
-#include <k3dsdk/bitmap_modifier.h>
 #include <k3dsdk/node.h>
+#include <k3dsdk/pixel_modifier.h>
 
 namespace module
 {
@@ -31,7 +31,7 @@ namespace bitmap
 
 class simple_modifier :
 	public k3d::node,
-	public k3d::bitmap_modifier<simple_modifier>
+	public k3d::pixel_modifier<simple_modifier>
 {
 	typedef k3d::node base;
 
@@ -40,12 +40,6 @@ public:
 		base(Factory, Document)
 	{
 	}
-
-private:
-	virtual void on_resize_bitmap(const k3d::bitmap& Input, k3d::bitmap& Output)
-	{
-		Output.recreate(Input.width(), Input.height());
-	}
 };
 
 } // namespace bitmap
@@ -58,9 +58,11 @@ public:
 			k3d::hint::convert<k3d::hint::any, k3d::hint::bitmap_pixels_changed> >(make_update_bitmap_slot()));
 	}
 
-	struct functor
+	class operation :
+		public k3d::pixel_operation
 	{
-		functor(const double RedThreshold, const double GreenThreshold, const double BlueThreshold, const double AlphaThreshold) :
+	public:
+		operation(const double RedThreshold, const double GreenThreshold, const double BlueThreshold, const double AlphaThreshold) :
 			red_threshold(RedThreshold),
 			green_threshold(GreenThreshold),
 			blue_threshold(BlueThreshold),
@@ -68,14 +70,21 @@ public:
 		{
 		}
 
-		k3d::pixel operator()(const k3d::pixel& Input) const
+		void apply(k3d::pixel_block& Block) const
 		{
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.red[i] = std::max(red_threshold, static_cast<double>(Block.red[i]));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.green[i] = std::max(green_threshold, static_cast<double>(Block.green[i]));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.blue[i] = std::max(blue_threshold, static_cast<double>(Block.blue[i]));
+			for(k3d::uint_t i = 0; i != Block.size; ++i)
+				Block.alpha[i] = std::max(alpha_threshold, static_cast<double>(Block.alpha[i]));
+		}
 
-			return k3d::pixel(
-				std::max(red_threshold, static_cast<double>(boost::gil::get_color(Input, boost::gil::red_t()))),
-				std::max(green_threshold, static_cast<double>(boost::gil::get_color(Input, boost::gil::green_t()))),
-				std::max(blue_threshold, static_cast<double>(boost::gil::get_color(Input, boost::gil::blue_t()))),
-				std::max(alpha_threshold, static_cast<double>(boost::gil::get_color(Input, boost::gil::alpha_t()))));
+		const k3d::bool_t separable() const
+		{
+			return true;
 		}
 
 		const double red_threshold;
@@ -84,9 +93,9 @@ public:
 		const double alpha_threshold;
 	};
 
-	void on_assign_pixels(const k3d::bitmap& Input, k3d::bitmap& Output)
+	k3d::pixel_operation* create_pixel_operation()
 	{
-		boost::gil::transform_pixels(const_view(Input), view(Output), functor(m_red_threshold.pipeline_value(), m_green_threshold.pipeline_value(), m_blue_threshold.pipeline_value(), m_alpha_threshold.pipeline_value()));
+		return new operation(m_red_threshold.pipeline_value(), m_green_threshold.pipeline_value(), m_blue_threshold.pipeline_value(), m_alpha_threshold.pipeline_value());
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -0,0 +1,1193 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Timothy M. Shead (tshead@k-3d.com)
+*/
+
+#include <k3d-i18n-config.h>
+#include <k3dsdk/algebra.h>
+#include <k3dsdk/blobby.h>
+#include <k3dsdk/bounding_box3.h>
+#include <k3dsdk/document_plugin_factory.h>
+#include <k3dsdk/hints.h>
+#include <k3dsdk/log.h>
+#include <k3dsdk/measurement.h>
+#include <k3dsdk/mesh_modifier.h>
+#include <k3dsdk/node.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/polyhedron.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+namespace module
+{
+
+namespace blobby
+{
+
+namespace detail
+{
+
+/// Field value at which the surface is extracted (matches RenderMan)
+const k3d::double_t threshold = 0.5;
+/// Number of cells along each side of a work item
+const k3d::uint_t block_size = 16;
+
+/// Field contribution of a primitive, given the squared distance in its normalized space (one at the center, zero at distance one)
+inline k3d::double_t falloff(const k3d::double_t DistanceSquared)
+{
+	if(DistanceSquared >= 1)
+		return 0;
+
+	const k3d::double_t t = 1 - DistanceSquared;
+	return t * t * t;
+}
+
+/// Stores the conservative region of space where a node in the field tree can be nonzero
+struct bounds
+{
+	bounds() :
+		unbounded(false)
+	{
+	}
+
+	k3d::bool_t unbounded;
+	k3d::bounding_box3 box;
+};
+
+/// Stores a blobby field as a flat tree (primitives first, then operators, addressed the same way as blobby operands)
+class field
+{
+public:
+	/// Describes how an operator is activated by its operands, so empty space can be culled
+	enum activation
+	{
+		/// The operator may be nonzero wherever any operand is nonzero
+		ANY_OPERAND,
+		/// The operator may only be nonzero where every operand is nonzero
+		ALL_OPERANDS,
+		/// The operator may only be nonzero where its first operand is nonzero
+		FIRST_OPERAND,
+	};
+
+	/// Returns a field for one blobby, or false if the blobby is malformed
+	k3d::bool_t compile(const k3d::blobby::const_primitive& Blobby, const k3d::uint_t Index)
+	{
+		const k3d::uint_t primitives_begin = Blobby.first_primitives[Index];
+		primitive_count = Blobby.primitive_counts[Index];
+		const k3d::uint_t operators_begin = Blobby.first_operators[Index];
+		const k3d::uint_t operator_count = Blobby.operator_counts[Index];
+		node_count = primitive_count + operator_count;
+
+		primitive_types.resize(primitive_count);
+		inverse_matrices.resize(primitive_count);
+		segment_starts.resize(primitive_count);
+		segment_axes.resize(primitive_count);
+		constants.resize(primitive_count);
+		node_bounds.assign(node_count, bounds());
+
+		for(k3d::uint_t i = 0; i != primitive_count; ++i)
+		{
+			const k3d::uint_t primitive = primitives_begin + i;
+			const k3d::uint_t first_float = Blobby.primitive_first_floats[primitive];
+			const k3d::uint_t float_count = Blobby.primitive_float_counts[primitive];
+			primitive_types[i] = Blobby.primitives[primitive];
+
+			switch(primitive_types[i])
+			{
+				case k3d::blobby::CONSTANT:
+				{
+					if(float_count < 1)
+						return false;
+					constants[i] = Blobby.floats[first_float];
+					node_bounds[i].unbounded = constants[i] != 0;
+					break;
+				}
+				case k3d::blobby::ELLIPSOID:
+				{
+					if(float_count < 16)
+						return false;
+					const k3d::matrix4 matrix = get_matrix(Blobby.floats, first_float);
+					inverse_matrices[i] = k3d::inverse(matrix);
+					node_bounds[i].box = transform_box(matrix, k3d::bounding_box3(1, -1, 1, -1, 1, -1));
+					break;
+				}
+				case k3d::blobby::SEGMENT:
+				{
+					if(float_count < 23)
+						return false;
+					const k3d::point3 start(Blobby.floats[first_float + 0], Blobby.floats[first_float + 1], Blobby.floats[first_float + 2]);
+					const k3d::point3 end(Blobby.floats[first_float + 3], Blobby.floats[first_float + 4], Blobby.floats[first_float + 5]);
+					const k3d::double_t radius = std::abs(Blobby.floats[first_float + 6]);
+					if(!radius)
+						return false;
+
+					const k3d::matrix4 matrix = get_matrix(Blobby.floats, first_float + 7);
+					inverse_matrices[i] = k3d::scale3(1 / radius) * k3d::inverse(matrix);
+					segment_starts[i] = start / radius;
+					segment_axes[i] = (end - start) / radius;
+					node_bounds[i].box = transform_box(matrix, k3d::bounding_box3(
+						std::max(start[0], end[0]) + radius, std::min(start[0], end[0]) - radius,
+						std::max(start[1], end[1]) + radius, std::min(start[1], end[1]) - radius,
+						std::max(start[2], end[2]) + radius, std::min(start[2], end[2]) - radius));
+					break;
+				}
+				default:
+					return false;
+			}
+		}
+
+		operator_types.resize(operator_count);
+		operator_activations.resize(operator_count);
+		operator_first_operands.resize(operator_count);
+		operator_operand_counts.resize(operator_count);
+		operands.clear();
+
+		for(k3d::uint_t i = 0; i != operator_count; ++i)
+		{
+			const k3d::uint_t op = operators_begin + i;
+			const k3d::uint_t node = primitive_count + i;
+			k3d::uint_t operands_begin = Blobby.operator_first_operands[op];
+			const k3d::uint_t operands_end = operands_begin + Blobby.operator_operand_counts[op];
+
+			operator_types[i] = Blobby.operators[op];
+			switch(operator_types[i])
+			{
+				case k3d::blobby::ADD:
+				case k3d::blobby::MAXIMUM:
+					operator_activations[i] = ANY_OPERAND;
+					++operands_begin;
+					break;
+				case k3d::blobby::MULTIPLY:
+				case k3d::blobby::MINIMUM:
+					operator_activations[i] = ALL_OPERANDS;
+					++operands_begin;
+					break;
+				case k3d::blobby::SUBTRACT:
+					operator_activations[i] = FIRST_OPERAND;
+					break;
+				case k3d::blobby::DIVIDE:
+					operator_activations[i] = ALL_OPERANDS;
+					break;
+				case k3d::blobby::NEGATE:
+				case k3d::blobby::IDENTITY:
+					operator_activations[i] = ANY_OPERAND;
+					break;
+				default:
+					return false;
+			}
+
+			if(operands_begin > operands_end)
+				return false;
+
+			operator_first_operands[i] = operands.size();
+			operator_operand_counts[i] = operands_end - operands_begin;
+
+			// Operands must refer to earlier nodes, so the tree can be evaluated in order ...
+			for(k3d::uint_t operand = operands_begin; operand != operands_end; ++operand)
+			{
+				if(Blobby.operands[operand] >= node)
+					return false;
+				operands.push_back(Blobby.operands[operand]);
+			}
+
+			// Compute bounds ...
+			bounds& result = node_bounds[node];
+			const k3d::uint_t first_operand = operator_first_operands[i];
+			const k3d::uint_t operand_count = operator_operand_counts[i];
+			switch(operator_activations[i])
+			{
+				case ANY_OPERAND:
+				{
+					for(k3d::uint_t j = 0; j != operand_count; ++j)
+					{
+						const bounds& operand_bounds = node_bounds[operands[first_operand + j]];
+						result.unbounded = result.unbounded || operand_bounds.unbounded;
+						result.box.insert(operand_bounds.box);
+					}
+					break;
+				}
+				case ALL_OPERANDS:
+				{
+					result.unbounded = true;
+					for(k3d::uint_t j = 0; j != operand_count; ++j)
+					{
+						const bounds& operand_bounds = node_bounds[operands[first_operand + j]];
+						if(operand_bounds.unbounded)
+							continue;
+
+						result.box = result.unbounded ? operand_bounds.box : intersect(result.box, operand_bounds.box);
+						result.unbounded = false;
+					}
+					break;
+				}
+				case FIRST_OPERAND:
+				{
+					if(operand_count)
+						result = node_bounds[operands[first_operand]];
+					break;
+				}
+			}
+		}
+
+		// Without operators, the field is the sum of its primitives ...
+		if(!operator_count)
+		{
+			operator_types.push_back(k3d::blobby::ADD);
+			operator_activations.push_back(ANY_OPERAND);
+			operator_first_operands.push_back(operands.size());
+			operator_operand_counts.push_back(primitive_count);
+			node_bounds.push_back(bounds());
+			for(k3d::uint_t i = 0; i != primitive_count; ++i)
+			{
+				operands.push_back(i);
+				node_bounds.back().unbounded = node_bounds.back().unbounded || node_bounds[i].unbounded;
+				node_bounds.back().box.insert(node_bounds[i].box);
+			}
+			++node_count;
+		}
+
+		root = node_count - 1;
+
+		// Create a lookup from each node to the operators that use it ...
+		node_first_parents.assign(node_count + 1, 0);
+		for(k3d::uint_t i = 0; i != operands.size(); ++i)
+			++node_first_parents[operands[i] + 1];
+		for(k3d::uint_t i = 0; i != node_count; ++i)
+			node_first_parents[i + 1] += node_first_parents[i];
+
+		parents.resize(operands.size());
+		parent_positions.resize(operands.size());
+		k3d::mesh::indices_t cursors(node_first_parents.begin(), node_first_parents.end() - 1);
+		for(k3d::uint_t i = 0; i != operator_types.size(); ++i)
+		{
+			for(k3d::uint_t j = 0; j != operator_operand_counts[i]; ++j)
+			{
+				const k3d::uint_t child = operands[operator_first_operands[i] + j];
+				parents[cursors[child]] = primitive_count + i;
+				parent_positions[cursors[child]++] = j;
+			}
+		}
+
+		return true;
+	}
+
+	/// Returns the region of space that must be sampled to find the surface, or an empty box
+	const k3d::bounding_box3 domain() const
+	{
+		if(!node_bounds[root].unbounded)
+			return node_bounds[root].box;
+
+		k3d::bounding_box3 result;
+		for(k3d::uint_t i = 0; i != primitive_count; ++i)
+		{
+			if(!node_bounds[i].unbounded)
+				result.insert(node_bounds[i].box);
+		}
+		return result;
+	}
+
+	/// Returns the smallest extent of any bounded primitive, used to choose a sampling resolution
+	const k3d::double_t feature_size() const
+	{
+		k3d::double_t result = std::numeric_limits<k3d::double_t>::max();
+		for(k3d::uint_t i = 0; i != primitive_count; ++i)
+		{
+			if(node_bounds[i].unbounded || node_bounds[i].box.empty())
+				continue;
+
+			result = std::min(result, std::min(node_bounds[i].box.width(), std::min(node_bounds[i].box.height(), node_bounds[i].box.depth())));
+		}
+		return result;
+	}
+
+	/// Returns the value of a primitive at a point
+	const k3d::double_t evaluate_primitive(const k3d::uint_t Primitive, const k3d::point3& Point) const
+	{
+		switch(primitive_types[Primitive])
+		{
+			case k3d::blobby::CONSTANT:
+				return constants[Primitive];
+			case k3d::blobby::ELLIPSOID:
+				return falloff(k3d::to_vector(inverse_matrices[Primitive] * Point).length2());
+			case k3d::blobby::SEGMENT:
+			{
+				const k3d::point3 point = inverse_matrices[Primitive] * Point;
+				const k3d::vector3& axis = segment_axes[Primitive];
+				const k3d::double_t axis_length2 = axis.length2();
+				const k3d::vector3 offset = point - segment_starts[Primitive];
+				const k3d::double_t t = axis_length2 ? std::max(0.0, std::min(1.0, (offset * axis) / axis_length2)) : 0.0;
+				return falloff((offset - t * axis).length2());
+			}
+		}
+
+		return 0;
+	}
+
+	k3d::uint_t primitive_count;
+	k3d::uint_t node_count;
+	k3d::uint_t root;
+
+	std::vector<k3d::int32_t> primitive_types;
+	std::vector<k3d::matrix4> inverse_matrices;
+	std::vector<k3d::point3> segment_starts;
+	std::vector<k3d::vector3> segment_axes;
+	std::vector<k3d::double_t> constants;
+
+	std::vector<k3d::int32_t> operator_types;
+	std::vector<activation> operator_activations;
+	k3d::mesh::indices_t operator_first_operands;
+	k3d::mesh::counts_t operator_operand_counts;
+	k3d::mesh::indices_t operands;
+
+	std::vector<bounds> node_bounds;
+	k3d::mesh::indices_t node_first_parents;
+	k3d::mesh::indices_t parents;
+	k3d::mesh::indices_t parent_positions;
+
+private:
+	/// Converts a RenderMan (column-major) matrix into a matrix4
+	static const k3d::matrix4 get_matrix(const k3d::mesh::doubles_t& Floats, const k3d::uint_t First)
+	{
+		return k3d::transpose(k3d::matrix4(
+			k3d::vector4(Floats[First + 0], Floats[First + 1], Floats[First + 2], Floats[First + 3]),
+			k3d::vector4(Floats[First + 4], Floats[First + 5], Floats[First + 6], Floats[First + 7]),
+			k3d::vector4(Floats[First + 8], Floats[First + 9], Floats[First + 10], Floats[First + 11]),
+			k3d::vector4(Floats[First + 12], Floats[First + 13], Floats[First + 14], Floats[First + 15])));
+	}
+
+	static const k3d::bounding_box3 transform_box(const k3d::matrix4& Matrix, const k3d::bounding_box3& Box)
+	{
+		k3d::bounding_box3 result;
+		for(k3d::uint_t i = 0; i != 8; ++i)
+			result.insert(Matrix * k3d::point3(i & 1 ? Box.px : Box.nx, i & 2 ? Box.py : Box.ny, i & 4 ? Box.pz : Box.nz));
+		return result;
+	}
+
+	static const k3d::bounding_box3 intersect(const k3d::bounding_box3& A, const k3d::bounding_box3& B)
+	{
+		if(A.empty() || B.empty())
+			return k3d::bounding_box3();
+
+		const k3d::double_t px = std::min(A.px, B.px);
+		const k3d::double_t nx = std::max(A.nx, B.nx);
+		const k3d::double_t py = std::min(A.py, B.py);
+		const k3d::double_t ny = std::max(A.ny, B.ny);
+		const k3d::double_t pz = std::min(A.pz, B.pz);
+		const k3d::double_t nz = std::max(A.nz, B.nz);
+		if(px < nx || py < ny || pz < nz)
+			return k3d::bounding_box3();
+
+		return k3d::bounding_box3(px, nx, py, ny, pz, nz);
+	}
+};
+
+/// Describes the sampling lattice for one blobby, divided into blocks of cells that are polygonized independently
+class lattice
+{
+public:
+	lattice(const k3d::bounding_box3& Domain, const k3d::double_t CellSize)
+	{
+		cell_size = CellSize;
+
+		// Pad the domain by one cell, so the surface is always closed ...
+		origin = k3d::point3(Domain.nx - CellSize, Domain.ny - CellSize, Domain.nz - CellSize);
+		sample_counts[0] = static_cast<k3d::uint_t>(std::ceil(Domain.width() / CellSize)) + 3;
+		sample_counts[1] = static_cast<k3d::uint_t>(std::ceil(Domain.height() / CellSize)) + 3;
+		sample_counts[2] = static_cast<k3d::uint_t>(std::ceil(Domain.depth() / CellSize)) + 3;
+
+		for(k3d::uint_t i = 0; i != 3; ++i)
+			block_counts[i] = (sample_counts[i] - 1 + block_size - 1) / block_size;
+	}
+
+	const k3d::point3 sample_point(const k3d::uint_t I, const k3d::uint_t J, const k3d::uint_t K) const
+	{
+		return k3d::point3(origin[0] + I * cell_size, origin[1] + J * cell_size, origin[2] + K * cell_size);
+	}
+
+	/// Returns the range of samples covered by a box along one axis, or false if no samples are covered
+	const k3d::bool_t sample_range(const k3d::bounding_box3& Box, const k3d::uint_t Axis, k3d::uint_t& Begin, k3d::uint_t& End) const
+	{
+		const k3d::double_t low = ((Axis == 0 ? Box.nx : Axis == 1 ? Box.ny : Box.nz) - origin[Axis]) / cell_size;
+		const k3d::double_t high = ((Axis == 0 ? Box.px : Axis == 1 ? Box.py : Box.pz) - origin[Axis]) / cell_size;
+		if(high < 0 || low > sample_counts[Axis] - 1)
+			return false;
+
+		Begin = static_cast<k3d::uint_t>(std::ceil(std::max(0.0, low)));
+		End = std::min(sample_counts[Axis], static_cast<k3d::uint_t>(std::floor(high)) + 1);
+		return Begin < End;
+	}
+
+	const k3d::uint_t block_count() const
+	{
+		return block_counts[0] * block_counts[1] * block_counts[2];
+	}
+
+	k3d::point3 origin;
+	k3d::double_t cell_size;
+	k3d::uint_t sample_counts[3];
+	k3d::uint_t block_counts[3];
+};
+
+/// Stores the intermediate results for one block of cells
+struct block
+{
+	block() :
+		vertex_offset(0)
+	{
+		std::fill(sample_begin, sample_begin + 3, 0);
+		std::fill(sample_end, sample_end + 3, 0);
+	}
+
+	/// Returns the index of a sample, relative to this block
+	const k3d::uint_t sample_index(const k3d::uint_t I, const k3d::uint_t J, const k3d::uint_t K) const
+	{
+		return ((K - sample_begin[2]) * (block_size + 1) + (J - sample_begin[1])) * (block_size + 1) + (I - sample_begin[0]);
+	}
+
+	/// Returns the index of a cell, relative to this block
+	const k3d::uint_t cell_index(const k3d::uint_t I, const k3d::uint_t J, const k3d::uint_t K) const
+	{
+		return ((K - sample_begin[2]) * block_size + (J - sample_begin[1])) * block_size + (I - sample_begin[0]);
+	}
+
+	k3d::uint_t sample_begin[3];
+	k3d::uint_t sample_end[3];
+	/// Field samples (empty if the block doesn't intersect the field)
+	std::vector<k3d::double_t> samples;
+	/// Vertex index for each cell, relative to this block, or -1 for cells that don't intersect the surface
+	std::vector<k3d::int32_t> cell_vertices;
+	std::vector<k3d::point3> vertices;
+	k3d::uint_t vertex_offset;
+	/// Global vertex indices for each quadrilateral whose dual edge is owned by this block
+	k3d::mesh::indices_t quads;
+};
+
+/// Evaluates the field and places one vertex in each cell that the surface passes through
+class sample_blocks
+{
+public:
+	sample_blocks(const field& Field, const lattice& Lattice, const k3d::mesh::indices_t& BlockFirstPrimitives, const k3d::mesh::indices_t& BlockPrimitives, const k3d::mesh::indices_t& UnboundedPrimitives, std::vector<block>& Blocks) :
+		m_field(Field),
+		m_lattice(Lattice),
+		m_block_first_primitives(BlockFirstPrimitives),
+		m_block_primitives(BlockPrimitives),
+		m_unbounded_primitives(UnboundedPrimitives),
+		m_blocks(Blocks)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& Range) const
+	{
+		// Scratch storage is reused for every block in the range ...
+		std::vector<k3d::uint_t> node_stamps(m_field.node_count, 0);
+		std::vector<k3d::uint_t> node_count_stamps(m_field.node_count, 0);
+		std::vector<k3d::uint_t> node_active_operands(m_field.node_count, 0);
+		std::vector<k3d::uint_t> node_slots(m_field.node_count, 0);
+		k3d::mesh::indices_t active_nodes;
+		k3d::mesh::indices_t worklist;
+		std::vector<child> children;
+		std::vector<k3d::double_t> buffers;
+		std::vector<const k3d::double_t*> operand_buffers;
+
+		const k3d::uint_t sample_count = (block_size + 1) * (block_size + 1) * (block_size + 1);
+
+		for(k3d::uint_t block_index = Range.begin(); block_index != Range.end(); ++block_index)
+		{
+			const k3d::uint_t stamp = block_index + 1;
+			block& current_block = m_blocks[block_index];
+
+			const k3d::uint_t block_i = block_index % m_lattice.block_counts[0];
+			const k3d::uint_t block_j = (block_index / m_lattice.block_counts[0]) % m_lattice.block_counts[1];
+			const k3d::uint_t block_k = block_index / (m_lattice.block_counts[0] * m_lattice.block_counts[1]);
+			const k3d::uint_t block_ijk[3] = { block_i, block_j, block_k };
+			for(k3d::uint_t axis = 0; axis != 3; ++axis)
+			{
+				current_block.sample_begin[axis] = block_ijk[axis] * block_size;
+				current_block.sample_end[axis] = std::min(m_lattice.sample_counts[axis], current_block.sample_begin[axis] + block_size + 1);
+			}
+
+			// Find the nodes that can be nonzero within this block ...
+			active_nodes.clear();
+			worklist.clear();
+			children.clear();
+
+			for(k3d::uint_t i = m_block_first_primitives[block_index]; i != m_block_first_primitives[block_index + 1]; ++i)
+				worklist.push_back(m_block_primitives[i]);
+			worklist.insert(worklist.end(), m_unbounded_primitives.begin(), m_unbounded_primitives.end());
+			for(k3d::uint_t i = 0; i != worklist.size(); ++i)
+				node_stamps[worklist[i]] = stamp;
+
+			while(!worklist.empty())
+			{
+				const k3d::uint_t node = worklist.back();
+				worklist.pop_back();
+				active_nodes.push_back(node);
+
+				for(k3d::uint_t i = m_field.node_first_parents[node]; i != m_field.node_first_parents[node + 1]; ++i)
+				{
+					const k3d::uint_t parent = m_field.parents[i];
+					const k3d::uint_t position = m_field.parent_positions[i];
+					const k3d::uint_t op = parent - m_field.primitive_count;
+					children.push_back(child(parent, position, node));
+
+					if(node_stamps[parent] == stamp)
+						continue;
+
+					k3d::bool_t activate = false;
+					switch(m_field.operator_activations[op])
+					{
+						case field::ANY_OPERAND:
+							activate = true;
+							break;
+						case field::ALL_OPERANDS:
+							if(node_count_stamps[parent] != stamp)
+							{
+								node_count_stamps[parent] = stamp;
+								node_active_operands[parent] = 0;
+							}
+							activate = ++node_active_operands[parent] == m_field.operator_operand_counts[op];
+							break;
+						case field::FIRST_OPERAND:
+							activate = position == 0;
+							break;
+					}
+
+					if(activate)
+					{
+						node_stamps[parent] = stamp;
+						worklist.push_back(parent);
+					}
+				}
+			}
+
+			if(node_stamps[m_field.root] != stamp)
+				continue;
+
+			// Evaluate every active node over the block, children first ...
+			std::sort(active_nodes.begin(), active_nodes.end());
+			std::sort(children.begin(), children.end());
+
+			buffers.resize(active_nodes.size() * sample_count);
+			for(k3d::uint_t i = 0; i != active_nodes.size(); ++i)
+				node_slots[active_nodes[i]] = i;
+
+			std::vector<child>::const_iterator current_child = children.begin();
+			for(k3d::uint_t i = 0; i != active_nodes.size(); ++i)
+			{
+				const k3d::uint_t node = active_nodes[i];
+				k3d::double_t* const buffer = &buffers[i * sample_count];
+
+				if(node < m_field.primitive_count)
+				{
+					evaluate_primitive(node, current_block, buffer);
+					continue;
+				}
+
+				while(current_child != children.end() && current_child->parent < node)
+					++current_child;
+
+				std::vector<child>::const_iterator children_begin = current_child;
+				while(current_child != children.end() && current_child->parent == node)
+					++current_child;
+
+				evaluate_operator(node, children_begin, current_child, node_stamps, stamp, node_slots, buffers, sample_count, operand_buffers, buffer);
+			}
+
+			const k3d::double_t* const root_buffer = &buffers[node_slots[m_field.root] * sample_count];
+			current_block.samples.assign(root_buffer, root_buffer + sample_count);
+
+			place_vertices(current_block);
+		}
+	}
+
+private:
+	/// Identifies an active operand of an operator
+	struct child
+	{
+		child(const k3d::uint_t Parent, const k3d::uint_t Position, const k3d::uint_t Node) :
+			parent(Parent),
+			position(Position),
+			node(Node)
+		{
+		}
+
+		bool operator<(const child& Other) const
+		{
+			if(parent != Other.parent)
+				return parent < Other.parent;
+			return position < Other.position;
+		}
+
+		k3d::uint_t parent;
+		k3d::uint_t position;
+		k3d::uint_t node;
+	};
+
+	void evaluate_primitive(const k3d::uint_t Primitive, const block& Block, k3d::double_t* const Buffer) const
+	{
+		const k3d::uint_t sample_count = (block_size + 1) * (block_size + 1) * (block_size + 1);
+		std::fill(Buffer, Buffer + sample_count, 0.0);
+
+		// Only the samples within the primitive's bounds can be nonzero ...
+		k3d::uint_t begin[3] = { Block.sample_begin[0], Block.sample_begin[1], Block.sample_begin[2] };
+		k3d::uint_t end[3] = { Block.sample_end[0], Block.sample_end[1], Block.sample_end[2] };
+		const bounds& primitive_bounds = m_field.node_bounds[Primitive];
+		if(!primitive_bounds.unbounded)
+		{
+			for(k3d::uint_t axis = 0; axis != 3; ++axis)
+			{
+				k3d::uint_t range_begin = 0;
+				k3d::uint_t range_end = 0;
+				if(!m_lattice.sample_range(primitive_bounds.box, axis, range_begin, range_end))
+					return;
+				begin[axis] = std::max(begin[axis], range_begin);
+				end[axis] = std::min(end[axis], range_end);
+				if(begin[axis] >= end[axis])
+					return;
+			}
+		}
+
+		for(k3d::uint_t k = begin[2]; k != end[2]; ++k)
+		{
+			for(k3d::uint_t j = begin[1]; j != end[1]; ++j)
+			{
+				for(k3d::uint_t i = begin[0]; i != end[0]; ++i)
+					Buffer[Block.sample_index(i, j, k)] = m_field.evaluate_primitive(Primitive, m_lattice.sample_point(i, j, k));
+			}
+		}
+	}
+
+	void evaluate_operator(
+		const k3d::uint_t Node,
+		const std::vector<child>::const_iterator ChildrenBegin,
+		const std::vector<child>::const_iterator ChildrenEnd,
+		const std::vector<k3d::uint_t>& NodeStamps,
+		const k3d::uint_t Stamp,
+		const std::vector<k3d::uint_t>& NodeSlots,
+		const std::vector<k3d::double_t>& Buffers,
+		const k3d::uint_t SampleCount,
+		std::vector<const k3d::double_t*>& OperandBuffers,
+		k3d::double_t* const Buffer) const
+	{
+		const k3d::uint_t op = Node - m_field.primitive_count;
+		const k3d::uint_t operand_count = m_field.operator_operand_counts[op];
+
+		// Collect the buffers of active operands by position (inactive operands are zero) ...
+		OperandBuffers.assign(operand_count, static_cast<const k3d::double_t*>(0));
+		for(std::vector<child>::const_iterator c = ChildrenBegin; c != ChildrenEnd; ++c)
+		{
+			if(NodeStamps[c->node] == Stamp)
+				OperandBuffers[c->position] = &Buffers[NodeSlots[c->node] * SampleCount];
+		}
+
+		std::fill(Buffer, Buffer + SampleCount, 0.0);
+
+		switch(m_field.operator_types[op])
+		{
+			case k3d::blobby::ADD:
+			{
+				for(k3d::uint_t i = 0; i != operand_count; ++i)
+				{
+					if(const k3d::double_t* const operand = OperandBuffers[i])
+					{
+						for(k3d::uint_t sample = 0; sample != SampleCount; ++sample)
+							Buffer[sample] += operand[sample];
+					}
+				}
+				break;
+			}
+			case k3d::blobby::MULTIPLY:
+			{
+				std::fill(Buffer, Buffer + SampleCount, 1.0);
+				for(k3d::uint_t i = 0; i != operand_count; ++i)
+				{
+					const k3d::double_t* const operand = OperandBuffers[i];
+					for(k3d::uint_t sample = 0; sample != SampleCount; ++sample)
+						Buffer[sample] *= operand[sample];
+				}
+				break;
+			}
+			case k3d::blobby::MAXIMUM:
+			case k3d::blobby::MINIMUM:
+			{
+				const k3d::bool_t maximum = m_field.operator_types[op] == k3d::blobby::MAXIMUM;
+				k3d::bool_t first = true;
+				for(k3d::uint_t i = 0; i != operand_count; ++i)
+				{
+					const k3d::double_t* const operand = OperandBuffers[i];
+					for(k3d::uint_t sample = 0; sample != SampleCount; ++sample)
+					{
+						const k3d::double_t value = operand ? operand[sample] : 0.0;
+						Buffer[sample] = first ? value : maximum ? std::max(Buffer[sample], value) : std::min(Buffer[sample], value);
+					}
+					first = false;
+				}
+				break;
+			}
+			case k3d::blobby::SUBTRACT:
+			{
+				for(k3d::uint_t i = 0; i != operand_count && i != 2; ++i)
+				{
+					if(const k3d::double_t* const operand = OperandBuffers[i])
+					{
+						for(k3d::uint_t sample = 0; sample != SampleCount; ++sample)
+							Buffer[sample] += i ? -operand[sample] : operand[sample];
+					}
+				}
+				break;
+			}
+			case k3d::blobby::DIVIDE:
+			{
+				if(operand_count < 2)
+					break;
+				for(k3d::uint_t sample = 0; sample != SampleCount; ++sample)
+					Buffer[sample] = OperandBuffers[1][sample] ? OperandBuffers[0][sample] / OperandBuffers[1][sample] : 0.0;
+				break;
+			}
+			case k3d::blobby::NEGATE:
+			case k3d::blobby::IDENTITY:
+			{
+				const k3d::double_t scale = m_field.operator_types[op] == k3d::blobby::NEGATE ? -1.0 : 1.0;
+				if(operand_count && OperandBuffers[0])
+				{
+					for(k3d::uint_t sample = 0; sample != SampleCount; ++sample)
+						Buffer[sample] = scale * OperandBuffers[0][sample];
+				}
+				break;
+			}
+		}
+	}
+
+	/// Places a vertex at the average of the surface crossings along the edges of each cell that the surface intersects
+	void place_vertices(block& Block) const
+	{
+		static const k3d::uint_t corners[12][2] =
+		{
+			{0, 1}, {2, 3}, {4, 5}, {6, 7},
+			{0, 2}, {1, 3}, {4, 6}, {5, 7},
+			{0, 4}, {1, 5}, {2, 6}, {3, 7},
+		};
+
+		Block.cell_vertices.assign(block_size * block_size * block_size, -1);
+		Block.vertices.clear();
+
+		for(k3d::uint_t k = Block.sample_begin[2]; k + 1 < Block.sample_end[2]; ++k)
+		{
+			for(k3d::uint_t j = Block.sample_begin[1]; j + 1 < Block.sample_end[1]; ++j)
+			{
+				for(k3d::uint_t i = Block.sample_begin[0]; i + 1 < Block.sample_end[0]; ++i)
+				{
+					k3d::double_t values[8];
+					k3d::uint_t inside_count = 0;
+					for(k3d::uint_t corner = 0; corner != 8; ++corner)
+					{
+						values[corner] = Block.samples[Block.sample_index(i + (corner & 1), j + ((corner >> 1) & 1), k + ((corner >> 2) & 1))];
+						if(values[corner] >= threshold)
+							++inside_count;
+					}
+
+					if(inside_count == 0 || inside_count == 8)
+						continue;
+
+					k3d::vector3 sum(0, 0, 0);
+					k3d::uint_t crossing_count = 0;
+					for(k3d::uint_t edge = 0; edge != 12; ++edge)
+					{
+						const k3d::uint_t a = corners[edge][0];
+						const k3d::uint_t b = corners[edge][1];
+						if((values[a] >= threshold) == (values[b] >= threshold))
+							continue;
+
+						const k3d::double_t t = (threshold - values[a]) / (values[b] - values[a]);
+						const k3d::vector3 corner_a((a & 1), ((a >> 1) & 1), ((a >> 2) & 1));
+						const k3d::vector3 corner_b((b & 1), ((b >> 1) & 1), ((b >> 2) & 1));
+						sum += corner_a + t * (corner_b - corner_a);
+						++crossing_count;
+					}
+
+					const k3d::vector3 offset = m_lattice.cell_size * (sum / crossing_count);
+					Block.cell_vertices[Block.cell_index(i, j, k)] = Block.vertices.size();
+					Block.vertices.push_back(m_lattice.sample_point(i, j, k) + offset);
+				}
+			}
+		}
+	}
+
+	const field& m_field;
+	const lattice& m_lattice;
+	const k3d::mesh::indices_t& m_block_first_primitives;
+	const k3d::mesh::indices_t& m_block_primitives;
+	const k3d::mesh::indices_t& m_unbounded_primitives;
+	std::vector<block>& m_blocks;
+};
+
+/// Creates a quadrilateral for each lattice edge that crosses the surface, connecting the vertices of the four cells around it
+class connect_blocks
+{
+public:
+	connect_blocks(const lattice& Lattice, std::vector<block>& Blocks) :
+		m_lattice(Lattice),
+		m_blocks(Blocks)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& Range) const
+	{
+		for(k3d::uint_t block_index = Range.begin(); block_index != Range.end(); ++block_index)
+		{
+			block& current_block = m_blocks[block_index];
+			current_block.quads.clear();
+			if(current_block.samples.empty())
+				continue;
+
+			// Each block owns the edges that start at its samples (excluding the samples shared with the next block) ...
+			k3d::uint_t owned_end[3];
+			for(k3d::uint_t axis = 0; axis != 3; ++axis)
+				owned_end[axis] = std::min(current_block.sample_begin[axis] + block_size, current_block.sample_end[axis]);
+
+			k3d::uint_t sample[3];
+			for(sample[2] = current_block.sample_begin[2]; sample[2] != owned_end[2]; ++sample[2])
+			{
+				for(sample[1] = current_block.sample_begin[1]; sample[1] != owned_end[1]; ++sample[1])
+				{
+					for(sample[0] = current_block.sample_begin[0]; sample[0] != owned_end[0]; ++sample[0])
+					{
+						const k3d::bool_t inside = current_block.samples[current_block.sample_index(sample[0], sample[1], sample[2])] >= threshold;
+
+						for(k3d::uint_t axis = 0; axis != 3; ++axis)
+						{
+							const k3d::uint_t u = (axis + 1) % 3;
+							const k3d::uint_t v = (axis + 2) % 3;
+
+							// The edge must have a cell on every side ...
+							if(sample[axis] + 1 >= m_lattice.sample_counts[axis])
+								continue;
+							if(sample[u] == 0 || sample[u] + 1 >= m_lattice.sample_counts[u])
+								continue;
+							if(sample[v] == 0 || sample[v] + 1 >= m_lattice.sample_counts[v])
+								continue;
+
+							k3d::uint_t next[3] = { sample[0], sample[1], sample[2] };
+							++next[axis];
+							const k3d::bool_t next_inside = current_block.samples[current_block.sample_index(next[0], next[1], next[2])] >= threshold;
+							if(inside == next_inside)
+								continue;
+
+							// Visit the cells counterclockwise around the edge, so the face normal points from inside to outside ...
+							static const k3d::uint_t offsets[4][2] = { {1, 1}, {0, 1}, {0, 0}, {1, 0} };
+							k3d::uint_t quad[4];
+							k3d::bool_t valid = true;
+							for(k3d::uint_t corner = 0; corner != 4; ++corner)
+							{
+								k3d::uint_t cell[3] = { sample[0], sample[1], sample[2] };
+								cell[u] -= offsets[corner][0];
+								cell[v] -= offsets[corner][1];
+
+								const k3d::int32_t vertex = get_vertex(cell);
+								if(vertex < 0)
+								{
+									valid = false;
+									break;
+								}
+								quad[corner] = vertex;
+							}
+							if(!valid)
+								continue;
+
+							if(inside)
+								current_block.quads.insert(current_block.quads.end(), quad, quad + 4);
+							else
+								current_block.quads.insert(current_block.quads.end(), std::reverse_iterator<k3d::uint_t*>(quad + 4), std::reverse_iterator<k3d::uint_t*>(quad));
+						}
+					}
+				}
+			}
+		}
+	}
+
+private:
+	/// Returns the global index of the vertex for a cell, or -1
+	const k3d::int32_t get_vertex(const k3d::uint_t* const Cell) const
+	{
+		const k3d::uint_t block_index =
+			((Cell[2] / block_size) * m_lattice.block_counts[1] + (Cell[1] / block_size)) * m_lattice.block_counts[0] + (Cell[0] / block_size);
+		const block& cell_block = m_blocks[block_index];
+		if(cell_block.cell_vertices.empty())
+			return -1;
+
+		const k3d::int32_t vertex = cell_block.cell_vertices[cell_block.cell_index(Cell[0], Cell[1], Cell[2])];
+		return vertex < 0 ? -1 : cell_block.vertex_offset + vertex;
+	}
+
+	const lattice& m_lattice;
+	std::vector<block>& m_blocks;
+};
+
+/// Polygonizes one blobby, appending points to the output mesh and faces to the given polyhedron
+void polygonize(const field& Field, const k3d::int32_t Resolution, const k3d::int32_t MaximumResolution, const k3d::uint_t Shell, k3d::imaterial* const Material, k3d::mesh& Output, k3d::polyhedron::primitive& Polyhedron)
+{
+	const k3d::bounding_box3 domain = Field.domain();
+	if(domain.empty())
+		return;
+
+	// Choose a cell size that resolves the smallest primitive, within the maximum resolution ...
+	const k3d::double_t longest_side = std::max(domain.width(), std::max(domain.height(), domain.depth()));
+	const k3d::double_t feature_size = Field.feature_size();
+	k3d::double_t cell_size = feature_size < std::numeric_limits<k3d::double_t>::max() ? feature_size / std::max(1, Resolution) : longest_side / std::max(1, MaximumResolution);
+	cell_size = std::max(cell_size, longest_side / std::max(1, MaximumResolution));
+	if(!(cell_size > 0))
+		return;
+
+	const lattice grid(domain, cell_size);
+	const k3d::uint_t block_count = grid.block_count();
+
+	// Bin bounded primitives by the blocks they overlap, so each block only evaluates nearby primitives ...
+	k3d::mesh::indices_t block_first_primitives(block_count + 1, 0);
+	k3d::mesh::indices_t block_primitives;
+	k3d::mesh::indices_t unbounded_primitives;
+	std::vector<k3d::uint_t> primitive_block_ranges(Field.primitive_count * 6, 0);
+	std::vector<k3d::bool_t> primitive_binned(Field.primitive_count, false);
+	for(k3d::uint_t pass = 0; pass != 2; ++pass)
+	{
+		k3d::mesh::indices_t cursors;
+		if(pass)
+		{
+			for(k3d::uint_t i = 0; i != block_count; ++i)
+				block_first_primitives[i + 1] += block_first_primitives[i];
+			block_primitives.resize(block_first_primitives.back());
+			cursors.assign(block_first_primitives.begin(), block_first_primitives.end() - 1);
+		}
+
+		for(k3d::uint_t primitive = 0; primitive != Field.primitive_count; ++primitive)
+		{
+			const bounds& primitive_bounds = Field.node_bounds[primitive];
+			if(primitive_bounds.unbounded)
+			{
+				if(pass)
+					unbounded_primitives.push_back(primitive);
+				continue;
+			}
+
+			k3d::uint_t* const range = &primitive_block_ranges[primitive * 6];
+			if(!pass)
+			{
+				primitive_binned[primitive] = true;
+				for(k3d::uint_t axis = 0; axis != 3; ++axis)
+				{
+					k3d::uint_t sample_begin = 0;
+					k3d::uint_t sample_end = 0;
+					if(!grid.sample_range(primitive_bounds.box, axis, sample_begin, sample_end))
+					{
+						primitive_binned[primitive] = false;
+						break;
+					}
+
+					range[axis * 2 + 0] = sample_begin ? (sample_begin - 1) / block_size : 0;
+					range[axis * 2 + 1] = std::min(grid.block_counts[axis], (sample_end - 1) / block_size + 1);
+				}
+			}
+
+			if(!primitive_binned[primitive])
+				continue;
+
+			for(k3d::uint_t k = range[4]; k != range[5]; ++k)
+			{
+				for(k3d::uint_t j = range[2]; j != range[3]; ++j)
+				{
+					for(k3d::uint_t i = range[0]; i != range[1]; ++i)
+					{
+						const k3d::uint_t block_index = (k * grid.block_counts[1] + j) * grid.block_counts[0] + i;
+						if(pass)
+							block_primitives[cursors[block_index]++] = primitive;
+						else
+							++block_first_primitives[block_index + 1];
+					}
+				}
+			}
+		}
+	}
+
+	// Sample each block and place vertices in parallel (blocks are coarse work items, so each is scheduled independently) ...
+	std::vector<block> blocks(block_count);
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, block_count, 1),
+		sample_blocks(Field, grid, block_first_primitives, block_primitives, unbounded_primitives, blocks));
+
+	// Assign global vertex indices ...
+	k3d::mesh::points_t& points = Output.points.writable();
+	k3d::mesh::selection_t& point_selection = Output.point_selection.writable();
+	const k3d::uint_t point_offset = points.size();
+
+	k3d::uint_t vertex_count = 0;
+	for(k3d::uint_t i = 0; i != block_count; ++i)
+	{
+		blocks[i].vertex_offset = point_offset + vertex_count;
+		vertex_count += blocks[i].vertices.size();
+	}
+
+	// Connect vertices in parallel (vertices are welded, since each cell has exactly one) ...
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, block_count, 1),
+		connect_blocks(grid, blocks));
+
+	points.reserve(point_offset + vertex_count);
+	for(k3d::uint_t i = 0; i != block_count; ++i)
+		points.insert(points.end(), blocks[i].vertices.begin(), blocks[i].vertices.end());
+	point_selection.resize(points.size(), 0.0);
+	Output.point_attributes.set_row_count(points.size());
+
+	for(k3d::uint_t i = 0; i != block_count; ++i)
+	{
+		const k3d::mesh::indices_t& quads = blocks[i].quads;
+		for(k3d::uint_t quad = 0; quad + 3 < quads.size(); quad += 4)
+		{
+			Polyhedron.face_shells.push_back(Shell);
+			Polyhedron.face_first_loops.push_back(Polyhedron.loop_first_edges.size());
+			Polyhedron.face_loop_counts.push_back(1);
+			Polyhedron.face_selections.push_back(0);
+			Polyhedron.face_materials.push_back(Material);
+
+			Polyhedron.loop_first_edges.push_back(Polyhedron.clockwise_edges.size());
+
+			Polyhedron.clockwise_edges.push_back(Polyhedron.clockwise_edges.size() + 1);
+			Polyhedron.clockwise_edges.push_back(Polyhedron.clockwise_edges.size() + 1);
+			Polyhedron.clockwise_edges.push_back(Polyhedron.clockwise_edges.size() + 1);
+			Polyhedron.clockwise_edges.push_back(Polyhedron.clockwise_edges.size() - 3);
+
+			Polyhedron.edge_selections.insert(Polyhedron.edge_selections.end(), 4, 0);
+			Polyhedron.vertex_points.insert(Polyhedron.vertex_points.end(), quads.begin() + quad, quads.begin() + quad + 4);
+			Polyhedron.vertex_selections.insert(Polyhedron.vertex_selections.end(), 4, 0);
+		}
+	}
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// blobby_to_polyhedron
+
+class blobby_to_polyhedron :
+	public k3d::mesh_modifier<k3d::node >
+{
+	typedef k3d::mesh_modifier<k3d::node > base;
+
+public:
+	blobby_to_polyhedron(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
+		base(Factory, Document),
+		m_resolution(init_owner(*this) + init_name("resolution") + init_label(_("Resolution")) + init_description(_("Number of cells across the smallest blobby primitive")) + init_value(8) + init_step_increment(1) + init_constraint(constraint::minimum<k3d::int32_t>(1)) + init_units(typeid(k3d::measurement::scalar))),
+		m_maximum_resolution(init_owner(*this) + init_name("maximum_resolution") + init_label(_("Maximum Resolution")) + init_description(_("Maximum number of cells along the longest side of each blobby")) + init_value(256) + init_step_increment(1) + init_constraint(constraint::minimum<k3d::int32_t>(1)) + init_units(typeid(k3d::measurement::scalar)))
+	{
+		m_resolution.changed_signal().connect(k3d::hint::converter<
+			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
+		m_maximum_resolution.changed_signal().connect(k3d::hint::converter<
+			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
+	}
+
+	void on_create_mesh(const k3d::mesh& Input, k3d::mesh& Output)
+	{
+		// Copy point data only ...
+		Output = k3d::mesh();
+		Output.points = Input.points;
+		Output.point_selection = Input.point_selection;
+		Output.point_attributes = Input.point_attributes;
+		if(!Output.points)
+			Output.points.create();
+		if(!Output.point_selection)
+			Output.point_selection.create();
+
+		const k3d::int32_t resolution = m_resolution.pipeline_value();
+		const k3d::int32_t maximum_resolution = m_maximum_resolution.pipeline_value();
+
+		// For each primitive ...
+		for(k3d::mesh::primitives_t::const_iterator primitive = Input.primitives.begin(); primitive != Input.primitives.end(); ++primitive)
+		{
+			// Convert blobby primitives to polyhedron primitives, passing-through all other primitive types ...
+			boost::scoped_ptr<k3d::blobby::const_primitive> blobby(k3d::blobby::validate(Input, **primitive));
+			if(!blobby)
+			{
+				Output.primitives.push_back(*primitive);
+				continue;
+			}
+
+			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::create(Output));
+
+			detail::field field;
+			const k3d::uint_t blobby_begin = 0;
+			const k3d::uint_t blobby_end = blobby_begin + blobby->first_primitives.size();
+			for(k3d::uint_t b = blobby_begin; b != blobby_end; ++b)
+			{
+				if(!field.compile(*blobby, b))
+				{
+					k3d::log() << error << factory().name() << ": skipping unsupported blobby " << b << std::endl;
+					continue;
+				}
+
+				polyhedron->shell_types.push_back(k3d::polyhedron::POLYGONS);
+				detail::polygonize(field, resolution, maximum_resolution, polyhedron->shell_types.size() - 1, blobby->materials[b], Output, *polyhedron);
+			}
+		}
+
+		k3d::mesh::bools_t unused_points;
+		k3d::mesh::lookup_unused_points(Output, unused_points);
+		k3d::mesh::delete_points(Output, unused_points);
+	}
+
+	void on_update_mesh(const k3d::mesh& Input, k3d::mesh& Output)
+	{
+	}
+
+	static k3d::iplugin_factory& get_factory()
+	{
+		static k3d::document_plugin_factory<blobby_to_polyhedron,
+				k3d::interface_list<k3d::imesh_source,
+				k3d::interface_list<k3d::imesh_sink> > > factory(
+				k3d::uuid(0x3c5a0e71, 0x9b4d4f28, 0xa1e6d203, 0x5f8b7c94),
+				"BlobbyToPolyhedron",
+				_("Polygonizes blobby implicit surfaces"),
+				"Blobby",
+				k3d::iplugin_factory::EXPERIMENTAL);
+
+		return factory;
+	}
+
+private:
+	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_resolution;
+	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_maximum_resolution;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// blobby_to_polyhedron_factory
+
+k3d::iplugin_factory& blobby_to_polyhedron_factory()
+{
+	return blobby_to_polyhedron::get_factory();
+}
+
+} // namespace blobby
+
+} // namespace module
+
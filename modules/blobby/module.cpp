@@ -30,6 +30,7 @@ namespace blobby
 {
 
 extern k3d::iplugin_factory& add_factory();
+extern k3d::iplugin_factory& blobby_to_polyhedron_factory();
 extern k3d::iplugin_factory& divide_factory();
 extern k3d::iplugin_factory& edges_to_blobby_factory();
 extern k3d::iplugin_factory& ellipsoid_factory();
@@ -47,6 +48,7 @@ extern k3d::iplugin_factory& subtract_factory();
 
 K3D_MODULE_START(Registry)
 	Registry.register_factory(module::blobby::add_factory());
+	Registry.register_factory(module::blobby::blobby_to_polyhedron_factory());
 	Registry.register_factory(module::blobby::divide_factory());
 	Registry.register_factory(module::blobby::edges_to_blobby_factory());
 	Registry.register_factory(module::blobby::ellipsoid_factory());
@@ -34,6 +34,7 @@
 #include <k3dsdk/euler_operations.h>
 #include <k3dsdk/imaterial.h>
 #include <k3dsdk/imulti_mesh_sink.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/ipipeline_profiler.h>
 #include <k3dsdk/material_sink.h>
 #include <k3dsdk/measurement.h>
@@ -196,8 +197,9 @@ private:
 				const k3d::mesh* const input_mesh = boost::any_cast<k3d::mesh*>(k3d::property::pipeline_value(*Property));
 				if(!input_mesh)
 					throw std::runtime_error("No mesh found in property " + Property->property_name());
-				// make a copy of the mesh, where we can alter the face selection so everything is selected
-				k3d::mesh mesh_all_faces_selected(*input_mesh);
+				// make an explicit copy of the mesh (flattening any instances), where we can alter the face selection so everything is selected
+				k3d::mesh mesh_all_faces_selected;
+				k3d::instances::flatten(*input_mesh, mesh_all_faces_selected);
 				boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron;
 				for(k3d::mesh::primitives_t::iterator primitive = mesh_all_faces_selected.primitives.begin(); primitive != mesh_all_faces_selected.primitives.end(); ++primitive)
 				{
@@ -0,0 +1,575 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Carlos Andres Dominguez Caballero (carlosadc at gmail dot com)
+*/
+
+#include "cloth_solver.h"
+
+#include <k3dsdk/log.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
+#include <k3dsdk/polyhedron.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace module
+{
+
+namespace cloth
+{
+
+namespace detail
+{
+
+/// Defines an upper bound on the number of integration steps per frame, so unreasonable parameters can't hang the pipeline
+const k3d::uint_t maximum_steps_per_frame = 10000;
+
+/// Orders springs by their endpoints, and then by type
+class spring_order
+{
+public:
+	spring_order(const std::vector<k3d::uint_t>& A, const std::vector<k3d::uint_t>& B, const std::vector<k3d::uint_t>& Types) :
+		a(A),
+		b(B),
+		types(Types)
+	{
+	}
+
+	bool operator()(const k3d::uint_t Left, const k3d::uint_t Right) const
+	{
+		if(a[Left] != a[Right])
+			return a[Left] < a[Right];
+		if(b[Left] != b[Right])
+			return b[Left] < b[Right];
+		return types[Left] < types[Right];
+	}
+
+private:
+	const std::vector<k3d::uint_t>& a;
+	const std::vector<k3d::uint_t>& b;
+	const std::vector<k3d::uint_t>& types;
+};
+
+/// Calculates the acceleration of each point in a range, from gravity, damping, and the springs attached to it
+class accelerate_points
+{
+public:
+	accelerate_points(
+		const std::vector<k3d::uint_t>& PointFirstSprings,
+		const std::vector<k3d::uint_t>& SpringPoints,
+		const std::vector<k3d::double_t>& SpringLengths,
+		const std::vector<k3d::double_t>& SpringConstants,
+		const std::vector<k3d::double_t>& InverseMasses,
+		const std::vector<k3d::double_t>& X, const std::vector<k3d::double_t>& Y, const std::vector<k3d::double_t>& Z,
+		const std::vector<k3d::double_t>& VX, const std::vector<k3d::double_t>& VY, const std::vector<k3d::double_t>& VZ,
+		std::vector<k3d::double_t>& AX, std::vector<k3d::double_t>& AY, std::vector<k3d::double_t>& AZ,
+		const k3d::double_t Gravity,
+		const k3d::double_t Damping) :
+		point_first_springs(PointFirstSprings),
+		spring_points(SpringPoints),
+		spring_lengths(SpringLengths),
+		spring_constants(SpringConstants),
+		inverse_masses(InverseMasses),
+		x(X), y(Y), z(Z),
+		vx(VX), vy(VY), vz(VZ),
+		ax(AX), ay(AY), az(AZ),
+		gravity(Gravity),
+		damping(Damping)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& Range) const
+	{
+		const k3d::uint_t point_begin = Range.begin();
+		const k3d::uint_t point_end = Range.end();
+		for(k3d::uint_t point = point_begin; point != point_end; ++point)
+		{
+			const k3d::double_t inverse_mass = inverse_masses[point];
+			if(!inverse_mass)
+			{
+				ax[point] = ay[point] = az[point] = 0;
+				continue;
+			}
+
+			k3d::double_t fx = 0;
+			k3d::double_t fy = 0;
+			k3d::double_t fz = 0;
+
+			const k3d::uint_t spring_end = point_first_springs[point + 1];
+			for(k3d::uint_t spring = point_first_springs[point]; spring != spring_end; ++spring)
+			{
+				const k3d::uint_t other = spring_points[spring];
+				const k3d::double_t dx = x[other] - x[point];
+				const k3d::double_t dy = y[other] - y[point];
+				const k3d::double_t dz = z[other] - z[point];
+				const k3d::double_t length = std::sqrt(dx * dx + dy * dy + dz * dz);
+				if(!length)
+					continue;
+
+				const k3d::double_t scale = spring_constants[spring] * (length - spring_lengths[spring]) / length;
+				fx += scale * dx;
+				fy += scale * dy;
+				fz += scale * dz;
+			}
+
+			ax[point] = fx * inverse_mass - damping * vx[point];
+			ay[point] = fy * inverse_mass - damping * vy[point];
+			az[point] = fz * inverse_mass - damping * vz[point] + gravity;
+		}
+	}
+
+private:
+	const std::vector<k3d::uint_t>& point_first_springs;
+	const std::vector<k3d::uint_t>& spring_points;
+	const std::vector<k3d::double_t>& spring_lengths;
+	const std::vector<k3d::double_t>& spring_constants;
+	const std::vector<k3d::double_t>& inverse_masses;
+	const std::vector<k3d::double_t>& x;
+	const std::vector<k3d::double_t>& y;
+	const std::vector<k3d::double_t>& z;
+	const std::vector<k3d::double_t>& vx;
+	const std::vector<k3d::double_t>& vy;
+	const std::vector<k3d::double_t>& vz;
+	std::vector<k3d::double_t>& ax;
+	std::vector<k3d::double_t>& ay;
+	std::vector<k3d::double_t>& az;
+	const k3d::double_t gravity;
+	const k3d::double_t damping;
+};
+
+/// Updates the velocity and then the position of each point in a range (semi-implicit Euler integration)
+class integrate_points
+{
+public:
+	integrate_points(
+		const std::vector<k3d::double_t>& AX, const std::vector<k3d::double_t>& AY, const std::vector<k3d::double_t>& AZ,
+		std::vector<k3d::double_t>& VX, std::vector<k3d::double_t>& VY, std::vector<k3d::double_t>& VZ,
+		std::vector<k3d::double_t>& X, std::vector<k3d::double_t>& Y, std::vector<k3d::double_t>& Z,
+		const k3d::double_t DeltaTime) :
+		ax(AX), ay(AY), az(AZ),
+		vx(VX), vy(VY), vz(VZ),
+		x(X), y(Y), z(Z),
+		dt(DeltaTime)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& Range) const
+	{
+		const k3d::uint_t point_begin = Range.begin();
+		const k3d::uint_t point_end = Range.end();
+		for(k3d::uint_t point = point_begin; point != point_end; ++point)
+		{
+			vx[point] += dt * ax[point];
+			vy[point] += dt * ay[point];
+			vz[point] += dt * az[point];
+
+			x[point] += dt * vx[point];
+			y[point] += dt * vy[point];
+			z[point] += dt * vz[point];
+		}
+	}
+
+private:
+	const std::vector<k3d::double_t>& ax;
+	const std::vector<k3d::double_t>& ay;
+	const std::vector<k3d::double_t>& az;
+	std::vector<k3d::double_t>& vx;
+	std::vector<k3d::double_t>& vy;
+	std::vector<k3d::double_t>& vz;
+	std::vector<k3d::double_t>& x;
+	std::vector<k3d::double_t>& y;
+	std::vector<k3d::double_t>& z;
+	const k3d::double_t dt;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// cloth_solver::parameters
+
+cloth_solver::parameters::parameters() :
+	mass(2.0),
+	gravity(-9.81),
+	damping(1.0),
+	stiffness(20.0),
+	bend_stiffness(20.0),
+	frame_time(1.0 / 24.0),
+	steps(10),
+	checkpoints(100)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// cloth_solver
+
+cloth_solver::cloth_solver() :
+	m_steps_per_frame(0),
+	m_frame(0),
+	m_checkpoint_interval(1)
+{
+	std::fill(m_spring_counts, m_spring_counts + 3, 0);
+}
+
+void cloth_solver::initialize(const k3d::mesh& Mesh, const k3d::mesh::points_t& Points, const k3d::mesh::selection_t& PointSelection, const parameters& Parameters)
+{
+	m_parameters = Parameters;
+	m_checkpoints.clear();
+	m_checkpoint_interval = 1;
+	m_frame = 0;
+
+	const k3d::uint_t point_count = Points.size();
+
+	m_spring_a.clear();
+	m_spring_b.clear();
+	m_spring_types.clear();
+
+	// Derive springs from the topology of each polyhedron ...
+	for(k3d::mesh::primitives_t::const_iterator primitive = Mesh.primitives.begin(); primitive != Mesh.primitives.end(); ++primitive)
+	{
+		const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Mesh, **primitive);
+		if(!topology)
+			continue;
+
+		boost::scoped_ptr<k3d::polyhedron::const_primitive> polyhedron(k3d::polyhedron::validate(Mesh, **primitive));
+		if(!polyhedron)
+			continue;
+
+		const k3d::mesh::indices_t& vertex_points = polyhedron->vertex_points;
+		const k3d::mesh::indices_t& clockwise_edges = polyhedron->clockwise_edges;
+
+		// Structural springs follow the edges ...
+		const k3d::uint_t edge_begin = 0;
+		const k3d::uint_t edge_end = edge_begin + clockwise_edges.size();
+		for(k3d::uint_t edge = edge_begin; edge != edge_end; ++edge)
+			add_spring(vertex_points[edge], vertex_points[clockwise_edges[edge]], STRUCTURAL);
+
+		// Shear springs connect non-adjacent points on the outer loop of each face ...
+		k3d::mesh::indices_t loop_points;
+		const k3d::uint_t face_begin = 0;
+		const k3d::uint_t face_end = face_begin + polyhedron->face_first_loops.size();
+		for(k3d::uint_t face = face_begin; face != face_end; ++face)
+		{
+			loop_points.clear();
+			const k3d::uint_t first_edge = polyhedron->loop_first_edges[polyhedron->face_first_loops[face]];
+			for(k3d::uint_t edge = first_edge; ;)
+			{
+				loop_points.push_back(vertex_points[edge]);
+
+				edge = clockwise_edges[edge];
+				if(edge == first_edge)
+					break;
+			}
+
+			const k3d::uint_t loop_size = loop_points.size();
+			if(loop_size < 4)
+				continue;
+
+			for(k3d::uint_t i = 0; i + 2 < loop_size; ++i)
+			{
+				for(k3d::uint_t j = i + 2; j != loop_size; ++j)
+				{
+					if(i == 0 && j == loop_size - 1)
+						continue;
+					add_spring(loop_points[i], loop_points[j], SHEAR);
+				}
+			}
+		}
+
+		// Bend springs connect neighbors on opposite sides of each point, found by walking the edges around it ...
+		k3d::mesh::indices_t fan_points;
+		const k3d::uint_t topology_point_count = std::min(point_count, topology->point_count);
+		for(k3d::uint_t point = 0; point != topology_point_count; ++point)
+		{
+			const k3d::uint_t out_edge_begin = topology->point_first_out_edges[point];
+			const k3d::uint_t out_edge_end = topology->point_first_out_edges[point + 1];
+			const k3d::uint_t valence = out_edge_end - out_edge_begin;
+
+			// Start at out-edges on the boundary, or at any out-edge for an interior point ...
+			k3d::bool_t boundary = false;
+			for(k3d::uint_t i = out_edge_begin; i != out_edge_end; ++i)
+				boundary = boundary || topology->boundary_edges[topology->point_out_edges[i]];
+
+			for(k3d::uint_t i = out_edge_begin; i != out_edge_end; ++i)
+			{
+				const k3d::uint_t first_edge = topology->point_out_edges[i];
+				if(boundary != topology->boundary_edges[first_edge])
+					continue;
+
+				fan_points.clear();
+				k3d::bool_t closed = false;
+				for(k3d::uint_t edge = first_edge; fan_points.size() <= valence;)
+				{
+					fan_points.push_back(vertex_points[clockwise_edges[edge]]);
+
+					const k3d::uint_t in_edge = topology->counterclockwise_edges[edge];
+					if(topology->boundary_edges[in_edge])
+					{
+						fan_points.push_back(vertex_points[in_edge]);
+						break;
+					}
+
+					edge = topology->companions[in_edge];
+					if(edge == first_edge)
+					{
+						closed = true;
+						break;
+					}
+				}
+
+				if(closed)
+				{
+					if(fan_points.size() % 2 == 0)
+					{
+						const k3d::uint_t half = fan_points.size() / 2;
+						for(k3d::uint_t j = 0; j != half; ++j)
+							add_spring(fan_points[j], fan_points[j + half], BEND);
+					}
+					break;
+				}
+
+				if(fan_points.size() >= 3)
+					add_spring(fan_points.front(), fan_points.back(), BEND);
+			}
+		}
+	}
+
+	// Sort springs and remove duplicates, keeping the strongest type ...
+	std::vector<k3d::uint_t> order(m_spring_a.size());
+	for(k3d::uint_t i = 0; i != order.size(); ++i)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), detail::spring_order(m_spring_a, m_spring_b, m_spring_types));
+
+	std::vector<k3d::uint_t> unique_springs;
+	for(k3d::uint_t i = 0; i != order.size(); ++i)
+	{
+		const k3d::uint_t spring = order[i];
+		if(m_spring_a[spring] >= point_count || m_spring_b[spring] >= point_count)
+			continue;
+		if(unique_springs.size() && m_spring_a[unique_springs.back()] == m_spring_a[spring] && m_spring_b[unique_springs.back()] == m_spring_b[spring])
+			continue;
+		unique_springs.push_back(spring);
+	}
+
+	// Convert springs into per-point rows, so forces can be accumulated in parallel without contention ...
+	std::fill(m_spring_counts, m_spring_counts + 3, 0);
+	m_point_first_springs.assign(point_count + 1, 0);
+	for(k3d::uint_t i = 0; i != unique_springs.size(); ++i)
+	{
+		const k3d::uint_t spring = unique_springs[i];
+		++m_point_first_springs[m_spring_a[spring] + 1];
+		++m_point_first_springs[m_spring_b[spring] + 1];
+		++m_spring_counts[m_spring_types[spring]];
+	}
+	for(k3d::uint_t point = 0; point != point_count; ++point)
+		m_point_first_springs[point + 1] += m_point_first_springs[point];
+
+	const k3d::uint_t row_size = m_point_first_springs.back();
+	m_spring_points.resize(row_size);
+	m_spring_lengths.resize(row_size);
+	m_spring_constants.resize(row_size);
+
+	std::vector<k3d::uint_t> cursors(m_point_first_springs.begin(), m_point_first_springs.end() - 1);
+	for(k3d::uint_t i = 0; i != unique_springs.size(); ++i)
+	{
+		const k3d::uint_t spring = unique_springs[i];
+		const k3d::uint_t a = m_spring_a[spring];
+		const k3d::uint_t b = m_spring_b[spring];
+		const k3d::double_t length = k3d::distance(Points[a], Points[b]);
+		const k3d::double_t constant = m_spring_types[spring] == BEND ? m_parameters.bend_stiffness : m_parameters.stiffness;
+
+		m_spring_points[cursors[a]] = b;
+		m_spring_lengths[cursors[a]] = length;
+		m_spring_constants[cursors[a]++] = constant;
+
+		m_spring_points[cursors[b]] = a;
+		m_spring_lengths[cursors[b]] = length;
+		m_spring_constants[cursors[b]++] = constant;
+	}
+
+	m_spring_a.clear();
+	m_spring_b.clear();
+	m_spring_types.clear();
+
+	// Initialize state ...
+	const k3d::double_t inverse_mass = point_count && m_parameters.mass > 0 ? point_count / m_parameters.mass : 0;
+	m_inverse_masses.assign(point_count, inverse_mass);
+	for(k3d::uint_t point = 0; point != point_count && point != PointSelection.size(); ++point)
+	{
+		if(PointSelection[point])
+			m_inverse_masses[point] = 0;
+	}
+
+	m_x.resize(point_count);
+	m_y.resize(point_count);
+	m_z.resize(point_count);
+	for(k3d::uint_t point = 0; point != point_count; ++point)
+	{
+		m_x[point] = Points[point][0];
+		m_y[point] = Points[point][1];
+		m_z[point] = Points[point][2];
+	}
+	m_vx.assign(point_count, 0);
+	m_vy.assign(point_count, 0);
+	m_vz.assign(point_count, 0);
+	m_ax.assign(point_count, 0);
+	m_ay.assign(point_count, 0);
+	m_az.assign(point_count, 0);
+
+	// Choose a step size that keeps the explicit spring and damping terms stable ...
+	k3d::double_t maximum_frequency = std::max(0.0, m_parameters.damping);
+	for(k3d::uint_t point = 0; point != point_count; ++point)
+	{
+		k3d::double_t constants = 0;
+		for(k3d::uint_t spring = m_point_first_springs[point]; spring != m_point_first_springs[point + 1]; ++spring)
+			constants += std::abs(m_spring_constants[spring]);
+		maximum_frequency = std::max(maximum_frequency, 2.0 * std::sqrt(constants * m_inverse_masses[point]));
+	}
+
+	m_steps_per_frame = std::max(static_cast<k3d::uint_t>(1), m_parameters.steps);
+	if(maximum_frequency > 0 && m_parameters.frame_time > 0)
+		m_steps_per_frame = std::max(m_steps_per_frame, static_cast<k3d::uint_t>(std::ceil(m_parameters.frame_time * maximum_frequency)));
+
+	if(m_steps_per_frame > detail::maximum_steps_per_frame)
+	{
+		k3d::log() << warning << "cloth simulation requires " << m_steps_per_frame << " steps per frame for stability, limiting to " << detail::maximum_steps_per_frame << std::endl;
+		m_steps_per_frame = detail::maximum_steps_per_frame;
+	}
+
+	// Frame zero is the rest shape ...
+	store_checkpoint();
+}
+
+k3d::uint_t cloth_solver::point_count() const
+{
+	return m_x.size();
+}
+
+k3d::uint_t cloth_solver::spring_count(const spring_type Type) const
+{
+	return m_spring_counts[Type];
+}
+
+k3d::uint_t cloth_solver::steps_per_frame() const
+{
+	return m_steps_per_frame;
+}
+
+k3d::uint_t cloth_solver::checkpoint_count() const
+{
+	return m_checkpoints.size();
+}
+
+void cloth_solver::get_frame(const k3d::uint_t Frame, k3d::mesh::points_t& Points)
+{
+	return_if_fail(m_checkpoints.size());
+	return_if_fail(Points.size() == point_count());
+
+	// Resume from the nearest earlier checkpoint, unless the current state is closer ...
+	const k3d::uint_t checkpoint = (--m_checkpoints.upper_bound(Frame))->first;
+	if(Frame < m_frame || checkpoint > m_frame)
+		restore_checkpoint(checkpoint);
+
+	const k3d::double_t delta_time = m_parameters.frame_time / m_steps_per_frame;
+	while(m_frame < Frame)
+	{
+		for(k3d::uint_t i = 0; i != m_steps_per_frame; ++i)
+			step(delta_time);
+
+		++m_frame;
+		if(0 == m_frame % m_checkpoint_interval && !m_checkpoints.count(m_frame))
+			store_checkpoint();
+	}
+
+	const k3d::uint_t point_count = this->point_count();
+	for(k3d::uint_t point = 0; point != point_count; ++point)
+		Points[point] = k3d::point3(m_x[point], m_y[point], m_z[point]);
+}
+
+void cloth_solver::add_spring(const k3d::uint_t A, const k3d::uint_t B, const spring_type Type)
+{
+	if(A == B)
+		return;
+
+	m_spring_a.push_back(std::min(A, B));
+	m_spring_b.push_back(std::max(A, B));
+	m_spring_types.push_back(Type);
+}
+
+void cloth_solver::store_checkpoint()
+{
+	checkpoint& state = m_checkpoints[m_frame];
+	state.x = m_x;
+	state.y = m_y;
+	state.z = m_z;
+	state.vx = m_vx;
+	state.vy = m_vy;
+	state.vz = m_vz;
+
+	// Keep the number of checkpoints bounded by doubling the interval between them.  Frame zero is always kept ...
+	const k3d::uint_t maximum_checkpoints = std::max(static_cast<k3d::uint_t>(2), m_parameters.checkpoints);
+	while(m_checkpoints.size() > maximum_checkpoints)
+	{
+		m_checkpoint_interval *= 2;
+		for(checkpoints_t::iterator i = m_checkpoints.begin(); i != m_checkpoints.end(); )
+		{
+			if(i->first % m_checkpoint_interval)
+				m_checkpoints.erase(i++);
+			else
+				++i;
+		}
+	}
+}
+
+void cloth_solver::restore_checkpoint(const k3d::uint_t Frame)
+{
+	const checkpoints_t::const_iterator state = m_checkpoints.find(Frame);
+	return_if_fail(state != m_checkpoints.end());
+
+	m_x = state->second.x;
+	m_y = state->second.y;
+	m_z = state->second.z;
+	m_vx = state->second.vx;
+	m_vy = state->second.vy;
+	m_vz = state->second.vz;
+	m_frame = Frame;
+}
+
+void cloth_solver::step(const k3d::double_t DeltaTime)
+{
+	const k3d::uint_t point_count = this->point_count();
+
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, point_count, k3d::parallel::grain_size()),
+		detail::accelerate_points(m_point_first_springs, m_spring_points, m_spring_lengths, m_spring_constants, m_inverse_masses, m_x, m_y, m_z, m_vx, m_vy, m_vz, m_ax, m_ay, m_az, m_parameters.gravity, m_parameters.damping));
+
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, point_count, k3d::parallel::grain_size()),
+		detail::integrate_points(m_ax, m_ay, m_az, m_vx, m_vy, m_vz, m_x, m_y, m_z, DeltaTime));
+}
+
+} // namespace cloth
+
+} // namespace module
+
@@ -1,259 +1,153 @@
 #ifndef MODULES_CLOTH_CLOTH_SOLVER_H
 #define MODULES_CLOTH_CLOTH_SOLVER_H
 
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Carlos Andres Dominguez Caballero (carlosadc at gmail dot com)
+*/
+
+#include <k3dsdk/mesh.h>
+
+#include <map>
 #include <vector>
-#include <iostream>
-#include "particle.h"
-#include "d_Vecf.h"
 
-/*helper functions to locate particle positions and velocities
-  within the X and f vectors*/
-unsigned P(unsigned p, unsigned c) { return 3*p*2+c; }
-unsigned V(unsigned p, unsigned c) { return 3*p*2+3+c; }
+namespace module
+{
 
-using namespace std;
+namespace cloth
+{
 
+/// Simulates cloth as a mass-spring system.  Structural, shear, and bend springs are derived from the edge topology of every
+/// polyhedron in a mesh, and the simulation is integrated in parallel using semi-implicit Euler steps over structure-of-arrays
+/// buffers that are allocated once.  The simulation state is checkpointed at regular intervals, so revisiting a frame only
+/// re-simulates from the nearest earlier checkpoint.  The interval doubles whenever the number of checkpoints exceeds a limit.
 class cloth_solver
 {
 public:
-	cloth_solver(unsigned num)
-	{
-		Particle tmp(0);
-		for (int i=0; i<num; i++) 
-			particles.push_back(tmp);
-
-		for (int i=0; i<num; i++)
-			particles[i].m = 2/(float)num;
-		
-		f.set_size(6*num);
-		X.set_size(6*num);
-		pnum = num;
-		t=0;
-		ks = 20;
-		vd = 2;
-		gravity = -9.81;
-		damping = 2;
-		stiffness = 20;
-	}
-	
-	void set_constants(double g, double d, double s)
-	{
-		gravity = g;
-		damping = d;
-		stiffness = s;
-	}
-	
-	void generate_particles(k3d::mesh::points_t Points)
-	{
-		for(int i=0; i<Points.size(); i++)
-			for(int j=0; j<3; j++)
-			{
-				particles[i].x[j] = Points[i][j];
-				particles[i].v[j] = 0;
-			}
-	}
-
-	void update_vertices(k3d::mesh::points_t& Points)
-	{
-		for(int i=0; i<Points.size(); i++)
-			for(int j=0; j<3; j++)
-				Points[i][j] = particles[i].x[j];
-
-	}
-
-	void compute_accelerations(d_Vecf Y, d_Vecf *out, const k3d::mesh::selection_t& PointSelection)
-	{
-		static d_Vecf W;
-		d_Vec3f tmp = d_Vec3f(0,0,0);
-		d_Vec3f p1, p2;
-		W.set_size(6*pnum);
-		float eightrt = sqrt(8);
-		ks = stiffness;
-		for(int i=0; i<pnum; i++)
-		{
-			p1 = d_Vec3f(Y[P(i,0)], Y[P(i,1)], Y[P(i,2)]);
-			//if(i!=0 && i!=5)
-			//	tmp = add_gravity(particles[i].m, -9.81);
-			//else
-			tmp = add_gravity(particles[i].m, gravity);
-
-			//if(i>0&&i<5)
-			{
-				//p2 = d_Vec3f(Y[P(i-1,0)], Y[P(i-1,1)], Y[P(i-1,2)]);
-				//tmp = tmp + add_spring(p1, p2, ks, 2);
-				//p2 = d_Vec3f(Y[P(i+1,0)], Y[P(i+1,1)], Y[P(i+1,2)]);
-				//tmp = tmp + add_spring(p1, p2, ks, 2);
-				//std::cout << "BLA: " << abs(p2[0]-p1[0]) << std::endl;
-			}
-
-/////////////////////////////////////
-
-			if(i>5)
-			{
-				p2 = d_Vec3f(Y[P(i-6,0)], Y[P(i-6,1)], Y[P(i-6,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 2);
-			}
-
-			if(i<30)
-			{
-				p2 = d_Vec3f(Y[P(i+6,0)], Y[P(i+6,1)], Y[P(i+6,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 2);
-			}
-
-			if(i%6 != 0)
-			{
-				p2 = d_Vec3f(Y[P(i-1,0)], Y[P(i-1,1)], Y[P(i-1,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 2);
-			}
-
-			if((i-5)%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i+1,0)], Y[P(i+1,1)], Y[P(i+1,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 2);
-			}
-
-/////////////////////////////////////////
-
-			if(i>5 && (i-5)%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i-5,0)], Y[P(i-5,1)], Y[P(i-5,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, eightrt);
-			}
-
-			if(i>5 && i%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i-7,0)], Y[P(i-7,1)], Y[P(i-7,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, eightrt);
-			}
-				
-			if(i<30 && (i-5)%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i+7,0)], Y[P(i+7,1)], Y[P(i+7,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, eightrt);
-			}
-
-			if(i<5 && i%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i+5,0)], Y[P(i+5,1)], Y[P(i+5,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, eightrt);
-			}
-
-/////////////////////////////////////////
-			if(i<24)
-			{
-				p2 = d_Vec3f(Y[P(i+12,0)], Y[P(i+12,1)], Y[P(i+12,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 4);
-			}
-			
-			if(i>11)
-			{
-				p2 = d_Vec3f(Y[P(i-12,0)], Y[P(i-12,1)], Y[P(i-12,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 4);
-			}
-
-			if((i-5)%6 !=0 && (i-4)%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i+2,0)], Y[P(i+2,1)], Y[P(i+2,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 4);
-			}
-
-			if(i%6 !=0 && (i-1)%6 !=0)
-			{
-				p2 = d_Vec3f(Y[P(i-2,0)], Y[P(i-2,1)], Y[P(i-2,2)]);
-				tmp = tmp + add_spring(p1, p2, ks, 4);
-			}
-///////////////////////////////////////////
-			
-			tmp = tmp + add_damping(d_Vec3f(Y[V(i,0)], Y[V(i,1)], Y[V(i,2)]), damping);
-
-
-			if(PointSelection.at(i)==1)
-				tmp = d_Vec3f(0,0,0);
-			//if(i==25)
-			//	tmp = d_Vec3f(0,0,0);
-
-			//if(i < 30)
-			//{
-			//	p2 = d_Vec3f(Y[P(i-6,0)], Y[P(i-6,1)], Y[P(i-6,2)]);
-			//	tmp = add_spring(p1,p2,ks,len(particles[i].x-particles[i-6].x));
-			//}
-	
-			W[P(i, 0)]= Y[V(i,0)];
-			W[P(i, 1)]= Y[V(i,1)];
-			W[P(i, 2)]= Y[V(i,2)];
-			W[V(i, 0)]= tmp[0]/particles[i].m;
-			W[V(i, 1)]= tmp[1]/particles[i].m;
-			W[V(i, 2)]= tmp[2]/particles[i].m;
-		}
-		*out= W;
-	}
-
-	void get_state()
+	/// Defines the kinds of spring derived from mesh topology
+	enum spring_type
 	{
-		for (int i=0; i<particles.size(); i++) 
-		{
-			X[P(i,0)]= particles[i].x[0];
-			X[P(i,1)]= particles[i].x[1];
-			X[P(i,2)]= particles[i].x[2];
-			X[V(i,0)]= particles[i].v[0];
-			X[V(i,1)]= particles[i].v[1];
-			X[V(i,2)]= particles[i].v[2];
-		}
-	}
-
-	void set_state()
+		/// Springs along polyhedron edges
+		STRUCTURAL = 0,
+		/// Springs across the diagonals of polygons with four-or-more sides
+		SHEAR = 1,
+		/// Springs that skip over a point, connecting neighbors on opposite sides of it
+		BEND = 2,
+	};
+
+	/// Stores simulation parameters
+	struct parameters
 	{
-		for (int i=0; i<particles.size(); i++) 
-		{
-			particles[i].t += t;
-			particles[i].x[0]= X[P(i,0)];
-			particles[i].x[1]= X[P(i,1)];
-			particles[i].x[2]= X[P(i,2)];
-			particles[i].v[0]= X[V(i,0)];
-			particles[i].v[1]= X[V(i,1)];
-			particles[i].v[2]= X[V(i,2)];
-		}
-	}
-
-	void rk_step(float dt, const k3d::mesh::selection_t& PointSelection)
+		parameters();
+
+		/// Total mass of the cloth, divided equally among its points
+		k3d::double_t mass;
+		/// Acceleration along the Z axis
+		k3d::double_t gravity;
+		/// Velocity damping coefficient
+		k3d::double_t damping;
+		/// Spring constant for structural and shear springs
+		k3d::double_t stiffness;
+		/// Spring constant for bend springs
+		k3d::double_t bend_stiffness;
+		/// Duration of one frame in seconds
+		k3d::double_t frame_time;
+		/// Minimum number of integration steps per frame (more are taken if required for stability)
+		k3d::uint_t steps;
+		/// Maximum number of checkpoints to keep (at least two)
+		k3d::uint_t checkpoints;
+	};
+
+	cloth_solver();
+
+	/// Derives springs from every polyhedron in a mesh, using the given points as the rest shape, and discards checkpoints.
+	/// Selected points are pinned in-place.
+	void initialize(const k3d::mesh& Mesh, const k3d::mesh::points_t& Points, const k3d::mesh::selection_t& PointSelection, const parameters& Parameters);
+	/// Returns the number of points in the simulation
+	k3d::uint_t point_count() const;
+	/// Returns the number of springs of the given type
+	k3d::uint_t spring_count(const spring_type Type) const;
+	/// Returns the number of integration steps taken for each frame
+	k3d::uint_t steps_per_frame() const;
+	/// Returns the number of checkpoints currently stored
+	k3d::uint_t checkpoint_count() const;
+
+	/// Returns simulated positions for a frame (frame zero is the rest shape), simulating forward from the current state or the
+	/// nearest earlier checkpoint if necessary
+	void get_frame(const k3d::uint_t Frame, k3d::mesh::points_t& Points);
+
+private:
+	/// Adds a spring between two points (duplicates are removed later)
+	void add_spring(const k3d::uint_t A, const k3d::uint_t B, const spring_type Type);
+	/// Integrates one time step
+	void step(const k3d::double_t DeltaTime);
+	/// Stores the current state as a checkpoint, thinning existing checkpoints if there are too many
+	void store_checkpoint();
+	/// Replaces the current state with a checkpoint
+	void restore_checkpoint(const k3d::uint_t Frame);
+
+	parameters m_parameters;
+	k3d::uint_t m_steps_per_frame;
+
+	/// Stores the endpoints and type of every spring, before they're converted to per-point rows
+	std::vector<k3d::uint_t> m_spring_a;
+	std::vector<k3d::uint_t> m_spring_b;
+	std::vector<k3d::uint_t> m_spring_types;
+	/// Stores the number of springs of each type
+	k3d::uint_t m_spring_counts[3];
+
+	/// Stores the first spring of each point, plus a final entry that stores the total (compressed-sparse-row)
+	std::vector<k3d::uint_t> m_point_first_springs;
+	/// Stores the opposite endpoint of each spring, for each point
+	std::vector<k3d::uint_t> m_spring_points;
+	/// Stores the rest length of each spring, for each point
+	std::vector<k3d::double_t> m_spring_lengths;
+	/// Stores the spring constant of each spring, for each point
+	std::vector<k3d::double_t> m_spring_constants;
+
+	/// Stores the inverse mass of each point (zero for pinned points)
+	std::vector<k3d::double_t> m_inverse_masses;
+	/// Stores the simulation state
+	std::vector<k3d::double_t> m_x, m_y, m_z;
+	std::vector<k3d::double_t> m_vx, m_vy, m_vz;
+	std::vector<k3d::double_t> m_ax, m_ay, m_az;
+
+	/// Stores the frame of the current simulation state
+	k3d::uint_t m_frame;
+
+	/// Stores everything needed to resume the simulation from a frame
+	struct checkpoint
 	{
-		//for(int i=0; i<pnum; i++)
-		//	particles[i].x = particles[i].x + d_Vec3f(0,0,dt);
-		static d_Vecf k1, k2, k3, k4;
-		k1.set_size(6*pnum);
-		k2.set_size(6*pnum);
-		k3.set_size(6*pnum);
-		k4.set_size(6*pnum);
-		get_state();
-		compute_accelerations(X, &k1, PointSelection);
-		k1 = k1*dt;
-		compute_accelerations(X+k2/2, &k2, PointSelection);
-		k2 = k2*dt;
-		compute_accelerations(X+k2/2, &k3, PointSelection);
-		k3 = k3*dt;
-		compute_accelerations(X+k3, &k4, PointSelection);
-		k4 = k4*dt;
-		X = X + k1/6 + k2/3 + k3/3 + k4/6;
-		t=dt;
-		set_state();
-	}
+		std::vector<k3d::double_t> x, y, z;
+		std::vector<k3d::double_t> vx, vy, vz;
+	};
+	/// Stores checkpoints by frame, at multiples of the checkpoint interval
+	typedef std::map<k3d::uint_t, checkpoint> checkpoints_t;
+	checkpoints_t m_checkpoints;
+	k3d::uint_t m_checkpoint_interval;
+};
 
-	unsigned S(unsigned r, unsigned c){ return r*pnum/(int)sqrt(pnum)+c; }
+} // namespace cloth
 
-	vector<Particle> particles;
-	d_Math::d_Vec3f generator;
-	int pnum;
-	d_Vecf X;
-	d_Vecf f;
-	int w, h;
-	float r;
-	float t;
-	double ks;
-	float vd;
-	double gravity;
-	double damping;
-	double stiffness;
-};
+} // namespace module
 
 #endif // !MODULES_CLOTH_CLOTH_SOLVER_H
 
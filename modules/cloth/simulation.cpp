@@ -25,15 +25,15 @@
 
 #include <k3dsdk/module.h>
 #include <k3d-i18n-config.h>
-#include <k3dsdk/algebra.h>
-#include <k3dsdk/axis.h>
+#include <k3dsdk/basic_math.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/measurement.h>
 #include <k3dsdk/mesh_deformation_modifier.h>
 
-#include "d_Vec3f.h"
 #include "cloth_solver.h"
 
+#include <cmath>
+
 namespace module
 {
 
@@ -48,39 +48,65 @@ public:
 	simulation(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
 		base(Factory, Document),
 		m_time(init_owner(*this) + init_name("time") + init_label(_("Time")) + init_description(_("Controls the current time displayed in the viewports.")) + init_value(0.0) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::time))),
+		m_start_time(init_owner(*this) + init_name("start_time") + init_label(_("Start Time")) + init_description(_("Time at which the simulation starts from the input shape.")) + init_value(0.0) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::time))),
+		m_frame_rate(init_owner(*this) + init_name("frame_rate") + init_label(_("Frame Rate")) + init_description(_("Number of simulated frames per second.")) + init_value(24.0) + init_step_increment(1.0) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum(1.0))),
+		m_steps(init_owner(*this) + init_name("steps") + init_label(_("Steps")) + init_description(_("Minimum number of integration steps per frame (more are taken when required for stability).")) + init_value(10) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(1))),
+		m_mass(init_owner(*this) + init_name("mass") + init_label(_("Mass")) + init_description(_("Total mass of cloth, divided equally among its points")) + init_value(2.0) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::scalar))),
 		m_damping(init_owner(*this) + init_name("damping") + init_label(_("Damping")) + init_description(_("Damping of cloth")) + init_value(1.0) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::scalar))),
 		m_gravity(init_owner(*this) + init_name("gravity") + init_label(_("Gravity")) + init_description(_("Gravity to affect the system")) + init_value(-9.81) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::scalar))),
-		m_stiffness(init_owner(*this) + init_name("stiffness") + init_label(_("Stiffness")) + init_description(_("Stiffness of cloth (k constant for spring structure)")) + init_value(20) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::scalar)))
+		m_stiffness(init_owner(*this) + init_name("stiffness") + init_label(_("Stiffness")) + init_description(_("Stiffness of cloth (k constant for structural and shear springs)")) + init_value(20) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::scalar))),
+		m_bend_stiffness(init_owner(*this) + init_name("bend_stiffness") + init_label(_("Bend Stiffness")) + init_description(_("Resistance of cloth to bending (k constant for bend springs)")) + init_value(20) + init_step_increment(0.1) + init_units(typeid(k3d::measurement::scalar))),
+		m_checkpoints(init_owner(*this) + init_name("checkpoints") + init_label(_("Checkpoints")) + init_description(_("Maximum number of simulation states kept for revisiting earlier frames.  Checkpoints are spaced further apart as the simulation runs longer.")) + init_value(100) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(2))),
+		m_reset(true)
 	{
-		m_mesh_selection.changed_signal().connect(make_reset_mesh_slot());
+		m_input_mesh.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_mesh_selection.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_start_time.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_frame_rate.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_steps.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_mass.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_damping.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_gravity.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_stiffness.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_bend_stiffness.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+		m_checkpoints.changed_signal().connect(sigc::mem_fun(*this, &simulation::on_reset_simulation));
+
+		m_mesh_selection.changed_signal().connect(make_update_mesh_slot());
 		m_time.changed_signal().connect(make_update_mesh_slot());
-		first_time = true;
+		m_start_time.changed_signal().connect(make_update_mesh_slot());
+		m_frame_rate.changed_signal().connect(make_update_mesh_slot());
+		m_steps.changed_signal().connect(make_update_mesh_slot());
+		m_mass.changed_signal().connect(make_update_mesh_slot());
+		m_damping.changed_signal().connect(make_update_mesh_slot());
+		m_gravity.changed_signal().connect(make_update_mesh_slot());
+		m_stiffness.changed_signal().connect(make_update_mesh_slot());
+		m_bend_stiffness.changed_signal().connect(make_update_mesh_slot());
 	}
 
 	void on_deform_mesh(const k3d::mesh& InputMesh, const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
 	{
-		const double damping = m_damping.pipeline_value();
-		const double gravity = m_gravity.pipeline_value();
-		const double stiffness = m_stiffness.pipeline_value();
-		//const k3d::mesh::indices_t& face_first_loops = *InputMesh.polyhedra->face_first_loops;
-		//const k3d::mesh::indices_t& loop_first_edges = *InputMesh.polyhedra->loop_first_edges;
-		//const k3d::mesh::indices_t& edge_points = *InputMesh.polyhedra->edge_points;
-
-		if(first_time)
+		const double frame_rate = m_frame_rate.pipeline_value();
+		const double elapsed = m_time.pipeline_value() - m_start_time.pipeline_value();
+		const k3d::uint_t frame = elapsed > 0 ? static_cast<k3d::uint_t>(k3d::round(elapsed * frame_rate)) : 0;
+
+		// Changing parameters, topology, or the rest shape discards checkpoints; scrubbing time resumes from the nearest one ...
+		if(m_reset || m_solver.point_count() != InputPoints.size())
 		{
-			solver = new cloth_solver(36);
-			solver->generate_particles(InputPoints);
-			first_time = false;
-		}		
-		else
-		{	
-			solver->set_constants(gravity, damping, stiffness);
-
-			for(int i=0; i<10; i++)
-				solver->rk_step(0.003, PointSelection);
+			cloth_solver::parameters parameters;
+			parameters.mass = m_mass.pipeline_value();
+			parameters.gravity = m_gravity.pipeline_value();
+			parameters.damping = m_damping.pipeline_value();
+			parameters.stiffness = m_stiffness.pipeline_value();
+			parameters.bend_stiffness = m_bend_stiffness.pipeline_value();
+			parameters.frame_time = 1.0 / frame_rate;
+			parameters.steps = m_steps.pipeline_value();
+			parameters.checkpoints = m_checkpoints.pipeline_value();
+
+			m_solver.initialize(InputMesh, InputPoints, PointSelection, parameters);
+			m_reset = false;
 		}
-		
-		solver->update_vertices(OutputPoints);
+
+		m_solver.get_frame(frame, OutputPoints);
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -90,18 +116,32 @@ public:
 				k3d::interface_list<k3d::imesh_sink > > > factory(
 				k3d::uuid(0xd6a72aa4, 0x9e426c45, 0x2429eaab, 0x634a2ff8),
 				"ClothSimulation",
-				_("Cloth simulation (currently for grids only)"),
+				_("Cloth simulation for polyhedra, with selected points pinned in-place"),
 				"Simulation",
 				k3d::iplugin_factory::EXPERIMENTAL);
 
 		return factory;
 	}
+
+private:
+	void on_reset_simulation(k3d::ihint*)
+	{
+		m_reset = true;
+	}
+
 	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_time;
+	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_start_time;
+	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, with_constraint, measurement_property, with_serialization) m_frame_rate;
+	k3d_data(k3d::int32_t, immutable_name, change_signal, no_undo, local_storage, with_constraint, measurement_property, with_serialization) m_steps;
+	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_mass;
 	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_damping;
 	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_gravity;
 	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_stiffness;
-	cloth_solver *solver;
-	bool first_time;
+	k3d_data(double, immutable_name, change_signal, no_undo, local_storage, no_constraint, measurement_property, with_serialization) m_bend_stiffness;
+	k3d_data(k3d::int32_t, immutable_name, change_signal, no_undo, local_storage, with_constraint, measurement_property, with_serialization) m_checkpoints;
+
+	cloth_solver m_solver;
+	bool m_reset;
 };
 
 } // namespace cloth
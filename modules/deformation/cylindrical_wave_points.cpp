@@ -58,33 +58,66 @@ public:
 		m_phase.changed_signal().connect(make_update_mesh_slot());
 	}
 
-	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
+	class wave :
+		public k3d::mesh_simple_deformation_modifier::point_deformation
 	{
-		const k3d::axis along = m_along.pipeline_value();
-		const double amplitude = m_amplitude.pipeline_value();
-		const double wavelength = m_wavelength.pipeline_value();
-		const double phase = m_phase.pipeline_value();
+	public:
+		wave(const k3d::axis Along, const double Amplitude, const double Wavelength, const double Phase) :
+			wavelength(Wavelength),
+			along(Along),
+			amplitude(Amplitude),
+			phase(Phase)
+		{
+		}
 
-		// Filter-out infinite frequencies ...
-		if(0 == wavelength)
-			return;
+		void deform(const k3d::uint_t Begin, const k3d::uint_t End, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& Points) const
+		{
+			// Filter-out infinite frequencies ...
+			if(0 == wavelength)
+				return;
 
+			for(k3d::uint_t point = Begin; point != End; ++point)
+				Points[point] = displace(Points[point], PointSelection[point]);
+		}
 
-		const size_t point_begin = 0;
-		const size_t point_end = point_begin + OutputPoints.size();
-		for(size_t point = point_begin; point != point_end; ++point)
+		/// Returns the displaced position, or the original position for points on the axis
+		const k3d::point3 displace(const k3d::point3& Position, const double Weight) const
 		{
-			k3d::point3 position = InputPoints[point];
-
-			const double wave_position = phase + (k3d::pi_times_2() * position[along] / wavelength);
+			const double wave_position = phase + (k3d::pi_times_2() * Position[along] / wavelength);
 			const double offset = amplitude * sin(wave_position);
 
-			const k3d::vector3 direction((k3d::X != along) * position[0], (k3d::Y != along) * position[1], (k3d::Z != along) * position[2]);
+			const k3d::vector3 direction((k3d::X != along) * Position[0], (k3d::Y != along) * Position[1], (k3d::Z != along) * Position[2]);
 			if(0 == direction.length2())
-				continue;
+				return Position;
 
-			OutputPoints[point] = k3d::mix(InputPoints[point], InputPoints[point] + offset * k3d::normalize(direction), PointSelection[point]);
+			return k3d::mix(Position, Position + offset * k3d::normalize(direction), Weight);
 		}
+
+		const double wavelength;
+
+	private:
+		const k3d::axis along;
+		const double amplitude;
+		const double phase;
+	};
+
+	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
+	{
+		const wave deformation(m_along.pipeline_value(), m_amplitude.pipeline_value(), m_wavelength.pipeline_value(), m_phase.pipeline_value());
+
+		// Filter-out infinite frequencies ...
+		if(0 == deformation.wavelength)
+			return;
+
+		const size_t point_begin = 0;
+		const size_t point_end = point_begin + OutputPoints.size();
+		for(size_t point = point_begin; point != point_end; ++point)
+			OutputPoints[point] = deformation.displace(InputPoints[point], PointSelection[point]);
+	}
+
+	k3d::mesh_simple_deformation_modifier::point_deformation* create_point_deformation()
+	{
+		return new wave(m_along.pipeline_value(), m_amplitude.pipeline_value(), m_wavelength.pipeline_value(), m_phase.pipeline_value());
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -27,6 +27,9 @@
 #include <k3dsdk/expression/parser.h>
 #include <k3dsdk/iuser_property.h>
 #include <k3dsdk/mesh_simple_deformation_modifier.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
 #include <k3dsdk/property.h>
 #include <k3dsdk/type_registry.h>
 #include <k3dsdk/user_property_changed_signal.h>
@@ -51,7 +54,8 @@ public:
 		m_x_function(init_owner(*this) + init_name("x_function") + init_label(_("X Function")) + init_description(_("Output X coordinate function, in terms of x, y, z, and any user-defined scalars.")) + init_value(k3d::string_t(_("x")))),
 		m_y_function(init_owner(*this) + init_name("y_function") + init_label(_("Y Function")) + init_description(_("Output Y coordinate function, in terms of x, y, z, and any user-defined scalars.")) + init_value(k3d::string_t(_("y")))),
 		m_z_function(init_owner(*this) + init_name("z_function") + init_label(_("Z Function")) + init_description(_("Output Z coordinate function, in terms of x, y, z, and any user-defined scalars.")) + init_value(k3d::string_t(_("z + sin(x)")))),
-		m_user_property_changed_signal(*this)
+		m_user_property_changed_signal(*this),
+		m_parsed(false)
 	{
 		m_mesh_selection.changed_signal().connect(make_update_mesh_slot());
 		m_x_function.changed_signal().connect(make_update_mesh_slot());
@@ -84,26 +88,19 @@ public:
 			variables += "," + (**property).property_name();
 			values.push_back(k3d::property::pipeline_value<double>(**property));
 		}
-			
-		k3d::expression::parser parser_x_component;
-		if(!parser_x_component.parse(m_x_function.pipeline_value(), variables))
-		{
-			k3d::log() << error << factory().name() << ": function parsing for x component failed: " << parser_x_component.last_parse_error() << std::endl;
+
+		if(!parse_functions(variables))
 			return;
-		}
-		k3d::expression::parser parser_y_component;
-		if(!parser_y_component.parse(m_y_function.pipeline_value(), variables))
+
+		// Evaluate functions on blocks of points in parallel, if we can ...
+		if(m_x_parser.block_evaluation() && m_y_parser.block_evaluation() && m_z_parser.block_evaluation())
 		{
-			k3d::log() << error << factory().name() << ": function parsing for y component failed: " << parser_y_component.last_parse_error() << std::endl;
+			k3d::parallel::parallel_for(
+				k3d::parallel::blocked_range<k3d::uint_t>(0, OutputPoints.size(), k3d::parallel::grain_size()),
+				evaluate_points(m_x_parser, m_y_parser, m_z_parser, values, InputPoints, PointSelection, OutputPoints));
 			return;
 		}
-		k3d::expression::parser parser_z_component;
-		if(!parser_z_component.parse(m_z_function.pipeline_value(), variables))
-		{
-			k3d::log() << error << factory().name() << ": function parsing for z component failed: " << parser_z_component.last_parse_error() << std::endl;
-			return;
-		}				
-		
+
 		//Evaluate functions on each point.
 		const k3d::uint_t point_begin = 0;
 		const k3d::uint_t point_end = point_begin + OutputPoints.size();
@@ -117,9 +114,9 @@ public:
 			values[2] = InputPoints[point].n[2];
 
 			OutputPoints[point] = k3d::point3(
-				parser_x_component.evaluate(&values[0]),
-				parser_y_component.evaluate(&values[0]),
-				parser_z_component.evaluate(&values[0])
+				m_x_parser.evaluate(&values[0]),
+				m_y_parser.evaluate(&values[0]),
+				m_z_parser.evaluate(&values[0])
 				);
 		}
 	}
@@ -144,7 +141,126 @@ private:
 	k3d_data(k3d::string_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_z_function;
 
 	k3d::user_property_changed_signal m_user_property_changed_signal;
-	
+
+	/// Parses the x, y, and z functions, reusing the cached parsers if neither the functions nor the variables have changed
+	bool parse_functions(const std::string& Variables)
+	{
+		const std::string x_function = m_x_function.pipeline_value();
+		const std::string y_function = m_y_function.pipeline_value();
+		const std::string z_function = m_z_function.pipeline_value();
+
+		if(m_parsed && Variables == m_parsed_variables && x_function == m_parsed_x_function && y_function == m_parsed_y_function && z_function == m_parsed_z_function)
+			return true;
+
+		m_parsed = false;
+
+		if(!m_x_parser.parse(x_function, Variables))
+		{
+			k3d::log() << error << factory().name() << ": function parsing for x component failed: " << m_x_parser.last_parse_error() << std::endl;
+			return false;
+		}
+		if(!m_y_parser.parse(y_function, Variables))
+		{
+			k3d::log() << error << factory().name() << ": function parsing for y component failed: " << m_y_parser.last_parse_error() << std::endl;
+			return false;
+		}
+		if(!m_z_parser.parse(z_function, Variables))
+		{
+			k3d::log() << error << factory().name() << ": function parsing for z component failed: " << m_z_parser.last_parse_error() << std::endl;
+			return false;
+		}
+
+		m_parsed = true;
+		m_parsed_variables = Variables;
+		m_parsed_x_function = x_function;
+		m_parsed_y_function = y_function;
+		m_parsed_z_function = z_function;
+
+		return true;
+	}
+
+	/// Evaluates the x, y, and z functions for a range of points, gathering selected points into blocks of coordinates
+	class evaluate_points
+	{
+	public:
+		evaluate_points(const k3d::expression::parser& XParser, const k3d::expression::parser& YParser, const k3d::expression::parser& ZParser, const std::vector<k3d::double_t>& Values, const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints) :
+			x_parser(XParser),
+			y_parser(YParser),
+			z_parser(ZParser),
+			values(Values),
+			input_points(InputPoints),
+			point_selection(PointSelection),
+			output_points(OutputPoints)
+		{
+		}
+
+		void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& Range) const
+		{
+			const k3d::uint_t block_size = 256;
+
+			std::vector<k3d::uint_t> block_points(block_size);
+			std::vector<k3d::double_t> coordinates(3 * block_size);
+			std::vector<k3d::double_t> results(3 * block_size);
+
+			// x, y, and z are read from the gathered coordinates, user-defined variables are the same for every point ...
+			std::vector<const k3d::double_t*> variables(values.size());
+			std::vector<k3d::uint_t> strides(values.size(), 0);
+			for(k3d::uint_t i = 0; i != 3; ++i)
+			{
+				variables[i] = &coordinates[i * block_size];
+				strides[i] = 1;
+			}
+			for(k3d::uint_t i = 3; i < values.size(); ++i)
+				variables[i] = &values[i];
+
+			const k3d::uint_t point_begin = Range.begin();
+			const k3d::uint_t point_end = Range.end();
+			for(k3d::uint_t point = point_begin; point != point_end; )
+			{
+				k3d::uint_t count = 0;
+				for(; point != point_end && count != block_size; ++point)
+				{
+					if(!point_selection[point])
+						continue;
+
+					block_points[count] = point;
+					coordinates[count] = input_points[point][0];
+					coordinates[block_size + count] = input_points[point][1];
+					coordinates[2 * block_size + count] = input_points[point][2];
+					++count;
+				}
+
+				if(!count)
+					continue;
+
+				x_parser.evaluate_block(&variables[0], &strides[0], count, &results[0]);
+				y_parser.evaluate_block(&variables[0], &strides[0], count, &results[block_size]);
+				z_parser.evaluate_block(&variables[0], &strides[0], count, &results[2 * block_size]);
+
+				for(k3d::uint_t i = 0; i != count; ++i)
+					output_points[block_points[i]] = k3d::point3(results[i], results[block_size + i], results[2 * block_size + i]);
+			}
+		}
+
+	private:
+		const k3d::expression::parser& x_parser;
+		const k3d::expression::parser& y_parser;
+		const k3d::expression::parser& z_parser;
+		const std::vector<k3d::double_t>& values;
+		const k3d::mesh::points_t& input_points;
+		const k3d::mesh::selection_t& point_selection;
+		k3d::mesh::points_t& output_points;
+	};
+
+	/// Caches parsed functions between updates
+	k3d::expression::parser m_x_parser;
+	k3d::expression::parser m_y_parser;
+	k3d::expression::parser m_z_parser;
+	bool m_parsed;
+	std::string m_parsed_variables;
+	std::string m_parsed_x_function;
+	std::string m_parsed_y_function;
+	std::string m_parsed_z_function;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -26,6 +26,7 @@
 
 #include <k3dsdk/algebra.h>
 #include <k3dsdk/mesh.h>
+#include <k3dsdk/mesh_simple_deformation_modifier.h>
 #include <k3dsdk/parallel/blocked_range.h>
 #include <k3dsdk/parallel/parallel_for.h>
 #include <k3dsdk/parallel/threads.h>
@@ -66,6 +67,26 @@ private:
 	const k3d::matrix4& transformation;
 };
 
+/// Point deformation that applies a linear transformation, so it can be fused with other deformations
+class linear_point_deformation :
+	public k3d::mesh_simple_deformation_modifier::point_deformation
+{
+public:
+	linear_point_deformation(const k3d::matrix4& Transformation) :
+		transformation(Transformation)
+	{
+	}
+
+	void deform(const k3d::uint_t Begin, const k3d::uint_t End, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& Points) const
+	{
+		for(k3d::uint_t point = Begin; point != End; ++point)
+			Points[point] = k3d::mix(Points[point], transformation * Points[point], PointSelection[point]);
+	}
+
+private:
+	const k3d::matrix4 transformation;
+};
+
 } // namespace deformation
 
 } // namespace module
@@ -60,31 +60,63 @@ public:
 		m_phase.changed_signal().connect(make_update_mesh_slot());
 	}
 
-	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
+	class wave :
+		public k3d::mesh_simple_deformation_modifier::point_deformation
 	{
-		const k3d::axis axis = m_axis.pipeline_value();
-		const k3d::axis along = m_along.pipeline_value();
-		const double amplitude = m_amplitude.pipeline_value();
-		const double wavelength = m_wavelength.pipeline_value();
-		const double phase = m_phase.pipeline_value();
+	public:
+		wave(const k3d::axis Axis, const k3d::axis Along, const double Amplitude, const double Wavelength, const double Phase) :
+			wavelength(Wavelength),
+			offset_filter(k3d::X == Axis, k3d::Y == Axis, k3d::Z == Axis),
+			along(Along),
+			amplitude(Amplitude),
+			phase(Phase)
+		{
+		}
+
+		void deform(const k3d::uint_t Begin, const k3d::uint_t End, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& Points) const
+		{
+			// Filter-out infinite frequencies ...
+			if(0 == wavelength)
+				return;
+
+			for(k3d::uint_t point = Begin; point != End; ++point)
+				Points[point] = displace(Points[point], PointSelection[point]);
+		}
+
+		const k3d::point3 displace(const k3d::point3& Position, const double Weight) const
+		{
+			const double wave_position = phase + (k3d::pi_times_2() * Position[along] / wavelength);
+			const double offset = amplitude * sin(wave_position);
+
+			return k3d::mix(Position, Position + (offset * offset_filter), Weight);
+		}
+
+		const double wavelength;
+
+	private:
+		const k3d::point3 offset_filter;
+		const k3d::axis along;
+		const double amplitude;
+		const double phase;
+	};
 
-		const k3d::point3 offset_filter(k3d::X == axis, k3d::Y == axis, k3d::Z == axis);
+	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
+	{
+		const wave deformation(m_axis.pipeline_value(), m_along.pipeline_value(), m_amplitude.pipeline_value(), m_wavelength.pipeline_value(), m_phase.pipeline_value());
 
 		// Filter-out infinite frequencies ...
-		if(0 == wavelength)
+		if(0 == deformation.wavelength)
 			return;
 
 		const size_t point_begin = 0;
 		const size_t point_end = point_begin + OutputPoints.size();
 		for(size_t point = point_begin; point != point_end; ++point)
-		{
-			k3d::point3 position = InputPoints[point];
-
-			const double wave_position = phase + (k3d::pi_times_2() * position[along] / wavelength);
-			const double offset = amplitude * sin(wave_position);
+			OutputPoints[point] = deformation.displace(InputPoints[point], PointSelection[point]);
+	}
 
-			OutputPoints[point] = k3d::mix(InputPoints[point], InputPoints[point] + (offset * offset_filter), PointSelection[point]);
-		}
+	k3d::mesh_simple_deformation_modifier::point_deformation* create_point_deformation()
+	{
+		return new wave(m_axis.pipeline_value(), m_along.pipeline_value(), m_amplitude.pipeline_value(), m_wavelength.pipeline_value(), m_phase.pipeline_value());
 	}
 
 	static k3d::iplugin_factory& get_factory()
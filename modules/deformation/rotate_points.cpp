@@ -60,18 +60,18 @@ public:
 
 	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
 	{
-		const k3d::matrix4 rotation = k3d::rotate3(k3d::point3(m_x.pipeline_value(), m_y.pipeline_value(), m_z.pipeline_value()));
-		const k3d::vector3 translation_vector = k3d::to_vector(m_origin.pipeline_value());
-		const k3d::matrix4 pre_translation = k3d::translate3(-translation_vector);
-		const k3d::matrix4 post_translation = k3d::translate3(translation_vector);
-
-		const k3d::matrix4 transformation = post_translation * rotation * pre_translation;
+		const k3d::matrix4 transformation = this->transformation();
 
 		k3d::parallel::parallel_for(
 			k3d::parallel::blocked_range<k3d::uint_t>(0, OutputPoints.size(), k3d::parallel::grain_size()),
 			linear_transformation_worker(InputPoints, PointSelection, OutputPoints, transformation));
 	}
 
+	k3d::mesh_simple_deformation_modifier::point_deformation* create_point_deformation()
+	{
+		return new linear_point_deformation(transformation());
+	}
+
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<rotate_points,
@@ -87,6 +87,16 @@ public:
 	}
 
 private:
+	const k3d::matrix4 transformation()
+	{
+		const k3d::matrix4 rotation = k3d::rotate3(k3d::point3(m_x.pipeline_value(), m_y.pipeline_value(), m_z.pipeline_value()));
+		const k3d::vector3 translation_vector = k3d::to_vector(m_origin.pipeline_value());
+		const k3d::matrix4 pre_translation = k3d::translate3(-translation_vector);
+		const k3d::matrix4 post_translation = k3d::translate3(translation_vector);
+
+		return post_translation * rotation * pre_translation;
+	}
+
 	k3d_data(k3d::double_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_x;
 	k3d_data(k3d::double_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_y;
 	k3d_data(k3d::double_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_z;
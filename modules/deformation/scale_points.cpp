@@ -58,13 +58,18 @@ public:
 
 	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
 	{
-		const k3d::matrix4 transformation = k3d::scale3(m_x.pipeline_value(), m_y.pipeline_value(), m_z.pipeline_value());
+		const k3d::matrix4 transformation = this->transformation();
 
 		k3d::parallel::parallel_for(
 			k3d::parallel::blocked_range<k3d::uint_t>(0, OutputPoints.size(), k3d::parallel::grain_size()),
 			linear_transformation_worker(InputPoints, PointSelection, OutputPoints, transformation));
 	}
 
+	k3d::mesh_simple_deformation_modifier::point_deformation* create_point_deformation()
+	{
+		return new linear_point_deformation(transformation());
+	}
+
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<scale_points,
@@ -80,6 +85,11 @@ public:
 	}
 
 private:
+	const k3d::matrix4 transformation()
+	{
+		return k3d::scale3(m_x.pipeline_value(), m_y.pipeline_value(), m_z.pipeline_value());
+	}
+
 	k3d_data(double, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_x;
 	k3d_data(double, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_y;
 	k3d_data(double, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_z;
@@ -59,24 +59,18 @@ public:
 
 	void on_deform_mesh(const k3d::mesh::points_t& InputPoints, const k3d::mesh::selection_t& PointSelection, k3d::mesh::points_t& OutputPoints)
 	{
-		const k3d::axis direction = m_direction.pipeline_value();
-		const k3d::axis axis = m_axis.pipeline_value();
-		const double shear_factor = m_shear_factor.pipeline_value();
-
-		const double xy = k3d::X == direction && k3d::Y == axis ? shear_factor : 0;
-		const double xz = k3d::X == direction && k3d::Z == axis ? shear_factor : 0;
-		const double yx = k3d::Y == direction && k3d::X == axis ? shear_factor : 0;
-		const double yz = k3d::Y == direction && k3d::Z == axis ? shear_factor : 0;
-		const double zx = k3d::Z == direction && k3d::X == axis ? shear_factor : 0;
-		const double zy = k3d::Z == direction && k3d::Y == axis ? shear_factor : 0;
-
-		const k3d::matrix4 transformation = k3d::shear3(xy, xz, yx, yz, zx, zy);
+		const k3d::matrix4 transformation = this->transformation();
 
 		k3d::parallel::parallel_for(
 			k3d::parallel::blocked_range<k3d::uint_t>(0, OutputPoints.size(), k3d::parallel::grain_size()),
 			linear_transformation_worker(InputPoints, PointSelection, OutputPoints, transformation));
 	}
 
+	k3d::mesh_simple_deformation_modifier::point_deformation* create_point_deformation()
+	{
+		return new linear_point_deformation(transformation());
+	}
+
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<shear_points,
@@ -92,6 +86,22 @@ public:
 	}
 
 private:
+	const k3d::matrix4 transformation()
+	{
+		const k3d::axis direction = m_direction.pipeline_value();
+		const k3d::axis axis = m_axis.pipeline_value();
+		const double shear_factor = m_shear_factor.pipeline_value();
+
+		const double xy = k3d::X == direction && k3d::Y == axis ? shear_factor : 0;
+		const double xz = k3d::X == direction && k3d::Z == axis ? shear_factor : 0;
+		const double yx = k3d::Y == direction && k3d::X == axis ? shear_factor : 0;
+		const double yz = k3d::Y == direction && k3d::Z == axis ? shear_factor : 0;
+		const double zx = k3d::Z == direction && k3d::X == axis ? shear_factor : 0;
+		const double zy = k3d::Z == direction && k3d::Y == axis ? shear_factor : 0;
+
+		return k3d::shear3(xy, xz, yx, yz, zx, zy);
+	}
+
 	k3d_data(k3d::axis, immutable_name, change_signal, with_undo, local_storage, no_constraint, enumeration_property, with_serialization) m_direction;
 	k3d_data(k3d::axis, immutable_name, change_signal, with_undo, local_storage, no_constraint, enumeration_property, with_serialization) m_axis;
 	k3d_data(double, immutable_name, change_signal, with_undo, local_storage, no_constraint, measurement_property, with_serialization) m_shear_factor;
@@ -63,6 +63,11 @@ public:
 			linear_transformation_worker(InputPoints, PointSelection, OutputPoints, transformation));
 	}
 
+	k3d::mesh_simple_deformation_modifier::point_deformation* create_point_deformation()
+	{
+		return new linear_point_deformation(m_input_matrix.pipeline_value());
+	}
+
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<transform_points,
@@ -27,11 +27,14 @@
 
 #include <k3d-i18n-config.h>
 #include <k3dsdk/algebra.h>
+#include <k3dsdk/array_delta.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/measurement.h>
 #include <k3dsdk/node.h>
 #include <k3dsdk/property.h>
 
+#include <boost/shared_ptr.hpp>
+
 namespace module
 {
 
@@ -82,17 +85,18 @@ public:
 		k3d::state_change_set* change_set = document().state_recorder().current_change_set();
 		if(change_set)
 		{
-			k3d::mesh::points_t old_positions;
+			k3d::mesh::points_t old_positions(tweaks.second);
 			for(k3d::uint_t i = tweaks_begin; i != tweaks_end; ++i)
 			{
 				const k3d::uint_t point_idx = tweaks.first[i];
 				if(point_idx < point_count)
-					old_positions.push_back(output_points[point_idx]);
+					old_positions[i] = output_points[point_idx];
 			}
-			// If undo/redo is being recorded, we need to store the old positions at the new tweak indices for the old state:
-			change_set->record_old_state(new tweaks_container(m_tweaks, tweaks.first, old_positions));
-			// The new state is simply the new tweak indices and the new positions:
-			change_set->record_new_state(new tweaks_container(m_tweaks, tweaks.first, tweaks.second));
+			// If undo/redo is being recorded, the old state is the old positions at the new tweak indices, and the new state is simply
+			// the new tweak indices and the new positions.  Both share one copy of the new tweaks, plus the positions that actually moved:
+			const boost::shared_ptr<const tweaks_state> state(new tweaks_state(tweaks, old_positions));
+			change_set->record_old_state(new tweaks_container(m_tweaks, state, true));
+			change_set->record_new_state(new tweaks_container(m_tweaks, state, false));
 		}
 
 		for(k3d::uint_t i = tweaks_begin; i != tweaks_end; ++i)
@@ -173,26 +177,59 @@ private:
 	/// Stores the cumulative result of all the tweaks
 	k3d::pipeline_data<k3d::mesh::points_t> m_tweaked_points;
 
+	/// Stores the undo/redo state for one change to the tweaks
+	struct tweaks_state
+	{
+		tweaks_state(const tweaks_t& Tweaks, const k3d::mesh::points_t& OldPositions) :
+			tweaks(Tweaks),
+			old_positions(OldPositions, Tweaks.second)
+		{
+		}
+
+		/// Stores the tweaks after the change
+		const tweaks_t tweaks;
+		/// Stores the positions that changed
+		const k3d::array_delta<k3d::mesh::points_t> old_positions;
+	};
+
 	class tweaks_container :
-		public k3d::istate_container
+		public k3d::istate_container,
+		public k3d::ispillable_state_container
 	{
 	public:
-		tweaks_container(k3d::iproperty& Tweaks, const k3d::mesh::indices_t& StoredIndices, const k3d::mesh::points_t& StoredPoints) :
+		tweaks_container(k3d::iproperty& Tweaks, const boost::shared_ptr<const tweaks_state>& State, const bool Undo) :
 			m_tweaks(Tweaks),
-			m_stored_indices(StoredIndices),
-			m_stored_points(StoredPoints)
+			m_state(State),
+			m_undo(Undo)
 		{
 		}
 
 		void restore_state()
 		{
-			k3d::property::set_internal_value(m_tweaks, std::make_pair(m_stored_indices, m_stored_points));
+			tweaks_t tweaks(m_state->tweaks);
+			if(m_undo)
+				m_state->old_positions.undo(tweaks.second);
+			k3d::property::set_internal_value(m_tweaks, tweaks);
+		}
+
+		const k3d::uint_t memory_usage()
+		{
+			// The state is shared with the container for the other side, so only the old side reports it ...
+			if(!m_undo)
+				return 0;
+
+			return sizeof(tweaks_state) + m_state->tweaks.first.size() * sizeof(k3d::uint_t) + m_state->tweaks.second.size() * sizeof(k3d::point3) + m_state->old_positions.memory_usage();
+		}
+
+		void spill(const boost::shared_ptr<k3d::state_spill_file>&)
+		{
+			// Tweaks stay in memory, they only take part in the memory budget ...
 		}
 
 	private:
 		k3d::iproperty& m_tweaks;
-		const k3d::mesh::indices_t m_stored_indices;
-		const k3d::mesh::points_t m_stored_points;
+		const boost::shared_ptr<const tweaks_state> m_state;
+		const bool m_undo;
 	};
 };
 
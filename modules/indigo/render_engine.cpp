@@ -41,6 +41,7 @@
 #include <k3dsdk/inetwork_render_farm.h>
 #include <k3dsdk/inetwork_render_frame.h>
 #include <k3dsdk/inetwork_render_job.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/inode_collection_sink.h>
 #include <k3dsdk/iprojection.h>
 #include <k3dsdk/irender_camera_animation.h>
@@ -464,7 +465,8 @@ private:
 
 				const k3d::string_t mesh_name = "mesh_" + k3d::string_cast(mesh_index++);
 
-				render_mesh(material_names, mesh_name, **node, *mesh, stream);
+				k3d::mesh flattened;
+				render_mesh(material_names, mesh_name, **node, k3d::instances::explicit_geometry(*mesh, flattened), stream);
 			}
 
 			// Finish the scene ...
@@ -53,9 +53,15 @@ class document_exporter :
 	public k3d::idocument_exporter
 {
 public:
+	document_exporter() :
+		m_factory(get_factory()),
+		m_array_encoding(k3d::ipersistent::save_context::TEXT_ARRAYS)
+	{
+	}
+
 	bool write_file(k3d::idocument& Document, const k3d::filesystem::path& Path)
 	{
-		k3d::log() << info << "Writing " << Path.native_console_string() << " using " << get_factory().name() << std::endl;
+		k3d::log() << info << "Writing " << Path.native_console_string() << " using " << m_factory.name() << std::endl;
 
 		// Try to open the file ...
 		k3d::filesystem::ofstream filestream(Path);
@@ -75,7 +81,7 @@ public:
 		const k3d::filesystem::path root_path = Path.branch_path();
 		k3d::dependencies dependencies;
 		k3d::persistent_lookup lookup;
-		k3d::ipersistent::save_context context(root_path, dependencies, lookup);
+		k3d::ipersistent::save_context context(root_path, dependencies, lookup, m_array_encoding);
 
 		// Save per-document data ...
 		k3d::xml::element& xml_document = xml.append(k3d::xml::element("document"));
@@ -110,6 +116,18 @@ public:
 
 		return factory;
 	}
+
+protected:
+	/// Used by derived exporters to supply their own factory (for logging) and array encoding
+	document_exporter(k3d::iplugin_factory& Factory, const k3d::ipersistent::save_context::array_encoding_t ArrayEncoding) :
+		m_factory(Factory),
+		m_array_encoding(ArrayEncoding)
+	{
+	}
+
+private:
+	k3d::iplugin_factory& m_factory;
+	const k3d::ipersistent::save_context::array_encoding_t m_array_encoding;
 };
 
 k3d::iplugin_factory& document_exporter_factory()
@@ -117,6 +135,36 @@ k3d::iplugin_factory& document_exporter_factory()
 	return document_exporter::get_factory();
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// binary_document_exporter
+
+/// Serializes a K-3D document using the native K-3D XML format, storing large numeric arrays as compressed binary data
+class binary_document_exporter :
+	public document_exporter
+{
+public:
+	binary_document_exporter() :
+		document_exporter(get_factory(), k3d::ipersistent::save_context::COMPRESSED_BINARY_ARRAYS)
+	{
+	}
+
+	static k3d::iplugin_factory& get_factory()
+	{
+		static k3d::application_plugin_factory<binary_document_exporter, k3d::interface_list<k3d::idocument_exporter> > factory(
+			k3d::uuid(0x6b1b0f4e, 0x2d7c4a39, 0x9e5f31a8, 0x47c0d2b6),
+			"K3DBinaryDocumentExporter",
+			_("K-3D Native with binary arrays ( .k3d )"),
+			"DocumentExporter");
+
+		return factory;
+	}
+};
+
+k3d::iplugin_factory& binary_document_exporter_factory()
+{
+	return binary_document_exporter::get_factory();
+}
+
 } // namespace k3d_io
 
 } // namespace module
@@ -48,8 +48,11 @@ class mesh_writer :
 
 public:
 	mesh_writer(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
-		base(Factory, Document)
+		base(Factory, Document),
+		m_array_encoding(init_owner(*this) + init_name("array_encoding") + init_label(_("Array Encoding")) + init_description(_("Controls how large numeric arrays are stored")) + init_value(TEXT) + init_enumeration(array_encoding_values()))
 	{
+		m_array_encoding.changed_signal().connect(k3d::hint::converter<
+			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_write_file_slot()));
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -70,7 +73,20 @@ private:
 		const k3d::filesystem::path root_path(OutputPath.branch_path());
 		k3d::dependencies dependencies;
 		k3d::persistent_lookup lookup;
-		k3d::ipersistent::save_context context(root_path, dependencies, lookup);
+		k3d::ipersistent::save_context::array_encoding_t array_encoding = k3d::ipersistent::save_context::TEXT_ARRAYS;
+		switch(m_array_encoding.pipeline_value())
+		{
+			case TEXT:
+				array_encoding = k3d::ipersistent::save_context::TEXT_ARRAYS;
+				break;
+			case BINARY:
+				array_encoding = k3d::ipersistent::save_context::BINARY_ARRAYS;
+				break;
+			case COMPRESSED_BINARY:
+				array_encoding = k3d::ipersistent::save_context::COMPRESSED_BINARY_ARRAYS;
+				break;
+		}
+		k3d::ipersistent::save_context context(root_path, dependencies, lookup, array_encoding);
 
 		k3d::xml::element xml("k3dml");
 		k3d::xml::element& xml_mesh = xml.append(k3d::xml::element("mesh_arrays"));
@@ -78,6 +94,63 @@ private:
 
 		Output << k3d::xml::declaration() << xml;
 	}
+
+	/// Enumerates supported array encodings
+	typedef enum
+	{
+		TEXT,
+		BINARY,
+		COMPRESSED_BINARY
+	} array_encoding_t;
+
+	friend std::ostream& operator << (std::ostream& Stream, const array_encoding_t& Value)
+	{
+		switch(Value)
+		{
+			case TEXT:
+				Stream << "text";
+				break;
+			case BINARY:
+				Stream << "binary";
+				break;
+			case COMPRESSED_BINARY:
+				Stream << "compressed_binary";
+				break;
+		}
+		return Stream;
+	}
+
+	friend std::istream& operator >> (std::istream& Stream, array_encoding_t& Value)
+	{
+		std::string text;
+		Stream >> text;
+
+		if(text == "text")
+			Value = TEXT;
+		else if(text == "binary")
+			Value = BINARY;
+		else if(text == "compressed_binary")
+			Value = COMPRESSED_BINARY;
+		else
+			k3d::log() << error << k3d_file_reference << ": unknown enumeration [" << text << "]" << std::endl;
+
+		return Stream;
+	}
+
+	static const k3d::ienumeration_property::enumeration_values_t& array_encoding_values()
+	{
+		static k3d::ienumeration_property::enumeration_values_t values;
+		if(values.empty())
+		{
+			values.push_back(k3d::ienumeration_property::enumeration_value_t(_("Text"), "text", _("Store arrays as human-readable text")));
+			values.push_back(k3d::ienumeration_property::enumeration_value_t(_("Binary"), "binary", _("Store large numeric arrays as base64-encoded binary data")));
+			values.push_back(k3d::ienumeration_property::enumeration_value_t(_("Compressed Binary"), "compressed_binary", _("Store large numeric arrays as compressed, base64-encoded binary data")));
+		}
+
+		return values;
+	}
+
+	k3d_data(array_encoding_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, enumeration_property, with_serialization) m_array_encoding;
 };
 
 k3d::iplugin_factory& mesh_writer_factory()
@@ -31,6 +31,7 @@ namespace k3d_io
 
 extern k3d::iplugin_factory& document_importer_factory();
 extern k3d::iplugin_factory& document_exporter_factory();
+extern k3d::iplugin_factory& binary_document_exporter_factory();
 extern k3d::iplugin_factory& mesh_reader_factory();
 extern k3d::iplugin_factory& mesh_writer_factory();
 
@@ -41,6 +42,7 @@ extern k3d::iplugin_factory& mesh_writer_factory();
 K3D_MODULE_START(Registry)
 	Registry.register_factory(module::k3d_io::document_importer_factory());
 	Registry.register_factory(module::k3d_io::document_exporter_factory());
+	Registry.register_factory(module::k3d_io::binary_document_exporter_factory());
 	Registry.register_factory(module::k3d_io::mesh_reader_factory());
 	Registry.register_factory(module::k3d_io::mesh_writer_factory());
 K3D_MODULE_END
@@ -47,6 +47,7 @@
 #include <k3dsdk/inetwork_render_farm.h>
 #include <k3dsdk/inetwork_render_frame.h>
 #include <k3dsdk/inetwork_render_job.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/inode_collection_sink.h>
 #include <k3dsdk/iprojection.h>
 #include <k3dsdk/irender_camera_animation.h>
@@ -637,10 +638,14 @@ private:
 
 	void render_mesh_instance(const material::name_map& MaterialNames, k3d::inode& MeshInstance, std::ostream& Stream)
 	{
-		const k3d::mesh* const mesh = k3d::property::pipeline_value<k3d::mesh*>(MeshInstance, "output_mesh");
-		if(!mesh)
+		const k3d::mesh* const pipeline_mesh = k3d::property::pipeline_value<k3d::mesh*>(MeshInstance, "output_mesh");
+		if(!pipeline_mesh)
 			return;
 
+		// Instances are rendered as explicit geometry ...
+		k3d::mesh flattened;
+		const k3d::mesh* const mesh = &k3d::instances::explicit_geometry(*pipeline_mesh, flattened);
+
 		for(k3d::mesh::primitives_t::const_iterator primitive = mesh->primitives.begin(); primitive != mesh->primitives.end(); ++primitive)
 		{
 			boost::scoped_ptr<k3d::cone::const_primitive> cone(k3d::cone::validate(*mesh, **primitive));
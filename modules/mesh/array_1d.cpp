@@ -24,6 +24,7 @@
 #include <k3d-i18n-config.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/hints.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/itransform_array_1d.h>
 #include <k3dsdk/measurement.h>
 #include <k3dsdk/mesh_modifier.h>
@@ -47,12 +48,15 @@ public:
 	array_1d_implementation(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
 		base(Factory, Document),
 		m_layout(init_owner(*this) + init_name("layout") + init_label(_("Layout")) + init_description(_("Layout")) + init_value<k3d::itransform_array_1d*>(0)),
-		m_count(init_owner(*this) + init_name("count") + init_label(_("Count")) + init_description(_("Number of mesh copies")) + init_value(5) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(0)))
+		m_count(init_owner(*this) + init_name("count") + init_label(_("Count")) + init_description(_("Number of mesh copies")) + init_value(5) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(0))),
+		m_instancing(init_owner(*this) + init_name("instancing") + init_label(_("Instancing")) + init_description(_("Place instances of the input mesh that share its geometry, instead of making explicit copies (some consumers, such as MergeMesh, don't support instances)")) + init_value(false))
 	{
 		m_layout.changed_signal().connect(k3d::hint::converter<
 			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
 		m_count.changed_signal().connect(k3d::hint::converter<
 			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
+		m_instancing.changed_signal().connect(k3d::hint::converter<
+			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
 	}
 
 	void on_create_mesh(const k3d::mesh& Input, k3d::mesh& Output)
@@ -64,22 +68,21 @@ public:
 			return;
 
 		const k3d::int32_t count = m_count.pipeline_value();
+
+		k3d::mesh::matrices_t matrices;
+		matrices.reserve(count);
 		for(k3d::int32_t i = 0; i != count; ++i)
+			matrices.push_back(layout->get_element(i, count));
+
+		if(m_instancing.pipeline_value())
+		{
+			k3d::instances::replicate(Input, matrices, Output);
+		}
+		else
 		{
-			// Merge input geometry into our output ...
-			k3d::uint_t point_begin = 0;
-			k3d::uint_t point_end = 0;
-			k3d::mesh::append(Input, Output, &point_begin, &point_end);
-
-			// Transform the corresponding output points ...
-			if(Output.points)
-			{
-				k3d::mesh::points_t& output_points = Output.points.writable();
-
-				const k3d::matrix4 matrix = layout->get_element(i, count);
-				for(k3d::uint_t point = point_begin; point != point_end; ++point)
-					output_points[point] = matrix * output_points[point];
-			}
+			k3d::mesh instanced_mesh;
+			k3d::instances::replicate(Input, matrices, instanced_mesh);
+			k3d::instances::flatten(instanced_mesh, Output);
 		}
 	}
 
@@ -87,6 +90,11 @@ public:
 	{
 	}
 
+	k3d::bool_t preserve_instances()
+	{
+		return true;
+	}
+
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<array_1d_implementation,
@@ -104,6 +112,7 @@ public:
 private:
 	k3d_data(k3d::itransform_array_1d*, immutable_name, change_signal, with_undo, node_storage, no_constraint, node_property, node_serialization) m_layout;
 	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_count;
+	k3d_data(k3d::bool_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_instancing;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -24,6 +24,7 @@
 #include <k3d-i18n-config.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/hints.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/itransform_array_3d.h>
 #include <k3dsdk/measurement.h>
 #include <k3dsdk/mesh_modifier.h>
@@ -49,7 +50,8 @@ public:
 		m_layout(init_owner(*this) + init_name("layout") + init_label(_("Layout")) + init_description(_("Layout")) + init_value<k3d::itransform_array_3d*>(0)),
 		m_count1(init_owner(*this) + init_name("count1") + init_label(_("Count 1")) + init_description(_("Number of mesh copies")) + init_value(5) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(0))),
 		m_count2(init_owner(*this) + init_name("count2") + init_label(_("Count 2")) + init_description(_("Number of mesh copies")) + init_value(5) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(0))),
-		m_count3(init_owner(*this) + init_name("count3") + init_label(_("Count 3")) + init_description(_("Number of mesh copies")) + init_value(5) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(0)))
+		m_count3(init_owner(*this) + init_name("count3") + init_label(_("Count 3")) + init_description(_("Number of mesh copies")) + init_value(5) + init_step_increment(1) + init_units(typeid(k3d::measurement::scalar)) + init_constraint(constraint::minimum<k3d::int32_t>(0))),
+		m_instancing(init_owner(*this) + init_name("instancing") + init_label(_("Instancing")) + init_description(_("Place instances of the input mesh that share its geometry, instead of making explicit copies (some consumers, such as MergeMesh, don't support instances)")) + init_value(false))
 	{
 		m_layout.changed_signal().connect(k3d::hint::converter<
 			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
@@ -59,6 +61,8 @@ public:
 			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
 		m_count3.changed_signal().connect(k3d::hint::converter<
 			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
+		m_instancing.changed_signal().connect(k3d::hint::converter<
+			k3d::hint::convert<k3d::hint::any, k3d::hint::none> >(make_reset_mesh_slot()));
 	}
 
 	void on_create_mesh(const k3d::mesh& Input, k3d::mesh& Output)
@@ -72,35 +76,39 @@ public:
 		const k3d::int32_t count1 = m_count1.pipeline_value();
 		const k3d::int32_t count2 = m_count2.pipeline_value();
 		const k3d::int32_t count3 = m_count3.pipeline_value();
+
+		k3d::mesh::matrices_t matrices;
+		matrices.reserve(count1 * count2 * count3);
 		for(k3d::int32_t i = 0; i != count1; ++i)
 		{
 			for(k3d::int32_t j = 0; j != count2; ++j)
 			{
 				for(k3d::int32_t k = 0; k != count3; ++k)
-				{
-					// Merge input geometry into our output ...
-					k3d::uint_t point_begin = 0;
-					k3d::uint_t point_end = 0;
-					k3d::mesh::append(Input, Output, &point_begin, &point_end);
-
-					// Transform the corresponding output points ...
-					if(Output.points)
-					{
-						k3d::mesh::points_t& output_points = Output.points.writable();
-
-						const k3d::matrix4 matrix = layout->get_element(i, count1, j, count2, k, count3);
-						for(k3d::uint_t point = point_begin; point != point_end; ++point)
-							output_points[point] = matrix * output_points[point];
-					}
-				}
+					matrices.push_back(layout->get_element(i, count1, j, count2, k, count3));
 			}
 		}
+
+		if(m_instancing.pipeline_value())
+		{
+			k3d::instances::replicate(Input, matrices, Output);
+		}
+		else
+		{
+			k3d::mesh instanced_mesh;
+			k3d::instances::replicate(Input, matrices, instanced_mesh);
+			k3d::instances::flatten(instanced_mesh, Output);
+		}
 	}
 
 	void on_update_mesh(const k3d::mesh& Input, k3d::mesh& Output)
 	{
 	}
 
+	k3d::bool_t preserve_instances()
+	{
+		return true;
+	}
+
 	static k3d::iplugin_factory& get_factory()
 	{
 		static k3d::document_plugin_factory<array_3d_implementation,
@@ -120,6 +128,7 @@ private:
 	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_count1;
 	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_count2;
 	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_count3;
+	k3d_data(k3d::bool_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_instancing;
 };
 
 /////////////////////////////////////////////////////////////////////////////
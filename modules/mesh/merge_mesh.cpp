@@ -27,6 +27,7 @@
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/hints.h>
 #include <k3dsdk/imulti_mesh_sink.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/measurement.h>
 #include <k3dsdk/mesh_source.h>
 #include <k3dsdk/metadata_keys.h>
@@ -81,7 +82,9 @@ public:
 			if(!mesh)
 				continue;
 
-			k3d::mesh::append(*mesh, Output);
+			// Instances place every other primitive in their mesh, so they must be flattened before merging ...
+			k3d::mesh flattened;
+			k3d::mesh::append(k3d::instances::explicit_geometry(*mesh, flattened), Output);
 		}
 	}
 
@@ -26,6 +26,7 @@
 #include <k3dsdk/geometry.h>
 #include <k3dsdk/hints.h>
 #include <k3dsdk/imesh_sink.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/mesh.h>
 #include <k3dsdk/mesh_selection_sink.h>
 #include <k3dsdk/node.h>
@@ -68,7 +69,8 @@ public:
 		{
 			if(!input->points)
 				return;
-			k3d::mesh selected_mesh = *input;
+			k3d::mesh selected_mesh;
+			k3d::instances::flatten(*input, selected_mesh);
 			k3d::geometry::selection::merge(m_mesh_selection.pipeline_value(), selected_mesh);
 			const k3d::uint_t points_begin = 0;
 			const k3d::uint_t points_end = selected_mesh.points->size();
@@ -31,8 +31,15 @@
 #include <k3dsdk/mesh_selection_sink.h>
 #include <k3dsdk/metadata_keys.h>
 #include <k3dsdk/node.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
 #include <k3dsdk/utility.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace module
 {
 
@@ -50,12 +57,21 @@ class weld_points :
 public:
 	weld_points(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
 		base(Factory, Document),
-		m_distance(init_owner(*this) + init_name("distance") + init_label(_("Distance")) + init_description(_("Maximum distance between points")) + init_value(0.001) + init_step_increment(0.0001) + init_units(typeid(k3d::measurement::distance)) + init_constraint(constraint::minimum<k3d::double_t>(0.0)))
+		m_distance(init_owner(*this) + init_name("distance") + init_label(_("Distance")) + init_description(_("Maximum distance between points")) + init_value(0.001) + init_step_increment(0.0001) + init_units(typeid(k3d::measurement::distance)) + init_constraint(constraint::minimum<k3d::double_t>(0.0))),
+		m_algorithm(init_owner(*this) + init_name("algorithm") + init_label(_("Algorithm")) + init_description(_("Algorithm used to find coincident points")) + init_value(GRID) + init_enumeration(algorithm_values()))
 	{
 		m_distance.changed_signal().connect(k3d::hint::converter<
 			k3d::hint::convert<k3d::hint::any, k3d::hint::mesh_topology_changed> >(make_reset_mesh_slot()));
+		m_algorithm.changed_signal().connect(k3d::hint::converter<
+			k3d::hint::convert<k3d::hint::any, k3d::hint::mesh_topology_changed> >(make_reset_mesh_slot()));
 	}
 
+	typedef enum
+	{
+		GRID,
+		BRUTE_FORCE
+	} algorithm_t;
+
 	struct map_point_indices
 	{
 		map_point_indices(const k3d::mesh::indices_t& PointMap) :
@@ -84,45 +100,279 @@ public:
 		const k3d::mesh::indices_t& point_map;	
 	};
 
-	void on_create_mesh(const k3d::mesh& Input, k3d::mesh& Output)
+	/// Integer coordinates of a cell in a uniform grid
+	struct grid_cell
 	{
-		Output = Input;
+		grid_cell() :
+			x(0),
+			y(0),
+			z(0)
+		{
+		}
 
-		if(!Output.points)
-			return;
-		k3d::mesh::points_t& points = Output.points.writable();
+		grid_cell(const k3d::int64_t X, const k3d::int64_t Y, const k3d::int64_t Z) :
+			x(X),
+			y(Y),
+			z(Z)
+		{
+		}
 
-		// Begin by creating an identity map from each mesh point to itself ...
-		const k3d::uint_t point_begin = 0;
-		const k3d::uint_t point_end = point_begin + points.size();
-		k3d::mesh::indices_t point_map(points.size());
-		for(k3d::uint_t point = point_begin; point != point_end; ++point)
-			point_map[point] = point;
+		bool operator<(const grid_cell& Other) const
+		{
+			if(x != Other.x)
+				return x < Other.x;
+			if(y != Other.y)
+				return y < Other.y;
+			return z < Other.z;
+		}
+
+		k3d::int64_t x;
+		k3d::int64_t y;
+		k3d::int64_t z;
+	};
+
+	/// Stores a point index along with the grid cell that contains it
+	typedef std::pair<grid_cell, k3d::uint_t> grid_entry;
+	typedef std::vector<grid_entry> grid_entries;
+
+	/// Orders grid entries by cell only, so we can search for every point in a range of cells
+	struct compare_cells
+	{
+		bool operator()(const grid_entry& LHS, const grid_cell& RHS) const
+		{
+			return LHS.first < RHS;
+		}
+
+		bool operator()(const grid_cell& LHS, const grid_entry& RHS) const
+		{
+			return LHS < RHS.first;
+		}
+	};
+
+	static const k3d::int64_t cell_coordinate(const k3d::double_t Value, const k3d::double_t CellSize)
+	{
+		return static_cast<k3d::int64_t>(std::floor(Value / CellSize));
+	}
+
+	/// Assigns each point to the grid cell that contains it
+	class assign_cells
+	{
+	public:
+		assign_cells(const k3d::mesh::points_t& Points, const k3d::double_t CellSize, grid_entries& Entries) :
+			points(Points),
+			cell_size(CellSize),
+			entries(Entries)
+		{
+		}
+
+		void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+		{
+			const k3d::uint_t point_begin = range.begin();
+			const k3d::uint_t point_end = range.end();
+			for(k3d::uint_t point = point_begin; point != point_end; ++point)
+			{
+				const k3d::point3& p = points[point];
+				entries[point] = grid_entry(grid_cell(cell_coordinate(p[0], cell_size), cell_coordinate(p[1], cell_size), cell_coordinate(p[2], cell_size)), point);
+			}
+		}
+
+	private:
+		const k3d::mesh::points_t& points;
+		const k3d::double_t cell_size;
+		grid_entries& entries;
+	};
+
+	/// Finds every lower-numbered point that lies within the weld distance of each point.
+	/** Runs in two passes: with a null Neighbors array it only counts neighbors,
+	otherwise it stores them (in ascending order) starting at the given offsets. */
+	class find_neighbors
+	{
+	public:
+		find_neighbors(const k3d::mesh::points_t& Points, const k3d::double_t Distance, const grid_entries& Entries, k3d::mesh::counts_t& Counts, const k3d::mesh::indices_t& Offsets, k3d::mesh::indices_t* const Neighbors) :
+			points(Points),
+			distance(Distance),
+			entries(Entries),
+			counts(Counts),
+			offsets(Offsets),
+			neighbors(Neighbors)
+		{
+		}
+
+		void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+		{
+			const k3d::uint_t point_begin = range.begin();
+			const k3d::uint_t point_end = range.end();
+			for(k3d::uint_t point = point_begin; point != point_end; ++point)
+			{
+				const k3d::point3& p = points[point];
+
+				// Rounding is monotonic, so any point that passes the distance test below is guaranteed to lie within these cells ...
+				const k3d::int64_t x_begin = cell_coordinate(p[0] - distance, distance);
+				const k3d::int64_t x_end = cell_coordinate(p[0] + distance, distance);
+				const k3d::int64_t y_begin = cell_coordinate(p[1] - distance, distance);
+				const k3d::int64_t y_end = cell_coordinate(p[1] + distance, distance);
+				const k3d::int64_t z_begin = cell_coordinate(p[2] - distance, distance);
+				const k3d::int64_t z_end = cell_coordinate(p[2] + distance, distance);
+
+				k3d::uint_t count = 0;
+				for(k3d::int64_t x = x_begin; x <= x_end; ++x)
+				{
+					for(k3d::int64_t y = y_begin; y <= y_end; ++y)
+					{
+						// Cells are sorted lexicographically, so each row of cells along Z is contiguous ...
+						grid_entries::const_iterator entry = std::lower_bound(entries.begin(), entries.end(), grid_cell(x, y, z_begin), compare_cells());
+						const grid_entries::const_iterator entry_end = std::upper_bound(entry, entries.end(), grid_cell(x, y, z_end), compare_cells());
+						for(; entry != entry_end; ++entry)
+						{
+							const k3d::uint_t other = entry->second;
+							if(other >= point)
+								continue;
+
+							const k3d::vector3 delta = p - points[other];
+							if(std::fabs(delta[0]) < distance && std::fabs(delta[1]) < distance && std::fabs(delta[2]) < distance)
+							{
+								if(neighbors)
+									(*neighbors)[offsets[point] + count] = other;
+								++count;
+							}
+						}
+					}
+				}
+
+				if(neighbors)
+					std::sort(neighbors->begin() + offsets[point], neighbors->begin() + offsets[point] + count);
+				else
+					counts[point] = count;
+			}
+		}
+
+	private:
+		const k3d::mesh::points_t& points;
+		const k3d::double_t distance;
+		const grid_entries& entries;
+		k3d::mesh::counts_t& counts;
+		const k3d::mesh::indices_t& offsets;
+		k3d::mesh::indices_t* const neighbors;
+	};
 
-		// Update the point map to eliminate "duplicate" points ... warning: this is O(N^2)!!!
+	/// Maps each point to the first earlier point within Distance that hasn't itself been welded, by comparing every pair of points ... warning: this is O(N^2)!!!
+	static const k3d::uint_t brute_force_weld(const k3d::mesh::points_t& Points, const k3d::double_t Distance, k3d::mesh::indices_t& PointMap)
+	{
 		k3d::uint_t weld_points_count = 0;
-		const k3d::double_t distance = m_distance.pipeline_value();
+		const k3d::uint_t point_begin = 0;
+		const k3d::uint_t point_end = point_begin + Points.size();
 		for(k3d::uint_t point1 = point_begin; point1 != point_end; ++point1)
 		{
-			// Skip points that have already been weld_pointsed ...
-			if(point_map[point1] != point1)
+			// Skip points that have already been welded ...
+			if(PointMap[point1] != point1)
 				continue;
 
 			for(k3d::uint_t point2 = point1 + 1; point2 != point_end; ++point2)
 			{
-				// Skip points that have already been weld_pointsed ...
-				if(point_map[point2] != point2)
+				// Skip points that have already been welded ...
+				if(PointMap[point2] != point2)
 					continue;
 
-				const k3d::vector3 delta = points[point2] - points[point1];
-				if(std::fabs(delta[0]) < distance && std::fabs(delta[1]) < distance && std::fabs(delta[2]) < distance)
+				const k3d::vector3 delta = Points[point2] - Points[point1];
+				if(std::fabs(delta[0]) < Distance && std::fabs(delta[1]) < Distance && std::fabs(delta[2]) < Distance)
 				{
 					++weld_points_count;
-					point_map[point2] = point1;
+					PointMap[point2] = point1;
 				}
 			}
 		}
 
+		return weld_points_count;
+	}
+
+	/// Produces the same point map as brute_force_weld(), using a uniform grid with cells of size Distance to limit the search to nearby points.
+	static const k3d::uint_t grid_weld(const k3d::mesh::points_t& Points, const k3d::double_t Distance, k3d::mesh::indices_t& PointMap)
+	{
+		const k3d::uint_t point_count = Points.size();
+
+		// Bin points into cells, then sort them so that each cell's points are contiguous and in index order ...
+		grid_entries entries(point_count);
+		k3d::parallel::parallel_for(
+			k3d::parallel::blocked_range<k3d::uint_t>(0, point_count, k3d::parallel::grain_size()),
+			assign_cells(Points, Distance, entries));
+		std::sort(entries.begin(), entries.end());
+
+		// Find the lower-numbered neighbors of every point, storing them in a flat array ...
+		k3d::mesh::counts_t counts(point_count);
+		k3d::mesh::indices_t offsets(point_count);
+		k3d::parallel::parallel_for(
+			k3d::parallel::blocked_range<k3d::uint_t>(0, point_count, k3d::parallel::grain_size()),
+			find_neighbors(Points, Distance, entries, counts, offsets, 0));
+
+		k3d::uint_t neighbor_count = 0;
+		for(k3d::uint_t point = 0; point != point_count; ++point)
+		{
+			offsets[point] = neighbor_count;
+			neighbor_count += counts[point];
+		}
+
+		// If no point has a neighbor, there's nothing to weld ...
+		if(!neighbor_count)
+			return 0;
+
+		k3d::mesh::indices_t neighbors(neighbor_count);
+		k3d::parallel::parallel_for(
+			k3d::parallel::blocked_range<k3d::uint_t>(0, point_count, k3d::parallel::grain_size()),
+			find_neighbors(Points, Distance, entries, counts, offsets, &neighbors));
+
+		// Weld each point to its first neighbor that wasn't welded itself, matching the brute-force ordering ...
+		k3d::uint_t weld_points_count = 0;
+		for(k3d::uint_t point = 0; point != point_count; ++point)
+		{
+			const k3d::uint_t neighbor_begin = offsets[point];
+			const k3d::uint_t neighbor_end = neighbor_begin + counts[point];
+			for(k3d::uint_t neighbor = neighbor_begin; neighbor != neighbor_end; ++neighbor)
+			{
+				if(PointMap[neighbors[neighbor]] != neighbors[neighbor])
+					continue;
+
+				++weld_points_count;
+				PointMap[point] = neighbors[neighbor];
+				break;
+			}
+		}
+
+		return weld_points_count;
+	}
+
+	void on_create_mesh(const k3d::mesh& Input, k3d::mesh& Output)
+	{
+		Output = Input;
+
+		if(!Output.points)
+			return;
+		const k3d::mesh::points_t& points = *Output.points;
+
+		// No two points can be closer than a zero distance ...
+		const k3d::double_t distance = m_distance.pipeline_value();
+		if(distance <= 0.0)
+			return;
+
+		// Begin by creating an identity map from each mesh point to itself ...
+		const k3d::uint_t point_begin = 0;
+		const k3d::uint_t point_end = point_begin + points.size();
+		k3d::mesh::indices_t point_map(points.size());
+		for(k3d::uint_t point = point_begin; point != point_end; ++point)
+			point_map[point] = point;
+
+		// Update the point map to eliminate "duplicate" points ...
+		// Cell coordinates must fit in an integer, otherwise we fall back on comparing every pair of points ...
+		algorithm_t algorithm = m_algorithm.pipeline_value();
+		if(algorithm == GRID)
+		{
+			const k3d::bounding_box3 bounds = k3d::mesh::bounds(points);
+			const k3d::double_t extent = std::max(std::max(std::max(std::fabs(bounds.nx), std::fabs(bounds.px)), std::max(std::fabs(bounds.ny), std::fabs(bounds.py))), std::max(std::fabs(bounds.nz), std::fabs(bounds.pz)));
+			if(!(extent / distance < 1e15))
+				algorithm = BRUTE_FORCE;
+		}
+
+		const k3d::uint_t weld_points_count = algorithm == GRID ? grid_weld(points, distance, point_map) : brute_force_weld(points, distance, point_map);
+
 		// If we didn't find any points to weld_points, we're done ...
 		if(!weld_points_count)
 			return;
@@ -156,7 +406,50 @@ public:
 	}
 
 private:
+	static const k3d::ienumeration_property::enumeration_values_t& algorithm_values()
+	{
+		static k3d::ienumeration_property::enumeration_values_t values;
+		if(values.empty())
+		{
+			values.push_back(k3d::ienumeration_property::enumeration_value_t(_("Grid"), "grid", _("Search for coincident points using a uniform grid")));
+			values.push_back(k3d::ienumeration_property::enumeration_value_t(_("Brute Force"), "brute_force", _("Compare every pair of points (slow, for reference)")));
+		}
+
+		return values;
+	}
+
+	friend std::ostream& operator<<(std::ostream& Stream, const algorithm_t& Value)
+	{
+		switch(Value)
+		{
+			case GRID:
+				Stream << "grid";
+				break;
+			case BRUTE_FORCE:
+				Stream << "brute_force";
+				break;
+		}
+
+		return Stream;
+	}
+
+	friend std::istream& operator>>(std::istream& Stream, algorithm_t& Value)
+	{
+		std::string text;
+		Stream >> text;
+
+		if(text == "grid")
+			Value = GRID;
+		else if(text == "brute_force")
+			Value = BRUTE_FORCE;
+		else
+			k3d::log() << error << k3d_file_reference << ": unknown enumeration [" << text << "]" << std::endl;
+
+		return Stream;
+	}
+
 	k3d_data(k3d::double_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_distance;
+	k3d_data(algorithm_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, enumeration_property, with_serialization) m_algorithm;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -98,6 +98,11 @@ public:
 
 		for(k3d::mesh::primitives_t::iterator primitive = Output.primitives.begin(); primitive != Output.primitives.end(); ++primitive)
 		{
+			// Get the shared point-to-edge lookup (before making the output writable) ...
+			const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Output, **primitive);
+			if(!topology)
+				continue;
+
 			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::validate(Output, *primitive));
 			if(!polyhedron)
 				continue;
@@ -121,10 +126,10 @@ public:
 
 				k3d::mesh::normals_t& vertex_normals = polyhedron->vertex_attributes.create(m_vertex_array.pipeline_value(), new k3d::mesh::normals_t(polyhedron->vertex_points.size()));
 
-				k3d::mesh::indices_t point_first_faces;
-				k3d::mesh::counts_t point_face_counts;
-				k3d::mesh::indices_t point_faces;
-				k3d::polyhedron::create_point_face_lookup(polyhedron->face_first_loops, polyhedron->face_loop_counts, polyhedron->loop_first_edges, polyhedron->vertex_points, polyhedron->clockwise_edges, points, point_first_faces, point_face_counts, point_faces);
+				// The faces adjacent to a point are the faces that own its out-edges ...
+				const k3d::mesh::indices_t& point_first_edges = topology->point_first_out_edges;
+				const k3d::mesh::indices_t& point_edges = topology->point_out_edges;
+				const k3d::mesh::indices_t& edge_faces = topology->edge_faces;
 
 				for(k3d::uint_t face = face_begin; face != face_end; ++face)
 				{
@@ -141,11 +146,11 @@ public:
 
 							if(polyhedron->face_selections[face])
 							{
-								const k3d::uint_t point_face_begin = point_first_faces[polyhedron->vertex_points[edge]];
-								const k3d::uint_t point_face_end = point_face_begin + point_face_counts[polyhedron->vertex_points[edge]];
-								for(k3d::uint_t point_face = point_face_begin; point_face != point_face_end; ++point_face)
+								const k3d::uint_t point_edge_begin = point_first_edges[polyhedron->vertex_points[edge]];
+								const k3d::uint_t point_edge_end = point_first_edges[polyhedron->vertex_points[edge] + 1];
+								for(k3d::uint_t point_edge = point_edge_begin; point_edge != point_edge_end; ++point_edge)
 								{
-									const k3d::uint_t adjacent_face = point_faces[point_face];
+									const k3d::uint_t adjacent_face = edge_faces[point_edges[point_edge]];
 									if(adjacent_face == face)
 										continue;
 
@@ -22,6 +22,7 @@
 */
 
 #include <k3d-i18n-config.h>
+#include <k3dsdk/archive_cache_ri.h>
 #include <k3dsdk/classes.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/geometry.h>
@@ -31,6 +32,8 @@
 #include <k3dsdk/imesh_painter_ri.h>
 #include <k3dsdk/imesh_sink.h>
 #include <k3dsdk/imesh_source.h>
+#include <k3dsdk/imaterial.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/ipipeline.h>
 #include <k3dsdk/ipipeline_profiler.h>
 #include <k3dsdk/mesh_selection_sink.h>
@@ -44,11 +47,14 @@
 #include <k3dsdk/renderable_ri.h>
 #include <k3dsdk/selection.h>
 #include <k3dsdk/snappable.h>
+#include <k3dsdk/stream_ri.h>
 #include <k3dsdk/transformable.h>
 
 #include <boost/any.hpp>
 
 #include <list>
+#include <set>
+#include <sstream>
 
 namespace module
 {
@@ -56,6 +62,28 @@ namespace module
 namespace mesh_instance
 {
 
+namespace detail
+{
+
+/// Collects every material referenced by the arrays of a mesh
+struct collect_materials
+{
+	collect_materials(std::set<k3d::imaterial*>& Materials) :
+		materials(Materials)
+	{
+	}
+
+	void operator()(const k3d::string_t&, const k3d::table&, const k3d::string_t&, const k3d::pipeline_data<k3d::array>& Array)
+	{
+		if(const k3d::mesh::materials_t* const array = dynamic_cast<const k3d::mesh::materials_t*>(Array.get()))
+			materials.insert(array->begin(), array->end());
+	}
+
+	std::set<k3d::imaterial*>& materials;
+};
+
+} // namespace detail
+
 /////////////////////////////////////////////////////////////////////////////
 // mesh_instance
 
@@ -73,7 +101,8 @@ public:
 		m_output_mesh(init_owner(*this) + init_name("output_mesh") + init_label(_("Output Mesh")) + init_description(_("Output mesh"))),
 		m_gl_painter(init_owner(*this) + init_name("gl_painter") + init_label(_("OpenGL Mesh Painter")) + init_description(_("OpenGL Mesh Painter")) + init_value(static_cast<k3d::gl::imesh_painter*>(0))),
 		m_ri_painter(init_owner(*this) + init_name("ri_painter") + init_label(_("RenderMan Mesh Painter")) + init_description(_("RenderMan Mesh Painter")) + init_value(static_cast<k3d::ri::imesh_painter*>(0))),
-		m_show_component_selection(init_owner(*this) + init_name("show_component_selection") + init_label(_("Show Component Selection")) + init_description(_("Show component selection")) + init_value(false))
+		m_show_component_selection(init_owner(*this) + init_name("show_component_selection") + init_label(_("Show Component Selection")) + init_description(_("Show component selection")) + init_value(false)),
+		m_ri_archive_version(0)
 	{
 		m_input_mesh.changed_signal().connect(k3d::hint::converter<k3d::hint::convert<k3d::hint::any, k3d::hint::unchanged> >(m_output_mesh.make_slot()));
 		m_mesh_selection.changed_signal().connect(k3d::hint::converter<k3d::hint::convert<k3d::hint::any, k3d::hint::selection_changed> >(m_output_mesh.make_slot()));
@@ -83,6 +112,9 @@ public:
 		m_input_matrix.changed_signal().connect(make_async_redraw_slot());
 		m_gl_painter.changed_signal().connect(make_async_redraw_slot());
 		m_show_component_selection.changed_signal().connect(make_async_redraw_slot());
+
+		m_input_mesh.changed_signal().connect(sigc::mem_fun(*this, &mesh_instance::on_ri_archive_changed));
+		m_ri_painter.changed_signal().connect(sigc::mem_fun(*this, &mesh_instance::on_ri_archive_changed));
 		
 		m_output_mesh.set_update_slot(sigc::mem_fun(*this, &mesh_instance::execute));
 	}
@@ -134,7 +166,29 @@ public:
 			}
 		}
 
-		return results;
+		// If the mesh contains instances, bound the transformed corners of the prototype bounds ...
+		k3d::mesh::matrices_t matrices;
+		if(results.empty() || !k3d::instances::get_matrices(*output_mesh, matrices))
+			return results;
+
+		const k3d::point3 corners[8] = {
+			k3d::point3(results.nx, results.ny, results.nz),
+			k3d::point3(results.px, results.ny, results.nz),
+			k3d::point3(results.nx, results.py, results.nz),
+			k3d::point3(results.px, results.py, results.nz),
+			k3d::point3(results.nx, results.ny, results.pz),
+			k3d::point3(results.px, results.ny, results.pz),
+			k3d::point3(results.nx, results.py, results.pz),
+			k3d::point3(results.px, results.py, results.pz) };
+
+		k3d::bounding_box3 instance_results;
+		for(k3d::mesh::matrices_t::const_iterator matrix = matrices.begin(); matrix != matrices.end(); ++matrix)
+		{
+			for(k3d::uint_t i = 0; i != 8; ++i)
+				instance_results.insert(*matrix * corners[i]);
+		}
+
+		return instance_results;
 	}
 	
 	void on_gl_draw(const k3d::gl::render_state& State)
@@ -145,14 +199,26 @@ public:
 			const k3d::mesh* const output_mesh = k3d::property::pipeline_value<k3d::mesh*>(m_output_mesh);
 			return_if_fail(output_mesh);
 			
-			k3d::gl::painter_render_state render_state(State, matrix(), m_show_component_selection.pipeline_value());
-			try
+			// Instances share the painter caches for the prototype, so the painter simply runs once per instance ...
+			const k3d::mesh::matrices_t matrices = instance_matrices(*output_mesh);
+			for(k3d::mesh::matrices_t::const_iterator instance_matrix = matrices.begin(); instance_matrix != matrices.end(); ++instance_matrix)
 			{
-				painter->paint_mesh(*output_mesh, render_state, m_output_mesh.changed_signal());
-			}
-			catch(std::runtime_error& E) // VBO painters throw an exception if the VBO state is corrupted.
-			{
-				k3d::log() << error << E.what() << std::endl;
+				glMatrixMode(GL_MODELVIEW);
+				glPushMatrix();
+				k3d::gl::push_matrix(*instance_matrix);
+
+				k3d::gl::painter_render_state render_state(State, matrix() * *instance_matrix, m_show_component_selection.pipeline_value());
+				try
+				{
+					painter->paint_mesh(*output_mesh, render_state, m_output_mesh.changed_signal());
+				}
+				catch(std::runtime_error& E) // VBO painters throw an exception if the VBO state is corrupted.
+				{
+					k3d::log() << error << E.what() << std::endl;
+				}
+
+				glMatrixMode(GL_MODELVIEW);
+				glPopMatrix();
 			}
 		}
 	}
@@ -165,21 +231,32 @@ public:
 			const k3d::mesh* const output_mesh = k3d::property::pipeline_value<k3d::mesh*>(m_output_mesh);
 			return_if_fail(output_mesh);
 
-			k3d::gl::painter_render_state render_state(State, matrix(), m_show_component_selection.pipeline_value());
 			k3d::gl::painter_selection_state selection_state(SelectionState);
 
 			// At the top-level, ID the entire instance ...
 			k3d::gl::push_selection_token(this);
 			// Then, ID the underlying mesh ...
 			k3d::gl::push_selection_token(k3d::selection::MESH, 0);
-			// Now give the painters a chance ...
-			try
-			{
-				painter->select_mesh(*output_mesh, render_state, selection_state, m_output_mesh.changed_signal());
-			}
-			catch(std::runtime_error& E) // VBO painters throw an exception if the VBO state is corrupted.
+			// Now give the painters a chance, once for each instance of the prototype ...
+			const k3d::mesh::matrices_t matrices = instance_matrices(*output_mesh);
+			for(k3d::mesh::matrices_t::const_iterator instance_matrix = matrices.begin(); instance_matrix != matrices.end(); ++instance_matrix)
 			{
-				k3d::log() << error << E.what() << std::endl;
+				glMatrixMode(GL_MODELVIEW);
+				glPushMatrix();
+				k3d::gl::push_matrix(*instance_matrix);
+
+				k3d::gl::painter_render_state render_state(State, matrix() * *instance_matrix, m_show_component_selection.pipeline_value());
+				try
+				{
+					painter->select_mesh(*output_mesh, render_state, selection_state, m_output_mesh.changed_signal());
+				}
+				catch(std::runtime_error& E) // VBO painters throw an exception if the VBO state is corrupted.
+				{
+					k3d::log() << error << E.what() << std::endl;
+				}
+
+				glMatrixMode(GL_MODELVIEW);
+				glPopMatrix();
 			}
 
 			k3d::gl::pop_selection_token(); // mesh
@@ -194,7 +271,30 @@ public:
 			const k3d::mesh* const input_mesh = m_input_mesh.pipeline_value();
 			return_if_fail(input_mesh);
 
-			painter->paint_mesh(*input_mesh, State);
+			k3d::mesh::matrices_t matrices;
+			if(!k3d::instances::get_matrices(*input_mesh, matrices))
+			{
+				if(State.archives && State.render_context == k3d::ri::FINAL_FRAME)
+					render_archive(*painter, *input_mesh, State);
+				else
+					painter->paint_mesh(*input_mesh, State);
+				return;
+			}
+
+			// Define the prototype once, then place it for each instance ...
+			const k3d::ri::object_handle handle = State.stream.RiObjectBegin();
+				k3d::ri::render_state state(State);
+				state.render_context = k3d::ri::OBJECT_INSTANCE;
+				painter->paint_mesh(*input_mesh, state);
+			State.stream.RiObjectEnd();
+
+			for(k3d::mesh::matrices_t::const_iterator instance_matrix = matrices.begin(); instance_matrix != matrices.end(); ++instance_matrix)
+			{
+				State.stream.RiAttributeBegin();
+				State.stream.RiConcatTransform(k3d::ri::convert(*instance_matrix));
+				State.stream.RiObjectInstance(handle);
+				State.stream.RiAttributeEnd();
+			}
 		}
 	}
 
@@ -237,11 +337,94 @@ public:
 
 
 private:
+	/// Paints the mesh into an archive shared with the other frames of an animation (if it isn't already there), then references the archive.
+	/// The mesh is only painted when its version has changed since the archive was stored.
+	void render_archive(k3d::ri::imesh_painter& Painter, const k3d::mesh& Mesh, const k3d::ri::render_state& State)
+	{
+		k3d::filesystem::path archive = State.archives->lookup(this, m_ri_archive_version);
+		if(archive.empty())
+		{
+			std::ostringstream buffer;
+			{
+				k3d::ri::stream stream(buffer);
+				stream.set_binary_encoding(State.archives->binary_encoding());
+
+				k3d::ri::render_state state(State.frame, stream, State.shaders, State.projection, State.render_context, State.sample_times, State.sample_index, State.camera_matrix);
+				Painter.paint_mesh(Mesh, state);
+			}
+
+			archive = State.archives->store(this, m_ri_archive_version, buffer.str());
+			watch_ri_archive_dependencies(Painter, Mesh);
+		}
+
+		if(archive.empty())
+		{
+			Painter.paint_mesh(Mesh, State);
+			return;
+		}
+
+		State.stream.RiReadArchive(archive);
+	}
+
+	/// Painters write their own settings and those of the materials used by the mesh (including shaders) into archives, so changes to any
+	/// of them must invalidate the archive
+	void watch_ri_archive_dependencies(k3d::ri::imesh_painter& Painter, const k3d::mesh& Mesh)
+	{
+		for(std::vector<sigc::connection>::iterator connection = m_ri_archive_connections.begin(); connection != m_ri_archive_connections.end(); ++connection)
+			connection->disconnect();
+		m_ri_archive_connections.clear();
+
+		std::set<k3d::iproperty_collection*> visited;
+		watch_ri_archive_properties(dynamic_cast<k3d::iproperty_collection*>(&Painter), visited);
+
+		std::set<k3d::imaterial*> materials;
+		k3d::mesh::visit_arrays(Mesh, detail::collect_materials(materials));
+		for(std::set<k3d::imaterial*>::const_iterator material = materials.begin(); material != materials.end(); ++material)
+			watch_ri_archive_properties(dynamic_cast<k3d::iproperty_collection*>(*material), visited);
+	}
+
+	/// Watches every property of a node, and of the nodes it references (such as shaders or child painters)
+	void watch_ri_archive_properties(k3d::iproperty_collection* const Node, std::set<k3d::iproperty_collection*>& Visited)
+	{
+		if(!Node || !Visited.insert(Node).second)
+			return;
+
+		const k3d::iproperty_collection::properties_t& properties = Node->properties();
+		for(k3d::iproperty_collection::properties_t::const_iterator prop = properties.begin(); prop != properties.end(); ++prop)
+		{
+			k3d::iproperty& property = **prop;
+			m_ri_archive_connections.push_back(property.property_changed_signal().connect(sigc::mem_fun(*this, &mesh_instance::on_ri_archive_changed)));
+
+			if(property.property_type() == typeid(k3d::inode*))
+				watch_ri_archive_properties(dynamic_cast<k3d::iproperty_collection*>(boost::any_cast<k3d::inode*>(k3d::property::pipeline_value(property))), Visited);
+		}
+	}
+
+	void on_ri_archive_changed(k3d::ihint*)
+	{
+		++m_ri_archive_version;
+	}
+
+	/// Returns the matrix of every instance in the given mesh, or a single identity matrix if the mesh doesn't contain instances
+	static const k3d::mesh::matrices_t instance_matrices(const k3d::mesh& Mesh)
+	{
+		k3d::mesh::matrices_t results;
+		if(!k3d::instances::get_matrices(Mesh, results))
+			results.push_back(k3d::identity3());
+
+		return results;
+	}
+
 	k3d_data(k3d::mesh*, k3d::data::immutable_name, k3d::data::change_signal, k3d::data::no_undo, k3d::data::local_storage, k3d::data::no_constraint, k3d::data::read_only_property, k3d::data::no_serialization) m_input_mesh;
 	k3d_data(k3d::mesh*, k3d::data::immutable_name, k3d::data::change_signal, k3d::data::no_undo, k3d::data::pointer_demand_storage, k3d::data::no_constraint, k3d::data::read_only_property, k3d::data::no_serialization) m_output_mesh;
 	k3d_data(k3d::gl::imesh_painter*, k3d::data::immutable_name, k3d::data::change_signal, k3d::data::with_undo, k3d::data::node_storage, k3d::data::no_constraint, k3d::data::node_property, k3d::data::node_serialization) m_gl_painter;
 	k3d_data(k3d::ri::imesh_painter*, k3d::data::immutable_name, k3d::data::change_signal, k3d::data::with_undo, k3d::data::node_storage, k3d::data::no_constraint, k3d::data::node_property, k3d::data::node_serialization) m_ri_painter;
 	k3d_data(bool, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_show_component_selection;
+
+	/// Incremented whenever the RIB painted for the mesh may have changed, so archives of earlier frames are reused until then
+	k3d::uint_t m_ri_archive_version;
+	/// Connections to the painter, material, and shader properties that affect the archived RIB
+	std::vector<sigc::connection> m_ri_archive_connections;
 };
 
 /////////////////////////////////////////////////////////////////////////////
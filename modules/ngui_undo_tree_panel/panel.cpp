@@ -119,6 +119,7 @@ public:
 		m_view.append_column(*manage(column));
 
 		m_document_state.document().state_recorder().connect_node_added_signal(sigc::mem_fun(*this, &implementation::on_node_added));
+		m_document_state.document().state_recorder().connect_nodes_removed_signal(sigc::mem_fun(*this, &implementation::on_update));
 		m_document_state.document().state_recorder().connect_current_node_changed_signal(sigc::mem_fun(*this, &implementation::on_current_node_changed));
 		m_document_state.document().state_recorder().connect_last_saved_node_changed_signal(sigc::mem_fun(*this, &implementation::on_last_saved_node_changed));
 
@@ -28,6 +28,7 @@
 #include <k3dsdk/table_copier.h>
 
 #include "nurbs_curves.h"
+#include "nurbs_evaluation.h"
 #include "utility.h" // for knot_nomalizer
 
 #include <boost/scoped_ptr.hpp>
@@ -1565,19 +1566,36 @@ void polygonize(k3d::mesh& OutputMesh, k3d::linear_curve::primitive& OutputCurve
 	if(OutputCurve.vertex_attributes.empty())
 		OutputCurve.vertex_attributes = curve.vertex_attributes.clone_types();
 
+	// Compute every basis function up-front, then combine the control points and attributes directly ...
+	const basis_table basis(curve.knots, curve.order, sample_u_vals);
+	k3d::table_copier point_copier(curve.point_attributes, OutputMesh.point_attributes);
+	k3d::table_copier vertex_copier(curve.vertex_attributes, OutputCurve.vertex_attributes);
+	k3d::mesh::indices_t indices(curve.order);
+	k3d::mesh::weights_t weights(curve.order);
+
 	k3d::mesh::points_t& points = OutputMesh.points.writable();
 	const k3d::uint_t samples_end = sample_u_vals.size();
+	points.reserve(points.size() + samples_end);
 	for(k3d::uint_t i = 0; i != samples_end; ++i)
 	{
-		curve_arrays::curve_value val = curve.evaluate(sample_u_vals[i]);
+		const k3d::double_t* const values = basis.values(i);
+		k3d::point4 weighted_position(0, 0, 0, 0);
+		for(k3d::uint_t j = 0; j != curve.order; ++j)
+		{
+			indices[j] = basis.first_points[i] + j;
+			weighted_position = weighted_position + values[j] * curve.points[indices[j]];
+		}
+		const k3d::double_t w = weighted_position[3];
+
 		OutputCurve.curve_points.push_back(points.size());
 		OutputCurve.curve_point_counts.back()++;
-		points.push_back(val.position());
+		points.push_back(k3d::point3(weighted_position[0]/w, weighted_position[1]/w, weighted_position[2]/w));
 
-		k3d::table_copier point_copier(val.point_attributes, OutputMesh.point_attributes);
-		point_copier.push_back(0);
-		k3d::table_copier vertex_copier(val.vertex_attributes, OutputCurve.vertex_attributes);
-		vertex_copier.push_back(0);
+		// Attributes are stored premultiplied by the point weights, so "unweight" them while interpolating
+		for(k3d::uint_t j = 0; j != curve.order; ++j)
+			weights[j] = values[j] / w;
+		point_copier.push_back(curve.order, &indices[0], &weights[0]);
+		vertex_copier.push_back(curve.order, &indices[0], &weights[0]);
 	}
 	OutputMesh.point_selection.writable().resize(points.size(), 1.0);
 }
@@ -0,0 +1,533 @@
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Timothy M. Shead (tshead@k-3d.com)
+*/
+
+#include "nurbs_evaluation.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace module
+{
+
+namespace nurbs
+{
+
+namespace detail
+{
+
+/// Number of probe intervals per knot span used to estimate curvature for adaptive sampling
+const k3d::uint_t probe_steps = 4;
+
+/// Returns the number of segments required to keep the chordal error of a span below Tolerance, given the largest second difference of its probes
+const k3d::uint_t required_segments(const k3d::double_t SecondDifference, const k3d::double_t Tolerance, const k3d::uint_t MaximumSegments)
+{
+	// With probes spaced h apart, the second difference approximates f''h^2.  A span of length 4h divided into n segments has a
+	// chordal error of roughly f''(4h/n)^2/8 = 2*SecondDifference/n^2 ...
+	const k3d::double_t segments = std::ceil(std::sqrt(2.0 * SecondDifference / Tolerance));
+	if(!(segments < MaximumSegments))
+		return MaximumSegments;
+	return std::max(static_cast<k3d::uint_t>(segments), k3d::uint_t(1));
+}
+
+/// Returns the largest second difference of the probe points Points[Begin + k * Stride] for k in [1, probe_steps - 1]
+const k3d::double_t second_difference(const k3d::mesh::points_t& Points, const k3d::uint_t Begin, const k3d::uint_t Stride)
+{
+	k3d::double_t result = 0;
+	for(k3d::uint_t k = 1; k != probe_steps; ++k)
+	{
+		const k3d::point3& a = Points[Begin + (k - 1) * Stride];
+		const k3d::point3& b = Points[Begin + k * Stride];
+		const k3d::point3& c = Points[Begin + (k + 1) * Stride];
+		result = std::max(result, k3d::length(k3d::to_vector(a) - 2.0 * k3d::to_vector(b) + k3d::to_vector(c)));
+	}
+	return result;
+}
+
+/// Ensures that a set of per-span segment counts produces at least two segments in total
+void require_two_segments(k3d::mesh::counts_t& Segments)
+{
+	k3d::uint_t total = 0;
+	for(k3d::uint_t i = 0; i != Segments.size(); ++i)
+		total += Segments[i];
+	if(total < 2)
+		Segments[0] = 2;
+}
+
+/// Returns the boundary sample closest to each interior parameter, excluding the boundary corners
+void nearest_samples(const k3d::mesh::knots_t& Interior, const k3d::mesh::knots_t& Boundary, k3d::mesh::indices_t& Nearest)
+{
+	const k3d::uint_t last = Boundary.size() - 1;
+	Nearest.assign(Interior.size(), 0);
+	for(k3d::uint_t i = 1; i + 1 < Interior.size(); ++i)
+	{
+		const k3d::uint_t upper = std::lower_bound(Boundary.begin(), Boundary.end(), Interior[i]) - Boundary.begin();
+		k3d::uint_t nearest = upper;
+		if(upper == Boundary.size() || (upper > 0 && Interior[i] - Boundary[upper - 1] < Boundary[upper] - Interior[i]))
+			nearest = upper - 1;
+		Nearest[i] = std::min(std::max(nearest, k3d::uint_t(1)), last - 1);
+	}
+}
+
+/// Appends the boundary vertices Boundary(Begin) through Boundary(End) inclusive, in either direction
+template<typename BoundaryT>
+void append_boundary(k3d::mesh::indices_t& VertexIndices, const BoundaryT& Boundary, const k3d::uint_t Begin, const k3d::uint_t End)
+{
+	if(Begin <= End)
+	{
+		for(k3d::uint_t k = Begin; k <= End; ++k)
+			VertexIndices.push_back(Boundary(k));
+	}
+	else
+	{
+		for(k3d::uint_t k = Begin + 1; k-- > End; )
+			VertexIndices.push_back(Boundary(k));
+	}
+}
+
+/// Maps boundary sample numbers to vertex indices, for boundaries that store their end points in neighboring boundaries
+struct boundary_vertices
+{
+	boundary_vertices(const k3d::uint_t Begin, const k3d::uint_t Last, const k3d::uint_t First, const k3d::uint_t LastVertex) :
+		begin(Begin),
+		last(Last),
+		first(First),
+		last_vertex(LastVertex)
+	{
+	}
+
+	const k3d::uint_t operator()(const k3d::uint_t Sample) const
+	{
+		if(Sample == 0)
+			return first;
+		if(Sample == last)
+			return last_vertex;
+		return begin + Sample - 1;
+	}
+
+	const k3d::uint_t begin;
+	const k3d::uint_t last;
+	const k3d::uint_t first;
+	const k3d::uint_t last_vertex;
+};
+
+/// Maps boundary sample numbers to vertex indices, for boundaries that store all of their samples
+struct all_boundary_vertices
+{
+	all_boundary_vertices(const k3d::uint_t Begin) :
+		begin(Begin)
+	{
+	}
+
+	const k3d::uint_t operator()(const k3d::uint_t Sample) const
+	{
+		return begin + Sample;
+	}
+
+	const k3d::uint_t begin;
+};
+
+/// Maps interior grid coordinates (i, j), for i in [1, n-1] and j in [1, m-1], to vertex indices
+struct interior_vertices
+{
+	interior_vertices(const k3d::uint_t Begin, const k3d::uint_t N) :
+		begin(Begin),
+		row_size(N - 1)
+	{
+	}
+
+	const k3d::uint_t operator()(const k3d::uint_t I, const k3d::uint_t J) const
+	{
+		return begin + (J - 1) * row_size + (I - 1);
+	}
+
+	const k3d::uint_t begin;
+	const k3d::uint_t row_size;
+};
+
+} // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////////
+// basis_table
+
+basis_table::basis_table(const k3d::mesh::knots_t& Knots, const k3d::uint_t Order, const k3d::mesh::knots_t& Parameters) :
+	order(Order)
+{
+	const k3d::uint_t parameter_count = Parameters.size();
+	const k3d::uint_t point_count = Knots.size() - Order;
+	first_points.resize(parameter_count);
+	basis_values.assign(parameter_count * Order, 0.0);
+
+	k3d::mesh::weights_t left(Order, 0.0);
+	k3d::mesh::weights_t right(Order, 0.0);
+
+	const k3d::double_t domain_begin = Knots[Order - 1];
+	const k3d::double_t domain_end = Knots[point_count];
+	for(k3d::uint_t parameter = 0; parameter != parameter_count; ++parameter)
+	{
+		const k3d::double_t u = Parameters[parameter];
+		k3d::double_t* const basis = &basis_values[parameter * Order];
+
+		if(u < domain_begin)
+		{
+			first_points[parameter] = 0;
+			basis[0] = 1;
+			continue;
+		}
+		if(u >= domain_end)
+		{
+			first_points[parameter] = point_count - Order;
+			basis[Order - 1] = 1;
+			continue;
+		}
+
+		// Find the span such that Knots[span] <= u < Knots[span + 1] ...
+		const k3d::uint_t span = std::upper_bound(Knots.begin() + Order - 1, Knots.begin() + point_count, u) - Knots.begin() - 1;
+		first_points[parameter] = span + 1 - Order;
+
+		// Cox-de Boor recursion, see "The NURBS Book", algorithm A2.2 ...
+		basis[0] = 1;
+		for(k3d::uint_t j = 1; j != Order; ++j)
+		{
+			left[j] = u - Knots[span + 1 - j];
+			right[j] = Knots[span + j] - u;
+			k3d::double_t saved = 0.0;
+			for(k3d::uint_t r = 0; r != j; ++r)
+			{
+				const k3d::double_t temp = basis[r] / (right[r + 1] + left[j - r]);
+				basis[r] = saved + right[r + 1] * temp;
+				saved = left[j - r] * temp;
+			}
+			basis[j] = saved;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// patch_evaluator
+
+patch_evaluator::patch_evaluator(const k3d::mesh& Mesh, const k3d::nurbs_patch::const_primitive& Patches, const k3d::uint_t Patch) :
+	u_order(Patches.patch_u_orders[Patch]),
+	v_order(Patches.patch_v_orders[Patch]),
+	u_point_count(Patches.patch_u_point_counts[Patch]),
+	v_point_count(Patches.patch_v_point_counts[Patch])
+{
+	const k3d::uint_t u_knots_begin = Patches.patch_u_first_knots[Patch];
+	u_knots.assign(Patches.patch_u_knots.begin() + u_knots_begin, Patches.patch_u_knots.begin() + u_knots_begin + u_point_count + u_order);
+	const k3d::uint_t v_knots_begin = Patches.patch_v_first_knots[Patch];
+	v_knots.assign(Patches.patch_v_knots.begin() + v_knots_begin, Patches.patch_v_knots.begin() + v_knots_begin + v_point_count + v_order);
+
+	const k3d::mesh::points_t& points = *Mesh.points;
+	const k3d::uint_t point_count = u_point_count * v_point_count;
+	const k3d::uint_t points_begin = Patches.patch_first_points[Patch];
+	x.resize(point_count);
+	y.resize(point_count);
+	z.resize(point_count);
+	w.resize(point_count);
+	for(k3d::uint_t i = 0; i != point_count; ++i)
+	{
+		const k3d::point3& p = points[Patches.patch_points[points_begin + i]];
+		const k3d::double_t weight = Patches.patch_point_weights[points_begin + i];
+		x[i] = p[0] * weight;
+		y[i] = p[1] * weight;
+		z[i] = p[2] * weight;
+		w[i] = weight;
+	}
+}
+
+void patch_evaluator::evaluate(const basis_table& U, const basis_table& V, k3d::mesh::points_t& Points) const
+{
+	const k3d::uint_t u_count = U.size();
+	const k3d::uint_t v_count = V.size();
+	if(!u_count || !v_count)
+		return;
+
+	// Only the columns of control points that influence a U parameter need to be contracted ...
+	k3d::uint_t column_begin = u_point_count;
+	k3d::uint_t column_end = 0;
+	for(k3d::uint_t i = 0; i != u_count; ++i)
+	{
+		column_begin = std::min(column_begin, static_cast<k3d::uint_t>(U.first_points[i]));
+		column_end = std::max(column_end, static_cast<k3d::uint_t>(U.first_points[i] + u_order));
+	}
+
+	k3d::mesh::weights_t row_x(u_point_count), row_y(u_point_count), row_z(u_point_count), row_w(u_point_count);
+
+	Points.reserve(Points.size() + u_count * v_count);
+	for(k3d::uint_t j = 0; j != v_count; ++j)
+	{
+		// Contract the control points with the V basis, producing one row of homogeneous points ...
+		std::fill(row_x.begin() + column_begin, row_x.begin() + column_end, 0.0);
+		std::fill(row_y.begin() + column_begin, row_y.begin() + column_end, 0.0);
+		std::fill(row_z.begin() + column_begin, row_z.begin() + column_end, 0.0);
+		std::fill(row_w.begin() + column_begin, row_w.begin() + column_end, 0.0);
+
+		const k3d::double_t* const v_basis = V.values(j);
+		for(k3d::uint_t l = 0; l != v_order; ++l)
+		{
+			const k3d::double_t n = v_basis[l];
+			if(n == 0.0)
+				continue;
+
+			const k3d::uint_t row_begin = (V.first_points[j] + l) * u_point_count;
+			const k3d::double_t* const px = &x[row_begin];
+			const k3d::double_t* const py = &y[row_begin];
+			const k3d::double_t* const pz = &z[row_begin];
+			const k3d::double_t* const pw = &w[row_begin];
+			for(k3d::uint_t i = column_begin; i != column_end; ++i)
+			{
+				row_x[i] += n * px[i];
+				row_y[i] += n * py[i];
+				row_z[i] += n * pz[i];
+				row_w[i] += n * pw[i];
+			}
+		}
+
+		// Evaluate the row at every U parameter ...
+		for(k3d::uint_t i = 0; i != u_count; ++i)
+		{
+			const k3d::double_t* const u_basis = U.values(i);
+			const k3d::uint_t first = U.first_points[i];
+			k3d::double_t sx = 0, sy = 0, sz = 0, sw = 0;
+			for(k3d::uint_t k = 0; k != u_order; ++k)
+			{
+				sx += u_basis[k] * row_x[first + k];
+				sy += u_basis[k] * row_y[first + k];
+				sz += u_basis[k] * row_z[first + k];
+				sw += u_basis[k] * row_w[first + k];
+			}
+			Points.push_back(k3d::point3(sx / sw, sy / sw, sz / sw));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// unique_domain_knots
+
+void unique_domain_knots(const k3d::mesh::knots_t& Knots, const k3d::uint_t Order, const k3d::uint_t PointCount, k3d::mesh::knots_t& UniqueKnots)
+{
+	for(k3d::uint_t i = Order - 1; i <= PointCount; ++i)
+	{
+		if(UniqueKnots.empty() || std::abs(Knots[i] - UniqueKnots.back()) >= 0.000001)
+			UniqueKnots.push_back(Knots[i]);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// sample
+
+void sample(const k3d::mesh::knots_t& UniqueKnots, const k3d::mesh::counts_t& Segments, k3d::mesh::knots_t& Parameters)
+{
+	const k3d::uint_t span_count = Segments.size();
+	for(k3d::uint_t span = 0; span != span_count; ++span)
+	{
+		const k3d::double_t start = UniqueKnots[span];
+		const k3d::double_t step = (UniqueKnots[span + 1] - start) / static_cast<k3d::double_t>(Segments[span]);
+		for(k3d::uint_t segment = 0; segment != Segments[span]; ++segment)
+			Parameters.push_back(start + static_cast<k3d::double_t>(segment) * step);
+	}
+	Parameters.push_back(UniqueKnots[span_count]);
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// polygonize_adaptive
+
+void polygonize_adaptive(k3d::mesh::points_t& Vertices, k3d::mesh::counts_t& VertexCounts, k3d::mesh::indices_t& VertexIndices, const k3d::mesh& InputMesh, const k3d::nurbs_patch::const_primitive& InputPatches, const k3d::uint_t Patch, const k3d::double_t Tolerance, const k3d::uint_t MaximumSegments)
+{
+	const patch_evaluator patch(InputMesh, InputPatches, Patch);
+
+	k3d::mesh::knots_t u_knots;
+	unique_domain_knots(patch.u_knots, patch.u_order, patch.u_point_count, u_knots);
+	k3d::mesh::knots_t v_knots;
+	unique_domain_knots(patch.v_knots, patch.v_order, patch.v_point_count, v_knots);
+	if(u_knots.size() < 2 || v_knots.size() < 2)
+		return;
+
+	const k3d::uint_t u_span_count = u_knots.size() - 1;
+	const k3d::uint_t v_span_count = v_knots.size() - 1;
+
+	// Evaluate a grid of probe points ...
+	k3d::mesh::knots_t u_probes;
+	sample(u_knots, k3d::mesh::counts_t(u_span_count, detail::probe_steps), u_probes);
+	k3d::mesh::knots_t v_probes;
+	sample(v_knots, k3d::mesh::counts_t(v_span_count, detail::probe_steps), v_probes);
+	k3d::mesh::points_t probes;
+	patch.evaluate(basis_table(patch.u_knots, patch.u_order, u_probes), basis_table(patch.v_knots, patch.v_order, v_probes), probes);
+
+	const k3d::uint_t u_probe_count = u_probes.size();
+	const k3d::uint_t v_probe_count = v_probes.size();
+	const k3d::uint_t last_row = (v_probe_count - 1) * u_probe_count;
+	const k3d::uint_t last_column = u_probe_count - 1;
+
+	// Choose segment counts for each span.  The interior uses the worst case across the patch, while each boundary only considers
+	// its own probes, so it can be reproduced by any patch that shares the same boundary curve ...
+	k3d::mesh::counts_t u_segments(u_span_count, 1), south_segments(u_span_count, 1), north_segments(u_span_count, 1);
+	for(k3d::uint_t span = 0; span != u_span_count; ++span)
+	{
+		const k3d::uint_t begin = span * detail::probe_steps;
+		for(k3d::uint_t row = 0; row != v_probe_count; ++row)
+			u_segments[span] = std::max(u_segments[span], detail::required_segments(detail::second_difference(probes, row * u_probe_count + begin, 1), Tolerance, MaximumSegments));
+		south_segments[span] = detail::required_segments(detail::second_difference(probes, begin, 1), Tolerance, MaximumSegments);
+		north_segments[span] = detail::required_segments(detail::second_difference(probes, last_row + begin, 1), Tolerance, MaximumSegments);
+	}
+
+	k3d::mesh::counts_t v_segments(v_span_count, 1), west_segments(v_span_count, 1), east_segments(v_span_count, 1);
+	for(k3d::uint_t span = 0; span != v_span_count; ++span)
+	{
+		const k3d::uint_t begin = span * detail::probe_steps * u_probe_count;
+		for(k3d::uint_t column = 0; column != u_probe_count; ++column)
+			v_segments[span] = std::max(v_segments[span], detail::required_segments(detail::second_difference(probes, begin + column, u_probe_count), Tolerance, MaximumSegments));
+		west_segments[span] = detail::required_segments(detail::second_difference(probes, begin, u_probe_count), Tolerance, MaximumSegments);
+		east_segments[span] = detail::required_segments(detail::second_difference(probes, begin + last_column, u_probe_count), Tolerance, MaximumSegments);
+	}
+
+	detail::require_two_segments(u_segments);
+	detail::require_two_segments(south_segments);
+	detail::require_two_segments(north_segments);
+	detail::require_two_segments(v_segments);
+	detail::require_two_segments(west_segments);
+	detail::require_two_segments(east_segments);
+
+	k3d::mesh::knots_t u_parameters, v_parameters, south_parameters, north_parameters, west_parameters, east_parameters;
+	sample(u_knots, u_segments, u_parameters);
+	sample(v_knots, v_segments, v_parameters);
+	sample(u_knots, south_segments, south_parameters);
+	sample(u_knots, north_segments, north_parameters);
+	sample(v_knots, west_segments, west_parameters);
+	sample(v_knots, east_segments, east_parameters);
+
+	// Evaluate the interior grid (excluding the outermost parameters in each direction), followed by the boundaries.  The south
+	// and north boundaries store the patch corners, so the west and east boundaries only store their interior samples ...
+	const k3d::uint_t n = u_parameters.size() - 1;
+	const k3d::uint_t m = v_parameters.size() - 1;
+	const k3d::uint_t south_last = south_parameters.size() - 1;
+	const k3d::uint_t north_last = north_parameters.size() - 1;
+	const k3d::uint_t west_last = west_parameters.size() - 1;
+	const k3d::uint_t east_last = east_parameters.size() - 1;
+
+	const k3d::mesh::knots_t u_begin(1, patch.u_begin());
+	const k3d::mesh::knots_t u_end(1, patch.u_end());
+	const k3d::mesh::knots_t v_begin(1, patch.v_begin());
+	const k3d::mesh::knots_t v_end(1, patch.v_end());
+
+	const k3d::uint_t interior_begin = Vertices.size();
+	patch.evaluate(
+		basis_table(patch.u_knots, patch.u_order, k3d::mesh::knots_t(u_parameters.begin() + 1, u_parameters.end() - 1)),
+		basis_table(patch.v_knots, patch.v_order, k3d::mesh::knots_t(v_parameters.begin() + 1, v_parameters.end() - 1)),
+		Vertices);
+
+	const k3d::uint_t south_begin = Vertices.size();
+	patch.evaluate(basis_table(patch.u_knots, patch.u_order, south_parameters), basis_table(patch.v_knots, patch.v_order, v_begin), Vertices);
+	const k3d::uint_t north_begin = Vertices.size();
+	patch.evaluate(basis_table(patch.u_knots, patch.u_order, north_parameters), basis_table(patch.v_knots, patch.v_order, v_end), Vertices);
+	const k3d::uint_t west_begin = Vertices.size();
+	patch.evaluate(basis_table(patch.u_knots, patch.u_order, u_begin), basis_table(patch.v_knots, patch.v_order, k3d::mesh::knots_t(west_parameters.begin() + 1, west_parameters.end() - 1)), Vertices);
+	const k3d::uint_t east_begin = Vertices.size();
+	patch.evaluate(basis_table(patch.u_knots, patch.u_order, u_end), basis_table(patch.v_knots, patch.v_order, k3d::mesh::knots_t(east_parameters.begin() + 1, east_parameters.end() - 1)), Vertices);
+
+	const detail::all_boundary_vertices south(south_begin);
+	const detail::all_boundary_vertices north(north_begin);
+	const detail::boundary_vertices west(west_begin, west_last, south(0), north(0));
+	const detail::boundary_vertices east(east_begin, east_last, south(south_last), north(north_last));
+
+	const detail::interior_vertices interior(interior_begin, n);
+
+	// Interior quads ...
+	for(k3d::uint_t j = 1; j + 1 < m; ++j)
+	{
+		for(k3d::uint_t i = 1; i + 1 < n; ++i)
+		{
+			VertexIndices.push_back(interior(i, j));
+			VertexIndices.push_back(interior(i + 1, j));
+			VertexIndices.push_back(interior(i + 1, j + 1));
+			VertexIndices.push_back(interior(i, j + 1));
+			VertexCounts.push_back(4);
+		}
+	}
+
+	// Stitch the interior grid to each boundary, using the boundary sample nearest each interior grid line ...
+	k3d::mesh::indices_t south_nearest, north_nearest, west_nearest, east_nearest;
+	detail::nearest_samples(u_parameters, south_parameters, south_nearest);
+	detail::nearest_samples(u_parameters, north_parameters, north_nearest);
+	detail::nearest_samples(v_parameters, west_parameters, west_nearest);
+	detail::nearest_samples(v_parameters, east_parameters, east_nearest);
+
+	for(k3d::uint_t i = 1; i + 1 < n; ++i)
+	{
+		k3d::uint_t first_index = VertexIndices.size();
+		detail::append_boundary(VertexIndices, south, south_nearest[i], south_nearest[i + 1]);
+		VertexIndices.push_back(interior(i + 1, 1));
+		VertexIndices.push_back(interior(i, 1));
+		VertexCounts.push_back(VertexIndices.size() - first_index);
+
+		first_index = VertexIndices.size();
+		VertexIndices.push_back(interior(i, m - 1));
+		VertexIndices.push_back(interior(i + 1, m - 1));
+		detail::append_boundary(VertexIndices, north, north_nearest[i + 1], north_nearest[i]);
+		VertexCounts.push_back(VertexIndices.size() - first_index);
+	}
+
+	for(k3d::uint_t j = 1; j + 1 < m; ++j)
+	{
+		k3d::uint_t first_index = VertexIndices.size();
+		VertexIndices.push_back(interior(1, j));
+		VertexIndices.push_back(interior(1, j + 1));
+		detail::append_boundary(VertexIndices, west, west_nearest[j + 1], west_nearest[j]);
+		VertexCounts.push_back(VertexIndices.size() - first_index);
+
+		first_index = VertexIndices.size();
+		VertexIndices.push_back(interior(n - 1, j));
+		detail::append_boundary(VertexIndices, east, east_nearest[j], east_nearest[j + 1]);
+		VertexIndices.push_back(interior(n - 1, j + 1));
+		VertexCounts.push_back(VertexIndices.size() - first_index);
+	}
+
+	// Corners ...
+	k3d::uint_t first_index = VertexIndices.size();
+	detail::append_boundary(VertexIndices, south, 0, south_nearest[1]);
+	VertexIndices.push_back(interior(1, 1));
+	detail::append_boundary(VertexIndices, west, west_nearest[1], 1);
+	VertexCounts.push_back(VertexIndices.size() - first_index);
+
+	first_index = VertexIndices.size();
+	detail::append_boundary(VertexIndices, south, south_nearest[n - 1], south_last);
+	detail::append_boundary(VertexIndices, east, 1, east_nearest[1]);
+	VertexIndices.push_back(interior(n - 1, 1));
+	VertexCounts.push_back(VertexIndices.size() - first_index);
+
+	first_index = VertexIndices.size();
+	VertexIndices.push_back(interior(n - 1, m - 1));
+	detail::append_boundary(VertexIndices, east, east_nearest[m - 1], east_last);
+	detail::append_boundary(VertexIndices, north, north_last - 1, north_nearest[n - 1]);
+	VertexCounts.push_back(VertexIndices.size() - first_index);
+
+	first_index = VertexIndices.size();
+	VertexIndices.push_back(interior(1, m - 1));
+	detail::append_boundary(VertexIndices, north, north_nearest[1], 0);
+	detail::append_boundary(VertexIndices, west, west_last - 1, west_nearest[m - 1]);
+	VertexCounts.push_back(VertexIndices.size() - first_index);
+}
+
+} //namespace nurbs
+
+} //namespace module
+
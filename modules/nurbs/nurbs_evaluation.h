@@ -0,0 +1,105 @@
+#ifndef MODULES_NURBS_NURBS_EVALUATION_H
+#define MODULES_NURBS_NURBS_EVALUATION_H
+
+// K-3D
+// Copyright (c) 1995-2010, Timothy M. Shead
+//
+// Contact: tshead@k-3d.com
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public
+// License as published by the Free Software Foundation; either
+// version 2 of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+/** \file
+	\author Timothy M. Shead (tshead@k-3d.com)
+*/
+
+#include <k3dsdk/mesh.h>
+#include <k3dsdk/nurbs_patch.h>
+
+namespace module
+{
+
+namespace nurbs
+{
+
+/// Stores the nonzero B-spline basis function values for a sorted set of parameter values, so they can be reused for every row of a grid
+/**
+ * Parameters outside the knot domain evaluate to the first or last control point.
+ */
+class basis_table
+{
+public:
+	basis_table(const k3d::mesh::knots_t& Knots, const k3d::uint_t Order, const k3d::mesh::knots_t& Parameters);
+
+	/// Returns the number of parameter values
+	const k3d::uint_t size() const
+	{
+		return first_points.size();
+	}
+
+	/// Returns the basis values for a parameter (Order values, starting with the value for control point first_points[Parameter])
+	const k3d::double_t* values(const k3d::uint_t Parameter) const
+	{
+		return &basis_values[Parameter * order];
+	}
+
+	k3d::uint_t order;
+	/// Stores the first control point influencing each parameter value
+	k3d::mesh::indices_t first_points;
+	/// Stores Order basis values for each parameter value
+	k3d::mesh::weights_t basis_values;
+};
+
+/// Stores the homogeneous control points of one NURBS patch as separate coordinate arrays, and evaluates whole parameter grids at once
+class patch_evaluator
+{
+public:
+	patch_evaluator(const k3d::mesh& Mesh, const k3d::nurbs_patch::const_primitive& Patches, const k3d::uint_t Patch);
+
+	/// Appends the surface points for every combination of U and V parameters (U varies fastest)
+	void evaluate(const basis_table& U, const basis_table& V, k3d::mesh::points_t& Points) const;
+
+	/// Returns the first and last parameter values of the valid domain in the U direction
+	const k3d::double_t u_begin() const { return u_knots[u_order - 1]; }
+	const k3d::double_t u_end() const { return u_knots[u_point_count]; }
+	/// Returns the first and last parameter values of the valid domain in the V direction
+	const k3d::double_t v_begin() const { return v_knots[v_order - 1]; }
+	const k3d::double_t v_end() const { return v_knots[v_point_count]; }
+
+	k3d::uint_t u_order;
+	k3d::uint_t v_order;
+	k3d::uint_t u_point_count;
+	k3d::uint_t v_point_count;
+	k3d::mesh::knots_t u_knots;
+	k3d::mesh::knots_t v_knots;
+	/// Homogeneous control point coordinates (x*w, y*w, z*w, w), with U varying fastest
+	k3d::mesh::weights_t x, y, z, w;
+};
+
+/// Appends the distinct knot values within the valid domain of a knot vector
+void unique_domain_knots(const k3d::mesh::knots_t& Knots, const k3d::uint_t Order, const k3d::uint_t PointCount, k3d::mesh::knots_t& UniqueKnots);
+
+/// Appends parameter values that divide each interval between UniqueKnots into the given number of segments, including both ends
+void sample(const k3d::mesh::knots_t& UniqueKnots, const k3d::mesh::counts_t& Segments, k3d::mesh::knots_t& Parameters);
+
+/// Polygonizes a NURBS patch with a sample density that adapts to its curvature.  Each boundary is sampled using only the geometry of
+/// the boundary itself, so neighboring patches that share a boundary curve produce matching vertices along it.
+void polygonize_adaptive(k3d::mesh::points_t& Vertices, k3d::mesh::counts_t& VertexCounts, k3d::mesh::indices_t& VertexIndices, const k3d::mesh& InputMesh, const k3d::nurbs_patch::const_primitive& InputPatches, const k3d::uint_t Patch, const k3d::double_t Tolerance, const k3d::uint_t MaximumSegments);
+
+} //namespace nurbs
+
+} //namespace module
+
+#endif // !MODULES_NURBS_NURBS_EVALUATION_H
+
@@ -23,6 +23,7 @@
 */
 
 #include "nurbs_curves.h"
+#include "nurbs_evaluation.h"
 #include "nurbs_patches.h"
 #include "utility.h"
 
@@ -1355,49 +1356,27 @@ void sweep(k3d::mesh& OutputMesh, k3d::nurbs_patch::primitive& OutputPatches, co
 
 void polygonize(k3d::mesh::points_t& Vertices, k3d::mesh::counts_t& VertexCounts, k3d::mesh::indices_t& VertexIndices, const k3d::mesh& InputMesh, const k3d::nurbs_patch::const_primitive& InputPatches, const k3d::uint_t Patch, const k3d::uint_t USamples, const k3d::uint_t VSamples)
 {
-	const k3d::uint_t u_order = InputPatches.patch_u_orders[Patch];
-	const k3d::uint_t u_knots_begin = InputPatches.patch_u_first_knots[Patch];
-	const k3d::uint_t u_knots_end = u_knots_begin + InputPatches.patch_u_point_counts[Patch] + u_order;
-	const k3d::mesh::knots_t::const_iterator u_it = InputPatches.patch_u_knots.begin();
-	k3d::mesh::knots_t u_knots(u_it + u_knots_begin, u_it + u_knots_end);
-	k3d::mesh::knots_t u_samples;
-	sample(u_samples, u_knots, USamples);
+	const patch_evaluator patch(InputMesh, InputPatches, Patch);
 
-	const k3d::uint_t v_order = InputPatches.patch_v_orders[Patch];
-	const k3d::uint_t v_knots_begin = InputPatches.patch_v_first_knots[Patch];
-	const k3d::uint_t v_knots_end = v_knots_begin + InputPatches.patch_v_point_counts[Patch] + v_order;
-	const k3d::mesh::knots_t::const_iterator v_it = InputPatches.patch_v_knots.begin();
-	k3d::mesh::knots_t v_knots(v_it + v_knots_begin, v_it + v_knots_end);
-	std::transform(v_knots.begin(), v_knots.end(), v_knots.begin(), knot_normalizer(v_knots.front(), v_knots.back()));
+	k3d::mesh::knots_t u_samples;
+	sample(u_samples, patch.u_knots, USamples);
 	k3d::mesh::knots_t v_samples;
-	sample(v_samples, v_knots, VSamples);
+	sample(v_samples, patch.v_knots, VSamples);
 
 	const k3d::uint_t u_sample_count = u_samples.size();
 	const k3d::uint_t v_sample_count = v_samples.size();
 
-	for(k3d::uint_t j = 0; j != v_sample_count; ++j)
-	{
-		const k3d::double_t v = v_samples[j];
-		k3d::mesh curve_mesh;
-		curve_mesh.points.create();
-		curve_mesh.point_selection.create();
-		boost::scoped_ptr<k3d::nurbs_curve::primitive> curve(k3d::nurbs_curve::create(curve_mesh));
-		extract_patch_curve_by_parameter(curve_mesh, *curve, InputMesh, InputPatches, Patch, v, true);
-		curve_arrays curve_arr(curve_mesh, *curve, 0);
-		for(k3d::uint_t i = 0; i != u_sample_count; ++i)
-		{
-			const k3d::double_t u = u_samples[i];
-			Vertices.push_back(curve_arr.evaluate(u).position());
-		}
-	}
+	const k3d::uint_t first_vertex = Vertices.size();
+	patch.evaluate(basis_table(patch.u_knots, patch.u_order, u_samples), basis_table(patch.v_knots, patch.v_order, v_samples), Vertices);
+
 	for(k3d::uint_t j = 0; j != v_sample_count-1; ++j)
 	{
 		for(k3d::uint_t i = 0; i != u_sample_count-1; ++i)
 		{
-			VertexIndices.push_back(j*u_sample_count+i);
-			VertexIndices.push_back(j*u_sample_count+i+1);
-			VertexIndices.push_back((j+1)*u_sample_count+i+1);
-			VertexIndices.push_back((j+1)*u_sample_count+i);
+			VertexIndices.push_back(first_vertex + j*u_sample_count+i);
+			VertexIndices.push_back(first_vertex + j*u_sample_count+i+1);
+			VertexIndices.push_back(first_vertex + (j+1)*u_sample_count+i+1);
+			VertexIndices.push_back(first_vertex + (j+1)*u_sample_count+i);
 			VertexCounts.push_back(4);
 		}
 	}
@@ -21,6 +21,7 @@
 	\author Carsten Haubold (CarstenHaubold@web.de)
 */
 
+#include "nurbs_evaluation.h"
 #include "nurbs_patches.h"
 #include "utility.h"
 
@@ -37,6 +38,8 @@
 #include <k3dsdk/module.h>
 #include <k3dsdk/node.h>
 #include <k3dsdk/nurbs_patch.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
 #include <k3dsdk/point3.h>
 #include <k3dsdk/polyhedron.h>
 #include <k3dsdk/selection.h>
@@ -51,6 +54,61 @@ namespace module
 
 namespace nurbs
 {
+
+namespace detail
+{
+
+/// Stores the polygons generated for one patch
+struct tessellation
+{
+	k3d::mesh::points_t vertices;
+	k3d::mesh::counts_t vertex_counts;
+	k3d::mesh::indices_t vertex_indices;
+};
+
+/// Polygonizes a set of patches in parallel, storing a separate tessellation for each
+class polygonize_patches
+{
+public:
+	polygonize_patches(const k3d::mesh& Mesh, const k3d::nurbs_patch::const_primitive& Patches, const k3d::mesh::indices_t& SelectedPatches, const k3d::bool_t Adaptive, const k3d::uint_t USamples, const k3d::uint_t VSamples, const k3d::double_t Tolerance, const k3d::uint_t MaximumSegments, std::vector<tessellation>& Tessellations) :
+		m_mesh(Mesh),
+		m_patches(Patches),
+		m_selected_patches(SelectedPatches),
+		m_adaptive(Adaptive),
+		m_u_samples(USamples),
+		m_v_samples(VSamples),
+		m_tolerance(Tolerance),
+		m_maximum_segments(MaximumSegments),
+		m_tessellations(Tessellations)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& Range) const
+	{
+		for(k3d::uint_t i = Range.begin(); i != Range.end(); ++i)
+		{
+			tessellation& output = m_tessellations[i];
+			if(m_adaptive)
+				polygonize_adaptive(output.vertices, output.vertex_counts, output.vertex_indices, m_mesh, m_patches, m_selected_patches[i], m_tolerance, m_maximum_segments);
+			else
+				polygonize(output.vertices, output.vertex_counts, output.vertex_indices, m_mesh, m_patches, m_selected_patches[i], m_u_samples, m_v_samples);
+		}
+	}
+
+private:
+	const k3d::mesh& m_mesh;
+	const k3d::nurbs_patch::const_primitive& m_patches;
+	const k3d::mesh::indices_t& m_selected_patches;
+	const k3d::bool_t m_adaptive;
+	const k3d::uint_t m_u_samples;
+	const k3d::uint_t m_v_samples;
+	const k3d::double_t m_tolerance;
+	const k3d::uint_t m_maximum_segments;
+	std::vector<tessellation>& m_tessellations;
+};
+
+} // namespace detail
+
 class polygonize_patch :
 			public k3d::mesh_selection_sink<k3d::mesh_modifier<k3d::node > >
 {
@@ -60,12 +118,18 @@ public:
 			base(Factory, Document),
 			m_u_samples(init_owner(*this) + init_name(_("u_samples")) + init_label(_("U Samples")) + init_description(_("Samples per knot interval in the U direction. More is better")) + init_value(5) + init_constraint(constraint::minimum(1))),
 			m_v_samples(init_owner(*this) + init_name(_("v_samples")) + init_label(_("V Samples")) + init_description(_("Samples per knot interval in the V direction. More is better")) + init_value(5) + init_constraint(constraint::minimum(1))),
-			m_delete_orig(init_owner(*this) + init_name(_("delete_orig")) + init_label(_("Delete original?")) + init_description(_("Delete original NURBS curve?")) + init_value(true))
+			m_delete_orig(init_owner(*this) + init_name(_("delete_orig")) + init_label(_("Delete original?")) + init_description(_("Delete original NURBS curve?")) + init_value(true)),
+			m_adaptive(init_owner(*this) + init_name(_("adaptive")) + init_label(_("Adaptive")) + init_description(_("Choose the number of samples from the surface curvature, instead of using U Samples and V Samples")) + init_value(false)),
+			m_tolerance(init_owner(*this) + init_name(_("tolerance")) + init_label(_("Tolerance")) + init_description(_("Maximum distance between the surface and its polygons, when sampling adaptively")) + init_value(0.01) + init_step_increment(0.001) + init_constraint(constraint::minimum(1e-6)) + init_units(typeid(k3d::measurement::distance))),
+			m_maximum_segments(init_owner(*this) + init_name(_("maximum_segments")) + init_label(_("Maximum Segments")) + init_description(_("Maximum number of segments per knot interval, when sampling adaptively")) + init_value(64) + init_step_increment(1) + init_constraint(constraint::minimum(1)) + init_units(typeid(k3d::measurement::scalar)))
 	{
 		m_mesh_selection.changed_signal().connect(make_update_mesh_slot());
 		m_u_samples.changed_signal().connect(make_update_mesh_slot());
 		m_v_samples.changed_signal().connect(make_update_mesh_slot());
 		m_delete_orig.changed_signal().connect(make_update_mesh_slot());
+		m_adaptive.changed_signal().connect(make_update_mesh_slot());
+		m_tolerance.changed_signal().connect(make_update_mesh_slot());
+		m_maximum_segments.changed_signal().connect(make_update_mesh_slot());
 	}
 
 	void on_create_mesh(const k3d::mesh& Input, k3d::mesh& Output)
@@ -83,6 +147,9 @@ public:
 
 		const k3d::uint_t u_samples = m_u_samples.pipeline_value();
 		const k3d::uint_t v_samples = m_v_samples.pipeline_value();
+		const k3d::bool_t adaptive = m_adaptive.pipeline_value();
+		const k3d::double_t tolerance = m_tolerance.pipeline_value();
+		const k3d::uint_t maximum_segments = m_maximum_segments.pipeline_value();
 
 		const k3d::uint_t prim_count = temp.primitives.size();
 		for(k3d::uint_t prim_idx = 0; prim_idx != prim_count; ++prim_idx)
@@ -91,18 +158,33 @@ public:
 			if(patches)
 			{
 				boost::scoped_ptr<k3d::nurbs_patch::primitive> output_patches(k3d::nurbs_patch::create(Output));
-				k3d::mesh::points_t vertices;
-				k3d::mesh::counts_t vertex_counts;
-				k3d::mesh::indices_t vertex_indices;
+				k3d::mesh::indices_t selected_patches;
 				for(k3d::uint_t patch = 0; patch != patches->patch_first_points.size(); ++patch)
 				{
 					// Copy existing patches, if required
 					if(!patches->patch_selections[patch] || !m_delete_orig.pipeline_value())
 						copy_patch(Output, *output_patches, temp, *patches, patch);
 					if(patches->patch_selections[patch])
-					{
-						polygonize(vertices, vertex_counts, vertex_indices, temp, *patches, patch, u_samples, v_samples);
-					}
+						selected_patches.push_back(patch);
+				}
+
+				// Patches are independent, so each one is polygonized as a separate work item ...
+				std::vector<detail::tessellation> tessellations(selected_patches.size());
+				k3d::parallel::parallel_for(
+					k3d::parallel::blocked_range<k3d::uint_t>(0, selected_patches.size(), 1),
+					detail::polygonize_patches(temp, *patches, selected_patches, adaptive, u_samples, v_samples, tolerance, maximum_segments, tessellations));
+
+				k3d::mesh::points_t vertices;
+				k3d::mesh::counts_t vertex_counts;
+				k3d::mesh::indices_t vertex_indices;
+				for(k3d::uint_t i = 0; i != tessellations.size(); ++i)
+				{
+					const detail::tessellation& tessellation = tessellations[i];
+					const k3d::uint_t first_vertex = vertices.size();
+					vertices.insert(vertices.end(), tessellation.vertices.begin(), tessellation.vertices.end());
+					vertex_counts.insert(vertex_counts.end(), tessellation.vertex_counts.begin(), tessellation.vertex_counts.end());
+					for(k3d::uint_t j = 0; j != tessellation.vertex_indices.size(); ++j)
+						vertex_indices.push_back(first_vertex + tessellation.vertex_indices[j]);
 				}
 				if(!vertices.empty())
 				{
@@ -138,6 +220,9 @@ private:
 	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, writable_property, with_serialization) m_u_samples;
 	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, writable_property, with_serialization) m_v_samples;
 	k3d_data(k3d::bool_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_delete_orig;
+	k3d_data(k3d::bool_t, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_adaptive;
+	k3d_data(k3d::double_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_tolerance;
+	k3d_data(k3d::int32_t, immutable_name, change_signal, with_undo, local_storage, with_constraint, measurement_property, with_serialization) m_maximum_segments;
 };
 
 k3d::iplugin_factory& polygonize_patch_factory()
@@ -25,12 +25,15 @@
 
 #include <k3d-i18n-config.h>
 #include <k3dsdk/document_plugin_factory.h>
-#include <k3dsdk/fstream.h>
+#include <k3dsdk/mapped_file.h>
 #include <k3dsdk/material_sink.h>
 #include <k3dsdk/mesh_reader.h>
 #include <k3dsdk/node.h>
 #include <k3dsdk/nurbs_patch.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
 #include <k3dsdk/polyhedron.h>
+#include <k3dsdk/text_parsing.h>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -43,6 +46,273 @@ namespace obj
 namespace io
 {
 
+namespace detail
+{
+
+/// Stores the points and polygons parsed from one chunk of an OBJ file
+class polygon_chunk
+{
+public:
+	polygon_chunk() :
+		valid(true)
+	{
+	}
+
+	k3d::mesh::points_t points;
+	k3d::mesh::counts_t face_counts;
+	/// Stores zero-based point indices for the whole file (relative indices are stored as zero until they're resolved)
+	k3d::mesh::indices_t face_points;
+	/// Stores the position in face_points and the chunk-relative point index of each relative (negative) point reference
+	std::vector<std::pair<k3d::uint_t, k3d::int64_t> > relative_points;
+	/// Set to false if the chunk contains anything other than points and polygons
+	k3d::bool_t valid;
+};
+
+typedef std::vector<polygon_chunk> polygon_chunks;
+
+/// Parses chunks of an OBJ file that contain only points and polygons, marking chunks that contain anything else as invalid
+class parse_polygon_chunks
+{
+public:
+	parse_polygon_chunks(const std::vector<const char*>& Boundaries, polygon_chunks& Chunks) :
+		boundaries(Boundaries),
+		chunks(Chunks)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t chunk_begin = range.begin();
+		const k3d::uint_t chunk_end = range.end();
+		for(k3d::uint_t chunk = chunk_begin; chunk != chunk_end; ++chunk)
+			chunks[chunk].valid = parse(boundaries[chunk], boundaries[chunk + 1], chunks[chunk]);
+	}
+
+private:
+	static const k3d::bool_t parse(const char* const Begin, const char* const End, polygon_chunk& Chunk)
+	{
+		for(const char* line = Begin; line != End; )
+		{
+			const char* const line_end = k3d::text::line_end(line, End);
+			const char* c = k3d::text::skip_blanks(line, line_end);
+
+			line = line_end;
+			if(line != End && *line == '\r')
+				++line;
+			if(line != End && *line == '\n')
+				++line;
+
+			if(c == line_end || *c == '#')
+				continue;
+
+			const char* const keyword_begin = c;
+			const char* const keyword_end = c = k3d::text::token_end(c, line_end);
+
+			if(k3d::text::equal(keyword_begin, keyword_end, "v"))
+			{
+				k3d::point3 v(0, 0, 0);
+				k3d::text::parse(c, line_end, v[0]) && k3d::text::parse(c, line_end, v[1]) && k3d::text::parse(c, line_end, v[2]);
+				Chunk.points.push_back(v);
+			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "f"))
+			{
+				k3d::uint_t count = 0;
+				k3d::uint_t texture_count = 0;
+				k3d::uint_t normal_count = 0;
+				k3d::int64_t vertex, texture, normal;
+				while(parse_vertex_reference(c, line_end, vertex, texture, normal))
+				{
+					++count;
+					if(texture)
+						++texture_count;
+					if(normal)
+						++normal_count;
+
+					if(vertex > 0)
+					{
+						Chunk.face_points.push_back(vertex - 1);
+					}
+					else if(vertex < 0)
+					{
+						Chunk.relative_points.push_back(std::make_pair(Chunk.face_points.size(), static_cast<k3d::int64_t>(Chunk.points.size()) + vertex));
+						Chunk.face_points.push_back(0);
+					}
+					else
+					{
+						return false;
+					}
+				}
+
+				// Leave anything unusual for the sequential parser to report ...
+				if(count < 3 || (texture_count && texture_count != count) || (normal_count && normal_count != count) || k3d::text::skip_blanks(c, line_end) != line_end)
+					return false;
+
+				Chunk.face_counts.push_back(count);
+			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "vt")
+				|| k3d::text::equal(keyword_begin, keyword_end, "vn")
+				|| k3d::text::equal(keyword_begin, keyword_end, "g")
+				|| k3d::text::equal(keyword_begin, keyword_end, "l")
+				|| k3d::text::equal(keyword_begin, keyword_end, "o")
+				|| k3d::text::equal(keyword_begin, keyword_end, "p")
+				|| k3d::text::equal(keyword_begin, keyword_end, "s")
+				|| k3d::text::equal(keyword_begin, keyword_end, "usemtl")
+				|| k3d::text::equal(keyword_begin, keyword_end, "mtllib"))
+			{
+				// These don't affect the points or polygons that we create ...
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	const std::vector<const char*>& boundaries;
+	polygon_chunks& chunks;
+};
+
+/// Copies the points and polygons from each chunk into their final positions in the output arrays
+class copy_polygon_chunks
+{
+public:
+	copy_polygon_chunks(const polygon_chunks& Chunks, const k3d::mesh::indices_t& PointOffsets, const k3d::mesh::indices_t& FaceOffsets, const k3d::mesh::indices_t& EdgeOffsets, k3d::mesh::points_t& Points, k3d::polyhedron::primitive* const Polyhedron) :
+		chunks(Chunks),
+		point_offsets(PointOffsets),
+		face_offsets(FaceOffsets),
+		edge_offsets(EdgeOffsets),
+		points(Points),
+		polyhedron(Polyhedron)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t chunk_begin = range.begin();
+		const k3d::uint_t chunk_end = range.end();
+		for(k3d::uint_t chunk = chunk_begin; chunk != chunk_end; ++chunk)
+		{
+			const polygon_chunk& source = chunks[chunk];
+			std::copy(source.points.begin(), source.points.end(), points.begin() + point_offsets[chunk]);
+
+			if(!polyhedron)
+				continue;
+
+			std::copy(source.face_points.begin(), source.face_points.end(), polyhedron->vertex_points.begin() + edge_offsets[chunk]);
+			for(k3d::uint_t i = 0; i != source.relative_points.size(); ++i)
+				polyhedron->vertex_points[edge_offsets[chunk] + source.relative_points[i].first] = point_offsets[chunk] + source.relative_points[i].second;
+
+			k3d::uint_t edge = edge_offsets[chunk];
+			const k3d::uint_t face_begin = 0;
+			const k3d::uint_t face_end = face_begin + source.face_counts.size();
+			for(k3d::uint_t face = face_begin; face != face_end; ++face)
+			{
+				const k3d::uint_t global_face = face_offsets[chunk] + face;
+				polyhedron->face_first_loops[global_face] = global_face;
+				polyhedron->loop_first_edges[global_face] = edge;
+
+				const k3d::uint_t first_edge = edge;
+				const k3d::uint_t last_edge = first_edge + source.face_counts[face] - 1;
+				for(; edge != last_edge; ++edge)
+					polyhedron->clockwise_edges[edge] = edge + 1;
+				polyhedron->clockwise_edges[edge++] = first_edge;
+			}
+		}
+	}
+
+private:
+	const polygon_chunks& chunks;
+	const k3d::mesh::indices_t& point_offsets;
+	const k3d::mesh::indices_t& face_offsets;
+	const k3d::mesh::indices_t& edge_offsets;
+	k3d::mesh::points_t& points;
+	k3d::polyhedron::primitive* const polyhedron;
+};
+
+/// Loads files that contain only points and polygons (by far the most common case) by parsing chunks of the file in parallel.
+/// Returns false without modifying the mesh if the file contains anything else, so it can be parsed sequentially instead.
+const k3d::bool_t load_polygons(const char* const Begin, const char* const End, k3d::imaterial* const Material, k3d::mesh& Mesh)
+{
+	std::vector<const char*> boundaries;
+	k3d::text::split_lines(Begin, End, k3d::text::chunk_count(End - Begin), boundaries);
+
+	const k3d::uint_t chunk_count = boundaries.size() - 1;
+	polygon_chunks chunks(chunk_count);
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, chunk_count, 1),
+		parse_polygon_chunks(boundaries, chunks));
+
+	k3d::mesh::indices_t point_offsets(chunk_count);
+	k3d::mesh::indices_t face_offsets(chunk_count);
+	k3d::mesh::indices_t edge_offsets(chunk_count);
+	k3d::uint_t point_count = 0;
+	k3d::uint_t face_count = 0;
+	k3d::uint_t edge_count = 0;
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		if(!chunks[chunk].valid)
+			return false;
+
+		point_offsets[chunk] = point_count;
+		face_offsets[chunk] = face_count;
+		edge_offsets[chunk] = edge_count;
+		point_count += chunks[chunk].points.size();
+		face_count += chunks[chunk].face_counts.size();
+		edge_count += chunks[chunk].face_points.size();
+	}
+
+	// Leave faces without points for the sequential parser to report ...
+	if(face_count && !point_count)
+		return false;
+
+	// Relative point references can point into earlier chunks, but not before the start of the file ...
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		for(k3d::uint_t i = 0; i != chunks[chunk].relative_points.size(); ++i)
+		{
+			if(static_cast<k3d::int64_t>(point_offsets[chunk]) + chunks[chunk].relative_points[i].second < 0)
+				return false;
+		}
+	}
+
+	k3d::mesh::points_t* points = 0;
+	if(point_count)
+	{
+		points = &Mesh.points.create(new k3d::mesh::points_t(point_count));
+		Mesh.point_selection.create(new k3d::mesh::selection_t(point_count, 0.0));
+	}
+
+	boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron;
+	if(face_count)
+	{
+		polyhedron.reset(k3d::polyhedron::create(Mesh));
+		polyhedron->shell_types.push_back(k3d::polyhedron::POLYGONS);
+		polyhedron->face_shells.assign(face_count, 0);
+		polyhedron->face_first_loops.resize(face_count);
+		polyhedron->face_loop_counts.assign(face_count, 1);
+		polyhedron->face_selections.assign(face_count, 0.0);
+		polyhedron->face_materials.assign(face_count, Material);
+		polyhedron->loop_first_edges.resize(face_count);
+		polyhedron->clockwise_edges.resize(edge_count);
+		polyhedron->edge_selections.assign(edge_count, 0.0);
+		polyhedron->vertex_points.resize(edge_count);
+		polyhedron->vertex_selections.assign(edge_count, 0.0);
+	}
+
+	if(points)
+	{
+		k3d::parallel::parallel_for(
+			k3d::parallel::blocked_range<k3d::uint_t>(0, chunk_count, 1),
+			copy_polygon_chunks(chunks, point_offsets, face_offsets, edge_offsets, *points, polyhedron.get()));
+	}
+
+	return true;
+}
+
+} // namespace detail
+
 /////////////////////////////////////////////////////////////////////////////
 // mesh_reader
 
@@ -63,15 +333,19 @@ public:
 	{
 		Output = k3d::mesh();
 
-		k3d::filesystem::ifstream file(Path);
-		if(!file)
+		const k3d::mapped_file file(Path);
+		if(!file.is_open())
 		{
 			k3d::log() << error << k3d_file_reference << ": error opening [" << Path.native_console_string() << "]" << std::endl;
 			return;
 		}
 
+		if(detail::load_polygons(file.begin(), file.end(), m_material.pipeline_value(), Output))
+			return;
+
+		Output = k3d::mesh();
 		my_parser parser(Output, m_material.pipeline_value());
-		parser.parse(file);
+		parser.parse(file.begin(), file.end());
 	}
 
 	static k3d::iplugin_factory& get_factory()
@@ -28,6 +28,7 @@
 #include <k3dsdk/algebra.h>
 #include <k3dsdk/file_helpers.h>
 #include <k3dsdk/log.h>
+#include <k3dsdk/text_parsing.h>
 #include <k3dsdk/texture3.h>
 
 #include <iostream>
@@ -47,7 +48,7 @@ namespace detail
 {
 
 /// Converts one-based indices and negative indices to zero-based indices
-k3d::uint_t zero_based_index(const int Index, const k3d::uint_t& CurrentCount)
+k3d::uint_t zero_based_index(const k3d::int64_t Index, const k3d::uint_t& CurrentCount)
 {
 	if(Index > 0)
 		return Index - 1;
@@ -59,75 +60,75 @@ k3d::uint_t zero_based_index(const int Index, const k3d::uint_t& CurrentCount)
 	return 0;
 }
 
-void read_vertices(std::istream& Stream, k3d::mesh::indices_t& VertexCoordinates, const k3d::uint_t& VertexCount)
+void read_vertices(const char* Current, const char* const End, k3d::mesh::indices_t& VertexCoordinates, k3d::mesh::indices_t& TextureCoordinates, k3d::mesh::indices_t& NormalCoordinates, const k3d::uint_t& VertexCount, const k3d::uint_t& TextureCount, const k3d::uint_t& NormalCount)
 {
-	int vertex_coordinate;
-	for(Stream >> vertex_coordinate; Stream; Stream >> vertex_coordinate)
-		VertexCoordinates.push_back(zero_based_index(vertex_coordinate, VertexCount));
-}
-
-void read_vertices(std::istream& Stream, k3d::mesh::indices_t& VertexCoordinates, k3d::mesh::indices_t& TextureCoordinates, const k3d::uint_t& VertexCount, const k3d::uint_t& TextureCount)
-{
-	int vertex_coordinate;
-	for(Stream >> vertex_coordinate; Stream; Stream >> vertex_coordinate)
+	k3d::int64_t vertex_coordinate, texture_coordinate, normal_coordinate;
+	while(parse_vertex_reference(Current, End, vertex_coordinate, texture_coordinate, normal_coordinate))
 	{
 		VertexCoordinates.push_back(zero_based_index(vertex_coordinate, VertexCount));
-		if(Stream.peek() == '/')
-		{
-			char separator;
-			int texture_coordinate;
-			Stream >> separator >> texture_coordinate;
-			if(Stream)
-				TextureCoordinates.push_back(zero_based_index(texture_coordinate, TextureCount));
-		}
+		if(texture_coordinate)
+			TextureCoordinates.push_back(zero_based_index(texture_coordinate, TextureCount));
+		if(normal_coordinate)
+			NormalCoordinates.push_back(zero_based_index(normal_coordinate, NormalCount));
 	}
 
 	// Sanity check - the number of texture coordinates must equal the number of vertices if nonzero
 	if(TextureCoordinates.size() && TextureCoordinates.size() != VertexCoordinates.size())
 		throw std::runtime_error("inconsistent use of texture coordinates");
+
+	// Sanity check - the number of normal coordinates must equal the number of vertices if nonzero
+	if(NormalCoordinates.size() && NormalCoordinates.size() != VertexCoordinates.size())
+		throw std::runtime_error("inconsistent use of normal coordinates");
 }
 
-void read_vertices(std::istream& Stream, k3d::mesh::indices_t& VertexCoordinates, k3d::mesh::indices_t& TextureCoordinates, k3d::mesh::indices_t& NormalCoordinates, const k3d::uint_t& VertexCount, const k3d::uint_t& TextureCount, const k3d::uint_t& NormalCount)
+/// Extracts the next whitespace-delimited token from a line
+const k3d::string_t read_token(const char*& Current, const char* const End)
 {
-	int vertex_coordinate;
-	for(Stream >> vertex_coordinate; Stream; Stream >> vertex_coordinate)
+	const char* const begin = k3d::text::skip_blanks(Current, End);
+	Current = k3d::text::token_end(begin, End);
+	return k3d::string_t(begin, Current);
+}
+
+} // namespace detail
+
+//////////////////////////////////////////////////////////////////////////////////////////
+// parse_vertex_reference
+
+const k3d::bool_t parse_vertex_reference(const char*& Current, const char* const End, k3d::int64_t& Vertex, k3d::int64_t& Texture, k3d::int64_t& Normal)
+{
+	const char* c = Current;
+	if(!k3d::text::parse(c, End, Vertex))
+		return false;
+
+	Texture = 0;
+	Normal = 0;
+	if(c != End && *c == '/')
 	{
-		VertexCoordinates.push_back(zero_based_index(vertex_coordinate, VertexCount));
-		if(Stream.peek() == '/')
+		++c;
+		if(c != End && *c != '/')
+			k3d::text::parse(c, End, Texture);
+
+		if(c != End && *c == '/')
 		{
-			char separator;
-			int texture_coordinate;
-			Stream >> separator >> texture_coordinate;
-			if(Stream)
-			{
-				TextureCoordinates.push_back(zero_based_index(texture_coordinate, TextureCount));
-				if(Stream.peek() == '/')
-				{
-					char separator;
-					int normal_coordinate;
-					Stream >> separator >> normal_coordinate;
-					if(Stream)
-						NormalCoordinates.push_back(zero_based_index(normal_coordinate, NormalCount));
-				}
-			}
+			++c;
+			k3d::text::parse(c, End, Normal);
 		}
 	}
 
-	// Sanity check - the number of texture coordinates must equal the number of vertices if nonzero
-	if(TextureCoordinates.size() && TextureCoordinates.size() != VertexCoordinates.size())
-		throw std::runtime_error("inconsistent use of texture coordinates");
-
-	// Sanity check - the number of normal coordinates must equal the number of vertices if nonzero
-	if(NormalCoordinates.size() && NormalCoordinates.size() != VertexCoordinates.size())
-		throw std::runtime_error("inconsistent use of normal coordinates");
+	Current = c;
+	return true;
 }
 
-} // namespace detail
-
 //////////////////////////////////////////////////////////////////////////////////////////
 // obj_parser
 
 void obj_parser::parse(std::istream& Stream)
+{
+	const k3d::string_t buffer((std::istreambuf_iterator<char>(Stream)), std::istreambuf_iterator<char>());
+	parse(buffer.data(), buffer.data() + buffer.size());
+}
+
+void obj_parser::parse(const char* const Begin, const char* const End)
 {
 	k3d::uint_t line_count = 0; // Track the number of lines parsed
 	k3d::uint_t v_count = 0; // Track the number of vertex coordinates parsed
@@ -136,152 +137,147 @@ void obj_parser::parse(std::istream& Stream)
 
 	try
 	{
-		k3d::string_t line_buffer;
-		for(k3d::getline(Stream, line_buffer); Stream; k3d::getline(Stream, line_buffer))
+		// Handle Posix, DOS, and Mac linebreaks ...
+		for(const char* line = Begin; line != End; )
 		{
+			const char* const line_end = k3d::text::line_end(line, End);
+			const char* c = k3d::text::skip_blanks(line, line_end);
+
+			line = line_end;
+			if(line != End && *line == '\r')
+				++line;
+			if(line != End && *line == '\n')
+				++line;
+
 			++line_count;
 
 			// Skip blank lines ...
-			if(line_buffer.empty())
+			if(c == line_end)
 				continue;
 
 			// Skip comments ...
-			if(line_buffer[0] == '#')
+			if(*c == '#')
 				continue;
 
 			// Start looking for keywords ...
-			k3d::string_t keyword;
-			std::istringstream line_stream(line_buffer);
-			line_stream >> keyword;
+			const char* const keyword_begin = c;
+			const char* const keyword_end = c = k3d::text::token_end(c, line_end);
 
-			if(keyword == "cstype")
+			if(k3d::text::equal(keyword_begin, keyword_end, "v"))
 			{
-				k3d::string_t type;
-				line_stream >> type;
+				++v_count;
+
+				k3d::point4 v(0, 0, 0, 1);
+				k3d::text::parse(c, line_end, v[0]) && k3d::text::parse(c, line_end, v[1]) && k3d::text::parse(c, line_end, v[2]) && k3d::text::parse(c, line_end, v[3]);
 
-				on_curve_surface_type(type);
+				on_vertex_coordinates(v);
 			}
-			else if(keyword == "deg")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "f"))
 			{
-				k3d::uint_t u_degree = 0;
-				k3d::uint_t v_degree = 0;
-				line_stream >> u_degree >> v_degree;
+				face_vertex_coordinates.clear();
+				face_texture_coordinates.clear();
+				face_normal_coordinates.clear();
+				detail::read_vertices(c, line_end, face_vertex_coordinates, face_texture_coordinates, face_normal_coordinates, v_count, vt_count, vn_count);
+			
+				if(face_vertex_coordinates.size() < 3)
+					throw std::runtime_error("face contains less than three vertices");
 
-				on_degree(u_degree, v_degree);
+				on_face(face_vertex_coordinates, face_texture_coordinates, face_normal_coordinates);
 			}
-			else if(keyword == "end")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "vn"))
 			{
-				on_curve_surface_end();
+				++vn_count;
+
+				k3d::normal3 vn(0, 0, 0);
+				k3d::text::parse(c, line_end, vn[0]) && k3d::text::parse(c, line_end, vn[1]) && k3d::text::parse(c, line_end, vn[2]);
+
+				on_normal_coordinates(vn);
 			}
-			else if(keyword == "f")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "vt"))
 			{
-				k3d::mesh::indices_t vertex_coordinates;
-				k3d::mesh::indices_t texture_coordinates;
-				k3d::mesh::indices_t normal_coordinates; 
-				detail::read_vertices(line_stream, vertex_coordinates, texture_coordinates, normal_coordinates, v_count, vt_count, vn_count);
-			
-				if(vertex_coordinates.size() < 3)
-					throw std::runtime_error("face contains less than three vertices");
+				++vt_count;
 
-				on_face(vertex_coordinates, texture_coordinates, normal_coordinates);
+				k3d::texture3 vt(0, 0, 0);
+				k3d::text::parse(c, line_end, vt[0]) && k3d::text::parse(c, line_end, vt[1]) && k3d::text::parse(c, line_end, vt[2]);
+
+				on_texture_coordinates(vt);
 			}
-			else if(keyword == "g")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "cstype"))
 			{
-				k3d::string_t name;
-				line_stream >> name;
+				on_curve_surface_type(detail::read_token(c, line_end));
+			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "deg"))
+			{
+				k3d::uint64_t u_degree = 0;
+				k3d::uint64_t v_degree = 0;
+				k3d::text::parse(c, line_end, u_degree) && k3d::text::parse(c, line_end, v_degree);
 
-				on_group(name);
+				on_degree(u_degree, v_degree);
+			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "end"))
+			{
+				on_curve_surface_end();
 			}
-			else if(keyword == "l")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "g"))
+			{
+				on_group(detail::read_token(c, line_end));
+			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "l"))
 			{
 				k3d::mesh::indices_t vertex_coordinates;
 				k3d::mesh::indices_t texture_coordinates;
-				detail::read_vertices(line_stream, vertex_coordinates, texture_coordinates, v_count, vt_count);
+				k3d::mesh::indices_t normal_coordinates;
+				detail::read_vertices(c, line_end, vertex_coordinates, texture_coordinates, normal_coordinates, v_count, vt_count, vn_count);
 
 				on_line(vertex_coordinates, texture_coordinates);
 			}
-			else if(keyword == "mtllib")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "mtllib"))
 			{
-				k3d::string_t name;
-				line_stream >> name;
-
-				on_material_library(name);
+				on_material_library(detail::read_token(c, line_end));
 			}
-			else if(keyword == "o")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "o"))
 			{
-				k3d::string_t name;
-				line_stream >> name;
-
-				on_object(name);
+				on_object(detail::read_token(c, line_end));
 			}
-			else if(keyword == "p")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "p"))
 			{
 				k3d::mesh::indices_t vertex_coordinates;
-				detail::read_vertices(line_stream, vertex_coordinates, v_count);
+				k3d::mesh::indices_t texture_coordinates;
+				k3d::mesh::indices_t normal_coordinates;
+				detail::read_vertices(c, line_end, vertex_coordinates, texture_coordinates, normal_coordinates, v_count, vt_count, vn_count);
 
 				on_points(vertex_coordinates);
 			}
-			else if(keyword == "parm")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "parm"))
 			{
-				k3d::string_t direction;
-				line_stream >> direction;
+				const k3d::string_t direction = detail::read_token(c, line_end);
 
 				k3d::double_t knot;
 				k3d::mesh::knots_t knots;
-				for(line_stream >> knot; line_stream; line_stream >> knot)
+				while(k3d::text::parse(c, line_end, knot))
 					knots.push_back(knot);
 
 				on_parameter(direction, knots);
 			}
-			else if(keyword == "surf")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "surf"))
 			{
-				k3d::double_t s0, s1, t0, t1;
-				line_stream >> s0 >> s1 >> t0 >> t1;
+				k3d::double_t s0 = 0, s1 = 0, t0 = 0, t1 = 0;
+				k3d::text::parse(c, line_end, s0) && k3d::text::parse(c, line_end, s1) && k3d::text::parse(c, line_end, t0) && k3d::text::parse(c, line_end, t1);
 
 				k3d::mesh::indices_t vertex_coordinates;
 				k3d::mesh::indices_t texture_coordinates;
 				k3d::mesh::indices_t normal_coordinates; 
-				detail::read_vertices(line_stream, vertex_coordinates, texture_coordinates, normal_coordinates, v_count, vt_count, vn_count);
+				detail::read_vertices(c, line_end, vertex_coordinates, texture_coordinates, normal_coordinates, v_count, vt_count, vn_count);
 
 				on_surface(s0, s1, t0, t1, vertex_coordinates, texture_coordinates, normal_coordinates);
 			}
-			else if(keyword == "usemtl")
+			else if(k3d::text::equal(keyword_begin, keyword_end, "usemtl"))
 			{
-				k3d::string_t name;
-				line_stream >> name;
-
-				on_use_material(name);
-			}
-			else if(keyword == "v")
-			{
-				++v_count;
-
-				k3d::point4 v(0, 0, 0, 1);
-				line_stream >> v[0] >> v[1] >> v[2] >> v[3];
-
-				on_vertex_coordinates(v);
-			}
-			else if(keyword == "vn")
-			{
-				++vn_count;
-
-				k3d::normal3 vn(0, 0, 0);
-				line_stream >> vn[0] >> vn[1] >> vn[2];
-
-				on_normal_coordinates(vn);
-			}
-			else if(keyword == "vt")
-			{
-				++vt_count;
-
-				k3d::texture3 vt(0, 0, 0);
-				line_stream >> vt[0] >> vt[1] >> vt[2];
-
-				on_texture_coordinates(vt);
+				on_use_material(detail::read_token(c, line_end));
 			}
 			else
 			{
-				k3d::log() << error << "unsupported keyword [" << keyword << "] at line " << line_count << " will be ignored" << std::endl;
+				k3d::log() << error << "unsupported keyword [" << k3d::string_t(keyword_begin, keyword_end) << "] at line " << line_count << " will be ignored" << std::endl;
 			}
 		}
 	}
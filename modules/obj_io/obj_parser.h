@@ -42,14 +42,26 @@ namespace obj
 namespace io
 {
 
+/// Parses a face vertex reference of the form "v", "v/t", "v//n", or "v/t/n" at Current, skipping leading blanks.  On success, advances
+/// Current past the reference and returns the indices as stored in the file (one-based, or negative for relative indices), with zero
+/// for missing texture or normal indices.
+const k3d::bool_t parse_vertex_reference(const char*& Current, const char* const End, k3d::int64_t& Vertex, k3d::int64_t& Texture, k3d::int64_t& Normal);
+
 /// Template design pattern class for parsing Wavefront (.obj) files
 class obj_parser
 {
 public:
 	/// Parse an input stream as an OBJ file, executing events based on the file contents
 	void parse(std::istream& Stream);
+	/// Parse an in-memory buffer as an OBJ file, executing events based on the file contents
+	void parse(const char* const Begin, const char* const End);
 
 private:
+	/// Storage for face indices, reused between faces to avoid allocations
+	k3d::mesh::indices_t face_vertex_coordinates;
+	k3d::mesh::indices_t face_texture_coordinates;
+	k3d::mesh::indices_t face_normal_coordinates;
+
 	/// @{
 	/// @name Override these methods in a derived class to handle the given parsing events
 
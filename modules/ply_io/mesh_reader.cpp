@@ -22,17 +22,25 @@
 */
 
 #include <k3d-i18n-config.h>
-#include <k3dsdk/data.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/file_helpers.h>
-#include <k3dsdk/fstream.h>
+#include <k3dsdk/mapped_file.h>
 #include <k3dsdk/material_sink.h>
 #include <k3dsdk/mesh_reader.h>
 #include <k3dsdk/node.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
 #include <k3dsdk/polyhedron.h>
+#include <k3dsdk/text_parsing.h>
 
+#include <boost/lexical_cast.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
 namespace module
 {
 
@@ -42,156 +50,718 @@ namespace ply
 namespace io
 {
 
-/////////////////////////////////////////////////////////////////////////////
-// mesh_reader
+namespace detail
+{
 
-class mesh_reader :
-	public k3d::material_sink<k3d::mesh_reader<k3d::node > >
+/// Enumerates the scalar types that can be stored in a PLY file
+enum scalar_type
 {
-	typedef k3d::material_sink<k3d::mesh_reader<k3d::node > > base;
+	NONE,
+	INT8,
+	UINT8,
+	INT16,
+	UINT16,
+	INT32,
+	UINT32,
+	FLOAT32,
+	FLOAT64
+};
 
-public:
-	mesh_reader(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
-		base(Factory, Document)
+/// Converts a PLY type name (using either the original or the sized names) into a scalar_type
+const scalar_type parse_scalar_type(const k3d::string_t& Type)
+{
+	if(Type == "char" || Type == "int8")
+		return INT8;
+	if(Type == "uchar" || Type == "uint8")
+		return UINT8;
+	if(Type == "short" || Type == "int16")
+		return INT16;
+	if(Type == "ushort" || Type == "uint16")
+		return UINT16;
+	if(Type == "int" || Type == "int32")
+		return INT32;
+	if(Type == "uint" || Type == "uint32")
+		return UINT32;
+	if(Type == "float" || Type == "float32")
+		return FLOAT32;
+	if(Type == "double" || Type == "float64")
+		return FLOAT64;
+
+	throw std::runtime_error("unknown property type [" + Type + "]");
+}
+
+/// Returns the size in bytes of a scalar_type in a binary file
+const k3d::uint_t scalar_size(const scalar_type Type)
+{
+	switch(Type)
 	{
+		case INT8:
+		case UINT8:
+			return 1;
+		case INT16:
+		case UINT16:
+			return 2;
+		case INT32:
+		case UINT32:
+		case FLOAT32:
+			return 4;
+		case FLOAT64:
+			return 8;
+		case NONE:
+			break;
 	}
 
-	void on_load_mesh(const k3d::filesystem::path& Path, k3d::mesh& Output)
+	return 0;
+}
+
+/// Describes one property of a PLY element
+struct property
+{
+	k3d::string_t name;
+	scalar_type type;
+	/// Stores the type of the item count for list properties, or NONE for scalar properties
+	scalar_type count_type;
+};
+
+/// Describes one element of a PLY file
+struct element
+{
+	k3d::string_t name;
+	k3d::uint_t count;
+	std::vector<property> properties;
+
+	/// Returns the index of the given property, or properties.size() if it doesn't exist
+	const k3d::uint_t find_property(const k3d::string_t& Name) const
 	{
-		k3d::filesystem::ifstream file(Path);
-		if(!file)
-			return;
+		for(k3d::uint_t i = 0; i != properties.size(); ++i)
+		{
+			if(properties[i].name == Name)
+				return i;
+		}
+		return properties.size();
+	}
 
-		k3d::string_t magic_number;
-		k3d::getline(file, magic_number);
-		if(magic_number != "ply")
+	/// Returns the size in bytes of one element in a binary file, or zero if the element contains lists (and varies in size)
+	const k3d::uint_t binary_size() const
+	{
+		k3d::uint_t result = 0;
+		for(k3d::uint_t i = 0; i != properties.size(); ++i)
 		{
-			k3d::log() << error << "Not a Stanford PLY file: " << Path.native_console_string() << std::endl;
-			return;
+			if(properties[i].count_type != NONE)
+				return 0;
+			result += scalar_size(properties[i].type);
 		}
+		return result;
+	}
+};
+
+typedef std::vector<element> elements_t;
+
+/// Enumerates the possible PLY storage formats
+enum file_format
+{
+	ASCII,
+	BINARY_LITTLE_ENDIAN,
+	BINARY_BIG_ENDIAN
+};
 
-		k3d::string_t format;
-		k3d::getline(file, format);
-		if(format != "format ascii 1.0")
+/// Parses a PLY header, returning the start of the element data
+const char* parse_header(const char* const Begin, const char* const End, file_format& Format, elements_t& Elements)
+{
+	k3d::bool_t has_magic_number = false;
+	k3d::bool_t has_format = false;
+	for(const char* line = Begin; line != End; )
+	{
+		const char* const line_end = k3d::text::line_end(line, End);
+		const char* c = k3d::text::skip_blanks(line, line_end);
+		const char* const keyword_begin = c;
+		const char* const keyword_end = c = k3d::text::token_end(c, line_end);
+		line = k3d::text::next_line(line_end, End);
+
+		std::vector<k3d::string_t> tokens;
+		for(c = k3d::text::skip_blanks(c, line_end); c != line_end; c = k3d::text::skip_blanks(c, line_end))
 		{
-			k3d::log() << error << "Not an ascii format PLY file: " << Path.native_console_string() << std::endl;
-			return;
+			const char* const token_begin = c;
+			c = k3d::text::token_end(c, line_end);
+			tokens.push_back(k3d::string_t(token_begin, c));
 		}
 
-		std::vector<k3d::string_t> element_types;
-		std::vector<k3d::uint_t> element_counts;
-	
-		while(true)
+		if(!has_magic_number)
 		{
-			std::stringstream line_buffer;
-			k3d::getline(file, line_buffer);
-			if(!file)
-				break;
+			if(!k3d::text::equal(keyword_begin, keyword_end, "ply") || tokens.size())
+				throw std::runtime_error("not a Stanford PLY file");
 
-			k3d::string_t keyword;
-			line_buffer >> keyword;
+			has_magic_number = true;
+		}
+		else if(k3d::text::equal(keyword_begin, keyword_end, "format"))
+		{
+			if(tokens.size() != 2 || tokens[1] != "1.0")
+				throw std::runtime_error("unsupported format");
+
+			if(tokens[0] == "ascii")
+				Format = ASCII;
+			else if(tokens[0] == "binary_little_endian")
+				Format = BINARY_LITTLE_ENDIAN;
+			else if(tokens[0] == "binary_big_endian")
+				Format = BINARY_BIG_ENDIAN;
+			else
+				throw std::runtime_error("unsupported format [" + tokens[0] + "]");
+
+			has_format = true;
+		}
+		else if(k3d::text::equal(keyword_begin, keyword_end, "element"))
+		{
+			if(tokens.size() != 2)
+				throw std::runtime_error("invalid element declaration");
 
-			if(keyword == "comment")
+			element new_element;
+			new_element.name = tokens[0];
+			new_element.count = boost::lexical_cast<k3d::uint_t>(tokens[1]);
+			Elements.push_back(new_element);
+		}
+		else if(k3d::text::equal(keyword_begin, keyword_end, "property"))
+		{
+			if(Elements.empty())
+				throw std::runtime_error("property declared outside an element");
+
+			property new_property;
+			if(tokens.size() == 4 && tokens[0] == "list")
 			{
+				new_property.count_type = parse_scalar_type(tokens[1]);
+				new_property.type = parse_scalar_type(tokens[2]);
+				new_property.name = tokens[3];
 			}
-			else if(keyword == "element")
+			else if(tokens.size() == 2)
 			{
-				k3d::string_t element_type;
-				size_t element_count = 0;
-				line_buffer >> element_type >> element_count;
-
-				element_types.push_back(element_type);
-				element_counts.push_back(element_count);
+				new_property.count_type = NONE;
+				new_property.type = parse_scalar_type(tokens[0]);
+				new_property.name = tokens[1];
 			}
-			else if(keyword == "property")
+			else
 			{
+				throw std::runtime_error("invalid property declaration");
 			}
-			else if(keyword == "end_header")
+
+			Elements.back().properties.push_back(new_property);
+		}
+		else if(k3d::text::equal(keyword_begin, keyword_end, "end_header"))
+		{
+			if(!has_format)
+				throw std::runtime_error("missing format");
+
+			return line;
+		}
+		else if(k3d::text::equal(keyword_begin, keyword_end, "comment") || k3d::text::equal(keyword_begin, keyword_end, "obj_info"))
+		{
+		}
+		else
+		{
+			throw std::runtime_error("unknown header keyword [" + k3d::string_t(keyword_begin, keyword_end) + "]");
+		}
+	}
+
+	throw std::runtime_error("missing end_header");
+}
+
+/// Locates the properties that we load from the vertex and face elements
+class property_layout
+{
+public:
+	property_layout(const element& Vertex, const element* const Face)
+	{
+		x = Vertex.find_property("x");
+		y = Vertex.find_property("y");
+		z = Vertex.find_property("z");
+		if(x == Vertex.properties.size() || y == Vertex.properties.size() || z == Vertex.properties.size())
+			throw std::runtime_error("vertex element missing x, y, or z property");
+		if(Vertex.properties[x].count_type != NONE || Vertex.properties[y].count_type != NONE || Vertex.properties[z].count_type != NONE)
+			throw std::runtime_error("vertex x, y, and z properties must be scalars");
+
+		vertex_indices = 0;
+		if(Face)
+		{
+			vertex_indices = Face->find_property("vertex_indices");
+			if(vertex_indices == Face->properties.size())
+				vertex_indices = Face->find_property("vertex_index");
+			if(vertex_indices == Face->properties.size() || Face->properties[vertex_indices].count_type == NONE)
+				throw std::runtime_error("face element missing vertex_indices list property");
+		}
+	}
+
+	k3d::uint_t x;
+	k3d::uint_t y;
+	k3d::uint_t z;
+	k3d::uint_t vertex_indices;
+};
+
+/// Stores the polygons parsed from one chunk of an ASCII PLY file
+class face_chunk
+{
+public:
+	k3d::mesh::counts_t face_counts;
+	k3d::mesh::indices_t face_points;
+	k3d::string_t error;
+};
+
+typedef std::vector<face_chunk> face_chunks;
+
+/// Counts the lines in each chunk of an ASCII PLY file, so each chunk knows which elements it contains
+class count_chunk_lines
+{
+public:
+	count_chunk_lines(const std::vector<const char*>& Boundaries, std::vector<k3d::uint64_t>& LineCounts) :
+		boundaries(Boundaries),
+		line_counts(LineCounts)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t chunk_begin = range.begin();
+		const k3d::uint_t chunk_end = range.end();
+		for(k3d::uint_t chunk = chunk_begin; chunk != chunk_end; ++chunk)
+			line_counts[chunk] = k3d::text::count_lines(boundaries[chunk], boundaries[chunk + 1]);
+	}
+
+private:
+	const std::vector<const char*>& boundaries;
+	std::vector<k3d::uint64_t>& line_counts;
+};
+
+/// Parses chunks of an ASCII PLY file (one element per line), storing vertices directly into the output points and collecting faces in per-chunk storage
+class parse_ascii_chunks
+{
+public:
+	parse_ascii_chunks(const std::vector<const char*>& Boundaries, const std::vector<k3d::uint64_t>& FirstLines, const elements_t& Elements, const std::vector<k3d::uint64_t>& ElementFirstLines, const k3d::uint_t VertexElement, const k3d::uint_t FaceElement, const property_layout& Layout, k3d::mesh::points_t& Points, face_chunks& Faces) :
+		boundaries(Boundaries),
+		first_lines(FirstLines),
+		elements(Elements),
+		element_first_lines(ElementFirstLines),
+		vertex_element(VertexElement),
+		face_element(FaceElement),
+		layout(Layout),
+		points(Points),
+		faces(Faces)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t chunk_begin = range.begin();
+		const k3d::uint_t chunk_end = range.end();
+		for(k3d::uint_t chunk = chunk_begin; chunk != chunk_end; ++chunk)
+		{
+			try
 			{
-				break;
+				parse(chunk);
+			}
+			catch(std::exception& e)
+			{
+				faces[chunk].error = e.what();
 			}
 		}
+	}
 
-		for(k3d::uint_t i = 0; i != element_types.size(); ++i)
+private:
+	void parse(const k3d::uint_t Chunk) const
+	{
+		const char* const end = boundaries[Chunk + 1];
+		k3d::uint64_t line_number = first_lines[Chunk];
+		for(const char* line = boundaries[Chunk]; line != end; line = k3d::text::next_line(line, end), ++line_number)
 		{
-			const k3d::string_t element_type = element_types[i];
-			const k3d::uint_t element_count = element_counts[i];
-			
-			k3d::log() << info << "Reading " << element_count << " elements of type: " << element_type << std::endl;
+			// Identify the element stored on this line, skipping anything after the last element ...
+			const k3d::uint_t element_index = std::upper_bound(element_first_lines.begin(), element_first_lines.end(), line_number) - element_first_lines.begin() - 1;
+			if(element_index == elements.size())
+				return;
 
-			if(element_type == "vertex")
-			{
-				k3d::mesh::points_t& points = Output.points.create(new k3d::mesh::points_t(element_count));
-				k3d::mesh::selection_t& point_selection = Output.point_selection.create(new k3d::mesh::selection_t(element_count, 0.0));
+			if(element_index != vertex_element && element_index != face_element)
+				continue;
+
+			const element& current_element = elements[element_index];
+			const char* const line_end = k3d::text::line_end(line, end);
+			const char* c = line;
 
-				for(k3d::uint_t j = 0; j != element_count; ++j)
+			k3d::point3 point(0, 0, 0);
+			for(k3d::uint_t i = 0; i != current_element.properties.size(); ++i)
+			{
+				k3d::double_t value = 0;
+				if(current_element.properties[i].count_type == NONE)
 				{
-					std::stringstream line_buffer;
-					k3d::getline(file, line_buffer);
-					if(!file)
+					if(!k3d::text::parse(c, line_end, value))
+						throw std::runtime_error("error reading " + current_element.name + " property " + current_element.properties[i].name);
+
+					if(element_index == vertex_element)
 					{
-						k3d::log() << error << "Unexpected end-of-file: " << Path.native_console_string() << std::endl;
-						return;
+						if(i == layout.x)
+							point[0] = value;
+						else if(i == layout.y)
+							point[1] = value;
+						else if(i == layout.z)
+							point[2] = value;
 					}
 
-					k3d::point3 point;
-					line_buffer >> point[0] >> point[1] >> point[2];
-					
-					points[j] = point;
+					continue;
+				}
+
+				k3d::uint64_t count = 0;
+				if(!k3d::text::parse(c, line_end, count))
+					throw std::runtime_error("error reading " + current_element.name + " property " + current_element.properties[i].name);
+
+				const k3d::bool_t store = element_index == face_element && i == layout.vertex_indices;
+				if(store)
+					faces[Chunk].face_counts.push_back(count);
+
+				for(k3d::uint64_t j = 0; j != count; ++j)
+				{
+					if(!k3d::text::parse(c, line_end, value))
+						throw std::runtime_error("error reading " + current_element.name + " property " + current_element.properties[i].name);
+
+					if(store)
+						faces[Chunk].face_points.push_back(static_cast<k3d::uint_t>(value));
 				}
 			}
-			else if(element_type == "face")
+
+			if(element_index == vertex_element)
+				points[line_number - element_first_lines[element_index]] = point;
+		}
+	}
+
+	const std::vector<const char*>& boundaries;
+	const std::vector<k3d::uint64_t>& first_lines;
+	const elements_t& elements;
+	const std::vector<k3d::uint64_t>& element_first_lines;
+	const k3d::uint_t vertex_element;
+	const k3d::uint_t face_element;
+	const property_layout& layout;
+	k3d::mesh::points_t& points;
+	face_chunks& faces;
+};
+
+/// Loads the data from an ASCII PLY file, parsing chunks of the file in parallel
+void load_ascii(const char* const Begin, const char* const End, const elements_t& Elements, const k3d::uint_t VertexElement, const k3d::uint_t FaceElement, const property_layout& Layout, k3d::mesh::points_t& Points, k3d::mesh::counts_t& FaceCounts, k3d::mesh::indices_t& FacePoints)
+{
+	std::vector<const char*> boundaries;
+	k3d::text::split_lines(Begin, End, k3d::text::chunk_count(End - Begin), boundaries);
+	const k3d::uint_t chunk_count = boundaries.size() - 1;
+
+	// Number the lines in each chunk ...
+	std::vector<k3d::uint64_t> first_lines(chunk_count);
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, chunk_count, 1),
+		count_chunk_lines(boundaries, first_lines));
+
+	k3d::uint64_t line_count = 0;
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		const k3d::uint64_t chunk_line_count = first_lines[chunk];
+		first_lines[chunk] = line_count;
+		line_count += chunk_line_count;
+	}
+
+	std::vector<k3d::uint64_t> element_first_lines;
+	k3d::uint64_t element_line_count = 0;
+	for(k3d::uint_t i = 0; i != Elements.size(); ++i)
+	{
+		element_first_lines.push_back(element_line_count);
+		element_line_count += Elements[i].count;
+	}
+	element_first_lines.push_back(element_line_count);
+
+	if(line_count < element_line_count)
+		throw std::runtime_error("unexpected end-of-file");
+
+	face_chunks faces(chunk_count);
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, chunk_count, 1),
+		parse_ascii_chunks(boundaries, first_lines, Elements, element_first_lines, VertexElement, FaceElement, Layout, Points, faces));
+
+	k3d::uint_t face_count = 0;
+	k3d::uint_t face_point_count = 0;
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		if(!faces[chunk].error.empty())
+			throw std::runtime_error(faces[chunk].error);
+
+		face_count += faces[chunk].face_counts.size();
+		face_point_count += faces[chunk].face_points.size();
+	}
+
+	FaceCounts.reserve(face_count);
+	FacePoints.reserve(face_point_count);
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		FaceCounts.insert(FaceCounts.end(), faces[chunk].face_counts.begin(), faces[chunk].face_counts.end());
+		FacePoints.insert(FacePoints.end(), faces[chunk].face_points.begin(), faces[chunk].face_points.end());
+	}
+}
+
+/// Reads one binary value of the given type, converting it to double
+const k3d::double_t read_binary(const char* const Data, const scalar_type Type, const k3d::bool_t Swap)
+{
+	char buffer[8];
+	const k3d::uint_t size = scalar_size(Type);
+	if(Swap)
+		std::reverse_copy(Data, Data + size, buffer);
+	else
+		std::memcpy(buffer, Data, size);
+
+	switch(Type)
+	{
+		case INT8:
+		{
+			k3d::int8_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case UINT8:
+		{
+			k3d::uint8_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case INT16:
+		{
+			k3d::int16_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case UINT16:
+		{
+			k3d::uint16_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case INT32:
+		{
+			k3d::int32_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case UINT32:
+		{
+			k3d::uint32_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case FLOAT32:
+		{
+			k3d::float_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case FLOAT64:
+		{
+			k3d::double_t value;
+			std::memcpy(&value, buffer, sizeof(value));
+			return value;
+		}
+		case NONE:
+			break;
+	}
+
+	return 0;
+}
+
+/// Reads one binary value of the given type and advances past it, throwing an exception at the end of the data
+const k3d::double_t read_binary(const char*& Current, const char* const End, const scalar_type Type, const k3d::bool_t Swap)
+{
+	const k3d::uint_t size = scalar_size(Type);
+	if(static_cast<k3d::uint64_t>(End - Current) < size)
+		throw std::runtime_error("unexpected end-of-file");
+
+	const k3d::double_t result = read_binary(Current, Type, Swap);
+	Current += size;
+	return result;
+}
+
+/// Decodes vertices from a binary PLY file in parallel, for vertex elements that have a fixed size
+class decode_binary_points
+{
+public:
+	decode_binary_points(const char* const Data, const element& Vertex, const property_layout& Layout, const k3d::bool_t Swap, k3d::mesh::points_t& Points) :
+		data(Data),
+		stride(Vertex.binary_size()),
+		swap(Swap),
+		points(Points)
+	{
+		const k3d::uint_t properties[3] = { Layout.x, Layout.y, Layout.z };
+		for(k3d::uint_t i = 0; i != 3; ++i)
+		{
+			offsets[i] = 0;
+			for(k3d::uint_t j = 0; j != properties[i]; ++j)
+				offsets[i] += scalar_size(Vertex.properties[j].type);
+			types[i] = Vertex.properties[properties[i]].type;
+		}
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t point_begin = range.begin();
+		const k3d::uint_t point_end = range.end();
+		for(k3d::uint_t point = point_begin; point != point_end; ++point)
+		{
+			const char* const vertex = data + point * stride;
+			points[point] = k3d::point3(read_binary(vertex + offsets[0], types[0], swap), read_binary(vertex + offsets[1], types[1], swap), read_binary(vertex + offsets[2], types[2], swap));
+		}
+	}
+
+private:
+	const char* const data;
+	const k3d::uint_t stride;
+	const k3d::bool_t swap;
+	k3d::uint_t offsets[3];
+	scalar_type types[3];
+	k3d::mesh::points_t& points;
+};
+
+/// Loads the data from a binary PLY file.  Vertices with a fixed size are decoded in parallel, everything else sequentially.
+void load_binary(const char* const Begin, const char* const End, const k3d::bool_t Swap, const elements_t& Elements, const k3d::uint_t VertexElement, const k3d::uint_t FaceElement, const property_layout& Layout, k3d::mesh::points_t& Points, k3d::mesh::counts_t& FaceCounts, k3d::mesh::indices_t& FacePoints)
+{
+	const char* c = Begin;
+	for(k3d::uint_t element_index = 0; element_index != Elements.size(); ++element_index)
+	{
+		const element& current_element = Elements[element_index];
+		const k3d::uint_t stride = current_element.binary_size();
+
+		if(element_index == VertexElement && stride)
+		{
+			if(static_cast<k3d::uint64_t>(End - c) < static_cast<k3d::uint64_t>(current_element.count) * stride)
+				throw std::runtime_error("unexpected end-of-file");
+
+			k3d::parallel::parallel_for(
+				k3d::parallel::blocked_range<k3d::uint_t>(0, current_element.count, k3d::parallel::grain_size()),
+				decode_binary_points(c, current_element, Layout, Swap, Points));
+
+			c += current_element.count * stride;
+			continue;
+		}
+
+		if(element_index != VertexElement && element_index != FaceElement && stride)
+		{
+			if(static_cast<k3d::uint64_t>(End - c) < static_cast<k3d::uint64_t>(current_element.count) * stride)
+				throw std::runtime_error("unexpected end-of-file");
+
+			c += current_element.count * stride;
+			continue;
+		}
+
+		if(element_index == FaceElement)
+		{
+			FaceCounts.reserve(current_element.count);
+			FacePoints.reserve(3 * current_element.count);
+		}
+
+		for(k3d::uint_t i = 0; i != current_element.count; ++i)
+		{
+			k3d::point3 point(0, 0, 0);
+			for(k3d::uint_t j = 0; j != current_element.properties.size(); ++j)
 			{
-				boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::create(Output));
-		
-				polyhedron->shell_types.push_back(k3d::polyhedron::POLYGONS);
-
-				polyhedron->face_shells.reserve(element_count);
-				polyhedron->face_first_loops.reserve(element_count);
-				polyhedron->face_loop_counts.reserve(element_count);
-				polyhedron->face_selections.reserve(element_count);
-				polyhedron->face_materials.reserve(element_count);
-				polyhedron->loop_first_edges.reserve(element_count);
-				polyhedron->clockwise_edges.reserve(3 * element_count);
-				polyhedron->edge_selections.reserve(3 * element_count);
-				polyhedron->vertex_points.reserve(3 * element_count);
-				polyhedron->vertex_selections.reserve(3 * element_count);
-				
-				for(k3d::uint_t j = 0; j != element_count; ++j)
+				const property& current_property = current_element.properties[j];
+				if(current_property.count_type == NONE)
 				{
-					std::stringstream line_buffer;
-					k3d::getline(file, line_buffer);
-					if(!file)
+					const k3d::double_t value = read_binary(c, End, current_property.type, Swap);
+					if(element_index == VertexElement)
 					{
-						k3d::log() << error << "Unexpected end-of-file: " << Path.native_console_string() << std::endl;
-						return;
+						if(j == Layout.x)
+							point[0] = value;
+						else if(j == Layout.y)
+							point[1] = value;
+						else if(j == Layout.z)
+							point[2] = value;
 					}
 
-					k3d::uint_t point_count = 0;
-					line_buffer >> point_count;
-
-					polyhedron->face_shells.push_back(0);
-					polyhedron->face_first_loops.push_back(polyhedron->loop_first_edges.size());
-					polyhedron->face_loop_counts.push_back(1);
-					polyhedron->face_selections.push_back(0.0);
-					polyhedron->face_materials.push_back(0);
-					polyhedron->loop_first_edges.push_back(polyhedron->clockwise_edges.size());
-					
-					for(k3d::uint_t k = 0; k != point_count; ++k)
-					{
-						k3d::uint_t point = 0;
-						line_buffer >> point;
-
-						polyhedron->clockwise_edges.push_back(polyhedron->clockwise_edges.size() + 1);
-						polyhedron->edge_selections.push_back(0.0);
-						polyhedron->vertex_points.push_back(point);
-						polyhedron->vertex_selections.push_back(0.0);
-					}
+					continue;
+				}
 
-					if(polyhedron->loop_first_edges.size() && polyhedron->clockwise_edges.size())
-						polyhedron->clockwise_edges.back() = polyhedron->loop_first_edges.back();
+				const k3d::uint_t count = static_cast<k3d::uint_t>(read_binary(c, End, current_property.count_type, Swap));
+				if(element_index == FaceElement && j == Layout.vertex_indices)
+				{
+					FaceCounts.push_back(count);
+					for(k3d::uint_t k = 0; k != count; ++k)
+						FacePoints.push_back(static_cast<k3d::uint_t>(read_binary(c, End, current_property.type, Swap)));
+				}
+				else
+				{
+					const k3d::uint64_t size = static_cast<k3d::uint64_t>(count) * scalar_size(current_property.type);
+					if(static_cast<k3d::uint64_t>(End - c) < size)
+						throw std::runtime_error("unexpected end-of-file");
+					c += size;
 				}
 			}
+
+			if(element_index == VertexElement)
+				Points[i] = point;
+		}
+	}
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// mesh_reader
+
+class mesh_reader :
+	public k3d::material_sink<k3d::mesh_reader<k3d::node > >
+{
+	typedef k3d::material_sink<k3d::mesh_reader<k3d::node > > base;
+
+public:
+	mesh_reader(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
+		base(Factory, Document)
+	{
+	}
+
+	void on_load_mesh(const k3d::filesystem::path& Path, k3d::mesh& Output)
+	{
+		const k3d::mapped_file file(Path);
+		if(!file.is_open())
+			return;
+
+		try
+		{
+			detail::file_format format = detail::ASCII;
+			detail::elements_t elements;
+			const char* const data = detail::parse_header(file.begin(), file.end(), format, elements);
+
+			k3d::uint_t vertex_element = elements.size();
+			k3d::uint_t face_element = elements.size();
+			for(k3d::uint_t i = 0; i != elements.size(); ++i)
+			{
+				k3d::log() << info << "Reading " << elements[i].count << " elements of type: " << elements[i].name << std::endl;
+
+				if(elements[i].name == "vertex" && vertex_element == elements.size())
+					vertex_element = i;
+				else if(elements[i].name == "face" && face_element == elements.size())
+					face_element = i;
+			}
+
+			if(vertex_element == elements.size())
+				return;
+
+			const detail::property_layout layout(elements[vertex_element], face_element == elements.size() ? 0 : &elements[face_element]);
+
+			k3d::mesh::points_t points(elements[vertex_element].count);
+			k3d::mesh::counts_t face_counts;
+			k3d::mesh::indices_t face_points;
+
+			if(format == detail::ASCII)
+				detail::load_ascii(data, file.end(), elements, vertex_element, face_element, layout, points, face_counts, face_points);
+			else
+				detail::load_binary(data, file.end(), (format == detail::BINARY_BIG_ENDIAN) != k3d::big_endian(), elements, vertex_element, face_element, layout, points, face_counts, face_points);
+
+			if(face_element == elements.size())
+			{
+				Output.points.create(new k3d::mesh::points_t()).swap(points);
+				Output.point_selection.create(new k3d::mesh::selection_t(elements[vertex_element].count, 0.0));
+				return;
+			}
+
+			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::create(Output, points, face_counts, face_points, 0));
+		}
+		catch(std::exception& e)
+		{
+			Output = k3d::mesh();
+			k3d::log() << error << "Error reading " << Path.native_console_string() << ": " << e.what() << std::endl;
 		}
 	}
 
@@ -76,18 +76,18 @@ public:
 
 		for(k3d::mesh::primitives_t::iterator primitive = Output.primitives.begin(); primitive != Output.primitives.end(); ++primitive)
 		{
+			// Get shared lookups for boundary edges and edge faces (before making the output writable) ...
+			const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Output, **primitive);
+			if(!topology)
+				continue;
+
 			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::validate(Output, *primitive));
 			if(!polyhedron)
 				continue;
 
-			// Create a lookup so we can detect boundary edges ...
-			k3d::mesh::bools_t boundary_edges;
-			k3d::mesh::indices_t adjacent_edges;
-			k3d::polyhedron::create_edge_adjacency_lookup(polyhedron->vertex_points, polyhedron->clockwise_edges, boundary_edges, adjacent_edges);
-
-			// Create a lookup from edges to faces ...
-			k3d::mesh::indices_t edge_faces;
-			k3d::polyhedron::create_edge_face_lookup(*polyhedron, edge_faces);	
+			const k3d::mesh::bools_t& boundary_edges = topology->boundary_edges;
+			const k3d::mesh::indices_t& adjacent_edges = topology->companions;
+			const k3d::mesh::indices_t& edge_faces = topology->edge_faces;
 
 			// Begin with the set of selected edges ...
 			const k3d::uint_t edge_begin = 0;
@@ -44,6 +44,54 @@ namespace module
 namespace polyhedron
 {
 
+namespace detail
+{
+
+/// Records the source rows and weights for each new attribute value, so every attribute array can be filled in a single bulk operation
+class attribute_rows
+{
+public:
+	attribute_rows() :
+		first_indices(1, 0)
+	{
+	}
+
+	/// Records a new value copied from the given source row
+	void push_back(const k3d::uint_t Index)
+	{
+		indices.push_back(Index);
+		weights.push_back(1.0);
+		first_indices.push_back(indices.size());
+	}
+
+	/// Records a new value computed as the weighted sum of the given source rows
+	void push_back(const k3d::uint_t Count, const k3d::uint_t* Indices, const k3d::double_t* Weights)
+	{
+		indices.insert(indices.end(), Indices, Indices + Count);
+		weights.insert(weights.end(), Weights, Weights + Count);
+		first_indices.push_back(indices.size());
+	}
+
+	/// Appends every recorded value to the target arrays of a copier, and clears the recorded values
+	void flush(k3d::table_copier& Copier)
+	{
+		const k3d::uint_t count = first_indices.size() - 1;
+		if(count)
+			Copier.push_back(count, &first_indices[0], &indices[0], &weights[0]);
+
+		first_indices.assign(1, 0);
+		indices.clear();
+		weights.clear();
+	}
+
+private:
+	k3d::mesh::indices_t first_indices;
+	k3d::mesh::indices_t indices;
+	k3d::mesh::weights_t weights;
+};
+
+} // namespace detail
+
 /////////////////////////////////////////////////////////////////////////////
 // subdivide_faces
 
@@ -75,7 +123,8 @@ public:
 
 		k3d::mesh::points_t& points = Output.points.writable();
 		k3d::mesh::selection_t& point_selection = Output.point_selection.writable();
-		k3d::table_copier point_attributes(Output.point_attributes);
+		k3d::table_copier point_attribute_copier(Output.point_attributes);
+		detail::attribute_rows point_attributes;
 
 		const subdivision_t subdivision_type = m_subdivision_type.pipeline_value();
 
@@ -90,9 +139,12 @@ public:
 				continue;
 
 			// Get ready to copy attributes ...
-			k3d::table_copier face_attributes(polyhedron->face_attributes);
-			k3d::table_copier edge_attributes(polyhedron->edge_attributes);
-			k3d::table_copier vertex_attributes(polyhedron->vertex_attributes);
+			k3d::table_copier face_attribute_copier(polyhedron->face_attributes);
+			k3d::table_copier edge_attribute_copier(polyhedron->edge_attributes);
+			k3d::table_copier vertex_attribute_copier(polyhedron->vertex_attributes);
+			detail::attribute_rows face_attributes;
+			detail::attribute_rows edge_attributes;
+			detail::attribute_rows vertex_attributes;
 
 			// Don't explicitly delete any edges ...
 			k3d::mesh::bools_t remove_edges(polyhedron->clockwise_edges.size(), false);
@@ -495,6 +547,12 @@ public:
 				}
 			}
 
+			// Copy attributes for every new component at once ...
+			point_attributes.flush(point_attribute_copier);
+			face_attributes.flush(face_attribute_copier);
+			edge_attributes.flush(edge_attribute_copier);
+			vertex_attributes.flush(vertex_attribute_copier);
+
 			// Make it happen ...
 			k3d::polyhedron::delete_components(Output, *polyhedron, remove_points, remove_edges, remove_loops, remove_faces);
 		}
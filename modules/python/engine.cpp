@@ -32,6 +32,9 @@
 #include <k3dsdk/classes.h>
 #include <k3dsdk/file_helpers.h>
 #include <k3dsdk/fstream.h>
+#include <k3dsdk/idocument.h>
+#include <k3dsdk/inode.h>
+#include <k3dsdk/ipipeline_profiler.h>
 #include <k3dsdk/iscript_engine.h>
 #include <k3dsdk/module.h>
 #include <k3dsdk/python/file_signal_python.h>
@@ -43,6 +46,10 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <functional>
+#include <list>
+#include <unordered_map>
+
 namespace module
 {
 
@@ -78,10 +85,99 @@ public:
 	}
 };
 
+/// Caches compiled code objects by source, so scripts that are executed repeatedly (such as scripted nodes in an animated pipeline) are only
+/// compiled once, and nodes with identical scripts share the same code
+class code_cache
+{
+public:
+	static code_cache& instance()
+	{
+		// Deliberately never destroyed, since the cached code objects mustn't outlive the interpreter ...
+		static code_cache* const cache = new code_cache();
+		return *cache;
+	}
+
+	/// Returns the compiled code for a script, or a null handle if it hasn't been cached
+	boost::python::handle<> find(const k3d::string_t& Script)
+	{
+		const index_t::iterator entry = m_index.find(key(Script));
+		if(entry == m_index.end() || entry->second->source != Script)
+			return boost::python::handle<>();
+
+		// Keep the most-recently-used code at the front of the list ...
+		m_entries.splice(m_entries.begin(), m_entries, entry->second);
+		return entry->second->code;
+	}
+
+	/// Caches the compiled code for a script, discarding the least-recently-used code if the cache is full
+	void insert(const k3d::string_t& Script, const boost::python::handle<>& Code)
+	{
+		const std::size_t script_key = key(Script);
+
+		const index_t::iterator existing = m_index.find(script_key);
+		if(existing != m_index.end())
+		{
+			m_entries.erase(existing->second);
+			m_index.erase(existing);
+		}
+
+		m_entries.push_front(entry(script_key, Script, Code));
+		m_index.insert(std::make_pair(script_key, m_entries.begin()));
+
+		if(m_entries.size() > maximum_size)
+		{
+			m_index.erase(m_entries.back().key);
+			m_entries.pop_back();
+		}
+	}
+
+private:
+	code_cache()
+	{
+	}
+
+	static const std::size_t key(const k3d::string_t& Script)
+	{
+		return std::hash<k3d::string_t>()(Script);
+	}
+
+	struct entry
+	{
+		entry(const std::size_t Key, const k3d::string_t& Source, const boost::python::handle<>& Code) :
+			key(Key),
+			source(Source),
+			code(Code)
+		{
+		}
+
+		std::size_t key;
+		k3d::string_t source;
+		boost::python::handle<> code;
+	};
+
+	/// Maximum number of scripts to cache, so editing a script interactively doesn't accumulate stale code
+	static const std::size_t maximum_size = 64;
+
+	typedef std::list<entry> entries_t;
+	typedef std::unordered_map<std::size_t, entries_t::iterator> index_t;
+
+	/// Stores cached code, most-recently-used first
+	entries_t m_entries;
+	/// Indexes cached code by a hash of the script source
+	index_t m_index;
+};
+
 class engine :
 	public k3d::iscript_engine
 {
 public:
+	engine() :
+		m_local_dict(namespace_type()())
+	{
+		// Seed the namespace with the names that are already in __main__ (the module dictionary is a borrowed reference) ...
+		PyDict_Update(m_local_dict.ptr(), PyModule_GetDict(PyImport_AddModule("__main__")));
+	}
+
 	k3d::iplugin_factory& factory()
 	{
 		return get_factory();
@@ -130,13 +226,31 @@ public:
 
 			m_local_dict["context"] = Context;
 
-			// The embedded python interpreter cannot handle DOS line-endings, see http://sourceforge.net/tracker/?group_id=5470&atid=105470&func=detail&aid=1167922
-			k3d::string_t script = Script;
-			script.erase(std::remove(script.begin(), script.end(), '\r'), script.end());
+			// Scripted nodes pass themselves in the context, so we can profile them ...
+			k3d::inode* const node = context_node(Context);
+
+			boost::python::handle<> code = code_cache::instance().find(Script);
+			if(!code)
+			{
+				boost::scoped_ptr<k3d::ipipeline_profiler::profile> profile(node ? new k3d::ipipeline_profiler::profile(node->document().pipeline_profiler(), *node, "Compile Script") : 0);
+
+				// The embedded python interpreter cannot handle DOS line-endings, see http://sourceforge.net/tracker/?group_id=5470&atid=105470&func=detail&aid=1167922
+				k3d::string_t script = Script;
+				script.erase(std::remove(script.begin(), script.end(), '\r'), script.end());
+
+				// Compiled code is shared by every script with the same source, so it can't be named after any one of them ...
+				code = boost::python::handle<>(boost::python::allow_null(Py_CompileString(const_cast<char*>(script.c_str()), const_cast<char*>("<string>"), Py_file_input)));
+				if(code)
+					code_cache::instance().insert(Script, code);
+			}
+
+			PyObject* result = 0;
+			if(code)
+			{
+				boost::scoped_ptr<k3d::ipipeline_profiler::profile> profile(node ? new k3d::ipipeline_profiler::profile(node->document().pipeline_profiler(), *node, "Execute Script") : 0);
+				result = PyEval_EvalCode(reinterpret_cast<PyCodeObject*>(code.get()), m_local_dict.ptr(), m_local_dict.ptr());
+			}
 
-			PyDict_Update(m_local_dict.ptr(), PyObject_GetAttrString(PyImport_AddModule("__main__"), "__dict__"));
-			
-			PyObject* const result = PyRun_String(const_cast<char*>(script.c_str()), Py_file_input, m_local_dict.ptr(), m_local_dict.ptr());
 			if(result)
 			{
 				Py_DECREF(result);
@@ -177,8 +291,44 @@ public:
 		return false;
 	}
 
+private:
+	/// Returns a dict subclass that looks up missing names in __main__, so scripts see names added to __main__ after their namespace was
+	/// seeded without copying __main__ on every execution.  Python only uses the fallback for lookups made by module-level code.
+	static boost::python::object namespace_type()
+	{
+		// Deliberately never destroyed, since the type mustn't outlive the interpreter ...
+		static boost::python::object* type = 0;
+		if(!type)
+		{
+			boost::python::dict definitions;
+			definitions["__builtins__"] = boost::python::handle<>(boost::python::borrowed(PyEval_GetBuiltins()));
+
+			boost::python::handle<>(PyRun_String(
+				"import __main__\n"
+				"class main_namespace(dict):\n"
+				"\tdef __missing__(self, key):\n"
+				"\t\treturn __main__.__dict__[key]\n",
+				Py_file_input, definitions.ptr(), definitions.ptr()));
+
+			type = new boost::python::object(definitions["main_namespace"]);
+		}
+
+		return *type;
+	}
+
+	/// Returns the node that is executing a script, or NULL
+	static k3d::inode* context_node(const context& Context)
+	{
+		const context::const_iterator node = Context.find("node");
+		if(node == Context.end() || node->second.type() != typeid(k3d::inode*))
+			return 0;
+
+		return boost::any_cast<k3d::inode*>(node->second);
+	}
+
 	initialize_python m_initialize_python;
-	boost::python::dict m_local_dict;
+	/// Stores the script namespace, which falls back to __main__ for missing names
+	boost::python::object m_local_dict;
 };
 
 } // namespace python
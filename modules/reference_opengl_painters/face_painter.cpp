@@ -26,6 +26,7 @@
 #include <k3d-i18n-config.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/gl.h>
+#include <k3dsdk/hints.h>
 #include <k3dsdk/mesh_painter_gl.h>
 #include <k3dsdk/painter_render_state_gl.h>
 #include <k3dsdk/painter_selection_state_gl.h>
@@ -36,6 +37,9 @@
 
 #include <boost/scoped_ptr.hpp>
 
+#include <list>
+#include <map>
+
 namespace module
 {
 
@@ -45,68 +49,143 @@ namespace opengl
 namespace painters
 {
 
+namespace detail
+{
+
 /////////////////////////////////////////////////////////////////////////////
-// face_painter
+// cached_triangulation
 
-class face_painter :
-	public colored_selection_painter
+/// Stores the triangulation of one polyhedron as flat vertex arrays that can be drawn with glDrawArrays().
+/// Each triangle gets its own three corners so it can be flat-shaded.  The triangulation is computed once
+/// per topology, and only the corner positions and normals are recalculated when the geometry changes.
+class cached_triangulation :
+	public k3d::triangulator
 {
-	typedef colored_selection_painter base;
-
 public:
-	face_painter(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
-		base(Factory, Document, k3d::color(0.2, 0.2, 0.2), k3d::color(0.6, 0.6, 0.6))
+	cached_triangulation(const k3d::mesh& Mesh, const k3d::polyhedron::const_primitive& Polyhedron) :
+		point_count(Mesh.points->size())
 	{
+		process(Mesh, Polyhedron);
+		update_geometry(*Mesh.points);
 	}
 
-	class paint_triangles :
-		public k3d::triangulator
+	/// Recalculates corner positions and normals from a new set of mesh points, without re-triangulating
+	void update_geometry(const k3d::mesh::points_t& Points)
 	{
-	public:
-		paint_triangles(const k3d::mesh::points_t& Points, const k3d::mesh::selection_t& FaceSelections, const k3d::color& Color, const k3d::color& SelectedColor) :
-			points(Points),
-			face_selections(FaceSelections),
-			color(Color),
-			selected_color(SelectedColor)
+		const k3d::uint_t new_vertex_count = new_vertex_points.size() / 4;
+		new_vertices.resize(new_vertex_count);
+		for(k3d::uint_t i = 0; i != new_vertex_count; ++i)
 		{
+			k3d::point3& new_vertex = new_vertices[i];
+			new_vertex = k3d::point3(0, 0, 0);
+			for(k3d::uint_t j = 0; j != 4; ++j)
+				new_vertex += new_vertex_weights[i * 4 + j] * k3d::to_vector(vertex(Points, new_vertex_points[i * 4 + j]));
 		}
 
-		void start_processing(const k3d::mesh& SourceMesh)
+		const k3d::uint_t corner_count = corner_points.size();
+		positions.resize(corner_count * 3);
+		normals.resize(corner_count * 3);
+		for(k3d::uint_t corner = 0; corner != corner_count; corner += 3)
 		{
-			glBegin(GL_TRIANGLES);
+			const k3d::point3& p0 = vertex(Points, corner_points[corner + 0]);
+			const k3d::point3& p1 = vertex(Points, corner_points[corner + 1]);
+			const k3d::point3& p2 = vertex(Points, corner_points[corner + 2]);
+			const k3d::normal3 normal = k3d::polyhedron::normal(p0, p1, p2);
+
+			store(positions, corner + 0, p0[0], p0[1], p0[2]);
+			store(positions, corner + 1, p1[0], p1[1], p1[2]);
+			store(positions, corner + 2, p2[0], p2[1], p2[2]);
+			for(k3d::uint_t i = 0; i != 3; ++i)
+				store(normals, corner + i, normal[0], normal[1], normal[2]);
 		}
+	}
 
-		void start_face(const k3d::uint_t Face)
-		{
-			const k3d::color& face_color = face_selections[Face] ? selected_color : color;
-			k3d::gl::material(GL_FRONT_AND_BACK, GL_DIFFUSE, face_color);
-		}
+	/// Number of points in the source mesh, which separates mesh points from new vertices in corner_points
+	const k3d::uint_t point_count;
+
+	/// Stores the first triangle for each face, plus a trailing entry with the total triangle count
+	k3d::mesh::indices_t face_first_triangles;
+	/// Stores the mesh point (or new vertex, offset by the mesh point count) for each triangle corner
+	k3d::mesh::indices_t corner_points;
+	/// Stores the four source vertices for each vertex created by the triangulator
+	k3d::mesh::indices_t new_vertex_points;
+	/// Stores the four source weights for each vertex created by the triangulator
+	k3d::mesh::weights_t new_vertex_weights;
+
+	/// Stores the position of each triangle corner, as required by glVertexPointer()
+	std::vector<k3d::float_t> positions;
+	/// Stores the normal of each triangle corner, as required by glNormalPointer()
+	std::vector<k3d::float_t> normals;
+
+private:
+	const k3d::point3& vertex(const k3d::mesh::points_t& Points, const k3d::uint_t Vertex) const
+	{
+		return Vertex < point_count ? Points[Vertex] : new_vertices[Vertex - point_count];
+	}
 
-		void add_vertex(const k3d::point3& Coordinates, k3d::uint_t Vertices[4], k3d::uint_t Edges[4], k3d::double_t Weights[4], k3d::uint_t& NewVertex)
-		{
-			NewVertex = points.size();
-			points.push_back(Coordinates);
-		}
+	static void store(std::vector<k3d::float_t>& Array, const k3d::uint_t Corner, const k3d::double_t X, const k3d::double_t Y, const k3d::double_t Z)
+	{
+		Array[Corner * 3 + 0] = static_cast<k3d::float_t>(X);
+		Array[Corner * 3 + 1] = static_cast<k3d::float_t>(Y);
+		Array[Corner * 3 + 2] = static_cast<k3d::float_t>(Z);
+	}
 
-		void add_triangle(k3d::uint_t Vertices[3], k3d::uint_t Edges[3])
-		{
-			k3d::gl::normal3d(k3d::polyhedron::normal(points[Vertices[0]], points[Vertices[1]], points[Vertices[2]]));
-			k3d::gl::vertex3d(points[Vertices[0]]);
-			k3d::gl::vertex3d(points[Vertices[1]]);
-			k3d::gl::vertex3d(points[Vertices[2]]);
-		}
+	void start_face(const k3d::uint_t Face)
+	{
+		face_first_triangles.push_back(corner_points.size() / 3);
+	}
+
+	void add_vertex(const k3d::point3& Coordinates, k3d::uint_t Vertices[4], k3d::uint_t Edges[4], k3d::double_t Weights[4], k3d::uint_t& NewVertex)
+	{
+		NewVertex = point_count + new_vertices.size();
+		new_vertices.push_back(Coordinates);
 
-		void finish_processing(const k3d::mesh& SourceMesh)
+		for(k3d::uint_t i = 0; i != 4; ++i)
 		{
-			glEnd();
+			new_vertex_points.push_back(Weights[i] ? Vertices[i] : 0);
+			new_vertex_weights.push_back(Weights[i]);
 		}
+	}
 
-	private:
-		std::vector<k3d::point3> points;
-		const k3d::mesh::selection_t& face_selections;
-		const k3d::color color;
-		const k3d::color selected_color;
-	};
+	void add_triangle(k3d::uint_t Vertices[3], k3d::uint_t Edges[3])
+	{
+		corner_points.push_back(Vertices[0]);
+		corner_points.push_back(Vertices[1]);
+		corner_points.push_back(Vertices[2]);
+	}
+
+	void finish_processing(const k3d::mesh& SourceMesh)
+	{
+		face_first_triangles.push_back(corner_points.size() / 3);
+	}
+
+	/// Stores vertices created by the triangulator (e.g. at self-intersections)
+	k3d::mesh::points_t new_vertices;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////
+// face_painter
+
+class face_painter :
+	public colored_selection_painter
+{
+	typedef colored_selection_painter base;
+
+public:
+	face_painter(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
+		base(Factory, Document, k3d::color(0.2, 0.2, 0.2), k3d::color(0.6, 0.6, 0.6))
+	{
+	}
+
+	~face_painter()
+	{
+		for(connections_t::iterator connection = m_connections.begin(); connection != m_connections.end(); ++connection)
+			connection->second.disconnect();
+
+		clear_cache();
+	}
 
 	void on_paint_mesh(const k3d::mesh& Mesh, const k3d::gl::painter_render_state& RenderState, k3d::iproperty::changed_signal_t& ChangedSignal)
 	{
@@ -119,6 +198,10 @@ public:
 			if(k3d::polyhedron::is_sds(*polyhedron))
 				continue;
 		
+			const detail::cached_triangulation& triangulation = get_triangulation(Mesh, *primitive, *polyhedron, ChangedSignal);
+			if(triangulation.corner_points.empty())
+				continue;
+
 			k3d::gl::store_attributes attributes;
 	
 			glFrontFace(RenderState.inside_out ? GL_CCW : GL_CW);
@@ -132,49 +215,33 @@ public:
 			const k3d::color color = RenderState.node_selection ? selected_mesh_color() : unselected_mesh_color(RenderState.parent_selection);
 			const k3d::color selected_color = RenderState.show_component_selection ? selected_component_color() : color;
 
-			paint_triangles painter(*Mesh.points, polyhedron->face_selections, color, selected_color);
-			painter.process(Mesh, *polyhedron);
+			glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_NORMAL_ARRAY);
+			glVertexPointer(3, GL_FLOAT, 0, &triangulation.positions[0]);
+			glNormalPointer(GL_FLOAT, 0, &triangulation.normals[0]);
+
+			// Draw runs of faces that share the same selection state with a single call ...
+			const k3d::mesh::selection_t& face_selections = polyhedron->face_selections;
+			const k3d::mesh::indices_t& face_first_triangles = triangulation.face_first_triangles;
+			const k3d::uint_t face_count = face_selections.size();
+			for(k3d::uint_t face_begin = 0; face_begin != face_count; )
+			{
+				const k3d::bool_t selected = face_selections[face_begin];
+				k3d::uint_t face_end = face_begin + 1;
+				while(face_end != face_count && static_cast<k3d::bool_t>(face_selections[face_end]) == selected)
+					++face_end;
+
+				k3d::gl::material(GL_FRONT_AND_BACK, GL_DIFFUSE, selected ? selected_color : color);
+				glDrawArrays(GL_TRIANGLES, face_first_triangles[face_begin] * 3, (face_first_triangles[face_end] - face_first_triangles[face_begin]) * 3);
+
+				face_begin = face_end;
+			}
+
+			glPopClientAttrib();
 		}
 	}
 	
-	class select_triangles :
-		public k3d::triangulator
-	{
-	public:
-		select_triangles(const k3d::mesh::points_t& Points) :
-			points(Points)
-		{
-		}
-
-		void start_face(const k3d::uint_t Face)
-		{
-			k3d::gl::push_selection_token(k3d::selection::FACE, Face);
-			glBegin(GL_TRIANGLES);
-		}
-
-		void add_vertex(const k3d::point3& Coordinates, k3d::uint_t Vertices[4], k3d::uint_t Edges[4], k3d::double_t Weights[4], k3d::uint_t& NewVertex)
-		{
-			NewVertex = points.size();
-			points.push_back(Coordinates);
-		}
-
-		void add_triangle(k3d::uint_t Vertices[3], k3d::uint_t Edges[3])
-		{
-			k3d::gl::vertex3d(points[Vertices[0]]);
-			k3d::gl::vertex3d(points[Vertices[1]]);
-			k3d::gl::vertex3d(points[Vertices[2]]);
-		}
-
-		void finish_face(const k3d::uint_t Face)
-		{
-			glEnd(); // GL_TRIANGLES
-			k3d::gl::pop_selection_token(); // FACE
-		}
-
-	private:
-		std::vector<k3d::point3> points;
-	};
-
 	void on_select_mesh(const k3d::mesh& Mesh, const k3d::gl::painter_render_state& RenderState, const k3d::gl::painter_selection_state& SelectionState, k3d::iproperty::changed_signal_t& ChangedSignal)
 	{
 		if(!SelectionState.select_component.count(k3d::selection::FACE))
@@ -190,6 +257,10 @@ public:
 			if(k3d::polyhedron::is_sds(*polyhedron))
 				continue;
 
+			const detail::cached_triangulation& triangulation = get_triangulation(Mesh, *primitive, *polyhedron, ChangedSignal);
+			if(triangulation.corner_points.empty())
+				continue;
+
 			k3d::gl::store_attributes attributes;
 
 			glFrontFace(RenderState.inside_out ? GL_CCW : GL_CW);
@@ -200,12 +271,24 @@ public:
 			glEnable(GL_POLYGON_OFFSET_FILL);
 			glPolygonOffset(1.0, 1.0);
 			
+			glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glVertexPointer(3, GL_FLOAT, 0, &triangulation.positions[0]);
+
 			k3d::gl::push_selection_token(k3d::selection::PRIMITIVE, primitive_index);
 
-			select_triangles painter(*Mesh.points);
-			painter.process(Mesh, *polyhedron);
+			const k3d::mesh::indices_t& face_first_triangles = triangulation.face_first_triangles;
+			const k3d::uint_t face_count = face_first_triangles.size() - 1;
+			for(k3d::uint_t face = 0; face != face_count; ++face)
+			{
+				k3d::gl::push_selection_token(k3d::selection::FACE, face);
+				glDrawArrays(GL_TRIANGLES, face_first_triangles[face] * 3, (face_first_triangles[face + 1] - face_first_triangles[face]) * 3);
+				k3d::gl::pop_selection_token(); // FACE
+			}
 
 			k3d::gl::pop_selection_token(); // PRIMITIVE
+
+			glPopClientAttrib();
 		}
 	}
 	
@@ -220,6 +303,122 @@ public:
 
 		return factory;
 	}
+
+private:
+	/// Most-recently-used first
+	typedef std::list<const k3d::mesh::primitive*> lru_t;
+
+	struct cache_entry
+	{
+		cache_entry(const k3d::mesh::primitives_t::value_type& Primitive, const k3d::pipeline_data<k3d::mesh::points_t>& Points, k3d::iproperty::changed_signal_t& ChangedSignal, const lru_t::iterator LRUPosition, detail::cached_triangulation* Triangulation) :
+			primitive(Primitive),
+			points(Points),
+			changed_signal(&ChangedSignal),
+			lru_position(LRUPosition),
+			triangulation(Triangulation),
+			geometry_changed(false)
+		{
+		}
+
+		/// Keeps the triangulated primitive alive, so its identity can't be reused
+		k3d::mesh::primitives_t::value_type primitive;
+		/// The points used to compute the current triangulation geometry
+		k3d::pipeline_data<k3d::mesh::points_t> points;
+		k3d::iproperty::changed_signal_t* changed_signal;
+		lru_t::iterator lru_position;
+		detail::cached_triangulation* triangulation;
+		k3d::bool_t geometry_changed;
+	};
+
+	/// Stores cached triangulations for each polyhedron that we've painted
+	typedef std::map<const k3d::mesh::primitive*, cache_entry> cache_t;
+
+	/// Returns an up-to-date triangulation for the given polyhedron, creating it if necessary
+	const detail::cached_triangulation& get_triangulation(const k3d::mesh& Mesh, const k3d::mesh::primitives_t::value_type& Primitive, const k3d::polyhedron::const_primitive& Polyhedron, k3d::iproperty::changed_signal_t& ChangedSignal)
+	{
+		// Make sure we hear about changes to this mesh ...
+		sigc::connection& connection = m_connections[&ChangedSignal];
+		if(!connection.connected())
+			connection = ChangedSignal.connect(sigc::bind(sigc::mem_fun(*this, &face_painter::on_mesh_changed), &ChangedSignal));
+
+		// Entries hold a reference to their primitive, so its address can't be reused while cached, and
+		// pipeline data is copied-on-write, so the same primitive always has the same topology ...
+		cache_t::iterator entry = m_cache.find(Primitive.get());
+		if(entry != m_cache.end() && entry->second.triangulation->point_count != Mesh.points->size())
+		{
+			remove_entry(entry);
+			entry = m_cache.end();
+		}
+
+		if(entry == m_cache.end())
+		{
+			// Evict the least-recently-used triangulation if the cache is full ...
+			if(m_cache.size() == max_cache_size)
+				remove_entry(m_cache.find(m_lru.back()));
+
+			m_lru.push_front(Primitive.get());
+			entry = m_cache.insert(std::make_pair(Primitive.get(), cache_entry(Primitive, Mesh.points, ChangedSignal, m_lru.begin(), new detail::cached_triangulation(Mesh, Polyhedron)))).first;
+		}
+		else
+		{
+			m_lru.splice(m_lru.begin(), m_lru, entry->second.lru_position);
+		}
+
+		if(entry->second.geometry_changed || entry->second.points.get() != Mesh.points.get())
+		{
+			entry->second.triangulation->update_geometry(*Mesh.points);
+			entry->second.points = Mesh.points;
+			entry->second.geometry_changed = false;
+		}
+
+		return *entry->second.triangulation;
+	}
+
+	/// Called when an input mesh changes, discarding or updating its cached triangulations as-needed
+	void on_mesh_changed(k3d::ihint* Hint, k3d::iproperty::changed_signal_t* ChangedSignal)
+	{
+		if(dynamic_cast<k3d::hint::selection_changed*>(Hint))
+			return;
+
+		const k3d::bool_t geometry_changed = dynamic_cast<k3d::hint::mesh_geometry_changed*>(Hint) ? true : false;
+		for(cache_t::iterator entry = m_cache.begin(); entry != m_cache.end(); )
+		{
+			cache_t::iterator current = entry++;
+			if(current->second.changed_signal != ChangedSignal)
+				continue;
+
+			if(geometry_changed)
+				current->second.geometry_changed = true;
+			else
+				remove_entry(current);
+		}
+	}
+
+	void remove_entry(const cache_t::iterator Entry)
+	{
+		m_lru.erase(Entry->second.lru_position);
+		delete Entry->second.triangulation;
+		m_cache.erase(Entry);
+	}
+
+	void clear_cache()
+	{
+		for(cache_t::iterator entry = m_cache.begin(); entry != m_cache.end(); ++entry)
+			delete entry->second.triangulation;
+		m_cache.clear();
+		m_lru.clear();
+	}
+
+	/// Maximum number of triangulations to keep, matching the limit used by the advanced painters' cache
+	static const k3d::uint_t max_cache_size = 100;
+
+	cache_t m_cache;
+	/// Stores the cached primitives in order of use, for eviction
+	lru_t m_lru;
+
+	/// Stores connections to the changed signal of each mesh that we've painted
+	typedef std::map<k3d::iproperty::changed_signal_t*, sigc::connection> connections_t;
+	connections_t m_connections;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -23,11 +23,13 @@
 
 #include <k3d-i18n-config.h>
 #include <k3d-version-config.h>
+#include <k3dsdk/archive_cache_ri.h>
 #include <k3dsdk/classes.h>
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/file_range.h>
 #include <k3dsdk/fstream.h>
 #include <k3dsdk/gl.h>
+#include <k3dsdk/gzstream.h>
 #include <k3dsdk/icamera.h>
 #include <k3dsdk/icrop_window.h>
 #include <k3dsdk/iimager_shader_ri.h>
@@ -157,7 +159,10 @@ public:
 		m_shading_interpolation(init_owner(*this) + init_name("shading_interpolation") + init_label(_("Shading Interpolation")) + init_description(_("Shading Interpolation")) + init_value(k3d::ri::RI_CONSTANT()) + init_values(shading_interpolation_values())),
 		m_two_sided(init_owner(*this) + init_name("two_sided") + init_label(_("Two-Sided")) + init_description(_("Two Sided")) + init_value(true)),
 		m_motion_blur(init_owner(*this) + init_name("motion_blur") + init_label(_("Motion Blur")) + init_description(_("Motion Blur")) + init_value(false)),
-		m_render_motion_blur(init_owner(*this) + init_name("render_motion_blur") + init_label(_("Render Motion Blur")) + init_description(_("Render Motion Blur")) + init_value(false))
+		m_render_motion_blur(init_owner(*this) + init_name("render_motion_blur") + init_label(_("Render Motion Blur")) + init_description(_("Render Motion Blur")) + init_value(false)),
+		m_rib_encoding(init_owner(*this) + init_name("rib_encoding") + init_label(_("RIB Encoding")) + init_description(_("Choose between human-readable ASCII RIB, or smaller binary RIB that is faster to write and parse")) + init_enumeration(rib_encoding_values()) + init_value(std::string("ascii"))),
+		m_compress_rib(init_owner(*this) + init_name("compress_rib") + init_label(_("Compress RIB")) + init_description(_("Compress the RIB file using gzip")) + init_value(false)),
+		m_archive_static_geometry(init_owner(*this) + init_name("archive_static_geometry") + init_label(_("Archive Static Geometry")) + init_description(_("When rendering animations, write geometry that doesn't change between frames once, to RIB archives shared by every frame")) + init_value(true))
 	{
 		k3d::iproperty_group_collection::group output_group("Output");
 		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_resolution));
@@ -170,6 +175,9 @@ public:
 		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_default_exterior_shader));
 		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_imager_shader));
 		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_render_alpha));
+		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_rib_encoding));
+		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_compress_rib));
+		output_group.properties.push_back(&static_cast<k3d::iproperty&>(m_archive_static_geometry));
 
 		k3d::iproperty_group_collection::group sampling_group("Sampling");
 		sampling_group.properties.push_back(&static_cast<k3d::iproperty&>(m_bucket_width));
@@ -238,7 +246,7 @@ public:
 		const k3d::filesystem::path output_image = frame.add_file("output_image");
 
 		k3d::ri::shader_collection shaders;
-		return_val_if_fail(render(Camera, frame, *render_engine, output_image, true, shaders), false);
+		return_val_if_fail(render(Camera, frame, *render_engine, output_image, true, shaders, 0), false);
 		synchronize_shaders(shaders, *render_engine);
 
 		k3d::get_network_render_farm().start_job(job);
@@ -257,7 +265,7 @@ public:
 		const k3d::filesystem::path output_image = frame.add_file("output_image");
 
 		k3d::ri::shader_collection shaders;
-		return_val_if_fail(render(Camera, frame, *render_engine, output_image, false, shaders), false);
+		return_val_if_fail(render(Camera, frame, *render_engine, output_image, false, shaders, 0), false);
 		synchronize_shaders(shaders, *render_engine);
 
 		frame.add_copy_command(output_image, OutputImage);
@@ -278,6 +286,11 @@ public:
 		k3d::ri::shader_collection shaders;
 		k3d::inetwork_render_job& job = k3d::get_network_render_farm().create_job("k3d-renderman-render-animation");
 
+		// Geometry that doesn't change from frame-to-frame is shared using archives ...
+		boost::scoped_ptr<k3d::ri::archive_cache> archives;
+		if(m_archive_static_geometry.pipeline_value())
+			archives.reset(new k3d::ri::archive_cache(job, m_rib_encoding.pipeline_value() == "binary", m_compress_rib.pipeline_value()));
+
 		// For each frame to be rendered ...
 		k3d::uint_t frame_index = 0;
 		for(k3d::frames::const_iterator frame = Frames.begin(); frame != Frames.end(); ++frame, ++frame_index)
@@ -297,7 +310,7 @@ public:
 			const k3d::filesystem::path output_image = render_frame.add_file("output_image");
 
 			// Render it (hidden rendering) ...
-			return_val_if_fail(render(Camera, render_frame, *render_engine, output_image, false, shaders), false);
+			return_val_if_fail(render(Camera, render_frame, *render_engine, output_image, false, shaders, archives.get()), false);
 
 			// Copy the output image to its requested destination ...
 			render_frame.add_copy_command(output_image, frame->destination);
@@ -332,7 +345,7 @@ public:
 	}
 
 private:
-	bool render(k3d::icamera& Camera, k3d::inetwork_render_frame& Frame, k3d::ri::irender_engine& RenderEngine, const k3d::filesystem::path& OutputImagePath, const bool VisibleRender, k3d::ri::shader_collection& Shaders)
+	bool render(k3d::icamera& Camera, k3d::inetwork_render_frame& Frame, k3d::ri::irender_engine& RenderEngine, const k3d::filesystem::path& OutputImagePath, const bool VisibleRender, k3d::ri::shader_collection& Shaders, k3d::ri::archive_cache* const Archives)
 	{
 		// Sanity checks ...
 		return_val_if_fail(!OutputImagePath.empty(), false);
@@ -351,14 +364,19 @@ private:
 		const k3d::filesystem::path ribfilepath = Frame.add_file(ribfilename);
 
 		// Open the RIB file stream ...
-		k3d::filesystem::ofstream ribfile(ribfilepath);
-		return_val_if_fail(ribfile.good(), false);
+		boost::scoped_ptr<std::ostream> ribfile;
+		if(m_compress_rib.pipeline_value())
+			ribfile.reset(new k3d::filesystem::ogzstream(ribfilepath));
+		else
+			ribfile.reset(new k3d::filesystem::ofstream(ribfilepath));
+		return_val_if_fail(ribfile->good(), false);
 
 		// Setup the frame for RI rendering with the user's preferred engine ...
 		return_val_if_fail(RenderEngine.render(Frame, ribfilepath), false);
 
 		// Create the Ri render engine object ...
-		k3d::ri::stream stream(ribfile);
+		k3d::ri::stream stream(*ribfile);
+		stream.set_binary_encoding(m_rib_encoding.pipeline_value() == "binary");
 
 		// Administrivia ...
 		stream.RiNewline();
@@ -493,6 +511,7 @@ private:
 
 			// Setup render state ...
 			k3d::ri::render_state state(Frame, stream, Shaders, Camera.projection(), k3d::ri::FINAL_FRAME, samples, sample_index, transform_matrix);
+			state.archives = Archives;
 
 			if(k3d::ri::last_sample(state))
 			{
@@ -734,6 +753,20 @@ private:
 	k3d_data(bool, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_two_sided;
 	k3d_data(bool, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_motion_blur;
 	k3d_data(bool, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_render_motion_blur;
+	k3d_data(std::string, immutable_name, change_signal, with_undo, local_storage, no_constraint, enumeration_property, with_serialization) m_rib_encoding;
+	k3d_data(bool, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_compress_rib;
+	k3d_data(bool, immutable_name, change_signal, with_undo, local_storage, no_constraint, writable_property, with_serialization) m_archive_static_geometry;
+
+	static const k3d::ienumeration_property::enumeration_values_t& rib_encoding_values()
+	{
+		static k3d::ienumeration_property::enumeration_values_t values;
+		if(values.empty())
+		{
+			values.push_back(k3d::ienumeration_property::enumeration_value_t("ASCII", "ascii", "Write human-readable ASCII RIB"));
+			values.push_back(k3d::ienumeration_property::enumeration_value_t("Binary", "binary", "Write binary RIB"));
+		}
+		return values;
+	}
 
 	const k3d::ilist_property<std::string>::values_t& pixel_filter_values()
 	{
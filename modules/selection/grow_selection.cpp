@@ -48,10 +48,10 @@ namespace detail
 {
 
 // Selects all edges adjacent to the given point
-void select_adjacent_edges(k3d::mesh::selection_t& OutputEdgeSelections, const k3d::mesh::indices_t& PointEdges, const k3d::mesh::indices_t& PointFirstEdges, const k3d::mesh::counts_t& PointEdgeCounts, const k3d::uint_t Point, const k3d::double_t EdgeSelection)
+void select_adjacent_edges(k3d::mesh::selection_t& OutputEdgeSelections, const k3d::mesh::indices_t& PointFirstEdges, const k3d::mesh::indices_t& PointEdges, const k3d::uint_t Point, const k3d::double_t EdgeSelection)
 {
 	const k3d::uint_t first_idx = PointFirstEdges[Point];
-	const k3d::uint_t last_idx = first_idx + PointEdgeCounts[Point];
+	const k3d::uint_t last_idx = PointFirstEdges[Point + 1];
 	for(k3d::uint_t i = first_idx; i != last_idx; ++i)
 	{
 		const k3d::uint_t point_edge = PointEdges[i];
@@ -59,10 +59,10 @@ void select_adjacent_edges(k3d::mesh::selection_t& OutputEdgeSelections, const k
 	}
 }
 
-void select_adjacent_points(k3d::mesh::selection_t& PointSelections, const k3d::mesh::indices_t& ClockwiseEdges, const k3d::mesh::indices_t& EdgePoints, const k3d::mesh::indices_t& PointEdges, const k3d::mesh::indices_t& PointFirstEdges, const k3d::mesh::counts_t& PointEdgeCounts, const k3d::uint_t Point, const k3d::double_t PointSelection)
+void select_adjacent_points(k3d::mesh::selection_t& PointSelections, const k3d::mesh::indices_t& ClockwiseEdges, const k3d::mesh::indices_t& EdgePoints, const k3d::mesh::indices_t& PointFirstEdges, const k3d::mesh::indices_t& PointEdges, const k3d::uint_t Point, const k3d::double_t PointSelection)
 {
 	const k3d::uint_t first_idx = PointFirstEdges[Point];
-	const k3d::uint_t last_idx = first_idx + PointEdgeCounts[Point];
+	const k3d::uint_t last_idx = PointFirstEdges[Point + 1];
 	for(k3d::uint_t i = first_idx; i != last_idx; ++i)
 	{
 		const k3d::uint_t edge = PointEdges[i];
@@ -96,37 +96,23 @@ public:
 
 		for(k3d::uint_t i = 0; i != Output.primitives.size(); ++i)
 		{
+			// Get shared point-to-edge, face-to-edge, and companion lookups (before making the output writable) ...
+			const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Output, *Output.primitives[i]);
+			if(!topology)
+				continue;
+
 			boost::scoped_ptr<k3d::polyhedron::primitive> output_polyhedron(k3d::polyhedron::validate(Output, Output.primitives[i]));
 			if(!output_polyhedron)
 				continue;
 
 			const k3d::uint_t edge_count = output_polyhedron->clockwise_edges.size();
 
-			// Get point-to-edge lookup data for outgoing edges
-			k3d::mesh::indices_t point_edges_out;
-			k3d::mesh::indices_t point_first_edges_out;
-			k3d::mesh::indices_t point_edge_counts_out;
-			k3d::polyhedron::create_point_edge_lookup(output_polyhedron->vertex_points, point_edges_out, point_first_edges_out, point_edge_counts_out);
-
-			// Get point-to-edge lookup data for incoming edges
-			k3d::mesh::indices_t vertex_points_in(edge_count);
-			for(k3d::uint_t edge = 0; edge != edge_count; ++edge)
-			{
-				vertex_points_in[edge] = output_polyhedron->vertex_points[output_polyhedron->clockwise_edges[edge]];
-			}
-			k3d::mesh::indices_t point_edges_in;
-			k3d::mesh::indices_t point_first_edges_in;
-			k3d::mesh::indices_t point_edge_counts_in;
-			k3d::polyhedron::create_point_edge_lookup(vertex_points_in, point_edges_in, point_first_edges_in, point_edge_counts_in);
-
-			// Get face-to-edge data
-			k3d::mesh::indices_t edge_faces;
-			k3d::polyhedron::create_edge_face_lookup(*output_polyhedron, edge_faces);
-
-			// Get edge companions
-			k3d::mesh::indices_t adjacent_edges;
-			k3d::mesh::bools_t boundary_edges;
-			k3d::polyhedron::create_edge_adjacency_lookup(output_polyhedron->vertex_points, output_polyhedron->clockwise_edges, boundary_edges, adjacent_edges);
+			const k3d::mesh::indices_t& point_first_edges_out = topology->point_first_out_edges;
+			const k3d::mesh::indices_t& point_edges_out = topology->point_out_edges;
+			const k3d::mesh::indices_t& point_first_edges_in = topology->point_first_in_edges;
+			const k3d::mesh::indices_t& point_edges_in = topology->point_in_edges;
+			const k3d::mesh::indices_t& edge_faces = topology->edge_faces;
+			const k3d::mesh::indices_t& adjacent_edges = topology->companions;
 
 			// copies, since we're modifying these in the output. They don't exist in Input since the selection was not merged
 			const k3d::mesh::selection_t input_point_selections = *Output.point_selection;
@@ -141,10 +127,10 @@ public:
 				{
 					const k3d::uint_t start_point = output_polyhedron->vertex_points[edge];
 					const k3d::uint_t end_point = output_polyhedron->vertex_points[output_polyhedron->clockwise_edges[edge]];
-					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_edges_out, point_first_edges_out, point_edge_counts_out, start_point, edge_selection);
-					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_edges_out, point_first_edges_out, point_edge_counts_out, end_point, edge_selection);
-					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_edges_in, point_first_edges_in, point_edge_counts_in, start_point, edge_selection);
-					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_edges_in, point_first_edges_in, point_edge_counts_in, end_point, edge_selection);
+					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_first_edges_out, point_edges_out, start_point, edge_selection);
+					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_first_edges_out, point_edges_out, end_point, edge_selection);
+					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_first_edges_in, point_edges_in, start_point, edge_selection);
+					detail::select_adjacent_edges(output_polyhedron->edge_selections, point_first_edges_in, point_edges_in, end_point, edge_selection);
 				}
 
 				// Grow face selections
@@ -159,8 +145,8 @@ public:
 			{
 				if(input_point_selections[point])
 				{
-					detail::select_adjacent_points(Output.point_selection.writable(), output_polyhedron->clockwise_edges, output_polyhedron->vertex_points, point_edges_out, point_first_edges_out, point_edge_counts_out, point, input_point_selections[point]);
-					detail::select_adjacent_points(Output.point_selection.writable(), output_polyhedron->clockwise_edges, output_polyhedron->vertex_points, point_edges_in, point_first_edges_in, point_edge_counts_in, point, input_point_selections[point]);
+					detail::select_adjacent_points(Output.point_selection.writable(), output_polyhedron->clockwise_edges, output_polyhedron->vertex_points, point_first_edges_out, point_edges_out, point, input_point_selections[point]);
+					detail::select_adjacent_points(Output.point_selection.writable(), output_polyhedron->clockwise_edges, output_polyhedron->vertex_points, point_first_edges_in, point_edges_in, point, input_point_selections[point]);
 				}
 			}
 		}
@@ -77,12 +77,14 @@ private:
 
 		for(k3d::mesh::primitives_t::iterator primitive = Output.primitives.begin(); primitive != Output.primitives.end(); ++primitive)
 		{
+			const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Output, **primitive);
+			if(!topology)
+				continue;
+
 			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::validate(Output, *primitive));
 			if(polyhedron)
 			{
-				k3d::mesh::bools_t boundary_edges;
-				k3d::mesh::indices_t adjacent_edges;
-				k3d::polyhedron::create_edge_adjacency_lookup(polyhedron->vertex_points, polyhedron->clockwise_edges, boundary_edges, adjacent_edges);
+				const k3d::mesh::bools_t& boundary_edges = topology->boundary_edges;
 				const k3d::uint_t edge_count = boundary_edges.size();
 				for(k3d::uint_t edge = 0; edge != edge_count; ++edge)
 				{
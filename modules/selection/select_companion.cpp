@@ -71,15 +71,16 @@ public:
 
 		for(k3d::mesh::primitives_t::iterator primitive = Output.primitives.begin(); primitive != Output.primitives.end(); ++primitive)
 		{
+			const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Output, **primitive);
+			if(!topology)
+				continue;
+
 			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::validate(Output, *primitive));
 			if(!polyhedron)
 				continue;
 
 			const k3d::mesh::selection_t original_edge_selections = polyhedron->edge_selections;
-
-			k3d::mesh::bools_t boundary_edges;
-			k3d::mesh::indices_t companions;
-			k3d::polyhedron::create_edge_adjacency_lookup(polyhedron->vertex_points, polyhedron->clockwise_edges, boundary_edges, companions);
+			const k3d::mesh::indices_t& companions = topology->companions;
 
 			std::fill(polyhedron->edge_selections.begin(), polyhedron->edge_selections.end(), 0.0);
 
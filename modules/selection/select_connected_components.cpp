@@ -152,6 +152,10 @@ public:
 
 		for(k3d::uint_t i = 0; i != Input.primitives.size(); ++i)
 		{
+			const boost::shared_ptr<const k3d::polyhedron::topology_index> topology = k3d::polyhedron::get_topology_index(Output, *Output.primitives[i]);
+			if(!topology)
+				continue;
+
 			boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::validate(Output, Output.primitives[i]));
 			if(!polyhedron)
 				continue;
@@ -186,7 +190,7 @@ public:
 			}
 
 			k3d::mesh::selection_t output_selection(face_end - face_begin, 0.0);
-			connected_faces_selector selector(*polyhedron, output_selection, array_name, m_same_attributes.pipeline_value());
+			connected_faces_selector selector(*polyhedron, *topology, output_selection, array_name, m_same_attributes.pipeline_value());
 			for(k3d::uint_t face = face_begin; face != face_end; ++face)
 			{
 				if(input_selected_faces[face])
@@ -219,15 +223,13 @@ private:
 	{
 		const k3d::polyhedron::const_primitive& m_polyhedron;
 		k3d::mesh::selection_t& m_output_selection;
-		k3d::mesh::bools_t m_boundary_edges;
-		k3d::mesh::indices_t m_adjacent_edges;
-		k3d::mesh::indices_t m_edge_faces;
+		const k3d::mesh::bools_t& m_boundary_edges;
+		const k3d::mesh::indices_t& m_adjacent_edges;
+		const k3d::mesh::indices_t& m_edge_faces;
 		boost::shared_ptr<detail::iarray_wrapper> m_face_array_wrapper;
 		const k3d::bool_t m_use_attributes;
-		connected_faces_selector(const k3d::polyhedron::const_primitive& Polyhedron, k3d::mesh::selection_t& OutputFaceSelection, const std::string& ArrayName, const k3d::bool_t UseAttributes) : m_polyhedron(Polyhedron), m_output_selection(OutputFaceSelection), m_use_attributes(UseAttributes)
+		connected_faces_selector(const k3d::polyhedron::const_primitive& Polyhedron, const k3d::polyhedron::topology_index& Topology, k3d::mesh::selection_t& OutputFaceSelection, const std::string& ArrayName, const k3d::bool_t UseAttributes) : m_polyhedron(Polyhedron), m_output_selection(OutputFaceSelection), m_boundary_edges(Topology.boundary_edges), m_adjacent_edges(Topology.companions), m_edge_faces(Topology.edge_faces), m_use_attributes(UseAttributes)
 		{
-			k3d::polyhedron::create_edge_adjacency_lookup(m_polyhedron.vertex_points, m_polyhedron.clockwise_edges, m_boundary_edges, m_adjacent_edges);
-			k3d::polyhedron::create_edge_face_lookup(m_polyhedron, m_edge_faces);
 			m_face_array_wrapper = detail::wrap_array(Polyhedron.face_attributes.lookup(ArrayName));
 		}
 
@@ -24,16 +24,19 @@
 
 #include <k3d-i18n-config.h>
 #include <k3dsdk/document_plugin_factory.h>
-#include <k3dsdk/file_helpers.h>
-#include <k3dsdk/fstream.h>
+#include <k3dsdk/mapped_file.h>
 #include <k3dsdk/mesh_reader.h>
 #include <k3dsdk/node.h>
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/threads.h>
 #include <k3dsdk/polyhedron.h>
+#include <k3dsdk/text_parsing.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/scoped_ptr.hpp>
 
-#include <set>
+#include <cstring>
 
 #include "binary_stl.h"
 
@@ -49,120 +52,380 @@ namespace io
 namespace detail
 {
 
+/// Size in bytes of the header of a binary STL file (an 80-byte comment, followed by the facet count)
+const k3d::uint_t binary_header_size = 84;
+/// Size in bytes of each facet in a binary STL file
+const k3d::uint_t binary_facet_size = 50;
+
 /// True if the supplied file is an ASCII STL file
-k3d::bool_t is_ascii(std::istream& Stream)
+k3d::bool_t is_ascii(const char* const Begin, const char* const End)
 {
-	char buffer[80];
-	Stream.read(buffer, 80);
-	Stream.seekg(0, std::ios::beg);
-	return (boost::algorithm::starts_with(buffer, "solid"));
+	const k3d::uint64_t size = End - Begin;
+	if(size < 5 || std::strncmp(Begin, "solid", 5))
+		return false;
+
+	// Some binary files start with "solid" too, so check whether the size matches a binary file ...
+	if(size >= binary_header_size)
+	{
+		k3d::uint32_t facet_count = 0;
+		std::memcpy(&facet_count, Begin + 80, sizeof(facet_count));
+		if(binary_header_size + static_cast<k3d::uint64_t>(facet_count) * binary_facet_size == size)
+			return false;
+	}
+
+	return true;
 }
 
-struct compare_points
+/// Mixes the bits of a 64-bit value, for hashing
+inline const k3d::uint64_t mix(k3d::uint64_t Value)
 {
-	bool operator()(const k3d::point3& A, const k3d::point3& B) const
+	Value ^= Value >> 33;
+	Value *= 0xff51afd7ed558ccdULL;
+	Value ^= Value >> 33;
+	Value *= 0xc4ceb9fe1a85ec53ULL;
+	Value ^= Value >> 33;
+	return Value;
+}
+
+/// Hashes points consistently with exact point equality (so -0 and 0 hash the same)
+struct hash_point
+{
+	const k3d::uint64_t operator()(const k3d::point3& Point) const
 	{
-		if (A[0] != B[0])
-		{
-			return A[0] < B[0];
-		}
-		if (A[1] != B[1])
+		k3d::uint64_t result = 0;
+		for(k3d::uint_t i = 0; i != 3; ++i)
 		{
-			return A[1] < B[1];
+			const k3d::double_t value = Point[i] == 0 ? 0.0 : Point[i];
+			k3d::uint64_t bits = 0;
+			std::memcpy(&bits, &value, sizeof(bits));
+			result = mix(result ^ bits);
 		}
-		return A[2] < B[2];
+		return result;
 	}
 };
 
-typedef std::map<k3d::point3, k3d::uint_t, compare_points> point_map_t;
+/// Stores the point indices of a triangle
+struct triangle
+{
+	triangle(const k3d::uint_t A, const k3d::uint_t B, const k3d::uint_t C)
+	{
+		points[0] = A;
+		points[1] = B;
+		points[2] = C;
+	}
+
+	bool operator==(const triangle& Other) const
+	{
+		return points[0] == Other.points[0] && points[1] == Other.points[1] && points[2] == Other.points[2];
+	}
+
+	k3d::uint_t points[3];
+};
 
-void fill_points(const point_map_t& PointMap, k3d::mesh::points_t& Points)
+/// Hashes triangles
+struct hash_triangle
 {
-	Points.resize(PointMap.size());
-	for(point_map_t::const_iterator it = PointMap.begin(); it != PointMap.end(); ++it)
+	const k3d::uint64_t operator()(const triangle& Triangle) const
 	{
-		Points[it->second] = it->first;
+		return mix(mix(mix(Triangle.points[0]) ^ Triangle.points[1]) ^ Triangle.points[2]);
 	}
-}
+};
 
-/// Adds a point without introducing duplicates
-k3d::uint_t add_point(point_map_t &PointMap, const k3d::point3 &Point)
+/// Open-addressing hash table that assigns consecutive indices to unique keys, in order of first appearance
+template<typename KeyT, typename HashT>
+class index_table
 {
-	return PointMap.insert(std::make_pair(Point, PointMap.size())).first->second;
-}
+public:
+	explicit index_table(const k3d::uint_t ExpectedKeys) :
+		m_slots(capacity(ExpectedKeys), empty())
+	{
+		m_keys.reserve(ExpectedKeys);
+	}
+
+	/// Returns the index of the given key, adding it if it doesn't already exist
+	const k3d::uint_t insert(const KeyT& Key, k3d::bool_t& Inserted)
+	{
+		const k3d::uint_t mask = m_slots.size() - 1;
+		for(k3d::uint_t slot = m_hash(Key) & mask; ; slot = (slot + 1) & mask)
+		{
+			const k3d::uint_t index = m_slots[slot];
+			if(index == empty())
+			{
+				m_slots[slot] = m_keys.size();
+				m_keys.push_back(Key);
+				Inserted = true;
+
+				if(2 * m_keys.size() > m_slots.size())
+					grow();
+
+				return m_keys.size() - 1;
+			}
+
+			if(m_keys[index] == Key)
+			{
+				Inserted = false;
+				return index;
+			}
+		}
+	}
 
-/// Extracts the STL topology information, merging points that are less than threshold apart
-void get_stl_topology(std::istream& Stream, k3d::mesh::points_t& Points, k3d::mesh::counts_t& VertexCounts, k3d::mesh::indices_t& VertexIndices, k3d::mesh::normals_t& Normals, const k3d::double_t Threshold = 1e-12)
+	/// Returns the unique keys, in index order
+	std::vector<KeyT>& keys()
+	{
+		return m_keys;
+	}
+
+private:
+	static const k3d::uint_t empty()
+	{
+		return static_cast<k3d::uint_t>(-1);
+	}
+
+	static const k3d::uint_t capacity(const k3d::uint_t Keys)
+	{
+		k3d::uint_t result = 16;
+		while(result < 2 * Keys)
+			result *= 2;
+		return result;
+	}
+
+	void grow()
+	{
+		m_slots.assign(2 * m_slots.size(), empty());
+		const k3d::uint_t mask = m_slots.size() - 1;
+		for(k3d::uint_t index = 0; index != m_keys.size(); ++index)
+		{
+			k3d::uint_t slot = m_hash(m_keys[index]) & mask;
+			while(m_slots[slot] != empty())
+				slot = (slot + 1) & mask;
+			m_slots[slot] = index;
+		}
+	}
+
+	std::vector<KeyT> m_keys;
+	std::vector<k3d::uint_t> m_slots;
+	HashT m_hash;
+};
+
+/// Stores the facets parsed from one chunk of an ASCII STL file
+class facet_chunk
 {
-	const k3d::double_t threshold = Threshold*Threshold;
+public:
+	/// Stores three corners for each facet
+	k3d::mesh::points_t corners;
+	k3d::mesh::normals_t normals;
+	k3d::string_t error;
+};
+
+typedef std::vector<facet_chunk> facet_chunks;
 
-	detail::point_map_t point_map;
+/// Divides an ASCII STL file into chunks that each begin with a "facet" line, for parsing in parallel
+void split_facets(const char* const Begin, const char* const End, std::vector<const char*>& Boundaries)
+{
+	std::vector<const char*> boundaries;
+	k3d::text::split_lines(Begin, End, k3d::text::chunk_count(End - Begin), boundaries);
 
-	k3d::string_t line_buffer;
-	k3d::uint_t line_number = 0;
-	k3d::mesh::indices_t face_points;
-	k3d::normal3 face_normal;
-	std::set<k3d::string_t> added_faces; // stores a unique ID for each added face
-	for(k3d::getline(Stream, line_buffer); Stream; k3d::getline(Stream, line_buffer))
+	Boundaries.clear();
+	Boundaries.push_back(Begin);
+	for(k3d::uint_t i = 1; i + 1 < boundaries.size(); ++i)
 	{
-		++line_number;
-		k3d::string_t keyword;
-		std::istringstream line_stream(line_buffer);
-		line_stream >> keyword;
+		const char* line = std::max(boundaries[i], Boundaries.back());
+		for(; line != End; line = k3d::text::next_line(line, End))
+		{
+			const char* const c = k3d::text::skip_space(line, End);
+			if(k3d::text::equal(c, k3d::text::token_end(c, End), "facet"))
+				break;
+		}
 
-		if(keyword == "facet")
+		if(line != Boundaries.back() && line != End)
+			Boundaries.push_back(line);
+	}
+	Boundaries.push_back(End);
+}
+
+/// Parses chunks of an ASCII STL file in parallel
+class parse_ascii_chunks
+{
+public:
+	parse_ascii_chunks(const std::vector<const char*>& Boundaries, facet_chunks& Chunks) :
+		boundaries(Boundaries),
+		chunks(Chunks)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t chunk_begin = range.begin();
+		const k3d::uint_t chunk_end = range.end();
+		for(k3d::uint_t chunk = chunk_begin; chunk != chunk_end; ++chunk)
 		{
-			k3d::string_t keyword2;
-			line_stream >> keyword2;
-			assert_warning(keyword2 == "normal");
-			k3d::double_t x, y, z;
-			line_stream >> x;
-			line_stream >> y;
-			line_stream >> z;
-			face_normal = k3d::normalize(k3d::normal3(x,y,z));
+			try
+			{
+				parse(boundaries[chunk], boundaries[chunk + 1], chunks[chunk]);
+			}
+			catch(std::exception& e)
+			{
+				chunks[chunk].error = e.what();
+			}
 		}
-		if(keyword == "vertex")
+	}
+
+private:
+	static void parse(const char* const Begin, const char* const End, facet_chunk& Chunk)
+	{
+		k3d::normal3 face_normal(0, 0, 0);
+		k3d::uint_t face_points = 0;
+		for(const char* line = Begin; line != End; line = k3d::text::next_line(line, End))
 		{
-			k3d::double_t x, y, z;
-			line_stream >> x;
-			line_stream >> y;
-			line_stream >> z;
-			k3d::point3 new_point(x, y, z);
-
-			face_points.push_back(detail::add_point(point_map, new_point));
-			if(face_points.size() == 3)
+			const char* const line_end = k3d::text::line_end(line, End);
+			const char* c = k3d::text::skip_blanks(line, line_end);
+			const char* const keyword_begin = c;
+			const char* const keyword_end = c = k3d::text::token_end(c, line_end);
+
+			if(k3d::text::equal(keyword_begin, keyword_end, "vertex"))
 			{
-				std::stringstream face_id_stream;
-				face_id_stream << face_points[0] << face_points[1] << face_points[2];
-				k3d::string_t face_id = face_id_stream.str();
-				if(added_faces.count(face_id))
-				{
-					k3d::log() << warning << "Skipping duplicate face on line " << line_number - 4 << std::endl;
-				}
-				else
+				k3d::point3 point;
+				if(!(k3d::text::parse(c, line_end, point[0]) && k3d::text::parse(c, line_end, point[1]) && k3d::text::parse(c, line_end, point[2])))
+					throw std::runtime_error("Error: invalid STL vertex [" + k3d::string_t(line, line_end) + "]");
+
+				Chunk.corners.push_back(point);
+				if(++face_points == 3)
 				{
-					VertexIndices.insert(VertexIndices.end(), face_points.begin(), face_points.end());
-					VertexCounts.push_back(3);
-					Normals.push_back(face_normal);
-					added_faces.insert(face_id);
+					Chunk.normals.push_back(face_normal);
+					face_points = 0;
 				}
-				face_points.clear();
 			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "facet"))
+			{
+				c = k3d::text::skip_blanks(c, line_end);
+				const char* const keyword2_end = k3d::text::token_end(c, line_end);
+				assert_warning(k3d::text::equal(c, keyword2_end, "normal"));
+				c = keyword2_end;
+
+				k3d::double_t x = 0, y = 0, z = 0;
+				k3d::text::parse(c, line_end, x) && k3d::text::parse(c, line_end, y) && k3d::text::parse(c, line_end, z);
+				face_normal = k3d::normalize(k3d::normal3(x, y, z));
+			}
+			else if(k3d::text::equal(keyword_begin, keyword_end, "endfacet"))
+			{
+				if(face_points)
+					throw std::runtime_error("Error: STL file had less than 3 vertices for face [" + k3d::string_t(line, line_end) + "]");
+			}
+		}
+
+		if(face_points)
+			throw std::runtime_error("Error: STL file had less than 3 vertices for the last face");
+	}
+
+	const std::vector<const char*>& boundaries;
+	facet_chunks& chunks;
+};
+
+/// Extracts the facet corners and normals from an ASCII STL file
+void read_ascii(const char* const Begin, const char* const End, k3d::mesh::points_t& Corners, k3d::mesh::normals_t& Normals)
+{
+	std::vector<const char*> boundaries;
+	split_facets(Begin, End, boundaries);
+
+	const k3d::uint_t chunk_count = boundaries.size() - 1;
+	facet_chunks chunks(chunk_count);
+	k3d::parallel::parallel_for(
+		k3d::parallel::blocked_range<k3d::uint_t>(0, chunk_count, 1),
+		parse_ascii_chunks(boundaries, chunks));
+
+	k3d::uint_t facet_count = 0;
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		if(!chunks[chunk].error.empty())
+			throw std::runtime_error(chunks[chunk].error);
+		facet_count += chunks[chunk].normals.size();
+	}
+
+	Corners.reserve(3 * facet_count);
+	Normals.reserve(facet_count);
+	for(k3d::uint_t chunk = 0; chunk != chunk_count; ++chunk)
+	{
+		Corners.insert(Corners.end(), chunks[chunk].corners.begin(), chunks[chunk].corners.end());
+		Normals.insert(Normals.end(), chunks[chunk].normals.begin(), chunks[chunk].normals.end());
+	}
+}
+
+/// Decodes the facets of a binary STL file in parallel
+class decode_binary_facets
+{
+public:
+	decode_binary_facets(const char* const Facets, k3d::mesh::points_t& Corners, k3d::mesh::normals_t& Normals, std::vector<k3d::uint16_t>& Colors) :
+		facets(Facets),
+		corners(Corners),
+		normals(Normals),
+		colors(Colors)
+	{
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t facet_begin = range.begin();
+		const k3d::uint_t facet_end = range.end();
+		for(k3d::uint_t f = facet_begin; f != facet_end; ++f)
+		{
+			facet stl_facet;
+			std::memcpy(&stl_facet, facets + f * binary_facet_size, binary_facet_size);
+
+			normals[f] = k3d::normal3(stl_facet.normal[0], stl_facet.normal[1], stl_facet.normal[2]);
+			corners[3 * f + 0] = k3d::point3(stl_facet.v0[0], stl_facet.v0[1], stl_facet.v0[2]);
+			corners[3 * f + 1] = k3d::point3(stl_facet.v1[0], stl_facet.v1[1], stl_facet.v1[2]);
+			corners[3 * f + 2] = k3d::point3(stl_facet.v2[0], stl_facet.v2[1], stl_facet.v2[2]);
+			colors[f] = stl_facet.color;
 		}
-		if(keyword == "endfacet")
+	}
+
+private:
+	const char* const facets;
+	k3d::mesh::points_t& corners;
+	k3d::mesh::normals_t& normals;
+	std::vector<k3d::uint16_t>& colors;
+};
+
+/// Merges identical facet corners into shared points (numbered in order of first appearance), optionally skipping duplicate faces.
+/// This is sequential, so the point order doesn't depend on the number of threads.
+void weld_corners(const k3d::mesh::points_t& Corners, const k3d::bool_t SkipDuplicateFaces, k3d::mesh::points_t& Points, k3d::mesh::counts_t& VertexCounts, k3d::mesh::indices_t& VertexIndices, std::vector<k3d::uint_t>& Faces)
+{
+	const k3d::uint_t facet_count = Corners.size() / 3;
+	index_table<k3d::point3, hash_point> point_table(facet_count / 2);
+	index_table<triangle, hash_triangle> face_table(SkipDuplicateFaces ? facet_count : 0);
+
+	VertexCounts.reserve(facet_count);
+	VertexIndices.reserve(3 * facet_count);
+	Faces.reserve(facet_count);
+
+	k3d::bool_t inserted = false;
+	for(k3d::uint_t f = 0; f != facet_count; ++f)
+	{
+		const k3d::uint_t a = point_table.insert(Corners[3 * f + 0], inserted);
+		const k3d::uint_t b = point_table.insert(Corners[3 * f + 1], inserted);
+		const k3d::uint_t c = point_table.insert(Corners[3 * f + 2], inserted);
+
+		if(SkipDuplicateFaces)
 		{
-			if(face_points.size())
+			face_table.insert(triangle(a, b, c), inserted);
+			if(!inserted)
 			{
-				std::stringstream error_stream;
-				error_stream << "Error: STL file had less than 3 vertices for face ending on line " << line_number;
-				throw std::runtime_error(error_stream.str());
+				k3d::log() << warning << "Skipping duplicate face " << f << std::endl;
+				continue;
 			}
 		}
+
+		VertexCounts.push_back(3);
+		VertexIndices.push_back(a);
+		VertexIndices.push_back(b);
+		VertexIndices.push_back(c);
+		Faces.push_back(f);
 	}
-	detail::fill_points(point_map, Points);
+
+	Points.swap(point_table.keys());
 }
 
-const k3d::normal3 normal(const k3d::mesh::points_t Points, k3d::mesh::indices_t& VertexIndices, const k3d::uint_t FaceIndex)
+const k3d::normal3 normal(const k3d::mesh::points_t& Points, const k3d::mesh::indices_t& VertexIndices, const k3d::uint_t FaceIndex)
 {
 	// Calculates the normal for an edge loop using the summation method, which is more robust than the three-point methods (handles zero-length edges)
 	k3d::normal3 result(0, 0, 0);
@@ -183,22 +446,38 @@ const k3d::normal3 normal(const k3d::mesh::points_t Points, k3d::mesh::indices_t
 }
 
 /// Make the face orientation consistent with the normal stored on file
-void adjust_orientation(const k3d::mesh::points_t Points, k3d::mesh::indices_t& VertexIndices, const k3d::mesh::normals_t& Normals)
+class adjust_orientation
 {
-	for(k3d::uint_t face = 0; face != Normals.size(); ++face)
+public:
+	adjust_orientation(const k3d::mesh::points_t& Points, k3d::mesh::indices_t& VertexIndices, const k3d::mesh::normals_t& Normals) :
+		points(Points),
+		vertex_indices(VertexIndices),
+		normals(Normals)
 	{
-		const k3d::normal3 calculated_normal = k3d::normalize(normal(Points, VertexIndices, face));
-		const k3d::normal3& stored_normal = Normals[face];
-		const k3d::uint_t face_start = face * 3;
-		if((calculated_normal * stored_normal) < 0)
+	}
+
+	void operator()(const k3d::parallel::blocked_range<k3d::uint_t>& range) const
+	{
+		const k3d::uint_t face_begin = range.begin();
+		const k3d::uint_t face_end = range.end();
+		for(k3d::uint_t face = face_begin; face != face_end; ++face)
 		{
-			// stored normal is opposite to face rientation, so we flip face orientation
-			const k3d::uint_t old_first_point = VertexIndices[face_start];
-			VertexIndices[face_start] = VertexIndices[face_start + 1];
-			VertexIndices[face_start + 1] = old_first_point;
+			const k3d::normal3 calculated_normal = k3d::normalize(normal(points, vertex_indices, face));
+			const k3d::normal3& stored_normal = normals[face];
+			const k3d::uint_t face_start = face * 3;
+			if((calculated_normal * stored_normal) < 0)
+			{
+				// stored normal is opposite to face rientation, so we flip face orientation
+				std::swap(vertex_indices[face_start], vertex_indices[face_start + 1]);
+			}
 		}
 	}
-}
+
+private:
+	const k3d::mesh::points_t& points;
+	k3d::mesh::indices_t& vertex_indices;
+	const k3d::mesh::normals_t& normals;
+};
 
 /// 2-byte integer value to a K-3D color
 k3d::color convert_color_viscam(const k3d::uint16_t Color, const k3d::color& BaseColor)
@@ -251,36 +530,47 @@ public:
 	{
 		Output = k3d::mesh();
 
-		k3d::filesystem::ifstream file(Path);
-		if(!file)
+		const k3d::mapped_file file(Path);
+		if(!file.is_open())
 		{
 			k3d::log() << error << k3d_file_reference << ": error opening [" << Path.native_console_string() << "]" << std::endl;
 			return;
 		}
 		
+		k3d::mesh::points_t corners;
+		k3d::mesh::normals_t corner_normals;
 		k3d::mesh::points_t points;
 		k3d::mesh::counts_t vertex_counts;
 		k3d::mesh::indices_t vertex_indices;
 		k3d::mesh::normals_t face_normals;
-		
-		detail::point_map_t point_map;
+		std::vector<k3d::uint_t> faces;
 		
 		try
 		{
-			if(detail::is_ascii(file))
+			if(detail::is_ascii(file.begin(), file.end()))
 			{
-				detail::get_stl_topology(file, points, vertex_counts, vertex_indices, face_normals, m_threshold.pipeline_value());
-				detail::adjust_orientation(points, vertex_indices, face_normals);
+				detail::read_ascii(file.begin(), file.end(), corners, corner_normals);
+				detail::weld_corners(corners, true, points, vertex_counts, vertex_indices, faces);
+
+				face_normals.resize(faces.size());
+				for(k3d::uint_t f = 0; f != faces.size(); ++f)
+					face_normals[f] = corner_normals[faces[f]];
+
+				k3d::parallel::parallel_for(
+					k3d::parallel::blocked_range<k3d::uint_t>(0, faces.size(), k3d::parallel::grain_size()),
+					detail::adjust_orientation(points, vertex_indices, face_normals));
+
 				k3d::polyhedron::primitive* polyhedron = k3d::polyhedron::create(Output, points, vertex_counts, vertex_indices, static_cast<k3d::imaterial*>(0));
 				if(m_store_normals.pipeline_value())
 					polyhedron->face_attributes.create("N", new k3d::mesh::normals_t(face_normals));
 			}
 			else
 			{
-				const k3d::double_t threshold = m_threshold.pipeline_value();
-				k3d::mesh::colors_t face_colors;
+				if(file.size() < detail::binary_header_size)
+					throw std::runtime_error("unexpected end-of-file");
+
 				binary_stl stl;
-				stl.read(file);
+				std::copy(file.begin(), file.begin() + 80, stl.header);
 				k3d::color base_color(0.8, 0.8, 0.8);
 				k3d::bool_t is_magics = false;
 				if(boost::algorithm::contains(stl.header, "COLOR="))
@@ -294,24 +584,25 @@ public:
 					base_color = k3d::color(static_cast<k3d::double_t>(color[0]/255.), static_cast<k3d::double_t>(color[1]/255.), static_cast<k3d::double_t>(color[2]/255.));
 					is_magics = true;
 				}
-				const k3d::uint_t nfacets = stl.facets.size();
-				vertex_counts.reserve(nfacets);
-				face_normals.reserve(nfacets);
-				face_colors.reserve(nfacets);
-				vertex_indices.reserve(3*nfacets);
+
+				k3d::int32_t nfacets = 0;
+				std::memcpy(&nfacets, file.begin() + 80, sizeof(nfacets));
+				if(nfacets < 0 || file.size() < detail::binary_header_size + static_cast<k3d::uint64_t>(nfacets) * detail::binary_facet_size)
+					throw std::runtime_error("unexpected end-of-file");
+
+				std::vector<k3d::uint16_t> colors(nfacets);
+				corners.resize(3 * nfacets);
+				corner_normals.resize(nfacets);
+				k3d::parallel::parallel_for(
+					k3d::parallel::blocked_range<k3d::uint_t>(0, nfacets, k3d::parallel::grain_size()),
+					detail::decode_binary_facets(file.begin() + detail::binary_header_size, corners, corner_normals, colors));
+
+				detail::weld_corners(corners, false, points, vertex_counts, vertex_indices, faces);
+
+				k3d::mesh::colors_t face_colors(nfacets);
 				for(k3d::uint_t f = 0; f != nfacets; ++f)
-				{
-					vertex_counts.push_back(3);
-					k3d::point3 p0(stl.facets[f].v0[0], stl.facets[f].v0[1], stl.facets[f].v0[2]);
-					k3d::point3 p1(stl.facets[f].v1[0], stl.facets[f].v1[1], stl.facets[f].v1[2]);
-					k3d::point3 p2(stl.facets[f].v2[0], stl.facets[f].v2[1], stl.facets[f].v2[2]);
-					vertex_indices.push_back(detail::add_point(point_map, p0));
-					vertex_indices.push_back(detail::add_point(point_map, p1));
-					vertex_indices.push_back(detail::add_point(point_map, p2));
-					face_normals.push_back(k3d::normal3(stl.facets[f].normal[0], stl.facets[f].normal[1], stl.facets[f].normal[2]));
-					face_colors.push_back(is_magics ? detail::convert_color_magics(stl.facets[f].color, base_color) : detail::convert_color_viscam(stl.facets[f].color, base_color));
-				}
-				detail::fill_points(point_map, points);
+					face_colors[f] = is_magics ? detail::convert_color_magics(colors[f], base_color) : detail::convert_color_viscam(colors[f], base_color);
+
 				k3d::polyhedron::primitive* polyhedron = k3d::polyhedron::create(Output, points, vertex_counts, vertex_indices, static_cast<k3d::imaterial*>(0));
 				polyhedron->face_attributes.create(m_color_array.pipeline_value(), new k3d::mesh::colors_t(face_colors));
 			}
@@ -28,6 +28,7 @@
 #include <k3dsdk/ipipeline_profiler.h>
 #include <k3dsdk/module.h>
 #include <k3dsdk/node.h>
+#include <k3dsdk/parallel/statistics.h>
 
 namespace module
 {
@@ -46,9 +47,14 @@ class pipeline_profiler :
 public:
 	pipeline_profiler(k3d::iplugin_factory& Factory, k3d::idocument& Document) :
 		base(Factory, Document),
-		m_records(init_owner(*this) + init_name("records") + init_label(_("Records")) + init_description(_("Contains records storing the execution time for individual node tasks.")) + init_value(records_t()))
+		m_records(init_owner(*this) + init_name("records") + init_label(_("Records")) + init_description(_("Contains records storing the execution time for individual node tasks.")) + init_value(records_t())),
+		m_parallel_calls(init_owner(*this) + init_name("parallel_calls") + init_label(_("Parallel Calls")) + init_description(_("Contains records storing the number of parallel algorithm calls made by individual node tasks.")) + init_value(records_t())),
+		m_parallel_tasks(init_owner(*this) + init_name("parallel_tasks") + init_label(_("Parallel Tasks")) + init_description(_("Contains records storing the number of parallel tasks executed for individual node tasks.")) + init_value(records_t())),
+		m_parallel_steals(init_owner(*this) + init_name("parallel_steals") + init_label(_("Parallel Steals")) + init_description(_("Contains records storing the number of parallel tasks executed by other threads for individual node tasks.")) + init_value(records_t())),
+		m_parallel_busy_time(init_owner(*this) + init_name("parallel_busy_time") + init_label(_("Parallel Busy Time")) + init_description(_("Contains records storing the time threads spent executing parallel tasks for individual node tasks, summed across threads.")) + init_value(records_t()))
 	{
 		Document.pipeline_profiler().connect_node_execution_signal(sigc::mem_fun(*this, &pipeline_profiler::on_node_execution));
+		Document.pipeline_profiler().connect_node_parallel_signal(sigc::mem_fun(*this, &pipeline_profiler::on_node_parallel));
 		Document.nodes().rename_node_signal().connect(sigc::mem_fun(*this, &pipeline_profiler::on_node_renamed));
 	}
 
@@ -75,7 +81,22 @@ private:
 		// Because we're modifying the internal state of the property by-reference, we have to call the "changed" signal explicitly ...
 		m_records.changed_signal().emit(0);
 	}
-	
+
+	/// Called by the signal system when parallel work statistics arrive
+	void on_node_parallel(k3d::inode& Node, const k3d::string_t& Task, const k3d::parallel::statistics& Statistics)
+	{
+		m_parallel_calls.internal_value()[&Node][Task] = Statistics.calls;
+		m_parallel_tasks.internal_value()[&Node][Task] = Statistics.tasks;
+		m_parallel_steals.internal_value()[&Node][Task] = Statistics.steals;
+		m_parallel_busy_time.internal_value()[&Node][Task] = Statistics.busy_time;
+
+		m_parallel_calls.changed_signal().emit(0);
+		m_parallel_tasks.changed_signal().emit(0);
+		m_parallel_steals.changed_signal().emit(0);
+		m_parallel_busy_time.changed_signal().emit(0);
+	}
+
+
 	/// Called by the signal system anytime a node is renamed
 	void on_node_renamed(k3d::inode*)
 	{
@@ -84,6 +105,11 @@ private:
 	/// Stores profiling events
 	typedef std::map<k3d::inode*, std::map<k3d::string_t, k3d::double_t> > records_t;
 	k3d_data(records_t, immutable_name, change_signal, no_undo, local_storage, no_constraint, read_only_property, no_serialization) m_records;
+	/// Stores parallel work statistics, using the same layout as the timing records
+	k3d_data(records_t, immutable_name, change_signal, no_undo, local_storage, no_constraint, read_only_property, no_serialization) m_parallel_calls;
+	k3d_data(records_t, immutable_name, change_signal, no_undo, local_storage, no_constraint, read_only_property, no_serialization) m_parallel_tasks;
+	k3d_data(records_t, immutable_name, change_signal, no_undo, local_storage, no_constraint, read_only_property, no_serialization) m_parallel_steals;
+	k3d_data(records_t, immutable_name, change_signal, no_undo, local_storage, no_constraint, read_only_property, no_serialization) m_parallel_busy_time;
 };
 
 /////////////////////////////////////////////////////////////////////////////
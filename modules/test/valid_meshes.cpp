@@ -33,6 +33,7 @@
 #include <k3dsdk/document_plugin_factory.h>
 #include <k3dsdk/hints.h>
 #include <k3dsdk/hyperboloid.h>
+#include <k3dsdk/instances.h>
 #include <k3dsdk/linear_curve.h>
 #include <k3dsdk/mesh.h>
 #include <k3dsdk/node.h>
@@ -138,6 +139,10 @@ public:
 						if(hyperboloid)
 							continue;
 
+						boost::scoped_ptr<k3d::instances::const_primitive> instances(k3d::instances::validate(*mesh, **primitive));
+						if(instances)
+							continue;
+
 						boost::scoped_ptr<k3d::linear_curve::const_primitive> linear_curve(k3d::linear_curve::validate(*mesh, **primitive));
 						if(linear_curve)
 							continue;
@@ -49,6 +49,7 @@ using namespace k3d::xml;
 #include <boost/format.hpp>
 #include <boost/regex.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <ctime>
 #include <iostream>
@@ -66,6 +67,8 @@ bool g_show_process = true;
 bool g_syslog = false;
 bool g_color_level = true;
 k3d::log_level_t g_minimum_log_level = k3d::K3D_LOG_LEVEL_DEBUG;
+/// Set to true when the caller (e.g. k3d-renderjob) has already claimed the frame by marking it "running"
+bool g_claimed = false;
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // expand
@@ -319,23 +322,36 @@ bool render_frame(const k3d::filesystem::path& FrameDirectory)
 	if(k3d::filesystem::exists(FrameDirectory / k3d::filesystem::generic_path("error")))
 		return true;
 
-	// Skip the frame if it's running ...
-	if(k3d::filesystem::exists(FrameDirectory / k3d::filesystem::generic_path("running")))
-		return true;
-
-	// Make sure the frame is ready ...
-	if(!k3d::filesystem::exists(FrameDirectory / k3d::filesystem::generic_path("ready")))
+	if(g_claimed)
 	{
-		k3d::log() << error << "Frame " << FrameDirectory.native_console_string() << " is not ready" << std::endl;
-		return false;
+		// Make sure our caller actually claimed the frame ...
+		if(!k3d::filesystem::exists(FrameDirectory / k3d::filesystem::generic_path("running")))
+		{
+			k3d::log() << error << "Frame " << FrameDirectory.native_console_string() << " has not been claimed" << std::endl;
+			return false;
+		}
+	}
+	else
+	{
+		// Skip the frame if it's running ...
+		if(k3d::filesystem::exists(FrameDirectory / k3d::filesystem::generic_path("running")))
+			return true;
+
+		// Make sure the frame is ready ...
+		if(!k3d::filesystem::exists(FrameDirectory / k3d::filesystem::generic_path("ready")))
+		{
+			k3d::log() << error << "Frame " << FrameDirectory.native_console_string() << " is not ready" << std::endl;
+			return false;
+		}
+
+		// Switch the frame status to running, skipping the frame if another process beat us to it ...
+		if(!k3d::filesystem::rename(FrameDirectory / k3d::filesystem::generic_path("ready"), FrameDirectory / k3d::filesystem::generic_path("running")))
+			return true;
 	}
 
 	// Standard logging ...
 	k3d::log() << info << "Starting Frame " << FrameDirectory.native_console_string() << std::endl;
 
-	// Switch the frame status to running ...
-	k3d::filesystem::rename(FrameDirectory / k3d::filesystem::generic_path("ready"), FrameDirectory / k3d::filesystem::generic_path("running"));
-
 	// Load the frame options file ...
 	element xml_frame_options("empty");
 	const k3d::filesystem::path control_file_path = FrameDirectory / k3d::filesystem::generic_path("control.k3d");
@@ -385,6 +401,7 @@ void usage(const k3d::string_t& Name, std::ostream& Stream)
 	Stream << std::endl;
 	Stream << "  -h, --help               prints this help information and exits" << std::endl;
 	Stream << "      --version            prints program version information and exits" << std::endl;
+	Stream << "      --claimed            renders frames that the caller has already marked as running" << std::endl;
 	Stream << std::endl;
 }
 
@@ -449,6 +466,13 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
+	// Look for frames that have been claimed by our caller ...
+	if(std::count(options.begin(), options.end(), "--claimed"))
+	{
+		detail::g_claimed = true;
+		options.erase(std::remove(options.begin(), options.end(), "--claimed"), options.end());
+	}
+
 	// Setup logging right away ...
 	detail::setup_logging(program_name);
 
@@ -25,13 +25,24 @@
 #include <k3d-platform-config.h>
 #include <k3d-version-config.h>
 
+#include <k3dsdk/high_res_timer.h>
 #include <k3dsdk/log.h>
 #include <k3dsdk/log_control.h>
 #include <k3dsdk/path.h>
+#include <k3dsdk/string_cast.h>
 #include <k3dsdk/system.h>
 #include <k3dsdk/utility.h>
 
+#ifdef K3D_API_WIN32
+	#include <k3dsdk/win32.h>
+#else // K3D_API_WIN32
+	#include <unistd.h>
+#endif // !K3D_API_WIN32
+
+#include <glibmm/thread.h>
+
 #include <algorithm>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 
@@ -46,6 +57,125 @@ bool g_syslog = false;
 bool g_color_level = false;
 k3d::log_level_t g_minimum_log_level = k3d::K3D_LOG_LEVEL_DEBUG;
 
+/// Stores the number of frames to be rendered simultaneously, or zero to use one frame per hardware thread
+unsigned long g_jobs = 0;
+
+/////////////////////////////////////////////////////////////////////////////
+// hardware_thread_count
+
+/// Returns the number of hardware threads available for rendering
+unsigned long hardware_thread_count()
+{
+#ifdef K3D_API_WIN32
+	SYSTEM_INFO system_info;
+	GetSystemInfo(&system_info);
+	return std::max(1UL, static_cast<unsigned long>(system_info.dwNumberOfProcessors));
+#else // K3D_API_WIN32
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+#endif // !K3D_API_WIN32
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// frame_result
+
+/// Records the outcome of rendering one frame
+struct frame_result
+{
+	frame_result(const k3d::filesystem::path& Frame, const double WallTime, const bool Succeeded) :
+		frame(Frame),
+		wall_time(WallTime),
+		succeeded(Succeeded)
+	{
+	}
+
+	k3d::filesystem::path frame;
+	double wall_time;
+	bool succeeded;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// frame_scheduler
+
+/// Renders the frames in a job using a pool of worker threads.  Each worker claims a frame by renaming its
+/// "ready" file to "running", which is atomic, so multiple k3d-renderjob processes can safely share a job.
+/// Note that k3d::log() isn't thread-safe, so all logging from workers is serialized by m_mutex.
+class frame_scheduler
+{
+public:
+	frame_scheduler(const std::vector<k3d::filesystem::path>& Frames) :
+		m_frames(Frames),
+		m_next_frame(0)
+	{
+	}
+
+	/// Renders every frame that can be claimed using the given number of workers, blocking until they are finished
+	void run(const unsigned long WorkerCount)
+	{
+		std::vector<Glib::Thread*> workers;
+		for(unsigned long i = 0; i < WorkerCount; ++i)
+			workers.push_back(Glib::Thread::create(sigc::mem_fun(*this, &frame_scheduler::worker), true));
+
+		for(unsigned long i = 0; i != workers.size(); ++i)
+			workers[i]->join();
+	}
+
+	/// Returns the outcome of every frame rendered by this process, in the order they completed
+	const std::vector<frame_result>& results() const
+	{
+		return m_results;
+	}
+
+private:
+	/// Returns the next frame that hasn't been visited by a worker, or an empty path when all frames have been visited
+	const k3d::filesystem::path next_frame()
+	{
+		Glib::Mutex::Lock lock(m_mutex);
+
+		if(m_next_frame == m_frames.size())
+			return k3d::filesystem::path();
+
+		return m_frames[m_next_frame++];
+	}
+
+	/// Executes within the context of a worker thread, rendering frames until none remain
+	void worker()
+	{
+		for(k3d::filesystem::path frame = next_frame(); !frame.empty(); frame = next_frame())
+		{
+			// Claim the frame, skipping it if it isn't ready or another worker / process got there first ...
+			if(!k3d::filesystem::rename(frame / k3d::filesystem::generic_path("ready"), frame / k3d::filesystem::generic_path("running")))
+				continue;
+
+			const std::string commandline("k3d-renderframe --claimed \"" + frame.native_filesystem_string() + "\"");
+
+			{
+				Glib::Mutex::Lock lock(m_mutex);
+				k3d::log() << info << "Starting Frame " << frame.native_console_string() << std::endl;
+			}
+
+			// Use the non-logging spawn_sync(), since logging must be serialized ...
+			k3d::timer timer;
+			int exit_status = 0;
+			std::string error_message;
+			const bool spawned = k3d::system::spawn_sync(commandline, exit_status, error_message);
+			const bool succeeded = spawned && 0 == exit_status;
+			const double wall_time = timer.elapsed();
+
+			Glib::Mutex::Lock lock(m_mutex);
+			if(!spawned)
+				k3d::log() << error << "Error starting Frame " << frame.native_console_string() << ": " << error_message << std::endl;
+			k3d::log() << info << "Finished Frame " << frame.native_console_string() << " in " << wall_time << " seconds" << std::endl;
+			m_results.push_back(frame_result(frame, wall_time, succeeded));
+		}
+	}
+
+	const std::vector<k3d::filesystem::path>& m_frames;
+	unsigned long m_next_frame;
+	std::vector<frame_result> m_results;
+	Glib::Mutex m_mutex;
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // render_job
 
@@ -72,12 +202,12 @@ bool render_job(const k3d::filesystem::path& JobDirectory)
 	if(k3d::filesystem::exists(JobDirectory / k3d::filesystem::generic_path("error")))
 		return true;
 
-	// Skip the job if it's running ...
-	if(k3d::filesystem::exists(JobDirectory / k3d::filesystem::generic_path("running")))
-		return true;
-
-	// Make sure the job is ready ...
-	if(!k3d::filesystem::exists(JobDirectory / k3d::filesystem::generic_path("ready")))
+	// Switch the job status to running, unless another process is already running it, in which case we help out ...
+	if(k3d::filesystem::exists(JobDirectory / k3d::filesystem::generic_path("ready")))
+	{
+		k3d::filesystem::rename(JobDirectory / k3d::filesystem::generic_path("ready"), JobDirectory / k3d::filesystem::generic_path("running"));
+	}
+	else if(!k3d::filesystem::exists(JobDirectory / k3d::filesystem::generic_path("running")))
 	{
 		k3d::log() << error << "Job " << JobDirectory.native_console_string() << " is not ready" << std::endl;
 		return false;
@@ -86,17 +216,45 @@ bool render_job(const k3d::filesystem::path& JobDirectory)
 	// Standard logging ...
 	k3d::log() << info << "Starting Job " << JobDirectory.native_console_string() << std::endl;
 
-	// Switch the job status to running ...
-	k3d::filesystem::rename(JobDirectory / k3d::filesystem::generic_path("ready"), JobDirectory / k3d::filesystem::generic_path("running"));
-
-	// For each directory in the job directory (non-recursive) ...
+	// Collect each directory in the job directory (non-recursive) ...
+	std::vector<k3d::filesystem::path> frames;
 	for(k3d::filesystem::directory_iterator frame(JobDirectory); frame != k3d::filesystem::directory_iterator(); ++frame)
 	{
 		if(!k3d::filesystem::is_directory(*frame))
 			continue;
 
-		const std::string commandline("k3d-renderframe \"" + frame->native_filesystem_string() + "\"");
-		k3d::system::spawn_sync(commandline);
+		frames.push_back(*frame);
+	}
+	std::sort(frames.begin(), frames.end());
+
+	// Render frames in parallel ...
+	const unsigned long worker_count = std::max(1UL, std::min(g_jobs ? g_jobs : hardware_thread_count(), static_cast<unsigned long>(frames.size())));
+	k3d::log() << info << "Rendering " << frames.size() << " frames using " << worker_count << " workers" << std::endl;
+
+	k3d::timer job_timer;
+	frame_scheduler scheduler(frames);
+	scheduler.run(worker_count);
+	const double job_time = job_timer.elapsed();
+
+	// Report timing for the frames we rendered ...
+	const std::vector<frame_result>& results = scheduler.results();
+	unsigned long failures = 0;
+	for(std::vector<frame_result>::const_iterator result = results.begin(); result != results.end(); ++result)
+	{
+		k3d::log() << info << "Frame " << result->frame.native_console_string() << ": " << std::fixed << std::setprecision(2) << result->wall_time << " seconds" << (result->succeeded ? "" : " (failed)") << std::endl;
+		if(!result->succeeded)
+			++failures;
+	}
+	k3d::log() << info << "Rendered " << results.size() << " frames (" << failures << " failed) in " << std::fixed << std::setprecision(2) << job_time << " seconds, " << (job_time > 0 ? results.size() * 3600.0 / job_time : 0.0) << " frames per hour" << std::endl;
+
+	// If another process is still rendering frames, leave it to mark the job complete ...
+	for(std::vector<k3d::filesystem::path>::const_iterator frame = frames.begin(); frame != frames.end(); ++frame)
+	{
+		if(k3d::filesystem::exists(*frame / k3d::filesystem::generic_path("ready")) || k3d::filesystem::exists(*frame / k3d::filesystem::generic_path("running")))
+		{
+			k3d::log() << info << "Job " << JobDirectory.native_console_string() << " still has frames rendering in other processes" << std::endl;
+			return true;
+		}
 	}
 
 	// Switch the job status to complete ...
@@ -119,6 +277,7 @@ void usage(const std::string& Name, std::ostream& Stream)
 	Stream << std::endl;
 	Stream << "  -h, --help               prints this help information and exits" << std::endl;
 	Stream << "      --version            prints program version information and exits" << std::endl;
+	Stream << "  -j, --jobs [count]       renders [count] frames at a time (defaults to the number of hardware threads)" << std::endl;
 	Stream << std::endl;
 }
 
@@ -182,6 +341,25 @@ int main(int argc, char* argv[])
 		return 0;
 	}
 
+	// Extract the number of simultaneous frames ...
+	for(detail::string_array::iterator option = options.begin(); option != options.end(); )
+	{
+		if((*option == "-j" || *option == "--jobs") && option + 1 != options.end())
+		{
+			detail::g_jobs = k3d::from_string<unsigned long>(*(option + 1), 0);
+			option = options.erase(option, option + 2);
+		}
+		else if(0 == option->find("--jobs="))
+		{
+			detail::g_jobs = k3d::from_string<unsigned long>(option->substr(7), 0);
+			option = options.erase(option);
+		}
+		else
+		{
+			++option;
+		}
+	}
+
 	// Otherwise we should have a minimum of one argument ...
 	if(options.size() < 1)
 	{
@@ -192,6 +370,10 @@ int main(int argc, char* argv[])
 	// Setup logging right away ...
 	detail::setup_logging(program_name);
 
+	// Setup threads for rendering frames in parallel ...
+	if(!Glib::thread_supported())
+		Glib::thread_init();
+
 	// Each remaining argument should be a job path to render ...
 	int result = 0;
 	for(unsigned long j = 0; j < options.size(); j++)
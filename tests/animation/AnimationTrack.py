@@ -32,3 +32,14 @@ reference = k3d.point3(1, 0, 0)
 
 if position != reference:
   raise Exception("Position differs from expected value, expected: " + str(reference) + ", result: " + str(position))
+
+# Editing a key must update the output ...
+for property in track.properties():
+  if property.name().startswith("key_time_") and property.internal_value() == 4.0:
+    track.get_property(property.name().replace("key_time_", "key_value_")).set_value(k3d.translate3(4, 0, 0))
+
+position = k3d.world_position(instance)
+reference = k3d.point3(2, 0, 0)
+
+if position != reference:
+  raise Exception("Position differs from expected value after editing a key, expected: " + str(reference) + ", result: " + str(position))
@@ -0,0 +1,34 @@
+#python
+
+import k3d
+
+document = k3d.new_document()
+
+track = k3d.plugin.create("AnimationTrackDoubleDouble", document)
+interpolator = k3d.plugin.create("InterpolatorDoubleDoubleLinear", document)
+track.interpolator = interpolator
+
+# Keys are created out-of-order, so the track has to sort them ...
+for (time, value) in [(3.0, -2.0), (0.0, 0.0), (6.0, 5.0), (1.0, 3.0)]:
+  track.time_input = time
+  track.value_input = value
+  track.keyframe()
+
+# Times outside the keys fall back to the input value ...
+track.value_input = 100.0
+
+# Sampling a range must match evaluating the track one time at a time ...
+start = -1.0
+step = 0.25
+count = 33
+samples = track.sample(start, step, count)
+
+if len(samples) != count:
+  raise Exception("expected " + str(count) + " samples, got " + str(len(samples)))
+
+for i in range(count):
+  time = start + step * i
+  track.time_input = time
+  reference = track.output_value
+  if abs(samples[i] - reference) > 1e-9:
+    raise Exception("Sample differs from evaluated value at time " + str(time) + ", expected: " + str(reference) + ", result: " + str(samples[i]))
@@ -0,0 +1,72 @@
+#python
+
+import k3d
+import testing
+
+doc = k3d.new_document()
+first = k3d.plugin.create("DoubleSourceScript", doc)
+second = k3d.plugin.create("DoubleSourceScript", doc)
+
+def test_output(source, expected):
+	if source.output_double != expected:
+		raise Exception("unexpected output_double: " + str(source.output_double) + " expected: " + str(expected))
+
+# Nodes with the same script share its compiled code, but each keeps its own results ...
+script = "#python\n\ncontext.output = 2.0\n"
+first.script = script
+second.script = script
+test_output(first, 2.0)
+test_output(second, 2.0)
+
+# Editing a script recompiles it ...
+first.script = "#python\n\ncontext.output = 3.0\n"
+test_output(first, 3.0)
+test_output(second, 2.0)
+
+# Returning to a previous script reuses its code ...
+first.script = script
+test_output(first, 2.0)
+
+# DOS line-endings ...
+second.script = "#python\r\n\r\ncontext.output = 4.0\r\n"
+test_output(second, 4.0)
+
+# Names added to __main__ after a node is created are visible to its script ...
+import __main__
+__main__.cache_test_value = 5.0
+first.script = "#python\n\ncontext.output = cache_test_value\n"
+test_output(first, 5.0)
+
+# Names added to __main__ after a script has run are visible to it, too ...
+__main__.cache_test_value = 6.0
+second.script = "#python\n\ncontext.output = cache_test_value\n"
+test_output(second, 6.0)
+__main__.cache_test_value = 7.0
+first.script = "#python\n\ncontext.output = cache_test_value + 0.0\n"
+test_output(first, 7.0)
+
+# Scripts that don't compile produce the default output ...
+first.script = "#python\n\ncontext.output = \n"
+test_output(first, 0.0)
+
+# Repeated evaluations of a script compile it once ...
+third = k3d.plugin.create("DoubleSourceScript", doc)
+third.name = "cache_test_third"
+k3d.property.create(third, "k3d::double_t", "scale", "Scale", "Scale")
+third.scale = 1.0
+third.script = "#python\n\ncontext.output = 8.0 * context.node.scale\n"
+test_output(third, 8.0)
+
+profiler = k3d.plugin.create("PipelineProfiler", doc)
+for scale in [2.0, 3.0, 4.0]:
+	third.scale = scale
+	test_output(third, 8.0 * scale)
+
+tasks = []
+for (node, timing) in profiler.records.items():
+	if node.name == third.name:
+		tasks = timing.keys()
+if "Execute Script" not in tasks:
+	raise Exception("script evaluations weren't profiled")
+if "Compile Script" in tasks:
+	raise Exception("script was recompiled: " + str(tasks))
@@ -0,0 +1,44 @@
+#python
+
+import k3d
+import testing
+
+def create_chain(document, input):
+	twist = k3d.plugin.create("TwistPoints", document)
+	taper = k3d.plugin.create("TaperPoints", document)
+	bend = k3d.plugin.create("BendPoints", document)
+
+	twist.angle = 0.5
+	taper.taper_factor = 0.25
+	bend.angle = 0.75
+
+	selection = k3d.geometry.selection.create(0)
+	point_selection = k3d.geometry.point_selection.create(selection)
+	k3d.geometry.point_selection.append(point_selection, 0, 50, 1)
+	k3d.geometry.point_selection.append(point_selection, 50, 100, 0.5)
+	taper.mesh_selection = selection
+
+	k3d.property.connect(document, input, twist.get_property("input_mesh"))
+	k3d.property.connect(document, twist.get_property("output_mesh"), taper.get_property("input_mesh"))
+	k3d.property.connect(document, taper.get_property("output_mesh"), bend.get_property("input_mesh"))
+
+	return bend
+
+document = k3d.new_document()
+
+source = k3d.plugin.create("PolyCube", document)
+source.rows = 5
+source.columns = 5
+source.slices = 5
+
+reference = create_chain(document, source.get_property("output_mesh"))
+fused = create_chain(document, source.get_property("output_mesh"))
+fused.fuse_deformations = True
+
+testing.require_valid_mesh(document, fused.get_property("output_mesh"))
+
+result = k3d.difference.accumulator()
+k3d.difference.test(reference.output_mesh, fused.output_mesh, result)
+if result.exact_min() != True or result.ulps_max() > 0:
+	raise Exception("fused deformations differ from unfused deformations")
+
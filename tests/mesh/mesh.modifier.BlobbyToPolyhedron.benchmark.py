@@ -0,0 +1,36 @@
+#python
+
+import k3d
+import testing
+
+# Polygonize 10k overlapping ellipsoids, one at each point of a 100 x 100 grid ...
+document = k3d.new_document()
+
+source = k3d.plugin.create("PolyGrid", document)
+source.columns = 99
+source.rows = 99
+source.width = 99
+source.height = 99
+
+points = k3d.plugin.create("PointsToBlobby", document)
+points.radius = 0.7
+k3d.property.connect(document, source.get_property("output_mesh"), points.get_property("input_mesh"))
+
+polygonize = k3d.plugin.create("BlobbyToPolyhedron", document)
+k3d.property.connect(document, points.get_property("output_mesh"), polygonize.get_property("input_mesh"))
+
+profiler = k3d.plugin.create("PipelineProfiler", document)
+
+testing.require_valid_mesh(document, polygonize.get_property("output_mesh"))
+if len(polygonize.output_mesh.points()) == 0:
+	raise Exception("BlobbyToPolyhedron produced an empty mesh")
+
+for (node, timing) in profiler.records.items():
+	if node.name != polygonize.name:
+		continue
+	total = 0.0
+	for t in timing:
+		total += timing[t]
+	print """<DartMeasurement name="BlobbyToPolyhedron 10k" type="numeric/float">""" + str(total) + """</DartMeasurement>"""
+
+k3d.close_document(document)
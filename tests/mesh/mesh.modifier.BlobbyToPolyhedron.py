@@ -0,0 +1,22 @@
+#python
+
+import k3d
+import testing
+
+setup = testing.setup_mesh_modifier_test("BlobbyEllipsoid", "BlobbyToPolyhedron")
+setup.modifier.resolution = 16
+
+testing.require_valid_mesh(setup.document, setup.modifier.get_property("output_mesh"))
+
+mesh = setup.modifier.output_mesh
+if len(mesh.primitives()) != 1:
+	raise Exception("expected one polyhedron")
+if not k3d.polyhedron.is_solid(k3d.polyhedron.validate(mesh, mesh.primitives()[0])):
+	raise Exception("expected a closed surface")
+
+# A lone unit ellipsoid reaches the 0.5 threshold at a radius of about 0.454 ...
+for point in mesh.points():
+	radius = k3d.length(k3d.to_vector3(point))
+	if radius < 0.42 or radius > 0.47:
+		raise Exception("point " + str(point) + " is too far from the surface")
+
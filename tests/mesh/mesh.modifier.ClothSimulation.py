@@ -0,0 +1,52 @@
+#python
+
+import k3d
+import testing
+
+setup = testing.setup_mesh_modifier_test("PolyGrid", "ClothSimulation")
+
+setup.source.rows = 5
+setup.source.columns = 5
+
+# Pin the first row of points ...
+selection = k3d.selection.set()
+point_selection = k3d.geometry.point_selection.create(selection)
+k3d.geometry.point_selection.append(point_selection, 0, 6, 1)
+setup.modifier.mesh_selection = selection
+
+input_points = [k3d.point3(point[0], point[1], point[2]) for point in setup.source.output_mesh.points()]
+
+def positions(time):
+	setup.modifier.time = time
+	return [k3d.point3(point[0], point[1], point[2]) for point in setup.modifier.output_mesh.points()]
+
+testing.require_valid_mesh(setup.document, setup.modifier.get_property("output_mesh"))
+
+if positions(0.0) != input_points:
+	raise Exception("frame zero should match the input points")
+
+later = positions(1.0)
+for point in range(6):
+	if later[point] != input_points[point]:
+		raise Exception("pinned point " + str(point) + " moved")
+for point in range(6, len(input_points)):
+	if not later[point][2] < input_points[point][2]:
+		raise Exception("free point " + str(point) + " didn't fall")
+
+# Revisiting cached frames must return identical results ...
+positions(0.5)
+if positions(1.0) != later:
+	raise Exception("revisiting a frame changed the simulation")
+
+# Revisiting frames between sparse checkpoints must also return identical results ...
+setup.modifier.checkpoints = 2
+later = positions(1.0)
+positions(0.25)
+if positions(1.0) != later:
+	raise Exception("revisiting a frame between checkpoints changed the simulation")
+
+# Changing parameters restarts the simulation ...
+setup.modifier.gravity = 0.0
+if positions(1.0) != input_points:
+	raise Exception("simulation without gravity should remain at rest")
+
@@ -0,0 +1,53 @@
+#python
+
+import k3d
+import testing
+
+def create_chain(document, input):
+	expression = k3d.plugin.create("DeformationExpression", document)
+	wave = k3d.plugin.create("CylindricalWavePoints", document)
+	translate = k3d.plugin.create("TranslatePoints", document)
+	twist = k3d.plugin.create("TwistPoints", document)
+	scale = k3d.plugin.create("ScalePoints", document)
+
+	# Only some points are selected, so the expression leaves the rest untouched ...
+	selection = k3d.geometry.selection.create(0)
+	point_selection = k3d.geometry.point_selection.create(selection)
+	k3d.geometry.point_selection.append(point_selection, 0, 50, 1)
+	expression.mesh_selection = selection
+
+	# A zero wavelength makes the wave return without modifying any points ...
+	wave.wavelength = 0
+
+	translate.x = 0.25
+	twist.angle = 0.5
+	scale.y = 1.5
+
+	# The wave and translation form one run of point-local deformations, and the twist (which needs the mesh bounds) separates it from the scaling ...
+
+	k3d.property.connect(document, input, expression.get_property("input_mesh"))
+	k3d.property.connect(document, expression.get_property("output_mesh"), wave.get_property("input_mesh"))
+	k3d.property.connect(document, wave.get_property("output_mesh"), translate.get_property("input_mesh"))
+	k3d.property.connect(document, translate.get_property("output_mesh"), twist.get_property("input_mesh"))
+	k3d.property.connect(document, twist.get_property("output_mesh"), scale.get_property("input_mesh"))
+
+	return scale
+
+document = k3d.new_document()
+
+source = k3d.plugin.create("PolyCube", document)
+source.rows = 5
+source.columns = 5
+source.slices = 5
+
+reference = create_chain(document, source.get_property("output_mesh"))
+fused = create_chain(document, source.get_property("output_mesh"))
+fused.fuse_deformations = True
+
+testing.require_valid_mesh(document, fused.get_property("output_mesh"))
+
+result = k3d.difference.accumulator()
+k3d.difference.test(reference.output_mesh, fused.output_mesh, result)
+if result.exact_min() != True or result.ulps_max() > 0:
+	raise Exception("fused deformations differ from unfused deformations")
+
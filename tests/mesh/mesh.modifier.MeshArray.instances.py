@@ -0,0 +1,65 @@
+#python
+
+import k3d
+import testing
+
+def create_arrays(document, input, instancing):
+	array_2d = k3d.plugin.create("MeshArray2D", document)
+	array_2d.layout = k3d.plugin.create("TranslateArray2D", document)
+	array_2d.instancing = instancing
+
+	array_1d = k3d.plugin.create("MeshArray1D", document)
+	array_1d.layout = k3d.plugin.create("TranslateArray1D", document)
+	array_1d.layout.offset = k3d.vector3(0, 0, 7)
+	array_1d.instancing = instancing
+
+	k3d.property.connect(document, input, array_2d.get_property("input_mesh"))
+	k3d.property.connect(document, array_2d.get_property("output_mesh"), array_1d.get_property("input_mesh"))
+
+	return array_1d
+
+document = k3d.new_document()
+
+source = k3d.plugin.create("PolyCube", document)
+
+copies = create_arrays(document, source.get_property("output_mesh"), False)
+instances = create_arrays(document, source.get_property("output_mesh"), True)
+
+testing.require_valid_mesh(document, instances.get_property("output_mesh"))
+
+# Downstream modifiers receive the instances as explicit geometry ...
+transform = k3d.plugin.create("TransformPoints", document)
+k3d.property.connect(document, instances.get_property("output_mesh"), transform.get_property("input_mesh"))
+
+testing.require_valid_mesh(document, transform.get_property("output_mesh"))
+
+result = k3d.difference.accumulator()
+k3d.difference.test(copies.output_mesh, transform.output_mesh, result)
+if result.exact_min() != True or result.ulps_max() > 4:
+	raise Exception("flattened instances differ from mesh copies")
+
+# Consumers that aren't mesh modifiers flatten instances, too ...
+def require_same_output(plugin_name, create_input):
+	reference_node = k3d.plugin.create(plugin_name, document)
+	instances_node = k3d.plugin.create(plugin_name, document)
+	create_input(reference_node, copies)
+	create_input(instances_node, instances)
+
+	testing.require_valid_mesh(document, instances_node.get_property("output_mesh"))
+
+	result = k3d.difference.accumulator()
+	k3d.difference.test(reference_node.output_mesh, instances_node.output_mesh, result)
+	if result.exact_min() != True or result.ulps_max() > 4:
+		raise Exception(plugin_name + " output differs for instances and mesh copies")
+
+def connect_merge_inputs(merge, array):
+	k3d.property.create(merge, "k3d::mesh*", "input_mesh1", "Input Mesh 1", "")
+	k3d.property.create(merge, "k3d::mesh*", "input_mesh2", "Input Mesh 2", "")
+	k3d.property.connect(document, array.get_property("output_mesh"), merge.get_property("input_mesh1"))
+	k3d.property.connect(document, source.get_property("output_mesh"), merge.get_property("input_mesh2"))
+
+def connect_selection_input(selection, array):
+	k3d.property.connect(document, array.get_property("output_mesh"), selection.get_property("input_mesh"))
+
+require_same_output("MergeMesh", connect_merge_inputs)
+require_same_output("SelectNSided", connect_selection_input)
@@ -0,0 +1,72 @@
+#python
+
+import k3d
+import testing
+
+setup = testing.setup_mesh_modifier_test("NurbsSphere","NurbsPolygonizePatch")
+setup.modifier.mesh_selection = k3d.geometry.selection.create(1)
+setup.modifier.adaptive = True
+setup.modifier.tolerance = 0.1
+
+testing.require_valid_mesh(setup.document, setup.modifier.get_property("output_mesh"))
+
+coarse_face_count = len(k3d.polyhedron.validate(setup.modifier.output_mesh, setup.modifier.output_mesh.primitives()[0]).face_shells())
+
+setup.modifier.tolerance = 0.01
+testing.require_valid_mesh(setup.document, setup.modifier.get_property("output_mesh"))
+
+mesh = setup.modifier.output_mesh
+fine_face_count = len(k3d.polyhedron.validate(mesh, mesh.primitives()[0]).face_shells())
+if fine_face_count <= coarse_face_count:
+	raise Exception("a smaller tolerance should produce more polygons")
+
+# Every sample lies on the sphere ...
+for point in mesh.points():
+	radius = k3d.length(k3d.to_vector3(point))
+	if abs(radius - 5.0) > 1e-6:
+		raise Exception("point " + str(point) + " is not on the surface")
+
+
+# Patches that share a boundary must sample it at the same points, so the polygons don't crack ...
+document = k3d.new_document()
+source = k3d.plugin.create("NurbsSphere", document)
+split = k3d.plugin.create("NurbsSplitPatch", document)
+split.mesh_selection = k3d.geometry.selection.create(1)
+split.u_value = 0.3
+split.insert_to_v = False
+k3d.property.connect(document, source.get_property("output_mesh"), split.get_property("input_mesh"))
+
+polygonize = k3d.plugin.create("NurbsPolygonizePatch", document)
+polygonize.mesh_selection = k3d.geometry.selection.create(1)
+polygonize.adaptive = True
+polygonize.tolerance = 0.01
+k3d.property.connect(document, split.get_property("output_mesh"), polygonize.get_property("input_mesh"))
+
+split_mesh = split.output_mesh
+if len(k3d.nurbs_patch.validate(split_mesh, split_mesh.primitives()[0]).patch_first_points()) != 2:
+	raise Exception("expected two patches")
+
+testing.require_valid_mesh(document, polygonize.get_property("output_mesh"))
+
+mesh = polygonize.output_mesh
+polyhedron = k3d.polyhedron.validate(mesh, mesh.primitives()[0])
+points = mesh.points()
+vertex_points = polyhedron.vertex_points()
+clockwise_edges = polyhedron.clockwise_edges()
+
+def position(point):
+	return (round(point[0], 6), round(point[1], 6), round(point[2], 6))
+
+# Every edge of the closed surface, matched by the positions of its endpoints, has to be used by more than one polygon ...
+edge_counts = {}
+for edge in range(len(clockwise_edges)):
+	start = position(points[vertex_points[edge]])
+	end = position(points[vertex_points[clockwise_edges[edge]]])
+	if start == end:
+		continue
+	key = (min(start, end), max(start, end))
+	edge_counts[key] = edge_counts.get(key, 0) + 1
+
+for (edge, count) in edge_counts.items():
+	if count < 2:
+		raise Exception("edge " + str(edge) + " isn't shared, so the patches don't meet at the same vertices")
@@ -0,0 +1,45 @@
+#python
+
+import k3d
+import testing
+import benchmarking
+
+# Measure the grid algorithm on roughly 10k, 100k, and 1M points, half of which are duplicates
+# that must be welded.  Brute force is quadratic, so it's only measured on the smallest case
+# for comparison - beyond that it would dominate the test run.
+for (size, columns) in [("10k", 70), ("100k", 223), ("1M", 706)]:
+	for algorithm in ["grid", "brute_force"]:
+		if algorithm == "brute_force" and size != "10k":
+			continue
+
+		document = k3d.new_document()
+
+		source = k3d.plugin.create("PolyGrid", document)
+		source.columns = columns
+		source.rows = columns
+
+		merge = k3d.plugin.create("MergeMesh", document)
+		k3d.property.create(merge, "k3d::mesh*", "input_mesh1", "Input Mesh 1", "")
+		k3d.property.create(merge, "k3d::mesh*", "input_mesh2", "Input Mesh 2", "")
+		k3d.property.connect(document, source.get_property("output_mesh"), merge.get_property("input_mesh1"))
+		k3d.property.connect(document, source.get_property("output_mesh"), merge.get_property("input_mesh2"))
+
+		weld = k3d.plugin.create("WeldPoints", document)
+		weld.algorithm = algorithm
+		k3d.property.connect(document, merge.get_property("output_mesh"), weld.get_property("input_mesh"))
+
+		profiler = k3d.plugin.create("PipelineProfiler", document)
+
+		testing.require_valid_mesh(document, weld.get_property("output_mesh"))
+		if len(weld.output_mesh.points()) != (columns + 1) * (columns + 1):
+			raise Exception("WeldPoints " + algorithm + " produced an incorrect point count")
+
+		for (node, timing) in profiler.records.items():
+			if node.name != weld.name:
+				continue
+			total = 0.0
+			for t in timing:
+				total += timing[t]
+			print """<DartMeasurement name="WeldPoints """ + algorithm + " " + size + """" type="numeric/float">""" + str(total) + """</DartMeasurement>"""
+
+		k3d.close_document(document)
@@ -0,0 +1,23 @@
+#python
+
+import k3d
+import testing
+
+setup = testing.setup_mesh_writer_test(["PolyCube", "AddIndexAttributes", "K3DMeshWriter"], "K3DMeshReader", "mesh.sink.K3DMeshWriter.binary.k3d")
+
+# Use enough points, faces, and attributes that every numeric array is stored in binary ...
+setup.source.rows = 5
+setup.source.columns = 5
+setup.source.slices = 5
+setup.writer.array_encoding = "compressed_binary"
+
+testing.require_valid_mesh(setup.document, setup.reader.get_property("output_mesh"))
+
+if len(setup.reader.output_mesh.points()) != len(setup.modifier.output_mesh.points()):
+	raise Exception("incorrect point count")
+
+result = k3d.difference.accumulator()
+k3d.difference.test(setup.modifier.output_mesh, setup.reader.output_mesh, result)
+if result.exact_min() != True or result.ulps_max() > 0:
+	raise Exception("binary arrays didn't round-trip exactly")
+
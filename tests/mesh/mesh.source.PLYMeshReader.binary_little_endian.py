@@ -0,0 +1,9 @@
+#python
+
+import testing
+
+setup = testing.setup_mesh_reader_test("PLYMeshReader", "mesh.source.PLYMeshReader.binary_little_endian.ply")
+
+testing.require_valid_mesh(setup.document, setup.source.get_property("output_mesh"))
+testing.require_similar_mesh(setup.document, setup.source.get_property("output_mesh"), "mesh.source.PLYMeshReader", 1)
+
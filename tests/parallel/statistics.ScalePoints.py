@@ -0,0 +1,32 @@
+#python
+
+import k3d
+import testing
+
+# Create a mesh source and our test modifier ...
+setup = testing.setup_mesh_modifier_test("PolyGrid", "ScalePoints")
+setup.source.rows = 100
+setup.source.columns = 100
+
+selection = k3d.geometry.selection.create(0)
+selection.points = k3d.geometry.point_selection.create(selection, 1)
+setup.modifier.mesh_selection = selection
+
+profiler = k3d.plugin.create("PipelineProfiler", setup.document)
+
+k3d.parallel.set_thread_count(2)
+setup.modifier.x = 2.0
+mesh = setup.modifier.output_mesh
+
+# The profiler should report the parallel work performed while updating the modifier ...
+records = [(node, tasks) for (node, tasks) in profiler.parallel_calls.items() if node.factory().name() == "ScalePoints"]
+if len(records) != 1 or records[0][1].get("Update Mesh", 0) < 1:
+	raise Exception("expected parallel calls for ScalePoints")
+
+node = records[0][0]
+if profiler.parallel_tasks[node]["Update Mesh"] < 1:
+	raise Exception("expected parallel tasks for ScalePoints")
+if profiler.parallel_busy_time[node]["Update Mesh"] <= 0:
+	raise Exception("expected parallel busy time for ScalePoints")
+if profiler.parallel_steals[node]["Update Mesh"] > profiler.parallel_tasks[node]["Update Mesh"]:
+	raise Exception("more steals than tasks for ScalePoints")
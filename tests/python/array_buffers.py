@@ -0,0 +1,84 @@
+#python
+
+import k3d
+
+document = k3d.new_document()
+source = k3d.plugin.create("FrozenMesh", document)
+mesh = source.create_mesh()
+
+points = mesh.create_points()
+points.assign([k3d.point3(0, 1, 2), k3d.point3(3, 4, 5)])
+
+# Writable arrays expose writable, two-dimensional buffers ...
+view = memoryview(points)
+if view.ndim != 2 or view.shape != (2, 3) or view.format != "d" or view.itemsize != 8 or view.readonly:
+	raise Exception("incorrect writable point buffer")
+
+point_selection = mesh.create_point_selection()
+point_selection.assign([1.0, 0.0])
+view = memoryview(point_selection)
+if view.ndim != 1 or view.shape != (2,) or view.format != "d" or view.readonly:
+	raise Exception("incorrect selection buffer")
+
+# Const arrays expose read-only buffers ...
+view = memoryview(source.output_mesh.points())
+if view.shape != (2, 3) or not view.readonly:
+	raise Exception("incorrect read-only point buffer")
+
+# Assigning from a buffer copies it in bulk ...
+polyhedron = k3d.polyhedron.create(mesh)
+copy = polyhedron.vertex_attributes().create("copy", "k3d::point3")
+copy.assign(points)
+if len(copy) != 2 or copy[1] != k3d.point3(3, 4, 5):
+	raise Exception("incorrect bulk assignment")
+
+# Arrays can't be resized while buffers view their storage ...
+view = memoryview(points)
+try:
+	points.append(k3d.point3(6, 7, 8))
+	raise Exception("array resized while a buffer was exported")
+except BufferError:
+	pass
+
+del view
+points.append(k3d.point3(6, 7, 8))
+if len(points) != 3:
+	raise Exception("array can't be resized after its buffer was released")
+
+try:
+	import numpy
+except ImportError:
+	numpy = None
+
+if numpy:
+	# NumPy arrays share storage with mesh arrays ...
+	array = numpy.asarray(points)
+	if array.shape != (3, 3) or array.dtype != numpy.float64:
+		raise Exception("incorrect numpy point array")
+
+	array[1, 2] = 10
+	if points[1] != k3d.point3(3, 4, 10):
+		raise Exception("numpy array doesn't share storage")
+
+	try:
+		points.assign(numpy.zeros((10, 3)))
+		raise Exception("array resized while a numpy array shares its storage")
+	except BufferError:
+		pass
+
+	del array
+
+	# Bulk assignment converts scalar types and handles non-contiguous buffers ...
+	points.assign(numpy.arange(30, dtype=numpy.float32).reshape(10, 3))
+	if len(points) != 10 or points[9] != k3d.point3(27, 28, 29):
+		raise Exception("incorrect converted assignment")
+
+	points.assign(numpy.arange(60, dtype=numpy.float64).reshape(10, 6)[:, ::2])
+	if len(points) != 10 or points[1] != k3d.point3(6, 8, 10):
+		raise Exception("incorrect strided assignment")
+
+	indices = polyhedron.vertex_points()
+	indices.assign(numpy.arange(5, dtype=numpy.int32))
+	if len(indices) != 5 or indices[4] != 4:
+		raise Exception("incorrect index assignment")
+
@@ -0,0 +1,104 @@
+#include <k3dsdk/archive_cache_ri.h>
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/inetwork_render_job.h>
+#include <k3dsdk/system.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+/// Creates job files in the temp directory, removing them on exit
+class test_job :
+	public k3d::inetwork_render_job
+{
+public:
+	~test_job()
+	{
+		for(std::vector<k3d::filesystem::path>::const_iterator file = files.begin(); file != files.end(); ++file)
+			k3d::filesystem::remove(*file);
+	}
+
+	k3d::inetwork_render_frame& create_frame(const k3d::string_t&)
+	{
+		throw std::runtime_error("test jobs don't have frames");
+	}
+
+	const k3d::filesystem::path add_file(const k3d::string_t& Name)
+	{
+		files.push_back(k3d::system::get_temp_directory() / k3d::filesystem::generic_path("k3d-archive-cache-test-" + boost::lexical_cast<k3d::string_t>(files.size()) + "-" + Name));
+		return files.back();
+	}
+
+	std::vector<k3d::filesystem::path> files;
+};
+
+void test_expression(const bool Expression, const char* const Description)
+{
+	if(!Expression)
+		throw std::runtime_error(Description);
+}
+
+const k3d::string_t contents(const k3d::filesystem::path& File)
+{
+	k3d::filesystem::ifstream stream(File);
+	return k3d::string_t(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		test_job job;
+
+		k3d::ri::archive_cache cache(job, false, false);
+
+		const k3d::filesystem::path first = cache.store("Sphere 1 -1 1 360\n");
+		test_expression(!first.empty(), "store failed");
+		test_expression(contents(first) == "Sphere 1 -1 1 360\n", "incorrect archive contents");
+		test_expression(cache.archive_count() == 1, "incorrect archive count");
+
+		// Identical contents share a single archive ...
+		test_expression(cache.store("Sphere 1 -1 1 360\n") == first, "identical contents weren't shared");
+		test_expression(cache.archive_count() == 1, "identical contents were written twice");
+
+		// Different contents get a new archive ...
+		const k3d::filesystem::path second = cache.store("Sphere 2 -2 2 360\n");
+		test_expression(!second.empty() && second != first, "changed contents didn't create a new archive");
+		test_expression(contents(second) == "Sphere 2 -2 2 360\n", "incorrect archive contents");
+		test_expression(cache.archive_count() == 2, "incorrect archive count");
+
+		// Contents that are a prefix of an existing archive get a new archive ...
+		const k3d::filesystem::path third = cache.store("Sphere 1 -1 1");
+		test_expression(third != first && contents(third) == "Sphere 1 -1 1", "truncated contents weren't written");
+
+		test_expression(cache.store("Sphere 2 -2 2 360\n") == second, "earlier contents weren't shared");
+
+		// Owners reuse their archive until their version changes ...
+		int owner = 0;
+		const k3d::iunknown* const owner_key = reinterpret_cast<const k3d::iunknown*>(&owner);
+		test_expression(cache.lookup(owner_key, 0).empty(), "lookup succeeded before store");
+		test_expression(cache.store(owner_key, 0, "Sphere 1 -1 1 360\n") == first, "owner contents weren't shared");
+		test_expression(cache.lookup(owner_key, 0) == first, "owner archive wasn't found");
+		test_expression(cache.lookup(owner_key, 1).empty(), "lookup ignored a changed version");
+		test_expression(cache.store(owner_key, 1, "Sphere 4 -4 4 360\n") != first, "changed owner contents didn't create a new archive");
+		test_expression(cache.lookup(owner_key, 0).empty(), "lookup found an outdated version");
+
+		// Compressed archives are matched by their uncompressed contents ...
+		k3d::ri::archive_cache compressed_cache(job, false, true);
+		const k3d::filesystem::path compressed = compressed_cache.store("Sphere 3 -3 3 360\n");
+		test_expression(!compressed.empty(), "compressed store failed");
+		test_expression(compressed_cache.store("Sphere 3 -3 3 360\n") == compressed, "compressed contents weren't shared");
+		test_expression(compressed_cache.archive_count() == 1, "compressed contents were written twice");
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
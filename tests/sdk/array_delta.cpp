@@ -0,0 +1,116 @@
+#include <k3dsdk/array_delta.h>
+#include <k3dsdk/mesh.h>
+#include <k3dsdk/state_change_set.h>
+#include <k3dsdk/state_spill_file.h>
+#include <k3dsdk/typed_array.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+/// Returns Count arbitrary points
+const k3d::mesh::points_t create_points(const k3d::uint_t Count)
+{
+	k3d::mesh::points_t result(Count);
+	for(k3d::uint_t i = 0; i != Count; ++i)
+		result[i] = k3d::point3(i, 2 * i, 3 * i);
+	return result;
+}
+
+template<typename array_t>
+void require_equal(const array_t& A, const array_t& B, const k3d::string_t& Message)
+{
+	if(A.size() != B.size() || !std::equal(A.begin(), A.end(), B.begin()))
+		throw std::runtime_error(Message);
+}
+
+/// Records a change from Old to New using array_undo_storage, then checks that undo and redo recreate both versions
+template<typename array_t>
+void test_undo_storage(const array_t& Old, const array_t& New, const boost::shared_ptr<k3d::state_spill_file>& File, const k3d::string_t& Message)
+{
+	array_t value = Old;
+
+	k3d::state_change_set change_set;
+	k3d::array_undo_storage<array_t> storage;
+	storage.start_recording(change_set, value);
+	value = New;
+	storage.finish_recording(change_set, value);
+
+	if(File)
+		change_set.spill(File);
+
+	for(k3d::uint_t i = 0; i != 2; ++i)
+	{
+		change_set.undo();
+		require_equal(value, Old, Message + ": undo mismatch");
+		change_set.redo();
+		require_equal(value, New, Message + ": redo mismatch");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const k3d::mesh::points_t old_points = create_points(1000);
+
+		// Changed values, growing, and shrinking arrays must all be recreated exactly ...
+		k3d::mesh::points_t moved_points = old_points;
+		moved_points[0] = k3d::point3(-1, -1, -1);
+		for(k3d::uint_t i = 500; i != 510; ++i)
+			moved_points[i] = k3d::point3(i, i, i);
+		moved_points[999] = k3d::point3(1, 1, 1);
+
+		const k3d::mesh::points_t grown_points = create_points(1200);
+		const k3d::mesh::points_t shrunk_points = create_points(700);
+
+		test_undo_storage(old_points, moved_points, boost::shared_ptr<k3d::state_spill_file>(), "moved points");
+		test_undo_storage(old_points, grown_points, boost::shared_ptr<k3d::state_spill_file>(), "grown points");
+		test_undo_storage(old_points, shrunk_points, boost::shared_ptr<k3d::state_spill_file>(), "shrunk points");
+		test_undo_storage(old_points, k3d::mesh::points_t(), boost::shared_ptr<k3d::state_spill_file>(), "cleared points");
+
+		// Deltas only store the values that changed ...
+		const k3d::array_delta<k3d::mesh::points_t> delta(old_points, moved_points);
+		if(delta.old_values.size() != 12 || delta.runs.size() != 6)
+			throw std::runtime_error("delta stores unchanged values");
+
+		// Spilled state must be recreated exactly, and releases its memory ...
+		boost::shared_ptr<k3d::state_spill_file> file(new k3d::state_spill_file());
+		test_undo_storage(old_points, moved_points, file, "spilled moved points");
+		test_undo_storage(old_points, grown_points, file, "spilled grown points");
+		test_undo_storage(old_points, shrunk_points, file, "spilled shrunk points");
+
+		{
+			k3d::mesh::points_t value = old_points;
+			k3d::state_change_set change_set;
+			k3d::array_undo_storage<k3d::mesh::points_t> storage;
+			storage.start_recording(change_set, value);
+			value = grown_points;
+			storage.finish_recording(change_set, value);
+
+			const k3d::uint_t memory_usage = change_set.memory_usage();
+			change_set.spill(file);
+			if(!change_set.spilled() || change_set.memory_usage() >= memory_usage || !file->size())
+				throw std::runtime_error("spilling doesn't release memory");
+		}
+
+		if(file->size())
+			throw std::runtime_error("spilled blocks aren't released");
+
+		// Arrays that can't be spilled stay in memory ...
+		k3d::typed_array<k3d::bool_t> old_bools(100, false);
+		k3d::typed_array<k3d::bool_t> new_bools(old_bools);
+		new_bools[10] = true;
+		new_bools.push_back(true);
+		test_undo_storage(old_bools, new_bools, file, "bools");
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
@@ -0,0 +1,130 @@
+#include <k3dsdk/algebra.h>
+#include <k3dsdk/bounding_volume_hierarchy.h>
+#include <k3dsdk/vector4.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+/// Returns a pseudo-random number in the range [Min, Max]
+double random_value(const double Min, const double Max)
+{
+	return Min + (Max - Min) * (static_cast<double>(std::rand()) / static_cast<double>(RAND_MAX));
+}
+
+/// Returns the same matrix as glFrustum()
+const k3d::matrix4 frustum_matrix(const double Left, const double Right, const double Bottom, const double Top, const double Near, const double Far)
+{
+	return k3d::matrix4(
+		k3d::vector4(2 * Near / (Right - Left), 0, (Right + Left) / (Right - Left), 0),
+		k3d::vector4(0, 2 * Near / (Top - Bottom), (Top + Bottom) / (Top - Bottom), 0),
+		k3d::vector4(0, 0, -(Far + Near) / (Far - Near), -2 * Far * Near / (Far - Near)),
+		k3d::vector4(0, 0, -1, 0));
+}
+
+/// Compares a hierarchy query against a brute-force test of every element
+void test_query(const k3d::bounding_volume_hierarchy& Hierarchy, const k3d::uint_t VertexCount, const k3d::mesh::indices_t& ElementVertices, const k3d::mesh::points_t& Points, const k3d::selection_frustum& Frustum, const k3d::bounding_volume_hierarchy::culling Culling)
+{
+	const k3d::uint_t element_count = ElementVertices.size() / VertexCount;
+
+	k3d::bounding_volume_hierarchy::hits_t hits;
+	Hierarchy.intersect(Frustum, Points, Culling, hits);
+
+	std::vector<k3d::bounding_volume_hierarchy::hit> expected(element_count);
+	std::vector<bool> expected_hit(element_count, false);
+	k3d::uint_t expected_count = 0;
+	for(k3d::uint_t element = 0; element != element_count; ++element)
+	{
+		k3d::point3 vertices[3];
+		for(k3d::uint_t i = 0; i != VertexCount; ++i)
+			vertices[i] = Points[ElementVertices[element * VertexCount + i]];
+
+		if(VertexCount == 3 && Culling != k3d::bounding_volume_hierarchy::CULL_NONE)
+		{
+			if(Frustum.counter_clockwise(vertices[0], vertices[1], vertices[2]) == (Culling == k3d::bounding_volume_hierarchy::CULL_COUNTER_CLOCKWISE))
+				continue;
+		}
+
+		expected_hit[element] = Frustum.clip(vertices, VertexCount, expected[element].zmin, expected[element].zmax);
+		if(expected_hit[element])
+			++expected_count;
+	}
+
+	if(hits.size() != expected_count)
+		throw std::runtime_error("incorrect hit count");
+
+	std::vector<bool> found(element_count, false);
+	for(k3d::uint_t i = 0; i != hits.size(); ++i)
+	{
+		const k3d::uint_t element = hits[i].element;
+		if(element >= element_count || !expected_hit[element] || found[element])
+			throw std::runtime_error("unexpected hit");
+		if(hits[i].zmin != expected[element].zmin || hits[i].zmax != expected[element].zmax)
+			throw std::runtime_error("incorrect hit depth");
+
+		found[element] = true;
+	}
+}
+
+/// Tests a hierarchy of randomly-placed elements against randomly-placed selection regions, before and after moving the points
+void test_hierarchy(const k3d::uint_t VertexCount)
+{
+	const k3d::uint_t element_count = 500;
+
+	k3d::mesh::points_t points;
+	k3d::mesh::indices_t element_vertices;
+	for(k3d::uint_t element = 0; element != element_count; ++element)
+	{
+		const k3d::point3 center(random_value(-2, 2), random_value(-2, 2), random_value(-2, 2));
+		for(k3d::uint_t i = 0; i != VertexCount; ++i)
+		{
+			element_vertices.push_back(points.size());
+			points.push_back(center + k3d::vector3(random_value(-0.2, 0.2), random_value(-0.2, 0.2), random_value(-0.2, 0.2)));
+		}
+	}
+
+	k3d::bounding_volume_hierarchy hierarchy(VertexCount, element_vertices, points);
+	if(hierarchy.element_count() != element_count)
+		throw std::runtime_error("incorrect element count");
+
+	const k3d::matrix4 object_to_clip = frustum_matrix(-0.5, 0.5, -0.5, 0.5, 1, 10) * k3d::translate3(0, 0, -5) * k3d::rotate3(k3d::radians(30.0), k3d::vector3(1, 1, 0));
+
+	for(k3d::uint_t pass = 0; pass != 2; ++pass)
+	{
+		for(k3d::uint_t region = 0; region != 50; ++region)
+		{
+			const double left = random_value(-1, 1);
+			const double bottom = random_value(-1, 1);
+			const k3d::selection_frustum frustum(object_to_clip, left, left + random_value(0, 0.5), bottom, bottom + random_value(0, 0.5));
+
+			test_query(hierarchy, VertexCount, element_vertices, points, frustum, k3d::bounding_volume_hierarchy::CULL_NONE);
+			test_query(hierarchy, VertexCount, element_vertices, points, frustum, k3d::bounding_volume_hierarchy::CULL_CLOCKWISE);
+			test_query(hierarchy, VertexCount, element_vertices, points, frustum, k3d::bounding_volume_hierarchy::CULL_COUNTER_CLOCKWISE);
+		}
+
+		// Move the points and refit, so the second pass tests the refit bounds ...
+		for(k3d::uint_t i = 0; i != points.size(); ++i)
+			points[i] += k3d::vector3(random_value(-0.5, 0.5), random_value(-0.5, 0.5), random_value(-0.5, 0.5));
+		hierarchy.refit(points);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		std::srand(1234);
+
+		test_hierarchy(1);
+		test_hierarchy(2);
+		test_hierarchy(3);
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
@@ -0,0 +1,79 @@
+#include <k3dsdk/expression/parser.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+/// Verifies that block evaluation produces the same results as evaluating each set of variables separately
+void test_expression(const std::string& Expression, const bool Optimize)
+{
+	std::cout << Expression << (Optimize ? " (optimized)" : "") << std::endl;
+
+	k3d::expression::parser parser;
+	if(!parser.parse(Expression, "x,y,z,w"))
+		throw std::runtime_error("parse error: " + parser.last_parse_error());
+	if(Optimize)
+		parser.optimize();
+
+	if(!parser.block_evaluation())
+		throw std::runtime_error("block evaluation not supported");
+
+	// Store points as interleaved x, y, z coordinates, with a single value for w ...
+	const k3d::uint_t count = 1000;
+	std::vector<k3d::double_t> points(3 * count);
+	for(k3d::uint_t i = 0; i != points.size(); ++i)
+		points[i] = 4.0 * std::rand() / RAND_MAX - 2.0;
+	const k3d::double_t w = 0.5;
+
+	const k3d::double_t* const variables[] = { &points[0], &points[1], &points[2], &w };
+	const k3d::uint_t strides[] = { 3, 3, 3, 0 };
+
+	std::vector<k3d::double_t> results(count);
+	if(!parser.evaluate_block(variables, strides, count, &results[0]))
+		throw std::runtime_error("block evaluation failed");
+
+	for(k3d::uint_t i = 0; i != count; ++i)
+	{
+		const k3d::double_t values[] = { points[3 * i + 0], points[3 * i + 1], points[3 * i + 2], w };
+		const k3d::double_t expected = parser.evaluate(values);
+		if(results[i] != expected && (expected == expected || results[i] == results[i]))
+			throw std::runtime_error("result mismatch");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const char* const expressions[] =
+		{
+			"z + sin(x)",
+			"x * y - z / (x - 1)",
+			"sqrt(x) + log(y) + acos(z)",
+			"min(x, y)^2 + (x < y) + !(z > 0) & w",
+			"-x * pi * 2 + cot(y) - sec(z) % 3",
+			"atan2(x, y) + floor(z) + int(x) * w"
+		};
+
+		for(k3d::uint_t i = 0; i != sizeof(expressions) / sizeof(expressions[0]); ++i)
+		{
+			test_expression(expressions[i], false);
+			test_expression(expressions[i], true);
+		}
+
+		// Conditionals can't be evaluated in blocks ...
+		k3d::expression::parser parser;
+		if(!parser.parse("if(x < 0, 1, 2)", "x"))
+			throw std::runtime_error("parse error: " + parser.last_parse_error());
+		if(parser.block_evaluation())
+			throw std::runtime_error("unexpected block evaluation support");
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
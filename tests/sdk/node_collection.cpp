@@ -0,0 +1,172 @@
+#include <k3dsdk/document.h>
+#include <k3dsdk/high_res_timer.h>
+#include <k3dsdk/idocument.h>
+#include <k3dsdk/inode.h>
+#include <k3dsdk/inode_collection.h>
+#include <k3dsdk/iproperty.h>
+#include <k3dsdk/nodes.h>
+#include <k3dsdk/property_collection.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+/// Minimal property implementation, used to test property ownership lookups
+class test_property :
+	public k3d::iproperty
+{
+public:
+	const k3d::string_t property_name() { return "test"; }
+	const k3d::string_t property_label() { return "Test"; }
+	const k3d::string_t property_description() { return ""; }
+	const std::type_info& property_type() { return typeid(k3d::int32_t); }
+	const boost::any property_internal_value() { return boost::any(); }
+	const boost::any property_pipeline_value() { return boost::any(); }
+	k3d::inode* property_node() { return 0; }
+	changed_signal_t& property_changed_signal() { return m_changed_signal; }
+	deleted_signal_t& property_deleted_signal() { return m_deleted_signal; }
+	k3d::iproperty* property_dependency() { return 0; }
+	void property_set_dependency(k3d::iproperty*) {}
+
+private:
+	changed_signal_t m_changed_signal;
+	deleted_signal_t m_deleted_signal;
+};
+
+/// Minimal node implementation, so the document node collection can be tested without loading plugins
+class test_node :
+	public k3d::inode,
+	public k3d::property_collection
+{
+public:
+	test_node(k3d::idocument& Document, const std::string& Name) :
+		m_document(Document),
+		m_name(Name)
+	{
+		register_property(m_property);
+	}
+
+	void set_name(const std::string Name) { m_name = Name; m_name_changed_signal.emit(); }
+	const std::string name() { return m_name; }
+	k3d::iplugin_factory& factory() { throw std::runtime_error("test nodes don't have a factory"); }
+	k3d::idocument& document() { return m_document; }
+	deleted_signal_t& deleted_signal() { return m_deleted_signal; }
+	name_changed_signal_t& name_changed_signal() { return m_name_changed_signal; }
+
+	test_property m_property;
+
+private:
+	k3d::idocument& m_document;
+	std::string m_name;
+	deleted_signal_t m_deleted_signal;
+	name_changed_signal_t m_name_changed_signal;
+};
+
+void test_expression(const bool Expression, const char* const Description)
+{
+	if(!Expression)
+		throw std::runtime_error(Description);
+}
+
+#define TEST_EXPRESSION(expression) test_expression(expression, #expression)
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const k3d::uint_t count = 100000;
+
+		k3d::idocument* const document = k3d::create_document();
+		k3d::inode_collection& collection = document->nodes();
+
+		// Create nodes in bulk ...
+		k3d::timer timer;
+		std::vector<test_node*> test_nodes;
+		k3d::nodes_t nodes;
+		for(k3d::uint_t i = 0; i != count; ++i)
+		{
+			test_nodes.push_back(new test_node(*document, "Node " + boost::lexical_cast<std::string>(i)));
+			nodes.push_back(test_nodes.back());
+		}
+		collection.add_nodes(nodes);
+		std::cout << "create " << count << " nodes: " << timer.elapsed() << " s" << std::endl;
+
+		TEST_EXPRESSION(collection.collection() == nodes);
+		TEST_EXPRESSION(collection.find_nodes("Node 5") == k3d::nodes_t(1, test_nodes[5]));
+		TEST_EXPRESSION(collection.find_nodes("Node").empty());
+		TEST_EXPRESSION(k3d::unique_name(collection, "Node") == "Node");
+		TEST_EXPRESSION(k3d::unique_name(collection, "Node 99998") == "Node 100000");
+		TEST_EXPRESSION(k3d::find_node(collection, test_nodes[7]->m_property) == test_nodes[7]);
+
+		// Adding a node twice is ignored ...
+		collection.add_nodes(k3d::nodes_t(1, test_nodes[3]));
+		TEST_EXPRESSION(collection.collection().size() == count);
+
+		// Properties are indexed as they're registered and unregistered ...
+		test_property extra_property;
+		test_nodes[11]->register_property(extra_property);
+		TEST_EXPRESSION(collection.find_node(extra_property) == test_nodes[11]);
+		test_nodes[11]->unregister_property(extra_property);
+		TEST_EXPRESSION(collection.find_node(extra_property) == 0);
+
+		// Rename every node ...
+		timer.restart();
+		for(k3d::uint_t i = 0; i != count; ++i)
+			test_nodes[i]->set_name(k3d::unique_name(collection, "Renamed " + boost::lexical_cast<std::string>(i)));
+		std::cout << "rename " << count << " nodes: " << timer.elapsed() << " s" << std::endl;
+
+		TEST_EXPRESSION(collection.find_nodes("Node 5").empty());
+		TEST_EXPRESSION(collection.find_nodes("Renamed 5") == k3d::nodes_t(1, test_nodes[5]));
+
+		// Duplicate names are returned in collection order ...
+		for(k3d::uint_t i = 20; i != 0; --i)
+			test_nodes[i - 1]->set_name("Shared");
+		const k3d::nodes_t shared = collection.find_nodes("Shared");
+		TEST_EXPRESSION(shared.size() == 20);
+		for(k3d::uint_t i = 0; i != shared.size(); ++i)
+			TEST_EXPRESSION(shared[i] == test_nodes[i]);
+
+		// Delete every other node in bulk ...
+		k3d::nodes_t odd_nodes;
+		k3d::nodes_t even_nodes;
+		for(k3d::uint_t i = 0; i != count; ++i)
+			(i % 2 ? odd_nodes : even_nodes).push_back(test_nodes[i]);
+
+		timer.restart();
+		collection.remove_nodes(odd_nodes);
+		std::cout << "delete " << odd_nodes.size() << " nodes: " << timer.elapsed() << " s" << std::endl;
+
+		TEST_EXPRESSION(collection.collection() == even_nodes);
+		TEST_EXPRESSION(collection.find_nodes("Shared").size() == 10);
+		TEST_EXPRESSION(collection.find_nodes("Renamed 5").empty());
+		TEST_EXPRESSION(collection.find_node(test_nodes[7]->m_property) == 0);
+		TEST_EXPRESSION(collection.find_node(test_nodes[8]->m_property) == test_nodes[8]);
+
+		// Removed nodes are no longer tracked when they're renamed ...
+		test_nodes[1001]->set_name("Renamed 1000");
+		TEST_EXPRESSION(collection.find_nodes("Renamed 1000") == k3d::nodes_t(1, test_nodes[1000]));
+
+		// Delete the remaining nodes one-at-a-time ...
+		timer.restart();
+		for(k3d::nodes_t::reverse_iterator node = even_nodes.rbegin(); node != even_nodes.rend(); ++node)
+			collection.remove_nodes(k3d::nodes_t(1, *node));
+		std::cout << "delete " << even_nodes.size() << " nodes individually: " << timer.elapsed() << " s" << std::endl;
+
+		TEST_EXPRESSION(collection.collection().empty());
+		TEST_EXPRESSION(collection.find_nodes("Shared").empty());
+
+		k3d::close_document(*document);
+
+		for(k3d::uint_t i = 0; i != count; ++i)
+			delete test_nodes[i];
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,248 @@
+#include <k3dsdk/parallel/blocked_range.h>
+#include <k3dsdk/parallel/parallel_for.h>
+#include <k3dsdk/parallel/parallel_reduce.h>
+#include <k3dsdk/parallel/parallel_scan.h>
+#include <k3dsdk/parallel/parallel_sort.h>
+#include <k3dsdk/parallel/statistics.h>
+#include <k3dsdk/parallel/task_group.h>
+#include <k3dsdk/parallel/threads.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+typedef k3d::parallel::blocked_range<k3d::uint_t> range_t;
+
+/// Doubles every value in a range
+class double_values
+{
+public:
+	double_values(std::vector<k3d::uint_t>& Values) :
+		values(Values)
+	{
+	}
+
+	void operator()(const range_t& Range) const
+	{
+		for(k3d::uint_t i = Range.begin(); i != Range.end(); ++i)
+			values[i] *= 2;
+	}
+
+private:
+	std::vector<k3d::uint_t>& values;
+};
+
+/// Sums the values in a range
+class sum_values
+{
+public:
+	sum_values(const std::vector<k3d::uint_t>& Values) :
+		values(Values),
+		sum(0)
+	{
+	}
+
+	sum_values(sum_values& Other, k3d::parallel::split) :
+		values(Other.values),
+		sum(0)
+	{
+	}
+
+	void operator()(const range_t& Range)
+	{
+		for(k3d::uint_t i = Range.begin(); i != Range.end(); ++i)
+			sum += values[i];
+	}
+
+	void join(sum_values& Other)
+	{
+		sum += Other.sum;
+	}
+
+	const std::vector<k3d::uint_t>& values;
+	k3d::uint_t sum;
+};
+
+/// Computes an inclusive running sum of a range
+class running_sum
+{
+public:
+	running_sum(const std::vector<k3d::uint_t>& Values, std::vector<k3d::uint_t>& Results) :
+		values(Values),
+		results(Results),
+		sum(0)
+	{
+	}
+
+	running_sum(running_sum& Other, k3d::parallel::split) :
+		values(Other.values),
+		results(Other.results),
+		sum(0)
+	{
+	}
+
+	template<typename TagT>
+	void operator()(const range_t& Range, TagT)
+	{
+		k3d::uint_t temp = sum;
+		for(k3d::uint_t i = Range.begin(); i != Range.end(); ++i)
+		{
+			temp += values[i];
+			if(TagT::is_final_scan())
+				results[i] = temp;
+		}
+		sum = temp;
+	}
+
+	void reverse_join(running_sum& Other)
+	{
+		sum += Other.sum;
+	}
+
+	void assign(running_sum& Other)
+	{
+		sum = Other.sum;
+	}
+
+	const std::vector<k3d::uint_t>& values;
+	std::vector<k3d::uint_t>& results;
+	k3d::uint_t sum;
+};
+
+/// Increments a counter
+class increment
+{
+public:
+	increment(std::atomic<k3d::uint_t>& Counter) :
+		counter(Counter)
+	{
+	}
+
+	void operator()() const
+	{
+		++counter;
+	}
+
+private:
+	std::atomic<k3d::uint_t>& counter;
+};
+
+/// Throws an exception
+class fail
+{
+public:
+	void operator()() const
+	{
+		throw std::runtime_error("task failure");
+	}
+};
+
+void test_algorithms(const k3d::uint_t Count, const k3d::uint_t GrainSize)
+{
+	std::vector<k3d::uint_t> values(Count);
+	for(k3d::uint_t i = 0; i != Count; ++i)
+		values[i] = i % 97;
+
+	std::vector<k3d::uint_t> doubled(values);
+	k3d::parallel::parallel_for(range_t(0, Count, GrainSize), double_values(doubled));
+	for(k3d::uint_t i = 0; i != Count; ++i)
+	{
+		if(doubled[i] != 2 * values[i])
+			throw std::runtime_error("parallel_for produced incorrect results");
+	}
+
+	sum_values sum(values);
+	k3d::parallel::parallel_reduce(range_t(0, Count, GrainSize), sum);
+	k3d::uint_t expected_sum = 0;
+	for(k3d::uint_t i = 0; i != Count; ++i)
+		expected_sum += values[i];
+	if(sum.sum != expected_sum)
+		throw std::runtime_error("parallel_reduce produced incorrect results");
+
+	std::vector<k3d::uint_t> running_sums(Count, 0);
+	running_sum scan(values, running_sums);
+	k3d::parallel::parallel_scan(range_t(0, Count, GrainSize), scan);
+	k3d::uint_t expected_running_sum = 0;
+	for(k3d::uint_t i = 0; i != Count; ++i)
+	{
+		expected_running_sum += values[i];
+		if(running_sums[i] != expected_running_sum)
+			throw std::runtime_error("parallel_scan produced incorrect results");
+	}
+	if(scan.sum != expected_sum)
+		throw std::runtime_error("parallel_scan produced an incorrect summary");
+
+	std::vector<k3d::uint_t> sorted(Count);
+	for(k3d::uint_t i = 0; i != Count; ++i)
+		sorted[i] = std::rand() % 1000;
+	std::vector<k3d::uint_t> expected_sorted(sorted);
+	std::sort(expected_sorted.begin(), expected_sorted.end(), std::greater<k3d::uint_t>());
+	k3d::parallel::parallel_sort(sorted.begin(), sorted.end(), std::greater<k3d::uint_t>());
+	if(sorted != expected_sorted)
+		throw std::runtime_error("parallel_sort produced incorrect results");
+}
+
+void test_task_group()
+{
+	std::atomic<k3d::uint_t> counter(0);
+
+	k3d::parallel::task_group group;
+	for(k3d::uint_t i = 0; i != 1000; ++i)
+		group.run(increment(counter));
+	group.wait();
+
+	if(counter.load() != 1000)
+		throw std::runtime_error("task_group didn't execute every task");
+
+	bool caught = false;
+	group.run(fail());
+	try
+	{
+		group.wait();
+	}
+	catch(std::runtime_error&)
+	{
+		caught = true;
+	}
+	if(!caught)
+		throw std::runtime_error("task_group didn't propagate an exception");
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		const k3d::int32_t thread_counts[] = { 1, 2, 4, k3d::parallel::automatic };
+		for(k3d::uint_t i = 0; i != 4; ++i)
+		{
+			k3d::parallel::set_thread_count(thread_counts[i]);
+			if(thread_counts[i] != k3d::parallel::automatic && k3d::parallel::thread_count() != static_cast<k3d::uint_t>(thread_counts[i]))
+				throw std::runtime_error("incorrect thread count");
+
+			const k3d::parallel::statistics start = k3d::parallel::get_statistics();
+
+			test_algorithms(0, 1);
+			test_algorithms(1, 1);
+			test_algorithms(1000, 1);
+			test_algorithms(100000, 1000);
+			test_algorithms(1000, 0);
+			test_task_group();
+
+			const k3d::parallel::statistics difference = k3d::parallel::get_statistics() - start;
+			if(difference.calls != 20 || difference.tasks < 1000 || difference.steals > difference.tasks || difference.busy_time < 0)
+				throw std::runtime_error("incorrect statistics");
+		}
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
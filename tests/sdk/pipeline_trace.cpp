@@ -0,0 +1,173 @@
+#include <k3dsdk/hints.h>
+#include <k3dsdk/inode.h>
+#include <k3dsdk/pipeline_profiler.h>
+#include <k3dsdk/pipeline_trace.h>
+
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+/// Minimal node implementation, so the profiler can be tested without a document
+class test_node :
+	public k3d::inode
+{
+public:
+	test_node(const std::string& Name) :
+		m_name(Name)
+	{
+	}
+
+	void set_name(const std::string Name) { m_name = Name; }
+	const std::string name() { return m_name; }
+	k3d::iplugin_factory& factory() { throw std::runtime_error("test nodes don't have a factory"); }
+	k3d::idocument& document() { throw std::runtime_error("test nodes don't have a document"); }
+	deleted_signal_t& deleted_signal() { return m_deleted_signal; }
+	name_changed_signal_t& name_changed_signal() { return m_name_changed_signal; }
+
+private:
+	std::string m_name;
+	deleted_signal_t m_deleted_signal;
+	name_changed_signal_t m_name_changed_signal;
+};
+
+void test_expression(const bool Expression, const char* const Description)
+{
+	if(!Expression)
+		throw std::runtime_error(Description);
+}
+
+#define TEST_EXPRESSION(expression) test_expression(expression, #expression)
+
+const k3d::uint_t count(const std::string& Text, const std::string& Pattern)
+{
+	k3d::uint_t result = 0;
+	for(std::string::size_type i = Text.find(Pattern); i != std::string::npos; i = Text.find(Pattern, i + 1))
+		++result;
+	return result;
+}
+
+/// Counts profiler entries (the profiler serializes its signals, so no locking is needed)
+struct execution_counter
+{
+	execution_counter() :
+		count(0)
+	{
+	}
+
+	void on_execution(k3d::inode&, const k3d::string_t&, double)
+	{
+		++count;
+	}
+
+	k3d::uint_t count;
+};
+
+void execute_tasks(k3d::pipeline_profiler& Profiler, test_node& Node, const k3d::uint_t Count)
+{
+	for(k3d::uint_t i = 0; i != Count; ++i)
+	{
+		Profiler.start_execution(Node, "Outer");
+		Profiler.start_execution(Node, "Inner");
+		Profiler.finish_execution(Node, "Inner");
+		Profiler.finish_execution(Node, "Outer");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		k3d::pipeline_profiler profiler;
+		test_node node("Node \"1\"");
+
+		// Nothing is recorded until recording starts ...
+		execute_tasks(profiler, node, 10);
+		TEST_EXPRESSION(!k3d::pipeline_trace::recording());
+		TEST_EXPRESSION(k3d::pipeline_trace::spans().empty());
+
+		k3d::pipeline_trace::start();
+		TEST_EXPRESSION(k3d::pipeline_trace::recording());
+
+		// Nested tasks on the main thread, with hints and allocations ...
+		{
+			std::vector<k3d::ihint*> hints(1, k3d::hint::mesh_geometry_changed::instance());
+			const k3d::pipeline_trace::hint_scope hint_scope(hints);
+
+			profiler.start_execution(node, "Outer");
+			profiler.start_execution(node, "Inner");
+			k3d::pipeline_trace::count_allocation(100);
+			profiler.finish_execution(node, "Inner");
+			profiler.finish_execution(node, "Outer");
+		}
+
+		// Nested tasks on several threads at once ...
+		const k3d::uint_t thread_count = 4;
+		const k3d::uint_t task_count = 100;
+		std::vector<std::thread> threads;
+		for(k3d::uint_t i = 0; i != thread_count; ++i)
+			threads.push_back(std::thread(execute_tasks, std::ref(profiler), std::ref(node), task_count));
+		for(k3d::uint_t i = 0; i != thread_count; ++i)
+			threads[i].join();
+
+		k3d::pipeline_trace::stop();
+		execute_tasks(profiler, node, 10);
+
+		const std::vector<k3d::pipeline_trace::span> spans = k3d::pipeline_trace::spans();
+		TEST_EXPRESSION(spans.size() == 2 + thread_count * task_count * 2);
+
+		// Spans are ordered by thread, with enclosing spans first ...
+		TEST_EXPRESSION(spans[0].task == "Outer");
+		TEST_EXPRESSION(spans[1].task == "Inner");
+		TEST_EXPRESSION(spans[0].thread == spans[1].thread);
+		TEST_EXPRESSION(spans[0].start <= spans[1].start);
+		TEST_EXPRESSION(spans[0].finish >= spans[1].finish);
+		TEST_EXPRESSION(spans[0].node == "Node \"1\"");
+		TEST_EXPRESSION(!spans[1].hints.empty());
+		TEST_EXPRESSION(spans[0].allocated_bytes == 100);
+		TEST_EXPRESSION(spans[1].allocated_bytes == 100);
+
+		std::set<k3d::uint_t> span_threads;
+		for(k3d::uint_t i = 0; i != spans.size(); ++i)
+		{
+			span_threads.insert(spans[i].thread);
+			TEST_EXPRESSION(spans[i].start <= spans[i].finish);
+			if(i && spans[i].thread == spans[i - 1].thread)
+				TEST_EXPRESSION(spans[i - 1].start <= spans[i].start);
+		}
+		TEST_EXPRESSION(span_threads.size() == 1 + thread_count);
+
+		std::ostringstream buffer;
+		k3d::pipeline_trace::write_chrome_trace(buffer);
+		const std::string trace = buffer.str();
+		TEST_EXPRESSION(trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+		TEST_EXPRESSION(trace.find("\n]}\n") == trace.size() - 4);
+		TEST_EXPRESSION(count(trace, "\"ph\":\"X\"") == spans.size());
+		TEST_EXPRESSION(count(trace, "\"ph\":\"M\"") == 1 + thread_count);
+		TEST_EXPRESSION(count(trace, "\"Node \\\"1\\\": Outer\"") == spans.size() / 2);
+
+		// Starting again discards the previous spans ...
+		k3d::pipeline_trace::start();
+		k3d::pipeline_trace::stop();
+		TEST_EXPRESSION(k3d::pipeline_trace::spans().empty());
+
+		// Observers see every task, from every thread ...
+		execution_counter counter;
+		profiler.connect_node_execution_signal(sigc::mem_fun(counter, &execution_counter::on_execution));
+		threads.clear();
+		for(k3d::uint_t i = 0; i != thread_count; ++i)
+			threads.push_back(std::thread(execute_tasks, std::ref(profiler), std::ref(node), task_count));
+		for(k3d::uint_t i = 0; i != thread_count; ++i)
+			threads[i].join();
+		TEST_EXPRESSION(counter.count == thread_count * task_count * 2);
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
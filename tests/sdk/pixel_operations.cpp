@@ -0,0 +1,186 @@
+#include <k3dsdk/high_res_timer.h>
+#include <k3dsdk/pixel_operation.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+/// Raises red, green, and blue to a power
+class gamma_operation :
+	public k3d::pixel_operation
+{
+public:
+	gamma_operation(const double Gamma) : gamma(1.0 / Gamma) { }
+
+	void apply(k3d::pixel_block& Block) const
+	{
+		for(k3d::uint_t i = 0; i != Block.size; ++i)
+		{
+			Block.red[i] = std::pow(static_cast<double>(Block.red[i]), gamma);
+			Block.green[i] = std::pow(static_cast<double>(Block.green[i]), gamma);
+			Block.blue[i] = std::pow(static_cast<double>(Block.blue[i]), gamma);
+		}
+	}
+
+	const k3d::bool_t separable() const { return true; }
+
+	const double gamma;
+};
+
+/// Inverts alpha
+class matte_invert_operation :
+	public k3d::pixel_operation
+{
+public:
+	void apply(k3d::pixel_block& Block) const
+	{
+		for(k3d::uint_t i = 0; i != Block.size; ++i)
+			Block.alpha[i] = 1.0f - Block.alpha[i];
+	}
+
+	const k3d::bool_t separable() const { return true; }
+};
+
+/// Replaces red, green, and blue with their average
+class monochrome_operation :
+	public k3d::pixel_operation
+{
+public:
+	void apply(k3d::pixel_block& Block) const
+	{
+		for(k3d::uint_t i = 0; i != Block.size; ++i)
+			Block.red[i] = Block.green[i] = Block.blue[i] = (Block.red[i] + Block.green[i] + Block.blue[i]) / 3.0f;
+	}
+};
+
+/// Fills a bitmap with a pattern that covers a wide range of values
+void fill(k3d::bitmap& Bitmap)
+{
+	for(k3d::pixel_size_t y = 0; y != Bitmap.height(); ++y)
+	{
+		for(k3d::pixel_size_t x = 0; x != Bitmap.width(); ++x)
+			*view(Bitmap).xy_at(x, y) = k3d::pixel(half(x / 97.0f), half(y / 89.0f), half((x * y % 1013) / 1013.0f), half((x + y) % 2 ? 1.0f : 0.25f));
+	}
+}
+
+/// Applies every operation to one pixel at a time
+void reference_apply(const std::vector<k3d::pixel_operation*>& Operations, const k3d::bitmap& Input, k3d::bitmap& Output)
+{
+	for(k3d::pixel_size_t y = 0; y != Input.height(); ++y)
+	{
+		for(k3d::pixel_size_t x = 0; x != Input.width(); ++x)
+		{
+			const k3d::pixel input = *const_view(Input).xy_at(x, y);
+			float red = boost::gil::get_color(input, boost::gil::red_t());
+			float green = boost::gil::get_color(input, boost::gil::green_t());
+			float blue = boost::gil::get_color(input, boost::gil::blue_t());
+			float alpha = boost::gil::get_color(input, boost::gil::alpha_t());
+
+			for(k3d::uint_t i = 0; i != Operations.size(); ++i)
+			{
+				k3d::pixel_block block(&red, &green, &blue, &alpha, 1);
+				Operations[i]->apply(block);
+			}
+
+			*view(Output).xy_at(x, y) = k3d::pixel(half(red), half(green), half(blue), half(alpha));
+		}
+	}
+}
+
+void test_chain(const k3d::uint_t Width, const k3d::uint_t Height, const bool Separable)
+{
+	k3d::bitmap input(Width, Height);
+	fill(input);
+
+	std::vector<k3d::pixel_operation*> reference_operations;
+	reference_operations.push_back(new gamma_operation(2.2));
+	reference_operations.push_back(new matte_invert_operation());
+	if(!Separable)
+		reference_operations.push_back(new monochrome_operation());
+
+	k3d::pixel_operations operations;
+	operations.push_back(new gamma_operation(2.2));
+	operations.push_back(new matte_invert_operation());
+	if(!Separable)
+		operations.push_back(new monochrome_operation());
+
+	k3d::bitmap expected(Width, Height);
+	reference_apply(reference_operations, input, expected);
+
+	k3d::bitmap output(Width, Height);
+	operations.apply(input, output);
+
+	for(k3d::pixel_size_t y = 0; y != input.height(); ++y)
+	{
+		for(k3d::pixel_size_t x = 0; x != input.width(); ++x)
+		{
+			const k3d::pixel a = *const_view(expected).xy_at(x, y);
+			const k3d::pixel b = *const_view(output).xy_at(x, y);
+			for(int c = 0; c != 4; ++c)
+			{
+				if(a[c].bits() != b[c].bits())
+					throw std::runtime_error("pixel mismatch at " + boost::lexical_cast<std::string>(x) + ", " + boost::lexical_cast<std::string>(y) + " for " + boost::lexical_cast<std::string>(Width) + "x" + boost::lexical_cast<std::string>(Height));
+			}
+		}
+	}
+
+	for(k3d::uint_t i = 0; i != reference_operations.size(); ++i)
+		delete reference_operations[i];
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		// Small bitmaps are evaluated directly, large bitmaps use lookup tables, both must match the reference results exactly ...
+		test_chain(17, 13, true);
+		test_chain(17, 13, false);
+		test_chain(1031, 257, true);
+		test_chain(1031, 257, false);
+
+		// Optionally time a 4K chain, compared to evaluating one operation at a time ...
+		if(argc > 1)
+		{
+			k3d::bitmap input(4096, 2160);
+			fill(input);
+			k3d::bitmap output(4096, 2160);
+
+			const k3d::uint_t iterations = boost::lexical_cast<k3d::uint_t>(argv[1]);
+
+			k3d::pixel_operations operations;
+			operations.push_back(new gamma_operation(2.2));
+			operations.push_back(new matte_invert_operation());
+			operations.push_back(new gamma_operation(1.8));
+
+			k3d::timer timer;
+			for(k3d::uint_t i = 0; i != iterations; ++i)
+				operations.apply(input, output);
+			std::cout << "separable chain: " << timer.elapsed() / iterations << " s per frame" << std::endl;
+
+			operations.push_back(new monochrome_operation());
+			timer.restart();
+			for(k3d::uint_t i = 0; i != iterations; ++i)
+				operations.apply(input, output);
+			std::cout << "mixed chain:     " << timer.elapsed() / iterations << " s per frame" << std::endl;
+
+			std::vector<k3d::pixel_operation*> reference_operations;
+			reference_operations.push_back(new gamma_operation(2.2));
+			reference_operations.push_back(new matte_invert_operation());
+			reference_operations.push_back(new gamma_operation(1.8));
+			reference_operations.push_back(new monochrome_operation());
+			timer.restart();
+			reference_apply(reference_operations, input, output);
+			std::cout << "per-pixel:       " << timer.elapsed() << " s per frame" << std::endl;
+		}
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
@@ -0,0 +1,101 @@
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/iplugin_factory.h>
+#include <k3dsdk/plugin_factory_collection.h>
+#include <k3dsdk/system.h>
+
+#include <iostream>
+#include <stdexcept>
+
+#include <utime.h>
+
+/// Writes a proxy for a module containing a single document plugin
+void write_proxy(const k3d::filesystem::path& ProxyPath)
+{
+	k3d::filesystem::ofstream stream(ProxyPath);
+	stream << "<?xml version=\"1.0\" ?>\n";
+	stream << "<k3dml><module name=\"k3d-plugin-index-test.module\"><plugins>\n";
+	stream << "<plugin name=\"PluginIndexTest\" factory_id=\"b7bb1a1c-a8f0-4b41-9f1e-2b1d2e5c6a01\" quality=\"stable\" type=\"document\">\n";
+	stream << "<short_description>Test plugin</short_description><categories><category>Test</category></categories><interfaces/><metadata/>\n";
+	stream << "</plugin></plugins></module></k3dml>\n";
+}
+
+/// Sets the modification time of a file
+void set_modification_time(const k3d::filesystem::path& Path, const time_t Time)
+{
+	struct utimbuf times;
+	times.actime = Time;
+	times.modtime = Time;
+	if(0 != utime(Path.native_filesystem_string().c_str(), &times))
+		throw std::runtime_error("error setting modification time for " + Path.native_console_string());
+}
+
+/// Loads the test module using the index, returning the number of plugins that were registered
+const k3d::uint_t load(const k3d::filesystem::path& IndexPath, const k3d::filesystem::path& ModulePath)
+{
+	k3d::plugin_factory_collection plugins;
+	plugins.load_index(IndexPath);
+	plugins.load_module(ModulePath, k3d::plugin_factory_collection::LOAD_PROXIES);
+	plugins.save_index(IndexPath);
+
+	if(plugins.factories().size() == 1 && (*plugins.factories().begin())->name() != "PluginIndexTest")
+		throw std::runtime_error("unexpected plugin " + (*plugins.factories().begin())->name());
+
+	return plugins.factories().size();
+}
+
+int main(int argc, char* argv[])
+{
+	const k3d::filesystem::path index_path = k3d::system::get_temp_directory() / k3d::filesystem::generic_path("k3d-plugin-index-test.index");
+	const k3d::filesystem::path module_path = k3d::system::get_temp_directory() / k3d::filesystem::generic_path("k3d-plugin-index-test.module");
+	const k3d::filesystem::path proxy_path = module_path + ".proxy";
+
+	int result = 0;
+
+	try
+	{
+		k3d::filesystem::remove(index_path);
+
+		// The "module" isn't a shared library, so it can only be proxied, never loaded ...
+		{
+			k3d::filesystem::ofstream stream(module_path);
+			stream << "not a shared library\n";
+		}
+		write_proxy(proxy_path);
+		set_modification_time(module_path, 1000000000);
+		set_modification_time(proxy_path, 1000000000);
+
+		// The first run should proxy the module using its proxy file, and index it ...
+		if(load(index_path, module_path) != 1)
+			throw std::runtime_error("module wasn't proxied");
+		if(!k3d::filesystem::exists(index_path))
+			throw std::runtime_error("index wasn't saved");
+
+		// Subsequent runs shouldn't need the proxy file ...
+		k3d::filesystem::remove(proxy_path);
+		if(load(index_path, module_path) != 1)
+			throw std::runtime_error("module wasn't proxied from the index");
+
+		// Once the module is modified, the index entry should be ignored ...
+		set_modification_time(module_path, 1000000001);
+		if(load(index_path, module_path) != 0)
+			throw std::runtime_error("out-of-date index entry was used");
+
+		// An out-of-date proxy should be ignored too ...
+		write_proxy(proxy_path);
+		set_modification_time(proxy_path, 1000000000);
+		if(load(index_path, module_path) != 0)
+			throw std::runtime_error("out-of-date proxy was used");
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		result = 1;
+	}
+
+	k3d::filesystem::remove(index_path);
+	k3d::filesystem::remove(module_path);
+	k3d::filesystem::remove(proxy_path);
+
+	return result;
+}
+
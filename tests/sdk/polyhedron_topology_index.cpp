@@ -0,0 +1,118 @@
+#include <k3dsdk/polyhedron.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+/// Compares a compressed-sparse-row adjacency against an adjacency list
+void test_rows(const k3d::mesh::indices_t& FirstEdges, const k3d::mesh::indices_t& Edges, const std::vector<k3d::mesh::indices_t>& AdjacencyList)
+{
+	if(FirstEdges.size() != AdjacencyList.size() + 1)
+		throw std::runtime_error("incorrect row count");
+
+	for(k3d::uint_t point = 0; point != AdjacencyList.size(); ++point)
+	{
+		if(FirstEdges[point + 1] - FirstEdges[point] != AdjacencyList[point].size())
+			throw std::runtime_error("incorrect row size");
+		if(!std::equal(AdjacencyList[point].begin(), AdjacencyList[point].end(), Edges.begin() + FirstEdges[point]))
+			throw std::runtime_error("incorrect row contents");
+	}
+}
+
+/// Compares the topology index for a polyhedron against the legacy lookup functions
+void test_index(const k3d::mesh& Mesh, const k3d::polyhedron::topology_index& Index)
+{
+	boost::scoped_ptr<k3d::polyhedron::const_primitive> polyhedron(k3d::polyhedron::validate(Mesh, *Mesh.primitives[0]));
+	if(!polyhedron)
+		throw std::runtime_error("invalid polyhedron");
+
+	std::vector<k3d::mesh::indices_t> out_edges;
+	k3d::polyhedron::create_point_out_edge_lookup(Mesh, *polyhedron, out_edges);
+	test_rows(Index.point_first_out_edges, Index.point_out_edges, out_edges);
+
+	std::vector<k3d::mesh::indices_t> in_edges;
+	k3d::polyhedron::create_point_in_edge_lookup(Mesh, *polyhedron, in_edges);
+	test_rows(Index.point_first_in_edges, Index.point_in_edges, in_edges);
+
+	for(k3d::uint_t point = 0; point != out_edges.size(); ++point)
+	{
+		if(Index.point_valences[point] != out_edges[point].size())
+			throw std::runtime_error("incorrect valence");
+	}
+
+	k3d::mesh::bools_t boundary_edges;
+	k3d::mesh::indices_t companions;
+	k3d::polyhedron::create_edge_adjacency_lookup(polyhedron->vertex_points, polyhedron->clockwise_edges, boundary_edges, companions);
+	if(Index.boundary_edges != boundary_edges || Index.companions != companions)
+		throw std::runtime_error("incorrect companions");
+
+	k3d::mesh::indices_t counterclockwise_edges;
+	k3d::polyhedron::create_counterclockwise_edge_lookup(*polyhedron, counterclockwise_edges);
+	if(Index.counterclockwise_edges != counterclockwise_edges)
+		throw std::runtime_error("incorrect counterclockwise edges");
+
+	k3d::mesh::indices_t edge_faces;
+	k3d::polyhedron::create_edge_face_lookup(*polyhedron, edge_faces);
+	if(Index.edge_faces != edge_faces)
+		throw std::runtime_error("incorrect edge faces");
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		k3d::mesh mesh;
+		boost::scoped_ptr<k3d::polyhedron::primitive> polyhedron(k3d::polyhedron::create(mesh));
+		polyhedron->shell_types.push_back(k3d::polyhedron::POLYGONS);
+		k3d::polyhedron::add_grid(mesh, *polyhedron, 0, 5, 7, 0);
+		k3d::polyhedron::add_torus(mesh, *polyhedron, 0, 6, 4, 0);
+		polyhedron.reset();
+
+		// The index must match the legacy lookups, and be cached with the primitive ...
+		boost::shared_ptr<const k3d::polyhedron::topology_index> index = k3d::polyhedron::get_topology_index(mesh, *mesh.primitives[0]);
+		if(!index)
+			throw std::runtime_error("missing index");
+		test_index(mesh, *index);
+
+		if(k3d::polyhedron::get_topology_index(mesh, *mesh.primitives[0]) != index)
+			throw std::runtime_error("index wasn't cached");
+
+		// Geometry changes must reuse the index ...
+		k3d::mesh geometry_copy = mesh;
+		geometry_copy.points.writable()[0] = k3d::point3(1, 2, 3);
+		if(k3d::polyhedron::get_topology_index(geometry_copy, *geometry_copy.primitives[0]) != index)
+			throw std::runtime_error("index wasn't shared after a geometry change");
+
+		// Copies with duplicated (but unchanged) topology arrays must reuse the index ...
+		k3d::mesh selection_copy = mesh;
+		boost::scoped_ptr<k3d::polyhedron::primitive> selection_polyhedron(k3d::polyhedron::validate(selection_copy, selection_copy.primitives[0]));
+		selection_polyhedron->edge_selections.assign(selection_polyhedron->edge_selections.size(), 1.0);
+		if(k3d::polyhedron::get_topology_index(selection_copy, *selection_copy.primitives[0]) != index)
+			throw std::runtime_error("index wasn't shared after a selection change");
+
+		// Topology changes must create a new index ...
+		k3d::mesh topology_copy = mesh;
+		boost::scoped_ptr<k3d::polyhedron::primitive> topology_polyhedron(k3d::polyhedron::validate(topology_copy, topology_copy.primitives[0]));
+		k3d::polyhedron::add_grid(topology_copy, *topology_polyhedron, 0, 2, 3, 0);
+		boost::shared_ptr<const k3d::polyhedron::topology_index> topology_index = k3d::polyhedron::get_topology_index(topology_copy, *topology_copy.primitives[0]);
+		if(!topology_index || topology_index == index)
+			throw std::runtime_error("index wasn't recreated after a topology change");
+		test_index(topology_copy, *topology_index);
+		test_index(mesh, *k3d::polyhedron::get_topology_index(mesh, *mesh.primitives[0]));
+
+		// Other primitives don't have an index ...
+		k3d::mesh empty_mesh;
+		empty_mesh.primitives.create("teapot");
+		if(k3d::polyhedron::get_topology_index(empty_mesh, *empty_mesh.primitives[0]))
+			throw std::runtime_error("unexpected index");
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
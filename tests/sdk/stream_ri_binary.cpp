@@ -0,0 +1,307 @@
+#include <k3dsdk/algebra.h>
+#include <k3dsdk/high_res_timer.h>
+#include <k3dsdk/stream_ri.h>
+#include <k3dsdk/types_ri.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+/// Stores one RIB token, decoded from either encoding
+struct token
+{
+	token(const char Type, const std::string& Text, const double Number = 0) : type(Type), text(Text), number(Number) { }
+
+	/// 'r' for requests, 's' for strings, 'n' for numbers, '[' and ']' for array delimiters
+	char type;
+	std::string text;
+	double number;
+};
+
+typedef std::vector<token> tokens_t;
+
+/// Appends the token for an ASCII word
+void append_word(const std::string& Word, tokens_t& Tokens)
+{
+	try
+	{
+		Tokens.push_back(token('n', Word, boost::lexical_cast<double>(Word)));
+	}
+	catch(boost::bad_lexical_cast&)
+	{
+		Tokens.push_back(token('r', Word));
+	}
+}
+
+const unsigned long read_bytes(const std::string& Data, size_t& Index, const unsigned long Count)
+{
+	unsigned long result = 0;
+	for(unsigned long i = 0; i != Count; ++i)
+		result = (result << 8) | static_cast<unsigned char>(Data[Index++]);
+	return result;
+}
+
+const std::string read_string_token(const std::string& Data, size_t& Index)
+{
+	const unsigned char code = Data[Index++];
+	unsigned long length = 0;
+	if(code >= 0220 && code <= 0237)
+		length = code - 0220;
+	else if(code >= 0240 && code <= 0243)
+		length = read_bytes(Data, Index, code - 0240 + 1);
+	else
+		throw std::runtime_error("expected string token");
+
+	const std::string result = Data.substr(Index, length);
+	Index += length;
+	return result;
+}
+
+/// Decodes RIB containing any mix of ASCII and binary tokens
+const tokens_t decode(const std::string& Data)
+{
+	tokens_t results;
+	std::map<unsigned long, std::string> strings;
+	std::map<unsigned long, std::string> requests;
+
+	for(size_t i = 0; i < Data.size(); )
+	{
+		const unsigned char c = Data[i];
+
+		if(c == ' ' || c == '\n' || c == '\t')
+		{
+			++i;
+		}
+		else if(c == '#')
+		{
+			i = Data.find('\n', i);
+		}
+		else if(c == '[' || c == ']')
+		{
+			results.push_back(token(c, std::string(1, c)));
+			++i;
+		}
+		else if(c == '"')
+		{
+			const size_t end = Data.find('"', i + 1);
+			results.push_back(token('s', Data.substr(i + 1, end - i - 1)));
+			i = end + 1;
+		}
+		else if(c < 0200)
+		{
+			size_t end = i;
+			while(end < Data.size() && !std::strchr(" \n\t[]\"#", Data[end]) && static_cast<unsigned char>(Data[end]) < 0200)
+				++end;
+			append_word(Data.substr(i, end - i), results);
+			i = end;
+		}
+		else if(c == 0203)
+		{
+			++i;
+			results.push_back(token('n', "", static_cast<int32_t>(read_bytes(Data, i, 4))));
+		}
+		else if(c >= 0310 && c <= 0313)
+		{
+			++i;
+			const unsigned long count = read_bytes(Data, i, c - 0310 + 1);
+			results.push_back(token('[', "["));
+			for(unsigned long j = 0; j != count; ++j)
+			{
+				const uint32_t bits = read_bytes(Data, i, 4);
+				float value;
+				std::memcpy(&value, &bits, 4);
+				results.push_back(token('n', "", value));
+			}
+			results.push_back(token(']', "]"));
+		}
+		else if((c >= 0220 && c <= 0237) || (c >= 0240 && c <= 0243))
+		{
+			results.push_back(token('s', read_string_token(Data, i)));
+		}
+		else if(c == 0315 || c == 0316)
+		{
+			++i;
+			const unsigned long index = read_bytes(Data, i, c - 0315 + 1);
+			strings[index] = read_string_token(Data, i);
+			results.push_back(token('s', strings[index]));
+		}
+		else if(c == 0317 || c == 0320)
+		{
+			++i;
+			const unsigned long index = read_bytes(Data, i, c - 0317 + 1);
+			if(!strings.count(index))
+				throw std::runtime_error("undefined string reference");
+			results.push_back(token('s', strings[index]));
+		}
+		else if(c == 0314)
+		{
+			++i;
+			const unsigned long code = read_bytes(Data, i, 1);
+			requests[code] = read_string_token(Data, i);
+		}
+		else if(c == 0246)
+		{
+			++i;
+			const unsigned long code = read_bytes(Data, i, 1);
+			if(!requests.count(code))
+				throw std::runtime_error("undefined request");
+			results.push_back(token('r', requests[code]));
+		}
+		else
+		{
+			throw std::runtime_error("unexpected binary token " + boost::lexical_cast<std::string>(static_cast<int>(c)));
+		}
+	}
+
+	return results;
+}
+
+/// Writes a grid of quadrilaterals as a single PointsPolygons request
+void write_scene(k3d::ri::stream& Stream, const k3d::uint_t Rows, const k3d::uint_t Columns)
+{
+	k3d::ri::unsigned_integers vertex_counts(Rows * Columns, 4);
+	k3d::ri::unsigned_integers vertex_ids;
+	vertex_ids.reserve(4 * Rows * Columns);
+	for(k3d::uint_t row = 0; row != Rows; ++row)
+	{
+		for(k3d::uint_t column = 0; column != Columns; ++column)
+		{
+			vertex_ids.push_back(row * (Columns + 1) + column);
+			vertex_ids.push_back(row * (Columns + 1) + column + 1);
+			vertex_ids.push_back((row + 1) * (Columns + 1) + column + 1);
+			vertex_ids.push_back((row + 1) * (Columns + 1) + column);
+		}
+	}
+
+	k3d::typed_array<k3d::ri::point>* const points = new k3d::typed_array<k3d::ri::point>();
+	points->reserve((Rows + 1) * (Columns + 1));
+	for(k3d::uint_t row = 0; row <= Rows; ++row)
+	{
+		for(k3d::uint_t column = 0; column <= Columns; ++column)
+			points->push_back(k3d::ri::point(0.1 * column, 0.1 * row, std::sin(0.01 * row * column)));
+	}
+
+	k3d::typed_array<k3d::ri::real>* const weights = new k3d::typed_array<k3d::ri::real>(Rows * Columns, 0.5);
+
+	k3d::ri::parameter_list parameters;
+	parameters.push_back(k3d::ri::parameter(k3d::ri::RI_P(), k3d::ri::VERTEX, 1, points));
+	parameters.push_back(k3d::ri::parameter("weight", k3d::ri::UNIFORM, 1, weights));
+
+	Stream.RiFrameBegin(1);
+	Stream.RiDisplayV("test.tif", k3d::ri::RI_FILE(), k3d::ri::RI_RGB());
+	Stream.RiWorldBegin();
+	Stream.RiAttributeBegin();
+	Stream.RiConcatTransform(k3d::translate3(k3d::vector3(1, 2, 3)));
+	Stream.RiSurfaceV(k3d::filesystem::path(), "plastic");
+	Stream.RiPointsPolygonsV(vertex_counts, vertex_ids, parameters);
+	Stream.RiAttributeEnd();
+	Stream.RiAttributeBegin();
+	Stream.RiSurfaceV(k3d::filesystem::path(), "plastic");
+	Stream.RiSphereV(1, -1, 1, 360);
+	Stream.RiAttributeEnd();
+	Stream.RiWorldEnd();
+	Stream.RiFrameEnd();
+}
+
+/// Counts the bytes written to a stream, without storing them
+class counting_buffer :
+	public std::streambuf
+{
+public:
+	counting_buffer() : count(0) { }
+
+	k3d::uint_t count;
+
+protected:
+	int_type overflow(int_type c)
+	{
+		++count;
+		return c;
+	}
+
+	std::streamsize xsputn(const char*, std::streamsize n)
+	{
+		count += n;
+		return n;
+	}
+};
+
+/// Writes a scene with the given encoding, printing the time and size
+void benchmark(const k3d::uint_t Rows, const k3d::uint_t Columns, const bool Binary)
+{
+	counting_buffer buffer;
+	std::ostream output(&buffer);
+
+	k3d::timer timer;
+	{
+		k3d::ri::stream stream(output);
+		stream.set_binary_encoding(Binary);
+		write_scene(stream, Rows, Columns);
+	}
+
+	std::cout << (Binary ? "binary" : "ascii ") << " " << Rows * Columns << " polygons: " << timer.elapsed() << " s, " << buffer.count << " bytes" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		// Both encodings must describe the same scene ...
+		std::ostringstream ascii_output;
+		{
+			k3d::ri::stream stream(ascii_output);
+			write_scene(stream, 20, 30);
+		}
+
+		std::ostringstream binary_output;
+		{
+			k3d::ri::stream stream(binary_output);
+			stream.set_binary_encoding(true);
+			write_scene(stream, 20, 30);
+		}
+
+		const tokens_t ascii_tokens = decode(ascii_output.str());
+		const tokens_t binary_tokens = decode(binary_output.str());
+
+		if(binary_output.str().size() >= ascii_output.str().size())
+			throw std::runtime_error("binary RIB isn't smaller than ASCII RIB");
+
+		if(ascii_tokens.size() != binary_tokens.size())
+			throw std::runtime_error("token count mismatch");
+
+		for(k3d::uint_t i = 0; i != ascii_tokens.size(); ++i)
+		{
+			const token& a = ascii_tokens[i];
+			const token& b = binary_tokens[i];
+			if(a.type != b.type)
+				throw std::runtime_error("token type mismatch at [" + a.text + "]");
+			if(a.type == 'n' && std::fabs(a.number - b.number) > 1e-5 * std::max(1.0, std::fabs(a.number)))
+				throw std::runtime_error("number mismatch at [" + a.text + "]");
+			if(a.type != 'n' && a.text != b.text)
+				throw std::runtime_error("token mismatch [" + a.text + "] [" + b.text + "]");
+		}
+
+		// Optionally compare performance for large scenes ...
+		if(argc > 1)
+		{
+			const k3d::uint_t rows = 1000;
+			const k3d::uint_t columns = boost::lexical_cast<k3d::uint_t>(argv[1]) / rows;
+			benchmark(rows, columns, false);
+			benchmark(rows, columns, true);
+		}
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
@@ -0,0 +1,161 @@
+#include <k3dsdk/difference.h>
+#include <k3dsdk/mesh.h>
+#include <k3dsdk/parallel/threads.h>
+#include <k3dsdk/table.h>
+#include <k3dsdk/table_copier.h>
+#include <k3dsdk/typed_array.h>
+#include <k3dsdk/uint_t_array.h>
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+/// Creates a table containing arrays of several types, with Count rows of arbitrary data
+const k3d::table create_table(const k3d::uint_t Count)
+{
+	k3d::table result;
+	k3d::typed_array<k3d::double_t>& doubles = result.create<k3d::typed_array<k3d::double_t> >("doubles");
+	k3d::typed_array<k3d::int32_t>& ints = result.create<k3d::typed_array<k3d::int32_t> >("ints");
+	k3d::typed_array<k3d::bool_t>& bools = result.create<k3d::typed_array<k3d::bool_t> >("bools");
+	k3d::typed_array<k3d::string_t>& strings = result.create<k3d::typed_array<k3d::string_t> >("strings");
+	k3d::typed_array<k3d::point3>& points = result.create<k3d::typed_array<k3d::point3> >("points");
+	k3d::uint_t_array& indices = result.create<k3d::uint_t_array>("indices");
+
+	for(k3d::uint_t i = 0; i != Count; ++i)
+	{
+		std::ostringstream buffer;
+		buffer << "row " << i;
+
+		doubles.push_back(0.5 * i);
+		ints.push_back(3 * i);
+		bools.push_back(i % 3 == 0);
+		strings.push_back(buffer.str());
+		points.push_back(k3d::point3(i, 2 * i, 3 * i));
+		indices.push_back(7 * i);
+	}
+
+	return result;
+}
+
+/// Bulk operations perform the same arithmetic as element-by-element operations, so their results must match exactly
+void require_equal(const k3d::table& A, const k3d::table& B, const k3d::string_t& Message)
+{
+	if(A.row_count() != B.row_count())
+		throw std::runtime_error(Message + ": row count mismatch");
+
+	const k3d::difference::accumulator result = k3d::difference::test(A, B);
+
+	if(boost::accumulators::count(result.exact) && boost::accumulators::min(result.exact) == false)
+		throw std::runtime_error(Message + ": exact value mismatch");
+
+	if(boost::accumulators::count(result.ulps) && boost::accumulators::max(result.ulps) > 0)
+		throw std::runtime_error(Message + ": inexact value mismatch");
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		// Use small blocks, so bulk operations are split across both arrays and rows ...
+		k3d::parallel::set_grain_size(7);
+
+		const k3d::uint_t source_count = 50;
+		const k3d::table source = create_table(source_count);
+
+		const k3d::uint_t count = 100;
+		k3d::mesh::indices_t indices(count);
+		k3d::mesh::indices_t first_indices(count + 1, 0);
+		k3d::mesh::indices_t weighted_indices;
+		k3d::mesh::weights_t weights;
+		for(k3d::uint_t i = 0; i != count; ++i)
+		{
+			indices[i] = (i * 17) % source_count;
+
+			const k3d::uint_t sum_count = 1 + (i % 4);
+			for(k3d::uint_t j = 0; j != sum_count; ++j)
+			{
+				weighted_indices.push_back((i + 5 * j) % source_count);
+				weights.push_back(1.0 / sum_count);
+			}
+			first_indices[i + 1] = weighted_indices.size();
+		}
+
+		// Bulk gathers must match element-by-element copies ...
+		{
+			k3d::table expected = source.clone_types();
+			k3d::table_copier expected_copier(source, expected);
+			for(k3d::uint_t i = 0; i != count; ++i)
+				expected_copier.push_back(indices[i]);
+
+			k3d::table result = source.clone_types();
+			k3d::table_copier copier(source, result);
+			copier.reserve(count);
+			copier.push_back(count, &indices[0]);
+
+			require_equal(expected, result, "gather mismatch");
+		}
+
+		// Bulk weighted gathers must match element-by-element weighted sums ...
+		{
+			k3d::table expected = source.clone_types();
+			k3d::table_copier expected_copier(source, expected);
+			for(k3d::uint_t i = 0; i != count; ++i)
+				expected_copier.push_back(first_indices[i + 1] - first_indices[i], &weighted_indices[first_indices[i]], &weights[first_indices[i]]);
+
+			k3d::table result = source.clone_types();
+			k3d::table_copier copier(source, result);
+			copier.push_back(count, &first_indices[0], &weighted_indices[0], &weights[0]);
+
+			require_equal(expected, result, "weighted gather mismatch");
+		}
+
+		// Bulk scatters must match element-by-element copies ...
+		{
+			k3d::mesh::indices_t target_indices(source_count);
+			for(k3d::uint_t i = 0; i != source_count; ++i)
+				target_indices[i] = (i * 13) % source_count;
+
+			k3d::table expected = create_table(source_count);
+			k3d::table_copier expected_copier(source, expected);
+			for(k3d::uint_t i = 0; i != source_count; ++i)
+				expected_copier.copy(indices[i], target_indices[i]);
+			for(k3d::uint_t i = 0; i != source_count; ++i)
+				expected_copier.copy(first_indices[i + 1] - first_indices[i], &weighted_indices[first_indices[i]], &weights[first_indices[i]], target_indices[i]);
+
+			k3d::table result = create_table(source_count);
+			k3d::table_copier copier(source, result);
+			copier.copy(source_count, &indices[0], &target_indices[0]);
+			copier.copy(source_count, &first_indices[0], &weighted_indices[0], &weights[0], &target_indices[0]);
+
+			require_equal(expected, result, "scatter mismatch");
+		}
+
+		// Bulk gathers within a single table must read the original rows ...
+		{
+			k3d::table expected = create_table(source_count);
+			{
+				k3d::table_copier expected_copier(expected);
+				for(k3d::uint_t i = 0; i != count; ++i)
+					expected_copier.push_back(indices[i]);
+			}
+
+			k3d::table result = create_table(source_count);
+			{
+				k3d::table_copier copier(result);
+				copier.push_back(count, &indices[0]);
+			}
+
+			require_equal(expected, result, "self-gather mismatch");
+			if(result.row_count() != source_count + count)
+				throw std::runtime_error("incorrect row count");
+		}
+
+		return 0;
+	}
+	catch(std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return 1;
+	}
+}
+
@@ -0,0 +1,138 @@
+#include <k3dsdk/fstream.h>
+#include <k3dsdk/mapped_file.h>
+#include <k3dsdk/system.h>
+#include <k3dsdk/text_parsing.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+
+/// Parses Text using k3d::text::parse() and a std::istream, throwing an exception if the results differ
+void test_double(const std::string& Text)
+{
+	std::istringstream stream(Text);
+	stream.imbue(std::locale::classic());
+	double expected = 0;
+	stream >> expected;
+
+	const char* current = Text.data();
+	double result = 0;
+	if(!k3d::text::parse(current, Text.data() + Text.size(), result))
+		throw std::runtime_error("couldn't parse [" + Text + "]");
+
+	if(std::memcmp(&result, &expected, sizeof(double)))
+		throw std::runtime_error("incorrect value parsing [" + Text + "]: " + boost::lexical_cast<std::string>(result) + " should be " + boost::lexical_cast<std::string>(expected));
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		// Doubles must match the standard library exactly, including the uncommon cases ...
+		const char* const cases[] = { "0", "-0", "1", "-1", "0.5", ".5", "5.", "3.14159", "-0.0312216", "1e10", "1E-10", "+2.5e+3",
+			"123456789012345678", "1234567890123456789012345", "0.000000000000000000000000001", "1.7976931348623157e308",
+			"4.9406564584124654e-324", "2.2250738585072014e-308", "9007199254740993", "0.1", "0.30000000000000004", "1e23", "8.589973e9" };
+		for(size_t i = 0; i != sizeof(cases) / sizeof(cases[0]); ++i)
+			test_double(cases[i]);
+
+		const char* const formats[] = { "%.17g", "%g", "%.6f", "%e", "%.3f", "%.9g" };
+		std::srand(42);
+		for(int i = 0; i != 100000; ++i)
+		{
+			const double value = (static_cast<double>(std::rand()) / RAND_MAX - 0.5) * std::pow(10.0, std::rand() % 40 - 20);
+			char buffer[64];
+			std::sprintf(buffer, formats[i % 6], value);
+			test_double(buffer);
+		}
+
+		// Integers ...
+		{
+			const std::string text = "  42 -17 +3 x 9223372036854775807 -9223372036854775808 9223372036854775808";
+			const char* current = text.data();
+			const char* const end = text.data() + text.size();
+			k3d::int64_t value = 0;
+			if(!k3d::text::parse(current, end, value) || value != 42)
+				throw std::runtime_error("error parsing integer");
+			if(!k3d::text::parse(current, end, value) || value != -17)
+				throw std::runtime_error("error parsing negative integer");
+			if(!k3d::text::parse(current, end, value) || value != 3)
+				throw std::runtime_error("error parsing signed integer");
+			if(k3d::text::parse(current, end, value) || value != 3)
+				throw std::runtime_error("non-integer was parsed");
+			current = k3d::text::token_end(k3d::text::skip_blanks(current, end), end);
+			if(!k3d::text::parse(current, end, value) || value != 9223372036854775807LL)
+				throw std::runtime_error("error parsing largest integer");
+			if(!k3d::text::parse(current, end, value) || value != -9223372036854775807LL - 1)
+				throw std::runtime_error("error parsing smallest integer");
+			if(k3d::text::parse(current, end, value))
+				throw std::runtime_error("integer overflow was parsed");
+		}
+
+		// Splitting into chunks must cover every line exactly once ...
+		{
+			std::string text;
+			for(int i = 0; i != 1000; ++i)
+				text += "line " + boost::lexical_cast<std::string>(i) + (i % 7 ? "\n" : " with some extra text\n");
+
+			const char* const begin = text.data();
+			const char* const end = text.data() + text.size();
+			if(k3d::text::count_lines(begin, end) != 1000 || k3d::text::count_lines(begin, end - 1) != 1000)
+				throw std::runtime_error("incorrect line count");
+
+			for(k3d::uint_t chunk_count = 1; chunk_count != 40; ++chunk_count)
+			{
+				std::vector<const char*> boundaries;
+				k3d::text::split_lines(begin, end, chunk_count, boundaries);
+				if(boundaries.front() != begin || boundaries.back() != end || boundaries.size() > chunk_count + 1)
+					throw std::runtime_error("incorrect chunk boundaries");
+
+				k3d::uint64_t lines = 0;
+				for(k3d::uint_t i = 0; i + 1 < boundaries.size(); ++i)
+				{
+					if(boundaries[i] >= boundaries[i + 1] || (boundaries[i] != begin && boundaries[i][-1] != '\n'))
+						throw std::runtime_error("chunk doesn't start a line");
+					lines += k3d::text::count_lines(boundaries[i], boundaries[i + 1]);
+				}
+
+				if(lines != 1000)
+					throw std::runtime_error("chunks don't cover every line");
+			}
+		}
+
+		// Mapped files ...
+		{
+			const k3d::filesystem::path path = k3d::system::get_temp_directory() / k3d::filesystem::generic_path("k3d-text-parsing-test.txt");
+			{
+				k3d::filesystem::ofstream stream(path);
+				stream << "v 1 2 3\n";
+			}
+
+			{
+				k3d::mapped_file file(path);
+				if(!file.is_open() || std::string(file.begin(), file.end()) != "v 1 2 3\n")
+					throw std::runtime_error("incorrect mapped file contents");
+			}
+
+			k3d::filesystem::remove(path);
+
+			k3d::mapped_file missing(path);
+			if(missing.is_open())
+				throw std::runtime_error("missing file was opened");
+		}
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+